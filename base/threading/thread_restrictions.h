@@ -23,6 +23,7 @@ class CookieManager;
 namespace cc {
 class CompletionEvent;
 class SingleThreadTaskGraphRunner;
+class WorkStealingTaskGraphRunner;
 }
 namespace chromeos {
 class BlockingMethodCaller;
@@ -398,6 +399,7 @@ class BASE_EXPORT ThreadRestrictions {
   friend class internal::TaskTracker;
   friend class cc::CompletionEvent;
   friend class cc::SingleThreadTaskGraphRunner;
+  friend class cc::WorkStealingTaskGraphRunner;
   friend class content::CategorizedWorkerPool;
   friend class remoting::AutoThread;
   friend class ui::WindowResizeHelperMac;
@@ -0,0 +1,302 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CC_BASE_FLAT_RTREE_H_
+#define CC_BASE_FLAT_RTREE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/macros.h"
+#include "build/build_config.h"
+#include "ui/gfx/geometry/rect.h"
+
+#if defined(ARCH_CPU_X86_FAMILY)
+#include <emmintrin.h>
+#endif
+
+namespace cc {
+
+// A bulk-loaded R-Tree with the same search semantics as RTree, laid out for
+// fast queries over large inputs such as display lists with 100k+ items.
+//
+// The tree is packed: every node has exactly kFanOut child slots, and the
+// children of a node are the kFanOut consecutive nodes (or items) one level
+// down, so no child pointers are stored. Each node keeps its children's
+// bounds as four parallel arrays (left, top, right, bottom), which lets a
+// node's children be tested against the query in a few SIMD instructions.
+// Unused slots hold inverted bounds that never intersect anything.
+//
+// Like RTree, items are grouped in the order they appear in the input rather
+// than sorted spatially, which keeps search results in input order. Blink
+// records in a reasonable x,y order, so the grouping stays reasonably tight.
+//
+// Search() invokes a callback per result instead of returning a vector, so
+// callers can reuse storage or consume results directly without allocating.
+template <typename T>
+class FlatRTree {
+ public:
+  FlatRTree();
+  ~FlatRTree();
+
+  // Constructs the rtree from a given container of gfx::Rects. Queries using
+  // Search will then return indices into this container.
+  template <typename Container>
+  void Build(const Container& items);
+
+  // Build helper that takes a container, a function used to get gfx::Rect
+  // from each item, and a function used to get the payload for each item. See
+  // RTree::Build.
+  template <typename Container, typename BoundsFunctor, typename PayloadFunctor>
+  void Build(const Container& items,
+             const BoundsFunctor& bounds_getter,
+             const PayloadFunctor& payload_getter);
+
+  // Given a query rect, calls |callback(const T&)| for each element that
+  // intersects the rect. Elements are visited in the order they appeared in
+  // the initial container. Does not allocate.
+  template <typename Functor>
+  void Search(const gfx::Rect& query, const Functor& callback) const;
+
+  // Given a query rect, returns elements that intersect the rect. Elements are
+  // returned in the order they appeared in the initial container.
+  std::vector<T> Search(const gfx::Rect& query) const;
+
+  // Returns the total bounds of all items in this rtree.
+  gfx::Rect GetBounds() const { return bounds_; }
+
+  void Reset();
+
+ private:
+  enum { kFanOut = 8 };
+
+  struct Node {
+    int32_t left[kFanOut];
+    int32_t top[kFanOut];
+    int32_t right[kFanOut];
+    int32_t bottom[kFanOut];
+  };
+
+  // Returns a bitmask with bit i set iff child slot i of |node| intersects
+  // the query, given as its edges. The query must not be empty.
+  static uint32_t IntersectingChildren(const Node& node,
+                                       int32_t left,
+                                       int32_t top,
+                                       int32_t right,
+                                       int32_t bottom);
+
+  template <typename Functor>
+  void SearchNode(size_t level,
+                  size_t index,
+                  const gfx::Rect& query,
+                  const Functor& callback) const;
+
+  // Payloads of all non-empty items, in input order. Child slot i of leaf node
+  // n refers to |payloads_[n * kFanOut + i]|.
+  std::vector<T> payloads_;
+  // All nodes, leaves first. Child slot i of node n at level l > 0 refers to
+  // node n * kFanOut + i at level l - 1. The root is the last node.
+  std::vector<Node> nodes_;
+  // The index of the first node of each level in |nodes_|.
+  std::vector<size_t> level_starts_;
+  gfx::Rect bounds_;
+
+  DISALLOW_COPY_AND_ASSIGN(FlatRTree);
+};
+
+template <typename T>
+FlatRTree<T>::FlatRTree() = default;
+
+template <typename T>
+FlatRTree<T>::~FlatRTree() = default;
+
+template <typename T>
+template <typename Container>
+void FlatRTree<T>::Build(const Container& items) {
+  Build(items,
+        [](const Container& items, size_t index) { return items[index]; },
+        [](const Container& items, size_t index) { return index; });
+}
+
+template <typename T>
+template <typename Container, typename BoundsFunctor, typename PayloadFunctor>
+void FlatRTree<T>::Build(const Container& items,
+                         const BoundsFunctor& bounds_getter,
+                         const PayloadFunctor& payload_getter) {
+  DCHECK(payloads_.empty());
+
+  // Leaf bounds are written straight into the leaf nodes. Empty items are
+  // skipped, as in RTree.
+  payloads_.reserve(items.size());
+  size_t max_leaf_count = (items.size() + kFanOut - 1) / kFanOut;
+  nodes_.reserve(max_leaf_count + max_leaf_count / (kFanOut - 1) + kFanOut);
+  for (size_t i = 0; i < items.size(); ++i) {
+    const gfx::Rect& bounds = bounds_getter(items, i);
+    if (bounds.IsEmpty())
+      continue;
+    size_t slot = payloads_.size() % kFanOut;
+    if (slot == 0)
+      nodes_.emplace_back();
+    Node& leaf = nodes_.back();
+    leaf.left[slot] = bounds.x();
+    leaf.top[slot] = bounds.y();
+    leaf.right[slot] = bounds.right();
+    leaf.bottom[slot] = bounds.bottom();
+    payloads_.push_back(payload_getter(items, i));
+    bounds_.Union(bounds);
+  }
+  if (payloads_.empty())
+    return;
+
+  // Build parent levels until a single root remains. |child_count| is the
+  // number of occupied slots (items or nodes) at the level below.
+  size_t child_count = payloads_.size();
+  size_t level_start = 0;
+  level_starts_.push_back(level_start);
+  while (true) {
+    size_t level_size = nodes_.size() - level_start;
+
+    // Fill the unused slots of the last node with bounds that no query can
+    // intersect.
+    Node& last = nodes_.back();
+    for (size_t slot = child_count - (level_size - 1) * kFanOut;
+         slot < kFanOut; ++slot) {
+      last.left[slot] = last.top[slot] = std::numeric_limits<int32_t>::max();
+      last.right[slot] = last.bottom[slot] =
+          std::numeric_limits<int32_t>::min();
+    }
+
+    if (level_size == 1)
+      break;
+
+    size_t next_level_start = nodes_.size();
+    for (size_t i = 0; i < level_size; ++i) {
+      size_t slot = i % kFanOut;
+      if (slot == 0)
+        nodes_.emplace_back();
+      // Note that |nodes_| may have reallocated, so look up the child by
+      // index rather than holding on to references.
+      const Node& child = nodes_[level_start + i];
+      int32_t left = child.left[0];
+      int32_t top = child.top[0];
+      int32_t right = child.right[0];
+      int32_t bottom = child.bottom[0];
+      for (size_t k = 1; k < kFanOut; ++k) {
+        left = std::min(left, child.left[k]);
+        top = std::min(top, child.top[k]);
+        right = std::max(right, child.right[k]);
+        bottom = std::max(bottom, child.bottom[k]);
+      }
+      Node& parent = nodes_.back();
+      parent.left[slot] = left;
+      parent.top[slot] = top;
+      parent.right[slot] = right;
+      parent.bottom[slot] = bottom;
+    }
+    child_count = level_size;
+    level_start = next_level_start;
+    level_starts_.push_back(level_start);
+  }
+}
+
+// static
+template <typename T>
+uint32_t FlatRTree<T>::IntersectingChildren(const Node& node,
+                                            int32_t left,
+                                            int32_t top,
+                                            int32_t right,
+                                            int32_t bottom) {
+  static_assert(kFanOut == 8, "The SIMD path handles exactly 8 children");
+#if defined(ARCH_CPU_X86_FAMILY)
+  // A child intersects iff child.left < right && left < child.right &&
+  // child.top < bottom && top < child.bottom, matching gfx::Rect::Intersects
+  // for non-empty rects.
+  const __m128i q_left = _mm_set1_epi32(left);
+  const __m128i q_top = _mm_set1_epi32(top);
+  const __m128i q_right = _mm_set1_epi32(right);
+  const __m128i q_bottom = _mm_set1_epi32(bottom);
+  uint32_t mask = 0;
+  for (int half = 0; half < 2; ++half) {
+    int offset = half * 4;
+    __m128i c_left = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(node.left + offset));
+    __m128i c_top =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(node.top + offset));
+    __m128i c_right = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(node.right + offset));
+    __m128i c_bottom = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(node.bottom + offset));
+    __m128i hit = _mm_and_si128(_mm_cmplt_epi32(c_left, q_right),
+                                _mm_cmplt_epi32(q_left, c_right));
+    hit = _mm_and_si128(hit, _mm_cmplt_epi32(c_top, q_bottom));
+    hit = _mm_and_si128(hit, _mm_cmplt_epi32(q_top, c_bottom));
+    mask |= static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(hit)))
+            << offset;
+  }
+  return mask;
+#else
+  // Written branch-free so that the compiler can vectorize it.
+  uint32_t mask = 0;
+  for (int i = 0; i < kFanOut; ++i) {
+    uint32_t hit = (node.left[i] < right) & (left < node.right[i]) &
+                   (node.top[i] < bottom) & (top < node.bottom[i]);
+    mask |= hit << i;
+  }
+  return mask;
+#endif
+}
+
+template <typename T>
+template <typename Functor>
+void FlatRTree<T>::SearchNode(size_t level,
+                              size_t index,
+                              const gfx::Rect& query,
+                              const Functor& callback) const {
+  const Node& node = nodes_[level_starts_[level] + index];
+  uint32_t mask = IntersectingChildren(node, query.x(), query.y(),
+                                       query.right(), query.bottom());
+  size_t first_child = index * kFanOut;
+  // Visit set bits from lowest to highest to keep results in input order.
+  for (size_t slot = 0; mask; ++slot, mask >>= 1) {
+    if (!(mask & 1))
+      continue;
+    if (level == 0)
+      callback(payloads_[first_child + slot]);
+    else
+      SearchNode(level - 1, first_child + slot, query, callback);
+  }
+}
+
+template <typename T>
+template <typename Functor>
+void FlatRTree<T>::Search(const gfx::Rect& query,
+                          const Functor& callback) const {
+  if (payloads_.empty() || !query.Intersects(bounds_))
+    return;
+  SearchNode(level_starts_.size() - 1, 0, query, callback);
+}
+
+template <typename T>
+std::vector<T> FlatRTree<T>::Search(const gfx::Rect& query) const {
+  std::vector<T> results;
+  Search(query, [&results](const T& payload) { results.push_back(payload); });
+  return results;
+}
+
+template <typename T>
+void FlatRTree<T>::Reset() {
+  payloads_.clear();
+  nodes_.clear();
+  level_starts_.clear();
+  bounds_ = gfx::Rect();
+}
+
+}  // namespace cc
+
+#endif  // CC_BASE_FLAT_RTREE_H_
@@ -0,0 +1,190 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/base/flat_rtree.h"
+
+#include <stddef.h>
+
+#include "cc/base/rtree.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace cc {
+
+TEST(FlatRTreeTest, NoOverlap) {
+  std::vector<gfx::Rect> rects;
+  for (int y = 0; y < 50; ++y) {
+    for (int x = 0; x < 50; ++x) {
+      rects.push_back(gfx::Rect(x, y, 1, 1));
+    }
+  }
+
+  FlatRTree<size_t> rtree;
+  rtree.Build(rects);
+
+  std::vector<size_t> results = rtree.Search(gfx::Rect(0, 0, 50, 50));
+  ASSERT_EQ(2500u, results.size());
+  for (size_t i = 0; i < 2500; ++i) {
+    ASSERT_EQ(results[i], i);
+  }
+
+  results = rtree.Search(gfx::Rect(0, 0, 50, 49));
+  ASSERT_EQ(2450u, results.size());
+  for (size_t i = 0; i < 2450; ++i) {
+    ASSERT_EQ(results[i], i);
+  }
+
+  results = rtree.Search(gfx::Rect(5, 6, 1, 1));
+  ASSERT_EQ(1u, results.size());
+  EXPECT_EQ(6u * 50 + 5u, results[0]);
+}
+
+TEST(FlatRTreeTest, Overlap) {
+  std::vector<gfx::Rect> rects;
+  for (int h = 1; h <= 50; ++h) {
+    for (int w = 1; w <= 50; ++w) {
+      rects.push_back(gfx::Rect(0, 0, w, h));
+    }
+  }
+
+  FlatRTree<size_t> rtree;
+  rtree.Build(rects);
+
+  std::vector<size_t> results = rtree.Search(gfx::Rect(0, 0, 1, 1));
+  ASSERT_EQ(2500u, results.size());
+  for (size_t i = 0; i < 2500; ++i) {
+    ASSERT_EQ(results[i], i);
+  }
+
+  results = rtree.Search(gfx::Rect(0, 49, 1, 1));
+  ASSERT_EQ(50u, results.size());
+  for (size_t i = 0; i < 50; ++i) {
+    EXPECT_EQ(results[i], 2450u + i);
+  }
+}
+
+TEST(FlatRTreeTest, SkipsEmptyRects) {
+  std::vector<gfx::Rect> rects;
+  rects.push_back(gfx::Rect(0, 0, 10, 10));
+  rects.push_back(gfx::Rect(5, 5, 0, 10));
+  rects.push_back(gfx::Rect(5, 5, 10, 10));
+
+  FlatRTree<size_t> rtree;
+  rtree.Build(rects);
+
+  std::vector<size_t> results = rtree.Search(gfx::Rect(0, 0, 20, 20));
+  ASSERT_EQ(2u, results.size());
+  EXPECT_EQ(0u, results[0]);
+  EXPECT_EQ(2u, results[1]);
+
+  // An empty query never intersects anything.
+  EXPECT_TRUE(rtree.Search(gfx::Rect(5, 5, 0, 0)).empty());
+}
+
+TEST(FlatRTreeTest, MatchesRTree) {
+  // Exercise every number of occupied slots in the last node of each level,
+  // including trees of one, two and three levels.
+  for (int count = 0; count < 600; count += 7) {
+    std::vector<gfx::Rect> rects;
+    for (int i = 0; i < count; ++i)
+      rects.push_back(gfx::Rect((i * 37) % 101, (i * 53) % 97, i % 13, i % 7));
+
+    RTree<size_t> rtree;
+    rtree.Build(rects);
+    FlatRTree<size_t> flat_rtree;
+    flat_rtree.Build(rects);
+
+    EXPECT_EQ(rtree.GetBounds(), flat_rtree.GetBounds());
+    for (int y = -10; y < 110; y += 9) {
+      for (int x = -10; x < 110; x += 11) {
+        gfx::Rect query(x, y, 1 + x % 17, 1 + y % 23);
+        ASSERT_EQ(rtree.Search(query), flat_rtree.Search(query))
+            << "count " << count << " query " << query.ToString();
+      }
+    }
+  }
+}
+
+TEST(FlatRTreeTest, SearchWithCallback) {
+  std::vector<gfx::Rect> rects;
+  for (int i = 0; i < 100; ++i)
+    rects.push_back(gfx::Rect(i, 0, 1, 1));
+
+  FlatRTree<size_t> rtree;
+  rtree.Build(rects);
+
+  size_t count = 0;
+  size_t sum = 0;
+  rtree.Search(gfx::Rect(10, 0, 20, 1), [&count, &sum](size_t index) {
+    ++count;
+    sum += index;
+  });
+  EXPECT_EQ(20u, count);
+  EXPECT_EQ((10u + 29u) * 20u / 2u, sum);
+}
+
+TEST(FlatRTreeTest, GetBoundsEmpty) {
+  FlatRTree<size_t> rtree;
+  EXPECT_EQ(gfx::Rect(), rtree.GetBounds());
+}
+
+TEST(FlatRTreeTest, GetBoundsNonOverlapping) {
+  std::vector<gfx::Rect> rects;
+  rects.push_back(gfx::Rect(5, 6, 7, 8));
+  rects.push_back(gfx::Rect(11, 12, 13, 14));
+
+  FlatRTree<size_t> rtree;
+  rtree.Build(rects);
+
+  EXPECT_EQ(gfx::Rect(5, 6, 19, 20), rtree.GetBounds());
+}
+
+TEST(FlatRTreeTest, BuildAfterReset) {
+  std::vector<gfx::Rect> rects;
+  rects.push_back(gfx::Rect(0, 0, 10, 10));
+  rects.push_back(gfx::Rect(0, 0, 10, 10));
+  rects.push_back(gfx::Rect(0, 0, 10, 10));
+  rects.push_back(gfx::Rect(0, 0, 10, 10));
+
+  FlatRTree<size_t> rtree;
+  rtree.Build(rects);
+
+  // Resetting should give the same as an empty rtree.
+  rtree.Reset();
+  EXPECT_EQ(gfx::Rect(), rtree.GetBounds());
+  EXPECT_TRUE(rtree.Search(gfx::Rect(0, 0, 10, 10)).empty());
+
+  // Should be able to rebuild from a reset rtree.
+  rtree.Build(rects);
+  EXPECT_EQ(gfx::Rect(0, 0, 10, 10), rtree.GetBounds());
+  EXPECT_EQ(4u, rtree.Search(gfx::Rect(0, 0, 10, 10)).size());
+}
+
+TEST(FlatRTreeTest, Payload) {
+  using Container = std::vector<std::pair<gfx::Rect, float>>;
+  Container data;
+  data.emplace_back(gfx::Rect(10, 10, 10, 10), 40.f);
+  data.emplace_back(gfx::Rect(0, 0, 10, 10), 10.f);
+  data.emplace_back(gfx::Rect(0, 10, 10, 10), 30.f);
+  data.emplace_back(gfx::Rect(10, 0, 10, 10), 20.f);
+
+  FlatRTree<float> rtree;
+  rtree.Build(
+      data,
+      [](const Container& items, size_t index) { return items[index].first; },
+      [](const Container& items, size_t index) { return items[index].second; });
+
+  auto results = rtree.Search(gfx::Rect(0, 0, 1, 1));
+  ASSERT_EQ(1u, results.size());
+  EXPECT_FLOAT_EQ(10.f, results[0]);
+
+  results = rtree.Search(gfx::Rect(5, 5, 10, 10));
+  ASSERT_EQ(4u, results.size());
+  // Items returned should be in the order they were inserted.
+  EXPECT_FLOAT_EQ(40.f, results[0]);
+  EXPECT_FLOAT_EQ(10.f, results[1]);
+  EXPECT_FLOAT_EQ(30.f, results[2]);
+  EXPECT_FLOAT_EQ(20.f, results[3]);
+}
+
+}  // namespace cc
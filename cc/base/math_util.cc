@@ -234,6 +234,142 @@ gfx::RectF MathUtil::MapClippedRect(const gfx::Transform& transform,
   return ComputeEnclosingClippedRect(hc0, hc1, hc2, hc3);
 }
 
+namespace {
+
+// The number of rects mapped together by MapEnclosingClippedRects().
+const size_t kRectBatchSize = 8;
+
+// A batch of rects along with the transforms mapping them, stored as a
+// structure of arrays so that each step of the mapping handles the whole
+// batch at once. Only the coefficients that affect the x and y of 2D points
+// are kept; the transforms must not have perspective.
+struct AffineRectBatch {
+  size_t size = 0;
+  // The index of each rect in the caller's arrays.
+  size_t indices[kRectBatchSize];
+
+  SkMScalar scale_x[kRectBatchSize];
+  SkMScalar skew_x[kRectBatchSize];
+  SkMScalar translate_x[kRectBatchSize];
+  SkMScalar skew_y[kRectBatchSize];
+  SkMScalar scale_y[kRectBatchSize];
+  SkMScalar translate_y[kRectBatchSize];
+
+  SkMScalar left[kRectBatchSize];
+  SkMScalar top[kRectBatchSize];
+  SkMScalar right[kRectBatchSize];
+  SkMScalar bottom[kRectBatchSize];
+};
+
+// Returns true if mapping a 2D point by |transform| always gives w == 1, in
+// which case MapClippedRect() never clips and only depends on the transform's
+// 2D affine coefficients.
+bool HasNoPerspectiveFor2dPoints(const gfx::Transform& transform) {
+  const SkMatrix44& matrix = transform.matrix();
+  return matrix.get(3, 0) == 0 && matrix.get(3, 1) == 0 &&
+         matrix.get(3, 3) == 1;
+}
+
+void AddToBatch(const gfx::Transform& transform,
+                const gfx::Rect& rect,
+                size_t index,
+                AffineRectBatch* batch) {
+  DCHECK_LT(batch->size, kRectBatchSize);
+  const SkMatrix44& matrix = transform.matrix();
+  // Like MapClippedRect(), go through gfx::RectF so that the edges are
+  // rounded the same way.
+  gfx::RectF src_rect(rect);
+  size_t i = batch->size++;
+  batch->indices[i] = index;
+  batch->scale_x[i] = matrix.get(0, 0);
+  batch->skew_x[i] = matrix.get(0, 1);
+  batch->translate_x[i] = matrix.get(0, 3);
+  batch->skew_y[i] = matrix.get(1, 0);
+  batch->scale_y[i] = matrix.get(1, 1);
+  batch->translate_y[i] = matrix.get(1, 3);
+  batch->left[i] = src_rect.x();
+  batch->top[i] = src_rect.y();
+  batch->right[i] = src_rect.right();
+  batch->bottom[i] = src_rect.bottom();
+}
+
+void MapBatch(AffineRectBatch* batch, gfx::Rect* mapped_rects) {
+  // Clear the unused slots so that the loops below can always run over the
+  // whole batch.
+  for (size_t i = batch->size; i < kRectBatchSize; ++i) {
+    batch->scale_x[i] = batch->skew_x[i] = batch->translate_x[i] = 0;
+    batch->skew_y[i] = batch->scale_y[i] = batch->translate_y[i] = 0;
+    batch->left[i] = batch->top[i] = batch->right[i] = batch->bottom[i] = 0;
+  }
+
+  // The corners of each rect, in the order used by gfx::QuadF(gfx::RectF).
+  // These are written branch-free over fixed-size arrays so that the compiler
+  // can vectorize them. The products are summed in the same order as
+  // SkMatrix44::map2(), so the results match MapClippedRect() exactly.
+  SkMScalar x[4][kRectBatchSize];
+  SkMScalar y[4][kRectBatchSize];
+  for (size_t i = 0; i < kRectBatchSize; ++i) {
+    SkMScalar left_x = batch->left[i] * batch->scale_x[i];
+    SkMScalar right_x = batch->right[i] * batch->scale_x[i];
+    SkMScalar top_x = batch->top[i] * batch->skew_x[i];
+    SkMScalar bottom_x = batch->bottom[i] * batch->skew_x[i];
+    x[0][i] = left_x + top_x + batch->translate_x[i];
+    x[1][i] = right_x + top_x + batch->translate_x[i];
+    x[2][i] = right_x + bottom_x + batch->translate_x[i];
+    x[3][i] = left_x + bottom_x + batch->translate_x[i];
+  }
+  for (size_t i = 0; i < kRectBatchSize; ++i) {
+    SkMScalar left_y = batch->left[i] * batch->skew_y[i];
+    SkMScalar right_y = batch->right[i] * batch->skew_y[i];
+    SkMScalar top_y = batch->top[i] * batch->scale_y[i];
+    SkMScalar bottom_y = batch->bottom[i] * batch->scale_y[i];
+    y[0][i] = left_y + top_y + batch->translate_y[i];
+    y[1][i] = right_y + top_y + batch->translate_y[i];
+    y[2][i] = right_y + bottom_y + batch->translate_y[i];
+    y[3][i] = left_y + bottom_y + batch->translate_y[i];
+  }
+
+  for (size_t i = 0; i < batch->size; ++i) {
+    gfx::QuadF mapped_quad(
+        gfx::PointF(x[0][i], y[0][i]), gfx::PointF(x[1][i], y[1][i]),
+        gfx::PointF(x[2][i], y[2][i]), gfx::PointF(x[3][i], y[3][i]));
+    gfx::RectF mapped_rect = mapped_quad.BoundingBox();
+    // gfx::ToEnclosingRect crashes if called on a RectF with any NaN
+    // coordinate.
+    gfx::Rect& result = mapped_rects[batch->indices[i]];
+    if (std::isnan(mapped_rect.x()) || std::isnan(mapped_rect.y()) ||
+        std::isnan(mapped_rect.right()) || std::isnan(mapped_rect.bottom()))
+      result = gfx::Rect();
+    else
+      result = gfx::ToEnclosingRect(mapped_rect);
+  }
+  batch->size = 0;
+}
+
+}  // namespace
+
+void MathUtil::MapEnclosingClippedRects(
+    const gfx::Transform* const* transforms,
+    const gfx::Rect* rects,
+    size_t count,
+    gfx::Rect* mapped_rects) {
+  AffineRectBatch batch;
+  for (size_t i = 0; i < count; ++i) {
+    const gfx::Transform& transform = *transforms[i];
+    // Translations have a cheaper path of their own.
+    if (transform.IsIdentityOrTranslation() ||
+        !HasNoPerspectiveFor2dPoints(transform)) {
+      mapped_rects[i] = MapEnclosingClippedRect(transform, rects[i]);
+      continue;
+    }
+    AddToBatch(transform, rects[i], i, &batch);
+    if (batch.size == kRectBatchSize)
+      MapBatch(&batch, mapped_rects);
+  }
+  if (batch.size)
+    MapBatch(&batch, mapped_rects);
+}
+
 gfx::Rect MathUtil::ProjectEnclosingClippedRect(const gfx::Transform& transform,
                                                 const gfx::Rect& src_rect) {
   if (transform.IsIdentityOrIntegerTranslation()) {
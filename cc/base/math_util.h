@@ -5,6 +5,8 @@
 #ifndef CC_BASE_MATH_UTIL_H_
 #define CC_BASE_MATH_UTIL_H_
 
+#include <stddef.h>
+
 #include <limits>
 #include <memory>
 #include <vector>
@@ -159,6 +161,15 @@ class CC_BASE_EXPORT MathUtil {
   static gfx::RectF ProjectClippedRect(const gfx::Transform& transform,
                                        const gfx::RectF& rect);
 
+  // Equivalent to calling MapEnclosingClippedRect(*transforms[i], rects[i])
+  // for each i in [0, count), with identical results. Rects whose transform
+  // has no perspective, by far the most common case, are mapped in batches
+  // laid out for SIMD; the others take the regular path.
+  static void MapEnclosingClippedRects(const gfx::Transform* const* transforms,
+                                       const gfx::Rect* rects,
+                                       size_t count,
+                                       gfx::Rect* mapped_rects);
+
   // This function is only valid when the transform preserves 2d axis
   // alignment and the resulting rect will not be clipped.
   static gfx::Rect MapEnclosedRectWith2dAxisAlignedTransform(
@@ -0,0 +1,97 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/base/math_util.h"
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#include "cc/base/lap_timer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/transform.h"
+
+namespace cc {
+namespace {
+
+static const int kTimeLimitMillis = 2000;
+static const int kWarmupRuns = 5;
+static const int kTimeCheckInterval = 10;
+
+// Maps the bounds of the layers of a large page to their targets, as done when
+// computing drawable content rects. Most layers have a 2D transform; a few are
+// in a 3D rendering context.
+class MapEnclosingClippedRectsPerfTest : public testing::Test {
+ public:
+  MapEnclosingClippedRectsPerfTest()
+      : timer_(kWarmupRuns,
+               base::TimeDelta::FromMilliseconds(kTimeLimitMillis),
+               kTimeCheckInterval) {}
+
+  void SetUp() override {
+    const int kNumLayers = 10000;
+    transforms_.resize(kNumLayers);
+    for (int i = 0; i < kNumLayers; ++i) {
+      gfx::Transform& transform = transforms_[i];
+      transform.Translate(i % 97, i % 89);
+      if (i % 100 == 0) {
+        transform.ApplyPerspectiveDepth(500);
+        transform.RotateAboutYAxis(i % 45);
+      } else {
+        transform.Rotate(i % 30);
+        transform.Scale(1.5f, 0.75f);
+      }
+      transform_ptrs_.push_back(&transform);
+      rects_.push_back(gfx::Rect(i % 13, i % 17, 50 + i % 200, 50 + i % 150));
+    }
+    mapped_rects_.resize(kNumLayers);
+  }
+
+  void RunOneAtATime(const std::string& test_name) {
+    timer_.Reset();
+    do {
+      for (size_t i = 0; i < rects_.size(); ++i) {
+        mapped_rects_[i] =
+            MathUtil::MapEnclosingClippedRect(*transform_ptrs_[i], rects_[i]);
+      }
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+
+    perf_test::PrintResult("map_enclosing_clipped_rects", "", test_name,
+                           timer_.LapsPerSecond(), "runs/s", true);
+  }
+
+  void RunBatched(const std::string& test_name) {
+    timer_.Reset();
+    do {
+      MathUtil::MapEnclosingClippedRects(transform_ptrs_.data(), rects_.data(),
+                                         rects_.size(), mapped_rects_.data());
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+
+    perf_test::PrintResult("map_enclosing_clipped_rects", "", test_name,
+                           timer_.LapsPerSecond(), "runs/s", true);
+  }
+
+ protected:
+  LapTimer timer_;
+  std::vector<gfx::Transform> transforms_;
+  std::vector<const gfx::Transform*> transform_ptrs_;
+  std::vector<gfx::Rect> rects_;
+  std::vector<gfx::Rect> mapped_rects_;
+};
+
+TEST_F(MapEnclosingClippedRectsPerfTest, OneAtATime10000) {
+  RunOneAtATime("one_at_a_time_10000");
+}
+
+TEST_F(MapEnclosingClippedRectsPerfTest, Batched10000) {
+  RunBatched("batched_10000");
+}
+
+}  // namespace
+}  // namespace cc
@@ -7,6 +7,7 @@
 #include <stdint.h>
 
 #include <cmath>
+#include <vector>
 
 #include "cc/test/geometry_test_utils.h"
 #include "testing/gmock/include/gmock/gmock.h"
@@ -339,6 +340,54 @@ TEST(MathUtilTest, MapEnclosingRectWithLargeTransforms) {
   EXPECT_EQ(gfx::Rect(), output);
 }
 
+TEST(MathUtilTest, MapEnclosingClippedRectsMatchesMapEnclosingClippedRect) {
+  std::vector<gfx::Transform> transforms(1);
+  transforms.emplace_back();
+  transforms.back().Translate(3, -4);
+  transforms.emplace_back();
+  transforms.back().Translate(0.25f, 1.5f);
+  transforms.emplace_back();
+  transforms.back().Scale(0.3f, 1.7f);
+  transforms.emplace_back();
+  transforms.back().Translate(11.1f, -2.2f);
+  transforms.back().Rotate(33);
+  transforms.emplace_back();
+  transforms.back().Skew(10, 20);
+  transforms.emplace_back();
+  transforms.back().RotateAboutXAxis(60);
+  transforms.emplace_back();
+  transforms.back().RotateAboutYAxis(170);
+  transforms.back().Scale(SkDoubleToMScalar(1e37), 1.0);
+  transforms.emplace_back();
+  transforms.back().ApplyPerspectiveDepth(100);
+  transforms.back().RotateAboutYAxis(45);
+  transforms.emplace_back();
+  transforms.back().ApplyPerspectiveDepth(10);
+  transforms.back().Translate3d(0, 0, 50);
+
+  std::vector<gfx::Rect> rects;
+  rects.push_back(gfx::Rect(0, 0, 100, 100));
+  rects.push_back(gfx::Rect(-7, 13, 1, 29));
+  rects.push_back(gfx::Rect(5, 5, 0, 0));
+
+  // Use a count that isn't a multiple of the batch size, with the different
+  // kinds of transforms interleaved.
+  std::vector<const gfx::Transform*> transform_ptrs;
+  std::vector<gfx::Rect> input;
+  for (int i = 0; i < 37; ++i) {
+    transform_ptrs.push_back(&transforms[(i * 7) % transforms.size()]);
+    input.push_back(rects[i % rects.size()]);
+  }
+  std::vector<gfx::Rect> output(input.size());
+  MathUtil::MapEnclosingClippedRects(transform_ptrs.data(), input.data(),
+                                     input.size(), output.data());
+  for (size_t i = 0; i < input.size(); ++i) {
+    EXPECT_EQ(MathUtil::MapEnclosingClippedRect(*transform_ptrs[i], input[i]),
+              output[i])
+        << "index " << i;
+  }
+}
+
 TEST(MathUtilTest, ProjectEnclosingRectWithLargeTransforms) {
   gfx::Rect input(1, 2, 100, 200);
   gfx::Rect output;
@@ -2,6 +2,7 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include "cc/base/flat_rtree.h"
 #include "cc/base/lap_timer.h"
 #include "cc/base/rtree.h"
 
@@ -30,30 +31,31 @@ class RTreePerfTest : public testing::Test {
                base::TimeDelta::FromMilliseconds(kTimeLimitMillis),
                kTimeCheckInterval) {}
 
-  void RunConstructTest(const std::string& test_name, int rect_count) {
+  template <typename Tree>
+  void RunConstructTest(const std::string& metric,
+                        const std::string& test_name,
+                        int rect_count) {
     std::vector<gfx::Rect> rects = BuildRects(rect_count);
     timer_.Reset();
     do {
-      RTree<size_t> rtree;
+      Tree rtree;
       rtree.Build(rects);
       timer_.NextLap();
     } while (!timer_.HasTimeLimitExpired());
 
-    perf_test::PrintResult("rtree_construct", "", test_name,
-                           timer_.LapsPerSecond(), "runs/s", true);
+    perf_test::PrintResult(metric, "", test_name, timer_.LapsPerSecond(),
+                           "runs/s", true);
   }
 
-  void RunSearchTest(const std::string& test_name, int rect_count) {
-    int large_query = std::sqrt(rect_count);
-
-    std::vector<gfx::Rect> queries = {
-        gfx::Rect(0, 0, 1, 1), gfx::Rect(100, 100, 2, 2),
-        gfx::Rect(-10, -10, 1, 1), gfx::Rect(0, 0, 1000, 1000),
-        gfx::Rect(large_query - 2, large_query - 2, 1, 1)};
+  template <typename Tree>
+  void RunSearchTest(const std::string& metric,
+                     const std::string& test_name,
+                     int rect_count) {
+    std::vector<gfx::Rect> queries = BuildQueries(rect_count);
     size_t query_index = 0;
 
     std::vector<gfx::Rect> rects = BuildRects(rect_count);
-    RTree<size_t> rtree;
+    Tree rtree;
     rtree.Build(rects);
 
     timer_.Reset();
@@ -63,10 +65,39 @@ class RTreePerfTest : public testing::Test {
       timer_.NextLap();
     } while (!timer_.HasTimeLimitExpired());
 
-    perf_test::PrintResult("rtree_search", "", test_name,
+    perf_test::PrintResult(metric, "", test_name, timer_.LapsPerSecond(),
+                           "runs/s", true);
+  }
+
+  void RunFlatSearchWithCallbackTest(const std::string& test_name,
+                                     int rect_count) {
+    std::vector<gfx::Rect> queries = BuildQueries(rect_count);
+    size_t query_index = 0;
+
+    std::vector<gfx::Rect> rects = BuildRects(rect_count);
+    FlatRTree<size_t> rtree;
+    rtree.Build(rects);
+
+    size_t result = 0;
+    timer_.Reset();
+    do {
+      rtree.Search(queries[query_index],
+                   [&result](size_t index) { result += index; });
+      query_index = (query_index + 1) % queries.size();
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+
+    perf_test::PrintResult("flat_rtree_search_callback", "", test_name,
                            timer_.LapsPerSecond(), "runs/s", true);
   }
 
+  std::vector<gfx::Rect> BuildQueries(int rect_count) {
+    int large_query = std::sqrt(rect_count);
+    return {gfx::Rect(0, 0, 1, 1), gfx::Rect(100, 100, 2, 2),
+            gfx::Rect(-10, -10, 1, 1), gfx::Rect(0, 0, 1000, 1000),
+            gfx::Rect(large_query - 2, large_query - 2, 1, 1)};
+  }
+
   std::vector<gfx::Rect> BuildRects(int count) {
     std::vector<gfx::Rect> result;
     int width = std::sqrt(count);
@@ -87,17 +118,39 @@ class RTreePerfTest : public testing::Test {
 };
 
 TEST_F(RTreePerfTest, Construct) {
-  RunConstructTest("100", 100);
-  RunConstructTest("1000", 1000);
-  RunConstructTest("10000", 10000);
-  RunConstructTest("100000", 100000);
+  RunConstructTest<RTree<size_t>>("rtree_construct", "100", 100);
+  RunConstructTest<RTree<size_t>>("rtree_construct", "1000", 1000);
+  RunConstructTest<RTree<size_t>>("rtree_construct", "10000", 10000);
+  RunConstructTest<RTree<size_t>>("rtree_construct", "100000", 100000);
 }
 
 TEST_F(RTreePerfTest, Search) {
-  RunSearchTest("100", 100);
-  RunSearchTest("1000", 1000);
-  RunSearchTest("10000", 10000);
-  RunSearchTest("100000", 100000);
+  RunSearchTest<RTree<size_t>>("rtree_search", "100", 100);
+  RunSearchTest<RTree<size_t>>("rtree_search", "1000", 1000);
+  RunSearchTest<RTree<size_t>>("rtree_search", "10000", 10000);
+  RunSearchTest<RTree<size_t>>("rtree_search", "100000", 100000);
+}
+
+TEST_F(RTreePerfTest, FlatConstruct) {
+  RunConstructTest<FlatRTree<size_t>>("flat_rtree_construct", "100", 100);
+  RunConstructTest<FlatRTree<size_t>>("flat_rtree_construct", "1000", 1000);
+  RunConstructTest<FlatRTree<size_t>>("flat_rtree_construct", "10000", 10000);
+  RunConstructTest<FlatRTree<size_t>>("flat_rtree_construct", "100000",
+                                      100000);
+}
+
+TEST_F(RTreePerfTest, FlatSearch) {
+  RunSearchTest<FlatRTree<size_t>>("flat_rtree_search", "100", 100);
+  RunSearchTest<FlatRTree<size_t>>("flat_rtree_search", "1000", 1000);
+  RunSearchTest<FlatRTree<size_t>>("flat_rtree_search", "10000", 10000);
+  RunSearchTest<FlatRTree<size_t>>("flat_rtree_search", "100000", 100000);
+}
+
+TEST_F(RTreePerfTest, FlatSearchWithCallback) {
+  RunFlatSearchWithCallbackTest("100", 100);
+  RunFlatSearchWithCallbackTest("1000", 1000);
+  RunFlatSearchWithCallbackTest("10000", 10000);
+  RunFlatSearchWithCallbackTest("100000", 100000);
 }
 
 }  // namespace
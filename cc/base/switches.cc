@@ -46,6 +46,20 @@ const char kSlowDownRasterScaleFactor[] = "slow-down-raster-scale-factor";
 // Compress tile textures for GPUs supporting it.
 const char kEnableTileCompression[] = "enable-tile-compression";
 
+// Splits large software-rastered tiles into horizontal bands that are rastered
+// concurrently on the raster worker threads.
+const char kEnableParallelTileRaster[] = "enable-parallel-tile-raster";
+
+// Keeps software image decodes in a process-wide cache when a layer tree drops
+// them, so they can be reused across navigations and layer trees.
+const char kEnableSharedDecodedImageCache[] =
+    "enable-shared-decoded-image-cache";
+
+// Runs raster worker pool tasks on per-thread queues that idle threads steal
+// from, instead of picking each task under a single pool-wide lock.
+const char kEnableWorkStealingRasterWorkerPool[] =
+    "enable-work-stealing-raster-worker-pool";
+
 // Enables the GPU benchmarking extension
 const char kEnableGpuBenchmarking[] = "enable-gpu-benchmarking";
 
@@ -27,6 +27,9 @@ CC_BASE_EXPORT extern const char kBrowserControlsShowThreshold[];
 CC_BASE_EXPORT extern const char kSlowDownRasterScaleFactor[];
 CC_BASE_EXPORT extern const char kStrictLayerPropertyChangeChecking[];
 CC_BASE_EXPORT extern const char kEnableTileCompression[];
+CC_BASE_EXPORT extern const char kEnableParallelTileRaster[];
+CC_BASE_EXPORT extern const char kEnableSharedDecodedImageCache[];
+CC_BASE_EXPORT extern const char kEnableWorkStealingRasterWorkerPool[];
 
 // Switches for both the renderer and ui compositors.
 CC_BASE_EXPORT extern const char kEnableGpuBenchmarking[];
@@ -518,7 +518,7 @@ void Layer::SetOpacity(float opacity) {
             property_trees->effect_tree.Node(effect_tree_index())) {
       node->opacity = opacity;
       node->effect_changed = true;
-      property_trees->effect_tree.set_needs_update(true);
+      property_trees->effect_tree.SetSubtreeNeedsUpdate(node->id);
     }
   }
   if (force_rebuild)
@@ -629,7 +629,8 @@ void Layer::SetPosition(const gfx::PointF& position) {
     transform_node->update_post_local_transform(position, transform_origin());
     transform_node->needs_local_transform_update = true;
     transform_node->transform_changed = true;
-    layer_tree_host_->property_trees()->transform_tree.set_needs_update(true);
+    layer_tree_host_->property_trees()->transform_tree.SetSubtreeNeedsUpdate(
+        transform_node->id);
   } else {
     SetPropertyTreesNeedRebuild();
   }
@@ -707,7 +708,8 @@ void Layer::SetTransformOrigin(const gfx::Point3F& transform_origin) {
     transform_node->update_post_local_transform(position(), transform_origin);
     transform_node->needs_local_transform_update = true;
     transform_node->transform_changed = true;
-    layer_tree_host_->property_trees()->transform_tree.set_needs_update(true);
+    layer_tree_host_->property_trees()->transform_tree.SetSubtreeNeedsUpdate(
+        transform_node->id);
   } else {
     SetPropertyTreesNeedRebuild();
   }
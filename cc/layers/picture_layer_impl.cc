@@ -587,6 +587,11 @@ bool PictureLayerImpl::UpdateTiles() {
           ? draw_properties().occlusion_in_content_space
           : kEmptyOcclusion;
 
+  // Scroll offsets are in the space of the scrolled contents, which is only
+  // translated from the layer space of the layers that get a prediction.
+  tilings_->SetScrollPrediction(layer_tree_impl()->GetScrollPrediction(
+      scroll_tree_index(), transform_tree_index()));
+
   // Pass |occlusion_in_content_space| for |occlusion_in_layer_space| since
   // they are the same space in picture layer, as contents scale is always 1.
   bool updated = tilings_->UpdateTilePriorities(
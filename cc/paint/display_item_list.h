@@ -14,7 +14,7 @@
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
 #include "base/trace_event/trace_event.h"
-#include "cc/base/rtree.h"
+#include "cc/base/flat_rtree.h"
 #include "cc/paint/discardable_image_map.h"
 #include "cc/paint/image_id.h"
 #include "cc/paint/paint_export.h"
@@ -193,7 +193,7 @@ class CC_PAINT_EXPORT DisplayItemList
 
   // RTree stores indices into the paint op buffer.
   // TODO(vmpstr): Update the rtree to store offsets instead.
-  RTree<size_t> rtree_;
+  FlatRTree<size_t> rtree_;
   DiscardableImageMap image_map_;
   PaintOpBuffer paint_op_buffer_;
 
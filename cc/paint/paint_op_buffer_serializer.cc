@@ -4,7 +4,11 @@
 
 #include "cc/paint/paint_op_buffer_serializer.h"
 
+#include <string.h>
+
 #include "base/bind.h"
+#include "base/hash.h"
+#include "cc/paint/paint_op_chunk_cache.h"
 #include "cc/paint/scoped_image_flags.h"
 #include "ui/gfx/skia_util.h"
 
@@ -24,6 +28,16 @@ class ScopedFlagsOverride {
   PaintOp::SerializeOptions* options_;
 };
 
+// Chunks end after an op whose hash has none of the bits in
+// |kChunkBoundaryMask| set, once they are at least |kMinChunkBytes|, so that
+// chunks are around 2KB on average. They are never more than |kMaxChunkBytes|,
+// unless a single op is larger.
+constexpr size_t kMinChunkBytes = 512;
+constexpr size_t kMaxChunkBytes = 8 * 1024;
+constexpr uint32_t kChunkBoundaryMask = 0xF;
+// The largest single op that can be put in a chunk.
+constexpr size_t kMaxChunkCapacity = 16 * 1024 * 1024;
+
 }  // namespace
 
 PaintOpBufferSerializer::PaintOpBufferSerializer(SerializeCallback serialize_cb,
@@ -46,7 +60,9 @@ void PaintOpBufferSerializer::Serialize(const PaintOpBuffer* buffer,
   int save_count = canvas_.getSaveCount();
   Save(options, params);
   SerializePreamble(preamble, options, params);
+  WillSerializeRootBuffer();
   SerializeBuffer(buffer, offsets);
+  DidSerializeRootBuffer();
   RestoreToCount(save_count, options, params);
 }
 
@@ -213,4 +229,133 @@ size_t SimpleBufferSerializer::SerializeToMemory(
   return bytes;
 }
 
+ChunkedBufferSerializer::ChunkedBufferSerializer(
+    void* memory,
+    size_t size,
+    ImageProvider* image_provider,
+    PaintOpChunkCache* chunk_cache)
+    : PaintOpBufferSerializer(
+          base::Bind(&ChunkedBufferSerializer::SerializeToRecords,
+                     base::Unretained(this)),
+          image_provider),
+      memory_(static_cast<char*>(memory)),
+      total_(size),
+      chunk_cache_(chunk_cache),
+      chunk_capacity_(kMaxChunkBytes + sizeof(LargestPaintOp)) {
+  DCHECK(chunk_cache_);
+  // Keep the padding between ops zeroed, so that the same ops always hash to
+  // the same chunk.
+  chunk_.reset(static_cast<char*>(
+      base::AlignedAlloc(chunk_capacity_, PaintOpBuffer::PaintOpAlign)));
+  memset(chunk_.get(), 0, chunk_capacity_);
+}
+
+ChunkedBufferSerializer::~ChunkedBufferSerializer() = default;
+
+void ChunkedBufferSerializer::WillSerializeRootBuffer() {
+  DCHECK(!in_root_buffer_);
+  in_root_buffer_ = true;
+}
+
+void ChunkedBufferSerializer::DidSerializeRootBuffer() {
+  DCHECK(in_root_buffer_);
+  in_root_buffer_ = false;
+  // A failure shows up as a failure to serialize the next op, which is at least
+  // the restore matching the save before the preamble.
+  if (!FlushChunk())
+    failed_ = true;
+}
+
+size_t ChunkedBufferSerializer::SerializeToRecords(
+    const PaintOp* op,
+    const PaintOp::SerializeOptions& options) {
+  if (failed_)
+    return 0u;
+  return in_root_buffer_ ? SerializeToChunk(op, options)
+                         : SerializeInline(op, options);
+}
+
+size_t ChunkedBufferSerializer::SerializeInline(
+    const PaintOp* op,
+    const PaintOp::SerializeOptions& options) {
+  if (!has_open_inline_record_) {
+    if (!WriteRecord(PaintOpChunkRecord::kInlineOps, 0u))
+      return 0u;
+    has_open_inline_record_ = true;
+    open_inline_record_offset_ = written_ - sizeof(PaintOpChunkRecord);
+  }
+
+  if (written_ == total_)
+    return 0u;
+  size_t bytes = op->Serialize(memory_ + written_, total_ - written_, options);
+  if (!bytes)
+    return 0u;
+
+  written_ += bytes;
+  DCHECK_GE(total_, written_);
+  auto* record = reinterpret_cast<PaintOpChunkRecord*>(
+      memory_ + open_inline_record_offset_);
+  record->value += static_cast<uint32_t>(bytes);
+  return bytes;
+}
+
+size_t ChunkedBufferSerializer::SerializeToChunk(
+    const PaintOp* op,
+    const PaintOp::SerializeOptions& options) {
+  size_t bytes = op->Serialize(chunk_.get() + chunk_size_,
+                               chunk_capacity_ - chunk_size_, options);
+  if (!bytes) {
+    // The op doesn't fit after the ops already in the chunk. Send those, and
+    // grow the chunk until the op fits on its own.
+    if (!FlushChunk())
+      return 0u;
+    // Clear whatever the failed attempt wrote.
+    memset(chunk_.get(), 0, chunk_capacity_);
+    while (!(bytes = op->Serialize(chunk_.get(), chunk_capacity_, options))) {
+      if (chunk_capacity_ >= kMaxChunkCapacity)
+        return 0u;
+      chunk_capacity_ *= 2;
+      chunk_.reset(static_cast<char*>(
+          base::AlignedAlloc(chunk_capacity_, PaintOpBuffer::PaintOpAlign)));
+      memset(chunk_.get(), 0, chunk_capacity_);
+    }
+  }
+
+  uint32_t op_hash = base::Hash(chunk_.get() + chunk_size_, bytes);
+  chunk_hash_ = static_cast<uint32_t>(base::HashInts32(chunk_hash_, op_hash));
+  chunk_size_ += bytes;
+
+  bool at_boundary =
+      chunk_size_ >= kMinChunkBytes && !(op_hash & kChunkBoundaryMask);
+  if ((at_boundary || chunk_size_ >= kMaxChunkBytes) && !FlushChunk())
+    return 0u;
+  return bytes;
+}
+
+bool ChunkedBufferSerializer::FlushChunk() {
+  if (!chunk_size_)
+    return true;
+
+  uint32_t id = chunk_cache_->GetOrCreateChunk(
+      chunk_hash_, reinterpret_cast<const uint8_t*>(chunk_.get()),
+      chunk_size_);
+  memset(chunk_.get(), 0, chunk_size_);
+  chunk_size_ = 0u;
+  chunk_hash_ = 0u;
+  return WriteRecord(PaintOpChunkRecord::kChunk, id);
+}
+
+bool ChunkedBufferSerializer::WriteRecord(uint32_t type, uint32_t value) {
+  has_open_inline_record_ = false;
+  if (total_ - written_ < sizeof(PaintOpChunkRecord))
+    return false;
+
+  PaintOpChunkRecord record = {};
+  record.type = type;
+  record.value = value;
+  memcpy(memory_ + written_, &record, sizeof(record));
+  written_ += sizeof(record);
+  return true;
+}
+
 }  // namespace cc
@@ -7,10 +7,15 @@
 
 #include "cc/paint/paint_op_buffer.h"
 
+#include <memory>
+
+#include "base/memory/aligned_memory.h"
 #include "third_party/skia/include/utils/SkNoDrawCanvas.h"
 
 namespace cc {
 
+class PaintOpChunkCache;
+
 class CC_PAINT_EXPORT PaintOpBufferSerializer {
  public:
   using SerializeCallback =
@@ -32,6 +37,13 @@ class CC_PAINT_EXPORT PaintOpBufferSerializer {
 
   bool valid() const { return valid_; }
 
+ protected:
+  // Called around the serialization of the ops in the buffer passed to
+  // Serialize(), as opposed to the ops of the preamble and the saves and
+  // restores around it.
+  virtual void WillSerializeRootBuffer() {}
+  virtual void DidSerializeRootBuffer() {}
+
  private:
   void SerializePreamble(const Preamble& preamble,
                          const PaintOp::SerializeOptions& options,
@@ -76,6 +88,57 @@ class CC_PAINT_EXPORT SimpleBufferSerializer : public PaintOpBufferSerializer {
   size_t written_ = 0u;
 };
 
+// Serializes the ops in the memory available, like SimpleBufferSerializer,
+// except that the ops of the buffer itself are sent in chunks through
+// |chunk_cache|, and only references to the chunks are written. Chunks that
+// are the same as in a previous raster are not sent again. See
+// PaintOpChunkRecord for the format written, and PaintOpChunkReader to read
+// it.
+//
+// Chunk boundaries are picked based on the content of the ops, so that a
+// change to some ops in the buffer only changes the chunks around them.
+class CC_PAINT_EXPORT ChunkedBufferSerializer : public PaintOpBufferSerializer {
+ public:
+  ChunkedBufferSerializer(void* memory,
+                          size_t size,
+                          ImageProvider* image_provider,
+                          PaintOpChunkCache* chunk_cache);
+  ~ChunkedBufferSerializer() override;
+
+  size_t written() const { return written_; }
+
+ private:
+  // PaintOpBufferSerializer implementation.
+  void WillSerializeRootBuffer() override;
+  void DidSerializeRootBuffer() override;
+
+  size_t SerializeToRecords(const PaintOp* op,
+                            const PaintOp::SerializeOptions& options);
+  size_t SerializeInline(const PaintOp* op,
+                         const PaintOp::SerializeOptions& options);
+  size_t SerializeToChunk(const PaintOp* op,
+                          const PaintOp::SerializeOptions& options);
+  bool FlushChunk();
+  bool WriteRecord(uint32_t type, uint32_t value);
+
+  char* memory_;
+  const size_t total_;
+  size_t written_ = 0u;
+  PaintOpChunkCache* chunk_cache_;
+  bool in_root_buffer_ = false;
+  bool failed_ = false;
+  // The offset of the last record written, if it is a kInlineOps record that
+  // more ops can be appended to.
+  bool has_open_inline_record_ = false;
+  size_t open_inline_record_offset_ = 0u;
+
+  // The ops of the chunk being built.
+  std::unique_ptr<char, base::AlignedFreeDeleter> chunk_;
+  size_t chunk_capacity_;
+  size_t chunk_size_ = 0u;
+  uint32_t chunk_hash_ = 0u;
+};
+
 }  // namespace cc
 
 #endif  // CC_PAINT_PAINT_OP_BUFFER_SERIALIZER_H_
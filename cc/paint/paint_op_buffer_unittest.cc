@@ -3,6 +3,11 @@
 // found in the LICENSE file.
 
 #include "cc/paint/paint_op_buffer.h"
+
+#include <map>
+
+#include "base/bind.h"
+#include "base/memory/aligned_memory.h"
 #include "base/memory/ptr_util.h"
 #include "base/strings/stringprintf.h"
 #include "cc/paint/decoded_draw_image.h"
@@ -10,6 +15,8 @@
 #include "cc/paint/image_provider.h"
 #include "cc/paint/paint_image_builder.h"
 #include "cc/paint/paint_op_buffer_serializer.h"
+#include "cc/paint/paint_op_chunk_cache.h"
+#include "cc/paint/paint_op_chunk_transfer_cache_entry.h"
 #include "cc/paint/paint_op_reader.h"
 #include "cc/paint/paint_op_writer.h"
 #include "cc/test/geometry_test_utils.h"
@@ -2178,6 +2185,236 @@ TEST(PaintOpBufferSerializationTest, AlphaFoldingDuringSerialization) {
   }
 }
 
+// Stands in for the client and service transfer caches.
+class FakePaintOpChunkCacheClient : public PaintOpChunkCache::Client {
+ public:
+  void CreateChunkEntry(
+      uint32_t id,
+      const ClientPaintOpChunkTransferCacheEntry& entry) override {
+    std::vector<uint8_t> data(entry.SerializedSize());
+    ASSERT_TRUE(entry.Serialize(data.size(), data.data()));
+    auto service_entry =
+        std::make_unique<ServicePaintOpChunkTransferCacheEntry>();
+    ASSERT_TRUE(service_entry->Deserialize(nullptr, data.size(), data.data()));
+    entries_[id] = std::move(service_entry);
+  }
+
+  void DeleteChunkEntry(uint32_t id) override {
+    EXPECT_EQ(1u, entries_.erase(id));
+  }
+
+  const ServicePaintOpChunkTransferCacheEntry* GetChunk(uint32_t id) {
+    auto it = entries_.find(id);
+    return it == entries_.end() ? nullptr : it->second.get();
+  }
+
+  size_t num_entries() const { return entries_.size(); }
+
+ private:
+  std::map<uint32_t, std::unique_ptr<ServicePaintOpChunkTransferCacheEntry>>
+      entries_;
+};
+
+// Reads the records written by a ChunkedBufferSerializer back into a buffer.
+sk_sp<PaintOpBuffer> ReadChunkedBuffer(const char* memory,
+                                       size_t size,
+                                       FakePaintOpChunkCacheClient* client) {
+  std::vector<char> ops;
+  PaintOpChunkReader reader(
+      memory, size,
+      base::Bind(&FakePaintOpChunkCacheClient::GetChunk,
+                 base::Unretained(client)));
+  const volatile void* range = nullptr;
+  size_t range_size = 0u;
+  while (reader.Next(&range, &range_size)) {
+    const volatile char* range_data = static_cast<const volatile char*>(range);
+    ops.insert(ops.end(), range_data, range_data + range_size);
+  }
+  if (!reader.valid())
+    return nullptr;
+
+  std::unique_ptr<char, base::AlignedFreeDeleter> aligned_ops(
+      static_cast<char*>(base::AlignedAlloc(std::max<size_t>(ops.size(), 1u),
+                                            PaintOpBuffer::PaintOpAlign)));
+  memcpy(aligned_ops.get(), ops.data(), ops.size());
+  PaintOp::DeserializeOptions deserialize_options;
+  return PaintOpBuffer::MakeFromMemory(aligned_ops.get(), ops.size(),
+                                       deserialize_options);
+}
+
+void PushManyDrawRectOps(PaintOpBuffer* buffer, size_t count) {
+  PaintFlags flags;
+  for (size_t i = 0; i < count; ++i) {
+    flags.setColor(SkColorSetARGB(255, i % 256, (i / 256) % 256, 0));
+    buffer->push<DrawRectOp>(SkRect::MakeXYWH(i, i, 10.f, 10.f), flags);
+  }
+}
+
+TEST(PaintOpSerializationTest, ChunkedSerializationMatchesSimple) {
+  PaintOpBuffer buffer;
+  PushManyDrawRectOps(&buffer, 1000);
+
+  PaintOpBufferSerializer::Preamble preamble;
+  preamble.translation = gfx::Vector2dF(10.f, 20.f);
+  preamble.playback_rect = gfx::Rect(1000, 1000);
+
+  const size_t kMemorySize = 1024 * 1024;
+  std::unique_ptr<char, base::AlignedFreeDeleter> simple_memory(
+      static_cast<char*>(
+          base::AlignedAlloc(kMemorySize, PaintOpBuffer::PaintOpAlign)));
+  SimpleBufferSerializer simple_serializer(simple_memory.get(), kMemorySize,
+                                           nullptr);
+  simple_serializer.Serialize(&buffer, nullptr, preamble);
+  ASSERT_TRUE(simple_serializer.valid());
+
+  FakePaintOpChunkCacheClient client;
+  PaintOpChunkCache chunk_cache(&client, PaintOpChunkCache::kDefaultMaxBytes);
+  std::unique_ptr<char, base::AlignedFreeDeleter> chunked_memory(
+      static_cast<char*>(
+          base::AlignedAlloc(kMemorySize, PaintOpBuffer::PaintOpAlign)));
+  ChunkedBufferSerializer chunked_serializer(
+      chunked_memory.get(), kMemorySize, nullptr, &chunk_cache);
+  chunked_serializer.Serialize(&buffer, nullptr, preamble);
+  ASSERT_TRUE(chunked_serializer.valid());
+  chunk_cache.FinishRaster();
+
+  // The ops of the buffer were split into several chunks, and only the
+  // references to them were written inline.
+  EXPECT_GT(client.num_entries(), 1u);
+  EXPECT_LT(chunked_serializer.written(), simple_serializer.written());
+
+  PaintOp::DeserializeOptions deserialize_options;
+  auto expected_buffer = PaintOpBuffer::MakeFromMemory(
+      simple_memory.get(), simple_serializer.written(), deserialize_options);
+  ASSERT_TRUE(expected_buffer);
+  auto chunked_buffer = ReadChunkedBuffer(
+      chunked_memory.get(), chunked_serializer.written(), &client);
+  ASSERT_TRUE(chunked_buffer);
+  ASSERT_EQ(expected_buffer->size(), chunked_buffer->size());
+
+  auto expected_iter = PaintOpBuffer::Iterator(expected_buffer.get());
+  for (const auto* op : PaintOpBuffer::Iterator(chunked_buffer.get())) {
+    EXPECT_EQ(**expected_iter, *op);
+    ++expected_iter;
+  }
+}
+
+TEST(PaintOpSerializationTest, ChunkedSerializationReusesChunks) {
+  PaintOpBuffer buffer;
+  PushManyDrawRectOps(&buffer, 1000);
+
+  FakePaintOpChunkCacheClient client;
+  PaintOpChunkCache chunk_cache(&client, PaintOpChunkCache::kDefaultMaxBytes);
+  const size_t kMemorySize = 1024 * 1024;
+  std::unique_ptr<char, base::AlignedFreeDeleter> memory(static_cast<char*>(
+      base::AlignedAlloc(kMemorySize, PaintOpBuffer::PaintOpAlign)));
+
+  PaintOpBufferSerializer::Preamble preamble;
+  preamble.playback_rect = gfx::Rect(1000, 1000);
+  {
+    ChunkedBufferSerializer serializer(memory.get(), kMemorySize, nullptr,
+                                       &chunk_cache);
+    serializer.Serialize(&buffer, nullptr, preamble);
+    ASSERT_TRUE(serializer.valid());
+    chunk_cache.FinishRaster();
+  }
+  size_t bytes_sent = chunk_cache.bytes_sent();
+  size_t num_entries = client.num_entries();
+  EXPECT_GT(bytes_sent, 0u);
+
+  // Rastering the same buffer with a different preamble sends no new chunks.
+  preamble.translation = gfx::Vector2dF(256.f, 0.f);
+  {
+    ChunkedBufferSerializer serializer(memory.get(), kMemorySize, nullptr,
+                                       &chunk_cache);
+    serializer.Serialize(&buffer, nullptr, preamble);
+    ASSERT_TRUE(serializer.valid());
+    chunk_cache.FinishRaster();
+    EXPECT_TRUE(
+        ReadChunkedBuffer(memory.get(), serializer.written(), &client));
+  }
+  EXPECT_EQ(bytes_sent, chunk_cache.bytes_sent());
+  EXPECT_EQ(num_entries, client.num_entries());
+
+  // Changing an op in the middle of the buffer only sends the chunks around
+  // it again.
+  PaintOpBuffer changed_buffer;
+  PushManyDrawRectOps(&changed_buffer, 500);
+  changed_buffer.push<DrawColorOp>(SK_ColorBLUE, SkBlendMode::kSrc);
+  PushManyDrawRectOps(&changed_buffer, 1000);
+  {
+    ChunkedBufferSerializer serializer(memory.get(), kMemorySize, nullptr,
+                                       &chunk_cache);
+    serializer.Serialize(&changed_buffer, nullptr, preamble);
+    ASSERT_TRUE(serializer.valid());
+    chunk_cache.FinishRaster();
+    EXPECT_TRUE(
+        ReadChunkedBuffer(memory.get(), serializer.written(), &client));
+  }
+  EXPECT_GT(chunk_cache.bytes_sent(), bytes_sent);
+  EXPECT_LT(chunk_cache.bytes_sent() - bytes_sent, bytes_sent / 2);
+}
+
+TEST(PaintOpSerializationTest, ChunkedSerializationEvictsOverBudget) {
+  FakePaintOpChunkCacheClient client;
+  PaintOpChunkCache chunk_cache(&client, 0u);
+  const size_t kMemorySize = 1024 * 1024;
+  std::unique_ptr<char, base::AlignedFreeDeleter> memory(static_cast<char*>(
+      base::AlignedAlloc(kMemorySize, PaintOpBuffer::PaintOpAlign)));
+
+  PaintOpBuffer buffer;
+  PushManyDrawRectOps(&buffer, 1000);
+  ChunkedBufferSerializer serializer(memory.get(), kMemorySize, nullptr,
+                                     &chunk_cache);
+  serializer.Serialize(&buffer, nullptr, PaintOpBufferSerializer::Preamble());
+  ASSERT_TRUE(serializer.valid());
+
+  // Chunks used by the raster are kept until it has been sent.
+  EXPECT_GT(client.num_entries(), 0u);
+  EXPECT_TRUE(ReadChunkedBuffer(memory.get(), serializer.written(), &client));
+  chunk_cache.FinishRaster();
+  EXPECT_EQ(0u, client.num_entries());
+  EXPECT_EQ(0u, chunk_cache.bytes());
+
+  // References to chunks the service doesn't have fail to read.
+  EXPECT_FALSE(ReadChunkedBuffer(memory.get(), serializer.written(), &client));
+}
+
+TEST(PaintOpSerializationTest, ChunkRecordValidation) {
+  PaintOpChunkRecord records[2] = {};
+  const size_t kAlign = PaintOpBuffer::PaintOpAlign;
+  uint32_t type = 0u;
+  uint32_t value = 0u;
+
+  records[0].type = PaintOpChunkRecord::kChunk;
+  records[0].value = 7u;
+  EXPECT_TRUE(PaintOpReader::ReadAndValidateChunkRecord(
+      records, sizeof(PaintOpChunkRecord), &type, &value));
+  EXPECT_EQ(static_cast<uint32_t>(PaintOpChunkRecord::kChunk), type);
+  EXPECT_EQ(7u, value);
+  EXPECT_FALSE(PaintOpReader::ReadAndValidateChunkRecord(
+      records, sizeof(PaintOpChunkRecord) - 1, &type, &value));
+
+  records[0].type = PaintOpChunkRecord::kInlineOps;
+  records[0].value = kAlign;
+  EXPECT_TRUE(PaintOpReader::ReadAndValidateChunkRecord(
+      records, sizeof(records), &type, &value));
+  // Inline ops that are empty, misaligned or past the end.
+  records[0].value = 0u;
+  EXPECT_FALSE(PaintOpReader::ReadAndValidateChunkRecord(
+      records, sizeof(records), &type, &value));
+  records[0].value = kAlign + 1;
+  EXPECT_FALSE(PaintOpReader::ReadAndValidateChunkRecord(
+      records, sizeof(records), &type, &value));
+  records[0].value = sizeof(records);
+  EXPECT_FALSE(PaintOpReader::ReadAndValidateChunkRecord(
+      records, sizeof(records), &type, &value));
+
+  records[0].type = PaintOpChunkRecord::kChunk + 1;
+  EXPECT_FALSE(PaintOpReader::ReadAndValidateChunkRecord(
+      records, sizeof(records), &type, &value));
+}
+
 // Test generic PaintOp deserializing failure cases.
 TEST(PaintOpBufferTest, PaintOpDeserialize) {
   static constexpr size_t kSize = sizeof(LargestPaintOp) + 100;
@@ -0,0 +1,77 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/paint/paint_op_chunk_cache.h"
+
+#include <string.h>
+
+#include <utility>
+
+#include "cc/paint/paint_op_chunk_transfer_cache_entry.h"
+
+namespace cc {
+
+// static
+const size_t PaintOpChunkCache::kDefaultMaxBytes = 4 * 1024 * 1024;
+
+PaintOpChunkCache::Chunk::Chunk(uint32_t id, const uint8_t* data, size_t size)
+    : id(id), data(data, data + size) {}
+
+PaintOpChunkCache::Chunk::Chunk(Chunk&& other) = default;
+
+PaintOpChunkCache::Chunk::~Chunk() = default;
+
+PaintOpChunkCache::Chunk& PaintOpChunkCache::Chunk::operator=(Chunk&& other) =
+    default;
+
+PaintOpChunkCache::PaintOpChunkCache(Client* client, size_t max_bytes)
+    : client_(client),
+      max_bytes_(max_bytes),
+      chunks_(ChunkMRUCache::NO_AUTO_EVICT) {
+  DCHECK(client_);
+}
+
+PaintOpChunkCache::~PaintOpChunkCache() = default;
+
+uint32_t PaintOpChunkCache::GetOrCreateChunk(uint32_t hash,
+                                             const uint8_t* data,
+                                             size_t size) {
+  auto it = chunks_.Get(hash);
+  if (it != chunks_.end()) {
+    // The hash is only used to find the chunk, the content must match too.
+    const std::vector<uint8_t>& cached_data = it->second.data;
+    if (cached_data.size() == size && !memcmp(cached_data.data(), data, size))
+      return it->second.id;
+
+    // The old chunk may still be referenced by this raster, so it can't be
+    // deleted yet.
+    replaced_chunk_ids_.push_back(it->second.id);
+    bytes_ -= cached_data.size();
+    chunks_.Erase(it);
+  }
+
+  uint32_t id = next_id_++;
+  Chunk chunk(id, data, size);
+  client_->CreateChunkEntry(
+      id, ClientPaintOpChunkTransferCacheEntry(chunk.data.data(), size));
+  chunks_.Put(hash, std::move(chunk));
+  bytes_ += size;
+  bytes_sent_ += size;
+  return id;
+}
+
+void PaintOpChunkCache::FinishRaster() {
+  for (uint32_t id : replaced_chunk_ids_)
+    client_->DeleteChunkEntry(id);
+  replaced_chunk_ids_.clear();
+
+  for (auto it = chunks_.rbegin(); bytes_ > max_bytes_;) {
+    DCHECK(it != chunks_.rend());
+    client_->DeleteChunkEntry(it->second.id);
+    bytes_ -= it->second.data.size();
+    it = chunks_.Erase(it);
+  }
+}
+
+}  // namespace cc
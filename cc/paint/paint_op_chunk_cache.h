@@ -0,0 +1,105 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CC_PAINT_PAINT_OP_CHUNK_CACHE_H_
+#define CC_PAINT_PAINT_OP_CHUNK_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/containers/mru_cache.h"
+#include "base/macros.h"
+#include "cc/paint/paint_export.h"
+#include "cc/paint/paint_op_buffer.h"
+
+namespace cc {
+
+class ClientPaintOpChunkTransferCacheEntry;
+
+// A ChunkedBufferSerializer writes a sequence of records, each starting with
+// a PaintOpChunkRecord. A kInlineOps record is followed by |value| bytes of
+// serialized ops. A kChunk record refers to the ops in the chunk with id
+// |value|, which was sent ahead of the record through the transfer cache.
+// PaintOpChunkReader reads them back.
+struct alignas(PaintOpBuffer::PaintOpAlign) PaintOpChunkRecord {
+  enum Type : uint32_t {
+    kInlineOps,
+    kChunk,
+  };
+
+  uint32_t type;
+  uint32_t value;
+};
+
+// Keeps track of the chunks of serialized ops that the service has in its
+// transfer cache, keyed by their content. Used by ChunkedBufferSerializer, so
+// that chunks which are the same as in a previous raster are sent by id.
+//
+// Chunks referenced by a raster must stay alive until the service has run it,
+// so chunks are only deleted from FinishRaster(), which must be called after
+// the serialized ops have been sent. This class is not thread safe.
+class CC_PAINT_EXPORT PaintOpChunkCache {
+ public:
+  class Client {
+   public:
+    // Sends |entry| to the service's transfer cache as the chunk |id|.
+    virtual void CreateChunkEntry(
+        uint32_t id,
+        const ClientPaintOpChunkTransferCacheEntry& entry) = 0;
+    // Deletes the chunk |id| from the service's transfer cache.
+    virtual void DeleteChunkEntry(uint32_t id) = 0;
+
+   protected:
+    virtual ~Client() {}
+  };
+
+  static const size_t kDefaultMaxBytes;
+
+  PaintOpChunkCache(Client* client, size_t max_bytes);
+  ~PaintOpChunkCache();
+
+  // Returns the id of the chunk with the ops in |data|, which hash to |hash|.
+  // If the service doesn't have such a chunk yet, it is sent first.
+  uint32_t GetOrCreateChunk(uint32_t hash, const uint8_t* data, size_t size);
+
+  // Deletes the chunks that are no longer needed once the current raster has
+  // been sent, keeping at most |max_bytes| of chunks.
+  void FinishRaster();
+
+  size_t bytes() const { return bytes_; }
+  // The number of bytes of chunks sent to the service so far.
+  size_t bytes_sent() const { return bytes_sent_; }
+
+ private:
+  struct Chunk {
+    Chunk(uint32_t id, const uint8_t* data, size_t size);
+    Chunk(Chunk&& other);
+    ~Chunk();
+
+    Chunk& operator=(Chunk&& other);
+
+    uint32_t id;
+    std::vector<uint8_t> data;
+  };
+  using ChunkMRUCache = base::HashingMRUCache<uint32_t, Chunk>;
+
+  Client* const client_;
+  const size_t max_bytes_;
+
+  ChunkMRUCache chunks_;
+  size_t bytes_ = 0u;
+  size_t bytes_sent_ = 0u;
+  uint32_t next_id_ = 1u;
+  // Chunks that were replaced by a different chunk with the same hash, to be
+  // deleted by FinishRaster().
+  std::vector<uint32_t> replaced_chunk_ids_;
+
+  DISALLOW_COPY_AND_ASSIGN(PaintOpChunkCache);
+};
+
+}  // namespace cc
+
+#endif  // CC_PAINT_PAINT_OP_CHUNK_CACHE_H_
@@ -0,0 +1,82 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/paint/paint_op_chunk_transfer_cache_entry.h"
+
+#include <string.h>
+
+#include "cc/paint/paint_op_buffer.h"
+#include "cc/paint/paint_op_reader.h"
+
+namespace cc {
+
+ClientPaintOpChunkTransferCacheEntry::ClientPaintOpChunkTransferCacheEntry(
+    const uint8_t* data,
+    size_t size)
+    : data_(data), size_(size) {}
+ClientPaintOpChunkTransferCacheEntry::~ClientPaintOpChunkTransferCacheEntry() =
+    default;
+
+TransferCacheEntryType ClientPaintOpChunkTransferCacheEntry::Type() const {
+  return TransferCacheEntryType::kPaintOpChunk;
+}
+
+size_t ClientPaintOpChunkTransferCacheEntry::SerializedSize() const {
+  return size_;
+}
+
+bool ClientPaintOpChunkTransferCacheEntry::Serialize(size_t size,
+                                                     uint8_t* data) const {
+  if (size != size_)
+    return false;
+
+  memcpy(data, data_, size);
+  return true;
+}
+
+ServicePaintOpChunkTransferCacheEntry::ServicePaintOpChunkTransferCacheEntry() =
+    default;
+ServicePaintOpChunkTransferCacheEntry::
+    ~ServicePaintOpChunkTransferCacheEntry() = default;
+
+TransferCacheEntryType ServicePaintOpChunkTransferCacheEntry::Type() const {
+  return TransferCacheEntryType::kPaintOpChunk;
+}
+
+size_t ServicePaintOpChunkTransferCacheEntry::Size() const {
+  return size_;
+}
+
+bool ServicePaintOpChunkTransferCacheEntry::Deserialize(GrContext* context,
+                                                        size_t size,
+                                                        uint8_t* data) {
+  if (!size || size % PaintOpBuffer::PaintOpAlign != 0)
+    return false;
+
+  // Validate the op headers once here, so that readers of this chunk can walk
+  // it without checking the bounds of every op again. The ops themselves are
+  // still validated when they are deserialized.
+  size_t offset = 0;
+  while (offset < size) {
+    size_t remaining = size - offset;
+    if (remaining < PaintOpWriter::HeaderBytes())
+      return false;
+    uint8_t type = 0;
+    uint32_t skip = 0;
+    if (!PaintOpReader::ReadAndValidateOpHeader(data + offset, remaining,
+                                                &type, &skip) ||
+        !skip) {
+      return false;
+    }
+    offset += skip;
+  }
+
+  data_.reset(static_cast<char*>(
+      base::AlignedAlloc(size, PaintOpBuffer::PaintOpAlign)));
+  memcpy(data_.get(), data, size);
+  size_ = size;
+  return true;
+}
+
+}  // namespace cc
@@ -0,0 +1,61 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CC_PAINT_PAINT_OP_CHUNK_TRANSFER_CACHE_ENTRY_H_
+#define CC_PAINT_PAINT_OP_CHUNK_TRANSFER_CACHE_ENTRY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+
+#include "base/memory/aligned_memory.h"
+#include "cc/paint/transfer_cache_entry.h"
+
+namespace cc {
+
+// Client/ServicePaintOpChunkTransferCacheEntry implement a transfer cache
+// entry for a chunk of serialized PaintOps, so that ops which don't change
+// between rasters only need to be sent to the service once. See
+// ChunkedBufferSerializer.
+class CC_PAINT_EXPORT ClientPaintOpChunkTransferCacheEntry
+    : public ClientTransferCacheEntry {
+ public:
+  // |data| must outlive this entry.
+  ClientPaintOpChunkTransferCacheEntry(const uint8_t* data, size_t size);
+  ~ClientPaintOpChunkTransferCacheEntry() override;
+
+  // ClientTransferCacheEntry implementation:
+  TransferCacheEntryType Type() const override;
+  size_t SerializedSize() const override;
+  bool Serialize(size_t size, uint8_t* data) const override;
+
+ private:
+  const uint8_t* const data_;
+  const size_t size_;
+};
+
+class CC_PAINT_EXPORT ServicePaintOpChunkTransferCacheEntry
+    : public ServiceTransferCacheEntry {
+ public:
+  ServicePaintOpChunkTransferCacheEntry();
+  ~ServicePaintOpChunkTransferCacheEntry() override;
+
+  // ServiceTransferCacheEntry implementation:
+  TransferCacheEntryType Type() const override;
+  size_t Size() const override;
+  // Fails unless |data| is a sequence of ops with valid headers.
+  bool Deserialize(GrContext* context, size_t size, uint8_t* data) override;
+
+  // The serialized ops, aligned to PaintOpBuffer::PaintOpAlign.
+  const char* data() const { return data_.get(); }
+
+ private:
+  std::unique_ptr<char, base::AlignedFreeDeleter> data_;
+  size_t size_ = 0;
+};
+
+}  // namespace cc
+
+#endif  // CC_PAINT_PAINT_OP_CHUNK_TRANSFER_CACHE_ENTRY_H_
@@ -2,13 +2,18 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <map>
 #include <utility>
 
+#include "base/bind.h"
 #include "base/test/launcher/unit_test_launcher.h"
 #include "base/test/test_suite.h"
 #include "cc/base/lap_timer.h"
 #include "cc/paint/paint_op_buffer.h"
 #include "cc/paint/paint_op_buffer_serializer.h"
+#include "cc/paint/paint_op_chunk_cache.h"
+#include "cc/paint/paint_op_chunk_transfer_cache_entry.h"
+#include "cc/paint/paint_op_reader.h"
 #include "testing/perf/perf_test.h"
 #include "third_party/skia/include/effects/SkBlurMaskFilter.h"
 #include "third_party/skia/include/effects/SkColorMatrixFilter.h"
@@ -25,6 +30,33 @@ static const int kTimeCheckInterval = 1;
 
 static const size_t kMaxSerializedBufferBytes = 100000;
 
+// Creates the service side entry of each chunk right away, as the raster
+// decoder would, so that the chunked rasters can be read back.
+class PerfPaintOpChunkCacheClient : public PaintOpChunkCache::Client {
+ public:
+  void CreateChunkEntry(
+      uint32_t id,
+      const ClientPaintOpChunkTransferCacheEntry& entry) override {
+    std::vector<uint8_t> data(entry.SerializedSize());
+    CHECK(entry.Serialize(data.size(), data.data()));
+    auto service_entry =
+        std::make_unique<ServicePaintOpChunkTransferCacheEntry>();
+    CHECK(service_entry->Deserialize(nullptr, data.size(), data.data()));
+    entries_[id] = std::move(service_entry);
+  }
+
+  void DeleteChunkEntry(uint32_t id) override { entries_.erase(id); }
+
+  const ServicePaintOpChunkTransferCacheEntry* GetChunk(uint32_t id) {
+    auto it = entries_.find(id);
+    return it == entries_.end() ? nullptr : it->second.get();
+  }
+
+ private:
+  std::map<uint32_t, std::unique_ptr<ServicePaintOpChunkTransferCacheEntry>>
+      entries_;
+};
+
 class PaintOpPerfTest : public testing::Test {
  public:
   PaintOpPerfTest()
@@ -59,6 +91,9 @@ class PaintOpPerfTest : public testing::Test {
     perf_test::PrintResult(name.c_str(), "", "  serialize",
                            buffer.size() * timer_.LapsPerSecond(), "ops/s",
                            true);
+    // The bytes sent to the service for each raster of |buffer|.
+    perf_test::PrintResult(name.c_str(), "", "serialized_size", bytes_written,
+                           "bytes", true);
 
     size_t bytes_read = 0;
     timer_.Reset();
@@ -89,7 +124,94 @@ class PaintOpPerfTest : public testing::Test {
                            true);
   }
 
+  // Measures the same as RunTest() for |buffer|, and then again with the ops
+  // sent in chunks through a PaintOpChunkCache. The bytes sent per frame are
+  // reported for rastering |buffer| for the first time, then |changed_buffer|,
+  // and then |changed_buffer| again unchanged. The throughput is measured for
+  // the unchanged frames, where all the chunks are already in the cache.
+  void RunChunkedTest(const std::string& name,
+                      const PaintOpBuffer& buffer,
+                      const PaintOpBuffer& changed_buffer) {
+    RunTest(name, buffer);
+
+    PerfPaintOpChunkCacheClient client;
+    PaintOpChunkCache chunk_cache(&client, PaintOpChunkCache::kDefaultMaxBytes);
+    PaintOpBufferSerializer::Preamble preamble;
+
+    size_t cold_bytes = SerializeChunked(buffer, &chunk_cache);
+    size_t changed_bytes = SerializeChunked(changed_buffer, &chunk_cache);
+    size_t warm_bytes = SerializeChunked(changed_buffer, &chunk_cache);
+
+    perf_test::PrintResult(name.c_str(), "", "chunked_cold_size", cold_bytes,
+                           "bytes", true);
+    perf_test::PrintResult(name.c_str(), "", "chunked_changed_size",
+                           changed_bytes, "bytes", true);
+    perf_test::PrintResult(name.c_str(), "", "chunked_warm_size", warm_bytes,
+                           "bytes", true);
+
+    size_t bytes_written = 0u;
+    timer_.Reset();
+    do {
+      ChunkedBufferSerializer serializer(serialized_data_.get(),
+                                         kMaxSerializedBufferBytes, nullptr,
+                                         &chunk_cache);
+      serializer.Serialize(&changed_buffer, nullptr, preamble);
+      chunk_cache.FinishRaster();
+      bytes_written = serializer.written();
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+    CHECK_GT(bytes_written, 0u);
+
+    perf_test::PrintResult(name.c_str(), "", "  chunked_serialize",
+                           changed_buffer.size() * timer_.LapsPerSecond(),
+                           "ops/s", true);
+
+    PaintOp::DeserializeOptions deserialize_options;
+    size_t bytes_read = 0u;
+    timer_.Reset();
+    do {
+      PaintOpChunkReader reader(
+          serialized_data_.get(), bytes_written,
+          base::Bind(&PerfPaintOpChunkCacheClient::GetChunk,
+                     base::Unretained(&client)));
+      const volatile void* ops = nullptr;
+      size_t ops_size = 0u;
+      while (reader.Next(&ops, &ops_size)) {
+        const volatile char* to_read = static_cast<const volatile char*>(ops);
+        while (ops_size) {
+          PaintOp* deserialized_op = PaintOp::Deserialize(
+              to_read, ops_size, deserialized_data_.get(),
+              sizeof(LargestPaintOp), &bytes_read, deserialize_options);
+          deserialized_op->DestroyThis();
+
+          DCHECK_GE(ops_size, bytes_read);
+          ops_size -= bytes_read;
+          to_read += bytes_read;
+        }
+      }
+      CHECK(reader.valid());
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+
+    perf_test::PrintResult(name.c_str(), "", "chunked_deserialize",
+                           changed_buffer.size() * timer_.LapsPerSecond(),
+                           "ops/s", true);
+  }
+
  protected:
+  // Returns the bytes written inline plus the bytes of new chunks.
+  size_t SerializeChunked(const PaintOpBuffer& buffer,
+                          PaintOpChunkCache* chunk_cache) {
+    size_t bytes_sent = chunk_cache->bytes_sent();
+    ChunkedBufferSerializer serializer(serialized_data_.get(),
+                                       kMaxSerializedBufferBytes, nullptr,
+                                       chunk_cache);
+    serializer.Serialize(&buffer, nullptr, PaintOpBufferSerializer::Preamble());
+    CHECK(serializer.valid());
+    chunk_cache->FinishRaster();
+    return serializer.written() + chunk_cache->bytes_sent() - bytes_sent;
+  }
+
   LapTimer timer_;
   std::unique_ptr<char, base::AlignedFreeDeleter> serialized_data_;
   std::unique_ptr<char, base::AlignedFreeDeleter> deserialized_data_;
@@ -112,6 +234,21 @@ TEST_F(PaintOpPerfTest, DrawOps) {
   RunTest("draw", buffer);
 }
 
+// A large buffer that is rastered again with a single op changed.
+TEST_F(PaintOpPerfTest, ChunkedDrawOps) {
+  PaintOpBuffer buffer;
+  PaintOpBuffer changed_buffer;
+  PaintFlags flags;
+  for (size_t i = 0; i < 500; ++i) {
+    SkRect rect = SkRect::MakeXYWH(i, i, 10, 10);
+    buffer.push<DrawRectOp>(rect, flags);
+    if (i == 250)
+      rect.offset(1, 1);
+    changed_buffer.push<DrawRectOp>(rect, flags);
+  }
+  RunChunkedTest("chunked_draw", buffer, changed_buffer);
+}
+
 // Ops with worst case flags.
 TEST_F(PaintOpPerfTest, ManyFlagsOps) {
   PaintOpBuffer buffer;
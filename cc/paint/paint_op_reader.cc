@@ -6,9 +6,12 @@
 
 #include <stddef.h>
 #include <algorithm>
+#include <utility>
 
 #include "cc/paint/paint_flags.h"
 #include "cc/paint/paint_op_buffer.h"
+#include "cc/paint/paint_op_chunk_cache.h"
+#include "cc/paint/paint_op_chunk_transfer_cache_entry.h"
 #include "cc/paint/paint_shader.h"
 #include "third_party/skia/include/core/SkFlattenableSerialization.h"
 #include "third_party/skia/include/core/SkPath.h"
@@ -90,6 +93,28 @@ bool PaintOpReader::ReadAndValidateOpHeader(const volatile void* input,
   return true;
 }
 
+// static
+bool PaintOpReader::ReadAndValidateChunkRecord(const volatile void* input,
+                                               size_t input_size,
+                                               uint32_t* type,
+                                               uint32_t* value) {
+  if (input_size < sizeof(PaintOpChunkRecord))
+    return false;
+  const volatile PaintOpChunkRecord* record =
+      static_cast<const volatile PaintOpChunkRecord*>(input);
+  *type = record->type;
+  *value = record->value;
+
+  switch (*type) {
+    case PaintOpChunkRecord::kInlineOps:
+      return *value && *value <= input_size - sizeof(PaintOpChunkRecord) &&
+             *value % PaintOpBuffer::PaintOpAlign == 0;
+    case PaintOpChunkRecord::kChunk:
+      return true;
+  }
+  return false;
+}
+
 template <typename T>
 void PaintOpReader::ReadSimple(T* val) {
   static_assert(base::is_trivially_copyable<T>::value,
@@ -526,4 +551,47 @@ const volatile void* PaintOpReader::ExtractReadableMemory(size_t bytes) {
   return extracted_memory;
 }
 
+PaintOpChunkReader::PaintOpChunkReader(const volatile void* memory,
+                                       size_t size,
+                                       GetChunkCallback get_chunk)
+    : memory_(static_cast<const volatile char*>(memory)),
+      remaining_bytes_(size),
+      get_chunk_(std::move(get_chunk)) {}
+
+PaintOpChunkReader::~PaintOpChunkReader() = default;
+
+bool PaintOpChunkReader::Next(const volatile void** ops, size_t* ops_size) {
+  if (!valid_ || !remaining_bytes_)
+    return false;
+
+  uint32_t type = 0u;
+  uint32_t value = 0u;
+  if (!PaintOpReader::ReadAndValidateChunkRecord(memory_, remaining_bytes_,
+                                                 &type, &value)) {
+    return SetInvalid();
+  }
+  memory_ += sizeof(PaintOpChunkRecord);
+  remaining_bytes_ -= sizeof(PaintOpChunkRecord);
+
+  if (type == PaintOpChunkRecord::kInlineOps) {
+    *ops = memory_;
+    *ops_size = value;
+    memory_ += value;
+    remaining_bytes_ -= value;
+    return true;
+  }
+
+  const ServicePaintOpChunkTransferCacheEntry* chunk = get_chunk_.Run(value);
+  if (!chunk)
+    return SetInvalid();
+  *ops = chunk->data();
+  *ops_size = chunk->Size();
+  return true;
+}
+
+bool PaintOpChunkReader::SetInvalid() {
+  valid_ = false;
+  return false;
+}
+
 }  // namespace cc
@@ -7,12 +7,15 @@
 
 #include <vector>
 
+#include "base/callback.h"
+#include "base/macros.h"
 #include "cc/paint/paint_export.h"
 #include "cc/paint/paint_op_writer.h"
 
 namespace cc {
 
 class PaintShader;
+class ServicePaintOpChunkTransferCacheEntry;
 
 // PaintOpReader takes garbage |memory| and clobbers it with successive
 // read functions.
@@ -31,6 +34,13 @@ class CC_PAINT_EXPORT PaintOpReader {
                                       size_t input_size,
                                       uint8_t* type,
                                       uint32_t* skip);
+  // Reads the PaintOpChunkRecord at the start of |input|. Fails if the record
+  // is truncated or of an unknown type, or if it is followed by inline ops
+  // that are misaligned or don't fit in |input_size|.
+  static bool ReadAndValidateChunkRecord(const volatile void* input,
+                                         size_t input_size,
+                                         uint32_t* type,
+                                         uint32_t* value);
 
   bool valid() const { return valid_; }
 
@@ -103,6 +113,38 @@ class CC_PAINT_EXPORT PaintOpReader {
   bool valid_ = true;
 };
 
+// Reads the records written by a ChunkedBufferSerializer, and returns the
+// serialized ops they contain, one contiguous range at a time. Chunks are
+// looked up with |get_chunk|, which returns null for unknown ids. The ops in
+// each range can then be read with PaintOp::Deserialize.
+class CC_PAINT_EXPORT PaintOpChunkReader {
+ public:
+  using GetChunkCallback =
+      base::Callback<const ServicePaintOpChunkTransferCacheEntry*(uint32_t)>;
+
+  PaintOpChunkReader(const volatile void* memory,
+                     size_t size,
+                     GetChunkCallback get_chunk);
+  ~PaintOpChunkReader();
+
+  // Sets |ops| and |ops_size| to the next range of serialized ops. Returns
+  // false once all records have been read, or if a record is invalid, in which
+  // case valid() returns false.
+  bool Next(const volatile void** ops, size_t* ops_size);
+
+  bool valid() const { return valid_; }
+
+ private:
+  bool SetInvalid();
+
+  const volatile char* memory_;
+  size_t remaining_bytes_;
+  GetChunkCallback get_chunk_;
+  bool valid_ = true;
+
+  DISALLOW_COPY_AND_ASSIGN(PaintOpChunkReader);
+};
+
 }  // namespace cc
 
 #endif  // CC_PAINT_PAINT_OP_READER_H_
@@ -8,6 +8,7 @@
 
 #include "base/logging.h"
 #include "cc/paint/image_transfer_cache_entry.h"
+#include "cc/paint/paint_op_chunk_transfer_cache_entry.h"
 #include "cc/paint/raw_memory_transfer_cache_entry.h"
 
 namespace cc {
@@ -19,6 +20,8 @@ std::unique_ptr<ServiceTransferCacheEntry> ServiceTransferCacheEntry::Create(
       return std::make_unique<ServiceRawMemoryTransferCacheEntry>();
     case TransferCacheEntryType::kImage:
       return std::make_unique<ServiceImageTransferCacheEntry>();
+    case TransferCacheEntryType::kPaintOpChunk:
+      return std::make_unique<ServicePaintOpChunkTransferCacheEntry>();
   }
 
   NOTREACHED();
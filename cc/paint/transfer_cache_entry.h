@@ -22,8 +22,9 @@ namespace cc {
 enum class TransferCacheEntryType {
   kRawMemory,
   kImage,
+  kPaintOpChunk,
   // Add new entries above this line, make sure to update kLast.
-  kLast = kImage,
+  kLast = kPaintOpChunk,
 };
 
 // An interface used on the client to serialize a transfer cache entry
@@ -14,6 +14,7 @@
 #include "base/strings/stringprintf.h"
 #include "base/trace_event/trace_event.h"
 #include "base/trace_event/trace_event_argument.h"
+#include "cc/raster/compressed_tile_cache.h"
 #include "cc/raster/raster_source.h"
 #include "cc/resources/layer_tree_resource_provider.h"
 #include "cc/resources/resource.h"
@@ -25,10 +26,12 @@ namespace {
 class BitmapRasterBufferImpl : public RasterBuffer {
  public:
   BitmapRasterBufferImpl(LayerTreeResourceProvider* resource_provider,
+                         CompressedTileCache* compressed_tile_cache,
                          const Resource* resource,
                          uint64_t resource_content_id,
                          uint64_t previous_content_id)
       : lock_(resource_provider, resource->id()),
+        compressed_tile_cache_(compressed_tile_cache),
         resource_(resource),
         resource_has_previous_content_(
             resource_content_id && resource_content_id == previous_content_id) {
@@ -43,6 +46,14 @@ class BitmapRasterBufferImpl : public RasterBuffer {
       const gfx::AxisTransform2d& transform,
       const RasterSource::PlaybackSettings& playback_settings) override {
     TRACE_EVENT0("cc", "BitmapRasterBuffer::Playback");
+    // Content that was evicted while compressed is restored without a raster.
+    if (compressed_tile_cache_ &&
+        compressed_tile_cache_->Take(new_content_id, resource_->size(),
+                                     lock_.color_space_for_raster(),
+                                     lock_.sk_bitmap().getPixels())) {
+      return;
+    }
+
     gfx::Rect playback_rect = raster_full_rect;
     if (resource_has_previous_content_) {
       playback_rect.Intersect(raster_dirty_rect);
@@ -59,6 +70,7 @@ class BitmapRasterBufferImpl : public RasterBuffer {
 
  private:
   ResourceProvider::ScopedWriteLockSoftware lock_;
+  CompressedTileCache* compressed_tile_cache_;
   const Resource* resource_;
   bool resource_has_previous_content_;
 
@@ -69,14 +81,21 @@ class BitmapRasterBufferImpl : public RasterBuffer {
 
 // static
 std::unique_ptr<RasterBufferProvider> BitmapRasterBufferProvider::Create(
-    LayerTreeResourceProvider* resource_provider) {
-  return base::WrapUnique<RasterBufferProvider>(
-      new BitmapRasterBufferProvider(resource_provider));
+    LayerTreeResourceProvider* resource_provider,
+    size_t compressed_tile_cache_bytes) {
+  return base::WrapUnique<RasterBufferProvider>(new BitmapRasterBufferProvider(
+      resource_provider, compressed_tile_cache_bytes));
 }
 
 BitmapRasterBufferProvider::BitmapRasterBufferProvider(
-    LayerTreeResourceProvider* resource_provider)
-    : resource_provider_(resource_provider) {}
+    LayerTreeResourceProvider* resource_provider,
+    size_t compressed_tile_cache_bytes)
+    : resource_provider_(resource_provider) {
+  if (compressed_tile_cache_bytes) {
+    compressed_tile_cache_ =
+        std::make_unique<CompressedTileCache>(compressed_tile_cache_bytes);
+  }
+}
 
 BitmapRasterBufferProvider::~BitmapRasterBufferProvider() = default;
 
@@ -86,7 +105,8 @@ BitmapRasterBufferProvider::AcquireBufferForRaster(
     uint64_t resource_content_id,
     uint64_t previous_content_id) {
   return std::unique_ptr<RasterBuffer>(new BitmapRasterBufferImpl(
-      resource_provider_, resource, resource_content_id, previous_content_id));
+      resource_provider_, compressed_tile_cache_.get(), resource,
+      resource_content_id, previous_content_id));
 }
 
 void BitmapRasterBufferProvider::OrderingBarrier() {
@@ -123,6 +143,41 @@ uint64_t BitmapRasterBufferProvider::SetReadyToDrawCallback(
   return 0;
 }
 
-void BitmapRasterBufferProvider::Shutdown() {}
+void BitmapRasterBufferProvider::Shutdown() {
+  if (compressed_tile_cache_)
+    compressed_tile_cache_->Clear();
+}
+
+void BitmapRasterBufferProvider::RetainEvictedContent(
+    const Resource* resource,
+    uint64_t content_id) {
+  // Resources that the display compositor is still reading can't be locked.
+  // They were visible recently, so they are likely to be rastered again soon
+  // anyway.
+  if (!compressed_tile_cache_ ||
+      !resource_provider_->CanLockForWrite(resource->id())) {
+    return;
+  }
+  ResourceProvider::ScopedWriteLockSoftware lock(resource_provider_,
+                                                 resource->id());
+  compressed_tile_cache_->Put(content_id, resource->size(),
+                              lock.color_space_for_raster(),
+                              lock.sk_bitmap().getPixels());
+}
+
+void BitmapRasterBufferProvider::DiscardEvictedContent(uint64_t content_id) {
+  if (compressed_tile_cache_)
+    compressed_tile_cache_->Remove(content_id);
+}
+
+size_t BitmapRasterBufferProvider::GetRetainedEvictedContentBytes() const {
+  return compressed_tile_cache_ ? compressed_tile_cache_->bytes() : 0u;
+}
+
+void BitmapRasterBufferProvider::ReduceRetainedEvictedContent(
+    size_t max_bytes) {
+  if (compressed_tile_cache_)
+    compressed_tile_cache_->ReduceTo(max_bytes);
+}
 
 }  // namespace cc
@@ -5,8 +5,11 @@
 #ifndef CC_RASTER_BITMAP_RASTER_BUFFER_PROVIDER_H_
 #define CC_RASTER_BITMAP_RASTER_BUFFER_PROVIDER_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
+#include <memory>
+
 #include "base/macros.h"
 #include "base/values.h"
 #include "cc/raster/raster_buffer_provider.h"
@@ -18,14 +21,18 @@ class ConvertableToTraceFormat;
 }
 
 namespace cc {
+class CompressedTileCache;
 class LayerTreeResourceProvider;
 
 class CC_EXPORT BitmapRasterBufferProvider : public RasterBufferProvider {
  public:
   ~BitmapRasterBufferProvider() override;
 
+  // Evicted tiles are kept compressed in up to |compressed_tile_cache_bytes|,
+  // or not at all if it is 0.
   static std::unique_ptr<RasterBufferProvider> Create(
-      LayerTreeResourceProvider* resource_provider);
+      LayerTreeResourceProvider* resource_provider,
+      size_t compressed_tile_cache_bytes);
 
   // Overridden from RasterBufferProvider:
   std::unique_ptr<RasterBuffer> AcquireBufferForRaster(
@@ -43,16 +50,26 @@ class CC_EXPORT BitmapRasterBufferProvider : public RasterBufferProvider {
       const base::Closure& callback,
       uint64_t pending_callback_id) const override;
   void Shutdown() override;
+  void RetainEvictedContent(const Resource* resource,
+                            uint64_t content_id) override;
+  void DiscardEvictedContent(uint64_t content_id) override;
+  size_t GetRetainedEvictedContentBytes() const override;
+  void ReduceRetainedEvictedContent(size_t max_bytes) override;
+
+  CompressedTileCache* compressed_tile_cache_for_testing() const {
+    return compressed_tile_cache_.get();
+  }
 
  protected:
-  explicit BitmapRasterBufferProvider(
-      LayerTreeResourceProvider* resource_provider);
+  BitmapRasterBufferProvider(LayerTreeResourceProvider* resource_provider,
+                             size_t compressed_tile_cache_bytes);
 
  private:
   std::unique_ptr<base::trace_event::ConvertableToTraceFormat> StateAsValue()
       const;
 
   LayerTreeResourceProvider* resource_provider_;
+  std::unique_ptr<CompressedTileCache> compressed_tile_cache_;
 
   DISALLOW_COPY_AND_ASSIGN(BitmapRasterBufferProvider);
 };
@@ -0,0 +1,284 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/raster/compressed_tile_cache.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/format_macros.h"
+#include "base/logging.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "base/trace_event/memory_dump_manager.h"
+#include "base/trace_event/process_memory_dump.h"
+#include "base/trace_event/trace_event.h"
+
+namespace cc {
+namespace {
+
+// Each op is a one byte header, with the op type in the top two bits and the
+// number of pixels it covers, minus one, in the others.
+enum OpType : uint8_t {
+  // Followed by the pixels.
+  kLiteral = 0,
+  // Followed by one pixel, repeated.
+  kRun = 1,
+  // Copies the pixels one row above.
+  kCopyAbove = 2,
+};
+const int kOpTypeShift = 6;
+const size_t kMaxOpLength = 1 << kOpTypeShift;
+
+void AppendOp(OpType type, size_t length, std::vector<uint8_t>* output) {
+  DCHECK_GT(length, 0u);
+  DCHECK_LE(length, kMaxOpLength);
+  output->push_back(
+      static_cast<uint8_t>((type << kOpTypeShift) | (length - 1)));
+}
+
+void AppendPixels(const uint32_t* pixels,
+                  size_t count,
+                  std::vector<uint8_t>* output) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(pixels);
+  output->insert(output->end(), bytes, bytes + count * sizeof(uint32_t));
+}
+
+void CompressPixels(const uint32_t* pixels,
+                    size_t width,
+                    size_t count,
+                    std::vector<uint8_t>* output) {
+  size_t literal_start = 0;
+  auto flush_literals = [&](size_t end) {
+    while (literal_start < end) {
+      size_t length = std::min(end - literal_start, kMaxOpLength);
+      AppendOp(kLiteral, length, output);
+      AppendPixels(pixels + literal_start, length, output);
+      literal_start += length;
+    }
+  };
+
+  size_t i = 0;
+  while (i < count) {
+    size_t max_length = std::min(count - i, kMaxOpLength);
+    size_t run = 1;
+    while (run < max_length && pixels[i + run] == pixels[i])
+      ++run;
+    size_t above = 0;
+    if (i >= width) {
+      while (above < max_length &&
+             pixels[i + above] == pixels[i + above - width]) {
+        ++above;
+      }
+    }
+
+    if (above && above >= run) {
+      flush_literals(i);
+      AppendOp(kCopyAbove, above, output);
+      i += above;
+      literal_start = i;
+    } else if (run >= 2) {
+      flush_literals(i);
+      AppendOp(kRun, run, output);
+      AppendPixels(pixels + i, 1, output);
+      i += run;
+      literal_start = i;
+    } else {
+      ++i;
+    }
+  }
+  flush_literals(count);
+}
+
+bool DecompressPixels(const uint8_t* data,
+                      size_t size,
+                      size_t width,
+                      size_t count,
+                      uint32_t* pixels) {
+  const uint8_t* end = data + size;
+  size_t i = 0;
+  while (data < end) {
+    uint8_t header = *data++;
+    size_t length = (header & (kMaxOpLength - 1)) + 1;
+    if (length > count - i)
+      return false;
+
+    switch (header >> kOpTypeShift) {
+      case kLiteral:
+        if (static_cast<size_t>(end - data) < length * sizeof(uint32_t))
+          return false;
+        memcpy(pixels + i, data, length * sizeof(uint32_t));
+        data += length * sizeof(uint32_t);
+        break;
+      case kRun: {
+        if (static_cast<size_t>(end - data) < sizeof(uint32_t))
+          return false;
+        uint32_t pixel;
+        memcpy(&pixel, data, sizeof(uint32_t));
+        data += sizeof(uint32_t);
+        std::fill(pixels + i, pixels + i + length, pixel);
+        break;
+      }
+      case kCopyAbove:
+        if (i < width)
+          return false;
+        // The copy may overlap itself if |length| is more than |width|, so
+        // copy a pixel at a time.
+        for (size_t j = i; j < i + length; ++j)
+          pixels[j] = pixels[j - width];
+        break;
+      default:
+        return false;
+    }
+    i += length;
+  }
+  return i == count;
+}
+
+}  // namespace
+
+CompressedTileCache::Entry::Entry(const gfx::Size& size,
+                                  const gfx::ColorSpace& color_space,
+                                  std::vector<uint8_t> data)
+    : size(size), color_space(color_space), data(std::move(data)) {}
+
+CompressedTileCache::Entry::Entry(Entry&& other) = default;
+
+CompressedTileCache::Entry::~Entry() = default;
+
+CompressedTileCache::Entry& CompressedTileCache::Entry::operator=(
+    Entry&& other) = default;
+
+CompressedTileCache::CompressedTileCache(size_t max_bytes)
+    : max_bytes_(max_bytes), entries_(EntryMRUCache::NO_AUTO_EVICT) {
+  // In certain cases, ThreadTaskRunnerHandle isn't set (Android Webview).
+  // Don't register a dump provider in these cases.
+  if (base::ThreadTaskRunnerHandle::IsSet()) {
+    base::trace_event::MemoryDumpManager::GetInstance()->RegisterDumpProvider(
+        this, "cc::CompressedTileCache", base::ThreadTaskRunnerHandle::Get());
+  }
+}
+
+CompressedTileCache::~CompressedTileCache() {
+  base::trace_event::MemoryDumpManager::GetInstance()->UnregisterDumpProvider(
+      this);
+}
+
+void CompressedTileCache::Put(uint64_t content_id,
+                              const gfx::Size& size,
+                              const gfx::ColorSpace& color_space,
+                              const void* pixels) {
+  TRACE_EVENT0("cc", "CompressedTileCache::Put");
+  DCHECK(!size.IsEmpty());
+  size_t count = size.GetArea();
+  size_t uncompressed_bytes = count * sizeof(uint32_t);
+
+  std::vector<uint8_t> data;
+  data.reserve(uncompressed_bytes / 2);
+  CompressPixels(static_cast<const uint32_t*>(pixels), size.width(), count,
+                 &data);
+
+  base::AutoLock lock(lock_);
+  auto it = entries_.Peek(content_id);
+  if (it != entries_.end())
+    RemoveLocked(it);
+  if (data.size() > uncompressed_bytes / 2 || data.size() > max_bytes_)
+    return;
+
+  bytes_ += data.size();
+  entries_.Put(content_id, Entry(size, color_space, std::move(data)));
+  ReduceToLocked(max_bytes_);
+}
+
+bool CompressedTileCache::Take(uint64_t content_id,
+                               const gfx::Size& size,
+                               const gfx::ColorSpace& color_space,
+                               void* pixels) {
+  std::vector<uint8_t> data;
+  {
+    base::AutoLock lock(lock_);
+    auto it = entries_.Peek(content_id);
+    if (it == entries_.end())
+      return false;
+    // Content rastered for another size or color space can't be restored.
+    bool matches =
+        it->second.size == size && it->second.color_space == color_space;
+    bytes_ -= it->second.data.size();
+    if (matches)
+      data = std::move(it->second.data);
+    entries_.Erase(it);
+    if (!matches)
+      return false;
+  }
+
+  TRACE_EVENT0("cc", "CompressedTileCache::Take");
+  bool success =
+      DecompressPixels(data.data(), data.size(), size.width(), size.GetArea(),
+                       static_cast<uint32_t*>(pixels));
+  DCHECK(success);
+  return success;
+}
+
+void CompressedTileCache::Remove(uint64_t content_id) {
+  base::AutoLock lock(lock_);
+  auto it = entries_.Peek(content_id);
+  if (it != entries_.end())
+    RemoveLocked(it);
+}
+
+void CompressedTileCache::ReduceTo(size_t max_bytes) {
+  base::AutoLock lock(lock_);
+  ReduceToLocked(max_bytes);
+}
+
+void CompressedTileCache::Clear() {
+  base::AutoLock lock(lock_);
+  entries_.Clear();
+  bytes_ = 0u;
+}
+
+size_t CompressedTileCache::bytes() const {
+  base::AutoLock lock(lock_);
+  return bytes_;
+}
+
+size_t CompressedTileCache::count() const {
+  base::AutoLock lock(lock_);
+  return entries_.size();
+}
+
+bool CompressedTileCache::OnMemoryDump(
+    const base::trace_event::MemoryDumpArgs& args,
+    base::trace_event::ProcessMemoryDump* pmd) {
+  using base::trace_event::MemoryAllocatorDump;
+  std::string dump_name =
+      base::StringPrintf("cc/tile_memory/compressed_tile_cache_0x%" PRIXPTR,
+                         reinterpret_cast<uintptr_t>(this));
+  MemoryAllocatorDump* dump = pmd->CreateAllocatorDump(dump_name);
+  base::AutoLock lock(lock_);
+  dump->AddScalar(MemoryAllocatorDump::kNameSize,
+                  MemoryAllocatorDump::kUnitsBytes, bytes_);
+  dump->AddScalar(MemoryAllocatorDump::kNameObjectCount,
+                  MemoryAllocatorDump::kUnitsObjects, entries_.size());
+  return true;
+}
+
+void CompressedTileCache::RemoveLocked(EntryMRUCache::iterator it) {
+  lock_.AssertAcquired();
+  bytes_ -= it->second.data.size();
+  entries_.Erase(it);
+}
+
+void CompressedTileCache::ReduceToLocked(size_t max_bytes) {
+  lock_.AssertAcquired();
+  for (auto lru = entries_.rbegin(); bytes_ > max_bytes;) {
+    bytes_ -= lru->second.data.size();
+    lru = entries_.Erase(lru);
+  }
+}
+
+}  // namespace cc
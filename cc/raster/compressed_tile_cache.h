@@ -0,0 +1,107 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CC_RASTER_COMPRESSED_TILE_CACHE_H_
+#define CC_RASTER_COMPRESSED_TILE_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/containers/mru_cache.h"
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "base/trace_event/memory_dump_provider.h"
+#include "cc/cc_export.h"
+#include "ui/gfx/color_space.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace cc {
+
+// Keeps the contents of software tiles that were evicted from the tile memory
+// budget, losslessly compressed, so that they can be restored with a
+// decompression instead of a raster when they are needed again. Contents are
+// keyed by their content id, which is the id of the tile, and are only
+// restored into a tile of the same size and raster color space. The least
+// recently used ones are dropped to stay within |max_bytes|, and the owner
+// accounts bytes() against the tile memory budget.
+//
+// The codec is a byte-aligned LZ variant that only matches the previous pixel
+// (runs) or the pixel above (copies), which is what most of the web's solid
+// backgrounds and text boxes are made of, and which is cheap enough to run on
+// the compositor thread for the few tiles that TileManager retains per frame.
+// Contents that don't compress to at least half their size are not kept.
+//
+// This class is thread safe: contents are added on the compositor thread and
+// taken on raster worker threads.
+class CC_EXPORT CompressedTileCache
+    : public base::trace_event::MemoryDumpProvider {
+ public:
+  explicit CompressedTileCache(size_t max_bytes);
+  ~CompressedTileCache() override;
+
+  // Compresses the N32 pixels of a |size| tile, rastered in |color_space| and
+  // in |pixels| with no row padding, as the content |content_id|.
+  void Put(uint64_t content_id,
+           const gfx::Size& size,
+           const gfx::ColorSpace& color_space,
+           const void* pixels);
+
+  // Decompresses the content |content_id| into |pixels| and removes it from
+  // the cache. Returns false if the content isn't cached for a |size| tile
+  // rastered in |color_space|.
+  bool Take(uint64_t content_id,
+            const gfx::Size& size,
+            const gfx::ColorSpace& color_space,
+            void* pixels);
+
+  // Drops the content |content_id|, once its tile is gone.
+  void Remove(uint64_t content_id);
+
+  // Drops the least recently used contents until at most |max_bytes| are
+  // kept.
+  void ReduceTo(size_t max_bytes);
+
+  void Clear();
+
+  size_t bytes() const;
+  size_t count() const;
+
+  // base::trace_event::MemoryDumpProvider implementation.
+  bool OnMemoryDump(const base::trace_event::MemoryDumpArgs& args,
+                    base::trace_event::ProcessMemoryDump* pmd) override;
+
+ private:
+  struct Entry {
+    Entry(const gfx::Size& size,
+          const gfx::ColorSpace& color_space,
+          std::vector<uint8_t> data);
+    Entry(Entry&& other);
+    ~Entry();
+
+    Entry& operator=(Entry&& other);
+
+    gfx::Size size;
+    gfx::ColorSpace color_space;
+    std::vector<uint8_t> data;
+  };
+  using EntryMRUCache = base::HashingMRUCache<uint64_t, Entry>;
+
+  void RemoveLocked(EntryMRUCache::iterator it);
+  void ReduceToLocked(size_t max_bytes);
+
+  const size_t max_bytes_;
+
+  mutable base::Lock lock_;
+  // The following members are protected by |lock_|.
+  EntryMRUCache entries_;
+  size_t bytes_ = 0u;
+
+  DISALLOW_COPY_AND_ASSIGN(CompressedTileCache);
+};
+
+}  // namespace cc
+
+#endif  // CC_RASTER_COMPRESSED_TILE_CACHE_H_
@@ -0,0 +1,176 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/raster/compressed_tile_cache.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace cc {
+namespace {
+
+const gfx::Size kTileSize(64, 64);
+const size_t kTileBytes = 64 * 64 * sizeof(uint32_t);
+
+// A tile with a solid background, a box with a border, and some noise, which
+// exercises all of the codec's ops.
+std::vector<uint32_t> CreateTilePixels(uint32_t background) {
+  std::vector<uint32_t> pixels(kTileSize.GetArea(), background);
+  for (int y = 8; y < 40; ++y) {
+    for (int x = 8; x < 56; ++x) {
+      bool border = y == 8 || y == 39 || x == 8 || x == 55;
+      pixels[y * kTileSize.width() + x] = border ? 0xff000000 : 0xffffffff;
+    }
+  }
+  uint32_t seed = 1;
+  for (int i = 48 * kTileSize.width(); i < 52 * kTileSize.width(); ++i) {
+    seed = seed * 1103515245 + 12345;
+    pixels[i] = seed;
+  }
+  return pixels;
+}
+
+gfx::ColorSpace SRGB() {
+  return gfx::ColorSpace::CreateSRGB();
+}
+
+std::vector<uint32_t> CreateNoisePixels() {
+  std::vector<uint32_t> pixels(kTileSize.GetArea());
+  uint32_t seed = 7;
+  for (uint32_t& pixel : pixels) {
+    seed = seed * 1103515245 + 12345;
+    pixel = seed;
+  }
+  return pixels;
+}
+
+TEST(CompressedTileCacheTest, PutAndTake) {
+  CompressedTileCache cache(1024 * 1024);
+  std::vector<uint32_t> pixels = CreateTilePixels(0xff336699);
+  cache.Put(1u, kTileSize, SRGB(), pixels.data());
+  EXPECT_EQ(1u, cache.count());
+  EXPECT_LT(cache.bytes(), kTileBytes / 2);
+
+  std::vector<uint32_t> restored(kTileSize.GetArea());
+  EXPECT_TRUE(cache.Take(1u, kTileSize, SRGB(), restored.data()));
+  EXPECT_EQ(pixels, restored);
+
+  // Taking the content removes it.
+  EXPECT_EQ(0u, cache.count());
+  EXPECT_EQ(0u, cache.bytes());
+  EXPECT_FALSE(cache.Take(1u, kTileSize, SRGB(), restored.data()));
+}
+
+TEST(CompressedTileCacheTest, SolidTileIsSmall) {
+  CompressedTileCache cache(1024 * 1024);
+  std::vector<uint32_t> pixels(kTileSize.GetArea(), 0xff00ff00);
+  cache.Put(1u, kTileSize, SRGB(), pixels.data());
+  EXPECT_LT(cache.bytes(), kTileBytes / 100);
+
+  std::vector<uint32_t> restored(kTileSize.GetArea());
+  EXPECT_TRUE(cache.Take(1u, kTileSize, SRGB(), restored.data()));
+  EXPECT_EQ(pixels, restored);
+}
+
+TEST(CompressedTileCacheTest, IncompressibleContentIsNotKept) {
+  CompressedTileCache cache(1024 * 1024);
+  std::vector<uint32_t> pixels = CreateNoisePixels();
+  cache.Put(1u, kTileSize, SRGB(), pixels.data());
+  EXPECT_EQ(0u, cache.count());
+  EXPECT_EQ(0u, cache.bytes());
+}
+
+TEST(CompressedTileCacheTest, SizeMismatch) {
+  CompressedTileCache cache(1024 * 1024);
+  std::vector<uint32_t> pixels = CreateTilePixels(0xff336699);
+  cache.Put(1u, kTileSize, SRGB(), pixels.data());
+
+  // The tile no longer matches, so the content is dropped.
+  std::vector<uint32_t> restored(kTileSize.GetArea());
+  EXPECT_FALSE(cache.Take(1u, gfx::Size(32, 128), SRGB(), restored.data()));
+  EXPECT_EQ(0u, cache.count());
+  EXPECT_EQ(0u, cache.bytes());
+}
+
+TEST(CompressedTileCacheTest, ColorSpaceMismatch) {
+  CompressedTileCache cache(1024 * 1024);
+  std::vector<uint32_t> pixels = CreateTilePixels(0xff336699);
+  cache.Put(1u, kTileSize, SRGB(), pixels.data());
+
+  // The tile is now rastered in another color space, so the content is
+  // dropped.
+  std::vector<uint32_t> restored(kTileSize.GetArea());
+  EXPECT_FALSE(cache.Take(1u, kTileSize, gfx::ColorSpace::CreateDisplayP3D65(),
+                          restored.data()));
+  EXPECT_EQ(0u, cache.count());
+  EXPECT_EQ(0u, cache.bytes());
+}
+
+TEST(CompressedTileCacheTest, PutReplacesContent) {
+  CompressedTileCache cache(1024 * 1024);
+  std::vector<uint32_t> first = CreateTilePixels(0xff336699);
+  std::vector<uint32_t> second = CreateTilePixels(0xff996633);
+  cache.Put(1u, kTileSize, SRGB(), first.data());
+  size_t bytes = cache.bytes();
+  cache.Put(1u, kTileSize, SRGB(), second.data());
+  EXPECT_EQ(1u, cache.count());
+  EXPECT_EQ(bytes, cache.bytes());
+
+  std::vector<uint32_t> restored(kTileSize.GetArea());
+  EXPECT_TRUE(cache.Take(1u, kTileSize, SRGB(), restored.data()));
+  EXPECT_EQ(second, restored);
+}
+
+TEST(CompressedTileCacheTest, EvictsLeastRecentlyUsed) {
+  std::vector<uint32_t> pixels = CreateTilePixels(0xff336699);
+  size_t tile_bytes;
+  {
+    CompressedTileCache cache(1024 * 1024);
+    cache.Put(1u, kTileSize, SRGB(), pixels.data());
+    tile_bytes = cache.bytes();
+  }
+
+  CompressedTileCache cache(3 * tile_bytes);
+  for (uint64_t id = 1u; id <= 4u; ++id)
+    cache.Put(id, kTileSize, SRGB(), pixels.data());
+  EXPECT_EQ(3u, cache.count());
+  EXPECT_EQ(3 * tile_bytes, cache.bytes());
+
+  std::vector<uint32_t> restored(kTileSize.GetArea());
+  EXPECT_FALSE(cache.Take(1u, kTileSize, SRGB(), restored.data()));
+  EXPECT_TRUE(cache.Take(4u, kTileSize, SRGB(), restored.data()));
+  EXPECT_EQ(pixels, restored);
+
+  cache.Remove(2u);
+  EXPECT_EQ(1u, cache.count());
+  cache.Clear();
+  EXPECT_EQ(0u, cache.count());
+  EXPECT_EQ(0u, cache.bytes());
+}
+
+TEST(CompressedTileCacheTest, ReduceTo) {
+  std::vector<uint32_t> pixels = CreateTilePixels(0xff336699);
+  CompressedTileCache cache(1024 * 1024);
+  for (uint64_t id = 1u; id <= 4u; ++id)
+    cache.Put(id, kTileSize, SRGB(), pixels.data());
+  size_t tile_bytes = cache.bytes() / 4;
+
+  // Reducing to less than two tiles keeps only the most recently used one.
+  cache.ReduceTo(2 * tile_bytes - 1);
+  EXPECT_EQ(1u, cache.count());
+  EXPECT_EQ(tile_bytes, cache.bytes());
+  std::vector<uint32_t> restored(kTileSize.GetArea());
+  EXPECT_TRUE(cache.Take(4u, kTileSize, SRGB(), restored.data()));
+
+  cache.Put(1u, kTileSize, SRGB(), pixels.data());
+  cache.ReduceTo(0u);
+  EXPECT_EQ(0u, cache.count());
+  EXPECT_EQ(0u, cache.bytes());
+}
+
+}  // namespace
+}  // namespace cc
@@ -6,8 +6,17 @@
 
 #include <stddef.h>
 
+#include <algorithm>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/optional.h"
+#include "base/synchronization/lock.h"
 #include "base/trace_event/trace_event.h"
+#include "cc/paint/image_provider.h"
 #include "cc/raster/raster_source.h"
+#include "cc/raster/task_category.h"
+#include "cc/raster/task_graph_runner.h"
 #include "cc/raster/texture_compressor.h"
 #include "components/viz/common/resources/platform_color.h"
 #include "components/viz/common/resources/resource_format_utils.h"
@@ -22,6 +31,17 @@ RasterBufferProvider::RasterBufferProvider() = default;
 
 RasterBufferProvider::~RasterBufferProvider() = default;
 
+void RasterBufferProvider::RetainEvictedContent(const Resource* resource,
+                                                uint64_t content_id) {}
+
+void RasterBufferProvider::DiscardEvictedContent(uint64_t content_id) {}
+
+size_t RasterBufferProvider::GetRetainedEvictedContentBytes() const {
+  return 0u;
+}
+
+void RasterBufferProvider::ReduceRetainedEvictedContent(size_t max_bytes) {}
+
 namespace {
 
 bool IsSupportedPlaybackToMemoryFormat(viz::ResourceFormat format) {
@@ -44,6 +64,211 @@ bool IsSupportedPlaybackToMemoryFormat(viz::ResourceFormat format) {
   return false;
 }
 
+// Bands shorter than this are not worth the overhead of a separate canvas and
+// of replaying the ops that straddle band boundaries more than once.
+const int kMinParallelRasterBandHeight = 64;
+
+// Splits the rect to play back into horizontal bands for concurrent raster.
+// Returns an empty vector if the playback should not be split.
+std::vector<gfx::Rect> ComputeParallelRasterBands(
+    const gfx::Rect& canvas_bitmap_rect,
+    const gfx::Rect& canvas_playback_rect,
+    const RasterSource::PlaybackSettings& playback_settings) {
+  if (!playback_settings.parallel_raster_task_graph_runner)
+    return std::vector<gfx::Rect>();
+
+  gfx::Rect playback_rect = canvas_bitmap_rect;
+  if (!canvas_playback_rect.IsEmpty())
+    playback_rect.Intersect(canvas_playback_rect);
+
+  int band_count =
+      std::min(playback_settings.max_parallel_raster_bands,
+               playback_rect.height() / kMinParallelRasterBandHeight);
+  if (band_count <= 1)
+    return std::vector<gfx::Rect>();
+
+  std::vector<gfx::Rect> bands;
+  bands.reserve(band_count);
+  int band_height = playback_rect.height() / band_count;
+  int y = playback_rect.y();
+  for (int i = 0; i < band_count; ++i) {
+    // The last band absorbs the remainder of the division.
+    int height =
+        i == band_count - 1 ? playback_rect.bottom() - y : band_height;
+    bands.emplace_back(playback_rect.x(), y, playback_rect.width(), height);
+    y += height;
+  }
+  return bands;
+}
+
+// Forwards decode requests to another ImageProvider, but ignores
+// BeginRaster/EndRaster. This allows the bands of a tile to share a single
+// provider whose at-raster decodes are locked once for the whole tile.
+class BandImageProvider : public ImageProvider {
+ public:
+  explicit BandImageProvider(ImageProvider* image_provider)
+      : image_provider_(image_provider) {}
+  ~BandImageProvider() override = default;
+
+  // ImageProvider implementation.
+  ScopedDecodedDrawImage GetDecodedDrawImage(
+      const DrawImage& draw_image) override {
+    return image_provider_->GetDecodedDrawImage(draw_image);
+  }
+
+ private:
+  ImageProvider* const image_provider_;
+
+  DISALLOW_COPY_AND_ASSIGN(BandImageProvider);
+};
+
+// Plays back a set of bands into shared memory. Bands are handed out to
+// whichever thread asks first, so the thread that owns the tile never has to
+// wait for a worker that hasn't started yet.
+class BandedPlayback {
+ public:
+  BandedPlayback(void* memory,
+                 const SkImageInfo& info,
+                 size_t stride,
+                 const SkSurfaceProps& surface_props,
+                 const RasterSource* raster_source,
+                 const gfx::Rect& canvas_bitmap_rect,
+                 std::vector<gfx::Rect> bands,
+                 const gfx::AxisTransform2d& transform,
+                 const gfx::ColorSpace& target_color_space,
+                 const RasterSource::PlaybackSettings& playback_settings)
+      : memory_(memory),
+        info_(info),
+        stride_(stride),
+        surface_props_(surface_props),
+        raster_source_(raster_source),
+        canvas_bitmap_rect_(canvas_bitmap_rect),
+        bands_(std::move(bands)),
+        transform_(transform),
+        target_color_space_(target_color_space),
+        playback_settings_(playback_settings) {}
+
+  // Rasters bands until none are left. May be called on any thread.
+  void RasterRemainingBands() {
+    size_t index;
+    while (ClaimNextBand(&index)) {
+      TRACE_EVENT0(TRACE_DISABLED_BY_DEFAULT("cc.debug"),
+                   "BandedPlayback::RasterBand");
+      // Each band gets its own canvas onto the shared pixels. The bands don't
+      // overlap, so the canvases never write to the same rows.
+      sk_sp<SkSurface> surface = SkSurface::MakeRasterDirect(
+          info_, memory_, stride_, &surface_props_);
+      CHECK(surface);
+      raster_source_->PlaybackToCanvas(
+          surface->getCanvas(), target_color_space_, canvas_bitmap_rect_,
+          bands_[index], transform_, playback_settings_);
+    }
+  }
+
+  size_t band_count() const { return bands_.size(); }
+
+ private:
+  bool ClaimNextBand(size_t* index) {
+    base::AutoLock hold(lock_);
+    if (next_band_ == bands_.size())
+      return false;
+    *index = next_band_++;
+    return true;
+  }
+
+  void* const memory_;
+  const SkImageInfo info_;
+  const size_t stride_;
+  const SkSurfaceProps surface_props_;
+  const RasterSource* const raster_source_;
+  const gfx::Rect canvas_bitmap_rect_;
+  const std::vector<gfx::Rect> bands_;
+  const gfx::AxisTransform2d transform_;
+  const gfx::ColorSpace target_color_space_;
+  const RasterSource::PlaybackSettings playback_settings_;
+
+  base::Lock lock_;
+  size_t next_band_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(BandedPlayback);
+};
+
+class BandedPlaybackTask : public Task {
+ public:
+  explicit BandedPlaybackTask(BandedPlayback* playback)
+      : playback_(playback) {}
+
+  // Overridden from Task:
+  void RunOnWorkerThread() override { playback_->RasterRemainingBands(); }
+
+ private:
+  ~BandedPlaybackTask() override = default;
+
+  // Outlives every run of this task, since PlaybackBandsInParallel() waits for
+  // running tasks and cancels the rest before returning.
+  BandedPlayback* const playback_;
+
+  DISALLOW_COPY_AND_ASSIGN(BandedPlaybackTask);
+};
+
+void PlaybackBandsInParallel(
+    void* memory,
+    const SkImageInfo& info,
+    size_t stride,
+    const SkSurfaceProps& surface_props,
+    const RasterSource* raster_source,
+    const gfx::Rect& canvas_bitmap_rect,
+    std::vector<gfx::Rect> bands,
+    const gfx::AxisTransform2d& transform,
+    const gfx::ColorSpace& target_color_space,
+    const RasterSource::PlaybackSettings& playback_settings) {
+  TRACE_EVENT1("cc", "RasterBufferProvider::PlaybackBandsInParallel",
+               "band_count", bands.size());
+  TaskGraphRunner* task_graph_runner =
+      playback_settings.parallel_raster_task_graph_runner;
+
+  RasterSource::PlaybackSettings band_settings = playback_settings;
+  band_settings.parallel_raster_task_graph_runner = nullptr;
+  base::Optional<BandImageProvider> band_image_provider;
+  if (playback_settings.image_provider) {
+    playback_settings.image_provider->BeginRaster();
+    band_image_provider.emplace(playback_settings.image_provider);
+    band_settings.image_provider = &band_image_provider.value();
+  }
+
+  BandedPlayback playback(memory, info, stride, surface_props, raster_source,
+                          canvas_bitmap_rect, std::move(bands), transform,
+                          target_color_space, band_settings);
+
+  // The calling thread rasters bands as well, so one task fewer than the
+  // number of bands is enough to keep every band busy.
+  NamespaceToken token = task_graph_runner->GenerateNamespaceToken();
+  TaskGraph graph;
+  for (size_t i = 1; i < playback.band_count(); ++i) {
+    graph.nodes.push_back(
+        TaskGraph::Node(base::MakeRefCounted<BandedPlaybackTask>(&playback),
+                        TASK_CATEGORY_FOREGROUND, 0u /* priority */,
+                        0u /* dependencies */));
+  }
+  task_graph_runner->ScheduleTasks(token, &graph);
+
+  playback.RasterRemainingBands();
+
+  // Every band has been claimed at this point. Cancel the tasks that haven't
+  // started yet, and wait only for those still rastering their band. This
+  // relies on ScheduleTasks() canceling every task which hasn't started,
+  // wherever the runner queued it, as TaskGraphRunner requires: this thread is
+  // a worker of |task_graph_runner|, and band tasks may be queued behind it.
+  TaskGraph empty_graph;
+  task_graph_runner->ScheduleTasks(token, &empty_graph);
+  task_graph_runner->WaitForTasksToFinishRunning(token);
+  Task::Vector completed_tasks;
+  task_graph_runner->CollectCompletedTasks(token, &completed_tasks);
+
+  if (playback_settings.image_provider)
+    playback_settings.image_provider->EndRaster();
+}
+
 }  // anonymous namespace
 
 // static
@@ -82,6 +307,16 @@ void RasterBufferProvider::PlaybackToMemory(
     case viz::RGBA_8888:
     case viz::BGRA_8888:
     case viz::RGBA_F16: {
+      std::vector<gfx::Rect> bands = ComputeParallelRasterBands(
+          canvas_bitmap_rect, canvas_playback_rect, playback_settings);
+      if (!bands.empty()) {
+        PlaybackBandsInParallel(memory, info, stride, surface_props,
+                                raster_source, canvas_bitmap_rect,
+                                std::move(bands), transform,
+                                target_color_space, playback_settings);
+        return;
+      }
+
       sk_sp<SkSurface> surface =
           SkSurface::MakeRasterDirect(info, memory, stride, &surface_props);
       // There are some rare crashes where this doesn't succeed and may be
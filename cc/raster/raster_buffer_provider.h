@@ -83,6 +83,22 @@ class CC_EXPORT RasterBufferProvider {
   // Shutdown for doing cleanup.
   virtual void Shutdown() = 0;
 
+  // Called when the tile memory budget evicts |resource|, which holds the
+  // ready to draw content |content_id| of a tile that isn't visible. A
+  // provider may keep that content in a cheaper form and restore it when the
+  // tile is rastered again, until DiscardEvictedContent() is called.
+  virtual void RetainEvictedContent(const Resource* resource,
+                                    uint64_t content_id);
+  // Called when the tile with the content |content_id| is destroyed.
+  virtual void DiscardEvictedContent(uint64_t content_id);
+  // Returns the bytes held by retained content, which count against the tile
+  // memory budget.
+  virtual size_t GetRetainedEvictedContentBytes() const;
+  // Drops the least recently retained content until at most |max_bytes| are
+  // held. Retained content is worth less than any tile's resource, so it goes
+  // first when the budget is exceeded.
+  virtual void ReduceRetainedEvictedContent(size_t max_bytes);
+
  protected:
   // Check if resource format matches output format.
   static bool ResourceFormatRequiresSwizzle(viz::ResourceFormat format);
@@ -10,6 +10,7 @@
 #include "base/test/test_simple_task_runner.h"
 #include "base/time/time.h"
 #include "cc/base/lap_timer.h"
+#include "cc/paint/paint_flags.h"
 #include "cc/raster/bitmap_raster_buffer_provider.h"
 #include "cc/raster/gpu_raster_buffer_provider.h"
 #include "cc/raster/one_copy_raster_buffer_provider.h"
@@ -19,10 +20,13 @@
 #include "cc/resources/resource_pool.h"
 #include "cc/resources/resource_provider.h"
 #include "cc/resources/scoped_resource.h"
+#include "cc/test/fake_raster_source.h"
+#include "cc/test/fake_recording_source.h"
 #include "cc/test/fake_resource_provider.h"
 #include "cc/test/test_context_provider.h"
 #include "cc/test/test_context_support.h"
 #include "cc/test/test_shared_bitmap_manager.h"
+#include "cc/test/test_task_graph_runner.h"
 #include "cc/test/test_web_graphics_context_3d.h"
 #include "cc/tiles/tile_task_manager.h"
 #include "components/viz/common/gpu/context_cache_controller.h"
@@ -36,6 +40,7 @@
 #include "third_party/khronos/GLES2/gl2.h"
 #include "third_party/skia/include/gpu/GrContext.h"
 #include "third_party/skia/include/gpu/gl/GrGLInterface.h"
+#include "ui/gfx/geometry/axis_transform2d.h"
 
 namespace cc {
 namespace {
@@ -348,7 +353,7 @@ class RasterBufferProviderPerfTest
       case RASTER_BUFFER_PROVIDER_TYPE_BITMAP:
         CreateSoftwareResourceProvider();
         raster_buffer_provider_ =
-            BitmapRasterBufferProvider::Create(resource_provider_.get());
+            BitmapRasterBufferProvider::Create(resource_provider_.get(), 0u);
         break;
     }
 
@@ -581,6 +586,50 @@ class RasterBufferProviderCommonPerfTest
     perf_test::PrintResult("build_raster_task_graph", "", test_name,
                            timer_.LapsPerSecond(), "runs/s", true);
   }
+
+  // Measures the time to raster a single expensive tile, which bounds the
+  // tail of raster when one tile is much slower than the rest.
+  void RunPlaybackLargeTileTest(const std::string& test_name,
+                                int max_parallel_raster_bands) {
+    gfx::Size size(512, 512);
+    auto recording_source =
+        FakeRecordingSource::CreateFilledRecordingSource(size);
+    PaintFlags flags;
+    flags.setAntiAlias(true);
+    for (int i = 0; i < 4000; ++i) {
+      flags.setColor(SkColorSetARGB(128, i % 256, (i * 7) % 256, 0));
+      recording_source->add_draw_rectf_with_flags(
+          gfx::RectF((i * 13) % 400 + 0.5f, (i * 29) % 400 + 0.5f, 100.f,
+                     100.f),
+          flags);
+    }
+    recording_source->Rerecord();
+    scoped_refptr<FakeRasterSource> raster_source =
+        FakeRasterSource::CreateFromRecordingSource(recording_source.get());
+
+    TestTaskGraphRunner task_graph_runner;
+    RasterSource::PlaybackSettings settings;
+    if (max_parallel_raster_bands > 1) {
+      settings.parallel_raster_task_graph_runner = &task_graph_runner;
+      settings.max_parallel_raster_bands = max_parallel_raster_bands;
+    }
+
+    gfx::Rect canvas_rect(size);
+    size_t stride = size.width() * 4;
+    std::vector<uint8_t> memory(stride * size.height());
+
+    timer_.Reset();
+    do {
+      RasterBufferProvider::PlaybackToMemory(
+          memory.data(), viz::RGBA_8888, size, stride, raster_source.get(),
+          canvas_rect, canvas_rect, gfx::AxisTransform2d(),
+          gfx::ColorSpace(), settings);
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+
+    perf_test::PrintResult("playback_large_tile", "", test_name,
+                           timer_.MsPerLap(), "ms", true);
+  }
 };
 
 TEST_F(RasterBufferProviderCommonPerfTest, BuildTileTaskGraph) {
@@ -592,5 +641,13 @@ TEST_F(RasterBufferProviderCommonPerfTest, BuildTileTaskGraph) {
   RunBuildTileTaskGraphTest("32_4", 32, 4);
 }
 
+TEST_F(RasterBufferProviderCommonPerfTest, PlaybackLargeTile) {
+  RunPlaybackLargeTileTest("single", 1);
+  // TestTaskGraphRunner has a single worker, so two bands keep both it and the
+  // calling thread busy; more bands measure the cost of finer splitting.
+  RunPlaybackLargeTileTest("2_bands", 2);
+  RunPlaybackLargeTileTest("8_bands", 8);
+}
+
 }  // namespace
 }  // namespace cc
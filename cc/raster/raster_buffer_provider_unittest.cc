@@ -11,6 +11,7 @@
 #include <limits>
 #include <vector>
 
+#include "base/bind.h"
 #include "base/cancelable_callback.h"
 #include "base/location.h"
 #include "base/macros.h"
@@ -18,21 +19,27 @@
 #include "base/message_loop/message_loop.h"
 #include "base/run_loop.h"
 #include "base/single_thread_task_runner.h"
+#include "base/threading/simple_thread.h"
 #include "base/threading/thread_task_runner_handle.h"
 #include "cc/base/unique_notifier.h"
 #include "cc/paint/draw_image.h"
+#include "cc/paint/paint_flags.h"
 #include "cc/raster/bitmap_raster_buffer_provider.h"
 #include "cc/raster/gpu_raster_buffer_provider.h"
 #include "cc/raster/one_copy_raster_buffer_provider.h"
 #include "cc/raster/synchronous_task_graph_runner.h"
+#include "cc/raster/task_category.h"
+#include "cc/raster/work_stealing_task_graph_runner.h"
 #include "cc/raster/zero_copy_raster_buffer_provider.h"
 #include "cc/resources/resource_pool.h"
 #include "cc/resources/resource_provider.h"
 #include "cc/resources/scoped_resource.h"
 #include "cc/test/fake_raster_source.h"
+#include "cc/test/fake_recording_source.h"
 #include "cc/test/fake_resource_provider.h"
 #include "cc/test/test_context_provider.h"
 #include "cc/test/test_shared_bitmap_manager.h"
+#include "cc/test/test_task_graph_runner.h"
 #include "cc/test/test_web_graphics_context_3d.h"
 #include "cc/tiles/tile_task_manager.h"
 #include "components/viz/common/resources/platform_color.h"
@@ -194,7 +201,7 @@ class RasterBufferProviderTest
       case RASTER_BUFFER_PROVIDER_TYPE_BITMAP:
         CreateSoftwareResourceProvider();
         raster_buffer_provider_ =
-            BitmapRasterBufferProvider::Create(resource_provider_.get());
+            BitmapRasterBufferProvider::Create(resource_provider_.get(), 0u);
         break;
     }
 
@@ -460,5 +467,104 @@ INSTANTIATE_TEST_CASE_P(
                       RASTER_BUFFER_PROVIDER_TYPE_ASYNC_GPU,
                       RASTER_BUFFER_PROVIDER_TYPE_BITMAP));
 
+scoped_refptr<FakeRasterSource> CreateBandTestRasterSource(
+    const gfx::Size& size) {
+  auto recording_source =
+      FakeRecordingSource::CreateFilledRecordingSource(size);
+  PaintFlags flags;
+  flags.setAntiAlias(true);
+  for (int i = 0; i < 16; ++i) {
+    flags.setColor(SkColorSetARGB(128 + i * 8, i * 16, 255 - i * 16, 0));
+    // Fractional rects produce anti-aliased edges across band boundaries.
+    recording_source->add_draw_rectf_with_flags(
+        gfx::RectF(i * 7.3f, i * 31.7f, 150.5f, 97.25f), flags);
+  }
+  recording_source->Rerecord();
+  return FakeRasterSource::CreateFromRecordingSource(recording_source.get());
+}
+
+void PlaybackToBuffer(const RasterSource* raster_source,
+                      const RasterSource::PlaybackSettings& settings,
+                      const gfx::Size& size,
+                      std::vector<uint8_t>* buffer) {
+  size_t stride = size.width() * 4;
+  buffer->resize(stride * size.height());
+  gfx::Rect canvas_rect(size);
+  RasterBufferProvider::PlaybackToMemory(
+      buffer->data(), viz::RGBA_8888, size, stride, raster_source, canvas_rect,
+      canvas_rect, gfx::AxisTransform2d(), gfx::ColorSpace(), settings);
+}
+
+class ClosureTask : public Task {
+ public:
+  explicit ClosureTask(base::OnceClosure closure)
+      : closure_(std::move(closure)) {}
+
+  // Overridden from Task:
+  void RunOnWorkerThread() override { std::move(closure_).Run(); }
+
+ private:
+  ~ClosureTask() override = default;
+
+  base::OnceClosure closure_;
+
+  DISALLOW_COPY_AND_ASSIGN(ClosureTask);
+};
+
+TEST(RasterBufferProviderPlaybackTest, ParallelBandsMatchSinglePlayback) {
+  gfx::Size size(256, 512);
+  scoped_refptr<FakeRasterSource> raster_source =
+      CreateBandTestRasterSource(size);
+
+  RasterSource::PlaybackSettings settings;
+  std::vector<uint8_t> expected;
+  PlaybackToBuffer(raster_source.get(), settings, size, &expected);
+
+  TestTaskGraphRunner task_graph_runner;
+  settings.parallel_raster_task_graph_runner = &task_graph_runner;
+  settings.max_parallel_raster_bands = 4;
+  std::vector<uint8_t> actual;
+  PlaybackToBuffer(raster_source.get(), settings, size, &actual);
+
+  EXPECT_EQ(expected, actual);
+}
+
+// Bands are played back from a worker of the runner they are scheduled on, as
+// with the tile manager's raster tasks. The worker's own band tasks may be
+// queued behind it, so it must not wait for them.
+TEST(RasterBufferProviderPlaybackTest, ParallelBandsOnWorkStealingRunner) {
+  gfx::Size size(256, 512);
+  scoped_refptr<FakeRasterSource> raster_source =
+      CreateBandTestRasterSource(size);
+
+  RasterSource::PlaybackSettings settings;
+  std::vector<uint8_t> expected;
+  PlaybackToBuffer(raster_source.get(), settings, size, &expected);
+
+  for (int num_threads : {1, 2, 4}) {
+    WorkStealingTaskGraphRunner task_graph_runner;
+    task_graph_runner.Start(num_threads, "ParallelBandsTest",
+                            base::SimpleThread::Options());
+    settings.parallel_raster_task_graph_runner = &task_graph_runner;
+    settings.max_parallel_raster_bands = 4;
+
+    std::vector<uint8_t> actual;
+    NamespaceToken token = task_graph_runner.GenerateNamespaceToken();
+    TaskGraph graph;
+    graph.nodes.push_back(TaskGraph::Node(
+        base::MakeRefCounted<ClosureTask>(
+            base::BindOnce(&PlaybackToBuffer, base::RetainedRef(raster_source),
+                           settings, size, &actual)),
+        TASK_CATEGORY_FOREGROUND, 0u /* priority */, 0u /* dependencies */));
+    task_graph_runner.ScheduleTasks(token, &graph);
+    task_graph_runner.WaitForTasksToFinishRunning(token);
+    Task::Vector completed_tasks;
+    task_graph_runner.CollectCompletedTasks(token, &completed_tasks);
+    task_graph_runner.Shutdown();
+
+    EXPECT_EQ(expected, actual) << num_threads << " threads";
+  }
+}
+
 }  // namespace
 }  // namespace cc
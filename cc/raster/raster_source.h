@@ -27,6 +27,7 @@ namespace cc {
 class DisplayItemList;
 class DrawImage;
 class ImageProvider;
+class TaskGraphRunner;
 
 class CC_EXPORT RasterSource : public base::RefCountedThreadSafe<RasterSource> {
  public:
@@ -42,6 +43,12 @@ class CC_EXPORT RasterSource : public base::RefCountedThreadSafe<RasterSource> {
 
     // The ImageProvider used to replace images during playback.
     ImageProvider* image_provider = nullptr;
+
+    // If set, playback into memory is split into at most
+    // |max_parallel_raster_bands| horizontal bands which are rastered
+    // concurrently on this runner's workers and the calling thread.
+    TaskGraphRunner* parallel_raster_task_graph_runner = nullptr;
+    int max_parallel_raster_bands = 1;
   };
 
   // Helper function to apply a few common operations before passing the canvas
@@ -6,14 +6,19 @@
 #include <stdint.h>
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "base/macros.h"
 #include "base/memory/ptr_util.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/time/time.h"
 #include "cc/base/completion_event.h"
 #include "cc/base/lap_timer.h"
+#include "cc/raster/single_thread_task_graph_runner.h"
 #include "cc/raster/synchronous_task_graph_runner.h"
+#include "cc/raster/task_category.h"
+#include "cc/raster/work_stealing_task_graph_runner.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "testing/perf/perf_test.h"
 
@@ -313,5 +318,83 @@ TEST_F(TaskGraphRunnerPerfTest, ScheduleAndExecuteTasks) {
   RunScheduleAndExecuteTasksTest("2_32_1", 2, 32, 1);
 }
 
+// Runs large graphs of small tasks on threaded TaskGraphRunners, where the cost
+// of handing tasks to the worker threads dominates.
+class ThreadedTaskGraphRunnerPerfTest : public testing::Test {
+ public:
+  ThreadedTaskGraphRunnerPerfTest()
+      : timer_(kWarmupRuns,
+               base::TimeDelta::FromMilliseconds(kTimeLimitMillis),
+               kTimeCheckInterval) {}
+
+  void RunExecuteTasksTest(TaskGraphRunner* task_graph_runner,
+                           const std::string& runner_name,
+                           const std::string& test_name,
+                           int num_foreground_tasks,
+                           int num_background_tasks) {
+    NamespaceToken namespace_token =
+        task_graph_runner->GenerateNamespaceToken();
+
+    PerfTaskImpl::Vector tasks;
+    for (int i = 0; i < num_foreground_tasks + num_background_tasks; ++i)
+      tasks.push_back(base::MakeRefCounted<PerfTaskImpl>());
+
+    // Avoid unnecessary heap allocations by reusing the same graph and
+    // completed tasks vector.
+    TaskGraph graph;
+    Task::Vector completed_tasks;
+
+    timer_.Reset();
+    do {
+      graph.Reset();
+      for (size_t i = 0; i < tasks.size(); ++i) {
+        tasks[i]->Reset();
+        uint16_t category = static_cast<int>(i) < num_foreground_tasks
+                                ? TASK_CATEGORY_FOREGROUND
+                                : TASK_CATEGORY_BACKGROUND;
+        graph.nodes.emplace_back(tasks[i], category, static_cast<uint16_t>(i),
+                                 0u);
+      }
+      task_graph_runner->ScheduleTasks(namespace_token, &graph);
+      task_graph_runner->WaitForTasksToFinishRunning(namespace_token);
+      task_graph_runner->CollectCompletedTasks(namespace_token,
+                                               &completed_tasks);
+      DCHECK_EQ(tasks.size(), completed_tasks.size());
+      completed_tasks.clear();
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+
+    perf_test::PrintResult("execute_tasks", runner_name, test_name,
+                           timer_.LapsPerSecond(), "runs/s", true);
+  }
+
+ private:
+  LapTimer timer_;
+};
+
+TEST_F(ThreadedTaskGraphRunnerPerfTest, SingleThreadTaskGraphRunner) {
+  SingleThreadTaskGraphRunner task_graph_runner;
+  task_graph_runner.Start("PerfTestWorker", base::SimpleThread::Options());
+  RunExecuteTasksTest(&task_graph_runner, "_single_thread", "1024_0", 1024, 0);
+  RunExecuteTasksTest(&task_graph_runner, "_single_thread", "4096_0", 4096, 0);
+  RunExecuteTasksTest(&task_graph_runner, "_single_thread", "4096_256", 4096,
+                      256);
+  task_graph_runner.Shutdown();
+}
+
+TEST_F(ThreadedTaskGraphRunnerPerfTest, WorkStealingTaskGraphRunner) {
+  for (int num_threads : {1, 2, 4}) {
+    WorkStealingTaskGraphRunner task_graph_runner;
+    task_graph_runner.Start(num_threads, "PerfTestWorker",
+                            base::SimpleThread::Options());
+    std::string runner_name =
+        "_work_stealing_" + base::IntToString(num_threads) + "_threads";
+    RunExecuteTasksTest(&task_graph_runner, runner_name, "1024_0", 1024, 0);
+    RunExecuteTasksTest(&task_graph_runner, runner_name, "4096_0", 4096, 0);
+    RunExecuteTasksTest(&task_graph_runner, runner_name, "4096_256", 4096, 256);
+    task_graph_runner.Shutdown();
+  }
+}
+
 }  // namespace
 }  // namespace cc
@@ -354,6 +354,24 @@ void TaskGraphWorkQueue::CompleteTask(PrioritizedTask completed_task) {
   task_namespace->completed_tasks.push_back(std::move(task));
 }
 
+void TaskGraphWorkQueue::ReturnUnstartedTask(PrioritizedTask task) {
+  TaskNamespace* task_namespace = task.task_namespace;
+
+  // Remove task from |running_tasks|.
+  auto it = std::find_if(task_namespace->running_tasks.begin(),
+                         task_namespace->running_tasks.end(),
+                         [&task](const CategorizedTask& categorized_task) {
+                           return categorized_task.second == task.task;
+                         });
+  DCHECK(it != task_namespace->running_tasks.end());
+  std::swap(*it, task_namespace->running_tasks.back());
+  task_namespace->running_tasks.pop_back();
+
+  // Back to the state ScheduleTasks() expects of a task it has never seen.
+  DCHECK(task.task->state().IsRunning());
+  task.task->state().Reset();
+}
+
 void TaskGraphWorkQueue::CollectCompletedTasks(NamespaceToken token,
                                                Task::Vector* completed_tasks) {
   TaskNamespaceMap::iterator it = namespaces_.find(token);
@@ -94,6 +94,13 @@ class CC_EXPORT TaskGraphWorkQueue {
   // tasks and updating the list of |ready_to_run_namespaces|.
   void CompleteTask(PrioritizedTask completed_task);
 
+  // Undoes GetNextTaskToRun() for a task that was taken but hasn't started
+  // running, e.g. because it is still queued on a worker. The task is neither
+  // ready to run nor running afterwards, so the caller must call
+  // ScheduleTasks() for its namespace next, which schedules it again if it is
+  // still in the graph and cancels it otherwise.
+  void ReturnUnstartedTask(PrioritizedTask task);
+
   // Helper which populates a vector of completed tasks from the provided
   // namespace.
   void CollectCompletedTasks(NamespaceToken token,
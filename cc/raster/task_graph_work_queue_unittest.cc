@@ -58,5 +58,47 @@ TEST(TaskGraphWorkQueueTest, TestChangingDependency) {
   EXPECT_FALSE(work_queue.HasReadyToRunTasks());
 }
 
+TEST(TaskGraphWorkQueueTest, ReturnUnstartedTask) {
+  TaskGraphWorkQueue work_queue;
+  NamespaceToken token = work_queue.GenerateNamespaceToken();
+
+  scoped_refptr<FakeTaskImpl> kept_task(new FakeTaskImpl());
+  scoped_refptr<FakeTaskImpl> dropped_task(new FakeTaskImpl());
+  TaskGraph graph1;
+  graph1.nodes.push_back(TaskGraph::Node(kept_task.get(), 0u, 0u, 0u));
+  graph1.nodes.push_back(TaskGraph::Node(dropped_task.get(), 0u, 1u, 0u));
+  work_queue.ScheduleTasks(token, &graph1);
+
+  // Take both tasks, as a runner handing them out to workers would.
+  TaskGraphWorkQueue::PrioritizedTask taken_kept_task =
+      work_queue.GetNextTaskToRun(0u);
+  TaskGraphWorkQueue::PrioritizedTask taken_dropped_task =
+      work_queue.GetNextTaskToRun(0u);
+  EXPECT_EQ(kept_task.get(), taken_kept_task.task.get());
+  EXPECT_EQ(dropped_task.get(), taken_dropped_task.task.get());
+  EXPECT_FALSE(work_queue.HasReadyToRunTasks());
+
+  // Return them unstarted, and schedule a graph without |dropped_task|.
+  work_queue.ReturnUnstartedTask(std::move(taken_kept_task));
+  work_queue.ReturnUnstartedTask(std::move(taken_dropped_task));
+  TaskGraph graph2;
+  graph2.nodes.push_back(TaskGraph::Node(kept_task.get(), 0u, 0u, 0u));
+  work_queue.ScheduleTasks(token, &graph2);
+
+  // |dropped_task| is canceled, and |kept_task| can be run again.
+  EXPECT_TRUE(dropped_task->state().IsCanceled());
+  ASSERT_TRUE(work_queue.HasReadyToRunTasks());
+  TaskGraphWorkQueue::PrioritizedTask prioritized_task =
+      work_queue.GetNextTaskToRun(0u);
+  EXPECT_EQ(kept_task.get(), prioritized_task.task.get());
+  work_queue.CompleteTask(std::move(prioritized_task));
+  EXPECT_TRUE(kept_task->state().IsFinished());
+
+  Task::Vector completed_tasks;
+  work_queue.CollectCompletedTasks(token, &completed_tasks);
+  EXPECT_EQ(2u, completed_tasks.size());
+  EXPECT_FALSE(work_queue.HasAnyNamespaces());
+}
+
 }  // namespace
 }  // namespace cc
@@ -0,0 +1,439 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/raster/work_stealing_task_graph_runner.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/strings/stringprintf.h"
+#include "base/threading/thread_restrictions.h"
+#include "base/trace_event/trace_event.h"
+#include "cc/raster/task_category.h"
+
+namespace cc {
+namespace {
+
+// The number of foreground tasks that can be handed out per foreground worker
+// before they complete. Enough to keep a worker busy while it waits for the
+// global lock, but small enough that few tasks become uncancelable.
+const size_t kMaxDispatchedForegroundTasksPerWorker = 4;
+
+// Nonconcurrent tasks go before foreground tasks, then tasks are sorted by
+// priority. Lower values run first.
+bool RunsBefore(const TaskGraphWorkQueue::PrioritizedTask& a,
+                const TaskGraphWorkQueue::PrioritizedTask& b) {
+  bool a_is_nonconcurrent =
+      a.category == TASK_CATEGORY_NONCONCURRENT_FOREGROUND;
+  bool b_is_nonconcurrent =
+      b.category == TASK_CATEGORY_NONCONCURRENT_FOREGROUND;
+  if (a_is_nonconcurrent != b_is_nonconcurrent)
+    return a_is_nonconcurrent;
+  return a.priority < b.priority;
+}
+
+}  // namespace
+
+// A thread which forwards to WorkStealingTaskGraphRunner::RunWorker.
+class WorkStealingTaskGraphRunner::WorkerThread : public base::SimpleThread {
+ public:
+  WorkerThread(const std::string& name,
+               const Options& options,
+               WorkStealingTaskGraphRunner* runner,
+               size_t worker_index)
+      : SimpleThread(name, options),
+        runner_(runner),
+        worker_index_(worker_index) {}
+
+  void Run() override { runner_->RunWorker(worker_index_); }
+
+ private:
+  WorkStealingTaskGraphRunner* const runner_;
+  const size_t worker_index_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkerThread);
+};
+
+WorkStealingTaskGraphRunner::Worker::Worker() = default;
+
+WorkStealingTaskGraphRunner::Worker::~Worker() = default;
+
+WorkStealingTaskGraphRunner::WorkStealingTaskGraphRunner()
+    : num_dispatched_nonconcurrent_tasks_(0u),
+      num_dispatched_foreground_tasks_(0u),
+      num_dispatched_background_tasks_(0u),
+      next_foreground_worker_(0u),
+      has_foreground_tasks_cv_(&lock_),
+      has_background_tasks_cv_(&lock_),
+      has_namespaces_with_finished_running_tasks_cv_(&lock_),
+      shutdown_(false) {}
+
+WorkStealingTaskGraphRunner::~WorkStealingTaskGraphRunner() {
+  DCHECK(threads_.empty());
+}
+
+void WorkStealingTaskGraphRunner::Start(
+    int num_foreground_threads,
+    const std::string& thread_name_prefix,
+    const base::SimpleThread::Options& background_thread_options) {
+  DCHECK(workers_.empty());
+  DCHECK_GT(num_foreground_threads, 0);
+
+  // All workers must exist before any thread starts stealing from them.
+  for (int i = 0; i < num_foreground_threads + 1; i++)
+    workers_.push_back(std::make_unique<Worker>());
+
+  for (int i = 0; i < num_foreground_threads; i++) {
+    auto thread = std::make_unique<WorkerThread>(
+        base::StringPrintf("%s%d", thread_name_prefix.c_str(), i + 1),
+        base::SimpleThread::Options(), this, i);
+    thread->Start();
+    threads_.push_back(std::move(thread));
+  }
+
+  auto thread = std::make_unique<WorkerThread>(
+      thread_name_prefix + "Background", background_thread_options, this,
+      num_foreground_threads);
+  thread->Start();
+  threads_.push_back(std::move(thread));
+}
+
+void WorkStealingTaskGraphRunner::Shutdown() {
+  {
+    base::AutoLock lock(lock_);
+
+    DCHECK(!work_queue_.HasReadyToRunTasks());
+    DCHECK(!work_queue_.HasAnyNamespaces());
+
+    DCHECK(!shutdown_);
+    shutdown_ = true;
+
+    // Wake up all workers so they exit.
+    has_foreground_tasks_cv_.Broadcast();
+    has_background_tasks_cv_.Broadcast();
+  }
+  while (!threads_.empty()) {
+    threads_.back()->Join();
+    threads_.pop_back();
+  }
+}
+
+void WorkStealingTaskGraphRunner::FlushForTesting() {
+  base::AutoLock lock(lock_);
+
+  while (!work_queue_.HasFinishedRunningTasksInAllNamespaces())
+    has_namespaces_with_finished_running_tasks_cv_.Wait();
+}
+
+base::PlatformThreadId WorkStealingTaskGraphRunner::background_thread_id()
+    const {
+  return threads_.back()->tid();
+}
+
+NamespaceToken WorkStealingTaskGraphRunner::GenerateNamespaceToken() {
+  base::AutoLock lock(lock_);
+  return work_queue_.GenerateNamespaceToken();
+}
+
+void WorkStealingTaskGraphRunner::ScheduleTasks(NamespaceToken token,
+                                                TaskGraph* graph) {
+  TRACE_EVENT2("disabled-by-default-cc.debug",
+               "WorkStealingTaskGraphRunner::ScheduleTasks", "num_nodes",
+               graph->nodes.size(), "num_edges", graph->edges.size());
+
+  DCHECK(token.IsValid());
+  DCHECK(!TaskGraphWorkQueue::DependencyMismatch(graph));
+
+  {
+    base::AutoLock lock(lock_);
+
+    DCHECK(!shutdown_);
+
+    // Tasks sitting in the workers' deques must be cancelable too.
+    auto* task_namespace = work_queue_.GetNamespaceForToken(token);
+    if (task_namespace)
+      ReclaimUnstartedTasksWithLockAcquired(task_namespace);
+
+    work_queue_.ScheduleTasks(token, graph);
+    DispatchTasksWithLockAcquired();
+  }
+}
+
+void WorkStealingTaskGraphRunner::WaitForTasksToFinishRunning(
+    NamespaceToken token) {
+  TRACE_EVENT0("disabled-by-default-cc.debug",
+               "WorkStealingTaskGraphRunner::WaitForTasksToFinishRunning");
+
+  DCHECK(token.IsValid());
+
+  {
+    base::AutoLock lock(lock_);
+    base::ThreadRestrictions::ScopedAllowWait allow_wait;
+
+    // A task waiting on tasks it scheduled may run on a worker which has yet
+    // to complete tasks it ran before, possibly those waited for here, or
+    // those another waiting worker depends on. Complete them before blocking.
+    Worker* current_worker = current_worker_.Get();
+    if (current_worker)
+      CompleteTasksWithLockAcquired(&current_worker->completed_tasks);
+
+    auto* task_namespace = work_queue_.GetNamespaceForToken(token);
+
+    if (!task_namespace)
+      return;
+
+    while (!work_queue_.HasFinishedRunningTasksInNamespace(task_namespace))
+      has_namespaces_with_finished_running_tasks_cv_.Wait();
+
+    // There may be other namespaces that have finished running tasks, so wake
+    // up another origin thread.
+    has_namespaces_with_finished_running_tasks_cv_.Signal();
+  }
+}
+
+void WorkStealingTaskGraphRunner::CollectCompletedTasks(
+    NamespaceToken token,
+    Task::Vector* completed_tasks) {
+  TRACE_EVENT0("disabled-by-default-cc.debug",
+               "WorkStealingTaskGraphRunner::CollectCompletedTasks");
+
+  DCHECK(token.IsValid());
+
+  {
+    base::AutoLock lock(lock_);
+    work_queue_.CollectCompletedTasks(token, completed_tasks);
+  }
+}
+
+void WorkStealingTaskGraphRunner::RunWorker(size_t worker_index) {
+  base::ConditionVariable* has_tasks_cv = is_background_worker(worker_index)
+                                              ? &has_background_tasks_cv_
+                                              : &has_foreground_tasks_cv_;
+  Worker* worker = workers_[worker_index].get();
+  PrioritizedTask::Vector* completed_tasks = &worker->completed_tasks;
+  current_worker_.Set(worker);
+
+  while (true) {
+    PrioritizedTask task(nullptr, nullptr, 0u, 0u);
+    if (TakeTask(worker_index, &task)) {
+      {
+        TRACE_EVENT0("toplevel", "TaskGraphRunner::RunTask");
+        task.task->RunOnWorkerThread();
+      }
+      completed_tasks->push_back(std::move(task));
+
+      // Only complete tasks right away if that doesn't block this worker.
+      // Otherwise, keep running tasks and complete them all at once later.
+      // A single foreground worker has no other workers to keep busy, and
+      // always completing right away keeps its tasks in priority order.
+      if (num_foreground_workers() == 1) {
+        base::AutoLock lock(lock_);
+        CompleteTasksWithLockAcquired(completed_tasks);
+      } else if (lock_.Try()) {
+        CompleteTasksWithLockAcquired(completed_tasks);
+        lock_.Release();
+      }
+      continue;
+    }
+
+    base::AutoLock lock(lock_);
+    CompleteTasksWithLockAcquired(completed_tasks);
+
+    // Completing tasks may have handed out more tasks to this worker.
+    if (HasTaskForWorkerWithLockAcquired(worker_index))
+      continue;
+
+    // Exit when shutdown is set and no more tasks are pending.
+    if (shutdown_)
+      break;
+
+    // Wait for more tasks.
+    has_tasks_cv->Wait();
+  }
+}
+
+bool WorkStealingTaskGraphRunner::TakeTask(size_t worker_index,
+                                           PrioritizedTask* task) {
+  if (PopTask(workers_[worker_index].get(), task))
+    return true;
+
+  // The background worker only runs background tasks, so it doesn't steal.
+  if (is_background_worker(worker_index))
+    return false;
+
+  for (size_t i = 1; i < num_foreground_workers(); i++) {
+    size_t victim_index = (worker_index + i) % num_foreground_workers();
+    if (PopTask(workers_[victim_index].get(), task))
+      return true;
+  }
+  return false;
+}
+
+// static
+bool WorkStealingTaskGraphRunner::PopTask(Worker* worker,
+                                          PrioritizedTask* task) {
+  base::AutoLock lock(worker->lock);
+  if (worker->tasks.empty())
+    return false;
+  // Both the owner and thieves take the task that should run first, so that
+  // stealing doesn't change the order in which tasks start.
+  *task = std::move(worker->tasks.front());
+  worker->tasks.pop_front();
+  return true;
+}
+
+void WorkStealingTaskGraphRunner::CompleteTasksWithLockAcquired(
+    PrioritizedTask::Vector* completed_tasks) {
+  lock_.AssertAcquired();
+
+  if (completed_tasks->empty())
+    return;
+
+  bool has_namespaces_with_finished_running_tasks = false;
+  for (auto& completed_task : *completed_tasks) {
+    DidFinishDispatchedTaskWithLockAcquired(completed_task.category);
+
+    auto* task_namespace = completed_task.task_namespace;
+    work_queue_.CompleteTask(std::move(completed_task));
+    if (work_queue_.HasFinishedRunningTasksInNamespace(task_namespace))
+      has_namespaces_with_finished_running_tasks = true;
+  }
+  completed_tasks->clear();
+
+  // Completed tasks may have made more tasks ready to run, and leave room to
+  // hand out more.
+  DispatchTasksWithLockAcquired();
+
+  // If a namespace has finished running all tasks, wake up origin threads.
+  if (has_namespaces_with_finished_running_tasks)
+    has_namespaces_with_finished_running_tasks_cv_.Signal();
+}
+
+void WorkStealingTaskGraphRunner::ReclaimUnstartedTasksWithLockAcquired(
+    TaskGraphWorkQueue::TaskNamespace* task_namespace) {
+  lock_.AssertAcquired();
+
+  for (auto& worker : workers_) {
+    base::AutoLock lock(worker->lock);
+    std::deque<PrioritizedTask> kept_tasks;
+    for (auto& task : worker->tasks) {
+      if (task.task_namespace != task_namespace) {
+        kept_tasks.push_back(std::move(task));
+        continue;
+      }
+      DidFinishDispatchedTaskWithLockAcquired(task.category);
+      work_queue_.ReturnUnstartedTask(std::move(task));
+    }
+    worker->tasks.swap(kept_tasks);
+  }
+}
+
+void WorkStealingTaskGraphRunner::DidFinishDispatchedTaskWithLockAcquired(
+    uint16_t category) {
+  lock_.AssertAcquired();
+
+  switch (category) {
+    case TASK_CATEGORY_NONCONCURRENT_FOREGROUND:
+      DCHECK_GT(num_dispatched_nonconcurrent_tasks_, 0u);
+      --num_dispatched_nonconcurrent_tasks_;
+      break;
+    case TASK_CATEGORY_FOREGROUND:
+      DCHECK_GT(num_dispatched_foreground_tasks_, 0u);
+      --num_dispatched_foreground_tasks_;
+      break;
+    case TASK_CATEGORY_BACKGROUND:
+      DCHECK_GT(num_dispatched_background_tasks_, 0u);
+      --num_dispatched_background_tasks_;
+      break;
+  }
+}
+
+void WorkStealingTaskGraphRunner::DispatchTasksWithLockAcquired() {
+  lock_.AssertAcquired();
+
+  // Nothing can run before Start().
+  if (workers_.empty())
+    return;
+
+  // Hands |task| to the next foreground worker. Each deque is kept sorted, so
+  // a task handed out later can still run before the ones already handed out.
+  auto dispatch_to_foreground_worker = [this](PrioritizedTask task) {
+    Worker* worker = workers_[next_foreground_worker_].get();
+    next_foreground_worker_ =
+        (next_foreground_worker_ + 1) % num_foreground_workers();
+    base::AutoLock lock(worker->lock);
+    auto it = std::upper_bound(worker->tasks.begin(), worker->tasks.end(),
+                               task, RunsBefore);
+    worker->tasks.insert(it, std::move(task));
+  };
+
+  size_t num_foreground_tasks_dispatched = 0;
+
+  // Enforce that only one nonconcurrent task runs at a time.
+  if (num_dispatched_nonconcurrent_tasks_ == 0 &&
+      work_queue_.HasReadyToRunTasksForCategory(
+          TASK_CATEGORY_NONCONCURRENT_FOREGROUND)) {
+    dispatch_to_foreground_worker(work_queue_.GetNextTaskToRun(
+        TASK_CATEGORY_NONCONCURRENT_FOREGROUND));
+    ++num_dispatched_nonconcurrent_tasks_;
+    ++num_foreground_tasks_dispatched;
+  }
+
+  size_t max_dispatched_foreground_tasks =
+      kMaxDispatchedForegroundTasksPerWorker * num_foreground_workers();
+  while (num_dispatched_foreground_tasks_ < max_dispatched_foreground_tasks &&
+         work_queue_.HasReadyToRunTasksForCategory(TASK_CATEGORY_FOREGROUND)) {
+    dispatch_to_foreground_worker(
+        work_queue_.GetNextTaskToRun(TASK_CATEGORY_FOREGROUND));
+    ++num_dispatched_foreground_tasks_;
+    ++num_foreground_tasks_dispatched;
+  }
+
+  size_t num_foreground_workers_to_wake =
+      std::min(num_foreground_tasks_dispatched, num_foreground_workers());
+  for (size_t i = 0; i < num_foreground_workers_to_wake; i++)
+    has_foreground_tasks_cv_.Signal();
+
+  // Only run background tasks if there are no foreground tasks running or
+  // ready to run. Background tasks are handed out one at a time, so that
+  // foreground tasks scheduled in the meantime don't wait behind them.
+  bool has_foreground_tasks =
+      num_dispatched_nonconcurrent_tasks_ > 0 ||
+      num_dispatched_foreground_tasks_ > 0 ||
+      work_queue_.HasReadyToRunTasksForCategory(
+          TASK_CATEGORY_NONCONCURRENT_FOREGROUND) ||
+      work_queue_.HasReadyToRunTasksForCategory(TASK_CATEGORY_FOREGROUND);
+  if (!has_foreground_tasks && num_dispatched_background_tasks_ == 0 &&
+      work_queue_.HasReadyToRunTasksForCategory(TASK_CATEGORY_BACKGROUND)) {
+    Worker* worker = workers_.back().get();
+    {
+      base::AutoLock lock(worker->lock);
+      worker->tasks.push_back(
+          work_queue_.GetNextTaskToRun(TASK_CATEGORY_BACKGROUND));
+    }
+    ++num_dispatched_background_tasks_;
+    has_background_tasks_cv_.Signal();
+  }
+}
+
+bool WorkStealingTaskGraphRunner::HasTaskForWorkerWithLockAcquired(
+    size_t worker_index) {
+  lock_.AssertAcquired();
+
+  if (is_background_worker(worker_index)) {
+    Worker* worker = workers_[worker_index].get();
+    base::AutoLock lock(worker->lock);
+    return !worker->tasks.empty();
+  }
+
+  for (size_t i = 0; i < num_foreground_workers(); i++) {
+    Worker* worker = workers_[i].get();
+    base::AutoLock lock(worker->lock);
+    if (!worker->tasks.empty())
+      return true;
+  }
+  return false;
+}
+
+}  // namespace cc
@@ -0,0 +1,155 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CC_RASTER_WORK_STEALING_TASK_GRAPH_RUNNER_H_
+#define CC_RASTER_WORK_STEALING_TASK_GRAPH_RUNNER_H_
+
+#include <stddef.h>
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/synchronization/condition_variable.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/simple_thread.h"
+#include "base/threading/thread_local.h"
+#include "cc/cc_export.h"
+#include "cc/raster/task_graph_runner.h"
+#include "cc/raster/task_graph_work_queue.h"
+
+namespace cc {
+
+// A TaskGraphRunner that runs tasks on a pool of threads, using the task
+// categories in cc/raster/task_category.h: foreground threads run
+// TASK_CATEGORY_NONCONCURRENT_FOREGROUND and TASK_CATEGORY_FOREGROUND tasks,
+// and a single background thread runs TASK_CATEGORY_BACKGROUND tasks.
+//
+// Unlike a pool built directly on TaskGraphWorkQueue, worker threads don't
+// pick tasks under a global lock. Instead, each worker has its own deque of
+// tasks. Whenever tasks become ready to run, a small window of them is taken
+// from the work queue, in category and priority order, and handed out to the
+// workers' deques. A worker runs the tasks in its own deque first and steals
+// from the other workers' deques once it runs out. The global lock is then
+// only taken to hand out tasks and to complete them, and completions are
+// batched when the lock is contended.
+//
+// ScheduleTasks() takes back the tasks of its namespace which were handed out
+// but haven't started, so they are canceled or rescheduled like tasks that
+// weren't handed out. The window is kept small so that this stays cheap. At
+// most one nonconcurrent task is handed out at a time, and background tasks
+// are only handed out when no foreground tasks are ready or running.
+class CC_EXPORT WorkStealingTaskGraphRunner : public TaskGraphRunner {
+ public:
+  WorkStealingTaskGraphRunner();
+  ~WorkStealingTaskGraphRunner() override;
+
+  // Starts |num_foreground_threads| foreground threads and one background
+  // thread, which uses |background_thread_options|.
+  void Start(int num_foreground_threads,
+             const std::string& thread_name_prefix,
+             const base::SimpleThread::Options& background_thread_options);
+
+  // Stops all threads. All namespaces must have finished running their tasks.
+  void Shutdown();
+
+  // Blocks until all namespaces have finished running their tasks.
+  void FlushForTesting();
+
+  base::PlatformThreadId background_thread_id() const;
+
+  // Overridden from TaskGraphRunner:
+  NamespaceToken GenerateNamespaceToken() override;
+  void ScheduleTasks(NamespaceToken token, TaskGraph* graph) override;
+  void WaitForTasksToFinishRunning(NamespaceToken token) override;
+  void CollectCompletedTasks(NamespaceToken token,
+                             Task::Vector* completed_tasks) override;
+
+ private:
+  class WorkerThread;
+
+  using PrioritizedTask = TaskGraphWorkQueue::PrioritizedTask;
+
+  struct Worker {
+    Worker();
+    ~Worker();
+
+    // Protects |tasks|. Must be acquired after |lock_| if both are held.
+    base::Lock lock;
+    // Tasks handed out to this worker, highest priority first.
+    std::deque<PrioritizedTask> tasks;
+    // Tasks run by this worker which aren't completed yet. Only accessed on
+    // the worker's thread.
+    PrioritizedTask::Vector completed_tasks;
+  };
+
+  // Runs tasks on the worker at |worker_index| until shutdown.
+  void RunWorker(size_t worker_index);
+
+  // Takes the next task for the worker at |worker_index|, from its own deque
+  // or, failing that, from another foreground worker's deque. Returns false if
+  // there are none.
+  bool TakeTask(size_t worker_index, PrioritizedTask* task);
+  static bool PopTask(Worker* worker, PrioritizedTask* task);
+
+  // Completes |completed_tasks| and hands out the tasks that became ready.
+  void CompleteTasksWithLockAcquired(
+      std::vector<PrioritizedTask>* completed_tasks);
+
+  // Takes the tasks of |task_namespace| which were handed out but haven't
+  // started back from the workers, and returns them to |work_queue_|.
+  void ReclaimUnstartedTasksWithLockAcquired(
+      TaskGraphWorkQueue::TaskNamespace* task_namespace);
+
+  // Updates the count of handed out tasks when one of |category| completes or
+  // is taken back.
+  void DidFinishDispatchedTaskWithLockAcquired(uint16_t category);
+
+  // Hands out as many ready to run tasks as the window allows, and wakes up
+  // workers to run them.
+  void DispatchTasksWithLockAcquired();
+
+  // Returns true if the worker at |worker_index| could take a task without
+  // waiting for more tasks to be handed out.
+  bool HasTaskForWorkerWithLockAcquired(size_t worker_index);
+
+  bool is_background_worker(size_t worker_index) const {
+    return worker_index == workers_.size() - 1;
+  }
+  size_t num_foreground_workers() const { return workers_.size() - 1; }
+
+  // The last worker is the background worker.
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::unique_ptr<WorkerThread>> threads_;
+  // The worker run by the current thread, if it is a worker thread.
+  base::ThreadLocalPointer<Worker> current_worker_;
+
+  // Lock to exclusively access all the following members.
+  base::Lock lock_;
+  // Stores the tasks that are not handed out yet, sorted by priority.
+  TaskGraphWorkQueue work_queue_;
+  // The number of handed out tasks of each category that haven't completed.
+  size_t num_dispatched_nonconcurrent_tasks_;
+  size_t num_dispatched_foreground_tasks_;
+  size_t num_dispatched_background_tasks_;
+  // The foreground worker that is handed the next task.
+  size_t next_foreground_worker_;
+  // Condition variables waited on by idle foreground and background workers.
+  base::ConditionVariable has_foreground_tasks_cv_;
+  base::ConditionVariable has_background_tasks_cv_;
+  // Condition variable that is waited on by origin threads until a namespace
+  // has finished running all associated tasks.
+  base::ConditionVariable has_namespaces_with_finished_running_tasks_cv_;
+  // Set during shutdown. Tells workers to exit when no more tasks are pending.
+  bool shutdown_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingTaskGraphRunner);
+};
+
+}  // namespace cc
+
+#endif  // CC_RASTER_WORK_STEALING_TASK_GRAPH_RUNNER_H_
@@ -0,0 +1,170 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/raster/work_stealing_task_graph_runner.h"
+
+#include "base/bind.h"
+#include "base/callback.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/simple_thread.h"
+#include "cc/raster/task_category.h"
+#include "cc/test/task_graph_runner_test_template.h"
+
+namespace cc {
+namespace {
+
+template <int NumThreads>
+class WorkStealingTaskGraphRunnerTestDelegate {
+ public:
+  WorkStealingTaskGraphRunnerTestDelegate() = default;
+
+  void StartTaskGraphRunner() {
+    work_stealing_task_graph_runner_.Start(
+        NumThreads, "WorkStealingTaskGraphRunnerTestDelegate",
+        base::SimpleThread::Options());
+  }
+
+  TaskGraphRunner* GetTaskGraphRunner() {
+    return &work_stealing_task_graph_runner_;
+  }
+
+  void StopTaskGraphRunner() {
+    work_stealing_task_graph_runner_.FlushForTesting();
+  }
+
+  ~WorkStealingTaskGraphRunnerTestDelegate() {
+    work_stealing_task_graph_runner_.Shutdown();
+  }
+
+ private:
+  WorkStealingTaskGraphRunner work_stealing_task_graph_runner_;
+};
+
+INSTANTIATE_TYPED_TEST_CASE_P(WorkStealingTaskGraphRunner_1_Threads,
+                              TaskGraphRunnerTest,
+                              WorkStealingTaskGraphRunnerTestDelegate<1>);
+INSTANTIATE_TYPED_TEST_CASE_P(WorkStealingTaskGraphRunner_2_Threads,
+                              TaskGraphRunnerTest,
+                              WorkStealingTaskGraphRunnerTestDelegate<2>);
+INSTANTIATE_TYPED_TEST_CASE_P(WorkStealingTaskGraphRunner_4_Threads,
+                              TaskGraphRunnerTest,
+                              WorkStealingTaskGraphRunnerTestDelegate<4>);
+
+// With more than one foreground worker, completions may be batched when the
+// lock is contended, which lets an already handed out lower priority task run
+// before a dependent that was just made ready. A single worker always completes
+// its tasks right away.
+INSTANTIATE_TYPED_TEST_CASE_P(WorkStealingTaskGraphRunner,
+                              SingleThreadTaskGraphRunnerTest,
+                              WorkStealingTaskGraphRunnerTestDelegate<1>);
+
+class ClosureTask : public Task {
+ public:
+  explicit ClosureTask(base::OnceClosure closure)
+      : closure_(std::move(closure)) {}
+
+  // Overridden from Task:
+  void RunOnWorkerThread() override { std::move(closure_).Run(); }
+
+ private:
+  ~ClosureTask() override = default;
+
+  base::OnceClosure closure_;
+
+  DISALLOW_COPY_AND_ASSIGN(ClosureTask);
+};
+
+void SignalAndWait(base::WaitableEvent* started, base::WaitableEvent* release) {
+  started->Signal();
+  release->Wait();
+}
+
+// Tasks handed out to a busy worker can still be canceled.
+TEST(WorkStealingTaskGraphRunnerTest, CancelHandedOutTasks) {
+  WorkStealingTaskGraphRunner runner;
+  runner.Start(1, "CancelHandedOutTasks", base::SimpleThread::Options());
+  NamespaceToken token = runner.GenerateNamespaceToken();
+
+  base::WaitableEvent started(base::WaitableEvent::ResetPolicy::MANUAL,
+                              base::WaitableEvent::InitialState::NOT_SIGNALED);
+  base::WaitableEvent release(base::WaitableEvent::ResetPolicy::MANUAL,
+                              base::WaitableEvent::InitialState::NOT_SIGNALED);
+  bool queued_task_ran = false;
+  auto blocking_task = base::MakeRefCounted<ClosureTask>(
+      base::BindOnce(&SignalAndWait, &started, &release));
+  auto queued_task = base::MakeRefCounted<ClosureTask>(base::BindOnce(
+      [](bool* queued_task_ran) { *queued_task_ran = true; },
+      &queued_task_ran));
+  TaskGraph graph;
+  graph.nodes.push_back(TaskGraph::Node(blocking_task, TASK_CATEGORY_FOREGROUND,
+                                        0u /* priority */,
+                                        0u /* dependencies */));
+  graph.nodes.push_back(TaskGraph::Node(queued_task, TASK_CATEGORY_FOREGROUND,
+                                        1u /* priority */,
+                                        0u /* dependencies */));
+  runner.ScheduleTasks(token, &graph);
+  started.Wait();
+
+  // |queued_task| is in the only worker's deque, behind |blocking_task|.
+  TaskGraph empty_graph;
+  runner.ScheduleTasks(token, &empty_graph);
+  EXPECT_TRUE(queued_task->state().IsCanceled());
+
+  release.Signal();
+  runner.WaitForTasksToFinishRunning(token);
+  Task::Vector completed_tasks;
+  runner.CollectCompletedTasks(token, &completed_tasks);
+  EXPECT_EQ(2u, completed_tasks.size());
+  EXPECT_FALSE(queued_task_ran);
+  EXPECT_TRUE(blocking_task->state().IsFinished());
+
+  runner.Shutdown();
+}
+
+// A task can schedule tasks on the runner it runs on, cancel those that no
+// other worker started, and wait for the rest, as banded playback does.
+void ScheduleCancelAndWait(WorkStealingTaskGraphRunner* runner,
+                           int* subtasks_run) {
+  NamespaceToken token = runner->GenerateNamespaceToken();
+  TaskGraph graph;
+  for (int i = 0; i < 8; ++i) {
+    graph.nodes.push_back(TaskGraph::Node(
+        base::MakeRefCounted<ClosureTask>(base::BindOnce(
+            [](int* subtasks_run) { ++*subtasks_run; }, subtasks_run)),
+        TASK_CATEGORY_FOREGROUND, 0u /* priority */, 0u /* dependencies */));
+  }
+  runner->ScheduleTasks(token, &graph);
+
+  TaskGraph empty_graph;
+  runner->ScheduleTasks(token, &empty_graph);
+  runner->WaitForTasksToFinishRunning(token);
+  Task::Vector completed_tasks;
+  runner->CollectCompletedTasks(token, &completed_tasks);
+  EXPECT_EQ(8u, completed_tasks.size());
+}
+
+TEST(WorkStealingTaskGraphRunnerTest, WaitFromWorker) {
+  WorkStealingTaskGraphRunner runner;
+  runner.Start(1, "WaitFromWorker", base::SimpleThread::Options());
+  NamespaceToken token = runner.GenerateNamespaceToken();
+
+  int subtasks_run = 0;
+  TaskGraph graph;
+  graph.nodes.push_back(TaskGraph::Node(
+      base::MakeRefCounted<ClosureTask>(base::BindOnce(
+          &ScheduleCancelAndWait, &runner, &subtasks_run)),
+      TASK_CATEGORY_FOREGROUND, 0u /* priority */, 0u /* dependencies */));
+  runner.ScheduleTasks(token, &graph);
+  runner.WaitForTasksToFinishRunning(token);
+  Task::Vector completed_tasks;
+  runner.CollectCompletedTasks(token, &completed_tasks);
+
+  // The only worker was busy waiting, so no subtask could start.
+  EXPECT_EQ(0, subtasks_run);
+
+  runner.Shutdown();
+}
+
+}  // namespace
+}  // namespace cc
@@ -59,7 +59,7 @@ void LayerTreeHostPixelResourceTest::CreateResourceAndRasterBufferProvider(
       EXPECT_EQ(PIXEL_TEST_SOFTWARE, test_type_);
 
       *raster_buffer_provider =
-          BitmapRasterBufferProvider::Create(resource_provider);
+          BitmapRasterBufferProvider::Create(resource_provider, 0u);
       *resource_pool = ResourcePool::Create(
           resource_provider, task_runner, viz::ResourceTextureHint::kDefault,
           ResourcePool::kDefaultExpirationDelay, false);
@@ -165,6 +165,7 @@ void PictureLayerTiling::TakeTilesAndPropertiesFrom(
                        pending_twin->current_soon_border_rect_,
                        pending_twin->current_eventually_rect_,
                        pending_twin->current_occlusion_in_layer_space_);
+  current_scroll_prediction_ = pending_twin->current_scroll_prediction_;
 }
 
 void PictureLayerTiling::SetRasterSourceAndResize(
@@ -927,7 +928,15 @@ TilePriority PictureLayerTiling::ComputePriorityForTile(
       current_content_to_screen_scale_ *
       current_visible_rect_.ManhattanInternalDistance(tile_bounds);
 
-  return TilePriority(resolution_, priority_bin, distance_to_visible);
+  TilePriority priority(resolution_, priority_bin, distance_to_visible);
+  // When raster queues from different layers are merged, tiles that the
+  // predicted scroll brings into view go before the ones it moves away from.
+  if (!current_scroll_prediction_.IsEmpty()) {
+    priority.time_to_visible_in_seconds =
+        current_scroll_prediction_.TimeToVisible(current_visible_rect_,
+                                                 tile_bounds);
+  }
+  return priority;
 }
 
 PictureLayerTiling::PriorityRectType
@@ -19,6 +19,7 @@
 #include "cc/base/tiling_data.h"
 #include "cc/cc_export.h"
 #include "cc/tiles/tile.h"
+#include "cc/tiles/scroll_predictor.h"
 #include "cc/tiles/tile_priority.h"
 #include "cc/trees/occlusion.h"
 #include "ui/gfx/geometry/axis_transform2d.h"
@@ -261,6 +262,13 @@ class CC_EXPORT PictureLayerTiling {
 
   void Reset();
 
+  // Sets the scroll predicted for the visible rect, in layer space, which
+  // orders tiles by when they become visible.
+  void SetScrollPrediction(const ScrollPrediction& prediction_in_layer_space) {
+    current_scroll_prediction_ =
+        prediction_in_layer_space.ScaledBy(raster_transform_.scale());
+  }
+
   void ComputeTilePriorityRects(
       const gfx::Rect& visible_rect_in_layer_space,
       const gfx::Rect& skewport_in_layer_space,
@@ -386,6 +394,8 @@ class CC_EXPORT PictureLayerTiling {
   float current_content_to_screen_scale_ = 0.f;
   Occlusion current_occlusion_in_layer_space_;
   float max_skewport_extent_in_screen_space_ = 0.f;
+  // The predicted scroll in content space.
+  ScrollPrediction current_scroll_prediction_;
 
   bool has_visible_rect_tiles_ = false;
   bool has_skewport_rect_tiles_ = false;
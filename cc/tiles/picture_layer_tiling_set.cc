@@ -15,6 +15,7 @@
 #include "base/trace_event/trace_event.h"
 #include "cc/raster/raster_source.h"
 #include "ui/gfx/geometry/rect_conversions.h"
+#include "ui/gfx/geometry/vector2d_conversions.h"
 
 namespace cc {
 
@@ -397,6 +398,10 @@ bool PictureLayerTilingSet::TilingsNeedUpdate(
   if (state_since_last_tile_priority_update_.added_tilings)
     return true;
 
+  // Tile priorities depend on the predicted scroll.
+  if (state_since_last_tile_priority_update_.scroll_prediction_changed)
+    return true;
+
   // Finally, if some state changed (either frame time or visible rect), then we
   // need to inform the tilings of the change.
   const auto& last_frame = visible_rect_history_.front();
@@ -413,41 +418,61 @@ gfx::Rect PictureLayerTilingSet::ComputeSkewport(
     double current_frame_time_in_seconds,
     float ideal_contents_scale) {
   gfx::Rect skewport = visible_rect_in_layer_space;
-  if (skewport.IsEmpty() || visible_rect_history_.empty())
-    return skewport;
-
-  // Use the oldest recorded history to get a stable skewport.
-  const auto& historical_frame = visible_rect_history_.back();
-  double time_delta =
-      current_frame_time_in_seconds - historical_frame.frame_time_in_seconds;
-  if (time_delta == 0.)
+  if (skewport.IsEmpty())
     return skewport;
 
-  double extrapolation_multiplier =
-      skewport_target_time_in_seconds_ / time_delta;
-  int old_x = historical_frame.visible_rect_in_layer_space.x();
-  int old_y = historical_frame.visible_rect_in_layer_space.y();
-  int old_right = historical_frame.visible_rect_in_layer_space.right();
-  int old_bottom = historical_frame.visible_rect_in_layer_space.bottom();
-
-  int new_x = visible_rect_in_layer_space.x();
-  int new_y = visible_rect_in_layer_space.y();
-  int new_right = visible_rect_in_layer_space.right();
-  int new_bottom = visible_rect_in_layer_space.bottom();
-
-  int inset_x = (new_x - old_x) * extrapolation_multiplier;
-  int inset_y = (new_y - old_y) * extrapolation_multiplier;
-  int inset_right = (old_right - new_right) * extrapolation_multiplier;
-  int inset_bottom = (old_bottom - new_bottom) * extrapolation_multiplier;
-
   int skewport_extrapolation_limit_in_layer_pixels =
       skewport_extrapolation_limit_in_screen_pixels_ / ideal_contents_scale;
   gfx::Rect max_skewport = skewport;
   max_skewport.Inset(-skewport_extrapolation_limit_in_layer_pixels,
                      -skewport_extrapolation_limit_in_layer_pixels);
 
-  skewport.Inset(inset_x, inset_y, inset_right, inset_bottom);
-  skewport.Union(visible_rect_in_layer_space);
+  // Use the oldest recorded history to get a stable skewport.
+  double time_delta = 0.;
+  if (!visible_rect_history_.empty()) {
+    time_delta = current_frame_time_in_seconds -
+                 visible_rect_history_.back().frame_time_in_seconds;
+  }
+  if (time_delta != 0.) {
+    const auto& historical_frame = visible_rect_history_.back();
+    double extrapolation_multiplier =
+        skewport_target_time_in_seconds_ / time_delta;
+    int old_x = historical_frame.visible_rect_in_layer_space.x();
+    int old_y = historical_frame.visible_rect_in_layer_space.y();
+    int old_right = historical_frame.visible_rect_in_layer_space.right();
+    int old_bottom = historical_frame.visible_rect_in_layer_space.bottom();
+
+    int new_x = visible_rect_in_layer_space.x();
+    int new_y = visible_rect_in_layer_space.y();
+    int new_right = visible_rect_in_layer_space.right();
+    int new_bottom = visible_rect_in_layer_space.bottom();
+
+    int inset_x = (new_x - old_x) * extrapolation_multiplier;
+    int inset_y = (new_y - old_y) * extrapolation_multiplier;
+    int inset_right = (old_right - new_right) * extrapolation_multiplier;
+    int inset_bottom = (old_bottom - new_bottom) * extrapolation_multiplier;
+
+    skewport.Inset(inset_x, inset_y, inset_right, inset_bottom);
+    skewport.Union(visible_rect_in_layer_space);
+  }
+
+  // A predicted scroll extends the skewport to where the scroll is going, which
+  // is known before there is any history, and stops at the scroll's end.
+  if (!scroll_prediction_in_layer_space_.IsEmpty()) {
+    gfx::Vector2dF predicted_delta =
+        scroll_prediction_in_layer_space_.DeltaAfter(
+            skewport_target_time_in_seconds_);
+    float limit = skewport_extrapolation_limit_in_layer_pixels;
+    predicted_delta.SetToMax(gfx::Vector2dF(-limit, -limit));
+    predicted_delta.SetToMin(gfx::Vector2dF(limit, limit));
+    gfx::Rect predicted_rect = visible_rect_in_layer_space;
+    predicted_rect.Offset(gfx::ToRoundedVector2d(predicted_delta));
+    skewport.Union(predicted_rect);
+  }
+
+  if (skewport == visible_rect_in_layer_space)
+    return skewport;
+
   skewport.Intersect(max_skewport);
 
   // Due to limits in int's representation, it is possible that the two
@@ -516,6 +541,14 @@ void PictureLayerTilingSet::UpdatePriorityRects(
     visible_rect_history_.pop_back();
 }
 
+void PictureLayerTilingSet::SetScrollPrediction(
+    const ScrollPrediction& prediction_in_layer_space) {
+  if (scroll_prediction_in_layer_space_ == prediction_in_layer_space)
+    return;
+  scroll_prediction_in_layer_space_ = prediction_in_layer_space;
+  state_since_last_tile_priority_update_.scroll_prediction_changed = true;
+}
+
 bool PictureLayerTilingSet::UpdateTilePriorities(
     const gfx::Rect& visible_rect_in_layer_space,
     float ideal_contents_scale,
@@ -536,6 +569,7 @@ bool PictureLayerTilingSet::UpdateTilePriorities(
   for (const auto& tiling : tilings_) {
     tiling->set_can_require_tiles_for_activation(
         can_require_tiles_for_activation);
+    tiling->SetScrollPrediction(scroll_prediction_in_layer_space_);
     tiling->ComputeTilePriorityRects(
         visible_rect_in_layer_space_, skewport_in_layer_space_,
         soon_border_rect_in_layer_space_, eventually_rect_in_layer_space_,
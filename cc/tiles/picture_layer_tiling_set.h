@@ -118,6 +118,10 @@ class CC_EXPORT PictureLayerTilingSet {
   // Remove all tiles; keep all tilings.
   void RemoveAllTiles();
 
+  // Sets where the visible rect is predicted to scroll, in layer space, for
+  // the next UpdateTilePriorities(). Empty if there is no prediction.
+  void SetScrollPrediction(const ScrollPrediction& prediction_in_layer_space);
+
   // Update the rects and priorities for tiles based on the given information.
   // Returns true if PrepareTiles is required.
   bool UpdateTilePriorities(const gfx::Rect& required_rect_in_layer_space,
@@ -206,10 +210,13 @@ class CC_EXPORT PictureLayerTilingSet {
     };
 
     StateSinceLastTilePriorityUpdate()
-        : invalidated(false), added_tilings(false) {}
+        : invalidated(false),
+          added_tilings(false),
+          scroll_prediction_changed(false) {}
 
     bool invalidated;
     bool added_tilings;
+    bool scroll_prediction_changed;
   };
 
   explicit PictureLayerTilingSet(
@@ -257,6 +264,7 @@ class CC_EXPORT PictureLayerTilingSet {
   gfx::Rect skewport_in_layer_space_;
   gfx::Rect soon_border_rect_in_layer_space_;
   gfx::Rect eventually_rect_in_layer_space_;
+  ScrollPrediction scroll_prediction_in_layer_space_;
 
   friend class Iterator;
 
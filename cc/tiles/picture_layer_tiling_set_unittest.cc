@@ -4,6 +4,7 @@
 
 #include "cc/tiles/picture_layer_tiling_set.h"
 
+#include <limits>
 #include <map>
 #include <vector>
 
@@ -686,6 +687,90 @@ TEST(PictureLayerTilingSetTest, ComputeSkewport) {
   EXPECT_EQ(160, expanded_skewport.height());
 }
 
+TEST(PictureLayerTilingSetTest, ComputeSkewportWithScrollPrediction) {
+  FakePictureLayerTilingClient client;
+
+  gfx::Rect viewport(0, 0, 100, 100);
+  gfx::Size layer_bounds(200, 5000);
+  const float kInfinity = std::numeric_limits<float>::infinity();
+
+  client.SetTileSize(gfx::Size(100, 100));
+
+  scoped_refptr<FakeRasterSource> raster_source =
+      FakeRasterSource::CreateFilled(layer_bounds);
+  std::unique_ptr<TestablePictureLayerTilingSet> tiling_set =
+      CreateTilingSet(&client);
+  tiling_set->AddTiling(gfx::AxisTransform2d(), raster_source);
+
+  // A fling extends the skewport before there is any history.
+  tiling_set->SetScrollPrediction(ScrollPrediction(
+      gfx::Vector2dF(0.f, 300.f), gfx::Vector2dF(kInfinity, kInfinity)));
+  tiling_set->UpdateTilePriorities(viewport, 1.f, 1.0, Occlusion(), true);
+  EXPECT_EQ(gfx::Rect(0, 0, 100, 400),
+            tiling_set->ComputeSkewport(viewport, 1.0, 1.f));
+
+  // An animated scroll stops at its target.
+  tiling_set->SetScrollPrediction(ScrollPrediction(
+      gfx::Vector2dF(0.f, 300.f), gfx::Vector2dF(0.f, 120.f)));
+  EXPECT_EQ(gfx::Rect(0, 0, 100, 220),
+            tiling_set->ComputeSkewport(viewport, 1.0, 1.f));
+
+  // The prediction is limited like the extrapolated skewport.
+  tiling_set->SetScrollPrediction(ScrollPrediction(
+      gfx::Vector2dF(0.f, 1e6f), gfx::Vector2dF(kInfinity, kInfinity)));
+  EXPECT_EQ(gfx::Rect(0, 0, 100, 2100),
+            tiling_set->ComputeSkewport(viewport, 1.0, 1.f));
+
+  // Without a prediction there is no skewport until the viewport moves.
+  tiling_set->SetScrollPrediction(ScrollPrediction());
+  EXPECT_EQ(viewport, tiling_set->ComputeSkewport(viewport, 1.0, 1.f));
+}
+
+TEST(PictureLayerTilingSetTest, TimeToVisibleWithScrollPrediction) {
+  FakePictureLayerTilingClient client;
+
+  gfx::Rect viewport(0, 400, 100, 100);
+  gfx::Size layer_bounds(100, 1000);
+  const float kInfinity = std::numeric_limits<float>::infinity();
+
+  client.SetTileSize(gfx::Size(100, 100));
+
+  scoped_refptr<FakeRasterSource> raster_source =
+      FakeRasterSource::CreateFilled(layer_bounds);
+  std::unique_ptr<TestablePictureLayerTilingSet> tiling_set =
+      CreateTilingSet(&client);
+  PictureLayerTiling* tiling =
+      tiling_set->AddTiling(gfx::AxisTransform2d(), raster_source);
+  tiling->set_resolution(HIGH_RESOLUTION);
+  tiling->CreateAllTilesForTesting();
+
+  tiling_set->SetScrollPrediction(ScrollPrediction(
+      gfx::Vector2dF(0.f, 1000.f), gfx::Vector2dF(kInfinity, kInfinity)));
+  EXPECT_TRUE(tiling_set->UpdateTilePriorities(viewport, 1.f, 1.0,
+                                               Occlusion(), true));
+
+  auto prioritized_tiles = tiling->UpdateAndGetAllPrioritizedTilesForTesting();
+  const TilePriority& visible =
+      prioritized_tiles[tiling->TileAt(0, 4)].priority();
+  const TilePriority& ahead =
+      prioritized_tiles[tiling->TileAt(0, 6)].priority();
+  const TilePriority& behind =
+      prioritized_tiles[tiling->TileAt(0, 2)].priority();
+  EXPECT_EQ(TilePriority::NOW, visible.priority_bin);
+  EXPECT_FLOAT_EQ(0.1f, ahead.time_to_visible_in_seconds);
+  EXPECT_EQ(kInfinity, behind.time_to_visible_in_seconds);
+  EXPECT_TRUE(ahead.IsHigherRasterPriorityThan(behind));
+
+  // Changing the prediction alone requires new priorities.
+  tiling_set->SetScrollPrediction(ScrollPrediction());
+  EXPECT_TRUE(tiling_set->UpdateTilePriorities(viewport, 1.f, 1.0,
+                                               Occlusion(), true));
+  prioritized_tiles = tiling->UpdateAndGetAllPrioritizedTilesForTesting();
+  EXPECT_EQ(kInfinity, prioritized_tiles[tiling->TileAt(0, 6)]
+                           .priority()
+                           .time_to_visible_in_seconds);
+}
+
 TEST(PictureLayerTilingSetTest, SkewportThroughUpdateTilePriorities) {
   FakePictureLayerTilingClient client;
 
@@ -50,7 +50,7 @@ class RasterOrderComparator {
       return b_priority.resolution == HIGH_RESOLUTION;
     }
 
-    return b_priority.IsHigherPriorityThan(a_priority);
+    return b_priority.IsHigherRasterPriorityThan(a_priority);
   }
 
  private:
@@ -175,7 +175,7 @@ RasterTilePriorityQueueAll::GetNextQueues() const {
       return pending_queues_;
     }
     case SAME_PRIORITY_FOR_BOTH_TREES: {
-      if (active_priority.IsHigherPriorityThan(pending_priority))
+      if (active_priority.IsHigherRasterPriorityThan(pending_priority))
         return active_queues_;
       return pending_queues_;
     }
@@ -0,0 +1,178 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/tiles/scroll_predictor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "base/logging.h"
+
+namespace cc {
+namespace {
+
+const float kInfinity = std::numeric_limits<float>::infinity();
+
+// Until an animated scroll has ticked, its velocity is estimated by assuming
+// it covers the distance to its target in about the duration of a smooth
+// scroll.
+const float kAnimatedScrollDurationEstimateInSeconds = 0.15f;
+
+// The weight of the newest sample in the velocity estimate.
+const float kVelocitySampleWeight = 0.5f;
+
+// Within this many pixels of its target, a scroll is considered to have
+// reached it.
+const float kTargetEpsilon = 0.5f;
+
+// Computes the time interval during which [begin, end) overlaps
+// [visible_begin, visible_end) while the latter moves at |velocity|.
+void ComputeAxisOverlapInterval(int visible_begin,
+                                int visible_end,
+                                int begin,
+                                int end,
+                                float velocity,
+                                float* enter,
+                                float* exit) {
+  if (velocity == 0.f) {
+    bool overlaps = visible_begin < end && begin < visible_end;
+    *enter = overlaps ? -kInfinity : kInfinity;
+    *exit = overlaps ? kInfinity : -kInfinity;
+    return;
+  }
+  float begins_overlapping = (begin - visible_end) / velocity;
+  float ends_overlapping = (end - visible_begin) / velocity;
+  *enter = std::min(begins_overlapping, ends_overlapping);
+  *exit = std::max(begins_overlapping, ends_overlapping);
+}
+
+float ClampToMagnitude(float value, float magnitude) {
+  return std::max(-magnitude, std::min(value, magnitude));
+}
+
+}  // namespace
+
+ScrollPrediction::ScrollPrediction() = default;
+
+ScrollPrediction::ScrollPrediction(const gfx::Vector2dF& velocity,
+                                   const gfx::Vector2dF& remaining_delta)
+    : velocity(velocity), remaining_delta(remaining_delta) {}
+
+ScrollPrediction ScrollPrediction::ScaledBy(float scale) const {
+  return ScrollPrediction(gfx::ScaleVector2d(velocity, scale),
+                          gfx::ScaleVector2d(remaining_delta, scale));
+}
+
+gfx::Vector2dF ScrollPrediction::DeltaAfter(float seconds) const {
+  return gfx::Vector2dF(
+      ClampToMagnitude(velocity.x() * seconds, std::abs(remaining_delta.x())),
+      ClampToMagnitude(velocity.y() * seconds, std::abs(remaining_delta.y())));
+}
+
+float ScrollPrediction::TimeToVisible(const gfx::Rect& visible_rect,
+                                      const gfx::Rect& rect) const {
+  if (visible_rect.IsEmpty() || rect.IsEmpty())
+    return kInfinity;
+
+  float enter_x, exit_x, enter_y, exit_y;
+  ComputeAxisOverlapInterval(visible_rect.x(), visible_rect.right(), rect.x(),
+                             rect.right(), velocity.x(), &enter_x, &exit_x);
+  ComputeAxisOverlapInterval(visible_rect.y(), visible_rect.bottom(), rect.y(),
+                             rect.bottom(), velocity.y(), &enter_y, &exit_y);
+
+  float enter = std::max({enter_x, enter_y, 0.f});
+  float exit = std::min(exit_x, exit_y);
+  if (enter >= exit)
+    return kInfinity;
+
+  // The scroll has to get there before it stops.
+  if (std::abs(velocity.x()) * enter >
+          std::abs(remaining_delta.x()) + kTargetEpsilon ||
+      std::abs(velocity.y()) * enter >
+          std::abs(remaining_delta.y()) + kTargetEpsilon) {
+    return kInfinity;
+  }
+  return enter;
+}
+
+ScrollPredictor::ScrollPredictor() = default;
+
+ScrollPredictor::~ScrollPredictor() = default;
+
+void ScrollPredictor::SetScrollAnimationTarget(
+    int scroll_node_id,
+    const gfx::ScrollOffset& current_offset,
+    const gfx::ScrollOffset& target_offset) {
+  if (scroll_node_id != scroll_node_id_)
+    Reset();
+  scroll_node_id_ = scroll_node_id;
+  has_target_offset_ = true;
+  target_offset_ = target_offset;
+  if (!has_sample_)
+    last_offset_ = current_offset;
+}
+
+void ScrollPredictor::StartFling(int scroll_node_id) {
+  if (scroll_node_id == scroll_node_id_ && !has_target_offset_)
+    return;
+  Reset();
+  scroll_node_id_ = scroll_node_id;
+}
+
+void ScrollPredictor::Reset() {
+  scroll_node_id_ = kInvalidNodeId;
+  has_target_offset_ = false;
+  target_offset_ = gfx::ScrollOffset();
+  has_sample_ = false;
+  last_offset_ = gfx::ScrollOffset();
+  last_frame_time_ = base::TimeTicks();
+  velocity_ = gfx::Vector2dF();
+}
+
+void ScrollPredictor::AddScrollOffsetSample(const gfx::ScrollOffset& offset,
+                                            base::TimeTicks frame_time) {
+  DCHECK(is_predicting());
+  if (has_sample_) {
+    double seconds = (frame_time - last_frame_time_).InSecondsF();
+    if (seconds <= 0.)
+      return;
+    gfx::Vector2dF sample_velocity =
+        gfx::ScaleVector2d(offset.DeltaFrom(last_offset_), 1.f / seconds);
+    velocity_ = velocity_.IsZero()
+                    ? sample_velocity
+                    : gfx::ScaleVector2d(sample_velocity,
+                                         kVelocitySampleWeight) +
+                          gfx::ScaleVector2d(velocity_,
+                                             1.f - kVelocitySampleWeight);
+  }
+  has_sample_ = true;
+  last_offset_ = offset;
+  last_frame_time_ = frame_time;
+}
+
+ScrollPrediction ScrollPredictor::GetPrediction() const {
+  if (!is_predicting())
+    return ScrollPrediction();
+
+  if (!has_target_offset_)
+    return ScrollPrediction(velocity_, gfx::Vector2dF(kInfinity, kInfinity));
+
+  gfx::Vector2dF remaining_delta = target_offset_.DeltaFrom(last_offset_);
+  if (std::abs(remaining_delta.x()) < kTargetEpsilon &&
+      std::abs(remaining_delta.y()) < kTargetEpsilon) {
+    return ScrollPrediction();
+  }
+
+  // The animation heads towards its target, even if it was just retargeted in
+  // the opposite direction.
+  gfx::Vector2dF velocity = velocity_;
+  if (gfx::DotProduct(velocity, remaining_delta) <= 0.f) {
+    velocity = gfx::ScaleVector2d(
+        remaining_delta, 1.f / kAnimatedScrollDurationEstimateInSeconds);
+  }
+  return ScrollPrediction(velocity, remaining_delta);
+}
+
+}  // namespace cc
@@ -0,0 +1,104 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CC_TILES_SCROLL_PREDICTOR_H_
+#define CC_TILES_SCROLL_PREDICTOR_H_
+
+#include "base/macros.h"
+#include "base/time/time.h"
+#include "cc/cc_export.h"
+#include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/geometry/scroll_offset.h"
+#include "ui/gfx/geometry/vector2d_f.h"
+
+namespace cc {
+
+// Where a scroll is predicted to go, in the space of the scrolled contents.
+struct CC_EXPORT ScrollPrediction {
+  ScrollPrediction();
+  ScrollPrediction(const gfx::Vector2dF& velocity,
+                   const gfx::Vector2dF& remaining_delta);
+
+  bool IsEmpty() const { return velocity.IsZero(); }
+
+  // Returns the prediction in a space that is |scale| times the current one.
+  ScrollPrediction ScaledBy(float scale) const;
+
+  // Returns the predicted scroll delta after |seconds|, which doesn't go past
+  // |remaining_delta|.
+  gfx::Vector2dF DeltaAfter(float seconds) const;
+
+  // Returns the time in seconds until |rect| intersects |visible_rect| as it
+  // scrolls, 0 if they already intersect, or infinity if the scroll stops or
+  // goes past |rect| before that.
+  float TimeToVisible(const gfx::Rect& visible_rect,
+                      const gfx::Rect& rect) const;
+
+  bool operator==(const ScrollPrediction& other) const {
+    return velocity == other.velocity &&
+           remaining_delta == other.remaining_delta;
+  }
+  bool operator!=(const ScrollPrediction& other) const {
+    return !(*this == other);
+  }
+
+  // In pixels per second.
+  gfx::Vector2dF velocity;
+  // How far the scroll goes before it stops. Flings have no known end, so
+  // their components are infinite.
+  gfx::Vector2dF remaining_delta;
+};
+
+// Predicts the motion of the currently scrolling node during impl-side scroll
+// animations and flings. Animated scrolls have a known target, while flings
+// are extrapolated from their observed velocity until they end. Used to
+// prioritize tiles by when they become visible, ahead of the finite difference
+// skewport in PictureLayerTilingSet.
+class CC_EXPORT ScrollPredictor {
+ public:
+  ScrollPredictor();
+  ~ScrollPredictor();
+
+  // Starts, or updates, the prediction for an animated scroll of
+  // |scroll_node_id| from |current_offset| to |target_offset|.
+  void SetScrollAnimationTarget(int scroll_node_id,
+                                const gfx::ScrollOffset& current_offset,
+                                const gfx::ScrollOffset& target_offset);
+  // Starts the prediction for a fling of |scroll_node_id|.
+  void StartFling(int scroll_node_id);
+  // Stops predicting, once the scroll has ended.
+  void Reset();
+
+  // Records the scroll offset of the predicted node at |frame_time|. Called
+  // once per frame, after scroll animations and flings have ticked.
+  void AddScrollOffsetSample(const gfx::ScrollOffset& offset,
+                             base::TimeTicks frame_time);
+
+  bool is_predicting() const { return scroll_node_id_ != kInvalidNodeId; }
+  int scroll_node_id() const { return scroll_node_id_; }
+  bool has_target_offset() const { return has_target_offset_; }
+  const gfx::ScrollOffset& target_offset() const { return target_offset_; }
+
+  // The prediction from the latest samples, empty if there isn't one.
+  ScrollPrediction GetPrediction() const;
+
+ private:
+  // Matches PropertyTree<T>::kInvalidNodeId.
+  static const int kInvalidNodeId = -1;
+
+  int scroll_node_id_ = kInvalidNodeId;
+  bool has_target_offset_ = false;
+  gfx::ScrollOffset target_offset_;
+
+  bool has_sample_ = false;
+  gfx::ScrollOffset last_offset_;
+  base::TimeTicks last_frame_time_;
+  gfx::Vector2dF velocity_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScrollPredictor);
+};
+
+}  // namespace cc
+
+#endif  // CC_TILES_SCROLL_PREDICTOR_H_
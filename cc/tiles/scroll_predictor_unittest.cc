@@ -0,0 +1,136 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/tiles/scroll_predictor.h"
+
+#include <limits>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace cc {
+namespace {
+
+const float kInfinity = std::numeric_limits<float>::infinity();
+
+base::TimeTicks FrameTime(int frame) {
+  return base::TimeTicks() + base::TimeDelta::FromMilliseconds(16 * frame);
+}
+
+TEST(ScrollPredictionTest, DeltaAfterStopsAtRemainingDelta) {
+  ScrollPrediction prediction(gfx::Vector2dF(1000.f, -500.f),
+                              gfx::Vector2dF(300.f, -400.f));
+  EXPECT_EQ(gfx::Vector2dF(100.f, -50.f), prediction.DeltaAfter(0.1f));
+  EXPECT_EQ(gfx::Vector2dF(300.f, -400.f), prediction.DeltaAfter(1.f));
+
+  ScrollPrediction fling(gfx::Vector2dF(0.f, 2000.f),
+                         gfx::Vector2dF(kInfinity, kInfinity));
+  EXPECT_EQ(gfx::Vector2dF(0.f, 2000.f), fling.DeltaAfter(1.f));
+}
+
+TEST(ScrollPredictionTest, TimeToVisible) {
+  gfx::Rect visible_rect(0, 0, 100, 100);
+  ScrollPrediction prediction(gfx::Vector2dF(0.f, 1000.f),
+                              gfx::Vector2dF(kInfinity, kInfinity));
+
+  // Already visible.
+  EXPECT_EQ(0.f, prediction.TimeToVisible(visible_rect,
+                                          gfx::Rect(50, 50, 10, 10)));
+  // Ahead of the scroll.
+  EXPECT_FLOAT_EQ(0.1f, prediction.TimeToVisible(visible_rect,
+                                                 gfx::Rect(0, 200, 10, 10)));
+  // Behind the scroll.
+  EXPECT_EQ(kInfinity, prediction.TimeToVisible(visible_rect,
+                                                gfx::Rect(0, -200, 10, 10)));
+  // Beside the scroll.
+  EXPECT_EQ(kInfinity, prediction.TimeToVisible(visible_rect,
+                                                gfx::Rect(200, 200, 10, 10)));
+
+  // Diagonal scrolls have to line up on both axes.
+  ScrollPrediction diagonal(gfx::Vector2dF(1000.f, 1000.f),
+                            gfx::Vector2dF(kInfinity, kInfinity));
+  EXPECT_FLOAT_EQ(0.2f, diagonal.TimeToVisible(visible_rect,
+                                               gfx::Rect(200, 300, 10, 10)));
+  EXPECT_EQ(kInfinity, diagonal.TimeToVisible(visible_rect,
+                                              gfx::Rect(500, 0, 10, 10)));
+
+  // The scroll stops before getting there.
+  ScrollPrediction animation(gfx::Vector2dF(0.f, 1000.f),
+                             gfx::Vector2dF(0.f, 50.f));
+  EXPECT_FLOAT_EQ(0.04f, animation.TimeToVisible(visible_rect,
+                                                 gfx::Rect(0, 140, 10, 10)));
+  EXPECT_EQ(kInfinity, animation.TimeToVisible(visible_rect,
+                                               gfx::Rect(0, 200, 10, 10)));
+}
+
+TEST(ScrollPredictorTest, Fling) {
+  ScrollPredictor predictor;
+  EXPECT_FALSE(predictor.is_predicting());
+  EXPECT_TRUE(predictor.GetPrediction().IsEmpty());
+
+  predictor.StartFling(3);
+  EXPECT_TRUE(predictor.is_predicting());
+  EXPECT_EQ(3, predictor.scroll_node_id());
+  EXPECT_FALSE(predictor.has_target_offset());
+
+  // No velocity until the fling has moved.
+  predictor.AddScrollOffsetSample(gfx::ScrollOffset(0, 0), FrameTime(0));
+  EXPECT_TRUE(predictor.GetPrediction().IsEmpty());
+
+  predictor.AddScrollOffsetSample(gfx::ScrollOffset(0, 32), FrameTime(1));
+  ScrollPrediction prediction = predictor.GetPrediction();
+  EXPECT_FLOAT_EQ(0.f, prediction.velocity.x());
+  EXPECT_FLOAT_EQ(2000.f, prediction.velocity.y());
+  EXPECT_EQ(kInfinity, prediction.remaining_delta.y());
+
+  // The velocity follows the fling as it slows down.
+  predictor.AddScrollOffsetSample(gfx::ScrollOffset(0, 48), FrameTime(2));
+  EXPECT_FLOAT_EQ(1500.f, predictor.GetPrediction().velocity.y());
+
+  // Flinging again keeps the samples.
+  predictor.StartFling(3);
+  EXPECT_FLOAT_EQ(1500.f, predictor.GetPrediction().velocity.y());
+
+  predictor.Reset();
+  EXPECT_FALSE(predictor.is_predicting());
+  EXPECT_TRUE(predictor.GetPrediction().IsEmpty());
+}
+
+TEST(ScrollPredictorTest, ScrollAnimation) {
+  ScrollPredictor predictor;
+  predictor.SetScrollAnimationTarget(1, gfx::ScrollOffset(0, 100),
+                                     gfx::ScrollOffset(0, 400));
+  EXPECT_TRUE(predictor.has_target_offset());
+
+  // Before the animation ticks, the velocity is estimated from the target.
+  ScrollPrediction prediction = predictor.GetPrediction();
+  EXPECT_GT(prediction.velocity.y(), 0.f);
+  EXPECT_EQ(gfx::Vector2dF(0.f, 300.f), prediction.remaining_delta);
+
+  predictor.AddScrollOffsetSample(gfx::ScrollOffset(0, 100), FrameTime(0));
+  predictor.AddScrollOffsetSample(gfx::ScrollOffset(0, 180), FrameTime(1));
+  prediction = predictor.GetPrediction();
+  EXPECT_FLOAT_EQ(5000.f, prediction.velocity.y());
+  EXPECT_EQ(gfx::Vector2dF(0.f, 220.f), prediction.remaining_delta);
+
+  // Retargeting in the opposite direction turns the prediction around.
+  predictor.SetScrollAnimationTarget(1, gfx::ScrollOffset(0, 180),
+                                     gfx::ScrollOffset(0, 0));
+  prediction = predictor.GetPrediction();
+  EXPECT_LT(prediction.velocity.y(), 0.f);
+  EXPECT_EQ(gfx::Vector2dF(0.f, -180.f), prediction.remaining_delta);
+
+  // Nothing is predicted once the target is reached.
+  predictor.AddScrollOffsetSample(gfx::ScrollOffset(0, 0), FrameTime(2));
+  EXPECT_TRUE(predictor.GetPrediction().IsEmpty());
+
+  // Animating another node starts over.
+  predictor.SetScrollAnimationTarget(2, gfx::ScrollOffset(0, 0),
+                                     gfx::ScrollOffset(100, 0));
+  EXPECT_EQ(2, predictor.scroll_node_id());
+  EXPECT_EQ(gfx::Vector2dF(100.f, 0.f),
+            predictor.GetPrediction().remaining_delta);
+}
+
+}  // namespace
+}  // namespace cc
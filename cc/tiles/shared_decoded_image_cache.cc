@@ -0,0 +1,161 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/tiles/shared_decoded_image_cache.h"
+
+#include <utility>
+
+#include "base/lazy_instance.h"
+#include "base/memory/memory_coordinator_client_registry.h"
+#include "base/metrics/histogram_macros.h"
+#include "base/trace_event/trace_event.h"
+
+namespace cc {
+namespace {
+
+// Note that it's important not to reorder the following enums, since the
+// numerical values are used in the histogram code.
+enum LookupResult {
+  LOOKUP_RESULT_HIT,
+  LOOKUP_RESULT_MISS,
+  // The decode was found, but its discardable memory had been purged.
+  LOOKUP_RESULT_MISS_PURGED,
+  // The decode was found, but in a different color type than requested.
+  LOOKUP_RESULT_MISS_COLOR_TYPE,
+  LOOKUP_RESULT_COUNT
+};
+
+void RecordLookupResult(LookupResult result) {
+  UMA_HISTOGRAM_ENUMERATION("Renderer4.SharedDecodedImageCache.Lookup", result,
+                            LOOKUP_RESULT_COUNT);
+}
+
+struct SharedDecodedImageCacheTraits
+    : public base::internal::LeakyLazyInstanceTraits<SharedDecodedImageCache> {
+  static SharedDecodedImageCache* New(void* instance) {
+    return new (instance)
+        SharedDecodedImageCache(SharedDecodedImageCache::kDefaultMaxBytes);
+  }
+};
+
+base::LazyInstance<SharedDecodedImageCache, SharedDecodedImageCacheTraits>
+    g_shared_cache = LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+// static
+const size_t SharedDecodedImageCache::kDefaultMaxBytes = 64 * 1024 * 1024;
+
+SharedDecodedImageCache::Entry::Entry() = default;
+
+SharedDecodedImageCache::Entry::Entry(
+    const SkImageInfo& info,
+    std::unique_ptr<base::DiscardableMemory> memory,
+    const SkSize& src_rect_offset)
+    : info(info), memory(std::move(memory)), src_rect_offset(src_rect_offset) {}
+
+SharedDecodedImageCache::Entry::Entry(Entry&& other) = default;
+
+SharedDecodedImageCache::Entry::~Entry() = default;
+
+SharedDecodedImageCache::Entry& SharedDecodedImageCache::Entry::operator=(
+    Entry&& other) = default;
+
+// static
+SharedDecodedImageCache* SharedDecodedImageCache::GetInstance() {
+  return g_shared_cache.Pointer();
+}
+
+SharedDecodedImageCache::SharedDecodedImageCache(size_t max_bytes)
+    : max_bytes_(max_bytes), entries_(EntryMRUCache::NO_AUTO_EVICT) {
+  base::MemoryCoordinatorClientRegistry::GetInstance()->Register(this);
+}
+
+SharedDecodedImageCache::~SharedDecodedImageCache() {
+  base::MemoryCoordinatorClientRegistry::GetInstance()->Unregister(this);
+}
+
+void SharedDecodedImageCache::Retain(const ImageDecodeCacheKey& key,
+                                     Entry entry) {
+  DCHECK(entry.memory);
+  size_t entry_bytes = entry.size_in_bytes();
+  // Don't evict the whole cache for a decode that can never fit.
+  if (entry_bytes > max_bytes_)
+    return;
+
+  base::AutoLock lock(lock_);
+  auto it = entries_.Peek(key);
+  if (it != entries_.end()) {
+    bytes_ -= it->second.size_in_bytes();
+    entries_.Erase(it);
+  }
+  EvictUntilWithinLimit(max_bytes_ - entry_bytes);
+  entries_.Put(key, std::move(entry));
+  bytes_ += entry_bytes;
+}
+
+SharedDecodedImageCache::Entry SharedDecodedImageCache::TakeLocked(
+    const ImageDecodeCacheKey& key,
+    SkColorType color_type) {
+  TRACE_EVENT0(TRACE_DISABLED_BY_DEFAULT("cc.debug"),
+               "SharedDecodedImageCache::TakeLocked");
+  Entry entry;
+  {
+    base::AutoLock lock(lock_);
+    auto it = entries_.Peek(key);
+    if (it == entries_.end()) {
+      RecordLookupResult(LOOKUP_RESULT_MISS);
+      return Entry();
+    }
+    if (it->second.info.colorType() != color_type) {
+      RecordLookupResult(LOOKUP_RESULT_MISS_COLOR_TYPE);
+      return Entry();
+    }
+    entry = std::move(it->second);
+    bytes_ -= entry.size_in_bytes();
+    entries_.Erase(it);
+  }
+
+  // Locking can be slow, and the entry is no longer shared, so do it without
+  // holding the lock.
+  if (!entry.memory->Lock()) {
+    RecordLookupResult(LOOKUP_RESULT_MISS_PURGED);
+    return Entry();
+  }
+  RecordLookupResult(LOOKUP_RESULT_HIT);
+  return entry;
+}
+
+size_t SharedDecodedImageCache::GetNumEntriesForTesting() const {
+  base::AutoLock lock(lock_);
+  return entries_.size();
+}
+
+size_t SharedDecodedImageCache::GetBytesForTesting() const {
+  base::AutoLock lock(lock_);
+  return bytes_;
+}
+
+void SharedDecodedImageCache::EvictUntilWithinLimit(size_t max_bytes) {
+  lock_.AssertAcquired();
+  for (auto it = entries_.rbegin(); bytes_ > max_bytes;) {
+    DCHECK(it != entries_.rend());
+    bytes_ -= it->second.size_in_bytes();
+    it = entries_.Erase(it);
+  }
+}
+
+void SharedDecodedImageCache::OnMemoryStateChange(base::MemoryState state) {
+  if (state == base::MemoryState::THROTTLED ||
+      state == base::MemoryState::SUSPENDED) {
+    OnPurgeMemory();
+  }
+}
+
+void SharedDecodedImageCache::OnPurgeMemory() {
+  base::AutoLock lock(lock_);
+  EvictUntilWithinLimit(0u);
+}
+
+}  // namespace cc
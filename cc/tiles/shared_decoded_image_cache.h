@@ -0,0 +1,107 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CC_TILES_SHARED_DECODED_IMAGE_CACHE_H_
+#define CC_TILES_SHARED_DECODED_IMAGE_CACHE_H_
+
+#include <stddef.h>
+
+#include <memory>
+
+#include "base/containers/mru_cache.h"
+#include "base/macros.h"
+#include "base/memory/discardable_memory.h"
+#include "base/memory/memory_coordinator_client.h"
+#include "base/synchronization/lock.h"
+#include "cc/cc_export.h"
+#include "cc/tiles/software_image_decode_cache.h"
+#include "third_party/skia/include/core/SkImageInfo.h"
+#include "third_party/skia/include/core/SkSize.h"
+
+namespace cc {
+
+// SharedDecodedImageCache holds on to software decodes that a
+// SoftwareImageDecodeCache no longer wants, so that they can be picked up
+// again by any SoftwareImageDecodeCache in the process. This lets decodes
+// survive a navigation (which clears the tree's cache) or the teardown of a
+// LayerTreeHostImpl, e.g. on back/forward navigations and tab switches.
+//
+// Decodes are keyed by ImageDecodeCacheKey, which identifies the image by its
+// PaintImage content id along with the decoded scale, subrect, filter quality
+// and color space. They are kept unlocked in discardable memory (backed by
+// DiscardableSharedMemory in the renderer), so the system can still reclaim
+// them under memory pressure; the byte budget only bounds how much this cache
+// holds on to. A decode is owned by at most one cache at a time: taking it out
+// of this cache hands it back to the caller.
+//
+// This class is thread safe.
+class CC_EXPORT SharedDecodedImageCache : public base::MemoryCoordinatorClient {
+ public:
+  // An unlocked decode, as stored in this cache.
+  struct CC_EXPORT Entry {
+    Entry();
+    Entry(const SkImageInfo& info,
+          std::unique_ptr<base::DiscardableMemory> memory,
+          const SkSize& src_rect_offset);
+    Entry(Entry&& other);
+    ~Entry();
+
+    Entry& operator=(Entry&& other);
+
+    size_t size_in_bytes() const {
+      return info.minRowBytes() * info.height();
+    }
+
+    SkImageInfo info;
+    std::unique_ptr<base::DiscardableMemory> memory;
+    SkSize src_rect_offset;
+  };
+
+  // The budget of the process-wide instance.
+  static const size_t kDefaultMaxBytes;
+
+  // Returns the process-wide instance, which is created on first use and is
+  // never destroyed.
+  static SharedDecodedImageCache* GetInstance();
+
+  explicit SharedDecodedImageCache(size_t max_bytes);
+  ~SharedDecodedImageCache() override;
+
+  // Takes ownership of the unlocked decode in |entry|. If this cache goes over
+  // its budget, the least recently retained decodes are dropped.
+  void Retain(const ImageDecodeCacheKey& key, Entry entry);
+
+  // If this cache has a decode for |key| in |color_type| that can still be
+  // locked, removes it from the cache and returns it locked. Otherwise,
+  // returns an entry with no memory.
+  Entry TakeLocked(const ImageDecodeCacheKey& key, SkColorType color_type);
+
+  size_t GetNumEntriesForTesting() const;
+  size_t GetBytesForTesting() const;
+
+ private:
+  using EntryMRUCache = base::
+      HashingMRUCache<ImageDecodeCacheKey, Entry, ImageDecodeCacheKeyHash>;
+
+  // Drops the least recently retained decodes until at most |max_bytes| are
+  // held.
+  void EvictUntilWithinLimit(size_t max_bytes);
+
+  // base::MemoryCoordinatorClient overrides.
+  void OnMemoryStateChange(base::MemoryState state) override;
+  void OnPurgeMemory() override;
+
+  const size_t max_bytes_;
+
+  // The members below can only be accessed if |lock_| is held.
+  mutable base::Lock lock_;
+  EntryMRUCache entries_;
+  size_t bytes_ = 0u;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedDecodedImageCache);
+};
+
+}  // namespace cc
+
+#endif  // CC_TILES_SHARED_DECODED_IMAGE_CACHE_H_
@@ -0,0 +1,118 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/tiles/shared_decoded_image_cache.h"
+
+#include <vector>
+
+#include "base/memory/discardable_memory_allocator.h"
+#include "cc/paint/draw_image.h"
+#include "cc/test/skia_common.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace cc {
+namespace {
+
+const size_t kImageBytes = 4 * 10 * 10;
+
+DrawImage CreateDrawImage() {
+  PaintImage paint_image = CreateDiscardablePaintImage(gfx::Size(10, 10));
+  return DrawImage(paint_image, SkIRect::MakeWH(10, 10), kLow_SkFilterQuality,
+                   SkMatrix::I(), PaintImage::kDefaultFrameIndex,
+                   gfx::ColorSpace::CreateSRGB());
+}
+
+ImageDecodeCacheKey CreateKey(const DrawImage& draw_image) {
+  return ImageDecodeCacheKey::FromDrawImage(draw_image, kN32_SkColorType);
+}
+
+SharedDecodedImageCache::Entry CreateUnlockedEntry(SkColorType color_type) {
+  SkImageInfo info = SkImageInfo::Make(10, 10, color_type, kPremul_SkAlphaType);
+  std::unique_ptr<base::DiscardableMemory> memory =
+      base::DiscardableMemoryAllocator::GetInstance()
+          ->AllocateLockedDiscardableMemory(kImageBytes);
+  memory->Unlock();
+  return SharedDecodedImageCache::Entry(info, std::move(memory),
+                                        SkSize::Make(0, 0));
+}
+
+TEST(SharedDecodedImageCacheTest, RetainAndTake) {
+  SharedDecodedImageCache cache(10 * kImageBytes);
+  DrawImage draw_image = CreateDrawImage();
+  ImageDecodeCacheKey key = CreateKey(draw_image);
+
+  EXPECT_FALSE(cache.TakeLocked(key, kN32_SkColorType).memory);
+
+  cache.Retain(key, CreateUnlockedEntry(kN32_SkColorType));
+  EXPECT_EQ(1u, cache.GetNumEntriesForTesting());
+  EXPECT_EQ(kImageBytes, cache.GetBytesForTesting());
+
+  SharedDecodedImageCache::Entry entry =
+      cache.TakeLocked(key, kN32_SkColorType);
+  ASSERT_TRUE(entry.memory);
+  EXPECT_EQ(10, entry.info.width());
+  entry.memory->Unlock();
+
+  // Taking a decode removes it from the cache.
+  EXPECT_EQ(0u, cache.GetNumEntriesForTesting());
+  EXPECT_EQ(0u, cache.GetBytesForTesting());
+  EXPECT_FALSE(cache.TakeLocked(key, kN32_SkColorType).memory);
+}
+
+TEST(SharedDecodedImageCacheTest, ColorTypeMismatch) {
+  SharedDecodedImageCache cache(10 * kImageBytes);
+  DrawImage draw_image = CreateDrawImage();
+  ImageDecodeCacheKey key = CreateKey(draw_image);
+
+  cache.Retain(key, CreateUnlockedEntry(kN32_SkColorType));
+  EXPECT_FALSE(cache.TakeLocked(key, kARGB_4444_SkColorType).memory);
+  // The decode is still available for the right color type.
+  EXPECT_EQ(1u, cache.GetNumEntriesForTesting());
+  SharedDecodedImageCache::Entry entry =
+      cache.TakeLocked(key, kN32_SkColorType);
+  ASSERT_TRUE(entry.memory);
+  entry.memory->Unlock();
+}
+
+TEST(SharedDecodedImageCacheTest, EvictsLeastRecentlyRetained) {
+  SharedDecodedImageCache cache(2 * kImageBytes);
+  std::vector<DrawImage> draw_images;
+  for (int i = 0; i < 3; ++i) {
+    draw_images.push_back(CreateDrawImage());
+    cache.Retain(CreateKey(draw_images.back()),
+                 CreateUnlockedEntry(kN32_SkColorType));
+  }
+  EXPECT_EQ(2u, cache.GetNumEntriesForTesting());
+  EXPECT_EQ(2 * kImageBytes, cache.GetBytesForTesting());
+
+  EXPECT_FALSE(
+      cache.TakeLocked(CreateKey(draw_images[0]), kN32_SkColorType).memory);
+  for (int i = 1; i < 3; ++i) {
+    SharedDecodedImageCache::Entry entry =
+        cache.TakeLocked(CreateKey(draw_images[i]), kN32_SkColorType);
+    ASSERT_TRUE(entry.memory);
+    entry.memory->Unlock();
+  }
+}
+
+TEST(SharedDecodedImageCacheTest, IgnoresDecodesLargerThanBudget) {
+  SharedDecodedImageCache cache(kImageBytes / 2);
+  DrawImage draw_image = CreateDrawImage();
+  cache.Retain(CreateKey(draw_image), CreateUnlockedEntry(kN32_SkColorType));
+  EXPECT_EQ(0u, cache.GetNumEntriesForTesting());
+}
+
+TEST(SharedDecodedImageCacheTest, RetainReplacesExistingDecode) {
+  SharedDecodedImageCache cache(10 * kImageBytes);
+  DrawImage draw_image = CreateDrawImage();
+  ImageDecodeCacheKey key = CreateKey(draw_image);
+
+  cache.Retain(key, CreateUnlockedEntry(kN32_SkColorType));
+  cache.Retain(key, CreateUnlockedEntry(kN32_SkColorType));
+  EXPECT_EQ(1u, cache.GetNumEntriesForTesting());
+  EXPECT_EQ(kImageBytes, cache.GetBytesForTesting());
+}
+
+}  // namespace
+}  // namespace cc
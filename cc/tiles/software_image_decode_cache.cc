@@ -23,6 +23,7 @@
 #include "cc/base/histograms.h"
 #include "cc/raster/tile_task.h"
 #include "cc/tiles/mipmap_util.h"
+#include "cc/tiles/shared_decoded_image_cache.h"
 #include "third_party/skia/include/core/SkCanvas.h"
 #include "third_party/skia/include/core/SkImage.h"
 #include "third_party/skia/include/core/SkPixmap.h"
@@ -191,14 +192,28 @@ gfx::Rect GetSrcRect(const DrawImage& image) {
 
 }  // namespace
 
+// static
+constexpr size_t SoftwareImageDecodeCache::kDefaultNumShards;
+
 SoftwareImageDecodeCache::SoftwareImageDecodeCache(
     SkColorType color_type,
     size_t locked_memory_limit_bytes)
-    : decoded_images_(ImageMRUCache::NO_AUTO_EVICT),
-      at_raster_decoded_images_(ImageMRUCache::NO_AUTO_EVICT),
-      locked_images_budget_(locked_memory_limit_bytes),
+    : SoftwareImageDecodeCache(color_type,
+                               locked_memory_limit_bytes,
+                               kDefaultNumShards) {}
+
+SoftwareImageDecodeCache::SoftwareImageDecodeCache(
+    SkColorType color_type,
+    size_t locked_memory_limit_bytes,
+    size_t num_shards)
+    : locked_images_budget_(locked_memory_limit_bytes),
       color_type_(color_type),
       max_items_in_cache_(kNormalMaxItemsInCacheForSoftware) {
+  DCHECK_GT(num_shards, 0u);
+  shards_.reserve(num_shards);
+  for (size_t i = 0; i < num_shards; ++i)
+    shards_.push_back(std::make_unique<CacheShard>());
+
   // In certain cases, ThreadTaskRunnerHandle isn't set (Android Webview).
   // Don't register a dump provider in these cases.
   if (base::ThreadTaskRunnerHandle::IsSet()) {
@@ -212,8 +227,23 @@ SoftwareImageDecodeCache::SoftwareImageDecodeCache(
 
 SoftwareImageDecodeCache::~SoftwareImageDecodeCache() {
   // Debugging crbug.com/650234
-  CHECK_EQ(0u, decoded_images_ref_counts_.size());
-  CHECK_EQ(0u, at_raster_decoded_images_ref_counts_.size());
+  for (const auto& shard : shards_) {
+    CHECK_EQ(0u, shard->decoded_images_ref_counts.size());
+    CHECK_EQ(0u, shard->at_raster_decoded_images_ref_counts.size());
+  }
+
+  // Keep the decodes we still have around for other trees in this process.
+  if (shared_decoded_image_cache_) {
+    for (const auto& shard : shards_) {
+      base::AutoLock lock(shard->lock);
+      for (auto it = shard->decoded_images.rbegin();
+           it != shard->decoded_images.rend();) {
+        if (!it->second->is_locked())
+          RetainInSharedCache(it->first, std::move(it->second));
+        it = shard->decoded_images.Erase(it);
+      }
+    }
+  }
 
   // It is safe to unregister, even if we didn't register in the constructor.
   base::trace_event::MemoryDumpManager::GetInstance()->UnregisterDumpProvider(
@@ -272,17 +302,18 @@ SoftwareImageDecodeCache::GetTaskForImageAndRefInternal(
     return TaskResult(false);
   }
 
-  base::AutoLock lock(lock_);
+  CacheShard* shard = GetShard(key.frame_key());
+  base::AutoLock lock(shard->lock);
 
   // If we already have the image in cache, then we can return it.
-  auto decoded_it = decoded_images_.Get(key);
+  auto decoded_it = shard->decoded_images.Get(key);
   bool new_image_fits_in_memory =
       locked_images_budget_.AvailableMemoryBytes() >= key.locked_bytes();
-  if (decoded_it != decoded_images_.end()) {
+  if (decoded_it != shard->decoded_images.end()) {
     bool image_was_locked = decoded_it->second->is_locked();
     if (image_was_locked ||
         (new_image_fits_in_memory && decoded_it->second->Lock())) {
-      RefImage(key);
+      RefImage(shard, key);
 
       // If the image wasn't locked, then we just succeeded in locking it.
       if (!image_was_locked) {
@@ -297,7 +328,7 @@ SoftwareImageDecodeCache::GetTaskForImageAndRefInternal(
     if (new_image_fits_in_memory) {
       RecordLockExistingCachedImageHistogram(tracing_info.requesting_tile_bin,
                                              false);
-      CleanupDecodedImagesCache(key, decoded_it);
+      CleanupDecodedImagesCache(shard, key, decoded_it);
     }
   }
 
@@ -308,10 +339,10 @@ SoftwareImageDecodeCache::GetTaskForImageAndRefInternal(
   // is set to nullptr above).
   scoped_refptr<TileTask>& existing_task =
       (task_type == DecodeTaskType::USE_IN_RASTER_TASKS)
-          ? pending_in_raster_image_tasks_[key]
-          : pending_out_of_raster_image_tasks_[key];
+          ? shard->pending_in_raster_image_tasks[key]
+          : shard->pending_out_of_raster_image_tasks[key];
   if (existing_task) {
-    RefImage(key);
+    RefImage(shard, key);
     return TaskResult(existing_task);
   }
 
@@ -320,24 +351,26 @@ SoftwareImageDecodeCache::GetTaskForImageAndRefInternal(
   // would have already accounted for memory. The latter part is possible if
   // there's a running raster task that could not be canceled, and still has a
   // ref to the image that is now being reffed for the new schedule.
-  if (!new_image_fits_in_memory && (decoded_images_ref_counts_.find(key) ==
-                                    decoded_images_ref_counts_.end())) {
+  if (!new_image_fits_in_memory &&
+      (shard->decoded_images_ref_counts.find(key) ==
+       shard->decoded_images_ref_counts.end())) {
     return TaskResult(false);
   }
 
   // Actually create the task. RefImage will account for memory on the first
   // ref.
-  RefImage(key);
+  RefImage(shard, key);
   existing_task = base::MakeRefCounted<SoftwareImageDecodeTaskImpl>(
       this, key, image, task_type, tracing_info);
   return TaskResult(existing_task);
 }
 
-void SoftwareImageDecodeCache::RefImage(const ImageKey& key) {
+void SoftwareImageDecodeCache::RefImage(CacheShard* shard,
+                                        const ImageKey& key) {
   TRACE_EVENT1(TRACE_DISABLED_BY_DEFAULT("cc.debug"),
                "SoftwareImageDecodeCache::RefImage", "key", key.ToString());
-  lock_.AssertAcquired();
-  int ref = ++decoded_images_ref_counts_[key];
+  shard->lock.AssertAcquired();
+  int ref = ++shard->decoded_images_ref_counts[key];
   if (ref == 1) {
     DCHECK_GE(locked_images_budget_.AvailableMemoryBytes(), key.locked_bytes());
     locked_images_budget_.AddUsage(key.locked_bytes());
@@ -355,19 +388,20 @@ void SoftwareImageDecodeCache::UnrefImage(const DrawImage& image) {
   TRACE_EVENT1(TRACE_DISABLED_BY_DEFAULT("cc.debug"),
                "SoftwareImageDecodeCache::UnrefImage", "key", key.ToString());
 
-  base::AutoLock lock(lock_);
-  auto ref_count_it = decoded_images_ref_counts_.find(key);
-  DCHECK(ref_count_it != decoded_images_ref_counts_.end());
+  CacheShard* shard = GetShard(key.frame_key());
+  base::AutoLock lock(shard->lock);
+  auto ref_count_it = shard->decoded_images_ref_counts.find(key);
+  DCHECK(ref_count_it != shard->decoded_images_ref_counts.end());
 
   --ref_count_it->second;
   if (ref_count_it->second == 0) {
-    decoded_images_ref_counts_.erase(ref_count_it);
+    shard->decoded_images_ref_counts.erase(ref_count_it);
     locked_images_budget_.SubtractUsage(key.locked_bytes());
 
-    auto decoded_image_it = decoded_images_.Peek(key);
+    auto decoded_image_it = shard->decoded_images.Peek(key);
     // If we've never decoded the image before ref reached 0, then we wouldn't
     // have it in our cache. This would happen if we canceled tasks.
-    if (decoded_image_it == decoded_images_.end())
+    if (decoded_image_it == shard->decoded_images.end())
       return;
     DCHECK(decoded_image_it->second->is_locked());
     decoded_image_it->second->Unlock();
@@ -379,32 +413,33 @@ void SoftwareImageDecodeCache::DecodeImage(const ImageKey& key,
                                            DecodeTaskType task_type) {
   TRACE_EVENT1("cc", "SoftwareImageDecodeCache::DecodeImage", "key",
                key.ToString());
-  base::AutoLock lock(lock_);
+  CacheShard* shard = GetShard(key.frame_key());
+  base::AutoLock lock(shard->lock);
   AutoRemoveKeyFromTaskMap remove_key_from_task_map(
       (task_type == DecodeTaskType::USE_IN_RASTER_TASKS)
-          ? &pending_in_raster_image_tasks_
-          : &pending_out_of_raster_image_tasks_,
+          ? &shard->pending_in_raster_image_tasks
+          : &shard->pending_out_of_raster_image_tasks,
       key);
 
   // We could have finished all of the raster tasks (cancelled) while the task
   // was just starting to run. Since this task already started running, it
   // wasn't cancelled. So, if the ref count for the image is 0 then we can just
   // abort.
-  if (decoded_images_ref_counts_.find(key) ==
-      decoded_images_ref_counts_.end()) {
+  if (shard->decoded_images_ref_counts.find(key) ==
+      shard->decoded_images_ref_counts.end()) {
     return;
   }
 
-  auto image_it = decoded_images_.Peek(key);
-  if (image_it != decoded_images_.end()) {
+  auto image_it = shard->decoded_images.Peek(key);
+  if (image_it != shard->decoded_images.end()) {
     if (image_it->second->is_locked() || image_it->second->Lock())
       return;
-    CleanupDecodedImagesCache(key, image_it);
+    CleanupDecodedImagesCache(shard, key, image_it);
   }
 
   std::unique_ptr<DecodedImage> decoded_image;
   {
-    base::AutoUnlock unlock(lock_);
+    base::AutoUnlock unlock(shard->lock);
     decoded_image = DecodeImageInternal(key, image);
   }
 
@@ -416,21 +451,21 @@ void SoftwareImageDecodeCache::DecodeImage(const ImageKey& key,
   // place by an already running raster task from a previous schedule. If that's
   // the case, then it would have already been placed into the cache (possibly
   // locked). Remove it if that was the case.
-  image_it = decoded_images_.Peek(key);
-  if (image_it != decoded_images_.end()) {
+  image_it = shard->decoded_images.Peek(key);
+  if (image_it != shard->decoded_images.end()) {
     if (image_it->second->is_locked() || image_it->second->Lock()) {
       // Make sure to unlock the decode we did in this function.
       decoded_image->Unlock();
       return;
     }
-    CleanupDecodedImagesCache(key, image_it);
+    CleanupDecodedImagesCache(shard, key, image_it);
   }
 
   // We could have finished all of the raster tasks (cancelled) while this image
   // decode task was running, which means that we now have a locked image but no
   // ref counts. Unlock it immediately in this case.
-  if (decoded_images_ref_counts_.find(key) ==
-      decoded_images_ref_counts_.end()) {
+  if (shard->decoded_images_ref_counts.find(key) ==
+      shard->decoded_images_ref_counts.end()) {
     decoded_image->Unlock();
   }
 
@@ -440,7 +475,7 @@ void SoftwareImageDecodeCache::DecodeImage(const ImageKey& key,
   RecordImageMipLevelUMA(
       MipMapUtil::GetLevelForSize(key.src_rect().size(), key.target_size()));
 
-  CacheDecodedImages(key, std::move(decoded_image));
+  CacheDecodedImages(shard, key, std::move(decoded_image));
 }
 
 std::unique_ptr<SoftwareImageDecodeCache::DecodedImage>
@@ -453,6 +488,16 @@ SoftwareImageDecodeCache::DecodeImageInternal(const ImageKey& key,
   if (!paint_image)
     return nullptr;
 
+  // Another cache in this process may have left this exact decode behind.
+  if (shared_decoded_image_cache_) {
+    SharedDecodedImageCache::Entry entry =
+        shared_decoded_image_cache_->TakeLocked(key, color_type_);
+    if (entry.memory) {
+      return std::make_unique<DecodedImage>(
+          entry.info, std::move(entry.memory), entry.src_rect_offset);
+    }
+  }
+
   // Special case subrect into a special function.
   if (key.should_use_subrect())
     return GetSubrectImageDecode(key, paint_image);
@@ -499,32 +544,33 @@ DecodedDrawImage SoftwareImageDecodeCache::GetDecodedImageForDrawInternal(
                "SoftwareImageDecodeCache::GetDecodedImageForDrawInternal",
                "key", key.ToString());
 
-  base::AutoLock lock(lock_);
-  auto decoded_images_it = decoded_images_.Get(key);
+  CacheShard* shard = GetShard(key.frame_key());
+  base::AutoLock lock(shard->lock);
+  auto decoded_images_it = shard->decoded_images.Get(key);
   // If we found the image and it's locked, then return it. If it's not locked,
   // erase it from the cache since it might be put into the at-raster cache.
   std::unique_ptr<DecodedImage> scoped_decoded_image;
   DecodedImage* decoded_image = nullptr;
-  if (decoded_images_it != decoded_images_.end()) {
+  if (decoded_images_it != shard->decoded_images.end()) {
     decoded_image = decoded_images_it->second.get();
     if (decoded_image->is_locked()) {
-      RefImage(key);
+      RefImage(shard, key);
       decoded_image->mark_used();
       return DecodedDrawImage(
           decoded_image->image(), decoded_image->src_rect_offset(),
           GetScaleAdjustment(key), GetDecodedFilterQuality(key));
     } else {
       scoped_decoded_image = std::move(decoded_images_it->second);
-      CleanupDecodedImagesCache(key, decoded_images_it);
+      CleanupDecodedImagesCache(shard, key, decoded_images_it);
     }
   }
 
   // See if another thread already decoded this image at raster time. If so, we
   // can just use that result directly.
-  auto at_raster_images_it = at_raster_decoded_images_.Get(key);
-  if (at_raster_images_it != at_raster_decoded_images_.end()) {
+  auto at_raster_images_it = shard->at_raster_decoded_images.Get(key);
+  if (at_raster_images_it != shard->at_raster_decoded_images.end()) {
     DCHECK(at_raster_images_it->second->is_locked());
-    RefAtRasterImage(key);
+    RefAtRasterImage(shard, key);
     DecodedImage* at_raster_decoded_image = at_raster_images_it->second.get();
     at_raster_decoded_image->mark_used();
     auto decoded_draw_image =
@@ -544,7 +590,7 @@ DecodedDrawImage SoftwareImageDecodeCache::GetDecodedImageForDrawInternal(
     // Note that we have to release the lock, since this lock is also accessed
     // on the compositor thread. This means holding on to the lock might stall
     // the compositor thread for the duration of the decode!
-    base::AutoUnlock unlock(lock_);
+    base::AutoUnlock unlock(shard->lock);
     scoped_decoded_image = DecodeImageInternal(key, draw_image);
     decoded_image = scoped_decoded_image.get();
 
@@ -560,8 +606,8 @@ DecodedDrawImage SoftwareImageDecodeCache::GetDecodedImageForDrawInternal(
   // already decoded this already and put it in the at-raster cache. Look it up
   // first.
   if (check_at_raster_cache) {
-    at_raster_images_it = at_raster_decoded_images_.Get(key);
-    if (at_raster_images_it != at_raster_decoded_images_.end()) {
+    at_raster_images_it = shard->at_raster_decoded_images.Get(key);
+    if (at_raster_images_it != shard->at_raster_decoded_images.end()) {
       // We have to drop our decode, since the one in the cache is being used by
       // another thread.
       decoded_image->Unlock();
@@ -573,11 +619,11 @@ DecodedDrawImage SoftwareImageDecodeCache::GetDecodedImageForDrawInternal(
   // If we really are the first ones, or if the other thread already unlocked
   // the image, then put our work into at-raster time cache.
   if (scoped_decoded_image)
-    at_raster_decoded_images_.Put(key, std::move(scoped_decoded_image));
+    shard->at_raster_decoded_images.Put(key, std::move(scoped_decoded_image));
 
   DCHECK(decoded_image);
   DCHECK(decoded_image->is_locked());
-  RefAtRasterImage(key);
+  RefAtRasterImage(shard, key);
   decoded_image->mark_used();
   auto decoded_draw_image =
       DecodedDrawImage(decoded_image->image(), decoded_image->src_rect_offset(),
@@ -788,28 +834,31 @@ void SoftwareImageDecodeCache::DrawWithImageFinished(
     UnrefImage(image);
 }
 
-void SoftwareImageDecodeCache::RefAtRasterImage(const ImageKey& key) {
+void SoftwareImageDecodeCache::RefAtRasterImage(CacheShard* shard,
+                                                const ImageKey& key) {
   TRACE_EVENT1(TRACE_DISABLED_BY_DEFAULT("cc.debug"),
                "SoftwareImageDecodeCache::RefAtRasterImage", "key",
                key.ToString());
-  DCHECK(at_raster_decoded_images_.Peek(key) !=
-         at_raster_decoded_images_.end());
-  ++at_raster_decoded_images_ref_counts_[key];
+  shard->lock.AssertAcquired();
+  DCHECK(shard->at_raster_decoded_images.Peek(key) !=
+         shard->at_raster_decoded_images.end());
+  ++shard->at_raster_decoded_images_ref_counts[key];
 }
 
 void SoftwareImageDecodeCache::UnrefAtRasterImage(const ImageKey& key) {
   TRACE_EVENT1(TRACE_DISABLED_BY_DEFAULT("cc.debug"),
                "SoftwareImageDecodeCache::UnrefAtRasterImage", "key",
                key.ToString());
-  base::AutoLock lock(lock_);
+  CacheShard* shard = GetShard(key.frame_key());
+  base::AutoLock lock(shard->lock);
 
-  auto ref_it = at_raster_decoded_images_ref_counts_.find(key);
-  DCHECK(ref_it != at_raster_decoded_images_ref_counts_.end());
+  auto ref_it = shard->at_raster_decoded_images_ref_counts.find(key);
+  DCHECK(ref_it != shard->at_raster_decoded_images_ref_counts.end());
   --ref_it->second;
   if (ref_it->second == 0) {
-    at_raster_decoded_images_ref_counts_.erase(ref_it);
-    auto at_raster_image_it = at_raster_decoded_images_.Peek(key);
-    DCHECK(at_raster_image_it != at_raster_decoded_images_.end());
+    shard->at_raster_decoded_images_ref_counts.erase(ref_it);
+    auto at_raster_image_it = shard->at_raster_decoded_images.Peek(key);
+    DCHECK(at_raster_image_it != shard->at_raster_decoded_images.end());
 
     // The ref for our image reached 0 and it's still locked. We need to figure
     // out what the best thing to do with the image. There are several
@@ -825,55 +874,96 @@ void SoftwareImageDecodeCache::UnrefAtRasterImage(const ImageKey& key) {
     //       2b1. ... its ref count is 0: unlock our image and replace the
     //       existing one with ours.
     //       2b2. ... its ref count is not 0: this shouldn't be possible.
-    auto image_it = decoded_images_.Peek(key);
-    if (image_it == decoded_images_.end()) {
-      if (decoded_images_ref_counts_.find(key) ==
-          decoded_images_ref_counts_.end()) {
+    auto image_it = shard->decoded_images.Peek(key);
+    if (image_it == shard->decoded_images.end()) {
+      if (shard->decoded_images_ref_counts.find(key) ==
+          shard->decoded_images_ref_counts.end()) {
         at_raster_image_it->second->Unlock();
       }
-      CacheDecodedImages(key, std::move(at_raster_image_it->second));
+      CacheDecodedImages(shard, key, std::move(at_raster_image_it->second));
     } else if (image_it->second->is_locked()) {
       at_raster_image_it->second->Unlock();
     } else {
-      DCHECK(decoded_images_ref_counts_.find(key) ==
-             decoded_images_ref_counts_.end());
+      DCHECK(shard->decoded_images_ref_counts.find(key) ==
+             shard->decoded_images_ref_counts.end());
       at_raster_image_it->second->Unlock();
-      // Access decoded_images_ directly here to avoid deletion and entry
-      // of same key in ImageKey vector of decoded_images_unique_ids_.
-      decoded_images_.Erase(image_it);
-      decoded_images_.Put(key, std::move(at_raster_image_it->second));
+      // Access decoded_images directly here to avoid deletion and entry
+      // of same key in ImageKey vector of frame_key_to_image_keys.
+      shard->decoded_images.Erase(image_it);
+      shard->decoded_images.Put(key, std::move(at_raster_image_it->second));
     }
-    at_raster_decoded_images_.Erase(at_raster_image_it);
+    shard->at_raster_decoded_images.Erase(at_raster_image_it);
   }
 }
 
-void SoftwareImageDecodeCache::ReduceCacheUsageUntilWithinLimit(size_t limit) {
+void SoftwareImageDecodeCache::ReduceCacheUsageUntilWithinLimit(
+    size_t limit,
+    bool retain_in_shared_cache) {
   TRACE_EVENT0("cc",
                "SoftwareImageDecodeCache::ReduceCacheUsageUntilWithinLimit");
+  base::AutoLock reduce_lock(reduce_cache_usage_lock_);
+  size_t total_items = 0u;
+  for (const auto& shard : shards_) {
+    base::AutoLock lock(shard->lock);
+    total_items += shard->decoded_images.size();
+  }
   lifetime_max_items_in_cache_ =
-      std::max(lifetime_max_items_in_cache_, decoded_images_.size());
-  size_t num_to_remove =
-      (decoded_images_.size() > limit) ? (decoded_images_.size() - limit) : 0;
-  for (auto it = decoded_images_.rbegin();
-       num_to_remove != 0 && it != decoded_images_.rend();) {
-    if (it->second->is_locked()) {
-      ++it;
-      continue;
-    }
+      std::max(lifetime_max_items_in_cache_, total_items);
+  if (total_items <= limit)
+    return;
 
-    it = decoded_images_.Erase(it);
-    --num_to_remove;
-  }
+  // Only the excess is removed. Shards are first trimmed to an even share of
+  // the limit, rounded up so that a non-zero limit never trims a shard down to
+  // nothing, and whatever is left over is then taken from any shard.
+  size_t num_to_remove = total_items - limit;
+  auto trim_shard = [this, &num_to_remove, retain_in_shared_cache](
+                        CacheShard* shard, size_t shard_limit) {
+    base::AutoLock lock(shard->lock);
+    ImageMRUCache& decoded_images = shard->decoded_images;
+    for (auto it = decoded_images.rbegin();
+         num_to_remove != 0 && decoded_images.size() > shard_limit &&
+         it != decoded_images.rend();) {
+      if (it->second->is_locked()) {
+        ++it;
+        continue;
+      }
+
+      if (retain_in_shared_cache)
+        RetainInSharedCache(it->first, std::move(it->second));
+      it = decoded_images.Erase(it);
+      --num_to_remove;
+    }
+  };
+  size_t shard_limit = (limit + shards_.size() - 1) / shards_.size();
+  for (const auto& shard : shards_)
+    trim_shard(shard.get(), shard_limit);
+  for (const auto& shard : shards_)
+    trim_shard(shard.get(), 0u);
 }
 
 void SoftwareImageDecodeCache::ReduceCacheUsage() {
-  base::AutoLock lock(lock_);
-  ReduceCacheUsageUntilWithinLimit(max_items_in_cache_);
+  ReduceCacheUsageUntilWithinLimit(
+      base::subtle::NoBarrier_Load(&max_items_in_cache_),
+      true /* retain_in_shared_cache */);
 }
 
 void SoftwareImageDecodeCache::ClearCache() {
-  base::AutoLock lock(lock_);
-  ReduceCacheUsageUntilWithinLimit(0);
+  // This is called on navigation, so the decodes are worth keeping around in
+  // case we navigate back.
+  ReduceCacheUsageUntilWithinLimit(0, true /* retain_in_shared_cache */);
+}
+
+void SoftwareImageDecodeCache::RetainInSharedCache(
+    const ImageKey& key,
+    std::unique_ptr<DecodedImage> decoded_image) {
+  DCHECK(!decoded_image->is_locked());
+  if (!shared_decoded_image_cache_)
+    return;
+  SkImageInfo info = decoded_image->image_info();
+  SkSize src_rect_offset = decoded_image->src_rect_offset();
+  shared_decoded_image_cache_->Retain(
+      key, SharedDecodedImageCache::Entry(info, decoded_image->TakeMemory(),
+                                          src_rect_offset));
 }
 
 size_t SoftwareImageDecodeCache::GetMaximumMemoryLimitBytes() const {
@@ -882,42 +972,58 @@ size_t SoftwareImageDecodeCache::GetMaximumMemoryLimitBytes() const {
 
 void SoftwareImageDecodeCache::NotifyImageUnused(
     const PaintImage::FrameKey& frame_key) {
-  base::AutoLock lock(lock_);
+  CacheShard* shard = GetShard(frame_key);
+  base::AutoLock lock(shard->lock);
 
-  auto it = frame_key_to_image_keys_.find(frame_key);
-  if (it == frame_key_to_image_keys_.end())
+  auto it = shard->frame_key_to_image_keys.find(frame_key);
+  if (it == shard->frame_key_to_image_keys.end())
     return;
 
   for (auto key = it->second.begin(); key != it->second.end(); ++key) {
     // This iterates over the ImageKey vector for the given skimage_id,
-    // and deletes all entries from decoded_images_ corresponding to the
+    // and deletes all entries from decoded_images corresponding to the
     // skimage_id.
-    auto image_it = decoded_images_.Peek(*key);
+    auto image_it = shard->decoded_images.Peek(*key);
     // TODO(sohanjg) :Find an optimized way to cleanup locked images.
-    if (image_it != decoded_images_.end() && !image_it->second->is_locked())
-      decoded_images_.Erase(image_it);
+    if (image_it != shard->decoded_images.end() &&
+        !image_it->second->is_locked()) {
+      shard->decoded_images.Erase(image_it);
+    }
   }
-  frame_key_to_image_keys_.erase(it);
+  shard->frame_key_to_image_keys.erase(it);
 }
 
 void SoftwareImageDecodeCache::RemovePendingTask(const ImageKey& key,
                                                  DecodeTaskType task_type) {
-  base::AutoLock lock(lock_);
+  CacheShard* shard = GetShard(key.frame_key());
+  base::AutoLock lock(shard->lock);
   switch (task_type) {
     case DecodeTaskType::USE_IN_RASTER_TASKS:
-      pending_in_raster_image_tasks_.erase(key);
+      shard->pending_in_raster_image_tasks.erase(key);
       break;
     case DecodeTaskType::USE_OUT_OF_RASTER_TASKS:
-      pending_out_of_raster_image_tasks_.erase(key);
+      shard->pending_out_of_raster_image_tasks.erase(key);
       break;
   }
 }
 
+size_t SoftwareImageDecodeCache::GetNumCacheEntriesForTesting() const {
+  size_t num_entries = 0u;
+  for (const auto& shard : shards_) {
+    base::AutoLock lock(shard->lock);
+    num_entries += shard->decoded_images.size();
+  }
+  return num_entries;
+}
+
+SoftwareImageDecodeCache::CacheShard* SoftwareImageDecodeCache::GetShard(
+    const PaintImage::FrameKey& frame_key) const {
+  return shards_[frame_key.hash() % shards_.size()].get();
+}
+
 bool SoftwareImageDecodeCache::OnMemoryDump(
     const base::trace_event::MemoryDumpArgs& args,
     base::trace_event::ProcessMemoryDump* pmd) {
-  base::AutoLock lock(lock_);
-
   if (args.level_of_detail == MemoryDumpLevelOfDetail::BACKGROUND) {
     std::string dump_name = base::StringPrintf(
         "cc/image_memory/cache_0x%" PRIXPTR, reinterpret_cast<uintptr_t>(this));
@@ -926,8 +1032,12 @@ bool SoftwareImageDecodeCache::OnMemoryDump(
                     locked_images_budget_.GetCurrentUsageSafe());
   } else {
     // Dump each of our caches.
-    DumpImageMemoryForCache(decoded_images_, "cached", pmd);
-    DumpImageMemoryForCache(at_raster_decoded_images_, "at_raster", pmd);
+    for (const auto& shard : shards_) {
+      base::AutoLock lock(shard->lock);
+      DumpImageMemoryForCache(*shard, shard->decoded_images, "cached", pmd);
+      DumpImageMemoryForCache(*shard, shard->at_raster_decoded_images,
+                              "at_raster", pmd);
+    }
   }
 
   // Memory dump can't fail, always return true.
@@ -935,10 +1045,11 @@ bool SoftwareImageDecodeCache::OnMemoryDump(
 }
 
 void SoftwareImageDecodeCache::DumpImageMemoryForCache(
+    const CacheShard& shard,
     const ImageMRUCache& cache,
     const char* cache_name,
     base::trace_event::ProcessMemoryDump* pmd) const {
-  lock_.AssertAcquired();
+  shard.lock.AssertAcquired();
 
   for (const auto& image_pair : cache) {
     int image_id = static_cast<int>(image_pair.first.frame_key().hash());
@@ -1183,6 +1294,14 @@ bool SoftwareImageDecodeCache::DecodedImage::Lock() {
   return true;
 }
 
+std::unique_ptr<base::DiscardableMemory>
+SoftwareImageDecodeCache::DecodedImage::TakeMemory() {
+  DCHECK(!locked_);
+  // |image_| points into the memory, so drop it first.
+  image_ = nullptr;
+  return std::move(memory_);
+}
+
 void SoftwareImageDecodeCache::DecodedImage::Unlock() {
   DCHECK(locked_);
   memory_->Unlock();
@@ -1201,72 +1320,85 @@ size_t SoftwareImageDecodeCache::MemoryBudget::AvailableMemoryBytes() const {
 }
 
 void SoftwareImageDecodeCache::MemoryBudget::AddUsage(size_t usage) {
-  current_usage_bytes_ += usage;
+  base::subtle::NoBarrier_AtomicIncrement(
+      &current_usage_bytes_, static_cast<base::subtle::AtomicWord>(usage));
 }
 
 void SoftwareImageDecodeCache::MemoryBudget::SubtractUsage(size_t usage) {
-  DCHECK_GE(current_usage_bytes_.ValueOrDefault(0u), usage);
-  current_usage_bytes_ -= usage;
+  base::subtle::AtomicWord new_usage = base::subtle::NoBarrier_AtomicIncrement(
+      &current_usage_bytes_, -static_cast<base::subtle::AtomicWord>(usage));
+  DCHECK_GE(new_usage, 0);
 }
 
 void SoftwareImageDecodeCache::MemoryBudget::ResetUsage() {
-  current_usage_bytes_ = 0;
+  base::subtle::NoBarrier_Store(&current_usage_bytes_, 0);
 }
 
 size_t SoftwareImageDecodeCache::MemoryBudget::GetCurrentUsageSafe() const {
-  return current_usage_bytes_.ValueOrDie();
+  base::subtle::AtomicWord usage =
+      base::subtle::NoBarrier_Load(&current_usage_bytes_);
+  CHECK_GE(usage, 0);
+  return static_cast<size_t>(usage);
 }
 
+// CacheShard
+SoftwareImageDecodeCache::CacheShard::CacheShard()
+    : decoded_images(ImageMRUCache::NO_AUTO_EVICT),
+      at_raster_decoded_images(ImageMRUCache::NO_AUTO_EVICT) {}
+
+SoftwareImageDecodeCache::CacheShard::~CacheShard() = default;
+
 void SoftwareImageDecodeCache::OnMemoryStateChange(base::MemoryState state) {
-  {
-    base::AutoLock hold(lock_);
-    switch (state) {
-      case base::MemoryState::NORMAL:
-        max_items_in_cache_ = kNormalMaxItemsInCacheForSoftware;
-        break;
-      case base::MemoryState::THROTTLED:
-        max_items_in_cache_ = kThrottledMaxItemsInCacheForSoftware;
-        break;
-      case base::MemoryState::SUSPENDED:
-        max_items_in_cache_ = kSuspendedMaxItemsInCacheForSoftware;
-        break;
-      case base::MemoryState::UNKNOWN:
-        NOTREACHED();
-        return;
-    }
+  switch (state) {
+    case base::MemoryState::NORMAL:
+      base::subtle::NoBarrier_Store(&max_items_in_cache_,
+                                    kNormalMaxItemsInCacheForSoftware);
+      break;
+    case base::MemoryState::THROTTLED:
+      base::subtle::NoBarrier_Store(&max_items_in_cache_,
+                                    kThrottledMaxItemsInCacheForSoftware);
+      break;
+    case base::MemoryState::SUSPENDED:
+      base::subtle::NoBarrier_Store(&max_items_in_cache_,
+                                    kSuspendedMaxItemsInCacheForSoftware);
+      break;
+    case base::MemoryState::UNKNOWN:
+      NOTREACHED();
+      return;
   }
 }
 
 void SoftwareImageDecodeCache::OnPurgeMemory() {
-  base::AutoLock lock(lock_);
-  ReduceCacheUsageUntilWithinLimit(0);
+  ReduceCacheUsageUntilWithinLimit(0, false /* retain_in_shared_cache */);
 }
 
 void SoftwareImageDecodeCache::CleanupDecodedImagesCache(
+    CacheShard* shard,
     const ImageKey& key,
     ImageMRUCache::iterator it) {
-  lock_.AssertAcquired();
-  auto vector_it = frame_key_to_image_keys_.find(key.frame_key());
+  shard->lock.AssertAcquired();
+  auto vector_it = shard->frame_key_to_image_keys.find(key.frame_key());
 
   // TODO(sohanjg): Check if we can DCHECK here.
-  if (vector_it != frame_key_to_image_keys_.end()) {
+  if (vector_it != shard->frame_key_to_image_keys.end()) {
     auto iter =
         std::find(vector_it->second.begin(), vector_it->second.end(), key);
     DCHECK(iter != vector_it->second.end());
     vector_it->second.erase(iter);
     if (vector_it->second.empty())
-      frame_key_to_image_keys_.erase(vector_it);
+      shard->frame_key_to_image_keys.erase(vector_it);
   }
 
-  decoded_images_.Erase(it);
+  shard->decoded_images.Erase(it);
 }
 
 void SoftwareImageDecodeCache::CacheDecodedImages(
+    CacheShard* shard,
     const ImageKey& key,
     std::unique_ptr<DecodedImage> decoded_image) {
-  lock_.AssertAcquired();
-  frame_key_to_image_keys_[key.frame_key()].push_back(key);
-  decoded_images_.Put(key, std::move(decoded_image));
+  shard->lock.AssertAcquired();
+  shard->frame_key_to_image_keys[key.frame_key()].push_back(key);
+  shard->decoded_images.Put(key, std::move(decoded_image));
 }
 
 }  // namespace cc
@@ -10,14 +10,18 @@
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "base/atomic_sequence_num.h"
+#include "base/atomicops.h"
 #include "base/containers/mru_cache.h"
 #include "base/hash.h"
+#include "base/macros.h"
 #include "base/memory/discardable_memory_allocator.h"
 #include "base/memory/memory_coordinator_client.h"
 #include "base/memory/ref_counted.h"
 #include "base/numerics/safe_math.h"
+#include "base/synchronization/lock.h"
 #include "base/threading/thread_checker.h"
 #include "base/trace_event/memory_dump_provider.h"
 #include "cc/cc_export.h"
@@ -28,6 +32,8 @@
 
 namespace cc {
 
+class SharedDecodedImageCache;
+
 // ImageDecodeCacheKey is a class that gets a cache key out of a given draw
 // image. That is, this key uniquely identifies an image in the cache. Note that
 // it's insufficient to use SkImage's unique id, since the same image can appear
@@ -119,8 +125,14 @@ class CC_EXPORT SoftwareImageDecodeCache
 
   enum class DecodeTaskType { USE_IN_RASTER_TASKS, USE_OUT_OF_RASTER_TASKS };
 
+  // The number of shards used by the two argument constructor. See CacheShard.
+  static constexpr size_t kDefaultNumShards = 8u;
+
   SoftwareImageDecodeCache(SkColorType color_type,
                            size_t locked_memory_limit_bytes);
+  SoftwareImageDecodeCache(SkColorType color_type,
+                           size_t locked_memory_limit_bytes,
+                           size_t num_shards);
   ~SoftwareImageDecodeCache() override;
 
   // ImageDecodeCache overrides.
@@ -152,7 +164,15 @@ class CC_EXPORT SoftwareImageDecodeCache
   bool OnMemoryDump(const base::trace_event::MemoryDumpArgs& args,
                     base::trace_event::ProcessMemoryDump* pmd) override;
 
-  size_t GetNumCacheEntriesForTesting() const { return decoded_images_.size(); }
+  // Sets a process-wide cache that unlocked decodes are handed to when this
+  // cache evicts them or is destroyed, and that is checked before decoding an
+  // image. Must be called before the cache is used.
+  void set_shared_decoded_image_cache(SharedDecodedImageCache* shared_cache) {
+    shared_decoded_image_cache_ = shared_cache;
+  }
+
+  size_t GetNumCacheEntriesForTesting() const;
+  size_t GetNumShardsForTesting() const { return shards_.size(); }
 
  private:
   // DecodedImage is a convenience storage for discardable memory. It can also
@@ -176,6 +196,11 @@ class CC_EXPORT SoftwareImageDecodeCache
     void Unlock();
 
     const base::DiscardableMemory* memory() const { return memory_.get(); }
+    const SkImageInfo& image_info() const { return image_info_; }
+
+    // Releases the unlocked memory backing this image. The image can't be used
+    // afterwards.
+    std::unique_ptr<base::DiscardableMemory> TakeMemory();
 
     // An ID which uniquely identifies this DecodedImage within the image decode
     // cache. Used in memory tracing.
@@ -207,7 +232,9 @@ class CC_EXPORT SoftwareImageDecodeCache
   };
 
   // MemoryBudget is a convenience class for memory bookkeeping and ensuring
-  // that we don't go over the limit when pre-decoding.
+  // that we don't go over the limit when pre-decoding. The budget is shared by
+  // all shards, so the usage is updated atomically and can be accessed without
+  // holding any lock.
   class MemoryBudget {
    public:
     explicit MemoryBudget(size_t limit_bytes);
@@ -221,12 +248,53 @@ class CC_EXPORT SoftwareImageDecodeCache
 
    private:
     const size_t limit_bytes_;
-    base::CheckedNumeric<size_t> current_usage_bytes_;
+    base::subtle::AtomicWord current_usage_bytes_;
   };
 
   using ImageMRUCache = base::
       HashingMRUCache<ImageKey, std::unique_ptr<DecodedImage>, ImageKeyHash>;
 
+  // A CacheShard owns the decodes for a subset of images, picked by the hash
+  // of the image's PaintImage::FrameKey. This keeps every scale and subrect of
+  // a given image in the same shard, so a single shard lock covers everything
+  // that a decode, a NotifyImageUnused() or a subrect/scale of an existing
+  // decode needs to touch. Raster workers decoding different images then only
+  // share the lock-free |locked_images_budget_|, instead of serializing on one
+  // cache-wide lock.
+  struct CacheShard {
+    CacheShard();
+    ~CacheShard();
+
+    // The members below can only be accessed if |lock| is held.
+    base::Lock lock;
+
+    std::unordered_map<ImageKey, scoped_refptr<TileTask>, ImageKeyHash>
+        pending_in_raster_image_tasks;
+    std::unordered_map<ImageKey, scoped_refptr<TileTask>, ImageKeyHash>
+        pending_out_of_raster_image_tasks;
+
+    // Decoded images and ref counts (predecode path).
+    ImageMRUCache decoded_images;
+    std::unordered_map<ImageKey, int, ImageKeyHash> decoded_images_ref_counts;
+
+    // A map of PaintImage::FrameKey to the ImageKeys for cached decodes of
+    // this PaintImage.
+    std::unordered_map<PaintImage::FrameKey,
+                       std::vector<ImageKey>,
+                       PaintImage::FrameKeyHash>
+        frame_key_to_image_keys;
+
+    // Decoded image and ref counts (at-raster decode path).
+    ImageMRUCache at_raster_decoded_images;
+    std::unordered_map<ImageKey, int, ImageKeyHash>
+        at_raster_decoded_images_ref_counts;
+
+   private:
+    DISALLOW_COPY_AND_ASSIGN(CacheShard);
+  };
+
+  CacheShard* GetShard(const PaintImage::FrameKey& frame_key) const;
+
   // Looks for the key in the cache and returns true if it was found and was
   // successfully locked (or if it was already locked). Note that if this
   // function returns true, then a ref count is increased for the image.
@@ -273,18 +341,29 @@ class CC_EXPORT SoftwareImageDecodeCache
   std::unique_ptr<DecodedImage> GetScaledImageDecode(const ImageKey& key,
                                                      const PaintImage& image);
 
-  void RefImage(const ImageKey& key);
-  void RefAtRasterImage(const ImageKey& key);
+  void RefImage(CacheShard* shard, const ImageKey& key);
+  void RefAtRasterImage(CacheShard* shard, const ImageKey& key);
   void UnrefAtRasterImage(const ImageKey& key);
 
-  // Helper function which dumps all images in a specific ImageMRUCache.
-  void DumpImageMemoryForCache(const ImageMRUCache& cache,
+  // Helper function which dumps all images in a specific ImageMRUCache. The
+  // lock of |shard|, which owns |cache|, must be held.
+  void DumpImageMemoryForCache(const CacheShard& shard,
+                               const ImageMRUCache& cache,
                                const char* cache_name,
                                base::trace_event::ProcessMemoryDump* pmd) const;
 
   // Removes unlocked decoded images until the number of decoded images is
-  // reduced within the given limit.
-  void ReduceCacheUsageUntilWithinLimit(size_t limit);
+  // reduced within the given limit. Nothing is removed while the shards are
+  // within it in total. Otherwise, shards are trimmed one at a time, first
+  // to an even share of the limit. If |retain_in_shared_cache| is true, the
+  // removed images are handed to |shared_decoded_image_cache_|.
+  void ReduceCacheUsageUntilWithinLimit(size_t limit,
+                                        bool retain_in_shared_cache);
+
+  // Hands an unlocked decode to |shared_decoded_image_cache_|, if there is one.
+  // Otherwise, the decode is simply deleted.
+  void RetainInSharedCache(const ImageKey& key,
+                           std::unique_ptr<DecodedImage> decoded_image);
 
   // Overriden from base::MemoryCoordinatorClient.
   void OnMemoryStateChange(base::MemoryState state) override;
@@ -296,44 +375,33 @@ class CC_EXPORT SoftwareImageDecodeCache
                                            const TracingInfo& tracing_info,
                                            DecodeTaskType type);
 
-  void CacheDecodedImages(const ImageKey& key,
+  void CacheDecodedImages(CacheShard* shard,
+                          const ImageKey& key,
                           std::unique_ptr<DecodedImage> decoded_image);
-  void CleanupDecodedImagesCache(const ImageKey& key,
+  void CleanupDecodedImagesCache(CacheShard* shard,
+                                 const ImageKey& key,
                                  ImageMRUCache::iterator it);
 
-  std::unordered_map<ImageKey, scoped_refptr<TileTask>, ImageKeyHash>
-      pending_in_raster_image_tasks_;
-  std::unordered_map<ImageKey, scoped_refptr<TileTask>, ImageKeyHash>
-      pending_out_of_raster_image_tasks_;
-
-  // The members below this comment can only be accessed if the lock is held to
-  // ensure that they are safe to access on multiple threads.
-  // The exception is accessing |locked_images_budget_.total_limit_bytes()|,
-  // which is const and thread safe.
-  base::Lock lock_;
-
-  // Decoded images and ref counts (predecode path).
-  ImageMRUCache decoded_images_;
-  std::unordered_map<ImageKey, int, ImageKeyHash> decoded_images_ref_counts_;
-
-  // A map of PaintImage::FrameKey to the ImageKeys for cached decodes of this
-  // PaintImage.
-  std::unordered_map<PaintImage::FrameKey,
-                     std::vector<ImageKey>,
-                     PaintImage::FrameKeyHash>
-      frame_key_to_image_keys_;
-
-  // Decoded image and ref counts (at-raster decode path).
-  ImageMRUCache at_raster_decoded_images_;
-  std::unordered_map<ImageKey, int, ImageKeyHash>
-      at_raster_decoded_images_ref_counts_;
+  // Never resized after construction, so the vector itself can be accessed
+  // on any thread. See CacheShard for the locking of each shard.
+  std::vector<std::unique_ptr<CacheShard>> shards_;
 
   MemoryBudget locked_images_budget_;
 
+  SharedDecodedImageCache* shared_decoded_image_cache_ = nullptr;
+
   SkColorType color_type_;
-  size_t max_items_in_cache_;
+  // Updated by the memory coordinator and read when reducing cache usage,
+  // possibly on different threads.
+  base::subtle::AtomicWord max_items_in_cache_;
+
+  // Serializes ReduceCacheUsageUntilWithinLimit() calls, which can come from
+  // both the compositor thread and memory pressure notifications. Acquired
+  // before any shard lock.
+  base::Lock reduce_cache_usage_lock_;
   // Records the maximum number of items in the cache over the lifetime of the
-  // cache. This is updated anytime we are requested to reduce cache usage.
+  // cache. This is updated anytime we are requested to reduce cache usage, and
+  // can only be accessed with |reduce_cache_usage_lock_| held.
   size_t lifetime_max_items_in_cache_ = 0u;
 };
 
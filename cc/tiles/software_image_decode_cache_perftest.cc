@@ -2,8 +2,13 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <memory>
 #include <vector>
 
+#include "base/format_macros.h"
+#include "base/macros.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/simple_thread.h"
 #include "cc/base/lap_timer.h"
 #include "cc/paint/draw_image.h"
 #include "cc/paint/paint_image_builder.h"
@@ -18,6 +23,9 @@ namespace {
 static const int kTimeLimitMillis = 2000;
 static const int kWarmupRuns = 5;
 static const int kTimeCheckInterval = 10;
+static const int kNumDrawThreads = 4;
+static const int kImagesPerDrawThread = 64;
+static const int kDrawsPerImage = 4;
 
 sk_sp<SkImage> CreateImage(int width, int height) {
   SkBitmap bitmap;
@@ -31,6 +39,30 @@ SkMatrix CreateMatrix(const SkSize& scale) {
   return matrix;
 }
 
+// Repeatedly draws a set of images using at-raster decodes, the way a raster
+// worker does when images were not predecoded.
+class DrawImagesDelegate : public base::DelegateSimpleThread::Delegate {
+ public:
+  DrawImagesDelegate(SoftwareImageDecodeCache* cache,
+                     const std::vector<DrawImage>* images)
+      : cache_(cache), images_(images) {}
+
+  void Run() override {
+    for (int i = 0; i < kDrawsPerImage; ++i) {
+      for (const auto& image : *images_) {
+        DecodedDrawImage decoded_image = cache_->GetDecodedImageForDraw(image);
+        cache_->DrawWithImageFinished(image, decoded_image);
+      }
+    }
+  }
+
+ private:
+  SoftwareImageDecodeCache* cache_;
+  const std::vector<DrawImage>* images_;
+
+  DISALLOW_COPY_AND_ASSIGN(DrawImagesDelegate);
+};
+
 class SoftwareImageDecodeCachePerfTest : public testing::Test {
  public:
   SoftwareImageDecodeCachePerfTest()
@@ -79,6 +111,54 @@ class SoftwareImageDecodeCachePerfTest : public testing::Test {
                            "result", timer_.LapsPerSecond(), "runs/s", true);
   }
 
+  // Measures how well concurrent at-raster draws of distinct images scale with
+  // the number of cache shards.
+  void RunConcurrentDraws(size_t num_shards) {
+    SoftwareImageDecodeCache cache(kN32_SkColorType, 128 * 1024 * 1024,
+                                   num_shards);
+
+    std::vector<std::vector<DrawImage>> images_per_thread(kNumDrawThreads);
+    for (auto& images : images_per_thread) {
+      for (int i = 0; i < kImagesPerDrawThread; ++i) {
+        images.emplace_back(PaintImageBuilder::WithDefault()
+                                .set_id(PaintImage::GetNextId())
+                                .set_image(CreateImage(32, 32))
+                                .TakePaintImage(),
+                            SkIRect::MakeWH(32, 32), kLow_SkFilterQuality,
+                            CreateMatrix(SkSize::Make(1.f, 1.f)), 0u,
+                            gfx::ColorSpace());
+      }
+    }
+
+    std::vector<std::unique_ptr<DrawImagesDelegate>> delegates;
+    for (const auto& images : images_per_thread) {
+      delegates.push_back(
+          std::make_unique<DrawImagesDelegate>(&cache, &images));
+    }
+
+    timer_.Reset();
+    do {
+      std::vector<std::unique_ptr<base::DelegateSimpleThread>> threads;
+      for (auto& delegate : delegates) {
+        threads.push_back(std::make_unique<base::DelegateSimpleThread>(
+            delegate.get(), "DrawImagesThread"));
+        threads.back()->Start();
+      }
+      for (auto& thread : threads)
+        thread->Join();
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+
+    cache.ClearCache();
+
+    perf_test::PrintResult(
+        "software_image_decode_cache_concurrent_draws",
+        base::StringPrintf("_%" PRIuS "_shards", num_shards), "result",
+        timer_.LapsPerSecond() * kNumDrawThreads * kImagesPerDrawThread *
+            kDrawsPerImage,
+        "draws/s", true);
+  }
+
  private:
   LapTimer timer_;
 };
@@ -87,5 +167,13 @@ TEST_F(SoftwareImageDecodeCachePerfTest, FromDrawImage) {
   RunFromImage();
 }
 
+TEST_F(SoftwareImageDecodeCachePerfTest, ConcurrentDrawsSingleShard) {
+  RunConcurrentDraws(1u);
+}
+
+TEST_F(SoftwareImageDecodeCachePerfTest, ConcurrentDrawsDefaultShards) {
+  RunConcurrentDraws(SoftwareImageDecodeCache::kDefaultNumShards);
+}
+
 }  // namespace
 }  // namespace cc
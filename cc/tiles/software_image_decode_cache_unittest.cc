@@ -4,11 +4,13 @@
 
 #include "cc/tiles/software_image_decode_cache.h"
 
+#include "base/threading/simple_thread.h"
 #include "cc/paint/draw_image.h"
 #include "cc/paint/paint_image_builder.h"
 #include "cc/test/fake_paint_image_generator.h"
 #include "cc/test/skia_common.h"
 #include "cc/test/test_tile_task_runner.h"
+#include "cc/tiles/shared_decoded_image_cache.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "third_party/skia/include/core/SkRefCnt.h"
 
@@ -1630,6 +1632,138 @@ TEST(SoftwareImageDecodeCacheTest, ClearCache) {
   EXPECT_EQ(0u, cache.GetNumCacheEntriesForTesting());
 }
 
+TEST(SoftwareImageDecodeCacheTest, ReduceCacheUsageKeepsCacheWithinLimit) {
+  // With many more shards than images, some shards hold more than their even
+  // share of the limit, though the cache as a whole is within it.
+  SoftwareImageDecodeCache cache(kN32_SkColorType, kLockedMemoryLimitBytes,
+                                 1000u);
+  bool is_decomposable = true;
+  SkFilterQuality quality = kHigh_SkFilterQuality;
+
+  for (int i = 0; i < 200; ++i) {
+    PaintImage paint_image = CreatePaintImage(10, 10);
+    DrawImage draw_image(
+        paint_image, SkIRect::MakeWH(paint_image.width(), paint_image.height()),
+        quality, CreateMatrix(SkSize::Make(1.0f, 1.0f), is_decomposable),
+        PaintImage::kDefaultFrameIndex, DefaultColorSpace());
+    ImageDecodeCache::TaskResult result = cache.GetTaskForImageAndRef(
+        draw_image, ImageDecodeCache::TracingInfo());
+    EXPECT_TRUE(result.need_unref);
+    EXPECT_TRUE(result.task);
+    TestTileTaskRunner::ProcessTask(result.task.get());
+    cache.UnrefImage(draw_image);
+  }
+  EXPECT_EQ(200u, cache.GetNumCacheEntriesForTesting());
+
+  // Nothing is removed while the cache is within its limit.
+  cache.ReduceCacheUsage();
+  EXPECT_EQ(200u, cache.GetNumCacheEntriesForTesting());
+
+  cache.ClearCache();
+  EXPECT_EQ(0u, cache.GetNumCacheEntriesForTesting());
+}
+
+TEST(SoftwareImageDecodeCacheTest, ConcurrentAtRasterDraws) {
+  SoftwareImageDecodeCache cache(kN32_SkColorType, kLockedMemoryLimitBytes,
+                                 4u);
+  ASSERT_EQ(4u, cache.GetNumShardsForTesting());
+  bool is_decomposable = true;
+
+  // Draw both the original and a scaled version of each image, so that scaled
+  // decodes look up their source decode while other threads use the cache.
+  std::vector<DrawImage> draw_images;
+  for (int i = 0; i < 16; ++i) {
+    PaintImage paint_image = CreatePaintImage(100, 100);
+    for (float scale : {1.0f, 0.5f}) {
+      draw_images.emplace_back(
+          paint_image,
+          SkIRect::MakeWH(paint_image.width(), paint_image.height()),
+          kMedium_SkFilterQuality,
+          CreateMatrix(SkSize::Make(scale, scale), is_decomposable),
+          PaintImage::kDefaultFrameIndex, DefaultColorSpace());
+    }
+  }
+
+  class DrawDelegate : public base::DelegateSimpleThread::Delegate {
+   public:
+    DrawDelegate(SoftwareImageDecodeCache* cache,
+                 const std::vector<DrawImage>* draw_images)
+        : cache_(cache), draw_images_(draw_images) {}
+
+    void Run() override {
+      for (int i = 0; i < 10; ++i) {
+        for (const auto& draw_image : *draw_images_) {
+          DecodedDrawImage decoded_draw_image =
+              cache_->GetDecodedImageForDraw(draw_image);
+          EXPECT_TRUE(decoded_draw_image.image());
+          EXPECT_TRUE(decoded_draw_image.is_at_raster_decode());
+          cache_->DrawWithImageFinished(draw_image, decoded_draw_image);
+        }
+      }
+    }
+
+   private:
+    SoftwareImageDecodeCache* cache_;
+    const std::vector<DrawImage>* draw_images_;
+  };
+
+  DrawDelegate delegate(&cache, &draw_images);
+  base::DelegateSimpleThreadPool pool("DrawThread", 4);
+  pool.AddWork(&delegate, 4);
+  pool.Start();
+  pool.JoinAll();
+
+  // Each image has its original decode, used as the source for scaling, and a
+  // scaled decode.
+  EXPECT_EQ(32u, cache.GetNumCacheEntriesForTesting());
+  cache.ClearCache();
+  EXPECT_EQ(0u, cache.GetNumCacheEntriesForTesting());
+}
+
+TEST(SoftwareImageDecodeCacheTest, SharedCacheKeepsDecodesAcrossCaches) {
+  SharedDecodedImageCache shared_cache(kLockedMemoryLimitBytes);
+  bool is_decomposable = true;
+  PaintImage paint_image = CreatePaintImage(100, 100);
+  DrawImage draw_image(
+      paint_image, SkIRect::MakeWH(paint_image.width(), paint_image.height()),
+      kLow_SkFilterQuality,
+      CreateMatrix(SkSize::Make(1.0f, 1.0f), is_decomposable),
+      PaintImage::kDefaultFrameIndex, DefaultColorSpace());
+
+  {
+    TestSoftwareImageDecodeCache cache;
+    cache.set_shared_decoded_image_cache(&shared_cache);
+    ImageDecodeCache::TaskResult result = cache.GetTaskForImageAndRef(
+        draw_image, ImageDecodeCache::TracingInfo());
+    ASSERT_TRUE(result.task);
+    TestTileTaskRunner::ProcessTask(result.task.get());
+    cache.UnrefImage(draw_image);
+
+    // Clearing the cache, as done on navigation, hands the decode over.
+    cache.ClearCache();
+    EXPECT_EQ(0u, cache.GetNumCacheEntriesForTesting());
+    EXPECT_EQ(1u, shared_cache.GetNumEntriesForTesting());
+
+    // The decode is picked up again instead of decoding the image.
+    DecodedDrawImage decoded_draw_image =
+        cache.GetDecodedImageForDraw(draw_image);
+    EXPECT_TRUE(decoded_draw_image.image());
+    EXPECT_EQ(0u, shared_cache.GetNumEntriesForTesting());
+    cache.DrawWithImageFinished(draw_image, decoded_draw_image);
+  }
+
+  // Destroying the cache also hands over its unlocked decodes.
+  EXPECT_EQ(1u, shared_cache.GetNumEntriesForTesting());
+
+  TestSoftwareImageDecodeCache other_cache;
+  other_cache.set_shared_decoded_image_cache(&shared_cache);
+  DecodedDrawImage decoded_draw_image =
+      other_cache.GetDecodedImageForDraw(draw_image);
+  EXPECT_TRUE(decoded_draw_image.image());
+  EXPECT_EQ(0u, shared_cache.GetNumEntriesForTesting());
+  other_cache.DrawWithImageFinished(draw_image, decoded_draw_image);
+}
+
 TEST(SoftwareImageDecodeCacheTest, RemoveUnusedImage) {
   TestSoftwareImageDecodeCache cache;
   bool is_decomposable = true;
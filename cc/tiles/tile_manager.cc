@@ -40,6 +40,10 @@ namespace {
 // a tile is of solid color.
 const bool kUseColorEstimator = true;
 
+// Retaining the content of an evicted tile compresses it on the compositor
+// thread, so only this many are retained per AssignGpuMemoryToTiles().
+const int kMaxEvictedTilesToRetainPerAssign = 4;
+
 // TODO(enne): remove this histogram and its monitoring in M58 once there is
 // enough new data from the other two raster task timers.
 DEFINE_SCOPED_UMA_HISTOGRAM_AREA_TIMER(
@@ -361,6 +365,7 @@ TileManager::TileManager(
       task_runner_(origin_task_runner),
       resource_pool_(nullptr),
       tile_task_manager_(nullptr),
+      task_graph_runner_(nullptr),
       scheduled_raster_task_limit_(scheduled_raster_task_limit),
       tile_manager_settings_(tile_manager_settings),
       use_gpu_rasterization_(false),
@@ -405,6 +410,7 @@ void TileManager::FinishTasksAndCleanUp() {
   tile_task_manager_->CheckForCompletedTasks();
 
   tile_task_manager_ = nullptr;
+  task_graph_runner_ = nullptr;
   resource_pool_ = nullptr;
   more_tiles_need_prepare_check_notifier_.Cancel();
   signals_check_notifier_.Cancel();
@@ -434,6 +440,7 @@ void TileManager::SetResources(ResourcePool* resource_pool,
   resource_pool_ = resource_pool;
   image_controller_.SetImageDecodeCache(image_decode_cache);
   tile_task_manager_ = TileTaskManagerImpl::Create(task_graph_runner);
+  task_graph_runner_ = task_graph_runner;
   raster_buffer_provider_ = raster_buffer_provider;
 }
 
@@ -443,6 +450,8 @@ void TileManager::Release(Tile* tile) {
   DCHECK_GE(num_of_tiles_with_checker_images_, 0);
 
   FreeResourcesForTile(tile);
+  if (raster_buffer_provider_)
+    raster_buffer_provider_->DiscardEvictedContent(tile->id());
   tiles_.erase(tile->id());
 }
 
@@ -587,11 +596,14 @@ TileManager::FreeTileResourcesUntilUsageIsWithinLimit(
       eviction_priority_queue =
           client_->BuildEvictionQueue(global_state_.tree_priority);
     }
-    if (eviction_priority_queue->IsEmpty())
+    if (eviction_priority_queue->IsEmpty()) {
+      FreeRetainedEvictedContentUntilUsageIsWithinLimit(limit, usage);
       break;
+    }
 
     Tile* tile = eviction_priority_queue->Top().tile();
     *usage -= MemoryUsage::FromTile(tile);
+    RetainEvictedTileContent(eviction_priority_queue->Top(), usage);
     FreeResourcesForTileAndNotifyClientIfTileWasReadyToDraw(tile);
     eviction_priority_queue->Pop();
   }
@@ -609,15 +621,17 @@ TileManager::FreeTileResourcesWithLowerPriorityUntilUsageIsWithinLimit(
       eviction_priority_queue =
           client_->BuildEvictionQueue(global_state_.tree_priority);
     }
-    if (eviction_priority_queue->IsEmpty())
+    if (eviction_priority_queue->IsEmpty() ||
+        !other_priority.IsHigherPriorityThan(
+            eviction_priority_queue->Top().priority())) {
+      FreeRetainedEvictedContentUntilUsageIsWithinLimit(limit, usage);
       break;
+    }
 
     const PrioritizedTile& prioritized_tile = eviction_priority_queue->Top();
-    if (!other_priority.IsHigherPriorityThan(prioritized_tile.priority()))
-      break;
-
     Tile* tile = prioritized_tile.tile();
     *usage -= MemoryUsage::FromTile(tile);
+    RetainEvictedTileContent(prioritized_tile, usage);
     FreeResourcesForTileAndNotifyClientIfTileWasReadyToDraw(tile);
     eviction_priority_queue->Pop();
   }
@@ -663,8 +677,11 @@ TileManager::PrioritizedWorkToSchedule TileManager::AssignGpuMemoryToTiles() {
                                 global_state_.num_resources_limit);
   MemoryUsage soft_memory_limit(global_state_.soft_memory_limit_in_bytes,
                                 global_state_.num_resources_limit);
-  MemoryUsage memory_usage(resource_pool_->memory_usage_bytes(),
-                           resource_pool_->resource_count());
+  MemoryUsage memory_usage(
+      resource_pool_->memory_usage_bytes() +
+          raster_buffer_provider_->GetRetainedEvictedContentBytes(),
+      resource_pool_->resource_count());
+  num_evicted_tiles_retained_ = 0;
 
   gfx::ColorSpace raster_color_space = client_->GetRasterColorSpace();
 
@@ -872,6 +889,50 @@ void TileManager::FreeResourcesForTile(Tile* tile) {
   }
 }
 
+void TileManager::RetainEvictedTileContent(
+    const PrioritizedTile& prioritized_tile,
+    MemoryUsage* usage) {
+  // Only content that may be needed again, and that is complete, is worth
+  // keeping. Checker-imaged content has to be rastered again with its images.
+  if (global_state_.memory_limit_policy == ALLOW_NOTHING ||
+      prioritized_tile.priority().priority_bin == TilePriority::NOW ||
+      num_evicted_tiles_retained_ >= kMaxEvictedTilesToRetainPerAssign) {
+    return;
+  }
+  const TileDrawInfo& draw_info = prioritized_tile.tile()->draw_info();
+  if (draw_info.mode() != TileDrawInfo::RESOURCE_MODE ||
+      !draw_info.IsReadyToDraw() || draw_info.is_checker_imaged()) {
+    return;
+  }
+  size_t old_bytes = raster_buffer_provider_->GetRetainedEvictedContentBytes();
+  raster_buffer_provider_->RetainEvictedContent(draw_info.resource(),
+                                                prioritized_tile.tile()->id());
+  size_t new_bytes = raster_buffer_provider_->GetRetainedEvictedContentBytes();
+  // Only the compressed bytes count against the budget, which leaves room for
+  // more prepaint tiles than the tile's resource did.
+  *usage += MemoryUsage(new_bytes, 0);
+  *usage -= MemoryUsage(old_bytes, 0);
+  num_evicted_tiles_retained_++;
+}
+
+// Retained content is only freed once no tile resource of lower priority is
+// left to evict, so that content compressed by an eviction loop isn't freed by
+// its next iteration.
+void TileManager::FreeRetainedEvictedContentUntilUsageIsWithinLimit(
+    const MemoryUsage& limit,
+    MemoryUsage* usage) {
+  int64_t excess_bytes = usage->memory_bytes() - limit.memory_bytes();
+  if (excess_bytes <= 0)
+    return;
+  size_t old_bytes = raster_buffer_provider_->GetRetainedEvictedContentBytes();
+  if (!old_bytes)
+    return;
+  raster_buffer_provider_->ReduceRetainedEvictedContent(
+      old_bytes - std::min(old_bytes, static_cast<size_t>(excess_bytes)));
+  size_t new_bytes = raster_buffer_provider_->GetRetainedEvictedContentBytes();
+  *usage -= MemoryUsage(old_bytes - new_bytes, 0);
+}
+
 void TileManager::FreeResourcesForTileAndNotifyClientIfTileWasReadyToDraw(
     Tile* tile) {
   bool was_ready_to_draw = tile->draw_info().IsReadyToDraw();
@@ -1145,6 +1206,14 @@ scoped_refptr<TileTask> TileManager::CreateRasterTask(
   const bool skip_images =
       prioritized_tile.priority().resolution == LOW_RESOLUTION;
   playback_settings.use_lcd_text = tile->can_use_lcd_text();
+  // Banded raster shares the tile's ImageProvider across worker threads, which
+  // is only safe for the thread-safe software image decode cache.
+  if (!use_gpu_rasterization_ &&
+      tile_manager_settings_.max_parallel_raster_bands_per_tile > 1) {
+    playback_settings.parallel_raster_task_graph_runner = task_graph_runner_;
+    playback_settings.max_parallel_raster_bands =
+        tile_manager_settings_.max_parallel_raster_bands_per_tile;
+  }
 
   // Create and queue all image decode tasks that this tile depends on. Note
   // that we need to store the images for decode tasks in
@@ -328,6 +328,11 @@ class CC_EXPORT TileManager : CheckerImageTrackerClient {
 
   void FreeResourcesForTile(Tile* tile);
   void FreeResourcesForTileAndNotifyClientIfTileWasReadyToDraw(Tile* tile);
+  void RetainEvictedTileContent(const PrioritizedTile& prioritized_tile,
+                                MemoryUsage* usage);
+  void FreeRetainedEvictedContentUntilUsageIsWithinLimit(
+      const MemoryUsage& limit,
+      MemoryUsage* usage);
   scoped_refptr<TileTask> CreateRasterTask(
       const PrioritizedTile& prioritized_tile,
       const gfx::ColorSpace& color_space,
@@ -387,6 +392,7 @@ class CC_EXPORT TileManager : CheckerImageTrackerClient {
   base::SequencedTaskRunner* task_runner_;
   ResourcePool* resource_pool_;
   std::unique_ptr<TileTaskManager> tile_task_manager_;
+  TaskGraphRunner* task_graph_runner_;
   RasterBufferProvider* raster_buffer_provider_;
   GlobalStateThatImpactsTilePriority global_state_;
   size_t scheduled_raster_task_limit_;
@@ -434,6 +440,10 @@ class CC_EXPORT TileManager : CheckerImageTrackerClient {
   // will create a checker-imaged resource.
   int num_of_tiles_with_checker_images_ = 0;
 
+  // Number of evicted tiles whose content was retained by the raster buffer
+  // provider in the current AssignGpuMemoryToTiles().
+  int num_evicted_tiles_retained_ = 0;
+
   // We need two WeakPtrFactory objects as the invalidation pattern of each is
   // different. The |task_set_finished_weak_ptr_factory_| is invalidated any
   // time new tasks are scheduled, preventing a race when the callback has
@@ -24,6 +24,7 @@
 #include "cc/test/test_layer_tree_host_base.h"
 #include "cc/test/test_task_graph_runner.h"
 #include "cc/test/test_tile_priorities.h"
+#include "cc/tiles/scroll_predictor.h"
 #include "cc/tiles/tile.h"
 #include "cc/tiles/tile_priority.h"
 #include "cc/trees/layer_tree_impl.h"
@@ -289,6 +290,79 @@ class TileManagerPerfTest : public TestLayerTreeHostBase {
                            timer_.LapsPerSecond(), "runs/s", true);
   }
 
+  // Flings down a long layer while only a few tiles can be rastered each
+  // frame, and reports the percentage of visible tiles that are checkerboarded
+  // with and without the fling predicted.
+  void RunFlingCheckerboardTest(const std::string& test_name,
+                                bool predict_scroll) {
+    const int kFrames = 120;
+    const int kTilesRasteredPerFrame = 4;
+    const base::TimeDelta kFrameInterval =
+        base::TimeDelta::FromMilliseconds(16);
+    const float kFlingDecelerationPerFrame = 0.97f;
+
+    host_impl()->ResetTreesForTesting();
+    gfx::Size tile_size = LayerTreeSettings().default_tile_size;
+    gfx::Size layer_bounds(4 * tile_size.width(), 200 * tile_size.height());
+    gfx::Size viewport(layer_bounds.width(), 3 * tile_size.height());
+    host_impl()->SetViewportSize(viewport);
+    SetupPendingTree(FakeRasterSource::CreateFilled(layer_bounds), tile_size,
+                     Region());
+    ActivateTree();
+    FakePictureLayerImpl* layer = active_layer();
+
+    ScrollPredictor* scroll_predictor =
+        host_impl()->scroll_predictor_for_testing();
+    scroll_predictor->Reset();
+    if (predict_scroll)
+      scroll_predictor->StartFling(layer->scroll_tree_index());
+
+    float velocity = 8000.f;
+    float offset = 0.f;
+    int visible_tiles = 0;
+    int checkerboarded_tiles = 0;
+    for (int frame = 0; frame < kFrames; ++frame) {
+      host_impl()->AdvanceToNextFrame(kFrameInterval);
+      offset += velocity * kFrameInterval.InSecondsF();
+      velocity *= kFlingDecelerationPerFrame;
+
+      gfx::Rect visible_rect(gfx::Point(0, static_cast<int>(offset)), viewport);
+      layer->set_visible_layer_rect(visible_rect);
+      if (predict_scroll) {
+        scroll_predictor->AddScrollOffsetSample(
+            gfx::ScrollOffset(0, offset),
+            host_impl()->CurrentBeginFrameArgs().frame_time);
+      }
+      layer->UpdateTiles();
+
+      // This frame draws the tiles rastered in previous frames.
+      PictureLayerTiling* tiling = layer->HighResTiling();
+      for (TilingData::Iterator iter(&tiling->TilingDataForTesting(),
+                                     visible_rect, false);
+           iter; ++iter) {
+        Tile* tile = tiling->TileAt(iter.index_x(), iter.index_y());
+        ++visible_tiles;
+        if (!tile || !tile->draw_info().IsReadyToDraw())
+          ++checkerboarded_tiles;
+      }
+
+      std::unique_ptr<RasterTilePriorityQueue> queue(
+          host_impl()->BuildRasterQueue(SMOOTHNESS_TAKES_PRIORITY,
+                                        RasterTilePriorityQueue::Type::ALL));
+      for (int i = 0; i < kTilesRasteredPerFrame && !queue->IsEmpty(); ++i) {
+        queue->Top().tile()->draw_info().SetSolidColorForTesting(
+            SK_ColorWHITE);
+        queue->Pop();
+      }
+    }
+    scroll_predictor->Reset();
+
+    perf_test::PrintResult("tile_manager_fling_checkerboarded_tiles", "",
+                           test_name,
+                           100.f * checkerboarded_tiles / visible_tiles, "%",
+                           false);
+  }
+
   TileManager* tile_manager() { return host_impl()->tile_manager(); }
 
  protected:
@@ -307,6 +381,11 @@ TEST_F(TileManagerPerfTest, PrepareTiles) {
   RunPrepareTilesTest("50_1000", 100, 1000);
 }
 
+TEST_F(TileManagerPerfTest, FlingCheckerboard) {
+  RunFlingCheckerboardTest("extrapolated", false);
+  RunFlingCheckerboardTest("predicted", true);
+}
+
 TEST_F(TileManagerPerfTest, RasterTileQueueConstruct) {
   RunRasterQueueConstructTest("2", 2);
   RunRasterQueueConstructTest("10", 10);
@@ -14,6 +14,7 @@ struct CC_EXPORT TileManagerSettings {
   bool enable_checker_imaging = false;
   size_t min_image_bytes_to_checker = 1 * 1024 * 1024;
   bool enable_image_animations = false;
+  int max_parallel_raster_bands_per_tile = 1;
 };
 
 }  // namespace cc
@@ -54,6 +54,8 @@ void TilePriority::AsValueInto(base::trace_event::TracedValue* state) const {
   state->SetString("priority_bin", TilePriorityBinToString(priority_bin));
   state->SetDouble("distance_to_visible",
                    MathUtil::AsDoubleSafely(distance_to_visible));
+  state->SetDouble("time_to_visible_in_seconds",
+                   MathUtil::AsDoubleSafely(time_to_visible_in_seconds));
 }
 
 std::string TileMemoryLimitPolicyToString(TileMemoryLimitPolicy policy) {
@@ -44,14 +44,16 @@ struct CC_EXPORT TilePriority {
   TilePriority()
       : resolution(NON_IDEAL_RESOLUTION),
         priority_bin(EVENTUALLY),
-        distance_to_visible(std::numeric_limits<float>::infinity()) {}
+        distance_to_visible(std::numeric_limits<float>::infinity()),
+        time_to_visible_in_seconds(std::numeric_limits<float>::infinity()) {}
 
   TilePriority(TileResolution resolution,
                PriorityBin bin,
                float distance_to_visible)
       : resolution(resolution),
         priority_bin(bin),
-        distance_to_visible(distance_to_visible) {}
+        distance_to_visible(distance_to_visible),
+        time_to_visible_in_seconds(std::numeric_limits<float>::infinity()) {}
 
   void AsValueInto(base::trace_event::TracedValue* dict) const;
 
@@ -61,9 +63,23 @@ struct CC_EXPORT TilePriority {
             distance_to_visible < other.distance_to_visible);
   }
 
+  // Like IsHigherPriorityThan(), but within a bin, tiles that a predicted
+  // scroll brings into view sooner come first. Each layer's raster queue still
+  // iterates its tiles by distance, so this only decides which layer's tile is
+  // rastered next.
+  bool IsHigherRasterPriorityThan(const TilePriority& other) const {
+    if (priority_bin != other.priority_bin)
+      return priority_bin < other.priority_bin;
+    if (time_to_visible_in_seconds != other.time_to_visible_in_seconds)
+      return time_to_visible_in_seconds < other.time_to_visible_in_seconds;
+    return distance_to_visible < other.distance_to_visible;
+  }
+
   TileResolution resolution;
   PriorityBin priority_bin;
   float distance_to_visible;
+  // Infinite unless a predicted scroll brings the tile into view.
+  float time_to_visible_in_seconds;
 };
 
 std::string TilePriorityBinToString(TilePriority::PriorityBin bin);
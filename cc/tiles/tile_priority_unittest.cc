@@ -42,4 +42,31 @@ TEST(TilePriorityTest, IsHigherPriorityThan) {
   EXPECT_FALSE(close_soon.IsHigherPriorityThan(now));
 }
 
+TEST(TilePriorityTest, IsHigherRasterPriorityThan) {
+  TilePriority now(HIGH_RESOLUTION, TilePriority::NOW, 0);
+  TilePriority close_soon(HIGH_RESOLUTION, TilePriority::SOON, 1);
+  TilePriority far_soon_ahead(HIGH_RESOLUTION, TilePriority::SOON, 500);
+  far_soon_ahead.time_to_visible_in_seconds = 0.5f;
+  TilePriority farther_soon_ahead(HIGH_RESOLUTION, TilePriority::SOON, 1000);
+  farther_soon_ahead.time_to_visible_in_seconds = 1.f;
+  TilePriority eventually_ahead(HIGH_RESOLUTION, TilePriority::EVENTUALLY, 2);
+  eventually_ahead.time_to_visible_in_seconds = 0.1f;
+
+  // Within a bin, tiles that a scroll brings into view sooner come first,
+  // regardless of their distance.
+  EXPECT_TRUE(far_soon_ahead.IsHigherRasterPriorityThan(close_soon));
+  EXPECT_TRUE(far_soon_ahead.IsHigherRasterPriorityThan(farther_soon_ahead));
+  EXPECT_TRUE(farther_soon_ahead.IsHigherRasterPriorityThan(close_soon));
+  EXPECT_FALSE(close_soon.IsHigherRasterPriorityThan(far_soon_ahead));
+  EXPECT_FALSE(farther_soon_ahead.IsHigherRasterPriorityThan(far_soon_ahead));
+
+  // Time doesn't order tiles for anything else.
+  EXPECT_TRUE(close_soon.IsHigherPriorityThan(far_soon_ahead));
+
+  // The bin still matters most.
+  EXPECT_TRUE(now.IsHigherRasterPriorityThan(far_soon_ahead));
+  EXPECT_TRUE(close_soon.IsHigherRasterPriorityThan(eventually_ahead));
+  EXPECT_FALSE(eventually_ahead.IsHigherRasterPriorityThan(farther_soon_ahead));
+}
+
 }  // namespace cc
@@ -6,6 +6,7 @@
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <vector>
 
 #include "base/containers/stack.h"
@@ -741,19 +742,127 @@ static void UpdateRenderTarget(EffectTree* effect_tree) {
   }
 }
 
-static void ComputeClips(PropertyTrees* property_trees) {
+// Returns true if |updated_nodes| flags node |id|. |updated_nodes| may be
+// empty, in which case no node is flagged.
+static bool WasUpdated(const std::vector<bool>& updated_nodes, int id) {
+  return id >= 0 && static_cast<size_t>(id) < updated_nodes.size() &&
+         updated_nodes[id];
+}
+
+// Flags the roots of the subtrees of |tree| that need an update in
+// |updated_nodes|, and returns the smallest of their ids (or the size of the
+// tree if there are none). Since a node's parent always precedes it, the dirty
+// subtrees can then be updated in a single forward pass starting at that id.
+template <typename PropertyTreeType>
+static int MarkDirtySubtreeRoots(const PropertyTreeType& tree,
+                                 std::vector<bool>* updated_nodes) {
+  updated_nodes->assign(tree.size(), false);
+  int first_dirty_id = static_cast<int>(tree.size());
+  for (int id : tree.dirty_subtree_roots()) {
+    (*updated_nodes)[id] = true;
+    first_dirty_id = std::min(first_dirty_id, id);
+  }
+  return first_dirty_id;
+}
+
+// Updates the transform nodes that need it. On return, |updated_nodes| flags
+// every node that was recomputed, and is empty if none was.
+static void ComputeTransformsInternal(TransformTree* transform_tree,
+                                      std::vector<bool>* updated_nodes) {
+  updated_nodes->clear();
+  if (!transform_tree->needs_update())
+    return;
+  const int size = static_cast<int>(transform_tree->size());
+  if (transform_tree->needs_full_update()) {
+    updated_nodes->assign(size, true);
+    for (int i = TransformTree::kContentsRootNodeId; i < size; ++i)
+      transform_tree->UpdateTransforms(i);
+    transform_tree->set_needs_update(false);
+    return;
+  }
+
+  int first_dirty_id = MarkDirtySubtreeRoots(*transform_tree, updated_nodes);
+  for (int i = std::max(first_dirty_id, TransformTree::kContentsRootNodeId);
+       i < size; ++i) {
+    TransformNode* node = transform_tree->Node(i);
+    // Besides the dirty subtrees, a node depends on its source node (which
+    // may not be an ancestor, e.g. for fixed-position layers) and, when
+    // sticky, on the scroll offset of its containing scroller. A source node
+    // that comes after the node can't be handled in a forward pass, so such
+    // nodes are always recomputed.
+    bool needs_update =
+        (*updated_nodes)[i] || (*updated_nodes)[node->parent_id] ||
+        WasUpdated(*updated_nodes, node->source_node_id) ||
+        node->source_node_id > i || node->sticky_position_constraint_id >= 0;
+    if (!needs_update)
+      continue;
+    (*updated_nodes)[i] = true;
+    transform_tree->UpdateTransforms(i);
+  }
+  transform_tree->set_needs_update(false);
+}
+
+// Updates the effect nodes that need it, including those whose transform node
+// is flagged in |updated_transforms|.
+static void ComputeEffectsInternal(
+    EffectTree* effect_tree,
+    const std::vector<bool>& updated_transforms) {
+  if (!effect_tree->needs_update() && updated_transforms.empty())
+    return;
+  const int size = static_cast<int>(effect_tree->size());
+  if (effect_tree->needs_full_update()) {
+    for (int i = EffectTree::kContentsRootNodeId; i < size; ++i)
+      effect_tree->UpdateEffects(i);
+    effect_tree->set_needs_update(false);
+    return;
+  }
+
+  std::vector<bool> updated_nodes;
+  int first_dirty_id = MarkDirtySubtreeRoots(*effect_tree, &updated_nodes);
+  if (!updated_transforms.empty())
+    first_dirty_id = EffectTree::kContentsRootNodeId;
+  for (int i = std::max(first_dirty_id, EffectTree::kContentsRootNodeId);
+       i < size; ++i) {
+    EffectNode* node = effect_tree->Node(i);
+    // Every child of an updated node is updated too, which keeps
+    // |has_masking_child| (reset on the parent and set by its children)
+    // consistent.
+    bool needs_update = updated_nodes[i] || updated_nodes[node->parent_id] ||
+                        WasUpdated(updated_transforms, node->transform_id);
+    if (!needs_update)
+      continue;
+    updated_nodes[i] = true;
+    effect_tree->UpdateEffects(i);
+  }
+  effect_tree->set_needs_update(false);
+}
+
+static void ComputeClips(PropertyTrees* property_trees,
+                         const std::vector<bool>& updated_transforms) {
   DCHECK(!property_trees->transform_tree.needs_update());
   ClipTree* clip_tree = &property_trees->clip_tree;
-  if (!clip_tree->needs_update())
+  if (!clip_tree->needs_update() && updated_transforms.empty())
     return;
+  const bool full_update = clip_tree->needs_full_update();
+  std::vector<bool> updated_nodes;
+  MarkDirtySubtreeRoots(*clip_tree, &updated_nodes);
   const int target_effect_id = EffectTree::kContentsRootNodeId;
   const int target_transform_id = TransformTree::kRootNodeId;
   const bool include_expanding_clips = true;
   for (int i = ClipTree::kViewportNodeId;
        i < static_cast<int>(clip_tree->size()); ++i) {
     ClipNode* clip_node = clip_tree->Node(i);
-    // Clear the clip rect cache
+    // Clear the clip rect cache. The cached rects are relative to render
+    // targets, whose transforms may have changed even if this node's did not.
     clip_node->cached_clip_rects->clear();
+    // Expanding clips depend on their effect node's filters, so they are
+    // always recomputed.
+    if (!full_update && !updated_nodes[i] &&
+        !WasUpdated(updated_nodes, clip_node->parent_id) &&
+        !WasUpdated(updated_transforms, clip_node->transform_id) &&
+        !clip_node->clip_expander)
+      continue;
+    updated_nodes[i] = true;
     if (clip_node->id == ClipTree::kViewportNodeId) {
       clip_node->cached_accumulated_rect_in_screen_space = clip_node->clip;
       continue;
@@ -771,6 +880,26 @@ static void ComputeClips(PropertyTrees* property_trees) {
   clip_tree->set_needs_update(false);
 }
 
+static void ComputeTransformsEffectsAndClips(PropertyTrees* property_trees) {
+  // Unless the whole transform tree is updated, only the effect and clip nodes
+  // that depend on updated transform nodes are updated along with them.
+  std::vector<bool> updated_transforms;
+  ComputeTransformsInternal(&property_trees->transform_tree,
+                            &updated_transforms);
+  ComputeEffectsInternal(&property_trees->effect_tree, updated_transforms);
+  // Computation of clips uses ToScreen which is updated while computing
+  // transforms. So, ComputeTransforms should be before ComputeClips.
+  ComputeClips(property_trees, updated_transforms);
+}
+
+static void UpdatePropertyTreesInternal(PropertyTrees* property_trees) {
+  if (property_trees->transform_tree.needs_full_update()) {
+    property_trees->clip_tree.set_needs_update(true);
+    property_trees->effect_tree.set_needs_update(true);
+  }
+  ComputeTransformsEffectsAndClips(property_trees);
+}
+
 }  // namespace
 
 void ConcatInverseSurfaceContentsScale(const EffectNode* effect_node,
@@ -848,21 +977,12 @@ void FindLayersThatNeedUpdates(LayerTreeImpl* layer_tree_impl,
 }
 
 void ComputeTransforms(TransformTree* transform_tree) {
-  if (!transform_tree->needs_update())
-    return;
-  for (int i = TransformTree::kContentsRootNodeId;
-       i < static_cast<int>(transform_tree->size()); ++i)
-    transform_tree->UpdateTransforms(i);
-  transform_tree->set_needs_update(false);
+  std::vector<bool> updated_nodes;
+  ComputeTransformsInternal(transform_tree, &updated_nodes);
 }
 
 void ComputeEffects(EffectTree* effect_tree) {
-  if (!effect_tree->needs_update())
-    return;
-  for (int i = EffectTree::kContentsRootNodeId;
-       i < static_cast<int>(effect_tree->size()); ++i)
-    effect_tree->UpdateEffects(i);
-  effect_tree->set_needs_update(false);
+  ComputeEffectsInternal(effect_tree, std::vector<bool>());
 }
 
 void UpdatePropertyTrees(LayerTreeHost* layer_tree_host,
@@ -870,15 +990,11 @@ void UpdatePropertyTrees(LayerTreeHost* layer_tree_host,
   DCHECK(layer_tree_host);
   DCHECK(property_trees);
   DCHECK_EQ(layer_tree_host->property_trees(), property_trees);
-  if (property_trees->transform_tree.needs_update()) {
-    property_trees->clip_tree.set_needs_update(true);
-    property_trees->effect_tree.set_needs_update(true);
-  }
-  ComputeTransforms(&property_trees->transform_tree);
-  ComputeEffects(&property_trees->effect_tree);
-  // Computation of clips uses ToScreen which is updated while computing
-  // transforms. So, ComputeTransforms should be before ComputeClips.
-  ComputeClips(property_trees);
+  UpdatePropertyTreesInternal(property_trees);
+}
+
+void UpdatePropertyTreesForTesting(PropertyTrees* property_trees) {
+  UpdatePropertyTreesInternal(property_trees);
 }
 
 void UpdatePropertyTreesAndRenderSurfaces(LayerImpl* root_layer,
@@ -890,7 +1006,7 @@ void UpdatePropertyTreesAndRenderSurfaces(LayerImpl* root_layer,
     property_trees->transform_tree.set_needs_update(true);
     render_surfaces_need_update = true;
   }
-  if (property_trees->transform_tree.needs_update()) {
+  if (property_trees->transform_tree.needs_full_update()) {
     property_trees->clip_tree.set_needs_update(true);
     property_trees->effect_tree.set_needs_update(true);
   }
@@ -900,11 +1016,7 @@ void UpdatePropertyTreesAndRenderSurfaces(LayerImpl* root_layer,
   }
   UpdateRenderTarget(&property_trees->effect_tree);
 
-  ComputeTransforms(&property_trees->transform_tree);
-  ComputeEffects(&property_trees->effect_tree);
-  // Computation of clips uses ToScreen which is updated while computing
-  // transforms. So, ComputeTransforms should be before ComputeClips.
-  ComputeClips(property_trees);
+  ComputeTransformsEffectsAndClips(property_trees);
 }
 
 bool LayerNeedsUpdate(Layer* layer,
@@ -988,13 +1100,25 @@ void ComputeDrawPropertiesOfVisibleLayers(const LayerImplList* layer_list,
         LayerVisibleRect(property_trees, layer);
   }
 
-  // Compute drawable content rects
+  // Compute drawable content rects. The layer bounds are mapped to target
+  // space all at once, which is faster than one at a time on large pages.
+  std::vector<const gfx::Transform*> target_space_transforms;
+  std::vector<gfx::Rect> layer_bounds;
+  target_space_transforms.reserve(layer_list->size());
+  layer_bounds.reserve(layer_list->size());
   for (LayerImpl* layer : *layer_list) {
-    gfx::Rect bounds_in_target_space = MathUtil::MapEnclosingClippedRect(
-        layer->draw_properties().target_space_transform,
-        gfx::Rect(layer->bounds()));
+    target_space_transforms.push_back(
+        &layer->draw_properties().target_space_transform);
+    layer_bounds.push_back(gfx::Rect(layer->bounds()));
+  }
+  std::vector<gfx::Rect> bounds_in_target_space(layer_list->size());
+  MathUtil::MapEnclosingClippedRects(
+      target_space_transforms.data(), layer_bounds.data(), layer_list->size(),
+      bounds_in_target_space.data());
+  for (size_t i = 0; i < layer_list->size(); ++i) {
+    LayerImpl* layer = (*layer_list)[i];
     layer->draw_properties().drawable_content_rect = LayerDrawableContentRect(
-        layer, bounds_in_target_space, layer->draw_properties().clip_rect);
+        layer, bounds_in_target_space[i], layer->draw_properties().clip_rect);
   }
 }
 
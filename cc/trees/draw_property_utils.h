@@ -31,15 +31,21 @@ void CC_EXPORT ConcatInverseSurfaceContentsScale(const EffectNode* effect_node,
                                                  gfx::Transform* transform);
 
 // Computes combined (screen space) transforms for every node in the transform
-// tree. This must be done prior to calling |ComputeClips|.
+// tree that needs an update. If only some subtrees were marked as needing an
+// update, only those (and the nodes that depend on them) are recomputed. This
+// must be done prior to calling |ComputeClips|.
 void CC_EXPORT ComputeTransforms(TransformTree* transform_tree);
 
-// Computes screen space opacity for every node in the opacity tree.
+// Computes screen space opacity for every node in the opacity tree that needs
+// an update.
 void CC_EXPORT ComputeEffects(EffectTree* effect_tree);
 
 void CC_EXPORT UpdatePropertyTrees(LayerTreeHost* layer_tree_host,
                                    PropertyTrees* property_trees);
 
+// Like UpdatePropertyTrees(), for property trees without a layer tree.
+void CC_EXPORT UpdatePropertyTreesForTesting(PropertyTrees* property_trees);
+
 void CC_EXPORT
 UpdatePropertyTreesAndRenderSurfaces(LayerImpl* root_layer,
                                      PropertyTrees* property_trees,
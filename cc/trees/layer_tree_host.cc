@@ -1430,7 +1430,7 @@ void LayerTreeHost::SetElementOpacityMutated(ElementId element_id,
       return;
 
     node->opacity = opacity;
-    property_trees_.effect_tree.set_needs_update(true);
+    property_trees_.effect_tree.SetSubtreeNeedsUpdate(node->id);
   }
 
   SetNeedsUpdateLayers();
@@ -1456,7 +1456,7 @@ void LayerTreeHost::SetElementTransformMutated(
     node->local = transform;
     node->needs_local_transform_update = true;
     node->has_potential_animation = true;
-    property_trees_.transform_tree.set_needs_update(true);
+    property_trees_.transform_tree.SetSubtreeNeedsUpdate(node->id);
   }
 
   SetNeedsUpdateLayers();
@@ -19,8 +19,11 @@
 #include "cc/test/fake_layer_tree_host_client.h"
 #include "cc/test/layer_tree_json_parser.h"
 #include "cc/test/layer_tree_test.h"
+#include "cc/trees/draw_property_utils.h"
+#include "cc/trees/element_id.h"
 #include "cc/trees/layer_tree_host_common.h"
 #include "cc/trees/layer_tree_impl.h"
+#include "cc/trees/property_tree.h"
 #include "components/viz/test/paths.h"
 #include "testing/perf/perf_test.h"
 
@@ -138,5 +141,121 @@ TEST_F(CalcDrawPropsTest, TouchRegionHeavy) {
   RunCalcDrawProps();
 }
 
+// Measures updating the property trees of a large tree when a single node
+// animates, which should only recompute the animated subtree.
+class AnimatedNodeUpdatePropertyTreesTest : public LayerTreeHostCommonPerfTest {
+ public:
+  enum class AnimatedProperty { TRANSFORM, OPACITY };
+
+  static const int kNumContainers = 100;
+  static const int kNumLayersPerContainer = 100;
+
+  AnimatedNodeUpdatePropertyTreesTest()
+      : animated_element_id_(1),
+        animated_property_(AnimatedProperty::TRANSFORM),
+        force_full_update_(false) {}
+
+  void RunUpdatePropertyTrees(AnimatedProperty animated_property,
+                              bool force_full_update) {
+    animated_property_ = animated_property;
+    force_full_update_ = force_full_update;
+    RunTest(CompositorMode::SINGLE_THREADED);
+  }
+
+  void SetupTree() override {
+    // Builds a tree of 10k layers, each with its own transform node, clip node
+    // or effect node.
+    gfx::Size viewport = gfx::Size(720, 1038);
+    layer_tree_host()->SetViewportSize(viewport);
+    scoped_refptr<Layer> root = Layer::Create();
+    root->SetBounds(viewport);
+    for (int i = 0; i < kNumContainers; ++i) {
+      scoped_refptr<Layer> container = Layer::Create();
+      gfx::Transform container_transform;
+      container_transform.Rotate(i % 10);
+      container->SetTransform(container_transform);
+      container->SetBounds(gfx::Size(500, 500));
+      container->SetMasksToBounds(true);
+      root->AddChild(container);
+      for (int j = 0; j < kNumLayersPerContainer; ++j) {
+        scoped_refptr<Layer> layer = Layer::Create();
+        gfx::Transform transform;
+        transform.Translate(j, i);
+        transform.Rotate(j % 10);
+        layer->SetTransform(transform);
+        layer->SetOpacity(0.9f);
+        layer->SetBounds(gfx::Size(50, 50));
+        layer->SetIsDrawable(true);
+        if (i == kNumContainers / 2 && j == kNumLayersPerContainer / 2)
+          layer->SetElementId(animated_element_id_);
+        container->AddChild(layer);
+      }
+    }
+    layer_tree_host()->SetRootLayer(root);
+  }
+
+  void BeginTest() override { PostSetNeedsCommitToMainThread(); }
+
+  void DrawLayersOnThread(LayerTreeHostImpl* host_impl) override {
+    LayerTreeImpl* active_tree = host_impl->active_tree();
+    PropertyTrees* property_trees = active_tree->property_trees();
+    LayerImpl* root = active_tree->root_layer_for_testing();
+    bool can_adjust_raster_scales =
+        host_impl->settings().layer_transforms_should_scale_layer_contents;
+
+    timer_.Reset();
+    int frame = 0;
+    do {
+      ++frame;
+      if (animated_property_ == AnimatedProperty::TRANSFORM) {
+        if (force_full_update_)
+          property_trees->transform_tree.set_needs_update(true);
+        gfx::Transform transform;
+        transform.Rotate(frame % 360);
+        property_trees->transform_tree.OnTransformAnimated(
+            animated_element_id_, transform);
+      } else {
+        if (force_full_update_)
+          property_trees->effect_tree.set_needs_update(true);
+        property_trees->effect_tree.OnOpacityAnimated(
+            animated_element_id_, (frame % 100) / 100.f);
+      }
+      draw_property_utils::UpdatePropertyTreesAndRenderSurfaces(
+          root, property_trees, can_adjust_raster_scales);
+
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+
+    EndTest();
+  }
+
+ private:
+  const ElementId animated_element_id_;
+  AnimatedProperty animated_property_;
+  bool force_full_update_;
+};
+
+TEST_F(AnimatedNodeUpdatePropertyTreesTest, TenThousandLayersTransform) {
+  SetTestName("10k_layers_animated_transform");
+  RunUpdatePropertyTrees(AnimatedProperty::TRANSFORM, false);
+}
+
+TEST_F(AnimatedNodeUpdatePropertyTreesTest,
+       TenThousandLayersTransformFullUpdate) {
+  SetTestName("10k_layers_animated_transform_full_update");
+  RunUpdatePropertyTrees(AnimatedProperty::TRANSFORM, true);
+}
+
+TEST_F(AnimatedNodeUpdatePropertyTreesTest, TenThousandLayersOpacity) {
+  SetTestName("10k_layers_animated_opacity");
+  RunUpdatePropertyTrees(AnimatedProperty::OPACITY, false);
+}
+
+TEST_F(AnimatedNodeUpdatePropertyTreesTest,
+       TenThousandLayersOpacityFullUpdate) {
+  SetTestName("10k_layers_animated_opacity_full_update");
+  RunUpdatePropertyTrees(AnimatedProperty::OPACITY, true);
+}
+
 }  // namespace
 }  // namespace cc
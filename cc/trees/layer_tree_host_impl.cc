@@ -59,6 +59,7 @@
 #include "cc/tiles/gpu_image_decode_cache.h"
 #include "cc/tiles/picture_layer_tiling.h"
 #include "cc/tiles/raster_tile_priority_queue.h"
+#include "cc/tiles/shared_decoded_image_cache.h"
 #include "cc/tiles/software_image_decode_cache.h"
 #include "cc/trees/damage_tracker.h"
 #include "cc/trees/debug_rect_history.h"
@@ -519,6 +520,9 @@ void LayerTreeHostImpl::AnimateInternal(bool active_tree) {
   did_animate |= AnimateBrowserControls(monotonic_time);
 
   if (active_tree) {
+    // Scroll animations and flings have ticked, so sample where they are.
+    UpdateScrollPrediction();
+
     // Animating stuff can change the root scroll offset, so inform the
     // synchronous input handler.
     UpdateRootLayerStateForSynchronousInputHandler();
@@ -531,6 +535,22 @@ void LayerTreeHostImpl::AnimateInternal(bool active_tree) {
 }
 
 
+void LayerTreeHostImpl::UpdateScrollPrediction() {
+  if (!scroll_predictor_.is_predicting())
+    return;
+
+  const ScrollTree& scroll_tree = active_tree_->property_trees()->scroll_tree;
+  const ScrollNode* scroll_node =
+      scroll_tree.Node(scroll_predictor_.scroll_node_id());
+  if (!scroll_node) {
+    scroll_predictor_.Reset();
+    return;
+  }
+  scroll_predictor_.AddScrollOffsetSample(
+      scroll_tree.current_scroll_offset(scroll_node->element_id),
+      CurrentBeginFrameArgs().frame_time);
+}
+
 bool LayerTreeHostImpl::PrepareTiles() {
   if (!tile_priorities_dirty_)
     return false;
@@ -1107,6 +1127,15 @@ DrawResult LayerTreeHostImpl::CalculateRenderPasses(FrameData* frame) {
         "Compositing.RenderPass.AppendQuadData."
         "CheckerboardedNeedRasterContentArea",
         checkerboarded_needs_raster_content_area);
+    // How well tiles are rastered ahead of scroll animations and flings.
+    if (scroll_predictor_.is_predicting() && total_visible_area > 0) {
+      UMA_HISTOGRAM_PERCENTAGE(
+          "Compositing.RenderPass.AppendQuadData."
+          "CheckerboardedVisibleAreaPercent.PredictedScroll",
+          100 * (checkerboarded_no_recording_content_area +
+                 checkerboarded_needs_raster_content_area) /
+              total_visible_area);
+    }
   }
 
   TRACE_EVENT_END2("cc", "LayerTreeHostImpl::CalculateRenderPasses",
@@ -2446,10 +2475,15 @@ void LayerTreeHostImpl::CreateTileManagerResources() {
             settings_.preferred_tile_format),
         settings_.decoded_image_working_set_budget_bytes);
   } else {
-    image_decode_cache_ = std::make_unique<SoftwareImageDecodeCache>(
+    auto software_cache = std::make_unique<SoftwareImageDecodeCache>(
         viz::ResourceFormatToClosestSkColorType(
             settings_.preferred_tile_format),
         settings_.decoded_image_working_set_budget_bytes);
+    if (settings_.enable_shared_decoded_image_cache) {
+      software_cache->set_shared_decoded_image_cache(
+          SharedDecodedImageCache::GetInstance());
+    }
+    image_decode_cache_ = std::move(software_cache);
   }
 
   // Pass the single-threaded synchronous task graph runner to the worker pool
@@ -2491,8 +2525,9 @@ void LayerTreeHostImpl::CreateResourceAndRasterBufferProvider(
                              ResourcePool::kDefaultExpirationDelay,
                              settings_.disallow_non_exact_resource_reuse);
 
-    *raster_buffer_provider =
-        BitmapRasterBufferProvider::Create(resource_provider_.get());
+    *raster_buffer_provider = BitmapRasterBufferProvider::Create(
+        resource_provider_.get(),
+        settings_.compressed_software_tile_cache_bytes);
     return;
   }
 
@@ -3193,6 +3228,8 @@ bool LayerTreeHostImpl::ScrollAnimationCreate(ScrollNode* scroll_node,
   mutator_host_->ImplOnlyScrollAnimationCreate(
       scroll_node->element_id, target_offset, current_offset, delayed_by,
       animation_start_offset);
+  scroll_predictor_.SetScrollAnimationTarget(scroll_node->id, current_offset,
+                                             target_offset);
 
   SetNeedsOneBeginImplFrame();
 
@@ -3633,6 +3670,9 @@ InputHandlerScrollResult LayerTreeHostImpl::ScrollBy(
   if (!scroll_node)
     return InputHandlerScrollResult();
 
+  if (scroll_state->is_in_inertial_phase())
+    scroll_predictor_.StartFling(scroll_node->id);
+
   // Flash the overlay scrollbar even if the scroll dalta is 0.
   if (settings_.scrollbar_flash_after_any_scroll_update) {
     FlashAllScrollbars(false);
@@ -3747,6 +3787,7 @@ void LayerTreeHostImpl::ClearCurrentlyScrollingNode() {
   did_lock_scrolling_layer_ = false;
   scroll_affects_scroll_handler_ = false;
   accumulated_root_overscroll_ = gfx::Vector2dF();
+  scroll_predictor_.Reset();
 }
 
 void LayerTreeHostImpl::ScrollEnd(ScrollState* scroll_state) {
@@ -4431,11 +4472,21 @@ bool LayerTreeHostImpl::ScrollAnimationUpdateTarget(
   float scale_factor = active_tree()->current_page_scale_factor();
   gfx::Vector2dF scaled_delta =
       gfx::ScaleVector2d(scroll_delta, 1.f / scale_factor);
-  return mutator_host_->ImplOnlyScrollAnimationUpdateTarget(
+  ScrollTree& scroll_tree = active_tree_->property_trees()->scroll_tree;
+  bool updated = mutator_host_->ImplOnlyScrollAnimationUpdateTarget(
       scroll_node->element_id, scaled_delta,
-      active_tree_->property_trees()->scroll_tree.MaxScrollOffset(
-          scroll_node->id),
+      scroll_tree.MaxScrollOffset(scroll_node->id),
       CurrentBeginFrameArgs().frame_time, delayed_by);
+  if (updated && scroll_predictor_.has_target_offset() &&
+      scroll_predictor_.scroll_node_id() == scroll_node->id) {
+    scroll_predictor_.SetScrollAnimationTarget(
+        scroll_node->id,
+        scroll_tree.current_scroll_offset(scroll_node->element_id),
+        scroll_tree.ClampScrollOffsetToLimits(
+            scroll_predictor_.target_offset() + gfx::ScrollOffset(scaled_delta),
+            *scroll_node));
+  }
+  return updated;
 }
 
 bool LayerTreeHostImpl::IsElementInList(ElementId element_id,
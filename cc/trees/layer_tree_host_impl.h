@@ -33,6 +33,7 @@
 #include "cc/scheduler/video_frame_controller.h"
 #include "cc/tiles/decoded_image_tracker.h"
 #include "cc/tiles/image_decode_cache.h"
+#include "cc/tiles/scroll_predictor.h"
 #include "cc/tiles/tile_manager.h"
 #include "cc/trees/layer_tree_frame_sink_client.h"
 #include "cc/trees/layer_tree_mutator.h"
@@ -571,6 +572,10 @@ class CC_EXPORT LayerTreeHostImpl
   // Viewport rect to be used for tiling prioritization instead of the
   // DeviceViewport().
   const gfx::Rect ViewportRectForTilePriority() const;
+  // Predicts the current impl-side scroll animation or fling, for tile
+  // prioritization.
+  const ScrollPredictor& scroll_predictor() const { return scroll_predictor_; }
+  ScrollPredictor* scroll_predictor_for_testing() { return &scroll_predictor_; }
 
   // When a SwapPromiseMonitor is created on the impl thread, it calls
   // InsertSwapPromiseMonitor() to register itself with LayerTreeHostImpl.
@@ -715,6 +720,7 @@ class CC_EXPORT LayerTreeHostImpl
   bool AnimatePageScale(base::TimeTicks monotonic_time);
   bool AnimateScrollbars(base::TimeTicks monotonic_time);
   bool AnimateBrowserControls(base::TimeTicks monotonic_time);
+  void UpdateScrollPrediction();
 
   void UpdateTileManagerMemoryPolicy(const ManagedMemoryPolicy& policy);
 
@@ -845,6 +851,7 @@ class CC_EXPORT LayerTreeHostImpl
   DecodedImageTracker decoded_image_tracker_;
 
   gfx::Vector2dF accumulated_root_overscroll_;
+  ScrollPredictor scroll_predictor_;
 
   bool pinch_gesture_active_;
   bool pinch_gesture_end_should_clear_scrolling_node_;
@@ -172,7 +172,7 @@ void LayerTreeImpl::DidUpdateScrollOffset(ElementId id) {
   if (transform_node->scroll_offset != scroll_tree.current_scroll_offset(id)) {
     transform_node->scroll_offset = scroll_tree.current_scroll_offset(id);
     transform_node->needs_local_transform_update = true;
-    transform_tree.set_needs_update(true);
+    transform_tree.SetSubtreeNeedsUpdate(transform_node->id);
   }
   transform_node->transform_changed = true;
   property_trees()->changed = true;
@@ -675,7 +675,7 @@ void LayerTreeImpl::UpdatePropertyTreeAnimationFromMainThread() {
       continue;
     }
     node->opacity = element_id_to_opacity->second;
-    property_trees_.effect_tree.set_needs_update(true);
+    property_trees_.effect_tree.SetSubtreeNeedsUpdate(node->id);
     ++element_id_to_opacity;
   }
 
@@ -689,7 +689,7 @@ void LayerTreeImpl::UpdatePropertyTreeAnimationFromMainThread() {
       continue;
     }
     node->filters = element_id_to_filter->second;
-    property_trees_.effect_tree.set_needs_update(true);
+    property_trees_.effect_tree.SetSubtreeNeedsUpdate(node->id);
     ++element_id_to_filter;
   }
 
@@ -705,7 +705,7 @@ void LayerTreeImpl::UpdatePropertyTreeAnimationFromMainThread() {
     }
     node->local = element_id_to_transform->second;
     node->needs_local_transform_update = true;
-    property_trees_.transform_tree.set_needs_update(true);
+    property_trees_.transform_tree.SetSubtreeNeedsUpdate(node->id);
     ++element_id_to_transform;
   }
 
@@ -729,7 +729,7 @@ void LayerTreeImpl::UpdateTransformAnimation(ElementId element_id,
         node->has_potential_animation = has_potential_animation;
         node->has_only_translation_animations =
             mutator_host()->HasOnlyTranslationTransforms(element_id, list_type);
-        transform_tree.set_needs_update(true);
+        transform_tree.SetSubtreeNeedsUpdate(node->id);
         set_needs_update_draw_properties();
       }
     }
@@ -1406,6 +1406,37 @@ const gfx::Rect LayerTreeImpl::ViewportRectForTilePriority() const {
   return host_impl_->ViewportRectForTilePriority();
 }
 
+ScrollPrediction LayerTreeImpl::GetScrollPrediction(
+    int scroll_tree_index,
+    int transform_tree_index) const {
+  const ScrollPredictor& scroll_predictor = host_impl_->scroll_predictor();
+  if (!scroll_predictor.is_predicting())
+    return ScrollPrediction();
+
+  const ScrollTree& scroll_tree = property_trees_.scroll_tree;
+  const ScrollNode* scroll_node = scroll_tree.Node(scroll_tree_index);
+  while (scroll_node && scroll_node->id != scroll_predictor.scroll_node_id())
+    scroll_node = scroll_tree.parent(scroll_node);
+  if (!scroll_node)
+    return ScrollPrediction();
+
+  // The scroll moves the layer's visible rect by the scroll delta only if the
+  // layer is translated relative to the scrolled contents. Layers which are
+  // scaled or rotated, or which aren't positioned in the scroller, e.g. fixed
+  // position ones, get no prediction.
+  const TransformTree& transform_tree = property_trees_.transform_tree;
+  const TransformNode* transform_node =
+      transform_tree.Node(transform_tree_index);
+  while (transform_node && transform_node->id != scroll_node->transform_id) {
+    if (!transform_node->to_parent.IsIdentityOrTranslation())
+      return ScrollPrediction();
+    transform_node = transform_tree.parent(transform_node);
+  }
+  if (!transform_node || !transform_node->local.IsIdentityOrTranslation())
+    return ScrollPrediction();
+  return scroll_predictor.GetPrediction();
+}
+
 std::unique_ptr<ScrollbarAnimationController>
 LayerTreeImpl::CreateScrollbarAnimationController(ElementId scroll_element_id,
                                                   float initial_opacity) {
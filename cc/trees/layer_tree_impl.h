@@ -127,6 +127,11 @@ class CC_EXPORT LayerTreeImpl {
   base::TimeDelta CurrentBeginFrameInterval() const;
   gfx::Rect DeviceViewport() const;
   const gfx::Rect ViewportRectForTilePriority() const;
+  // Returns the predicted scroll of a layer in |scroll_tree_index| and
+  // |transform_tree_index|. Empty unless one of its scroll ancestors is being
+  // predicted, and the layer is only translated relative to that scroller.
+  ScrollPrediction GetScrollPrediction(int scroll_tree_index,
+                                       int transform_tree_index) const;
   std::unique_ptr<ScrollbarAnimationController>
   CreateScrollbarAnimationController(ElementId scroll_element_id,
                                      float initial_opacity);
@@ -48,6 +48,8 @@ TileManagerSettings LayerTreeSettings::ToTileManagerSettings() const {
   tile_manager_settings.enable_checker_imaging = enable_checker_imaging;
   tile_manager_settings.min_image_bytes_to_checker = min_image_bytes_to_checker;
   tile_manager_settings.enable_image_animations = enable_image_animations;
+  tile_manager_settings.max_parallel_raster_bands_per_tile =
+      max_parallel_raster_bands_per_tile;
   return tile_manager_settings;
 }
 
@@ -88,6 +88,9 @@ class CC_EXPORT LayerTreeSettings {
   ManagedMemoryPolicy gpu_memory_policy;
   ManagedMemoryPolicy software_memory_policy;
   size_t decoded_image_working_set_budget_bytes = 128 * 1024 * 1024;
+  // If set to true, software decodes evicted from this tree's image decode
+  // cache are kept in the process-wide SharedDecodedImageCache for reuse.
+  bool enable_shared_decoded_image_cache = false;
   int max_preraster_distance_in_screen_pixels = 1000;
   viz::ResourceFormat preferred_tile_format;
 
@@ -133,6 +136,19 @@ class CC_EXPORT LayerTreeSettings {
   // produces the active tree as its 'sync tree'.
   bool commit_to_active_tree = true;
 
+  // The maximum number of horizontal bands a single software-rastered tile is
+  // split into for concurrent raster on the worker threads. A value of 1
+  // rasters every tile as a whole on one worker.
+  int max_parallel_raster_bands_per_tile = 1;
+
+  // With software compositing, tiles that are evicted from the tile memory
+  // budget while not visible are kept compressed in up to this many bytes, so
+  // that they are restored without a raster if they come back into view.
+  // Only the compressed bytes count against the tile memory budget, so more
+  // prepaint content fits in it. They are freed once no lower priority tile is
+  // left to evict. 0 disables it.
+  size_t compressed_software_tile_cache_bytes = 0;
+
   // Whether to use out of process raster.  If true, whenever gpu raster
   // would have been used, out of process gpu raster will be used instead.
   bool enable_oop_rasterization = false;
@@ -24,6 +24,14 @@
 
 namespace cc {
 
+namespace {
+
+// The number of subtrees that can be marked as needing an update before the
+// whole tree is marked instead.
+const size_t kMaxDirtySubtreeRoots = 32;
+
+}  // namespace
+
 template <typename T>
 PropertyTree<T>::PropertyTree()
     : needs_update_(false) {
@@ -69,9 +77,29 @@ int PropertyTree<T>::Insert(const T& tree_node, int parent_id) {
   return node.id;
 }
 
+template <typename T>
+void PropertyTree<T>::SetSubtreeNeedsUpdate(int id) {
+  DCHECK_GT(id, kInvalidNodeId);
+  DCHECK_LT(id, static_cast<int>(size()));
+  if (needs_full_update())
+    return;
+  // Past a handful of dirty subtrees, finding the nodes that depend on them
+  // costs about as much as recomputing everything.
+  if (dirty_subtree_roots_.size() >= kMaxDirtySubtreeRoots) {
+    dirty_subtree_roots_.clear();
+    return;
+  }
+  // Go through set_needs_update() so that subclasses see the tree become
+  // dirty, e.g. to invalidate cached draw transforms.
+  if (!needs_update_)
+    set_needs_update(true);
+  dirty_subtree_roots_.push_back(id);
+}
+
 template <typename T>
 void PropertyTree<T>::clear() {
   needs_update_ = false;
+  dirty_subtree_roots_.clear();
   nodes_.clear();
   nodes_.push_back(T());
   back()->id = kRootNodeId;
@@ -85,7 +113,8 @@ void PropertyTree<T>::clear() {
 
 template <typename T>
 bool PropertyTree<T>::operator==(const PropertyTree<T>& other) const {
-  return nodes_ == other.nodes() && needs_update_ == other.needs_update();
+  return nodes_ == other.nodes() && needs_update_ == other.needs_update() &&
+         dirty_subtree_roots_ == other.dirty_subtree_roots();
 }
 
 template <typename T>
@@ -197,7 +226,7 @@ bool TransformTree::OnTransformAnimated(ElementId element_id,
   node->needs_local_transform_update = true;
   node->transform_changed = true;
   property_trees()->changed = true;
-  set_needs_update(true);
+  SetSubtreeNeedsUpdate(node->id);
   return true;
 }
 
@@ -870,7 +899,7 @@ bool EffectTree::OnOpacityAnimated(ElementId id, float opacity) {
   node->opacity = opacity;
   node->effect_changed = true;
   property_trees()->changed = true;
-  property_trees()->effect_tree.set_needs_update(true);
+  SetSubtreeNeedsUpdate(node->id);
   return true;
 }
 
@@ -883,7 +912,7 @@ bool EffectTree::OnFilterAnimated(ElementId id,
   node->filters = filters;
   node->effect_changed = true;
   property_trees()->changed = true;
-  property_trees()->effect_tree.set_needs_update(true);
+  SetSubtreeNeedsUpdate(node->id);
   return true;
 }
 
@@ -1725,7 +1754,7 @@ bool PropertyTrees::ElementIsAnimatingChanged(
             transform_node->has_only_translation_animations =
                 mutator_host->HasOnlyTranslationTransforms(element_id,
                                                            list_type);
-            transform_tree.set_needs_update(true);
+            transform_tree.SetSubtreeNeedsUpdate(transform_node->id);
             // We track transform updates specifically, whereas we
             // don't do so for opacity/filter, because whether a
             // transform is animating can change what layer(s) we
@@ -1748,7 +1777,7 @@ bool PropertyTrees::ElementIsAnimatingChanged(
             effect_node->has_potential_opacity_animation =
                 state.potentially_animating[property];
             // We may need to propagate things like screen space opacity.
-            effect_tree.set_needs_update(true);
+            effect_tree.SetSubtreeNeedsUpdate(effect_node->id);
           }
         } else {
           DCHECK_NODE_EXISTENCE(check_node_existence, state, property,
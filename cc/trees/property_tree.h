@@ -88,11 +88,28 @@ class CC_EXPORT PropertyTree {
   void clear();
   size_t size() const { return nodes_.size(); }
 
+  // Marks the whole tree as needing an update (or not). This forgets any
+  // subtrees passed to SetSubtreeNeedsUpdate().
   virtual void set_needs_update(bool needs_update) {
     needs_update_ = needs_update;
+    dirty_subtree_roots_.clear();
   }
   bool needs_update() const { return needs_update_; }
 
+  // Marks only the subtree rooted at node |id| as needing an update, e.g.
+  // because a single node's transform or opacity animated. When updating, the
+  // subtree and the nodes that depend on it are recomputed instead of the
+  // whole tree. Has no effect if the whole tree already needs an update.
+  void SetSubtreeNeedsUpdate(int id);
+  bool needs_full_update() const {
+    return needs_update_ && dirty_subtree_roots_.empty();
+  }
+  // The roots of the subtrees that need an update. Only meaningful if
+  // needs_update() is true and needs_full_update() is false.
+  const std::vector<int>& dirty_subtree_roots() const {
+    return dirty_subtree_roots_;
+  }
+
   std::vector<T>& nodes() { return nodes_; }
   const std::vector<T>& nodes() const { return nodes_; }
 
@@ -108,6 +125,7 @@ class CC_EXPORT PropertyTree {
  protected:
   std::vector<T> nodes_;
   bool needs_update_;
+  std::vector<int> dirty_subtree_roots_;
   PropertyTrees* property_trees_;
 };
 
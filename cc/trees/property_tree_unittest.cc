@@ -4,6 +4,8 @@
 
 #include "cc/trees/property_tree.h"
 
+#include <vector>
+
 #include "cc/input/main_thread_scrolling_reason.h"
 #include "cc/test/geometry_test_utils.h"
 #include "cc/trees/clip_node.h"
@@ -483,6 +485,217 @@ TEST(PropertyTreeTest, NonIntegerTranslationTest) {
       tree.Node(child)->node_and_ancestors_have_only_integer_translation);
 }
 
+TEST(PropertyTreeTest, SubtreeNeedsUpdateOnlyUpdatesSubtree) {
+  PropertyTrees property_trees;
+  TransformTree& tree = property_trees.transform_tree;
+
+  int parent = tree.Insert(TransformNode(), 0);
+  tree.Node(parent)->source_node_id = 0;
+  int child = tree.Insert(TransformNode(), parent);
+  tree.Node(child)->source_node_id = parent;
+  tree.Node(child)->local.Translate(1, 1);
+  int sibling = tree.Insert(TransformNode(), 0);
+  tree.Node(sibling)->source_node_id = 0;
+  tree.set_needs_update(true);
+  draw_property_utils::ComputeTransforms(&tree);
+
+  tree.Node(parent)->local.Translate(2, 2);
+  tree.Node(parent)->needs_local_transform_update = true;
+  // The sibling is changed without marking it as needing an update, so it
+  // should not be recomputed.
+  tree.Node(sibling)->local.Translate(3, 3);
+  tree.Node(sibling)->needs_local_transform_update = true;
+  tree.SetSubtreeNeedsUpdate(parent);
+  EXPECT_TRUE(tree.needs_update());
+  EXPECT_FALSE(tree.needs_full_update());
+  draw_property_utils::ComputeTransforms(&tree);
+  EXPECT_FALSE(tree.needs_update());
+
+  gfx::Transform expected;
+  expected.Translate(3, 3);
+  EXPECT_TRANSFORMATION_MATRIX_EQ(expected, tree.ToScreen(child));
+  EXPECT_TRANSFORMATION_MATRIX_EQ(gfx::Transform(), tree.ToScreen(sibling));
+
+  tree.SetSubtreeNeedsUpdate(sibling);
+  draw_property_utils::ComputeTransforms(&tree);
+  EXPECT_TRANSFORMATION_MATRIX_EQ(expected, tree.ToScreen(sibling));
+}
+
+TEST(PropertyTreeTest, SubtreeNeedsUpdateFallsBackToFullUpdate) {
+  PropertyTrees property_trees;
+  EffectTree& tree = property_trees.effect_tree;
+  std::vector<int> nodes;
+  for (int i = 0; i < 100; ++i)
+    nodes.push_back(tree.Insert(EffectNode(), 0));
+
+  // A subtree can't narrow down an update of the whole tree.
+  tree.set_needs_update(true);
+  tree.SetSubtreeNeedsUpdate(nodes[0]);
+  EXPECT_TRUE(tree.needs_full_update());
+
+  tree.set_needs_update(false);
+  tree.SetSubtreeNeedsUpdate(nodes[0]);
+  EXPECT_FALSE(tree.needs_full_update());
+  EXPECT_EQ(1u, tree.dirty_subtree_roots().size());
+
+  // Too many dirty subtrees turn into an update of the whole tree.
+  for (int id : nodes)
+    tree.SetSubtreeNeedsUpdate(id);
+  EXPECT_TRUE(tree.needs_full_update());
+}
+
+// Node ids of the property trees built by BuildPropertyTrees().
+struct TestNodeIds {
+  int transform_parent;
+  int transform_child;
+  int transform_sibling;
+  int effect_parent;
+  int effect_child;
+  int effect_sibling;
+  int clip_parent;
+  int clip_child;
+  int clip_sibling;
+};
+
+// Builds transform, effect and clip trees each with a parent node, its child,
+// and a sibling of the parent, and updates them.
+TestNodeIds BuildPropertyTrees(PropertyTrees* property_trees) {
+  TransformTree& transform_tree = property_trees->transform_tree;
+  EffectTree& effect_tree = property_trees->effect_tree;
+  ClipTree& clip_tree = property_trees->clip_tree;
+  TestNodeIds ids;
+
+  int transform_root = transform_tree.Insert(TransformNode(), 0);
+  transform_tree.Node(transform_root)->source_node_id = 0;
+  ids.transform_parent = transform_tree.Insert(TransformNode(), transform_root);
+  transform_tree.Node(ids.transform_parent)->source_node_id = transform_root;
+  transform_tree.Node(ids.transform_parent)->local.Translate(10, 10);
+  ids.transform_child =
+      transform_tree.Insert(TransformNode(), ids.transform_parent);
+  transform_tree.Node(ids.transform_child)->source_node_id =
+      ids.transform_parent;
+  transform_tree.Node(ids.transform_child)->local.Scale(2, 2);
+  ids.transform_sibling =
+      transform_tree.Insert(TransformNode(), transform_root);
+  transform_tree.Node(ids.transform_sibling)->source_node_id = transform_root;
+  transform_tree.Node(ids.transform_sibling)->local.Translate(200, 0);
+
+  int effect_root = effect_tree.Insert(EffectNode(), 0);
+  effect_tree.Node(effect_root)->transform_id = transform_root;
+  effect_tree.Node(effect_root)->has_render_surface = true;
+  ids.effect_parent = effect_tree.Insert(EffectNode(), effect_root);
+  effect_tree.Node(ids.effect_parent)->transform_id = ids.transform_parent;
+  effect_tree.Node(ids.effect_parent)->opacity = 0.5f;
+  ids.effect_child = effect_tree.Insert(EffectNode(), ids.effect_parent);
+  effect_tree.Node(ids.effect_child)->transform_id = ids.transform_child;
+  effect_tree.Node(ids.effect_child)->opacity = 0.5f;
+  ids.effect_sibling = effect_tree.Insert(EffectNode(), effect_root);
+  effect_tree.Node(ids.effect_sibling)->transform_id = ids.transform_sibling;
+  effect_tree.Node(ids.effect_sibling)->has_render_surface = true;
+
+  ClipNode viewport;
+  viewport.transform_id = TransformTree::kRootNodeId;
+  viewport.clip = gfx::RectF(0, 0, 500, 500);
+  int viewport_id = clip_tree.Insert(viewport, 0);
+  ClipNode clip;
+  clip.clip = gfx::RectF(0, 0, 100, 100);
+  clip.transform_id = ids.transform_parent;
+  ids.clip_parent = clip_tree.Insert(clip, viewport_id);
+  clip.transform_id = ids.transform_child;
+  ids.clip_child = clip_tree.Insert(clip, ids.clip_parent);
+  clip.transform_id = ids.transform_sibling;
+  ids.clip_sibling = clip_tree.Insert(clip, viewport_id);
+
+  transform_tree.set_needs_update(true);
+  draw_property_utils::UpdatePropertyTreesForTesting(property_trees);
+  return ids;
+}
+
+// Expects every node of |actual| to have the same computed properties as the
+// corresponding node of |expected|.
+void ExpectSameComputedProperties(const PropertyTrees& expected,
+                                  const PropertyTrees& actual) {
+  ASSERT_EQ(expected.transform_tree.size(), actual.transform_tree.size());
+  for (int i = 0; i < static_cast<int>(expected.transform_tree.size()); ++i) {
+    SCOPED_TRACE(i);
+    EXPECT_TRANSFORMATION_MATRIX_EQ(expected.transform_tree.ToScreen(i),
+                                    actual.transform_tree.ToScreen(i));
+  }
+  ASSERT_EQ(expected.effect_tree.size(), actual.effect_tree.size());
+  for (int i = 0; i < static_cast<int>(expected.effect_tree.size()); ++i)
+    EXPECT_EQ(*expected.effect_tree.Node(i), *actual.effect_tree.Node(i)) << i;
+  ASSERT_EQ(expected.clip_tree.size(), actual.clip_tree.size());
+  for (int i = 0; i < static_cast<int>(expected.clip_tree.size()); ++i) {
+    EXPECT_EQ(
+        expected.clip_tree.Node(i)->cached_accumulated_rect_in_screen_space,
+        actual.clip_tree.Node(i)->cached_accumulated_rect_in_screen_space)
+        << i;
+  }
+}
+
+TEST(PropertyTreeTest, EffectSubtreeUpdateMatchesFullUpdate) {
+  PropertyTrees partial;
+  PropertyTrees full;
+  TestNodeIds ids = BuildPropertyTrees(&partial);
+  BuildPropertyTrees(&full);
+
+  // The parent's opacity changes, and so does the scale of the sibling, whose
+  // effect node has a render surface scaled by it.
+  for (PropertyTrees* property_trees : {&partial, &full}) {
+    property_trees->effect_tree.Node(ids.effect_parent)->opacity = 0.25f;
+    TransformNode* node =
+        property_trees->transform_tree.Node(ids.transform_sibling);
+    node->local.Scale(3, 3);
+    node->needs_local_transform_update = true;
+  }
+  partial.effect_tree.SetSubtreeNeedsUpdate(ids.effect_parent);
+  partial.transform_tree.SetSubtreeNeedsUpdate(ids.transform_sibling);
+  EXPECT_FALSE(partial.effect_tree.needs_full_update());
+  EXPECT_FALSE(partial.transform_tree.needs_full_update());
+  full.transform_tree.set_needs_update(true);
+
+  draw_property_utils::UpdatePropertyTreesForTesting(&partial);
+  draw_property_utils::UpdatePropertyTreesForTesting(&full);
+  ExpectSameComputedProperties(full, partial);
+  EXPECT_EQ(0.125f,
+            partial.effect_tree.Node(ids.effect_child)->screen_space_opacity);
+  EXPECT_EQ(gfx::Vector2dF(3.f, 3.f),
+            partial.effect_tree.Node(ids.effect_sibling)
+                ->surface_contents_scale);
+}
+
+TEST(PropertyTreeTest, ClipSubtreeUpdateMatchesFullUpdate) {
+  PropertyTrees partial;
+  PropertyTrees full;
+  TestNodeIds ids = BuildPropertyTrees(&partial);
+  BuildPropertyTrees(&full);
+
+  // The parent moves, which moves the clips of the parent and its child, and
+  // the sibling's clip shrinks.
+  for (PropertyTrees* property_trees : {&partial, &full}) {
+    TransformNode* node =
+        property_trees->transform_tree.Node(ids.transform_parent);
+    node->local.Translate(5, 0);
+    node->needs_local_transform_update = true;
+    property_trees->clip_tree.Node(ids.clip_sibling)->clip =
+        gfx::RectF(0, 0, 20, 20);
+  }
+  partial.transform_tree.SetSubtreeNeedsUpdate(ids.transform_parent);
+  partial.clip_tree.SetSubtreeNeedsUpdate(ids.clip_sibling);
+  EXPECT_FALSE(partial.clip_tree.needs_full_update());
+  full.transform_tree.set_needs_update(true);
+
+  draw_property_utils::UpdatePropertyTreesForTesting(&partial);
+  draw_property_utils::UpdatePropertyTreesForTesting(&full);
+  ExpectSameComputedProperties(full, partial);
+  EXPECT_EQ(gfx::RectF(15, 10, 100, 100),
+            partial.clip_tree.Node(ids.clip_child)
+                ->cached_accumulated_rect_in_screen_space);
+  EXPECT_EQ(gfx::RectF(200, 0, 20, 20),
+            partial.clip_tree.Node(ids.clip_sibling)
+                ->cached_accumulated_rect_in_screen_space);
+}
+
 TEST(PropertyTreeTest, SingularTransformSnapTest) {
   // This tests that to_target transform is not snapped when it has a singular
   // transform.
@@ -191,6 +191,9 @@ void DeriveCommandLine(const GURL& start_url,
     cc::switches::kEnableGpuBenchmarking,
     cc::switches::kEnableLayerLists,
     cc::switches::kEnableMainFrameBeforeActivation,
+    cc::switches::kEnableParallelTileRaster,
+    cc::switches::kEnableSharedDecodedImageCache,
+    cc::switches::kEnableWorkStealingRasterWorkerPool,
     cc::switches::kShowCompositedLayerBorders,
     cc::switches::kShowFPSCounter,
     cc::switches::kShowLayerAnimationBounds,
@@ -115,6 +115,10 @@ const int kExpirationDelaySec = 30;
 // iteration, so we want to wait longer before checking to avoid wasting CPU.
 const int kExpirationEmptyDelayMin = 5;
 
+// The number of free pages released from the history database per iteration,
+// so that the file shrinks as history expires without a long VACUUM.
+const int kNumVacuumPagesPerIteration = 64;
+
 // The minimum number of hours between checking for old on-demand favicons that
 // should be cleared.
 const int kClearOnDemandFaviconsIntervalHours = 24;
@@ -494,6 +498,9 @@ void ExpireHistoryBackend::DoExpireIteration() {
   bool more_to_expire = ExpireSomeOldHistory(
       GetCurrentExpirationTime(), reader, kNumExpirePerIteration);
 
+  if (main_db_)
+    main_db_->IncrementalVacuum(kNumVacuumPagesPerIteration);
+
   work_queue_.pop();
   if (more_to_expire) {
     // If there are more items to expire, add the reader back to the queue, thus
@@ -100,6 +100,10 @@ sql::InitStatus HistoryDatabase::Init(const base::FilePath& history_name) {
   // TODO(brettw) scale this value to the amount of available memory.
   db_.set_cache_size(1000);
 
+  // Keep the pages freed by history expiration for IncrementalVacuum(), rather
+  // than letting the file only grow.
+  db_.set_incremental_vacuum();
+
   // Note that we don't set exclusive locking here. That's done by
   // BeginExclusiveMode below which is called later (we have to be in shared
   // mode to start out for the in-memory backend to read the data).
@@ -338,6 +342,10 @@ void HistoryDatabase::Vacuum() {
   ignore_result(db_.Execute("VACUUM"));
 }
 
+void HistoryDatabase::IncrementalVacuum(int max_pages) {
+  ignore_result(db_.IncrementalVacuum(max_pages));
+}
+
 void HistoryDatabase::TrimMemory(bool aggressively) {
   db_.TrimMemory(aggressively);
 }
@@ -139,6 +139,11 @@ class HistoryDatabase : public DownloadDatabase,
   // unused space in the file. It can be VERY SLOW.
   void Vacuum();
 
+  // Releases up to |max_pages| pages freed by deletions, shrinking the file a
+  // slice at a time. Databases created before incremental vacuum was turned on
+  // are left as is until their next Vacuum().
+  void IncrementalVacuum(int max_pages);
+
   // Try to trim the cache memory used by the database.  If |aggressively| is
   // true try to trim all unused cache, otherwise trim by half.
   void TrimMemory(bool aggressively);
@@ -42,6 +42,7 @@
 #include "build/build_config.h"
 #include "components/tracing/common/trace_startup.h"
 #include "content/app/mojo/mojo_init.h"
+#include "content/common/content_switches_internal.h"
 #include "content/common/url_schemes.h"
 #include "content/public/app/content_main.h"
 #include "content/public/app/content_main_delegate.h"
@@ -167,6 +168,8 @@ void InitializeFieldTrialAndFeatureList(
       command_line, switches::kEnableFeatures, switches::kDisableFeatures,
       feature_list.get());
   base::FeatureList::SetInstance(std::move(feature_list));
+
+  EnableMessageTrafficProfilerIfRequested();
 }
 
 #if defined(V8_USE_EXTERNAL_STARTUP_DATA)
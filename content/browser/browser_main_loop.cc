@@ -850,6 +850,8 @@ int BrowserMainLoop::PreCreateThreads() {
       command_line->GetSwitchValueASCII(switches::kEnableFeatures),
       command_line->GetSwitchValueASCII(switches::kDisableFeatures));
 
+  EnableMessageTrafficProfilerIfRequested();
+
   InitializeMemoryManagementComponent();
 
 #if defined(OS_MACOSX)
@@ -7,6 +7,8 @@
 #include <algorithm>
 #include <utility>
 
+#include "base/bind.h"
+#include "base/feature_list.h"
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
 #include "base/format_macros.h"
@@ -16,6 +18,7 @@
 #include "base/macros.h"
 #include "base/memory/ptr_util.h"
 #include "base/metrics/histogram_macros.h"
+#include "base/stl_util.h"
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
@@ -27,6 +30,7 @@
 #include "content/browser/indexed_db/indexed_db_context_impl.h"
 #include "content/browser/indexed_db/indexed_db_data_format_version.h"
 #include "content/browser/indexed_db/indexed_db_database_error.h"
+#include "content/browser/indexed_db/indexed_db_factory.h"
 #include "content/browser/indexed_db/indexed_db_leveldb_coding.h"
 #include "content/browser/indexed_db/indexed_db_leveldb_operations.h"
 #include "content/browser/indexed_db/indexed_db_metadata_coding.h"
@@ -51,6 +55,7 @@
 #include "storage/browser/fileapi/local_file_stream_writer.h"
 #include "storage/common/database/database_identifier.h"
 #include "storage/common/fileapi/file_system_mount_option.h"
+#include "third_party/WebKit/public/platform/modules/indexeddb/WebIDBDatabaseException.h"
 #include "third_party/WebKit/public/platform/modules/indexeddb/WebIDBTypes.h"
 #include "third_party/leveldatabase/env_chromium.h"
 
@@ -555,6 +560,9 @@ bool IndexCursorOptions(
 
 }  // namespace
 
+const base::Feature kIDBGroupCommit{"IDBGroupCommit",
+                                    base::FEATURE_DISABLED_BY_DEFAULT};
+
 class DefaultLevelDBFactory : public LevelDBFactory {
  public:
   DefaultLevelDBFactory() {}
@@ -591,7 +599,8 @@ IndexedDBBackingStore::IndexedDBBackingStore(
       db_(std::move(db)),
       comparator_(std::move(comparator)),
       active_blob_registry_(this),
-      committing_transaction_count_(0) {}
+      committing_transaction_count_(0),
+      weak_factory_(this) {}
 
 IndexedDBBackingStore::~IndexedDBBackingStore() {
   if (!blob_path_.empty() && !child_process_ids_granted_.empty()) {
@@ -600,6 +609,10 @@ IndexedDBBackingStore::~IndexedDBBackingStore() {
     for (const auto& pid : child_process_ids_granted_)
       policy->RevokeAllPermissionsForFile(pid, blob_path_);
   }
+  // The transactions waiting for a group commit are gone, but what they wrote
+  // should still reach disk.
+  if (!group_commit_waiters_.empty() && db_)
+    db_->Flush();
   // db_'s destructor uses comparator_. The order of destruction is important.
   db_.reset();
   comparator_.reset();
@@ -2564,6 +2577,9 @@ class ObjectStoreCursorImpl : public IndexedDBBackingStore::Cursor {
         current_value_(other->current_value_) {}
 
   IndexedDBValue current_value_;
+  // Reused by LoadCurrentRow() for every record, to save allocations.
+  std::string encoded_key_buffer_;
+  std::string leveldb_key_buffer_;
 
   DISALLOW_COPY_AND_ASSIGN(ObjectStoreCursorImpl);
 };
@@ -2588,16 +2604,18 @@ bool ObjectStoreCursorImpl::LoadCurrentRow(Status* s) {
   }
 
   // TODO(jsbell): This re-encodes what was just decoded; try and optimize.
-  std::string encoded_key;
-  EncodeIDBKey(*current_key_, &encoded_key);
-  record_identifier_.Reset(encoded_key, version);
+  encoded_key_buffer_.clear();
+  EncodeIDBKey(*current_key_, &encoded_key_buffer_);
+  record_identifier_.Reset(encoded_key_buffer_, version);
 
-  *s = transaction_->GetBlobInfoForRecord(
-      database_id_, iterator_->Key().as_string(), &current_value_);
+  StringPiece leveldb_key = iterator_->Key();
+  leveldb_key_buffer_.assign(leveldb_key.data(), leveldb_key.size());
+  *s = transaction_->GetBlobInfoForRecord(database_id_, leveldb_key_buffer_,
+                                          &current_value_);
   if (!s->ok())
     return false;
 
-  current_value_.bits = value_slice.as_string();
+  current_value_.bits.assign(value_slice.data(), value_slice.size());
   return true;
 }
 
@@ -2965,6 +2983,104 @@ void IndexedDBBackingStore::ForceRunBlobCleanup() {
   std::move(task).Run();
 }
 
+IndexedDBBackingStore::GroupCommitWaiter::GroupCommitWaiter() = default;
+
+IndexedDBBackingStore::GroupCommitWaiter::GroupCommitWaiter(
+    GroupCommitWaiter&& other) = default;
+
+IndexedDBBackingStore::GroupCommitWaiter::~GroupCommitWaiter() = default;
+
+void IndexedDBBackingStore::ScheduleGroupCommit(
+    int64_t database_id,
+    const std::set<int64_t>& scope,
+    base::OnceClosure callback) {
+  DCHECK(task_runner_->RunsTasksInCurrentSequence());
+  if (!group_commit_posted_) {
+    group_commit_posted_ = true;
+    task_runner_->PostTask(
+        FROM_HERE, base::BindOnce(&IndexedDBBackingStore::RunGroupCommit,
+                                  weak_factory_.GetWeakPtr()));
+  }
+  group_commit_waiters_.emplace_back();
+  GroupCommitWaiter& waiter = group_commit_waiters_.back();
+  waiter.database_id = database_id;
+  waiter.scope = scope;
+  waiter.callback = std::move(callback);
+  waiter.schedule_time = base::TimeTicks::Now();
+}
+
+bool IndexedDBBackingStore::HasOverlappingGroupCommit(
+    int64_t database_id,
+    const std::set<int64_t>& scope) const {
+  for (const GroupCommitWaiter& waiter : group_commit_waiters_) {
+    if (waiter.database_id != database_id)
+      continue;
+    // An empty scope is a version change transaction's, which covers all the
+    // object stores.
+    if (waiter.scope.empty() || scope.empty())
+      return true;
+    for (int64_t object_store_id : scope) {
+      if (base::ContainsKey(waiter.scope, object_store_id))
+        return true;
+    }
+  }
+  return false;
+}
+
+void IndexedDBBackingStore::FlushGroupCommit() {
+  if (!group_commit_waiters_.empty())
+    RunGroupCommit();
+}
+
+void IndexedDBBackingStore::RunGroupCommit() {
+  IDB_TRACE("IndexedDBBackingStore::RunGroupCommit");
+  group_commit_posted_ = false;
+  std::vector<GroupCommitWaiter> waiters;
+  waiters.swap(group_commit_waiters_);
+  // FlushGroupCommit() may have run the group commit already.
+  if (waiters.empty())
+    return;
+
+  Status s = SyncGroupCommit();
+  if (!s.ok()) {
+    // The waiting transactions neither complete nor abort: the connections
+    // closed along with the backing store finish them. Closing them may
+    // reenter the caller of FlushGroupCommit(), so it is done from a task.
+    task_runner_->PostTask(
+        FROM_HERE,
+        base::BindOnce(&IndexedDBBackingStore::ReportGroupCommitFailure,
+                       weak_factory_.GetWeakPtr(), s));
+    return;
+  }
+
+  base::TimeTicks now = base::TimeTicks::Now();
+  UMA_HISTOGRAM_COUNTS_100("WebCore.IndexedDB.GroupCommit.TransactionCount",
+                           waiters.size());
+  // The callbacks may release the last reference to |this|.
+  for (GroupCommitWaiter& waiter : waiters) {
+    UMA_HISTOGRAM_TIMES("WebCore.IndexedDB.GroupCommit.Latency",
+                        now - waiter.schedule_time);
+    std::move(waiter.callback).Run();
+  }
+}
+
+Status IndexedDBBackingStore::SyncGroupCommit() {
+  return db_->Flush();
+}
+
+void IndexedDBBackingStore::ReportGroupCommitFailure(leveldb::Status status) {
+  // Null for in-memory backing stores, which never defer a sync.
+  if (!indexed_db_factory_)
+    return;
+  if (status.IsCorruption()) {
+    IndexedDBDatabaseError error(blink::kWebIDBDatabaseExceptionUnknownError,
+                                 base::ASCIIToUTF16(status.ToString()));
+    indexed_db_factory_->HandleBackingStoreCorruption(origin_, error);
+  } else {
+    indexed_db_factory_->HandleBackingStoreFailure(origin_);
+  }
+}
+
 IndexedDBBackingStore::Transaction::Transaction(
     IndexedDBBackingStore* backing_store)
     : backing_store_(backing_store),
@@ -3189,6 +3305,12 @@ Status IndexedDBBackingStore::Transaction::CommitPhaseTwo() {
     UpdateLiveBlobJournal(transaction_.get(), live_journal);
   }
 
+  // Blob files are deleted right after the commit, which must be on disk by
+  // then, so only transactions without blob changes may defer the sync.
+  sync_deferred_ = group_commit_allowed_ && blob_change_map_.empty() &&
+                   !backing_store_->is_incognito();
+  transaction_->set_sync_on_commit(!sync_deferred_);
+
   // Actually commit. If this succeeds, the journals will appropriately
   // reflect pending blob work - dead files that should be deleted
   // immediately, and live files to monitor.
@@ -3196,6 +3318,7 @@ Status IndexedDBBackingStore::Transaction::CommitPhaseTwo() {
   transaction_ = nullptr;
 
   if (!s.ok()) {
+    sync_deferred_ = false;
     INTERNAL_WRITE_ERROR(TRANSACTION_COMMIT_METHOD);
     return s;
   }
@@ -15,6 +15,7 @@
 #include <utility>
 #include <vector>
 
+#include "base/callback.h"
 #include "base/files/file_path.h"
 #include "base/gtest_prod_util.h"
 #include "base/macros.h"
@@ -41,6 +42,7 @@
 #include "url/origin.h"
 
 namespace base {
+struct Feature;
 class SequencedTaskRunner;
 }
 
@@ -61,6 +63,10 @@ class LevelDBFactory;
 struct IndexedDBDataLossInfo;
 struct IndexedDBValue;
 
+// Lets readwrite transactions share the sync of their commits, see
+// IndexedDBBackingStore::ScheduleGroupCommit().
+CONTENT_EXPORT extern const base::Feature kIDBGroupCommit;
+
 class CONTENT_EXPORT IndexedDBBackingStore
     : public base::RefCounted<IndexedDBBackingStore> {
  public:
@@ -150,6 +156,15 @@ class CONTENT_EXPORT IndexedDBBackingStore
     // by the transaction and not referenced by running scripts.
     virtual leveldb::Status CommitPhaseTwo();
 
+    // Lets CommitPhaseTwo() return before the transaction is on disk, if it
+    // has no blob changes. The caller must then not report the commit until
+    // IndexedDBBackingStore::ScheduleGroupCommit() succeeds.
+    void set_group_commit_allowed(bool allowed) {
+      group_commit_allowed_ = allowed;
+    }
+    // Whether the last CommitPhaseTwo() returned before syncing.
+    bool sync_deferred() const { return sync_deferred_; }
+
     virtual void Rollback();
     void Reset() {
       backing_store_ = NULL;
@@ -239,6 +254,10 @@ class CONTENT_EXPORT IndexedDBBackingStore
 
     typedef std::vector<WriteDescriptor> WriteDescriptorVec;
 
+   protected:
+    bool group_commit_allowed() const { return group_commit_allowed_; }
+    void set_sync_deferred(bool deferred) { sync_deferred_ = deferred; }
+
    private:
     class BlobWriteCallbackWrapper;
 
@@ -290,6 +309,9 @@ class CONTENT_EXPORT IndexedDBBackingStore
     // has been bumped, and journal cleaning should be deferred.
     bool committing_;
 
+    bool group_commit_allowed_ = false;
+    bool sync_deferred_ = false;
+
     base::WeakPtrFactory<Transaction> ptr_factory_;
 
     DISALLOW_COPY_AND_ASSIGN(Transaction);
@@ -578,6 +600,31 @@ class CONTENT_EXPORT IndexedDBBackingStore
   // Stops the journal_cleaning_timer_ and runs its pending task.
   void ForceRunBlobCleanup();
 
+  // Runs |callback| once the transactions committed without a sync so far are
+  // on disk. A single sync is posted for all the transactions which commit
+  // before it runs, so that many small transactions don't each wait for one.
+  // It syncs leveldb's current log. The logs leveldb has switched away from
+  // since the commits were already synced by LevelDBEnv when it closed them.
+  // The callbacks run in the order they were scheduled in. |scope| holds the
+  // ids of the object stores of |database_id| the waiting transaction covers,
+  // and is empty for a version change transaction, which covers them all.
+  //
+  // If the sync fails, the callbacks are dropped: the commits were already
+  // visible to later transactions, so they can't be aborted anymore, and the
+  // backing store is closed as after any other fatal error.
+  void ScheduleGroupCommit(int64_t database_id,
+                           const std::set<int64_t>& scope,
+                           base::OnceClosure callback);
+
+  // Whether a transaction of |database_id| with |scope| overlaps one waiting
+  // for the group commit, in which case it must not complete before it.
+  bool HasOverlappingGroupCommit(int64_t database_id,
+                                 const std::set<int64_t>& scope) const;
+
+  // Runs the pending group commit right away, if there is one. Used when the
+  // connection of a waiting transaction closes.
+  void FlushGroupCommit();
+
  protected:
   friend class base::RefCounted<IndexedDBBackingStore>;
 
@@ -593,6 +640,9 @@ class CONTENT_EXPORT IndexedDBBackingStore
 
   bool is_incognito() const { return !indexed_db_factory_; }
 
+  // Syncs the writes of the transactions waiting for the group commit.
+  virtual leveldb::Status SyncGroupCommit();
+
   leveldb::Status SetUpMetadata();
 
   // TODO(dmurph): Move this completely to IndexedDBMetadataFactory.
@@ -663,6 +713,12 @@ class CONTENT_EXPORT IndexedDBBackingStore
   // Can run a journal cleaning job if one is pending.
   void DidCommitTransaction();
 
+  // Syncs the transactions waiting for a group commit, and runs their
+  // callbacks.
+  void RunGroupCommit();
+  // Closes the backing store after RunGroupCommit() failed with |status|.
+  void ReportGroupCommitFailure(leveldb::Status status);
+
   IndexedDBFactory* indexed_db_factory_;
   const url::Origin origin_;
   base::FilePath blob_path_;
@@ -702,6 +758,22 @@ class CONTENT_EXPORT IndexedDBBackingStore
   // journal cleaning must be deferred.
   size_t committing_transaction_count_;
 
+  struct GroupCommitWaiter {
+    GroupCommitWaiter();
+    GroupCommitWaiter(GroupCommitWaiter&& other);
+    ~GroupCommitWaiter();
+
+    int64_t database_id = 0;
+    std::set<int64_t> scope;
+    base::OnceClosure callback;
+    base::TimeTicks schedule_time;
+  };
+  // The transactions waiting for the posted RunGroupCommit().
+  std::vector<GroupCommitWaiter> group_commit_waiters_;
+  bool group_commit_posted_ = false;
+
+  base::WeakPtrFactory<IndexedDBBackingStore> weak_factory_;
+
   DISALLOW_COPY_AND_ASSIGN(IndexedDBBackingStore);
 };
 
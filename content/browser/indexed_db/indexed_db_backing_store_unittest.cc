@@ -495,6 +495,56 @@ TEST_F(IndexedDBBackingStoreTest, PutGetConsistency) {
   RunAllTasksUntilIdle();
 }
 
+TEST_F(IndexedDBBackingStoreTest, GroupCommit) {
+  int num_synced = 0;
+  idb_context_->TaskRunner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](IndexedDBBackingStore* backing_store, IndexedDBKey key1,
+             IndexedDBValue value1, IndexedDBKey key2, IndexedDBValue value2,
+             int* num_synced) {
+            auto on_synced = [](int* num_synced) { ++*num_synced; };
+
+            // Both transactions share the sync posted by the first one.
+            for (const auto& record : {std::make_pair(key1, value1),
+                                       std::make_pair(key2, value2)}) {
+              IndexedDBBackingStore::Transaction transaction(backing_store);
+              transaction.Begin();
+              std::vector<std::unique_ptr<storage::BlobDataHandle>> handles;
+              IndexedDBBackingStore::RecordIdentifier record_identifier;
+              IndexedDBValue value = record.second;
+              EXPECT_TRUE(backing_store
+                              ->PutRecord(&transaction, 1, 1, record.first,
+                                          &value, &handles, &record_identifier)
+                              .ok());
+              scoped_refptr<TestCallback> callback(
+                  base::MakeRefCounted<TestCallback>());
+              EXPECT_TRUE(transaction.CommitPhaseOne(callback).ok());
+              transaction.set_group_commit_allowed(true);
+              EXPECT_TRUE(transaction.CommitPhaseTwo().ok());
+              EXPECT_TRUE(transaction.sync_deferred());
+              backing_store->ScheduleGroupCommit(
+                  1, {1}, base::BindOnce(on_synced, num_synced));
+            }
+            EXPECT_EQ(0, *num_synced);
+
+            // The commits are visible before they are synced.
+            IndexedDBBackingStore::Transaction transaction(backing_store);
+            transaction.Begin();
+            IndexedDBValue result_value;
+            EXPECT_TRUE(
+                backing_store
+                    ->GetRecord(&transaction, 1, 1, key2, &result_value)
+                    .ok());
+            EXPECT_EQ(value2.bits, result_value.bits);
+            transaction.Rollback();
+          },
+          base::Unretained(backing_store()), key1_, value1_, key2_, value2_,
+          base::Unretained(&num_synced)));
+  RunAllTasksUntilIdle();
+  EXPECT_EQ(2, num_synced);
+}
+
 TEST_F(IndexedDBBackingStoreTestWithBlobs, PutGetConsistencyWithBlobs) {
   struct TestState {
     std::unique_ptr<IndexedDBBackingStore::Transaction> transaction1;
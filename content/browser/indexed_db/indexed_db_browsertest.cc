@@ -534,7 +534,7 @@ namespace {
 static void CompactIndexedDBBackingStore(
     scoped_refptr<IndexedDBContextImpl> context,
     const Origin& origin) {
-  IndexedDBFactory* factory = context->GetIDBFactory();
+  IndexedDBFactory* factory = context->GetIDBFactory(origin);
 
   std::pair<IndexedDBFactory::OriginDBMapIterator,
             IndexedDBFactory::OriginDBMapIterator>
@@ -744,7 +744,7 @@ std::string IndexedDBCallbacks::IOThreadHelper::CreateBlobData(
     shareable_file = ShareableFileReference::GetOrCreate(
         blob_info.file_path(),
         ShareableFileReference::DONT_DELETE_ON_FINAL_RELEASE,
-        dispatcher_host_->context()->TaskRunner());
+        idb_runner_.get());
     if (!blob_info.release_callback().is_null())
       shareable_file->AddFinalReleaseCallback(blob_info.release_callback());
   }
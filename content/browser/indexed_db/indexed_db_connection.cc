@@ -4,6 +4,7 @@
 
 #include "content/browser/indexed_db/indexed_db_connection.h"
 
+#include "base/atomic_sequence_num.h"
 #include "base/logging.h"
 #include "base/stl_util.h"
 #include "content/browser/indexed_db/indexed_db_class_factory.h"
@@ -17,7 +18,8 @@ namespace content {
 
 namespace {
 
-static int32_t next_id;
+// Connections are opened on every IndexedDB sequence.
+base::AtomicSequenceNumber g_next_connection_id;
 
 }  // namespace
 
@@ -25,7 +27,7 @@ IndexedDBConnection::IndexedDBConnection(
     int child_process_id,
     scoped_refptr<IndexedDBDatabase> database,
     scoped_refptr<IndexedDBDatabaseCallbacks> callbacks)
-    : id_(next_id++),
+    : id_(g_next_connection_id.GetNext()),
       child_process_id_(child_process_id),
       database_(database),
       callbacks_(callbacks),
@@ -125,11 +127,23 @@ void IndexedDBConnection::AbortTransaction(
 
 void IndexedDBConnection::AbortAllTransactions(
     const IndexedDBDatabaseError& error) {
+  // The transactions waiting for a group commit have committed already, so
+  // they complete rather than abort. Running the group commit now completes
+  // and removes them, unless it fails.
+  bool group_commit_pending = false;
+  for (const auto& pair : transactions_)
+    group_commit_pending |= pair.second->group_commit_pending_;
+  if (group_commit_pending)
+    database_->backing_store()->FlushGroupCommit();
+
   std::unordered_map<int64_t, std::unique_ptr<IndexedDBTransaction>> temp_map;
   std::swap(temp_map, transactions_);
   for (const auto& pair : temp_map) {
     IDB_TRACE1("IndexedDBDatabase::Abort(error)", "txn.id", pair.second->id());
-    pair.second->Abort(error);
+    if (pair.second->group_commit_pending_)
+      pair.second->AbandonGroupCommit();
+    else
+      pair.second->Abort(error);
   }
 }
 
@@ -7,16 +7,20 @@
 #include <algorithm>
 #include <utility>
 
+#include "base/barrier_closure.h"
 #include "base/bind.h"
+#include "base/bind_helpers.h"
 #include "base/command_line.h"
 #include "base/files/file_enumerator.h"
 #include "base/files/file_util.h"
+#include "base/hash.h"
 #include "base/logging.h"
 #include "base/memory/ptr_util.h"
 #include "base/metrics/histogram_macros.h"
 #include "base/sequenced_task_runner.h"
 #include "base/strings/string_util.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/sys_info.h"
 #include "base/task_scheduler/post_task.h"
 #include "base/threading/thread_restrictions.h"
 #include "base/time/default_clock.h"
@@ -33,6 +37,7 @@
 #include "content/browser/indexed_db/indexed_db_transaction.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/indexed_db_info.h"
+#include "content/public/common/content_features.h"
 #include "content/public/common/content_switches.h"
 #include "storage/browser/database/database_util.h"
 #include "storage/common/database/database_identifier.h"
@@ -59,6 +64,40 @@ static const base::FilePath::CharType kLevelDBExtension[] =
 
 namespace {
 
+// The most sequences which origins are spread over with the
+// IndexedDBOriginSequences feature.
+const int kMaxOriginSequences = 8;
+
+scoped_refptr<base::SequencedTaskRunner> CreateIndexedDBTaskRunner() {
+  return base::CreateSequencedTaskRunnerWithTraits(
+      {base::MayBlock(), base::WithBaseSyncPrimitives(),
+       base::TaskPriority::USER_VISIBLE,
+       base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN});
+}
+
+using DatabaseLists = std::vector<std::unique_ptr<base::ListValue>>;
+
+// Adds the open databases of each origin, in the same order, to the details
+// in |list|.
+void AddOpenDatabasesDetails(
+    std::unique_ptr<base::ListValue> list,
+    std::unique_ptr<DatabaseLists> database_lists,
+    IndexedDBContextImpl::OriginsDetailsCallback callback) {
+  for (size_t i = 0; i < database_lists->size(); ++i) {
+    base::DictionaryValue* info = nullptr;
+    if ((*database_lists)[i] && list->GetDictionary(i, &info))
+      info->Set("databases", std::move((*database_lists)[i]));
+  }
+  std::move(callback).Run(std::move(list));
+}
+
+void DestroyFactory(scoped_refptr<IndexedDBFactory> factory,
+                    const base::RepeatingClosure& done) {
+  if (factory)
+    factory->ContextDestroyed();
+  done.Run();
+}
+
 // This may be called after the IndexedDBContext is destroyed.
 void GetAllOriginsAndPaths(const base::FilePath& indexeddb_path,
                            std::vector<Origin>* origins,
@@ -114,36 +153,50 @@ IndexedDBContextImpl::IndexedDBContextImpl(
     : force_keep_session_state_(false),
       special_storage_policy_(special_storage_policy),
       quota_manager_proxy_(quota_manager_proxy),
-      task_runner_(base::CreateSequencedTaskRunnerWithTraits(
-          {base::MayBlock(), base::WithBaseSyncPrimitives(),
-           base::TaskPriority::USER_VISIBLE,
-           base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN})) {
+      task_runner_(CreateIndexedDBTaskRunner()) {
   IDB_TRACE("init");
   if (!data_path.empty())
     data_path_ = data_path.Append(kIndexedDBDirectory);
+  if (base::FeatureList::IsEnabled(features::kIndexedDBOriginSequences)) {
+    int num_sequences =
+        std::min(base::SysInfo::NumberOfProcessors(), kMaxOriginSequences);
+    for (int i = 0; i < num_sequences; ++i)
+      origin_task_runners_.push_back(CreateIndexedDBTaskRunner());
+  }
+  factories_.resize(std::max<size_t>(origin_task_runners_.size(), 1));
   quota_manager_proxy->RegisterClient(new IndexedDBQuotaClient(this));
 }
 
-IndexedDBFactory* IndexedDBContextImpl::GetIDBFactory() {
-  DCHECK(TaskRunner()->RunsTasksInCurrentSequence());
-  if (!factory_.get()) {
+IndexedDBFactory* IndexedDBContextImpl::GetIDBFactory(const Origin& origin) {
+  DCHECK(TaskRunnerForOrigin(origin)->RunsTasksInCurrentSequence());
+  scoped_refptr<IndexedDBFactory>& factory = factories_[GetShardIndex(origin)];
+  if (!factory.get()) {
     // Prime our cache of origins with existing databases so we can
     // detect when dbs are newly created.
-    GetOriginSet();
-    factory_ =
-        new IndexedDBFactoryImpl(this, base::DefaultClock::GetInstance());
+    EnsureOriginSetInitialized();
+    factory = new IndexedDBFactoryImpl(this, base::DefaultClock::GetInstance());
   }
-  return factory_.get();
+  return factory.get();
+}
+
+base::SequencedTaskRunner* IndexedDBContextImpl::TaskRunnerForOrigin(
+    const Origin& origin) const {
+  if (origin_task_runners_.empty())
+    return TaskRunner();
+  return origin_task_runners_[GetShardIndex(origin)].get();
 }
 
 std::vector<Origin> IndexedDBContextImpl::GetAllOrigins() {
   DCHECK(TaskRunner()->RunsTasksInCurrentSequence());
+  EnsureOriginSetInitialized();
+  base::AutoLock lock(lock_);
   std::set<Origin>* origins_set = GetOriginSet();
   return std::vector<Origin>(origins_set->begin(), origins_set->end());
 }
 
 bool IndexedDBContextImpl::HasOrigin(const Origin& origin) {
-  DCHECK(TaskRunner()->RunsTasksInCurrentSequence());
+  EnsureOriginSetInitialized();
+  base::AutoLock lock(lock_);
   std::set<Origin>* set = GetOriginSet();
   return set->find(origin) != set->end();
 }
@@ -165,7 +218,8 @@ static bool HostNameComparator(const Origin& i, const Origin& j) {
   return i.host() < j.host();
 }
 
-base::ListValue* IndexedDBContextImpl::GetAllOriginsDetails() {
+void IndexedDBContextImpl::GetAllOriginsDetails(
+    OriginsDetailsCallback callback) {
   DCHECK(TaskRunner()->RunsTasksInCurrentSequence());
   std::vector<Origin> origins = GetAllOrigins();
 
@@ -186,97 +240,118 @@ base::ListValue* IndexedDBContextImpl::GetAllOriginsDetails() {
       info->Set("paths", std::move(paths));
     }
     info->SetDouble("connection_count", GetConnectionCount(origin));
+    list->Append(std::move(info));
+  }
 
-    // This ends up being O(n^2) since we iterate over all open databases
-    // to extract just those in the origin, and we're iterating over all
-    // origins in the outer loop.
+  // The open databases are only known on each origin's sequence.
+  auto database_lists = std::make_unique<DatabaseLists>(origins.size());
+  DatabaseLists* database_lists_ptr = database_lists.get();
+  base::RepeatingClosure origin_done = base::BarrierClosure(
+      origins.size(),
+      base::BindOnce(&AddOpenDatabasesDetails, std::move(list),
+                     std::move(database_lists), std::move(callback)));
+  for (size_t i = 0; i < origins.size(); ++i) {
+    RunOnOriginSequence(
+        origins[i],
+        base::BindOnce(
+            [](IndexedDBContextImpl* context, const Origin& origin,
+               std::unique_ptr<base::ListValue>* database_list) {
+              *database_list = context->GetOpenDatabasesDetails(origin);
+            },
+            base::RetainedRef(this), origins[i], &(*database_lists_ptr)[i]),
+        origin_done);
+  }
+}
 
-    if (factory_.get()) {
-      std::pair<IndexedDBFactory::OriginDBMapIterator,
-                IndexedDBFactory::OriginDBMapIterator>
-          range = factory_->GetOpenDatabasesForOrigin(origin);
-      // TODO(jsbell): Sort by name?
-      std::unique_ptr<base::ListValue> database_list(
-          std::make_unique<base::ListValue>());
+std::unique_ptr<base::ListValue> IndexedDBContextImpl::GetOpenDatabasesDetails(
+    const Origin& origin) {
+  IndexedDBFactory* factory = factories_[GetShardIndex(origin)].get();
+  if (!factory)
+    return nullptr;
+
+  // This ends up being O(n^2) since we iterate over all open databases
+  // to extract just those in the origin, and we're iterating over all
+  // origins in GetAllOriginsDetails().
+  std::pair<IndexedDBFactory::OriginDBMapIterator,
+            IndexedDBFactory::OriginDBMapIterator>
+      range = factory->GetOpenDatabasesForOrigin(origin);
+  // TODO(jsbell): Sort by name?
+  std::unique_ptr<base::ListValue> database_list(
+      std::make_unique<base::ListValue>());
+
+  for (IndexedDBFactory::OriginDBMapIterator it = range.first;
+       it != range.second;
+       ++it) {
+    const IndexedDBDatabase* db = it->second;
+    std::unique_ptr<base::DictionaryValue> db_info(
+        std::make_unique<base::DictionaryValue>());
 
-      for (IndexedDBFactory::OriginDBMapIterator it = range.first;
-           it != range.second;
-           ++it) {
-        const IndexedDBDatabase* db = it->second;
-        std::unique_ptr<base::DictionaryValue> db_info(
-            std::make_unique<base::DictionaryValue>());
-
-        db_info->SetString("name", db->name());
-        db_info->SetDouble("connection_count", db->ConnectionCount());
-        db_info->SetDouble("active_open_delete", db->ActiveOpenDeleteCount());
-        db_info->SetDouble("pending_open_delete", db->PendingOpenDeleteCount());
-
-        std::unique_ptr<base::ListValue> transaction_list(
-            std::make_unique<base::ListValue>());
-        std::vector<const IndexedDBTransaction*> transactions =
-            db->transaction_coordinator().GetTransactions();
-        for (const auto* transaction : transactions) {
-          std::unique_ptr<base::DictionaryValue> transaction_info(
-              std::make_unique<base::DictionaryValue>());
-
-          const char* const kModes[] =
-              { "readonly", "readwrite", "versionchange" };
-          transaction_info->SetString("mode", kModes[transaction->mode()]);
-          switch (transaction->state()) {
-            case IndexedDBTransaction::CREATED:
-              transaction_info->SetString("status", "blocked");
-              break;
-            case IndexedDBTransaction::STARTED:
-              if (transaction->diagnostics().tasks_scheduled > 0)
-                transaction_info->SetString("status", "running");
-              else
-                transaction_info->SetString("status", "started");
-              break;
-            case IndexedDBTransaction::COMMITTING:
-              transaction_info->SetString("status", "committing");
-              break;
-            case IndexedDBTransaction::FINISHED:
-              transaction_info->SetString("status", "finished");
-              break;
-          }
-
-          transaction_info->SetDouble(
-              "pid", transaction->connection()->child_process_id());
-          transaction_info->SetDouble("tid", transaction->id());
-          transaction_info->SetDouble(
-              "age",
-              (base::Time::Now() - transaction->diagnostics().creation_time)
-                  .InMillisecondsF());
-          transaction_info->SetDouble(
-              "runtime",
-              (base::Time::Now() - transaction->diagnostics().start_time)
-                  .InMillisecondsF());
-          transaction_info->SetDouble(
-              "tasks_scheduled", transaction->diagnostics().tasks_scheduled);
-          transaction_info->SetDouble(
-              "tasks_completed", transaction->diagnostics().tasks_completed);
-
-          std::unique_ptr<base::ListValue> scope(
-              std::make_unique<base::ListValue>());
-          for (const auto& id : transaction->scope()) {
-            const auto& it = db->metadata().object_stores.find(id);
-            if (it != db->metadata().object_stores.end())
-              scope->AppendString(it->second.name);
-          }
-
-          transaction_info->Set("scope", std::move(scope));
-          transaction_list->Append(std::move(transaction_info));
-        }
-        db_info->Set("transactions", std::move(transaction_list));
-
-        database_list->Append(std::move(db_info));
+    db_info->SetString("name", db->name());
+    db_info->SetDouble("connection_count", db->ConnectionCount());
+    db_info->SetDouble("active_open_delete", db->ActiveOpenDeleteCount());
+    db_info->SetDouble("pending_open_delete", db->PendingOpenDeleteCount());
+
+    std::unique_ptr<base::ListValue> transaction_list(
+        std::make_unique<base::ListValue>());
+    std::vector<const IndexedDBTransaction*> transactions =
+        db->transaction_coordinator().GetTransactions();
+    for (const auto* transaction : transactions) {
+      std::unique_ptr<base::DictionaryValue> transaction_info(
+          std::make_unique<base::DictionaryValue>());
+
+      const char* const kModes[] =
+          { "readonly", "readwrite", "versionchange" };
+      transaction_info->SetString("mode", kModes[transaction->mode()]);
+      switch (transaction->state()) {
+        case IndexedDBTransaction::CREATED:
+          transaction_info->SetString("status", "blocked");
+          break;
+        case IndexedDBTransaction::STARTED:
+          if (transaction->diagnostics().tasks_scheduled > 0)
+            transaction_info->SetString("status", "running");
+          else
+            transaction_info->SetString("status", "started");
+          break;
+        case IndexedDBTransaction::COMMITTING:
+          transaction_info->SetString("status", "committing");
+          break;
+        case IndexedDBTransaction::FINISHED:
+          transaction_info->SetString("status", "finished");
+          break;
+      }
+
+      transaction_info->SetDouble(
+          "pid", transaction->connection()->child_process_id());
+      transaction_info->SetDouble("tid", transaction->id());
+      transaction_info->SetDouble(
+          "age",
+          (base::Time::Now() - transaction->diagnostics().creation_time)
+              .InMillisecondsF());
+      transaction_info->SetDouble(
+          "runtime",
+          (base::Time::Now() - transaction->diagnostics().start_time)
+              .InMillisecondsF());
+      transaction_info->SetDouble(
+          "tasks_scheduled", transaction->diagnostics().tasks_scheduled);
+      transaction_info->SetDouble(
+          "tasks_completed", transaction->diagnostics().tasks_completed);
+
+      std::unique_ptr<base::ListValue> scope(
+          std::make_unique<base::ListValue>());
+      for (const auto& id : transaction->scope()) {
+        const auto& it = db->metadata().object_stores.find(id);
+        if (it != db->metadata().object_stores.end())
+          scope->AppendString(it->second.name);
       }
-      info->Set("databases", std::move(database_list));
+
+      transaction_info->Set("scope", std::move(scope));
+      transaction_list->Append(std::move(transaction_info));
     }
+    db_info->Set("transactions", std::move(transaction_list));
 
-    list->Append(std::move(info));
+    database_list->Append(std::move(db_info));
   }
-  return list.release();
+  return database_list;
 }
 
 int IndexedDBContextImpl::GetOriginBlobFileCount(const Origin& origin) {
@@ -297,15 +372,14 @@ int64_t IndexedDBContextImpl::GetOriginDiskUsage(const GURL& origin_url) {
 }
 
 int64_t IndexedDBContextImpl::GetOriginDiskUsage(const Origin& origin) {
-  DCHECK(TaskRunner()->RunsTasksInCurrentSequence());
   if (data_path_.empty() || !HasOrigin(origin))
     return 0;
   EnsureDiskUsageCacheInitialized(origin);
+  base::AutoLock lock(lock_);
   return origin_size_map_[origin];
 }
 
 base::Time IndexedDBContextImpl::GetOriginLastModified(const Origin& origin) {
-  DCHECK(TaskRunner()->RunsTasksInCurrentSequence());
   if (data_path_.empty() || !HasOrigin(origin))
     return base::Time();
   base::FilePath idb_directory = GetLevelDBPath(origin);
@@ -321,8 +395,22 @@ void IndexedDBContextImpl::DeleteForOrigin(const GURL& origin_url) {
 }
 
 void IndexedDBContextImpl::DeleteForOrigin(const Origin& origin) {
-  DCHECK(TaskRunner()->RunsTasksInCurrentSequence());
-  ForceClose(origin, FORCE_CLOSE_DELETE_ORIGIN);
+  DeleteForOrigin(origin, base::BindOnce(&base::DoNothing));
+}
+
+void IndexedDBContextImpl::DeleteForOrigin(const Origin& origin,
+                                           base::OnceClosure callback) {
+  RunOnOriginSequence(
+      origin,
+      base::BindOnce(&IndexedDBContextImpl::DeleteForOriginOnOriginSequence,
+                     this, origin),
+      std::move(callback));
+}
+
+void IndexedDBContextImpl::DeleteForOriginOnOriginSequence(
+    const Origin& origin) {
+  DCHECK(TaskRunnerForOrigin(origin)->RunsTasksInCurrentSequence());
+  ForceCloseOnOriginSequence(origin, FORCE_CLOSE_DELETE_ORIGIN);
   if (data_path_.empty() || !HasOrigin(origin))
     return;
 
@@ -343,6 +431,7 @@ void IndexedDBContextImpl::DeleteForOrigin(const Origin& origin) {
   QueryDiskAndUpdateQuotaUsage(origin);
   if (s.ok()) {
     RemoveFromOriginSet(origin);
+    base::AutoLock lock(lock_);
     origin_size_map_.erase(origin);
   }
 }
@@ -355,14 +444,24 @@ void IndexedDBContextImpl::CopyOriginData(const GURL& origin_url,
 
 void IndexedDBContextImpl::CopyOriginData(const Origin& origin,
                                           IndexedDBContext* dest_context) {
-  DCHECK(TaskRunner()->RunsTasksInCurrentSequence());
+  RunOnOriginSequence(
+      origin,
+      base::BindOnce(&IndexedDBContextImpl::CopyOriginDataOnOriginSequence,
+                     this, origin, base::RetainedRef(dest_context)),
+      base::BindOnce(&base::DoNothing));
+}
+
+void IndexedDBContextImpl::CopyOriginDataOnOriginSequence(
+    const Origin& origin,
+    IndexedDBContext* dest_context) {
+  DCHECK(TaskRunnerForOrigin(origin)->RunsTasksInCurrentSequence());
   if (data_path_.empty() || !HasOrigin(origin))
     return;
 
   IndexedDBContextImpl* dest_context_impl =
       static_cast<IndexedDBContextImpl*>(dest_context);
 
-  ForceClose(origin, FORCE_CLOSE_COPY_ORIGIN);
+  ForceCloseOnOriginSequence(origin, FORCE_CLOSE_COPY_ORIGIN);
 
   // Make sure we're not about to delete our own database.
   CHECK_NE(dest_context_impl->data_path().value(), data_path().value());
@@ -386,7 +485,22 @@ void IndexedDBContextImpl::CopyOriginData(const Origin& origin,
 
 void IndexedDBContextImpl::ForceClose(const Origin origin,
                                       ForceCloseReason reason) {
-  DCHECK(TaskRunner()->RunsTasksInCurrentSequence());
+  ForceClose(origin, reason, base::BindOnce(&base::DoNothing));
+}
+
+void IndexedDBContextImpl::ForceClose(const Origin origin,
+                                      ForceCloseReason reason,
+                                      base::OnceClosure callback) {
+  RunOnOriginSequence(
+      origin,
+      base::BindOnce(&IndexedDBContextImpl::ForceCloseOnOriginSequence, this,
+                     origin, reason),
+      std::move(callback));
+}
+
+void IndexedDBContextImpl::ForceCloseOnOriginSequence(const Origin origin,
+                                                      ForceCloseReason reason) {
+  DCHECK(TaskRunnerForOrigin(origin)->RunsTasksInCurrentSequence());
   UMA_HISTOGRAM_ENUMERATION("WebCore.IndexedDB.Context.ForceCloseReason",
                             reason,
                             FORCE_CLOSE_REASON_MAX);
@@ -394,20 +508,39 @@ void IndexedDBContextImpl::ForceClose(const Origin origin,
   if (data_path_.empty() || !HasOrigin(origin))
     return;
 
-  if (factory_.get())
-    factory_->ForceClose(origin);
+  IndexedDBFactory* factory = factories_[GetShardIndex(origin)].get();
+  if (factory)
+    factory->ForceClose(origin);
+  UpdateConnectionCount(origin);
   DCHECK_EQ(0UL, GetConnectionCount(origin));
 }
 
 size_t IndexedDBContextImpl::GetConnectionCount(const Origin& origin) {
-  DCHECK(TaskRunner()->RunsTasksInCurrentSequence());
   if (data_path_.empty() || !HasOrigin(origin))
     return 0;
 
-  if (!factory_.get())
+  if (!TaskRunnerForOrigin(origin)->RunsTasksInCurrentSequence()) {
+    base::AutoLock lock(lock_);
+    auto it = origin_connection_count_map_.find(origin);
+    return it == origin_connection_count_map_.end() ? 0 : it->second;
+  }
+
+  IndexedDBFactory* factory = factories_[GetShardIndex(origin)].get();
+  if (!factory)
     return 0;
 
-  return factory_->GetConnectionCount(origin);
+  return factory->GetConnectionCount(origin);
+}
+
+void IndexedDBContextImpl::UpdateConnectionCount(const Origin& origin) {
+  DCHECK(TaskRunnerForOrigin(origin)->RunsTasksInCurrentSequence());
+  IndexedDBFactory* factory = factories_[GetShardIndex(origin)].get();
+  size_t count = factory ? factory->GetConnectionCount(origin) : 0;
+  base::AutoLock lock(lock_);
+  if (count)
+    origin_connection_count_map_[origin] = count;
+  else
+    origin_connection_count_map_.erase(origin);
 }
 
 std::vector<base::FilePath> IndexedDBContextImpl::GetStoragePaths(
@@ -431,17 +564,20 @@ base::FilePath IndexedDBContextImpl::GetFilePathForTesting(
 
 void IndexedDBContextImpl::SetTaskRunnerForTesting(
     scoped_refptr<base::SequencedTaskRunner> task_runner) {
+  DCHECK(origin_task_runners_.empty());
   task_runner_ = std::move(task_runner);
 }
 
 void IndexedDBContextImpl::ResetCachesForTesting() {
+  base::AutoLock lock(lock_);
   origin_set_.reset();
   origin_size_map_.clear();
+  origin_connection_count_map_.clear();
 }
 
 void IndexedDBContextImpl::ConnectionOpened(const Origin& origin,
                                             IndexedDBConnection* connection) {
-  DCHECK(TaskRunner()->RunsTasksInCurrentSequence());
+  DCHECK(TaskRunnerForOrigin(origin)->RunsTasksInCurrentSequence());
   quota_manager_proxy()->NotifyStorageAccessed(
       storage::QuotaClient::kIndexedDatabase, origin.GetURL(),
       storage::kStorageTypeTemporary);
@@ -451,20 +587,25 @@ void IndexedDBContextImpl::ConnectionOpened(const Origin& origin,
   } else {
     EnsureDiskUsageCacheInitialized(origin);
   }
+  UpdateConnectionCount(origin);
 }
 
 void IndexedDBContextImpl::ConnectionClosed(const Origin& origin,
                                             IndexedDBConnection* connection) {
-  DCHECK(TaskRunner()->RunsTasksInCurrentSequence());
+  DCHECK(TaskRunnerForOrigin(origin)->RunsTasksInCurrentSequence());
   quota_manager_proxy()->NotifyStorageAccessed(
       storage::QuotaClient::kIndexedDatabase, origin.GetURL(),
       storage::kStorageTypeTemporary);
-  if (factory_.get() && factory_->GetConnectionCount(origin) == 0)
+  IndexedDBFactory* factory = factories_[GetShardIndex(origin)].get();
+  if (factory && factory->GetConnectionCount(origin) == 0)
     QueryDiskAndUpdateQuotaUsage(origin);
+  UpdateConnectionCount(origin);
 }
 
 void IndexedDBContextImpl::TransactionComplete(const Origin& origin) {
-  DCHECK(!factory_.get() || factory_->GetConnectionCount(origin) > 0);
+  DCHECK(TaskRunnerForOrigin(origin)->RunsTasksInCurrentSequence());
+  DCHECK(!factories_[GetShardIndex(origin)].get() ||
+         factories_[GetShardIndex(origin)]->GetConnectionCount(origin) > 0);
   QueryDiskAndUpdateQuotaUsage(origin);
 }
 
@@ -485,6 +626,13 @@ void IndexedDBContextImpl::RemoveObserver(
 }
 
 void IndexedDBContextImpl::NotifyIndexedDBListChanged(const Origin& origin) {
+  if (!TaskRunner()->RunsTasksInCurrentSequence()) {
+    TaskRunner()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&IndexedDBContextImpl::NotifyIndexedDBListChanged, this,
+                       origin));
+    return;
+  }
   for (auto& observer : observers_)
     observer.OnIndexedDBListChanged(origin);
 }
@@ -493,6 +641,13 @@ void IndexedDBContextImpl::NotifyIndexedDBContentChanged(
     const Origin& origin,
     const base::string16& database_name,
     const base::string16& object_store_name) {
+  if (!TaskRunner()->RunsTasksInCurrentSequence()) {
+    TaskRunner()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&IndexedDBContextImpl::NotifyIndexedDBContentChanged,
+                       this, origin, database_name, object_store_name));
+    return;
+  }
   for (auto& observer : observers_) {
     observer.OnIndexedDBContentChanged(origin, database_name,
                                        object_store_name);
@@ -504,29 +659,32 @@ void IndexedDBContextImpl::BlobFilesCleaned(const url::Origin& origin) {
 }
 
 IndexedDBContextImpl::~IndexedDBContextImpl() {
-  if (factory_.get()) {
-    TaskRunner()->PostTask(FROM_HERE,
-                           base::BindOnce(&IndexedDBFactory::ContextDestroyed,
-                                          base::Passed(&factory_)));
-  }
-
-  if (data_path_.empty())
-    return;
-
-  if (force_keep_session_state_)
-    return;
-
+  // Session-only databases are cleared, unless there are none or this is told
+  // to keep them, once every factory has closed its backing stores.
   bool has_session_only_databases =
       special_storage_policy_.get() &&
       special_storage_policy_->HasSessionOnlyOrigins();
+  base::OnceClosure all_factories_destroyed = base::BindOnce(&base::DoNothing);
+  if (!data_path_.empty() && !force_keep_session_state_ &&
+      has_session_only_databases) {
+    all_factories_destroyed = base::BindOnce(
+        base::IgnoreResult(&base::SequencedTaskRunner::PostTask), task_runner_,
+        FROM_HERE,
+        base::BindOnce(&ClearSessionOnlyOrigins, data_path_,
+                       special_storage_policy_));
+  }
 
-  // Clearing only session-only databases, and there are none.
-  if (!has_session_only_databases)
-    return;
-
-  TaskRunner()->PostTask(FROM_HERE,
-                         base::BindOnce(&ClearSessionOnlyOrigins, data_path_,
-                                        special_storage_policy_));
+  base::RepeatingClosure factory_destroyed = base::BarrierClosure(
+      static_cast<int>(factories_.size()), std::move(all_factories_destroyed));
+  for (size_t i = 0; i < factories_.size(); ++i) {
+    base::SequencedTaskRunner* task_runner =
+        origin_task_runners_.empty() ? TaskRunner()
+                                     : origin_task_runners_[i].get();
+    task_runner->PostTask(FROM_HERE,
+                          base::BindOnce(&DestroyFactory,
+                                         std::move(factories_[i]),
+                                         factory_destroyed));
+  }
 }
 
 // static
@@ -571,16 +729,28 @@ int64_t IndexedDBContextImpl::ReadUsageFromDisk(const Origin& origin) const {
 
 void IndexedDBContextImpl::EnsureDiskUsageCacheInitialized(
     const Origin& origin) {
-  if (origin_size_map_.find(origin) == origin_size_map_.end())
-    origin_size_map_[origin] = ReadUsageFromDisk(origin);
+  {
+    base::AutoLock lock(lock_);
+    if (origin_size_map_.find(origin) != origin_size_map_.end())
+      return;
+  }
+  // The disk is read without holding the lock. If another sequence got there
+  // first, its entry is kept.
+  int64_t disk_usage = ReadUsageFromDisk(origin);
+  base::AutoLock lock(lock_);
+  origin_size_map_.insert(std::make_pair(origin, disk_usage));
 }
 
 void IndexedDBContextImpl::QueryDiskAndUpdateQuotaUsage(const Origin& origin) {
-  int64_t former_disk_usage = origin_size_map_[origin];
   int64_t current_disk_usage = ReadUsageFromDisk(origin);
-  int64_t difference = current_disk_usage - former_disk_usage;
+  int64_t difference;
+  {
+    base::AutoLock lock(lock_);
+    int64_t& disk_usage = origin_size_map_[origin];
+    difference = current_disk_usage - disk_usage;
+    disk_usage = current_disk_usage;
+  }
   if (difference) {
-    origin_size_map_[origin] = current_disk_usage;
     quota_manager_proxy()->NotifyStorageModified(
         storage::QuotaClient::kIndexedDatabase, origin.GetURL(),
         storage::kStorageTypeTemporary, difference);
@@ -588,16 +758,61 @@ void IndexedDBContextImpl::QueryDiskAndUpdateQuotaUsage(const Origin& origin) {
   }
 }
 
-std::set<Origin>* IndexedDBContextImpl::GetOriginSet() {
+size_t IndexedDBContextImpl::GetShardIndex(const Origin& origin) const {
+  if (origin_task_runners_.empty())
+    return 0;
+  return base::Hash(origin.Serialize()) % origin_task_runners_.size();
+}
+
+void IndexedDBContextImpl::RunOnOriginSequence(const Origin& origin,
+                                               base::OnceClosure task,
+                                               base::OnceClosure reply) {
+  base::SequencedTaskRunner* task_runner = TaskRunnerForOrigin(origin);
+  if (task_runner->RunsTasksInCurrentSequence()) {
+    std::move(task).Run();
+    std::move(reply).Run();
+    return;
+  }
+
+  DCHECK(TaskRunner()->RunsTasksInCurrentSequence());
+  task_runner->PostTaskAndReply(FROM_HERE, std::move(task), std::move(reply));
+}
+
+void IndexedDBContextImpl::EnsureOriginSetInitialized() {
+  {
+    base::AutoLock lock(lock_);
+    if (origin_set_)
+      return;
+  }
+  // The disk is read without holding the lock. If another sequence got there
+  // first, its set is kept.
+  std::vector<Origin> origins;
+  GetAllOriginsAndPaths(data_path_, &origins, nullptr);
+  base::AutoLock lock(lock_);
   if (!origin_set_) {
-    std::vector<Origin> origins;
-    GetAllOriginsAndPaths(data_path_, &origins, nullptr);
     origin_set_ =
         std::make_unique<std::set<Origin>>(origins.begin(), origins.end());
   }
+}
+
+std::set<Origin>* IndexedDBContextImpl::GetOriginSet() {
+  lock_.AssertAcquired();
+  DCHECK(origin_set_);
   return origin_set_.get();
 }
 
+bool IndexedDBContextImpl::AddToOriginSet(const Origin& origin) {
+  EnsureOriginSetInitialized();
+  base::AutoLock lock(lock_);
+  return GetOriginSet()->insert(origin).second;
+}
+
+void IndexedDBContextImpl::RemoveFromOriginSet(const Origin& origin) {
+  EnsureOriginSetInitialized();
+  base::AutoLock lock(lock_);
+  GetOriginSet()->erase(origin);
+}
+
 base::SequencedTaskRunner* IndexedDBContextImpl::TaskRunner() const {
   DCHECK(task_runner_.get());
   return task_runner_.get();
@@ -13,10 +13,12 @@
 #include <set>
 #include <vector>
 
+#include "base/callback.h"
 #include "base/compiler_specific.h"
 #include "base/files/file_path.h"
 #include "base/gtest_prod_util.h"
 #include "base/macros.h"
+#include "base/synchronization/lock.h"
 #include "content/browser/browser_main_loop.h"
 #include "content/browser/indexed_db/indexed_db_factory.h"
 #include "content/public/browser/indexed_db_context.h"
@@ -73,7 +75,22 @@ class CONTENT_EXPORT IndexedDBContextImpl : public IndexedDBContext {
       scoped_refptr<storage::SpecialStoragePolicy> special_storage_policy,
       scoped_refptr<storage::QuotaManagerProxy> quota_manager_proxy);
 
-  IndexedDBFactory* GetIDBFactory();
+  // Returns the factory which holds the backing stores and databases of
+  // |origin|. Must be called on TaskRunnerForOrigin(|origin|).
+  IndexedDBFactory* GetIDBFactory(const url::Origin& origin);
+
+  // Returns the sequence which runs the IndexedDB work of |origin|: its backing
+  // store, databases and transactions.
+  //
+  // By default this is TaskRunner() for every origin. With the
+  // IndexedDBOriginSequences feature, origins are spread over a bounded pool
+  // of sequences, each with its own factory, so that a busy origin doesn't
+  // hold up the others. TaskRunner() then only runs the work which spans
+  // origins, e.g. for the quota system and the observers. The per-origin
+  // methods below may still be called on it: they post to the origin's
+  // sequence without waiting for it.
+  base::SequencedTaskRunner* TaskRunnerForOrigin(
+      const url::Origin& origin) const;
 
   // Disables the exit-time deletion of session-only data.
   void SetForceKeepSessionState() { force_keep_session_state_ = true; }
@@ -93,6 +110,8 @@ class CONTENT_EXPORT IndexedDBContextImpl : public IndexedDBContext {
   void DeleteForOrigin(const url::Origin& origin);
   void CopyOriginData(const url::Origin& origin,
                       IndexedDBContext* dest_context);
+  // Runs |callback| on the calling sequence once |origin| is deleted.
+  void DeleteForOrigin(const url::Origin& origin, base::OnceClosure callback);
   base::FilePath GetFilePathForTesting(const url::Origin& origin) const;
 
   // Methods called by IndexedDBDispatcherHost for quota support.
@@ -116,17 +135,27 @@ class CONTENT_EXPORT IndexedDBContextImpl : public IndexedDBContext {
   std::vector<url::Origin> GetAllOrigins();
   bool HasOrigin(const url::Origin& origin);
 
-  // Used by IndexedDBInternalsUI to populate internals page.
-  base::ListValue* GetAllOriginsDetails();
+  // Used by IndexedDBInternalsUI to populate internals page. |callback| is run
+  // on TaskRunner() once every origin's sequence has listed its open
+  // databases.
+  using OriginsDetailsCallback =
+      base::OnceCallback<void(std::unique_ptr<base::ListValue>)>;
+  void GetAllOriginsDetails(OriginsDetailsCallback callback);
 
   // ForceClose takes a value rather than a reference since it may release the
   // owning object.
   void ForceClose(const url::Origin origin, ForceCloseReason reason);
+  // Runs |callback| on the calling sequence once |origin| is closed.
+  void ForceClose(const url::Origin origin,
+                  ForceCloseReason reason,
+                  base::OnceClosure callback);
   // GetStoragePaths returns all paths owned by this database, in arbitrary
   // order.
   std::vector<base::FilePath> GetStoragePaths(const url::Origin& origin) const;
 
   base::FilePath data_path() const { return data_path_; }
+  // Off the origin's sequence, this is the count as of the last connection
+  // change or ForceClose() on it.
   size_t GetConnectionCount(const url::Origin& origin);
   int GetOriginBlobFileCount(const url::Origin& origin);
 
@@ -145,6 +174,7 @@ class CONTENT_EXPORT IndexedDBContextImpl : public IndexedDBContext {
   void AddObserver(Observer* observer);
   void RemoveObserver(Observer* observer);
 
+  // The observers are notified on TaskRunner().
   void NotifyIndexedDBListChanged(const url::Origin& origin);
   void NotifyIndexedDBContentChanged(const url::Origin& origin,
                                      const base::string16& database_name,
@@ -174,23 +204,56 @@ class CONTENT_EXPORT IndexedDBContextImpl : public IndexedDBContext {
   void QueryDiskAndUpdateQuotaUsage(const url::Origin& origin);
   base::Time GetOriginLastModified(const url::Origin& origin);
 
+  // Returns the open databases of |origin|, for the internals page.
+  std::unique_ptr<base::ListValue> GetOpenDatabasesDetails(
+      const url::Origin& origin);
+
+  // These run on the origin's sequence.
+  void DeleteForOriginOnOriginSequence(const url::Origin& origin);
+  void CopyOriginDataOnOriginSequence(const url::Origin& origin,
+                                      IndexedDBContext* dest_context);
+  void ForceCloseOnOriginSequence(const url::Origin origin,
+                                  ForceCloseReason reason);
+  void UpdateConnectionCount(const url::Origin& origin);
+
+  // Returns the index of the factory and sequence of |origin|.
+  size_t GetShardIndex(const url::Origin& origin) const;
+
+  // Runs |task| on TaskRunnerForOrigin(|origin|), then |reply| on the current
+  // sequence. Both run right away if that is the origin's sequence; otherwise
+  // it must be TaskRunner(), and |task| is posted.
+  void RunOnOriginSequence(const url::Origin& origin,
+                           base::OnceClosure task,
+                           base::OnceClosure reply);
+
+  // Lists the origins on disk, without holding |lock_|, unless that was
+  // already done.
+  void EnsureOriginSetInitialized();
+  // |lock_| must be held, after EnsureOriginSetInitialized().
   std::set<url::Origin>* GetOriginSet();
-  bool AddToOriginSet(const url::Origin& origin) {
-    return GetOriginSet()->insert(origin).second;
-  }
-  void RemoveFromOriginSet(const url::Origin& origin) {
-    GetOriginSet()->erase(origin);
-  }
+  bool AddToOriginSet(const url::Origin& origin);
+  void RemoveFromOriginSet(const url::Origin& origin);
 
-  scoped_refptr<IndexedDBFactory> factory_;
   base::FilePath data_path_;
   // If true, nothing (not even session-only data) should be deleted on exit.
   bool force_keep_session_state_;
   scoped_refptr<storage::SpecialStoragePolicy> special_storage_policy_;
   scoped_refptr<storage::QuotaManagerProxy> quota_manager_proxy_;
   scoped_refptr<base::SequencedTaskRunner> task_runner_;
+  // Empty unless each origin runs on one of these sequences rather than on
+  // |task_runner_|.
+  std::vector<scoped_refptr<base::SequencedTaskRunner>> origin_task_runners_;
+  // One per origin sequence, or a single one on |task_runner_|. Each is only
+  // accessed on its sequence.
+  std::vector<scoped_refptr<IndexedDBFactory>> factories_;
+
+  // Guards the caches of which origins have data, how much and how many
+  // connections they have, which all origin sequences update.
+  base::Lock lock_;
   std::unique_ptr<std::set<url::Origin>> origin_set_;
   std::map<url::Origin, int64_t> origin_size_map_;
+  std::map<url::Origin, size_t> origin_connection_count_map_;
+
   base::ObserverList<Observer> observers_;
 
   DISALLOW_COPY_AND_ASSIGN(IndexedDBContextImpl);
@@ -5,11 +5,15 @@
 #include "content/browser/indexed_db/indexed_db_cursor.h"
 
 #include <stddef.h>
+
+#include <algorithm>
 #include <utility>
 #include <vector>
 
 #include "base/bind.h"
+#include "base/feature_list.h"
 #include "base/logging.h"
+#include "base/time/time.h"
 #include "content/browser/indexed_db/indexed_db_callbacks.h"
 #include "content/browser/indexed_db/indexed_db_database_error.h"
 #include "content/browser/indexed_db/indexed_db_tracing.h"
@@ -67,6 +71,8 @@ IndexedDBCursor::IndexedDBCursor(
       closed_(false),
       ptr_factory_(this) {
   IDB_ASYNC_TRACE_BEGIN("IndexedDBCursor::open", this);
+  if (base::FeatureList::IsEnabled(kIDBAdaptivePrefetch))
+    prefetch_sizer_ = std::make_unique<IndexedDBPrefetchSizer>();
 }
 
 IndexedDBCursor::~IndexedDBCursor() {
@@ -182,9 +188,20 @@ leveldb::Status IndexedDBCursor::CursorPrefetchIterationOperation(
   IDB_TRACE("IndexedDBCursor::CursorPrefetchIterationOperation");
   leveldb::Status s = leveldb::Status::OK();
 
+  int batch_limit = number_to_fetch;
+  if (prefetch_sizer_)
+    batch_limit = prefetch_sizer_->GetBatchLimit(number_to_fetch);
+  base::TimeTicks start_time = base::TimeTicks::Now();
+
   std::vector<IndexedDBKey> found_keys;
   std::vector<IndexedDBKey> found_primary_keys;
   std::vector<IndexedDBValue> found_values;
+  // |number_to_fetch| comes from the renderer, so isn't trusted this far.
+  size_t reserved_records = static_cast<size_t>(
+      std::min(batch_limit, IndexedDBPrefetchSizer::kMaxBatchRecords));
+  found_keys.reserve(reserved_records);
+  found_primary_keys.reserve(reserved_records);
+  found_values.reserve(reserved_records);
 
   saved_cursor_.reset();
   // TODO(cmumford): Use IPC::Channel::kMaximumMessageSize
@@ -194,7 +211,7 @@ leveldb::Status IndexedDBCursor::CursorPrefetchIterationOperation(
   // TODO(cmumford): Handle this error (crbug.com/363397). Although this will
   //                 properly fail, caller will not know why, and any corruption
   //                 will be ignored.
-  for (int i = 0; i < number_to_fetch; ++i) {
+  for (int i = 0; i < batch_limit; ++i) {
     if (!cursor_ || !cursor_->Continue(&s)) {
       cursor_.reset();
       if (s.ok()) {
@@ -219,13 +236,13 @@ leveldb::Status IndexedDBCursor::CursorPrefetchIterationOperation(
 
     switch (cursor_type_) {
       case indexed_db::CURSOR_KEY_ONLY:
-        found_values.push_back(IndexedDBValue());
+        found_values.emplace_back();
         break;
       case indexed_db::CURSOR_KEY_AND_VALUE: {
-        IndexedDBValue value;
-        value.swap(*cursor_->value());
-        size_estimate += value.SizeEstimate();
-        found_values.push_back(value);
+        // The value is moved rather than copied into the batch.
+        found_values.emplace_back();
+        found_values.back().swap(*cursor_->value());
+        size_estimate += found_values.back().SizeEstimate();
         break;
       }
       default:
@@ -236,6 +253,16 @@ leveldb::Status IndexedDBCursor::CursorPrefetchIterationOperation(
 
     if (size_estimate > max_size_estimate)
       break;
+    if (prefetch_sizer_ &&
+        prefetch_sizer_->ShouldEndBatch(number_to_fetch, i + 1, size_estimate,
+                                        start_time)) {
+      break;
+    }
+  }
+
+  if (prefetch_sizer_) {
+    prefetch_sizer_->OnBatchFetched(found_keys.size(), size_estimate,
+                                    base::TimeTicks::Now() - start_time);
   }
 
   if (found_keys.empty()) {
@@ -257,6 +284,8 @@ leveldb::Status IndexedDBCursor::PrefetchReset(int used_prefetches,
 
   if (closed_)
     return s;
+  if (prefetch_sizer_)
+    prefetch_sizer_->OnBatchReset(used_prefetches);
   // First prefetched result is always used.
   if (cursor_){
     DCHECK_GT(used_prefetches, 0);
@@ -15,6 +15,7 @@
 #include "base/memory/weak_ptr.h"
 #include "content/browser/indexed_db/indexed_db_backing_store.h"
 #include "content/browser/indexed_db/indexed_db_database.h"
+#include "content/browser/indexed_db/indexed_db_prefetch_sizer.h"
 #include "content/browser/indexed_db/indexed_db_transaction.h"
 #include "content/common/indexed_db/indexed_db_key_range.h"
 #include "third_party/WebKit/public/platform/modules/indexeddb/WebIDBTypes.h"
@@ -74,6 +75,9 @@ class CONTENT_EXPORT IndexedDBCursor {
 
   bool closed_;
 
+  // Null unless kIDBAdaptivePrefetch is enabled.
+  std::unique_ptr<IndexedDBPrefetchSizer> prefetch_sizer_;
+
   base::WeakPtrFactory<IndexedDBCursor> ptr_factory_;
 
   DISALLOW_COPY_AND_ASSIGN(IndexedDBCursor);
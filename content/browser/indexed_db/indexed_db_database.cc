@@ -1161,7 +1161,7 @@ Status IndexedDBDatabase::GetAllOperation(
     if (cursor_type == indexed_db::CURSOR_KEY_ONLY)
       found_keys.push_back(return_key);
     else
-      found_values.push_back(return_value);
+      found_values.push_back(std::move(return_value));
   }
 
   if (cursor_type == indexed_db::CURSOR_KEY_ONLY) {
@@ -135,6 +135,7 @@ class CONTENT_EXPORT IndexedDBDatabase
 
   void TransactionCreated(IndexedDBTransaction* transaction);
   void TransactionFinished(IndexedDBTransaction* transaction, bool committed);
+  int64_t transaction_count_for_testing() const { return transaction_count_; }
 
   void AbortAllTransactionsForConnections();
 
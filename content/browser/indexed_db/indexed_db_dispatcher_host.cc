@@ -86,7 +86,8 @@ void CallAbortStatusCallbackOnIOThread(
 
 }  // namespace
 
-class IndexedDBDispatcherHost::IDBSequenceHelper {
+class IndexedDBDispatcherHost::IDBSequenceHelper
+    : public base::RefCountedThreadSafe<IDBSequenceHelper> {
  public:
   IDBSequenceHelper(
       int ipc_process_id,
@@ -95,7 +96,6 @@ class IndexedDBDispatcherHost::IDBSequenceHelper {
       : ipc_process_id_(ipc_process_id),
         request_context_getter_(std::move(request_context_getter)),
         indexed_db_context_(std::move(indexed_db_context)) {}
-  ~IDBSequenceHelper() {}
 
   void GetDatabaseNamesOnIDBThread(scoped_refptr<IndexedDBCallbacks> callbacks,
                                    const url::Origin& origin);
@@ -118,6 +118,10 @@ class IndexedDBDispatcherHost::IDBSequenceHelper {
       const url::Origin& origin);
 
  private:
+  friend class base::RefCountedThreadSafe<IDBSequenceHelper>;
+
+  ~IDBSequenceHelper() {}
+
   const int ipc_process_id_;
   scoped_refptr<net::URLRequestContextGetter> request_context_getter_;
   scoped_refptr<IndexedDBContextImpl> indexed_db_context_;
@@ -140,9 +144,7 @@ IndexedDBDispatcherHost::IndexedDBDispatcherHost(
   DCHECK(indexed_db_context_.get());
 }
 
-IndexedDBDispatcherHost::~IndexedDBDispatcherHost() {
-  IDBTaskRunner()->DeleteSoon(FROM_HERE, idb_helper_);
-}
+IndexedDBDispatcherHost::~IndexedDBDispatcherHost() {}
 
 void IndexedDBDispatcherHost::AddBinding(
     ::indexed_db::mojom::FactoryAssociatedRequest request) {
@@ -224,12 +226,12 @@ void IndexedDBDispatcherHost::GetDatabaseNames(
     return;
   }
 
-  scoped_refptr<IndexedDBCallbacks> callbacks(new IndexedDBCallbacks(
-      this->AsWeakPtr(), origin, std::move(callbacks_info), IDBTaskRunner()));
-  IDBTaskRunner()->PostTask(
+  scoped_refptr<IndexedDBCallbacks> callbacks(
+      new IndexedDBCallbacks(this->AsWeakPtr(), origin,
+                             std::move(callbacks_info), IDBTaskRunner(origin)));
+  IDBTaskRunner(origin)->PostTask(
       FROM_HERE, base::BindOnce(&IDBSequenceHelper::GetDatabaseNamesOnIDBThread,
-                                base::Unretained(idb_helper_),
-                                base::Passed(&callbacks), origin));
+                                idb_helper_, base::Passed(&callbacks), origin));
 }
 
 void IndexedDBDispatcherHost::Open(
@@ -247,15 +249,16 @@ void IndexedDBDispatcherHost::Open(
     return;
   }
 
-  scoped_refptr<IndexedDBCallbacks> callbacks(new IndexedDBCallbacks(
-      this->AsWeakPtr(), origin, std::move(callbacks_info), IDBTaskRunner()));
+  scoped_refptr<IndexedDBCallbacks> callbacks(
+      new IndexedDBCallbacks(this->AsWeakPtr(), origin,
+                             std::move(callbacks_info), IDBTaskRunner(origin)));
   scoped_refptr<IndexedDBDatabaseCallbacks> database_callbacks(
       new IndexedDBDatabaseCallbacks(indexed_db_context_,
                                      std::move(database_callbacks_info)));
-  IDBTaskRunner()->PostTask(
+  IDBTaskRunner(origin)->PostTask(
       FROM_HERE,
-      base::BindOnce(&IDBSequenceHelper::OpenOnIDBThread,
-                     base::Unretained(idb_helper_), base::Passed(&callbacks),
+      base::BindOnce(&IDBSequenceHelper::OpenOnIDBThread, idb_helper_,
+                     base::Passed(&callbacks),
                      base::Passed(&database_callbacks), origin, name, version,
                      transaction_id));
 }
@@ -272,13 +275,14 @@ void IndexedDBDispatcherHost::DeleteDatabase(
     return;
   }
 
-  scoped_refptr<IndexedDBCallbacks> callbacks(new IndexedDBCallbacks(
-      this->AsWeakPtr(), origin, std::move(callbacks_info), IDBTaskRunner()));
-  IDBTaskRunner()->PostTask(
+  scoped_refptr<IndexedDBCallbacks> callbacks(
+      new IndexedDBCallbacks(this->AsWeakPtr(), origin,
+                             std::move(callbacks_info), IDBTaskRunner(origin)));
+  IDBTaskRunner(origin)->PostTask(
       FROM_HERE,
       base::BindOnce(&IDBSequenceHelper::DeleteDatabaseOnIDBThread,
-                     base::Unretained(idb_helper_), base::Passed(&callbacks),
-                     origin, name, force_close));
+                     idb_helper_, base::Passed(&callbacks), origin, name,
+                     force_close));
 }
 
 void IndexedDBDispatcherHost::AbortTransactionsAndCompactDatabase(
@@ -294,12 +298,11 @@ void IndexedDBDispatcherHost::AbortTransactionsAndCompactDatabase(
   base::OnceCallback<void(leveldb::Status)> callback_on_io = base::BindOnce(
       &CallCompactionStatusCallbackOnIOThread,
       base::ThreadTaskRunnerHandle::Get(), std::move(mojo_callback));
-  IDBTaskRunner()->PostTask(
+  IDBTaskRunner(origin)->PostTask(
       FROM_HERE,
       base::BindOnce(
           &IDBSequenceHelper::AbortTransactionsAndCompactDatabaseOnIDBThread,
-          base::Unretained(idb_helper_), base::Passed(&callback_on_io),
-          origin));
+          idb_helper_, base::Passed(&callback_on_io), origin));
 }
 
 void IndexedDBDispatcherHost::AbortTransactionsForDatabase(
@@ -315,12 +318,11 @@ void IndexedDBDispatcherHost::AbortTransactionsForDatabase(
   base::OnceCallback<void(leveldb::Status)> callback_on_io = base::BindOnce(
       &CallAbortStatusCallbackOnIOThread, base::ThreadTaskRunnerHandle::Get(),
       std::move(mojo_callback));
-  IDBTaskRunner()->PostTask(
+  IDBTaskRunner(origin)->PostTask(
       FROM_HERE,
       base::BindOnce(
           &IDBSequenceHelper::AbortTransactionsForDatabaseOnIDBThread,
-          base::Unretained(idb_helper_), base::Passed(&callback_on_io),
-          origin));
+          idb_helper_, base::Passed(&callback_on_io), origin));
 }
 
 void IndexedDBDispatcherHost::InvalidateWeakPtrsAndClearBindings() {
@@ -329,17 +331,19 @@ void IndexedDBDispatcherHost::InvalidateWeakPtrsAndClearBindings() {
   database_bindings_.CloseAllBindings();
 }
 
-base::SequencedTaskRunner* IndexedDBDispatcherHost::IDBTaskRunner() const {
-  return indexed_db_context_->TaskRunner();
+base::SequencedTaskRunner* IndexedDBDispatcherHost::IDBTaskRunner(
+    const url::Origin& origin) const {
+  return indexed_db_context_->TaskRunnerForOrigin(origin);
 }
 
 void IndexedDBDispatcherHost::IDBSequenceHelper::GetDatabaseNamesOnIDBThread(
     scoped_refptr<IndexedDBCallbacks> callbacks,
     const url::Origin& origin) {
-  DCHECK(indexed_db_context_->TaskRunner()->RunsTasksInCurrentSequence());
+  DCHECK(indexed_db_context_->TaskRunnerForOrigin(origin)
+             ->RunsTasksInCurrentSequence());
 
   base::FilePath indexed_db_path = indexed_db_context_->data_path();
-  indexed_db_context_->GetIDBFactory()->GetDatabaseNames(
+  indexed_db_context_->GetIDBFactory(origin)->GetDatabaseNames(
       callbacks, origin, indexed_db_path, request_context_getter_);
 }
 
@@ -350,7 +354,8 @@ void IndexedDBDispatcherHost::IDBSequenceHelper::OpenOnIDBThread(
     const base::string16& name,
     int64_t version,
     int64_t transaction_id) {
-  DCHECK(indexed_db_context_->TaskRunner()->RunsTasksInCurrentSequence());
+  DCHECK(indexed_db_context_->TaskRunnerForOrigin(origin)
+             ->RunsTasksInCurrentSequence());
 
   base::TimeTicks begin_time = base::TimeTicks::Now();
   base::FilePath indexed_db_path = indexed_db_context_->data_path();
@@ -363,9 +368,9 @@ void IndexedDBDispatcherHost::IDBSequenceHelper::OpenOnIDBThread(
           callbacks, database_callbacks, ipc_process_id_, transaction_id,
           version);
   DCHECK(request_context_getter_);
-  indexed_db_context_->GetIDBFactory()->Open(name, std::move(connection),
-                                             request_context_getter_, origin,
-                                             indexed_db_path);
+  indexed_db_context_->GetIDBFactory(origin)->Open(
+      name, std::move(connection), request_context_getter_, origin,
+      indexed_db_path);
 }
 
 void IndexedDBDispatcherHost::IDBSequenceHelper::DeleteDatabaseOnIDBThread(
@@ -373,11 +378,12 @@ void IndexedDBDispatcherHost::IDBSequenceHelper::DeleteDatabaseOnIDBThread(
     const url::Origin& origin,
     const base::string16& name,
     bool force_close) {
-  DCHECK(indexed_db_context_->TaskRunner()->RunsTasksInCurrentSequence());
+  DCHECK(indexed_db_context_->TaskRunnerForOrigin(origin)
+             ->RunsTasksInCurrentSequence());
 
   base::FilePath indexed_db_path = indexed_db_context_->data_path();
   DCHECK(request_context_getter_);
-  indexed_db_context_->GetIDBFactory()->DeleteDatabase(
+  indexed_db_context_->GetIDBFactory(origin)->DeleteDatabase(
       name, request_context_getter_, callbacks, origin, indexed_db_path,
       force_close);
 }
@@ -386,19 +392,21 @@ void IndexedDBDispatcherHost::IDBSequenceHelper::
     AbortTransactionsAndCompactDatabaseOnIDBThread(
         base::OnceCallback<void(leveldb::Status)> callback,
         const url::Origin& origin) {
-  DCHECK(indexed_db_context_->TaskRunner()->RunsTasksInCurrentSequence());
+  DCHECK(indexed_db_context_->TaskRunnerForOrigin(origin)
+             ->RunsTasksInCurrentSequence());
 
-  indexed_db_context_->GetIDBFactory()->AbortTransactionsAndCompactDatabase(
-      std::move(callback), origin);
+  indexed_db_context_->GetIDBFactory(origin)
+      ->AbortTransactionsAndCompactDatabase(std::move(callback), origin);
 }
 
 void IndexedDBDispatcherHost::IDBSequenceHelper::
     AbortTransactionsForDatabaseOnIDBThread(
         base::OnceCallback<void(leveldb::Status)> callback,
         const url::Origin& origin) {
-  DCHECK(indexed_db_context_->TaskRunner()->RunsTasksInCurrentSequence());
+  DCHECK(indexed_db_context_->TaskRunnerForOrigin(origin)
+             ->RunsTasksInCurrentSequence());
 
-  indexed_db_context_->GetIDBFactory()->AbortTransactionsForDatabase(
+  indexed_db_context_->GetIDBFactory(origin)->AbortTransactionsForDatabase(
       std::move(callback), origin);
 }
 
@@ -115,7 +115,8 @@ class CONTENT_EXPORT IndexedDBDispatcherHost
 
   void InvalidateWeakPtrsAndClearBindings();
 
-  base::SequencedTaskRunner* IDBTaskRunner() const;
+  // Returns the sequence which runs the IndexedDB work of |origin|.
+  base::SequencedTaskRunner* IDBTaskRunner(const url::Origin& origin) const;
 
   scoped_refptr<IndexedDBContextImpl> indexed_db_context_;
   scoped_refptr<ChromeBlobStorageContext> blob_storage_context_;
@@ -138,7 +139,8 @@ class CONTENT_EXPORT IndexedDBDispatcherHost
   mojo::StrongAssociatedBindingSet<::indexed_db::mojom::Cursor>
       cursor_bindings_;
 
-  IDBSequenceHelper* idb_helper_;
+  // Shared by the tasks posted to the origin sequences, which may outlive this.
+  scoped_refptr<IDBSequenceHelper> idb_helper_;
 
   base::WeakPtrFactory<IndexedDBDispatcherHost> weak_factory_;
 
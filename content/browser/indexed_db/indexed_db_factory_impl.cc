@@ -576,7 +576,7 @@ IndexedDBFactoryImpl::OpenBackingStoreHelper(
     leveldb::Status* status) {
   return IndexedDBBackingStore::Open(
       this, origin, data_directory, request_context_getter, data_loss_info,
-      disk_full, context_->TaskRunner(), first_time, status);
+      disk_full, context_->TaskRunnerForOrigin(origin), first_time, status);
 }
 
 scoped_refptr<IndexedDBBackingStore> IndexedDBFactoryImpl::OpenBackingStore(
@@ -605,7 +605,7 @@ scoped_refptr<IndexedDBBackingStore> IndexedDBFactoryImpl::OpenBackingStore(
   bool first_time = false;
   if (open_in_memory) {
     backing_store = IndexedDBBackingStore::OpenInMemory(
-        origin, context_->TaskRunner(), status);
+        origin, context_->TaskRunnerForOrigin(origin), status);
   } else {
     first_time = !backends_opened_since_boot_.count(origin);
 
@@ -156,6 +156,7 @@ leveldb::Status IndexedDBFakeBackingStore::FakeTransaction::CommitPhaseOne(
   return leveldb::Status::OK();
 }
 leveldb::Status IndexedDBFakeBackingStore::FakeTransaction::CommitPhaseTwo() {
+  set_sync_deferred(result_.ok() && group_commit_allowed());
   return result_;
 }
 uint64_t IndexedDBFakeBackingStore::FakeTransaction::GetTransactionSize() {
@@ -163,4 +164,8 @@ uint64_t IndexedDBFakeBackingStore::FakeTransaction::GetTransactionSize() {
 }
 void IndexedDBFakeBackingStore::FakeTransaction::Rollback() {}
 
+leveldb::Status IndexedDBFakeBackingStore::SyncGroupCommit() {
+  return group_commit_result_;
+}
+
 }  // namespace content
@@ -108,6 +108,8 @@ class IndexedDBFakeBackingStore : public IndexedDBBackingStore {
     explicit FakeTransaction(leveldb::Status phase_two_result);
     void Begin() override;
     leveldb::Status CommitPhaseOne(scoped_refptr<BlobWriteCallback>) override;
+    // Defers the sync if the transaction allows it, like a transaction
+    // without blobs.
     leveldb::Status CommitPhaseTwo() override;
     uint64_t GetTransactionSize() override;
     void Rollback() override;
@@ -118,11 +120,19 @@ class IndexedDBFakeBackingStore : public IndexedDBBackingStore {
     DISALLOW_COPY_AND_ASSIGN(FakeTransaction);
   };
 
+  void set_group_commit_result(leveldb::Status result) {
+    group_commit_result_ = result;
+  }
+
  protected:
   friend class base::RefCounted<IndexedDBFakeBackingStore>;
   ~IndexedDBFakeBackingStore() override;
 
+  leveldb::Status SyncGroupCommit() override;
+
  private:
+  leveldb::Status group_commit_result_;
+
   DISALLOW_COPY_AND_ASSIGN(IndexedDBFakeBackingStore);
 };
 
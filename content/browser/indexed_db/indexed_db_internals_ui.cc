@@ -110,15 +110,19 @@ void IndexedDBInternalsUI::GetAllOriginsOnIndexedDBThread(
   IndexedDBContextImpl* context_impl =
       static_cast<IndexedDBContextImpl*>(context.get());
 
-  std::unique_ptr<base::ListValue> info_list(
-      context_impl->GetAllOriginsDetails());
   bool is_incognito = context_impl->is_incognito();
+  context_impl->GetAllOriginsDetails(base::BindOnce(
+      &IndexedDBInternalsUI::OnOriginsDetailsReadyOnIndexedDBThread,
+      base::Unretained(this), is_incognito ? base::FilePath() : context_path));
+}
 
+void IndexedDBInternalsUI::OnOriginsDetailsReadyOnIndexedDBThread(
+    const base::FilePath& path,
+    std::unique_ptr<base::ListValue> info_list) {
   BrowserThread::PostTask(
       BrowserThread::UI, FROM_HERE,
       base::BindOnce(&IndexedDBInternalsUI::OnOriginsReady,
-                     base::Unretained(this), base::Passed(&info_list),
-                     is_incognito ? base::FilePath() : context_path));
+                     base::Unretained(this), std::move(info_list), path));
 }
 
 void IndexedDBInternalsUI::OnOriginsReady(
@@ -221,7 +225,17 @@ void IndexedDBInternalsUI::DownloadOriginDataOnIndexedDBThread(
   if (!context->HasOrigin(origin))
     return;
 
-  context->ForceClose(origin, IndexedDBContextImpl::FORCE_CLOSE_INTERNALS_PAGE);
+  context->ForceClose(
+      origin, IndexedDBContextImpl::FORCE_CLOSE_INTERNALS_PAGE,
+      base::BindOnce(&IndexedDBInternalsUI::ZipOriginDataOnIndexedDBThread,
+                     base::Unretained(this), partition_path, context, origin));
+}
+
+void IndexedDBInternalsUI::ZipOriginDataOnIndexedDBThread(
+    const base::FilePath& partition_path,
+    const scoped_refptr<IndexedDBContextImpl> context,
+    const Origin& origin) {
+  DCHECK(context->TaskRunner()->RunsTasksInCurrentSequence());
   size_t connection_count = context->GetConnectionCount(origin);
 
   base::ScopedTempDir temp_dir;
@@ -256,7 +270,17 @@ void IndexedDBInternalsUI::ForceCloseOriginOnIndexedDBThread(
   if (!context->HasOrigin(origin))
     return;
 
-  context->ForceClose(origin, IndexedDBContextImpl::FORCE_CLOSE_INTERNALS_PAGE);
+  context->ForceClose(
+      origin, IndexedDBContextImpl::FORCE_CLOSE_INTERNALS_PAGE,
+      base::BindOnce(&IndexedDBInternalsUI::DidForceCloseOnIndexedDBThread,
+                     base::Unretained(this), partition_path, context, origin));
+}
+
+void IndexedDBInternalsUI::DidForceCloseOnIndexedDBThread(
+    const base::FilePath& partition_path,
+    const scoped_refptr<IndexedDBContextImpl> context,
+    const Origin& origin) {
+  DCHECK(context->TaskRunner()->RunsTasksInCurrentSequence());
   size_t connection_count = context->GetConnectionCount(origin);
 
   BrowserThread::PostTask(BrowserThread::UI, FROM_HERE,
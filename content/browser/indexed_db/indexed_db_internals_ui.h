@@ -40,6 +40,9 @@ class IndexedDBInternalsUI : public WebUIController {
   void GetAllOrigins(const base::ListValue* args);
   void GetAllOriginsOnIndexedDBThread(scoped_refptr<IndexedDBContext> context,
                                       const base::FilePath& context_path);
+  void OnOriginsDetailsReadyOnIndexedDBThread(
+      const base::FilePath& path,
+      std::unique_ptr<base::ListValue> info_list);
   void OnOriginsReady(std::unique_ptr<base::ListValue> origins,
                       const base::FilePath& path);
 
@@ -50,6 +53,10 @@ class IndexedDBInternalsUI : public WebUIController {
       const base::FilePath& partition_path,
       const scoped_refptr<IndexedDBContextImpl> context,
       const url::Origin& origin);
+  void ZipOriginDataOnIndexedDBThread(
+      const base::FilePath& partition_path,
+      const scoped_refptr<IndexedDBContextImpl> context,
+      const url::Origin& origin);
   void OnDownloadDataReady(const base::FilePath& partition_path,
                            const url::Origin& origin,
                            const base::FilePath temp_path,
@@ -67,6 +74,10 @@ class IndexedDBInternalsUI : public WebUIController {
       const base::FilePath& partition_path,
       const scoped_refptr<IndexedDBContextImpl> context,
       const url::Origin& origin);
+  void DidForceCloseOnIndexedDBThread(
+      const base::FilePath& partition_path,
+      const scoped_refptr<IndexedDBContextImpl> context,
+      const url::Origin& origin);
   void OnForcedClose(const base::FilePath& partition_path,
                      const url::Origin& origin,
                      size_t connection_count);
@@ -0,0 +1,308 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include "base/barrier_closure.h"
+#include "base/bind.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/macros.h"
+#include "base/run_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/test/scoped_feature_list.h"
+#include "base/threading/sequenced_task_runner_handle.h"
+#include "base/time/time.h"
+#include "content/browser/indexed_db/indexed_db_backing_store.h"
+#include "content/browser/indexed_db/indexed_db_callbacks.h"
+#include "content/browser/indexed_db/indexed_db_context_impl.h"
+#include "content/browser/indexed_db/indexed_db_cursor.h"
+#include "content/browser/indexed_db/indexed_db_database_error.h"
+#include "content/browser/indexed_db/indexed_db_prefetch_sizer.h"
+#include "content/browser/indexed_db/indexed_db_return_value.h"
+#include "content/browser/indexed_db/indexed_db_value.h"
+#include "content/browser/indexed_db/leveldb/leveldb_comparator.h"
+#include "content/browser/indexed_db/leveldb/leveldb_database.h"
+#include "content/browser/indexed_db/leveldb/leveldb_write_batch.h"
+#include "content/common/indexed_db/indexed_db_key_range.h"
+#include "content/public/common/content_features.h"
+#include "content/public/test/test_browser_thread_bundle.h"
+#include "storage/browser/blob/blob_data_handle.h"
+#include "storage/browser/test/mock_quota_manager_proxy.h"
+#include "storage/browser/test/mock_special_storage_policy.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "url/gurl.h"
+#include "url/origin.h"
+
+using url::Origin;
+
+namespace content {
+
+namespace {
+
+const size_t kNumOrigins = 8;
+const size_t kTransactionsPerOrigin = 50;
+const size_t kRecordsPerTransaction = 20;
+const size_t kRecordSize = 1024;
+
+const int64_t kDatabaseId = 1;
+const int64_t kObjectStoreId = 1;
+const int kNumCursorRecords = 1000 * 1000;
+const int kCursorRecordsPerTransaction = 1000;
+const size_t kCursorRecordSize = 100;
+
+class SimpleComparator : public LevelDBComparator {
+ public:
+  int Compare(const base::StringPiece& a,
+              const base::StringPiece& b) const override {
+    size_t len = std::min(a.size(), b.size());
+    int result = memcmp(a.begin(), b.begin(), len);
+    if (result)
+      return result;
+    return a.size() < b.size() ? -1 : (a.size() > b.size() ? 1 : 0);
+  }
+  const char* Name() const override { return "idb_perftest_comparator"; }
+};
+
+// Opens the database of |origin| and commits |kTransactionsPerOrigin| write
+// transactions to it, as a page writing to IndexedDB would.
+void WriteOriginData(const base::FilePath& path, const base::Closure& done) {
+  SimpleComparator comparator;
+  std::unique_ptr<LevelDBDatabase> db;
+  leveldb::Status status = LevelDBDatabase::Open(
+      path, &comparator, LevelDBDatabase::kDefaultMaxOpenIteratorsPerDatabase,
+      &db);
+  EXPECT_TRUE(status.ok());
+  if (status.ok()) {
+    const std::string value(kRecordSize, 'x');
+    for (size_t i = 0; i < kTransactionsPerOrigin; ++i) {
+      std::unique_ptr<LevelDBWriteBatch> batch = LevelDBWriteBatch::Create();
+      for (size_t j = 0; j < kRecordsPerTransaction; ++j)
+        batch->Put(base::StringPrintf("key-%zu-%zu", i, j), value);
+      EXPECT_TRUE(db->Write(*batch).ok());
+    }
+  }
+  done.Run();
+}
+
+class CommitCallback : public IndexedDBBackingStore::BlobWriteCallback {
+ public:
+  CommitCallback() {}
+  leveldb::Status Run(IndexedDBBackingStore::BlobWriteResult result) override {
+    EXPECT_EQ(IndexedDBBackingStore::BlobWriteResult::SUCCESS_SYNC, result);
+    return leveldb::Status::OK();
+  }
+
+ private:
+  ~CommitCallback() override {}
+
+  DISALLOW_COPY_AND_ASSIGN(CommitCallback);
+};
+
+// Receives the result of one prefetch.
+class PrefetchCallbacks : public IndexedDBCallbacks {
+ public:
+  PrefetchCallbacks()
+      : IndexedDBCallbacks(nullptr, url::Origin(), nullptr, nullptr) {}
+
+  void OnSuccessWithPrefetch(const std::vector<IndexedDBKey>& keys,
+                             const std::vector<IndexedDBKey>& primary_keys,
+                             std::vector<IndexedDBValue>* values) override {
+    num_records_ = keys.size();
+  }
+  void OnSuccess(IndexedDBReturnValue* value) override { at_end_ = true; }
+  void OnError(const IndexedDBDatabaseError& error) override {
+    ADD_FAILURE() << "Prefetch failed";
+    at_end_ = true;
+  }
+
+  size_t num_records() const { return num_records_; }
+  bool at_end() const { return at_end_; }
+
+ private:
+  ~PrefetchCallbacks() override {}
+
+  size_t num_records_ = 0;
+  bool at_end_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(PrefetchCallbacks);
+};
+
+}  // namespace
+
+class IndexedDBOriginSequencesPerfTest : public testing::Test {
+ public:
+  IndexedDBOriginSequencesPerfTest()
+      : special_storage_policy_(
+            base::MakeRefCounted<MockSpecialStoragePolicy>()),
+        quota_manager_proxy_(
+            base::MakeRefCounted<MockQuotaManagerProxy>(nullptr, nullptr)) {}
+  ~IndexedDBOriginSequencesPerfTest() override {
+    quota_manager_proxy_->SimulateQuotaManagerDestroyed();
+  }
+
+  // Writes to |kNumOrigins| origins at once, and reports how many transactions
+  // were committed per second.
+  void RunTest(const std::string& trace) {
+    base::ScopedTempDir temp_dir;
+    ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+    scoped_refptr<IndexedDBContextImpl> idb_context =
+        base::MakeRefCounted<IndexedDBContextImpl>(
+            temp_dir.GetPath(), special_storage_policy_.get(),
+            quota_manager_proxy_.get());
+
+    base::RunLoop run_loop;
+    base::RepeatingClosure done =
+        base::BarrierClosure(kNumOrigins, run_loop.QuitClosure());
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (size_t i = 0; i < kNumOrigins; ++i) {
+      Origin origin =
+          Origin::Create(GURL(base::StringPrintf("http://origin%zu/", i)));
+      idb_context->TaskRunnerForOrigin(origin)->PostTask(
+          FROM_HERE,
+          base::BindOnce(&WriteOriginData,
+                         idb_context->GetFilePathForTesting(origin), done));
+    }
+    run_loop.Run();
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    perf_test::PrintResult(
+        "transactions_per_second", "", trace,
+        kNumOrigins * kTransactionsPerOrigin / elapsed.InSecondsF(),
+        "transactions/s", true);
+
+    idb_context = nullptr;
+    base::RunLoop().RunUntilIdle();
+  }
+
+ protected:
+  scoped_refptr<MockSpecialStoragePolicy> special_storage_policy_;
+  scoped_refptr<MockQuotaManagerProxy> quota_manager_proxy_;
+
+ private:
+  TestBrowserThreadBundle thread_bundle_;
+
+  DISALLOW_COPY_AND_ASSIGN(IndexedDBOriginSequencesPerfTest);
+};
+
+TEST_F(IndexedDBOriginSequencesPerfTest, SingleSequence) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndDisableFeature(features::kIndexedDBOriginSequences);
+  RunTest("single_sequence");
+}
+
+TEST_F(IndexedDBOriginSequencesPerfTest, OriginSequences) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(features::kIndexedDBOriginSequences);
+  RunTest("origin_sequences");
+}
+
+class IndexedDBCursorPrefetchPerfTest : public testing::Test {
+ public:
+  IndexedDBCursorPrefetchPerfTest() {}
+
+  void SetUp() override {
+    leveldb::Status status;
+    backing_store_ = IndexedDBBackingStore::OpenInMemory(
+        Origin::Create(GURL("http://origin/")),
+        base::SequencedTaskRunnerHandle::Get().get(), &status);
+    ASSERT_TRUE(backing_store_);
+
+    IndexedDBValue value(std::string(kCursorRecordSize, 'x'), {});
+    for (int i = 0; i < kNumCursorRecords;) {
+      IndexedDBBackingStore::Transaction transaction(backing_store_.get());
+      transaction.Begin();
+      for (int j = 0; j < kCursorRecordsPerTransaction; ++j, ++i) {
+        std::vector<std::unique_ptr<storage::BlobDataHandle>> handles;
+        IndexedDBBackingStore::RecordIdentifier record;
+        IndexedDBKey key(i, blink::kWebIDBKeyTypeNumber);
+        ASSERT_TRUE(backing_store_
+                        ->PutRecord(&transaction, kDatabaseId, kObjectStoreId,
+                                    key, &value, &handles, &record)
+                        .ok());
+      }
+      ASSERT_TRUE(
+          transaction.CommitPhaseOne(base::MakeRefCounted<CommitCallback>())
+              .ok());
+      ASSERT_TRUE(transaction.CommitPhaseTwo().ok());
+    }
+  }
+
+  void TearDown() override {
+    backing_store_ = nullptr;
+    base::RunLoop().RunUntilIdle();
+  }
+
+  // Iterates the whole object store with prefetches, asking for as many
+  // records as the renderer does, and reports the time per record and the
+  // number of prefetches.
+  void RunTest(const std::string& trace) {
+    IndexedDBBackingStore::Transaction transaction(backing_store_.get());
+    transaction.Begin();
+    leveldb::Status status;
+    std::unique_ptr<IndexedDBBackingStore::Cursor> backing_store_cursor =
+        backing_store_->OpenObjectStoreCursor(
+            &transaction, kDatabaseId, kObjectStoreId, IndexedDBKeyRange(),
+            blink::kWebIDBCursorDirectionNext, &status);
+    ASSERT_TRUE(backing_store_cursor);
+    IndexedDBCursor cursor(std::move(backing_store_cursor),
+                           indexed_db::CURSOR_KEY_AND_VALUE,
+                           blink::kWebIDBTaskTypeNormal, nullptr);
+
+    // The renderer asks for 5 records, then twice as many each time, up to 100.
+    int number_to_fetch = 5;
+    size_t num_records = 1;  // Opening the cursor returns the first record.
+    size_t num_prefetches = 0;
+    base::TimeTicks start = base::TimeTicks::Now();
+    while (true) {
+      scoped_refptr<PrefetchCallbacks> callbacks =
+          base::MakeRefCounted<PrefetchCallbacks>();
+      EXPECT_TRUE(cursor
+                      .CursorPrefetchIterationOperation(number_to_fetch,
+                                                        callbacks, nullptr)
+                      .ok());
+      if (callbacks->at_end())
+        break;
+      num_records += callbacks->num_records();
+      ++num_prefetches;
+      number_to_fetch = std::min(number_to_fetch * 2, 100);
+    }
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+    EXPECT_EQ(static_cast<size_t>(kNumCursorRecords), num_records);
+    cursor.Close();
+    transaction.Rollback();
+
+    perf_test::PrintResult("time_per_record", "", trace,
+                           elapsed.InMicrosecondsF() / num_records, "us",
+                           true);
+    perf_test::PrintResult("prefetches", "", trace, num_prefetches,
+                           "prefetches", false);
+  }
+
+ private:
+  TestBrowserThreadBundle thread_bundle_;
+  scoped_refptr<IndexedDBBackingStore> backing_store_;
+
+  DISALLOW_COPY_AND_ASSIGN(IndexedDBCursorPrefetchPerfTest);
+};
+
+TEST_F(IndexedDBCursorPrefetchPerfTest, IterateObjectStore) {
+  {
+    base::test::ScopedFeatureList feature_list;
+    feature_list.InitAndDisableFeature(kIDBAdaptivePrefetch);
+    RunTest("renderer_sized");
+  }
+  {
+    base::test::ScopedFeatureList feature_list;
+    feature_list.InitAndEnableFeature(kIDBAdaptivePrefetch);
+    RunTest("adaptive");
+  }
+}
+
+}  // namespace content
@@ -0,0 +1,88 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "content/browser/indexed_db/indexed_db_prefetch_sizer.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+
+#include "base/feature_list.h"
+#include "base/logging.h"
+
+namespace content {
+
+namespace {
+
+// The newest batch weighs 1 / kAverageWindow in the running averages.
+const int kAverageWindow = 4;
+
+}  // namespace
+
+const base::Feature kIDBAdaptivePrefetch{"IDBAdaptivePrefetch",
+                                         base::FEATURE_DISABLED_BY_DEFAULT};
+
+IndexedDBPrefetchSizer::IndexedDBPrefetchSizer() = default;
+
+IndexedDBPrefetchSizer::~IndexedDBPrefetchSizer() = default;
+
+int IndexedDBPrefetchSizer::GetBatchLimit(int requested) {
+  DCHECK_GT(requested, 0);
+  int limit = requested;
+  // Only grow while the renderer uses up the batches.
+  if (last_batch_used_)
+    limit = std::max(limit, std::min(batch_limit_ * 2, kMaxBatchRecords));
+
+  if (limit > requested && average_record_bytes_ > 0) {
+    int64_t by_bytes =
+        static_cast<int64_t>(kTargetBatchBytes / average_record_bytes_);
+    limit = static_cast<int>(
+        std::max<int64_t>(requested, std::min<int64_t>(limit, by_bytes)));
+  }
+  if (limit > requested && !average_record_time_.is_zero()) {
+    int64_t by_time = base::TimeDelta::FromMilliseconds(kBatchTimeBudgetMs) /
+                      average_record_time_;
+    limit = static_cast<int>(
+        std::max<int64_t>(requested, std::min<int64_t>(limit, by_time)));
+  }
+
+  batch_limit_ = limit;
+  last_batch_used_ = true;
+  return limit;
+}
+
+bool IndexedDBPrefetchSizer::ShouldEndBatch(int requested,
+                                            int num_records,
+                                            size_t num_bytes,
+                                            base::TimeTicks start) const {
+  if (num_records < requested)
+    return false;
+  return num_bytes >= kTargetBatchBytes ||
+         base::TimeTicks::Now() - start >=
+             base::TimeDelta::FromMilliseconds(kBatchTimeBudgetMs);
+}
+
+void IndexedDBPrefetchSizer::OnBatchFetched(int num_records,
+                                            size_t num_bytes,
+                                            base::TimeDelta elapsed) {
+  if (num_records <= 0)
+    return;
+  double record_bytes = static_cast<double>(num_bytes) / num_records;
+  base::TimeDelta record_time = elapsed / num_records;
+  if (average_record_bytes_ == 0) {
+    average_record_bytes_ = record_bytes;
+    average_record_time_ = record_time;
+    return;
+  }
+  average_record_bytes_ +=
+      (record_bytes - average_record_bytes_) / kAverageWindow;
+  average_record_time_ += (record_time - average_record_time_) / kAverageWindow;
+}
+
+void IndexedDBPrefetchSizer::OnBatchReset(int used_records) {
+  batch_limit_ = used_records;
+  last_batch_used_ = false;
+}
+
+}  // namespace content
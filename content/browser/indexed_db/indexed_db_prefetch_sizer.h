@@ -0,0 +1,79 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CONTENT_BROWSER_INDEXED_DB_INDEXED_DB_PREFETCH_SIZER_H_
+#define CONTENT_BROWSER_INDEXED_DB_INDEXED_DB_PREFETCH_SIZER_H_
+
+#include <stddef.h>
+
+#include "base/macros.h"
+#include "base/time/time.h"
+#include "content/common/content_export.h"
+
+namespace base {
+struct Feature;
+}
+
+namespace content {
+
+// Lets IndexedDBPrefetchSizer grow cursor prefetches past what the renderer
+// asks for.
+CONTENT_EXPORT extern const base::Feature kIDBAdaptivePrefetch;
+
+// Sizes the batches of records which an IndexedDBCursor prefetches for the
+// renderer. The renderer asks for a number of records which only grows from 5
+// to 100, whatever the records are like. While the batches are used up, and
+// their records are small and quick to read, the sizer lets them grow further,
+// so that iterating a large object store takes fewer round trips. A batch
+// always holds what the renderer asked for, and only goes past that while it
+// is under a byte target and a time budget, so that it doesn't hold up the
+// transaction or waste work if script stops iterating.
+class CONTENT_EXPORT IndexedDBPrefetchSizer {
+ public:
+  // The most records in a batch.
+  static const int kMaxBatchRecords = 5000;
+  // A batch goes past the records the renderer asked for while it's smaller
+  // than this, and while it's been fetching for less than kBatchTimeBudgetMs.
+  static const size_t kTargetBatchBytes = 1024 * 1024;
+  static const int kBatchTimeBudgetMs = 5;
+
+  IndexedDBPrefetchSizer();
+  ~IndexedDBPrefetchSizer();
+
+  // Returns the most records the next batch may hold, which is at least
+  // |requested|.
+  int GetBatchLimit(int requested);
+
+  // Returns whether the batch which started at |start| should end after
+  // |num_records| records of |num_bytes| bytes, before reaching its limit.
+  bool ShouldEndBatch(int requested,
+                      int num_records,
+                      size_t num_bytes,
+                      base::TimeTicks start) const;
+
+  // Records that a batch of |num_records| records of |num_bytes| bytes took
+  // |elapsed| to fetch.
+  void OnBatchFetched(int num_records,
+                      size_t num_bytes,
+                      base::TimeDelta elapsed);
+
+  // Records that the renderer only used |used_records| of the last batch.
+  void OnBatchReset(int used_records);
+
+ private:
+  // The limit of the last batch.
+  int batch_limit_ = 0;
+  // Whether the last batch hasn't been reset, i.e. the renderer used it all if
+  // it asks for another one.
+  bool last_batch_used_ = false;
+  // Running averages over the fetched records.
+  double average_record_bytes_ = 0;
+  base::TimeDelta average_record_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(IndexedDBPrefetchSizer);
+};
+
+}  // namespace content
+
+#endif  // CONTENT_BROWSER_INDEXED_DB_INDEXED_DB_PREFETCH_SIZER_H_
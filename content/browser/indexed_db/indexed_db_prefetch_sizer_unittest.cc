@@ -0,0 +1,86 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "content/browser/indexed_db/indexed_db_prefetch_sizer.h"
+
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace content {
+namespace {
+
+const base::TimeDelta kFastBatchTime = base::TimeDelta::FromMicroseconds(100);
+
+TEST(IndexedDBPrefetchSizerTest, FirstBatchIsRequested) {
+  IndexedDBPrefetchSizer sizer;
+  EXPECT_EQ(5, sizer.GetBatchLimit(5));
+}
+
+TEST(IndexedDBPrefetchSizerTest, GrowsWhileBatchesAreUsed) {
+  IndexedDBPrefetchSizer sizer;
+  EXPECT_EQ(100, sizer.GetBatchLimit(100));
+  sizer.OnBatchFetched(100, 100 * 100, kFastBatchTime);
+  EXPECT_EQ(200, sizer.GetBatchLimit(100));
+  sizer.OnBatchFetched(200, 200 * 100, kFastBatchTime);
+  EXPECT_EQ(400, sizer.GetBatchLimit(100));
+
+  for (int i = 0; i < 10; ++i) {
+    sizer.OnBatchFetched(100, 100 * 100, kFastBatchTime);
+    sizer.GetBatchLimit(100);
+  }
+  EXPECT_EQ(IndexedDBPrefetchSizer::kMaxBatchRecords,
+            sizer.GetBatchLimit(100));
+}
+
+TEST(IndexedDBPrefetchSizerTest, ShrinksOnReset) {
+  IndexedDBPrefetchSizer sizer;
+  sizer.GetBatchLimit(100);
+  sizer.OnBatchFetched(100, 100 * 100, kFastBatchTime);
+  EXPECT_EQ(200, sizer.GetBatchLimit(100));
+  sizer.OnBatchReset(3);
+
+  // The renderer starts over, and so does the sizer.
+  EXPECT_EQ(5, sizer.GetBatchLimit(5));
+  EXPECT_EQ(10, sizer.GetBatchLimit(10));
+}
+
+TEST(IndexedDBPrefetchSizerTest, LimitedByRecordSize) {
+  IndexedDBPrefetchSizer sizer;
+  const size_t kRecordSize = IndexedDBPrefetchSizer::kTargetBatchBytes / 150;
+  sizer.GetBatchLimit(100);
+  sizer.OnBatchFetched(100, 100 * kRecordSize, kFastBatchTime);
+  EXPECT_EQ(150, sizer.GetBatchLimit(100));
+
+  // Never less than requested.
+  sizer.OnBatchFetched(150, 150 * kRecordSize * 10, kFastBatchTime);
+  EXPECT_EQ(100, sizer.GetBatchLimit(100));
+}
+
+TEST(IndexedDBPrefetchSizerTest, LimitedByRecordTime) {
+  IndexedDBPrefetchSizer sizer;
+  sizer.GetBatchLimit(100);
+  // 25us per record fits 200 records in the time budget.
+  sizer.OnBatchFetched(100, 100 * 100, base::TimeDelta::FromMicroseconds(2500));
+  EXPECT_EQ(200, sizer.GetBatchLimit(100));
+  sizer.OnBatchFetched(200, 200 * 100, base::TimeDelta::FromMicroseconds(5000));
+  EXPECT_EQ(200, sizer.GetBatchLimit(100));
+}
+
+TEST(IndexedDBPrefetchSizerTest, ShouldEndBatch) {
+  IndexedDBPrefetchSizer sizer;
+  base::TimeTicks now = base::TimeTicks::Now();
+  base::TimeTicks long_ago = now - base::TimeDelta::FromSeconds(1);
+
+  // The requested records are always fetched.
+  EXPECT_FALSE(sizer.ShouldEndBatch(
+      100, 50, IndexedDBPrefetchSizer::kTargetBatchBytes * 2, long_ago));
+
+  EXPECT_FALSE(sizer.ShouldEndBatch(100, 100, 100, now));
+  EXPECT_TRUE(sizer.ShouldEndBatch(
+      100, 100, IndexedDBPrefetchSizer::kTargetBatchBytes, now));
+  EXPECT_TRUE(sizer.ShouldEndBatch(100, 100, 100, long_ago));
+}
+
+}  // namespace
+}  // namespace content
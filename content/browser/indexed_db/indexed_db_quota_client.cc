@@ -21,11 +21,19 @@ using storage::DatabaseUtil;
 namespace content {
 namespace {
 
-storage::QuotaStatusCode DeleteOriginDataOnIndexedDBThread(
+void DidDeleteOriginData(
+    const IndexedDBQuotaClient::DeletionCallback& callback) {
+  BrowserThread::PostTask(BrowserThread::IO, FROM_HERE,
+                          base::BindOnce(callback, storage::kQuotaStatusOk));
+}
+
+void DeleteOriginDataOnIndexedDBThread(
     IndexedDBContextImpl* context,
-    const GURL& origin) {
-  context->DeleteForOrigin(origin);
-  return storage::kQuotaStatusOk;
+    const GURL& origin,
+    const IndexedDBQuotaClient::DeletionCallback& callback) {
+  DCHECK(context->TaskRunner()->RunsTasksInCurrentSequence());
+  context->DeleteForOrigin(url::Origin::Create(origin),
+                           base::BindOnce(&DidDeleteOriginData, callback));
 }
 
 int64_t GetOriginUsageOnIndexedDBThread(IndexedDBContextImpl* context,
@@ -142,11 +150,10 @@ void IndexedDBQuotaClient::DeleteOriginData(const GURL& origin,
     return;
   }
 
-  base::PostTaskAndReplyWithResult(
-      indexed_db_context_->TaskRunner(), FROM_HERE,
-      base::Bind(&DeleteOriginDataOnIndexedDBThread,
-                 base::RetainedRef(indexed_db_context_), origin),
-      callback);
+  indexed_db_context_->TaskRunner()->PostTask(
+      FROM_HERE, base::BindOnce(&DeleteOriginDataOnIndexedDBThread,
+                                base::RetainedRef(indexed_db_context_), origin,
+                                callback));
 }
 
 bool IndexedDBQuotaClient::DoesSupport(storage::StorageType type) const {
@@ -5,6 +5,7 @@
 #include "content/browser/indexed_db/indexed_db_transaction.h"
 
 #include "base/bind.h"
+#include "base/feature_list.h"
 #include "base/location.h"
 #include "base/logging.h"
 #include "base/memory/ptr_util.h"
@@ -372,6 +373,7 @@ leveldb::Status IndexedDBTransaction::CommitPhaseTwo() {
 
   leveldb::Status s;
   bool committed;
+  bool sync_deferred = false;
   if (!used_) {
     committed = true;
   } else {
@@ -403,8 +405,14 @@ leveldb::Status IndexedDBTransaction::CommitPhaseTwo() {
         NOTREACHED();
     }
 
+    // Readwrite transactions may complete once their commit is synced along
+    // with the commits of the transactions which follow them.
+    transaction_->set_group_commit_allowed(
+        mode_ == blink::kWebIDBTransactionModeReadWrite &&
+        base::FeatureList::IsEnabled(kIDBGroupCommit));
     s = transaction_->CommitPhaseTwo();
     committed = s.ok();
+    sync_deferred = committed && transaction_->sync_deferred();
   }
 
   // Backing store resources (held via cursors) must be released
@@ -419,7 +427,44 @@ leveldb::Status IndexedDBTransaction::CommitPhaseTwo() {
   // operations like closing connections.
   database_->transaction_coordinator().DidFinishTransaction(this);
 
-  if (committed) {
+  // The commit is visible to the transactions which start now, but the
+  // front-end is only notified once it is on disk. The transactions which
+  // overlap one still waiting for the sync read what it wrote, so they wait
+  // too, and complete in order after it, whatever their mode.
+  IndexedDBBackingStore* backing_store = database_->backing_store();
+  if (committed &&
+      (sync_deferred || backing_store->HasOverlappingGroupCommit(
+                            database_->id(), object_store_ids_))) {
+    group_commit_pending_ = true;
+    backing_store->ScheduleGroupCommit(
+        database_->id(), object_store_ids_,
+        base::BindOnce(&IndexedDBTransaction::GroupCommitComplete,
+                       ptr_factory_.GetWeakPtr()));
+    return s;
+  }
+
+  CommitComplete(s);
+  return s;
+}
+
+void IndexedDBTransaction::GroupCommitComplete() {
+  IDB_TRACE1("IndexedDBTransaction::GroupCommitComplete", "txn.id", id());
+  DCHECK(group_commit_pending_);
+  group_commit_pending_ = false;
+  CommitComplete(leveldb::Status::OK());
+}
+
+void IndexedDBTransaction::AbandonGroupCommit() {
+  IDB_TRACE1("IndexedDBTransaction::AbandonGroupCommit", "txn.id", id());
+  DCHECK(group_commit_pending_);
+  group_commit_pending_ = false;
+  // The commit can't be undone, but isn't known to be on disk either, so the
+  // front-end, whose connection is closing, gets neither complete nor abort.
+  database_->TransactionFinished(this, false);
+}
+
+void IndexedDBTransaction::CommitComplete(const leveldb::Status& s) {
+  if (s.ok()) {
     abort_task_stack_.clear();
 
     // SendObservations must be called before OnComplete to ensure consistency
@@ -440,7 +485,6 @@ leveldb::Status IndexedDBTransaction::CommitPhaseTwo() {
     database_->TransactionFinished(this, true);
     // RemoveTransaction will delete |this|.
     connection_->RemoveTransaction(id_);
-    return s;
   } else {
     while (!abort_task_stack_.empty())
       abort_task_stack_.pop().Run();
@@ -458,7 +502,6 @@ leveldb::Status IndexedDBTransaction::CommitPhaseTwo() {
     callbacks_->OnAbort(*this, error);
     database_->TransactionFinished(this, false);
   }
-  return s;
 }
 
 void IndexedDBTransaction::ProcessTaskQueue() {
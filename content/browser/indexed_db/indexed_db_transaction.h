@@ -151,6 +151,13 @@ class CONTENT_EXPORT IndexedDBTransaction {
   void ProcessTaskQueue();
   void CloseOpenCursors();
   leveldb::Status CommitPhaseTwo();
+  void GroupCommitComplete();
+  // Notifies the front-end of the result of the commit. May delete |this|.
+  void CommitComplete(const leveldb::Status& s);
+  // Called by the connection when it lets go of the transaction while it
+  // still waits for a group commit, which only happens once the group commit
+  // failed.
+  void AbandonGroupCommit();
   void Timeout();
 
   const int64_t id_;
@@ -160,6 +167,9 @@ class CONTENT_EXPORT IndexedDBTransaction {
   bool used_ = false;
   State state_ = CREATED;
   bool commit_pending_ = false;
+  // Whether the transaction committed, but waits for
+  // IndexedDBBackingStore::ScheduleGroupCommit() to complete.
+  bool group_commit_pending_ = false;
   // We are owned by the connection object.
   IndexedDBConnection* connection_;
   scoped_refptr<IndexedDBDatabaseCallbacks> callbacks_;
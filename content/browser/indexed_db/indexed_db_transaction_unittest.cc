@@ -13,6 +13,8 @@
 #include "base/memory/ptr_util.h"
 #include "base/run_loop.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/test/scoped_feature_list.h"
+#include "base/threading/sequenced_task_runner_handle.h"
 #include "content/browser/indexed_db/fake_indexed_db_metadata_coding.h"
 #include "content/browser/indexed_db/indexed_db_connection.h"
 #include "content/browser/indexed_db/indexed_db_database_error.h"
@@ -22,6 +24,7 @@
 #include "content/browser/indexed_db/mock_indexed_db_database_callbacks.h"
 #include "content/browser/indexed_db/mock_indexed_db_factory.h"
 #include "content/public/test/test_browser_thread_bundle.h"
+#include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "third_party/WebKit/public/platform/modules/indexeddb/WebIDBDatabaseException.h"
 
@@ -494,6 +497,143 @@ TEST_F(IndexedDBTransactionTest, IndexedDBObserver) {
   EXPECT_EQ(0UL, connection->active_observers().size());
 }
 
+class IndexedDBTransactionGroupCommitTest : public IndexedDBTransactionTest {
+ public:
+  IndexedDBTransactionGroupCommitTest()
+      : callbacks_(new MockIndexedDBDatabaseCallbacks()) {
+    feature_list_.InitAndEnableFeature(kIDBGroupCommit);
+    // The group commit is posted to the backing store's task runner, and its
+    // failure reported to the factory.
+    backing_store_ = new IndexedDBFakeBackingStore(
+        factory_.get(), base::SequencedTaskRunnerHandle::Get().get());
+    CreateDB();
+    connection_ =
+        std::make_unique<IndexedDBConnection>(kFakeProcessId, db_, callbacks_);
+  }
+
+  // Creates a transaction which has run a task, so that committing it
+  // commits its backing store transaction.
+  IndexedDBTransaction* CreateUsedTransaction(
+      int64_t id,
+      const std::set<int64_t>& scope,
+      blink::WebIDBTransactionMode mode) {
+    IndexedDBTransaction* transaction = connection_->CreateTransaction(
+        id, scope, mode,
+        new IndexedDBFakeBackingStore::FakeTransaction(leveldb::Status::OK()));
+    db_->TransactionCreated(transaction);
+    transaction->ScheduleTask(
+        base::BindOnce(&IndexedDBTransactionTest::DummyOperation,
+                       base::Unretained(this), leveldb::Status::OK()));
+    RunPostedTasks();
+    EXPECT_EQ(IndexedDBTransaction::STARTED, transaction->state());
+    return transaction;
+  }
+
+ protected:
+  scoped_refptr<MockIndexedDBDatabaseCallbacks> callbacks_;
+  std::unique_ptr<IndexedDBConnection> connection_;
+
+ private:
+  base::test::ScopedFeatureList feature_list_;
+
+  DISALLOW_COPY_AND_ASSIGN(IndexedDBTransactionGroupCommitTest);
+};
+
+TEST_F(IndexedDBTransactionGroupCommitTest, CompletesOnceSynced) {
+  const int64_t id = 1;
+  IndexedDBTransaction* transaction =
+      CreateUsedTransaction(id, {1}, blink::kWebIDBTransactionModeReadWrite);
+  transaction->Commit();
+
+  // The transaction committed, but only completes once the group commit has
+  // synced it.
+  EXPECT_EQ(IndexedDBTransaction::FINISHED, transaction->state());
+  EXPECT_TRUE(callbacks_->completed_transaction_ids().empty());
+  EXPECT_EQ(transaction, connection_->GetTransaction(id));
+  EXPECT_EQ(1, db_->transaction_count_for_testing());
+
+  RunPostedTasks();
+  EXPECT_EQ(std::vector<int64_t>({id}),
+            callbacks_->completed_transaction_ids());
+  EXPECT_FALSE(connection_->GetTransaction(id));
+  EXPECT_EQ(0, db_->transaction_count_for_testing());
+  EXPECT_FALSE(callbacks_->abort_called());
+}
+
+TEST_F(IndexedDBTransactionGroupCommitTest, OverlappingTransactionsWait) {
+  IndexedDBTransaction* readwrite =
+      CreateUsedTransaction(1, {1}, blink::kWebIDBTransactionModeReadWrite);
+  IndexedDBTransaction* other =
+      CreateUsedTransaction(3, {3}, blink::kWebIDBTransactionModeReadOnly);
+
+  // The overlapping transaction is blocked by the readwrite one, and commits
+  // as soon as it starts.
+  IndexedDBTransaction* overlapping = connection_->CreateTransaction(
+      2, {1, 2}, blink::kWebIDBTransactionModeReadOnly,
+      new IndexedDBFakeBackingStore::FakeTransaction(leveldb::Status::OK()));
+  db_->TransactionCreated(overlapping);
+  overlapping->Commit();
+  EXPECT_EQ(IndexedDBTransaction::CREATED, overlapping->state());
+
+  readwrite->Commit();
+  other->Commit();
+
+  // Only the transaction which doesn't overlap the waiting one completes
+  // right away. The overlapping one commits before the group commit runs,
+  // but completes after the readwrite one.
+  EXPECT_EQ(std::vector<int64_t>({3}),
+            callbacks_->completed_transaction_ids());
+  RunPostedTasks();
+  EXPECT_EQ(std::vector<int64_t>({3, 1, 2}),
+            callbacks_->completed_transaction_ids());
+  EXPECT_EQ(0, db_->transaction_count_for_testing());
+}
+
+TEST_F(IndexedDBTransactionGroupCommitTest, FailureClosesBackingStore) {
+  const int64_t id = 1;
+  IndexedDBTransaction* transaction =
+      CreateUsedTransaction(id, {1}, blink::kWebIDBTransactionModeReadWrite);
+  backing_store_->set_group_commit_result(
+      leveldb::Status::IOError("Sync failed"));
+  transaction->Commit();
+
+  // The commit is visible already, so the transaction can't abort.
+  EXPECT_CALL(*factory_, HandleBackingStoreFailure(testing::_));
+  RunPostedTasks();
+  EXPECT_TRUE(callbacks_->completed_transaction_ids().empty());
+  EXPECT_FALSE(callbacks_->abort_called());
+  EXPECT_EQ(1, db_->transaction_count_for_testing());
+
+  // Closing the backing store closes the connection, which finishes the
+  // transaction.
+  connection_->AbortAllTransactions(IndexedDBDatabaseError(
+      blink::kWebIDBDatabaseExceptionUnknownError, "Connection is closing."));
+  EXPECT_TRUE(callbacks_->completed_transaction_ids().empty());
+  EXPECT_FALSE(callbacks_->abort_called());
+  EXPECT_EQ(0, db_->transaction_count_for_testing());
+}
+
+TEST_F(IndexedDBTransactionGroupCommitTest, ConnectionClose) {
+  const int64_t id = 1;
+  IndexedDBTransaction* transaction =
+      CreateUsedTransaction(id, {1}, blink::kWebIDBTransactionModeReadWrite);
+  transaction->Commit();
+  EXPECT_TRUE(callbacks_->completed_transaction_ids().empty());
+
+  // The waiting transaction completes when its connection closes, rather
+  // than getting lost with it.
+  connection_->AbortAllTransactions(IndexedDBDatabaseError(
+      blink::kWebIDBDatabaseExceptionUnknownError, "Connection is closing."));
+  EXPECT_EQ(std::vector<int64_t>({id}),
+            callbacks_->completed_transaction_ids());
+  EXPECT_FALSE(callbacks_->abort_called());
+  EXPECT_EQ(0, db_->transaction_count_for_testing());
+
+  RunPostedTasks();
+  EXPECT_EQ(std::vector<int64_t>({id}),
+            callbacks_->completed_transaction_ids());
+}
+
 static const blink::WebIDBTransactionMode kTestModes[] = {
     blink::kWebIDBTransactionModeReadOnly,
     blink::kWebIDBTransactionModeReadWrite,
@@ -10,6 +10,7 @@
 #include "base/macros.h"
 #include "base/memory/ptr_util.h"
 #include "base/run_loop.h"
+#include "base/test/scoped_feature_list.h"
 #include "base/threading/sequenced_task_runner_handle.h"
 #include "content/browser/indexed_db/indexed_db_connection.h"
 #include "content/browser/indexed_db/indexed_db_context_impl.h"
@@ -17,6 +18,7 @@
 #include "content/browser/indexed_db/mock_indexed_db_callbacks.h"
 #include "content/browser/indexed_db/mock_indexed_db_database_callbacks.h"
 #include "content/public/browser/storage_partition.h"
+#include "content/public/common/content_features.h"
 #include "content/public/common/url_constants.h"
 #include "content/public/test/test_browser_thread_bundle.h"
 #include "content/public/test/test_utils.h"
@@ -150,6 +152,59 @@ class ForceCloseDBCallbacks : public IndexedDBCallbacks {
   DISALLOW_COPY_AND_ASSIGN(ForceCloseDBCallbacks);
 };
 
+TEST_F(IndexedDBTest, OriginSequences) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(features::kIndexedDBOriginSequences);
+
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+
+  base::FilePath normal_path;
+  {
+    scoped_refptr<IndexedDBContextImpl> idb_context =
+        base::MakeRefCounted<IndexedDBContextImpl>(
+            temp_dir.GetPath(), special_storage_policy_.get(),
+            quota_manager_proxy_.get());
+
+    base::SequencedTaskRunner* origin_task_runner =
+        idb_context->TaskRunnerForOrigin(kNormalOrigin);
+    EXPECT_NE(idb_context->TaskRunner(), origin_task_runner);
+    EXPECT_EQ(origin_task_runner,
+              idb_context->TaskRunnerForOrigin(kNormalOrigin));
+
+    normal_path = idb_context->GetFilePathForTesting(kNormalOrigin);
+    ASSERT_TRUE(base::CreateDirectory(normal_path));
+
+    // The per-origin methods may be called on the context's sequence, and
+    // reply to it once they ran on the origin's sequence.
+    bool deleted = false;
+    idb_context->TaskRunner()->PostTask(
+        FROM_HERE,
+        base::BindOnce(
+            [](IndexedDBContextImpl* idb_context, const Origin& origin,
+               bool* deleted) {
+              EXPECT_TRUE(idb_context->HasOrigin(origin));
+              EXPECT_EQ(0u, idb_context->GetConnectionCount(origin));
+              idb_context->DeleteForOrigin(
+                  origin, base::BindOnce(
+                              [](IndexedDBContextImpl* idb_context,
+                                 const Origin& origin, bool* deleted) {
+                                EXPECT_TRUE(idb_context->TaskRunner()
+                                                ->RunsTasksInCurrentSequence());
+                                EXPECT_FALSE(idb_context->HasOrigin(origin));
+                                *deleted = true;
+                              },
+                              base::Unretained(idb_context), origin, deleted));
+            },
+            base::Unretained(idb_context.get()), kNormalOrigin, &deleted));
+    RunAllTasksUntilIdle();
+    EXPECT_TRUE(deleted);
+  }
+  RunAllTasksUntilIdle();
+
+  EXPECT_FALSE(base::DirectoryExists(normal_path));
+}
+
 TEST_F(IndexedDBTest, ForceCloseOpenDatabasesOnDelete) {
   base::ScopedTempDir temp_dir;
   ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
@@ -175,7 +230,7 @@ TEST_F(IndexedDBTest, ForceCloseOpenDatabasesOnDelete) {
             const int64_t version = 0;
             const scoped_refptr<net::URLRequestContextGetter> request_context;
 
-            IndexedDBFactory* factory = idb_context->GetIDBFactory();
+            IndexedDBFactory* factory = idb_context->GetIDBFactory(origin);
 
             base::FilePath test_path =
                 idb_context->GetFilePathForTesting(origin);
@@ -256,7 +311,7 @@ TEST_F(IndexedDBTest, ForceCloseOpenDatabasesOnCommitFailure) {
 
             scoped_refptr<IndexedDBFactoryImpl> factory =
                 static_cast<IndexedDBFactoryImpl*>(
-                    idb_context->GetIDBFactory());
+                    idb_context->GetIDBFactory(kTestOrigin));
 
             const int child_process_id = 0;
             const int64_t transaction_id = 1;
@@ -279,7 +334,7 @@ TEST_F(IndexedDBTest, ForceCloseOpenDatabasesOnCommitFailure) {
             // Simulate the write failure.
             leveldb::Status status =
                 leveldb::Status::IOError("Simulated failure");
-            idb_context->GetIDBFactory()->HandleBackingStoreFailure(
+            idb_context->GetIDBFactory(kTestOrigin)->HandleBackingStoreFailure(
                 kTestOrigin);
 
             EXPECT_TRUE(db_callbacks->forced_close_called());
@@ -16,8 +16,10 @@ IndexedDBValue::IndexedDBValue(
   DCHECK(input_blob_info.empty() || input_bits.size());
 }
 IndexedDBValue::IndexedDBValue(const IndexedDBValue& other) = default;
+IndexedDBValue::IndexedDBValue(IndexedDBValue&& other) = default;
 IndexedDBValue::~IndexedDBValue() = default;
 IndexedDBValue& IndexedDBValue::operator=(const IndexedDBValue& other) =
     default;
+IndexedDBValue& IndexedDBValue::operator=(IndexedDBValue&& other) = default;
 
 }  // namespace content
@@ -37,6 +37,7 @@
 #include "third_party/leveldatabase/src/include/leveldb/db.h"
 #include "third_party/leveldatabase/src/include/leveldb/filter_policy.h"
 #include "third_party/leveldatabase/src/include/leveldb/slice.h"
+#include "third_party/leveldatabase/src/include/leveldb/write_batch.h"
 
 using base::StringPiece;
 
@@ -324,6 +325,8 @@ leveldb::Status LevelDBDatabase::Open(const base::FilePath& file_name,
   (*result)->comparator_ = comparator;
   (*result)->filter_policy_ = std::move(filter_policy);
   (*result)->file_name_for_tracing = file_name.BaseName().AsUTF8Unsafe();
+  (*result)->log_sync_on_close_failures_ =
+      LevelDBEnv::Get()->log_sync_on_close_failures();
 
   return s;
 }
@@ -413,9 +416,47 @@ leveldb::Status LevelDBDatabase::Get(const StringPiece& key,
 }
 
 leveldb::Status LevelDBDatabase::Write(const LevelDBWriteBatch& write_batch) {
+  return WriteWithOptions(write_batch, kSyncWrites);
+}
+
+leveldb::Status LevelDBDatabase::WriteUnsynced(
+    const LevelDBWriteBatch& write_batch) {
+  return WriteWithOptions(write_batch, false);
+}
+
+leveldb::Status LevelDBDatabase::Flush() {
   base::TimeTicks begin_time = base::TimeTicks::Now();
   leveldb::WriteOptions write_options;
-  write_options.sync = kSyncWrites;
+  write_options.sync = true;
+
+  // Syncing the log for an empty batch also syncs everything written to the
+  // log before it. The writes in the logs leveldb has switched away from were
+  // synced by LevelDBEnv when it closed them, unless that failed.
+  leveldb::WriteBatch empty_batch;
+  leveldb::Status s = db_->Write(write_options, &empty_batch);
+  const int log_sync_on_close_failures =
+      LevelDBEnv::Get()->log_sync_on_close_failures();
+  if (s.ok() && log_sync_on_close_failures != log_sync_on_close_failures_) {
+    // The failed log may be another database's, but there is no telling.
+    log_sync_on_close_failures_ = log_sync_on_close_failures;
+    s = leveldb::Status::IOError("Failed to sync a closed log file");
+  }
+  if (!s.ok()) {
+    HistogramLevelDBError("WebCore.IndexedDB.LevelDBWriteErrors", s);
+    LOG(ERROR) << "LevelDB flush failed: " << s.ToString();
+  } else {
+    UMA_HISTOGRAM_TIMES("WebCore.IndexedDB.LevelDB.FlushTime",
+                        base::TimeTicks::Now() - begin_time);
+  }
+  return s;
+}
+
+leveldb::Status LevelDBDatabase::WriteWithOptions(
+    const LevelDBWriteBatch& write_batch,
+    bool sync) {
+  base::TimeTicks begin_time = base::TimeTicks::Now();
+  leveldb::WriteOptions write_options;
+  write_options.sync = sync;
 
   const leveldb::Status s =
       db_->Write(write_options, write_batch.write_batch_.get());
@@ -84,6 +84,12 @@ class CONTENT_EXPORT LevelDBDatabase
                               bool* found,
                               const LevelDBSnapshot* = 0);
   leveldb::Status Write(const LevelDBWriteBatch& write_batch);
+  // Like Write(), but returns before the write reaches disk. It is on disk
+  // once Flush() or a later Write() succeeds.
+  leveldb::Status WriteUnsynced(const LevelDBWriteBatch& write_batch);
+  // Syncs all the writes so far to disk. Fails if a log file which leveldb
+  // switched away from could not be synced.
+  leveldb::Status Flush();
   std::unique_ptr<LevelDBIterator> CreateIterator(const LevelDBSnapshot* = 0);
   const LevelDBComparator* Comparator() const;
   void Compact(const base::StringPiece& start, const base::StringPiece& stop);
@@ -114,11 +120,16 @@ class CONTENT_EXPORT LevelDBDatabase
 
   void CloseDatabase();
 
+  leveldb::Status WriteWithOptions(const LevelDBWriteBatch& write_batch,
+                                   bool sync);
+
   std::unique_ptr<leveldb::Env> env_;
   std::unique_ptr<leveldb::Comparator> comparator_adapter_;
   std::unique_ptr<leveldb::DB> db_;
   std::unique_ptr<const leveldb::FilterPolicy> filter_policy_;
   const LevelDBComparator* comparator_;
+  // LevelDBEnv's count of failed log syncs on close as of the last Flush().
+  int log_sync_on_close_failures_ = 0;
 
   struct DetachIteratorOnDestruct {
     DetachIteratorOnDestruct() {}
@@ -14,7 +14,11 @@ base::LazyInstance<content::LevelDBEnv>::Leaky g_leveldb_env =
 
 namespace content {
 
-LevelDBEnv::LevelDBEnv() : ChromiumEnv("LevelDBEnv.IDB") {}
+LevelDBEnv::LevelDBEnv() : ChromiumEnv("LevelDBEnv.IDB") {
+  // Group commits write transactions unsynced, and make them durable with
+  // LevelDBDatabase::Flush(), which only syncs the current log.
+  set_sync_logs_on_close();
+}
 
 LevelDBEnv* LevelDBEnv::Get() {
   return g_leveldb_env.Pointer();
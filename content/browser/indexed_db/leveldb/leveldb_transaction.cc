@@ -141,7 +141,8 @@ leveldb::Status LevelDBTransaction::Commit() {
 
   DCHECK(data_.empty());
 
-  leveldb::Status s = db_->Write(*write_batch);
+  leveldb::Status s = sync_on_commit_ ? db_->Write(*write_batch)
+                                      : db_->WriteUnsynced(*write_batch);
   if (s.ok()) {
     finished_ = true;
     UMA_HISTOGRAM_TIMES("WebCore.IndexedDB.LevelDB.Transaction.CommitTime",
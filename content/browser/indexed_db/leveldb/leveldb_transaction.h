@@ -42,6 +42,10 @@ class CONTENT_EXPORT LevelDBTransaction
 
   uint64_t GetTransactionSize() const { return size_; }
 
+  // Whether Commit() waits for the write to reach disk, which it does by
+  // default. Otherwise it is on disk once LevelDBDatabase::Flush() succeeds.
+  void set_sync_on_commit(bool sync) { sync_on_commit_ = sync; }
+
  protected:
   virtual ~LevelDBTransaction();
   explicit LevelDBTransaction(LevelDBDatabase* db);
@@ -169,6 +173,7 @@ class CONTENT_EXPORT LevelDBTransaction
   DataType data_;
   uint64_t size_ = 0ull;
   bool finished_ = false;
+  bool sync_on_commit_ = true;
   std::set<TransactionIterator*> iterators_;
 
   DISALLOW_COPY_AND_ASSIGN(LevelDBTransaction);
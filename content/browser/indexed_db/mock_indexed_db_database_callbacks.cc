@@ -5,6 +5,7 @@
 #include "content/browser/indexed_db/mock_indexed_db_database_callbacks.h"
 
 #include "content/browser/indexed_db/indexed_db_context_impl.h"
+#include "content/browser/indexed_db/indexed_db_transaction.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace content {
@@ -25,4 +26,9 @@ void MockIndexedDBDatabaseCallbacks::OnAbort(
   abort_called_ = true;
 }
 
+void MockIndexedDBDatabaseCallbacks::OnComplete(
+    const IndexedDBTransaction& transaction) {
+  completed_transaction_ids_.push_back(transaction.id());
+}
+
 }  // namespace content
@@ -7,6 +7,8 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include "base/macros.h"
 #include "content/browser/indexed_db/indexed_db_callbacks.h"
 #include "content/browser/indexed_db/indexed_db_connection.h"
@@ -21,16 +23,21 @@ class MockIndexedDBDatabaseCallbacks : public IndexedDBDatabaseCallbacks {
   void OnForcedClose() override;
   void OnAbort(const IndexedDBTransaction& transaction,
                const IndexedDBDatabaseError& error) override;
-  void OnComplete(const IndexedDBTransaction& transaction) override {}
+  void OnComplete(const IndexedDBTransaction& transaction) override;
 
   bool abort_called() const { return abort_called_; }
   bool forced_close_called() const { return forced_close_called_; }
+  // The ids of the completed transactions, in the order they completed in.
+  const std::vector<int64_t>& completed_transaction_ids() const {
+    return completed_transaction_ids_;
+  }
 
  private:
   ~MockIndexedDBDatabaseCallbacks() override {}
 
   bool abort_called_;
   bool forced_close_called_;
+  std::vector<int64_t> completed_transaction_ids_;
 
   DISALLOW_COPY_AND_ASSIGN(MockIndexedDBDatabaseCallbacks);
 };
@@ -2652,6 +2652,9 @@ void RenderProcessHostImpl::PropagateBrowserCommandLineToRenderer(
     cc::switches::kDisableThreadedAnimation,
     cc::switches::kEnableGpuBenchmarking,
     cc::switches::kEnableLayerLists,
+    cc::switches::kEnableParallelTileRaster,
+    cc::switches::kEnableSharedDecodedImageCache,
+    cc::switches::kEnableWorkStealingRasterWorkerPool,
     cc::switches::kEnableTileCompression,
     cc::switches::kShowCompositedLayerBorders,
     cc::switches::kShowFPSCounter,
@@ -4,6 +4,7 @@
 
 #include "content/common/content_switches_internal.h"
 
+#include <algorithm>
 #include <string>
 
 #include "base/command_line.h"
@@ -16,7 +17,9 @@
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
 #include "build/build_config.h"
+#include "content/public/common/content_features.h"
 #include "content/public/common/content_switches.h"
+#include "mojo/public/cpp/bindings/message_traffic_profiler.h"
 
 #if defined(OS_ANDROID)
 #include "base/debug/debugger.h"
@@ -209,6 +212,16 @@ void WaitForDebugger(const std::string& label) {
 #endif  // defined(OS_POSIX)
 }
 
+void EnableMessageTrafficProfilerIfRequested() {
+  if (!base::FeatureList::IsEnabled(features::kMojoMessageTrafficProfiler) ||
+      mojo::MessageTrafficProfiler::Get()) {
+    return;
+  }
+  int sampling_interval = base::GetFieldTrialParamByFeatureAsInt(
+      features::kMojoMessageTrafficProfiler, "sampling_interval", 100);
+  mojo::MessageTrafficProfiler::Enable(std::max(sampling_interval, 1));
+}
+
 std::vector<std::string> FeaturesFromSwitch(
     const base::CommandLine& command_line,
     const char* switch_name) {
@@ -27,6 +27,10 @@ CONTENT_EXPORT bool IsUseZoomForDSFEnabled();
 
 void WaitForDebugger(const std::string& label);
 
+// Enables the mojo::MessageTrafficProfiler if the MojoMessageTrafficProfiler
+// feature is enabled. Called once the feature list is set up in each process.
+CONTENT_EXPORT void EnableMessageTrafficProfilerIfRequested();
+
 // Returns all comma-separated values from all instances of a switch, in the
 // order they appear.  For example: given command line "--foo=aa,bb --foo=cc",
 // the feature list for switch "foo" will be ["aa", "bb", "cc"].
@@ -184,6 +184,12 @@ const base::Feature kMojoBlobs{"MojoBlobs", base::FEATURE_ENABLED_BY_DEFAULT};
 const base::Feature kMojoInputMessages{"MojoInputMessages",
                                        base::FEATURE_ENABLED_BY_DEFAULT};
 
+// Samples mojo and legacy IPC messages in every process with the
+// mojo::MessageTrafficProfiler. The "sampling_interval" param sets how many
+// messages there are per sample.
+const base::Feature kMojoMessageTrafficProfiler{
+    "MojoMessageTrafficProfiler", base::FEATURE_DISABLED_BY_DEFAULT};
+
 // Mojo-based Session Storage.
 const base::Feature kMojoSessionStorage{"MojoSessionStorage",
                                         base::FEATURE_DISABLED_BY_DEFAULT};
@@ -432,6 +438,11 @@ const base::Feature kWebUsb{"WebUSB", base::FEATURE_ENABLED_BY_DEFAULT};
 const base::Feature kImageCaptureAPI{"ImageCaptureAPI",
                                      base::FEATURE_ENABLED_BY_DEFAULT};
 
+// Runs the IndexedDB backing stores of different origins on a pool of
+// sequences, rather than all of them on one.
+const base::Feature kIndexedDBOriginSequences{
+    "IndexedDBOriginSequences", base::FEATURE_DISABLED_BY_DEFAULT};
+
 // Alternative to switches::kIsolateOrigins, for turning on origin isolation.
 // List of origins to isolate has to be specified via
 // kIsolateOriginsFieldTrialParamName.
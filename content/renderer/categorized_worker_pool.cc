@@ -121,8 +121,14 @@ class CategorizedWorkerPool::CategorizedWorkerPoolSequencedTaskRunner
   cc::Task::Vector completed_tasks_;
 };
 
-CategorizedWorkerPool::CategorizedWorkerPool()
-    : namespace_token_(GenerateNamespaceToken()),
+CategorizedWorkerPool::CategorizedWorkerPool() : CategorizedWorkerPool(false) {}
+
+CategorizedWorkerPool::CategorizedWorkerPool(bool use_work_stealing)
+    : work_stealing_task_graph_runner_(
+          use_work_stealing
+              ? std::make_unique<cc::WorkStealingTaskGraphRunner>()
+              : nullptr),
+      namespace_token_(GenerateNamespaceToken()),
       has_ready_to_run_foreground_tasks_cv_(&lock_),
       has_ready_to_run_background_tasks_cv_(&lock_),
       has_namespaces_with_finished_running_tasks_cv_(&lock_),
@@ -131,6 +137,18 @@ CategorizedWorkerPool::CategorizedWorkerPool()
 void CategorizedWorkerPool::Start(int num_threads) {
   DCHECK(threads_.empty());
 
+  // Use background priority for background thread.
+  base::SimpleThread::Options thread_options;
+#if !defined(OS_MACOSX)
+  thread_options.priority = base::ThreadPriority::BACKGROUND;
+#endif
+
+  if (work_stealing_task_graph_runner_) {
+    work_stealing_task_graph_runner_->Start(
+        num_threads, "CompositorTileWorker", thread_options);
+    return;
+  }
+
   // Start |num_threads| threads for foreground work, including nonconcurrent
   // foreground work.
   std::vector<cc::TaskCategory> foreground_categories;
@@ -150,12 +168,6 @@ void CategorizedWorkerPool::Start(int num_threads) {
   std::vector<cc::TaskCategory> background_categories;
   background_categories.push_back(cc::TASK_CATEGORY_BACKGROUND);
 
-  // Use background priority for background thread.
-  base::SimpleThread::Options thread_options;
-#if !defined(OS_MACOSX)
-  thread_options.priority = base::ThreadPriority::BACKGROUND;
-#endif
-
   std::unique_ptr<base::SimpleThread> thread(new CategorizedWorkerPoolThread(
       "CompositorTileWorkerBackground", thread_options, this,
       background_categories, &has_ready_to_run_background_tasks_cv_));
@@ -166,6 +178,10 @@ void CategorizedWorkerPool::Start(int num_threads) {
 void CategorizedWorkerPool::Shutdown() {
   WaitForTasksToFinishRunning(namespace_token_);
   CollectCompletedTasks(namespace_token_, &completed_tasks_);
+  if (work_stealing_task_graph_runner_) {
+    work_stealing_task_graph_runner_->Shutdown();
+    return;
+  }
   // Shutdown raster threads.
   {
     base::AutoLock lock(lock_);
@@ -246,6 +262,11 @@ void CategorizedWorkerPool::Run(
 }
 
 void CategorizedWorkerPool::FlushForTesting() {
+  if (work_stealing_task_graph_runner_) {
+    work_stealing_task_graph_runner_->FlushForTesting();
+    return;
+  }
+
   base::AutoLock lock(lock_);
 
   while (!work_queue_.HasFinishedRunningTasksInAllNamespaces()) {
@@ -261,6 +282,9 @@ CategorizedWorkerPool::CreateSequencedTaskRunner() {
 CategorizedWorkerPool::~CategorizedWorkerPool() {}
 
 cc::NamespaceToken CategorizedWorkerPool::GenerateNamespaceToken() {
+  if (work_stealing_task_graph_runner_)
+    return work_stealing_task_graph_runner_->GenerateNamespaceToken();
+
   base::AutoLock lock(lock_);
   return work_queue_.GenerateNamespaceToken();
 }
@@ -270,6 +294,11 @@ void CategorizedWorkerPool::ScheduleTasks(cc::NamespaceToken token,
   TRACE_EVENT2("disabled-by-default-cc.debug",
                "CategorizedWorkerPool::ScheduleTasks", "num_nodes",
                graph->nodes.size(), "num_edges", graph->edges.size());
+  if (work_stealing_task_graph_runner_) {
+    work_stealing_task_graph_runner_->ScheduleTasks(token, graph);
+    return;
+  }
+
   {
     base::AutoLock lock(lock_);
     ScheduleTasksWithLockAcquired(token, graph);
@@ -279,6 +308,12 @@ void CategorizedWorkerPool::ScheduleTasks(cc::NamespaceToken token,
 void CategorizedWorkerPool::ScheduleTasksWithLockAcquired(
     cc::NamespaceToken token,
     cc::TaskGraph* graph) {
+  // Tasks posted to the pool itself are scheduled here, with |lock_| held.
+  if (work_stealing_task_graph_runner_) {
+    work_stealing_task_graph_runner_->ScheduleTasks(token, graph);
+    return;
+  }
+
   DCHECK(token.IsValid());
   DCHECK(!cc::TaskGraphWorkQueue::DependencyMismatch(graph));
   DCHECK(!shutdown_);
@@ -296,6 +331,11 @@ void CategorizedWorkerPool::WaitForTasksToFinishRunning(
 
   DCHECK(token.IsValid());
 
+  if (work_stealing_task_graph_runner_) {
+    work_stealing_task_graph_runner_->WaitForTasksToFinishRunning(token);
+    return;
+  }
+
   {
     base::AutoLock lock(lock_);
     base::ThreadRestrictions::ScopedAllowWait allow_wait;
@@ -320,6 +360,12 @@ void CategorizedWorkerPool::CollectCompletedTasks(
   TRACE_EVENT0("disabled-by-default-cc.debug",
                "CategorizedWorkerPool::CollectCompletedTasks");
 
+  if (work_stealing_task_graph_runner_) {
+    work_stealing_task_graph_runner_->CollectCompletedTasks(token,
+                                                            completed_tasks);
+    return;
+  }
+
   {
     base::AutoLock lock(lock_);
     CollectCompletedTasksWithLockAcquired(token, completed_tasks);
@@ -330,6 +376,11 @@ void CategorizedWorkerPool::CollectCompletedTasksWithLockAcquired(
     cc::NamespaceToken token,
     cc::Task::Vector* completed_tasks) {
   DCHECK(token.IsValid());
+  if (work_stealing_task_graph_runner_) {
+    work_stealing_task_graph_runner_->CollectCompletedTasks(token,
+                                                            completed_tasks);
+    return;
+  }
   work_queue_.CollectCompletedTasks(token, completed_tasks);
 }
 
@@ -17,6 +17,7 @@
 #include "cc/raster/task_category.h"
 #include "cc/raster/task_graph_runner.h"
 #include "cc/raster/task_graph_work_queue.h"
+#include "cc/raster/work_stealing_task_graph_runner.h"
 #include "content/common/content_export.h"
 
 namespace content {
@@ -29,10 +30,14 @@ namespace content {
 //    schedule a graph of tasks with their dependencies.
 // 3. CreateSequencedTaskRunner() creates a sequenced task runner that might run
 //    in parallel with other instances of sequenced task runners.
+//
+// If |use_work_stealing| is set, all the work is run by a
+// cc::WorkStealingTaskGraphRunner instead of the pool's own threads.
 class CONTENT_EXPORT CategorizedWorkerPool : public base::TaskRunner,
                                              public cc::TaskGraphRunner {
  public:
   CategorizedWorkerPool();
+  explicit CategorizedWorkerPool(bool use_work_stealing);
 
   // Overridden from base::TaskRunner:
   bool PostDelayedTask(const base::Location& from_here,
@@ -70,6 +75,8 @@ class CONTENT_EXPORT CategorizedWorkerPool : public base::TaskRunner,
   scoped_refptr<base::SequencedTaskRunner> CreateSequencedTaskRunner();
 
   base::PlatformThreadId background_worker_thread_id() const {
+    if (work_stealing_task_graph_runner_)
+      return work_stealing_task_graph_runner_->background_thread_id();
     return threads_.back()->tid();
   }
 
@@ -123,6 +130,11 @@ class CONTENT_EXPORT CategorizedWorkerPool : public base::TaskRunner,
   // The actual threads where work is done.
   std::vector<std::unique_ptr<base::SimpleThread>> threads_;
 
+  // Runs the tasks, instead of |threads_| and |work_queue_|, when work stealing
+  // is used. Must be created before |namespace_token_|.
+  std::unique_ptr<cc::WorkStealingTaskGraphRunner>
+      work_stealing_task_graph_runner_;
+
   // Lock to exclusively access all the following members that are used to
   // implement the TaskRunner and TaskGraphRunner interfaces.
   base::Lock lock_;
@@ -119,5 +119,37 @@ INSTANTIATE_TYPED_TEST_CASE_P(
     SingleThreadTaskGraphRunnerTest,
     CategorizedWorkerPoolTaskGraphRunnerTestDelegate<1>);
 
+template <int NumThreads>
+class WorkStealingCategorizedWorkerPoolTaskGraphRunnerTestDelegate {
+ public:
+  WorkStealingCategorizedWorkerPoolTaskGraphRunnerTestDelegate()
+      : categorized_worker_pool_(new content::CategorizedWorkerPool(
+            true /* use_work_stealing */)) {}
+
+  void StartTaskGraphRunner() { categorized_worker_pool_->Start(NumThreads); }
+
+  cc::TaskGraphRunner* GetTaskGraphRunner() {
+    return categorized_worker_pool_->GetTaskGraphRunner();
+  }
+
+  void StopTaskGraphRunner() { categorized_worker_pool_->FlushForTesting(); }
+
+  ~WorkStealingCategorizedWorkerPoolTaskGraphRunnerTestDelegate() {
+    categorized_worker_pool_->Shutdown();
+  }
+
+ private:
+  scoped_refptr<content::CategorizedWorkerPool> categorized_worker_pool_;
+};
+
+INSTANTIATE_TYPED_TEST_CASE_P(
+    WorkStealingCategorizedWorkerPool_1_Threads,
+    TaskGraphRunnerTest,
+    WorkStealingCategorizedWorkerPoolTaskGraphRunnerTestDelegate<1>);
+INSTANTIATE_TYPED_TEST_CASE_P(
+    WorkStealingCategorizedWorkerPool_4_Threads,
+    TaskGraphRunnerTest,
+    WorkStealingCategorizedWorkerPoolTaskGraphRunnerTestDelegate<4>);
+
 }  // namespace
 }  // namespace cc
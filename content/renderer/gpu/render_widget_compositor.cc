@@ -569,6 +569,19 @@ cc::LayerTreeSettings RenderWidgetCompositor::GenerateLayerTreeSettings(
     settings.preferred_tile_format = viz::ETC1;
   }
 
+  settings.enable_shared_decoded_image_cache =
+      cmd.HasSwitch(cc::switches::kEnableSharedDecodedImageCache);
+
+  if (is_threaded && cmd.HasSwitch(cc::switches::kEnableParallelTileRaster)) {
+    // A tile can be spread across at most every raster worker thread.
+    int num_raster_threads = 0;
+    if (base::StringToInt(cmd.GetSwitchValueASCII(switches::kNumRasterThreads),
+                          &num_raster_threads) &&
+        num_raster_threads > 1) {
+      settings.max_parallel_raster_bands_per_tile = num_raster_threads;
+    }
+  }
+
   settings.max_staging_buffer_usage_in_bytes = 32 * 1024 * 1024;  // 32MB
   // Use 1/4th of staging buffers on low-end devices.
   if (base::SysInfo::IsLowEndDevice())
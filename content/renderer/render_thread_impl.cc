@@ -459,6 +459,11 @@ class UkmRecorderFactoryImpl : public cc::UkmRecorderFactory {
   std::unique_ptr<service_manager::Connector> connector_;
 };
 
+bool UseWorkStealingRasterWorkerPool() {
+  return base::CommandLine::ForCurrentProcess()->HasSwitch(
+      cc::switches::kEnableWorkStealingRasterWorkerPool);
+}
+
 }  // namespace
 
 RenderThreadImpl::HistogramCustomizer::HistogramCustomizer() {
@@ -636,7 +641,8 @@ RenderThreadImpl::RenderThreadImpl(
               .IPCTaskRunner(scheduler ? scheduler->IPCTaskRunner() : nullptr)
               .Build()),
       renderer_scheduler_(std::move(scheduler)),
-      categorized_worker_pool_(new CategorizedWorkerPool()),
+      categorized_worker_pool_(
+          new CategorizedWorkerPool(UseWorkStealingRasterWorkerPool())),
       renderer_binding_(this),
       client_id_(1),
       compositing_mode_watcher_binding_(this) {
@@ -656,7 +662,8 @@ RenderThreadImpl::RenderThreadImpl(
               .Build()),
       renderer_scheduler_(std::move(scheduler)),
       main_message_loop_(std::move(main_message_loop)),
-      categorized_worker_pool_(new CategorizedWorkerPool()),
+      categorized_worker_pool_(
+          new CategorizedWorkerPool(UseWorkStealingRasterWorkerPool())),
       is_scroll_animator_enabled_(false),
       renderer_binding_(this),
       compositing_mode_watcher_binding_(this) {
@@ -0,0 +1,127 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ipc/batched_task_queue.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/macros.h"
+
+namespace IPC {
+
+BatchedTaskQueue::QueuedTask::QueuedTask(uint64_t batch,
+                                         base::OnceClosure task)
+    : batch(batch), task(std::move(task)) {}
+
+BatchedTaskQueue::QueuedTask::QueuedTask(QueuedTask&& other) = default;
+
+BatchedTaskQueue::QueuedTask::~QueuedTask() = default;
+
+BatchedTaskQueue::QueuedTask& BatchedTaskQueue::QueuedTask::operator=(
+    QueuedTask&& other) = default;
+
+BatchedTaskQueue::BatchedTaskQueue(
+    scoped_refptr<base::SequencedTaskRunner> task_runner)
+    : task_runner_(std::move(task_runner)) {}
+
+BatchedTaskQueue::~BatchedTaskQueue() = default;
+
+void BatchedTaskQueue::QueueTask(const base::Location& from_here,
+                                 base::OnceClosure task) {
+  uint64_t batch;
+  {
+    base::AutoLock lock(lock_);
+    if (last_batch_is_open_) {
+      tasks_.emplace_back(last_batch_, std::move(task));
+      return;
+    }
+    batch = ++last_batch_;
+    tasks_.emplace_back(batch, std::move(task));
+    last_batch_is_open_ = batching_enabled_;
+  }
+
+  // If the task never runs, e.g. because the task runner has shut down, the
+  // batch is dropped with it, as the closures would have been had they been
+  // posted directly. They may well hold references to the owner of this queue.
+  task_runner_->PostTask(
+      from_here,
+      base::BindOnce(&BatchedTaskQueue::RunBatch, this, batch,
+                     base::ScopedClosureRunner(base::BindOnce(
+                         &BatchedTaskQueue::DropBatch, this, batch))));
+}
+
+void BatchedTaskQueue::DisableBatching() {
+  base::AutoLock lock(lock_);
+  batching_enabled_ = false;
+  last_batch_is_open_ = false;
+}
+
+void BatchedTaskQueue::OnBeginNestedRunLoop() {
+  base::AutoLock lock(lock_);
+
+  // The rest of the running batch must run in the nested loop too, as it
+  // would if each closure had its own task.
+  if (continuation_posted_ || tasks_.empty() ||
+      tasks_.front().batch > running_batch_) {
+    return;
+  }
+  continuation_posted_ = true;
+  task_runner_->PostTask(
+      FROM_HERE, base::BindOnce(&BatchedTaskQueue::RunBatch, this,
+                                running_batch_, base::ScopedClosureRunner()));
+}
+
+void BatchedTaskQueue::RunBatch(uint64_t batch,
+                                base::ScopedClosureRunner drop_batch) {
+  ignore_result(drop_batch.Release());
+
+  // A closure can only run a nested loop on a thread with a RunLoop. The
+  // outermost RunBatch() observes nested loops for those nested in it.
+  bool observe_nesting = !observing_nesting_ &&
+                         base::RunLoop::IsRunningOnCurrentThread() &&
+                         base::RunLoop::IsNestingAllowedOnCurrentThread();
+  if (observe_nesting) {
+    observing_nesting_ = true;
+    base::RunLoop::AddNestingObserverOnCurrentThread(this);
+  }
+
+  {
+    base::AutoLock lock(lock_);
+    continuation_posted_ = false;
+    running_batch_ = std::max(running_batch_, batch);
+    // Closures queued from now on, including by the closures of this batch,
+    // get a new batch and task. Otherwise a steady stream of them would keep
+    // this task from returning, and starve the other tasks of the runner.
+    if (batch == last_batch_)
+      last_batch_is_open_ = false;
+    while (!tasks_.empty() && tasks_.front().batch <= batch) {
+      base::OnceClosure task = std::move(tasks_.front().task);
+      tasks_.pop_front();
+
+      base::AutoUnlock unlock(lock_);
+      std::move(task).Run();
+    }
+  }
+
+  if (observe_nesting) {
+    base::RunLoop::RemoveNestingObserverOnCurrentThread(this);
+    observing_nesting_ = false;
+  }
+}
+
+void BatchedTaskQueue::DropBatch(uint64_t batch) {
+  // The closures are destroyed without holding the lock.
+  base::circular_deque<QueuedTask> dropped;
+  base::AutoLock lock(lock_);
+  while (!tasks_.empty() && tasks_.front().batch <= batch) {
+    dropped.push_back(std::move(tasks_.front()));
+    tasks_.pop_front();
+  }
+  if (batch == last_batch_)
+    last_batch_is_open_ = false;
+}
+
+}  // namespace IPC
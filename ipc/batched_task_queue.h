@@ -0,0 +1,107 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IPC_BATCHED_TASK_QUEUE_H_
+#define IPC_BATCHED_TASK_QUEUE_H_
+
+#include <stdint.h>
+
+#include "base/callback.h"
+#include "base/callback_helpers.h"
+#include "base/containers/circular_deque.h"
+#include "base/location.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/run_loop.h"
+#include "base/sequenced_task_runner.h"
+#include "base/synchronization/lock.h"
+#include "ipc/ipc_export.h"
+
+namespace IPC {
+
+// Runs closures in the order they are queued on a task runner, with a single
+// posted task for all of the closures queued while an earlier one is waiting to
+// run, rather than one task each. Closures queued once that task has started
+// running go in the next one. ChannelProxy uses one in each direction, so
+// that a burst of messages costs one thread hop instead of one per message.
+//
+// Closures queued to a BatchedTaskQueue stay ordered with each other, but not
+// with tasks posted directly to the task runner: a closure which joins a
+// pending batch runs before the tasks posted directly since that batch's task
+// was posted, even though it was queued after them. Anything that must stay
+// ordered with the closures should therefore be queued too. Once that isn't
+// possible, DisableBatching() gives every closure queued from then on its own
+// task, as if it was posted directly.
+//
+// If a closure runs a nested loop, the closures queued after it still run in
+// the nested loop, in order.
+//
+// This class is thread-safe.
+class IPC_EXPORT BatchedTaskQueue
+    : public base::RefCountedThreadSafe<BatchedTaskQueue>,
+      public base::RunLoop::NestingObserver {
+ public:
+  explicit BatchedTaskQueue(
+      scoped_refptr<base::SequencedTaskRunner> task_runner);
+
+  // Queues |task| to run on the task runner.
+  void QueueTask(const base::Location& from_here, base::OnceClosure task);
+
+  // Makes the closures queued from now on run after all tasks posted to the
+  // task runner before they are queued.
+  void DisableBatching();
+
+ private:
+  friend class base::RefCountedThreadSafe<BatchedTaskQueue>;
+
+  struct QueuedTask {
+    QueuedTask(uint64_t batch, base::OnceClosure task);
+    QueuedTask(QueuedTask&& other);
+    ~QueuedTask();
+    QueuedTask& operator=(QueuedTask&& other);
+
+    uint64_t batch;
+    base::OnceClosure task;
+  };
+
+  ~BatchedTaskQueue() override;
+
+  // base::RunLoop::NestingObserver:
+  void OnBeginNestedRunLoop() override;
+
+  // Runs the queued closures of |batch| and of earlier batches.
+  // |drop_batch| calls DropBatch() unless it is released.
+  void RunBatch(uint64_t batch, base::ScopedClosureRunner drop_batch);
+
+  // Destroys the queued closures of |batch| and of earlier batches without
+  // running them.
+  void DropBatch(uint64_t batch);
+
+  const scoped_refptr<base::SequencedTaskRunner> task_runner_;
+
+  base::Lock lock_;
+  base::circular_deque<QueuedTask> tasks_;
+  bool batching_enabled_ = true;
+  // Each posted RunBatch() task runs one batch of closures. Batches are
+  // numbered in order, and the last one takes newly queued closures while
+  // |last_batch_is_open_|, i.e. from when its task is posted until that task
+  // starts running.
+  uint64_t last_batch_ = 0;
+  bool last_batch_is_open_ = false;
+  // The latest batch a RunBatch() task has started running.
+  uint64_t running_batch_ = 0;
+  // Whether a RunBatch() task has been posted to continue |running_batch_| in
+  // a nested loop.
+  bool continuation_posted_ = false;
+
+  // Whether this observes nested loops, while RunBatch() runs closures. Only
+  // accessed on the task runner's sequence.
+  bool observing_nesting_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(BatchedTaskQueue);
+};
+
+}  // namespace IPC
+
+#endif  // IPC_BATCHED_TASK_QUEUE_H_
@@ -0,0 +1,159 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ipc/batched_task_queue.h"
+
+#include <string>
+
+#include "base/bind.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/test/test_simple_task_runner.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace IPC {
+namespace {
+
+void Append(std::string* log, const std::string& entry) {
+  *log += entry;
+}
+
+base::OnceClosure AppendClosure(std::string* log, const std::string& entry) {
+  return base::BindOnce(&Append, log, entry);
+}
+
+TEST(BatchedTaskQueueTest, RunsQueuedTasksInOneTask) {
+  scoped_refptr<base::TestSimpleTaskRunner> task_runner(
+      new base::TestSimpleTaskRunner);
+  scoped_refptr<BatchedTaskQueue> queue(new BatchedTaskQueue(task_runner));
+
+  std::string log;
+  queue->QueueTask(FROM_HERE, AppendClosure(&log, "a"));
+  queue->QueueTask(FROM_HERE, AppendClosure(&log, "b"));
+  queue->QueueTask(FROM_HERE, AppendClosure(&log, "c"));
+  EXPECT_EQ(1u, task_runner->NumPendingTasks());
+
+  // The batch takes a single task, with nothing posted to continue it.
+  task_runner->RunPendingTasks();
+  EXPECT_EQ("abc", log);
+  EXPECT_EQ(0u, task_runner->NumPendingTasks());
+
+  // The batch is over, so the next task is posted again.
+  queue->QueueTask(FROM_HERE, AppendClosure(&log, "d"));
+  EXPECT_EQ(1u, task_runner->NumPendingTasks());
+  task_runner->RunUntilIdle();
+  EXPECT_EQ("abcd", log);
+}
+
+// Appends "a", posts "x" directly to |task_runner| and queues "b".
+void AppendPostAndQueue(base::TaskRunner* task_runner,
+                        BatchedTaskQueue* queue,
+                        std::string* log) {
+  Append(log, "a");
+  task_runner->PostTask(FROM_HERE, AppendClosure(log, "x"));
+  queue->QueueTask(FROM_HERE, AppendClosure(log, "b"));
+}
+
+TEST(BatchedTaskQueueTest, TasksQueuedByTheBatchRunInTheNextOne) {
+  scoped_refptr<base::TestSimpleTaskRunner> task_runner(
+      new base::TestSimpleTaskRunner);
+  scoped_refptr<BatchedTaskQueue> queue(new BatchedTaskQueue(task_runner));
+
+  // A running batch doesn't take more closures, so tasks posted in the
+  // meantime get to run before them.
+  std::string log;
+  queue->QueueTask(FROM_HERE,
+                   base::BindOnce(&AppendPostAndQueue,
+                                  base::RetainedRef(task_runner),
+                                  base::RetainedRef(queue), &log));
+  task_runner->RunPendingTasks();
+  EXPECT_EQ("a", log);
+  EXPECT_EQ(2u, task_runner->NumPendingTasks());
+  task_runner->RunUntilIdle();
+  EXPECT_EQ("axb", log);
+}
+
+TEST(BatchedTaskQueueTest, DisableBatching) {
+  scoped_refptr<base::TestSimpleTaskRunner> task_runner(
+      new base::TestSimpleTaskRunner);
+  scoped_refptr<BatchedTaskQueue> queue(new BatchedTaskQueue(task_runner));
+
+  // Batched tasks may overtake tasks posted directly.
+  std::string log;
+  queue->QueueTask(FROM_HERE, AppendClosure(&log, "a"));
+  task_runner->PostTask(FROM_HERE, AppendClosure(&log, "x"));
+  queue->QueueTask(FROM_HERE, AppendClosure(&log, "b"));
+  task_runner->RunUntilIdle();
+  EXPECT_EQ("abx", log);
+
+  // But not once batching is disabled, even if there is a pending batch.
+  log.clear();
+  queue->QueueTask(FROM_HERE, AppendClosure(&log, "a"));
+  queue->DisableBatching();
+  task_runner->PostTask(FROM_HERE, AppendClosure(&log, "x"));
+  queue->QueueTask(FROM_HERE, AppendClosure(&log, "b"));
+  task_runner->PostTask(FROM_HERE, AppendClosure(&log, "y"));
+  queue->QueueTask(FROM_HERE, AppendClosure(&log, "c"));
+  task_runner->RunUntilIdle();
+  EXPECT_EQ("axbyc", log);
+}
+
+TEST(BatchedTaskQueueTest, NestedLoopRunsRestOfBatch) {
+  base::MessageLoop message_loop;
+  scoped_refptr<BatchedTaskQueue> queue(
+      new BatchedTaskQueue(base::ThreadTaskRunnerHandle::Get()));
+
+  std::string log;
+  queue->QueueTask(FROM_HERE, base::BindOnce(
+                                  [](std::string* log) {
+                                    Append(log, "[");
+                                    base::RunLoop(
+                                        base::RunLoop::Type::kNestableTasksAllowed)
+                                        .RunUntilIdle();
+                                    Append(log, "]");
+                                  },
+                                  &log));
+  queue->QueueTask(FROM_HERE, AppendClosure(&log, "b"));
+  queue->QueueTask(FROM_HERE, AppendClosure(&log, "c"));
+
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ("[bc]", log);
+}
+
+// Appends "x" and queues "d".
+void AppendAndQueue(BatchedTaskQueue* queue, std::string* log) {
+  Append(log, "x");
+  queue->QueueTask(FROM_HERE, AppendClosure(log, "d"));
+}
+
+// Runs a nested loop, with AppendAndQueue() posted directly before it.
+void RunNestedLoop(BatchedTaskQueue* queue, std::string* log) {
+  Append(log, "[");
+  base::ThreadTaskRunnerHandle::Get()->PostTask(
+      FROM_HERE,
+      base::BindOnce(&AppendAndQueue, base::RetainedRef(queue), log));
+  base::RunLoop(base::RunLoop::Type::kNestableTasksAllowed).RunUntilIdle();
+  Append(log, "]");
+}
+
+TEST(BatchedTaskQueueTest, NestedLoopRunsTasksQueuedInIt) {
+  base::MessageLoop message_loop;
+  scoped_refptr<BatchedTaskQueue> queue(
+      new BatchedTaskQueue(base::ThreadTaskRunnerHandle::Get()));
+
+  std::string log;
+  queue->QueueTask(FROM_HERE, base::BindOnce(&RunNestedLoop,
+                                             base::RetainedRef(queue), &log));
+  queue->QueueTask(FROM_HERE, AppendClosure(&log, "b"));
+  queue->QueueTask(FROM_HERE, AppendClosure(&log, "c"));
+
+  // The closures queued while the nested loop runs are run by it, after the
+  // rest of the batch which was already queued.
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ("[xbcd]", log);
+}
+
+}  // namespace
+}  // namespace IPC
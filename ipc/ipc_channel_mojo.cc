@@ -27,6 +27,7 @@
 #include "ipc/ipc_mojo_handle_attachment.h"
 #include "ipc/native_handle_type_converters.h"
 #include "mojo/public/cpp/bindings/binding.h"
+#include "mojo/public/cpp/bindings/message_traffic_profiler.h"
 #include "mojo/public/cpp/system/platform_handle.h"
 
 namespace IPC {
@@ -221,6 +222,8 @@ bool ChannelMojo::Send(Message* message) {
   if (!message_reader_)
     return false;
 
+  RecordMessage(true, *message);
+
   // Comment copied from ipc_channel_posix.cc:
   // We can't close the pipe here, because calling OnChannelError may destroy
   // this object, and that would be bad if we are called from Send(). Instead,
@@ -254,11 +257,24 @@ void ChannelMojo::OnMessageReceived(const Message& message) {
   TRACE_EVENT2("ipc,toplevel", "ChannelMojo::OnMessageReceived",
                "class", IPC_MESSAGE_ID_CLASS(message.type()),
                "line", IPC_MESSAGE_ID_LINE(message.type()));
+  RecordMessage(false, message);
   listener_->OnMessageReceived(message);
   if (message.dispatch_error())
     listener_->OnBadMessageReceived(message);
 }
 
+// static
+void ChannelMojo::RecordMessage(bool sent, const Message& message) {
+  mojo::MessageTrafficProfiler* profiler = mojo::MessageTrafficProfiler::Get();
+  if (!profiler || !profiler->ShouldSample(
+                       mojo::MessageTrafficProfiler::SamplePath::kLegacyIpc)) {
+    return;
+  }
+  profiler->RecordLegacyIpcMessage(
+      sent, message.type(), message.size(),
+      message.HasAttachments() ? message.attachment_set()->size() : 0);
+}
+
 // static
 MojoResult ChannelMojo::ReadFromMessageAttachmentSet(
     Message* message,
@@ -102,6 +102,9 @@ class IPC_EXPORT ChannelMojo : public Channel,
       const scoped_refptr<base::SingleThreadTaskRunner>& ipc_task_runner,
       const scoped_refptr<base::SingleThreadTaskRunner>& proxy_task_runner);
 
+  // Records |message| with the mojo::MessageTrafficProfiler if it is sampled.
+  static void RecordMessage(bool sent, const Message& message);
+
   void ForwardMessageFromThreadSafePtr(mojo::Message message);
   void ForwardMessageWithResponderFromThreadSafePtr(
       mojo::Message message,
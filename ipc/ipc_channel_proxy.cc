@@ -17,6 +17,7 @@
 #include "base/single_thread_task_runner.h"
 #include "base/threading/thread_task_runner_handle.h"
 #include "build/build_config.h"
+#include "ipc/batched_task_queue.h"
 #include "ipc/ipc_channel_factory.h"
 #include "ipc/ipc_listener.h"
 #include "ipc/ipc_logging.h"
@@ -37,7 +38,9 @@ ChannelProxy::Context::Context(
       ipc_task_runner_(ipc_task_runner),
       channel_connected_called_(false),
       message_filter_router_(new MessageFilterRouter()),
-      peer_pid_(base::kNullProcessId) {
+      peer_pid_(base::kNullProcessId),
+      ipc_tasks_(new BatchedTaskQueue(ipc_task_runner)),
+      listener_tasks_(new BatchedTaskQueue(listener_task_runner)) {
   DCHECK(ipc_task_runner_.get());
   // The Listener thread where Messages are handled must be a separate thread
   // to avoid oversubscribing the IO thread. If you trigger this error, you
@@ -85,7 +88,7 @@ bool ChannelProxy::Context::TryFilters(const Message& message) {
 
   if (message_filter_router_->TryFilters(message)) {
     if (message.dispatch_error()) {
-      listener_task_runner_->PostTask(
+      listener_tasks_->QueueTask(
           FROM_HERE, base::Bind(&Context::OnDispatchBadMessage, this, message));
     }
 #if BUILDFLAG(IPC_MESSAGE_LOG_ENABLED)
@@ -125,7 +128,7 @@ bool ChannelProxy::Context::OnMessageReceived(const Message& message) {
 
 // Called on the IPC::Channel thread
 bool ChannelProxy::Context::OnMessageReceivedNoFilter(const Message& message) {
-  listener_task_runner_->PostTask(
+  listener_tasks_->QueueTask(
       FROM_HERE, base::Bind(&Context::OnDispatchMessage, this, message));
   return true;
 }
@@ -145,7 +148,7 @@ void ChannelProxy::Context::OnChannelConnected(int32_t peer_pid) {
   OnAddFilter();
 
   // See above comment about using listener_task_runner_ here.
-  listener_task_runner_->PostTask(
+  listener_tasks_->QueueTask(
       FROM_HERE, base::Bind(&Context::OnDispatchConnected, this));
 }
 
@@ -155,15 +158,16 @@ void ChannelProxy::Context::OnChannelError() {
     filters_[i]->OnChannelError();
 
   // See above comment about using listener_task_runner_ here.
-  listener_task_runner_->PostTask(
-      FROM_HERE, base::Bind(&Context::OnDispatchError, this));
+  listener_tasks_->QueueTask(FROM_HERE,
+                             base::Bind(&Context::OnDispatchError, this));
 }
 
 // Called on the IPC::Channel thread
 void ChannelProxy::Context::OnAssociatedInterfaceRequest(
     const std::string& interface_name,
     mojo::ScopedInterfaceEndpointHandle handle) {
-  listener_task_runner_->PostTask(
+  DisableMessageBatching();
+  listener_tasks_->QueueTask(
       FROM_HERE, base::Bind(&Context::OnDispatchAssociatedInterfaceRequest,
                             this, interface_name, base::Passed(&handle)));
 }
@@ -295,8 +299,7 @@ void ChannelProxy::Context::OnRemoveFilter(MessageFilter* filter) {
 void ChannelProxy::Context::AddFilter(MessageFilter* filter) {
   base::AutoLock auto_lock(pending_filters_lock_);
   pending_filters_.push_back(base::WrapRefCounted(filter));
-  ipc_task_runner_->PostTask(
-      FROM_HERE, base::Bind(&Context::OnAddFilter, this));
+  ipc_tasks_->QueueTask(FROM_HERE, base::Bind(&Context::OnAddFilter, this));
 }
 
 // Called on the listener's thread
@@ -383,11 +386,26 @@ void ChannelProxy::Context::AddGenericAssociatedInterfaceForIOThread(
 }
 
 void ChannelProxy::Context::Send(Message* message) {
-  ipc_task_runner()->PostTask(
+  ipc_tasks_->QueueTask(
       FROM_HERE, base::Bind(&ChannelProxy::Context::OnSendMessage, this,
                             base::Passed(base::WrapUnique(message))));
 }
 
+void ChannelProxy::Context::PostListenerTask(const base::Location& from_here,
+                                             base::OnceClosure task) {
+  listener_tasks_->QueueTask(from_here, std::move(task));
+}
+
+void ChannelProxy::Context::PostIPCTask(const base::Location& from_here,
+                                        base::OnceClosure task) {
+  ipc_tasks_->QueueTask(from_here, std::move(task));
+}
+
+void ChannelProxy::Context::DisableMessageBatching() {
+  ipc_tasks_->DisableBatching();
+  listener_tasks_->DisableBatching();
+}
+
 //-----------------------------------------------------------------------------
 
 // static
@@ -468,33 +486,32 @@ void ChannelProxy::Init(std::unique_ptr<ChannelFactory> factory,
     // to connect and get an error since the pipe doesn't exist yet.
     context_->CreateChannel(std::move(factory));
   } else {
-    context_->ipc_task_runner()->PostTask(
-        FROM_HERE, base::Bind(&Context::CreateChannel, context_,
-                              base::Passed(&factory)));
+    context_->PostIPCTask(FROM_HERE, base::Bind(&Context::CreateChannel,
+                                                context_,
+                                                base::Passed(&factory)));
   }
 
   // complete initialization on the background thread
-  context_->ipc_task_runner()->PostTask(
-      FROM_HERE,
-      base::Bind(&Context::OnChannelOpened, context_));
+  context_->PostIPCTask(FROM_HERE,
+                        base::Bind(&Context::OnChannelOpened, context_));
 
   did_init_ = true;
   OnChannelInit();
 }
 
 void ChannelProxy::Pause() {
-  context_->ipc_task_runner()->PostTask(
-      FROM_HERE, base::Bind(&Context::PauseChannel, context_));
+  context_->PostIPCTask(FROM_HERE,
+                        base::Bind(&Context::PauseChannel, context_));
 }
 
 void ChannelProxy::Unpause(bool flush) {
-  context_->ipc_task_runner()->PostTask(
-      FROM_HERE, base::Bind(&Context::UnpauseChannel, context_, flush));
+  context_->PostIPCTask(FROM_HERE,
+                        base::Bind(&Context::UnpauseChannel, context_, flush));
 }
 
 void ChannelProxy::Flush() {
-  context_->ipc_task_runner()->PostTask(
-      FROM_HERE, base::Bind(&Context::FlushChannel, context_));
+  context_->PostIPCTask(FROM_HERE,
+                        base::Bind(&Context::FlushChannel, context_));
 }
 
 void ChannelProxy::Close() {
@@ -506,8 +523,8 @@ void ChannelProxy::Close() {
   context_->Clear();
 
   if (context_->ipc_task_runner()) {
-    context_->ipc_task_runner()->PostTask(
-        FROM_HERE, base::Bind(&Context::OnChannelClosed, context_));
+    context_->PostIPCTask(FROM_HERE,
+                          base::Bind(&Context::OnChannelClosed, context_));
   }
 }
 
@@ -551,9 +568,9 @@ void ChannelProxy::AddFilter(MessageFilter* filter) {
 void ChannelProxy::RemoveFilter(MessageFilter* filter) {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
 
-  context_->ipc_task_runner()->PostTask(
-      FROM_HERE, base::Bind(&Context::OnRemoveFilter, context_,
-                            base::RetainedRef(filter)));
+  context_->PostIPCTask(FROM_HERE, base::Bind(&Context::OnRemoveFilter,
+                                              context_,
+                                              base::RetainedRef(filter)));
 }
 
 void ChannelProxy::AddGenericAssociatedInterfaceForIOThread(
@@ -566,6 +583,9 @@ void ChannelProxy::GetGenericRemoteAssociatedInterface(
     const std::string& name,
     mojo::ScopedInterfaceEndpointHandle handle) {
   DCHECK(did_init_);
+  // Messages of associated interfaces don't go through the batches, so they
+  // would otherwise not stay ordered with messages sent through this channel.
+  context()->DisableMessageBatching();
   context()->thread_safe_channel().GetAssociatedInterface(
       name, mojom::GenericInterfaceAssociatedRequest(std::move(handle)));
 }
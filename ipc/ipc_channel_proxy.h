@@ -27,11 +27,13 @@
 #include "mojo/public/cpp/bindings/thread_safe_interface_ptr.h"
 
 namespace base {
+class Location;
 class SingleThreadTaskRunner;
 }
 
 namespace IPC {
 
+class BatchedTaskQueue;
 class ChannelFactory;
 class MessageFilter;
 class MessageFilterRouter;
@@ -72,6 +74,18 @@ class MessageFilterRouter;
 // |channel_lifetime_lock_| is used to protect it. The locking overhead is only
 // paid if the underlying channel supports thread-safe |Send|.
 //
+// Batching
+//
+// Messages sent from one thread in quick succession, and messages received in
+// quick succession, cross threads in batches: all of those sent or received
+// while the task for an earlier one is still pending run in that same task.
+// They stay ordered with each other and with the other operations of the
+// ChannelProxy. Messages of channel-associated interfaces are posted to the
+// threads separately, so batching is turned off once any are in use, to keep
+// them ordered with the messages of this class. Most channels between browser
+// and child processes use associated interfaces, so in practice batching only
+// applies to channels which carry legacy IPC messages alone.
+//
 class IPC_EXPORT ChannelProxy : public Sender {
  public:
 #if defined(ENABLE_IPC_FUZZER)
@@ -265,6 +279,11 @@ class IPC_EXPORT ChannelProxy : public Sender {
     // Sends |message| from appropriate thread.
     void Send(Message* message);
 
+    // Posts |task| to the listener thread, in order with the messages
+    // dispatched there. Called on the IPC thread.
+    void PostListenerTask(const base::Location& from_here,
+                          base::OnceClosure task);
+
    protected:
     friend class base::RefCountedThreadSafe<Context>;
     ~Context() override;
@@ -320,6 +339,13 @@ class IPC_EXPORT ChannelProxy : public Sender {
 
     void ClearChannel();
 
+    // Posts |task| to the IPC thread, in order with the messages sent.
+    void PostIPCTask(const base::Location& from_here, base::OnceClosure task);
+
+    // Makes messages cross threads in a task each, as associated interface
+    // messages do.
+    void DisableMessageBatching();
+
     mojom::Channel& thread_safe_channel() {
       return thread_safe_channel_->proxy();
     }
@@ -372,6 +398,11 @@ class IPC_EXPORT ChannelProxy : public Sender {
     base::Lock pending_io_thread_interfaces_lock_;
     std::vector<std::pair<std::string, GenericAssociatedInterfaceFactory>>
         pending_io_thread_interfaces_;
+
+    // Run tasks on the IPC and listener threads respectively, in batches. See
+    // the class comment.
+    scoped_refptr<BatchedTaskQueue> ipc_tasks_;
+    scoped_refptr<BatchedTaskQueue> listener_tasks_;
   };
 
   Context* context() { return context_.get(); }
@@ -3,6 +3,8 @@
 // found in the LICENSE file.
 
 #include <stddef.h>
+
+#include <algorithm>
 #include <memory>
 
 #include "base/memory/ptr_util.h"
@@ -40,7 +42,9 @@ class PerformanceChannelListener : public Listener {
         msg_count_(0),
         msg_size_(0),
         sync_(false),
-        count_down_(0) {
+        burst_size_(1),
+        count_down_(0),
+        burst_count_down_(0) {
     VLOG(1) << "Server listener up";
   }
 
@@ -51,12 +55,18 @@ class PerformanceChannelListener : public Listener {
     sender_ = sender;
   }
 
-  // Call this before running the message loop.
-  void SetTestParams(int msg_count, size_t msg_size, bool sync) {
+  // Call this before running the message loop. Asynchronous pings are sent in
+  // bursts of |burst_size|, each of which is sent once all of the pongs of the
+  // previous one have been received.
+  void SetTestParams(int msg_count,
+                     size_t msg_size,
+                     bool sync,
+                     int burst_size = 1) {
     DCHECK_EQ(0, count_down_);
     msg_count_ = msg_count;
     msg_size_ = msg_size;
     sync_ = sync;
+    burst_size_ = burst_size;
     count_down_ = msg_count_;
     payload_ = std::string(msg_size_, 'a');
   }
@@ -79,6 +89,8 @@ class PerformanceChannelListener : public Listener {
     std::string test_name =
         base::StringPrintf("IPC_%s_Perf_%dx_%u", label_.c_str(), msg_count_,
                            static_cast<unsigned>(msg_size_));
+    if (burst_size_ > 1)
+      test_name += base::StringPrintf("_Burst%d", burst_size_);
     perf_logger_.reset(new base::PerfTimeLogger(test_name.c_str()));
     if (sync_) {
       for (; count_down_ > 0; --count_down_) {
@@ -89,7 +101,7 @@ class PerformanceChannelListener : public Listener {
       perf_logger_.reset();
       base::RunLoop::QuitCurrentWhenIdleDeprecated();
     } else {
-      SendPong();
+      SendPongs();
     }
   }
 
@@ -105,10 +117,15 @@ class PerformanceChannelListener : public Listener {
       return;
     }
 
-    SendPong();
+    if (--burst_count_down_ == 0)
+      SendPongs();
   }
 
-  void SendPong() { sender_->Send(new TestMsg_Ping(payload_)); }
+  void SendPongs() {
+    burst_count_down_ = std::min(burst_size_, count_down_);
+    for (int i = 0; i < burst_count_down_; ++i)
+      sender_->Send(new TestMsg_Ping(payload_));
+  }
 
  private:
   std::string label_;
@@ -116,8 +133,10 @@ class PerformanceChannelListener : public Listener {
   int msg_count_;
   size_t msg_size_;
   bool sync_;
+  int burst_size_;
 
   int count_down_;
+  int burst_count_down_;
   std::string payload_;
   std::unique_ptr<base::PerfTimeLogger> perf_logger_;
 };
@@ -182,7 +201,7 @@ class MojoChannelPerfTest : public IPCChannelMojoTestBase {
   MojoChannelPerfTest() = default;
   ~MojoChannelPerfTest() override = default;
 
-  void RunTestChannelProxyPingPong() {
+  void RunTestChannelProxyPingPong(int burst_size) {
     Init("MojoPerfTestClient");
 
     // Set up IPC channel and start client.
@@ -196,7 +215,7 @@ class MojoChannelPerfTest : public IPCChannelMojoTestBase {
     std::vector<PingPongTestParams> params = GetDefaultTestParams();
     for (size_t i = 0; i < params.size(); i++) {
       listener.SetTestParams(params[i].message_count(),
-                             params[i].message_size(), false);
+                             params[i].message_size(), false, burst_size);
 
       // This initial message will kick-start the ping-pong of messages.
       channel_proxy->Send(new TestMsg_Hello);
@@ -248,7 +267,16 @@ class MojoChannelPerfTest : public IPCChannelMojoTestBase {
 };
 
 TEST_F(MojoChannelPerfTest, ChannelProxyPingPong) {
-  RunTestChannelProxyPingPong();
+  RunTestChannelProxyPingPong(1);
+
+  base::RunLoop run_loop;
+  run_loop.RunUntilIdle();
+}
+
+// Sends pings in bursts, which cross threads in batches on both ends of the
+// channel.
+TEST_F(MojoChannelPerfTest, ChannelProxyBurstPingPong) {
+  RunTestChannelProxyPingPong(100);
 
   base::RunLoop run_loop;
   run_loop.RunUntilIdle();
@@ -165,8 +165,10 @@ class SyncChannel::ReceivedSyncMsgQueue :
     }
 
     dispatch_event_.Signal();
+    // The task goes through the context's queue of listener tasks, so that
+    // the messages it dispatches stay ordered with the ones received before.
     if (!was_task_pending) {
-      listener_task_runner_->PostTask(
+      context->PostListenerTask(
           FROM_HERE, base::Bind(&ReceivedSyncMsgQueue::DispatchMessagesTask,
                                 this, base::RetainedRef(context)));
     }
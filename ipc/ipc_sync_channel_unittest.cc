@@ -593,6 +593,84 @@ TEST_F(IPCSyncChannelTest, Unblock) {
 
 //------------------------------------------------------------------------------
 
+const int kUnblockOrderPingCount = 30;
+
+class UnblockOrderServer : public Worker {
+ public:
+  UnblockOrderServer(WaitableEvent* sent_event,
+                     mojo::ScopedMessagePipeHandle channel_handle)
+      : Worker(Channel::MODE_SERVER,
+               "unblock_order_server",
+               std::move(channel_handle)),
+        sent_event_(sent_event) {}
+
+  void Run() override {
+    // Every third ping unblocks, so the client gets unblocking messages in
+    // between the messages it dispatches in batches.
+    for (int i = 0; i < kUnblockOrderPingCount; ++i) {
+      Message* msg = new SyncChannelTestMsg_Ping(i);
+      msg->set_unblock(i % 3 == 1);
+      Send(msg);
+    }
+    ipc_thread().task_runner()->PostTask(
+        FROM_HERE,
+        base::Bind(&WaitableEvent::Signal, base::Unretained(sent_event_)));
+    Done();
+  }
+
+ private:
+  WaitableEvent* sent_event_;
+};
+
+class UnblockOrderClient : public Worker {
+ public:
+  UnblockOrderClient(WaitableEvent* sent_event,
+                     mojo::ScopedMessagePipeHandle channel_handle)
+      : Worker(Channel::MODE_CLIENT,
+               "unblock_order_client",
+               std::move(channel_handle)),
+        sent_event_(sent_event) {}
+
+ private:
+  bool OnMessageReceived(const Message& message) override {
+    IPC_BEGIN_MESSAGE_MAP(UnblockOrderClient, message)
+     IPC_MESSAGE_HANDLER(SyncChannelTestMsg_Ping, OnPing)
+    IPC_END_MESSAGE_MAP()
+    return true;
+  }
+
+  void OnPing(int ping) {
+    EXPECT_EQ(next_ping_, ping);
+    next_ping_ = ping + 1;
+
+    // Holds up the listener thread until all the pings have been sent, so
+    // that the rest of them are queued up behind this one.
+    if (ping == 0)
+      sent_event_->Wait();
+    if (next_ping_ == kUnblockOrderPingCount)
+      Done();
+  }
+
+  WaitableEvent* sent_event_;
+  int next_ping_ = 0;
+};
+
+// Tests that messages which unblock the listener are dispatched in order with
+// the other messages, when it isn't blocked.
+TEST_F(IPCSyncChannelTest, UnblockingMessagesStayInOrder) {
+  WaitableEvent sent_event(base::WaitableEvent::ResetPolicy::MANUAL,
+                           base::WaitableEvent::InitialState::NOT_SIGNALED);
+  std::vector<Worker*> workers;
+  mojo::MessagePipe pipe;
+  workers.push_back(
+      new UnblockOrderServer(&sent_event, std::move(pipe.handle0)));
+  workers.push_back(
+      new UnblockOrderClient(&sent_event, std::move(pipe.handle1)));
+  RunTest(workers);
+}
+
+//------------------------------------------------------------------------------
+
 #if defined(OS_ANDROID)
 #define MAYBE_ChannelDeleteDuringSend DISABLED_ChannelDeleteDuringSend
 #else
@@ -0,0 +1,113 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/common/big_buffer.h"
+
+#include <string.h>
+
+#include <utility>
+
+#include "base/logging.h"
+
+namespace mojo {
+namespace common {
+
+namespace internal {
+
+BigBufferSharedMemoryRegion::BigBufferSharedMemoryRegion() = default;
+
+BigBufferSharedMemoryRegion::BigBufferSharedMemoryRegion(
+    ScopedSharedBufferHandle buffer_handle,
+    size_t size)
+    : size_(size),
+      buffer_handle_(std::move(buffer_handle)),
+      mapping_(buffer_handle_.is_valid() && size ? buffer_handle_->Map(size)
+                                                 : nullptr) {}
+
+BigBufferSharedMemoryRegion::BigBufferSharedMemoryRegion(
+    BigBufferSharedMemoryRegion&& other) = default;
+
+BigBufferSharedMemoryRegion::~BigBufferSharedMemoryRegion() = default;
+
+BigBufferSharedMemoryRegion& BigBufferSharedMemoryRegion::operator=(
+    BigBufferSharedMemoryRegion&& other) = default;
+
+ScopedSharedBufferHandle BigBufferSharedMemoryRegion::TakeBufferHandle() {
+  DCHECK(buffer_handle_.is_valid());
+  return std::move(buffer_handle_);
+}
+
+}  // namespace internal
+
+// static
+const size_t BigBuffer::kMaxInlineBytes = 64 * 1024;
+
+BigBuffer::BigBuffer() = default;
+
+BigBuffer::BigBuffer(BigBuffer&& other) = default;
+
+BigBuffer::BigBuffer(base::span<const uint8_t> data) {
+  if (data.size() > kMaxInlineBytes) {
+    ScopedSharedBufferHandle buffer_handle =
+        SharedBufferHandle::Create(data.size());
+    ScopedSharedBufferMapping mapping;
+    ScopedSharedBufferHandle read_only_handle;
+    if (buffer_handle.is_valid()) {
+      mapping = buffer_handle->Map(data.size());
+      read_only_handle =
+          buffer_handle->Clone(SharedBufferHandle::AccessMode::READ_ONLY);
+    }
+    if (mapping && read_only_handle.is_valid()) {
+      memcpy(mapping.get(), data.data(), data.size());
+      storage_type_ = StorageType::kSharedMemory;
+      shared_memory_.size_ = data.size();
+      shared_memory_.buffer_handle_ = std::move(read_only_handle);
+      shared_memory_.mapping_ = std::move(mapping);
+      return;
+    }
+    // Sandboxed processes may fail to allocate shared memory, in which case
+    // the bytes are sent inline.
+  }
+  bytes_.assign(data.begin(), data.end());
+}
+
+BigBuffer::BigBuffer(internal::BigBufferSharedMemoryRegion shared_memory)
+    : storage_type_(StorageType::kSharedMemory),
+      shared_memory_(std::move(shared_memory)) {}
+
+BigBuffer::~BigBuffer() = default;
+
+// static
+BigBuffer BigBuffer::FromInlineBytes(std::vector<uint8_t> bytes) {
+  BigBuffer buffer;
+  buffer.bytes_ = std::move(bytes);
+  return buffer;
+}
+
+BigBuffer& BigBuffer::operator=(BigBuffer&& other) = default;
+
+const uint8_t* BigBuffer::data() const {
+  if (storage_type_ == StorageType::kBytes)
+    return bytes_.data();
+  return static_cast<const uint8_t*>(shared_memory_.memory());
+}
+
+size_t BigBuffer::size() const {
+  if (storage_type_ == StorageType::kBytes)
+    return bytes_.size();
+  return shared_memory_.size();
+}
+
+const std::vector<uint8_t>& BigBuffer::bytes() const {
+  DCHECK_EQ(StorageType::kBytes, storage_type_);
+  return bytes_;
+}
+
+internal::BigBufferSharedMemoryRegion& BigBuffer::shared_memory() {
+  DCHECK_EQ(StorageType::kSharedMemory, storage_type_);
+  return shared_memory_;
+}
+
+}  // namespace common
+}  // namespace mojo
@@ -0,0 +1,109 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_COMMON_BIG_BUFFER_H_
+#define MOJO_COMMON_BIG_BUFFER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/containers/span.h"
+#include "base/macros.h"
+#include "mojo/common/mojo_common_export.h"
+#include "mojo/public/cpp/system/buffer.h"
+
+namespace mojo {
+namespace common {
+
+class BigBuffer;
+
+namespace internal {
+
+// The shared memory which holds the contents of a large BigBuffer.
+class MOJO_COMMON_EXPORT BigBufferSharedMemoryRegion {
+ public:
+  BigBufferSharedMemoryRegion();
+  // Maps the first |size| bytes of |buffer_handle|. memory() is null if that
+  // fails.
+  BigBufferSharedMemoryRegion(ScopedSharedBufferHandle buffer_handle,
+                              size_t size);
+  BigBufferSharedMemoryRegion(BigBufferSharedMemoryRegion&& other);
+  ~BigBufferSharedMemoryRegion();
+
+  BigBufferSharedMemoryRegion& operator=(BigBufferSharedMemoryRegion&& other);
+
+  void* memory() const { return mapping_.get(); }
+  size_t size() const { return size_; }
+
+  // Takes the handle to send to the receiver. The mapping stays valid.
+  ScopedSharedBufferHandle TakeBufferHandle();
+
+ private:
+  friend class mojo::common::BigBuffer;
+
+  size_t size_ = 0;
+  ScopedSharedBufferHandle buffer_handle_;
+  ScopedSharedBufferMapping mapping_;
+
+  DISALLOW_COPY_AND_ASSIGN(BigBufferSharedMemoryRegion);
+};
+
+}  // namespace internal
+
+// A buffer of bytes which is sent as a mojo.common.mojom.BigBuffer. Buffers
+// larger than |kMaxInlineBytes| are kept in shared memory, so that sending them
+// costs a handle rather than copies of the bytes into the message, through the
+// channel and out of the message again. The receiver reads the bytes where the
+// sender wrote them.
+//
+// The receiver maps the shared memory read-only, but the sender can still
+// write to it. Receivers which don't trust the sender must copy the bytes out
+// before validating them.
+class MOJO_COMMON_EXPORT BigBuffer {
+ public:
+  // Buffers larger than this are kept in shared memory.
+  static const size_t kMaxInlineBytes;
+
+  enum class StorageType {
+    kBytes,
+    kSharedMemory,
+  };
+
+  BigBuffer();
+  BigBuffer(BigBuffer&& other);
+  // Copies |data|, into shared memory if it is larger than |kMaxInlineBytes|
+  // and shared memory can be allocated.
+  explicit BigBuffer(base::span<const uint8_t> data);
+  explicit BigBuffer(internal::BigBufferSharedMemoryRegion shared_memory);
+  ~BigBuffer();
+
+  // Keeps |bytes| inline whatever their size. Buffers which arrived inline are
+  // deserialized this way, rather than copied again into shared memory.
+  static BigBuffer FromInlineBytes(std::vector<uint8_t> bytes);
+
+  BigBuffer& operator=(BigBuffer&& other);
+
+  const uint8_t* data() const;
+  size_t size() const;
+
+  StorageType storage_type() const { return storage_type_; }
+
+  // Only valid for the corresponding storage type.
+  const std::vector<uint8_t>& bytes() const;
+  internal::BigBufferSharedMemoryRegion& shared_memory();
+
+ private:
+  StorageType storage_type_ = StorageType::kBytes;
+  std::vector<uint8_t> bytes_;
+  internal::BigBufferSharedMemoryRegion shared_memory_;
+
+  DISALLOW_COPY_AND_ASSIGN(BigBuffer);
+};
+
+}  // namespace common
+}  // namespace mojo
+
+#endif  // MOJO_COMMON_BIG_BUFFER_H_
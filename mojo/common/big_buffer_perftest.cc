@@ -0,0 +1,126 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/containers/span.h"
+#include "base/macros.h"
+#include "base/message_loop/message_loop.h"
+#include "base/strings/stringprintf.h"
+#include "mojo/common/big_buffer.h"
+#include "mojo/common/test_common_custom_types.mojom.h"
+#include "mojo/public/c/system/functions.h"
+#include "mojo/public/cpp/bindings/binding.h"
+#include "mojo/public/cpp/test_support/test_support.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace common {
+namespace test {
+namespace {
+
+const double kMojoTicksPerSecond = 1000000.0;
+
+// Reads every byte, as a receiver which parses the payload would.
+uint8_t Checksum(const uint8_t* data, size_t size) {
+  uint8_t checksum = 0;
+  for (size_t i = 0; i < size; ++i)
+    checksum ^= data[i];
+  return checksum;
+}
+
+class TestBigBufferImpl : public TestBigBuffer {
+ public:
+  explicit TestBigBufferImpl(TestBigBufferRequest request)
+      : binding_(this, std::move(request)) {}
+
+  // TestBigBuffer implementation:
+  void BounceBigBuffer(BigBuffer in, BounceBigBufferCallback callback) override {
+    std::move(callback).Run(std::move(in));
+  }
+
+  void ConsumeBytes(const std::vector<uint8_t>& bytes,
+                    ConsumeBytesCallback callback) override {
+    std::move(callback).Run(Checksum(bytes.data(), bytes.size()));
+  }
+
+  void ConsumeBigBuffer(BigBuffer buffer,
+                        ConsumeBigBufferCallback callback) override {
+    std::move(callback).Run(Checksum(buffer.data(), buffer.size()));
+  }
+
+ private:
+  mojo::Binding<TestBigBuffer> binding_;
+
+  DISALLOW_COPY_AND_ASSIGN(TestBigBufferImpl);
+};
+
+class BigBufferPerfTest : public testing::Test {
+ public:
+  BigBufferPerfTest() : impl_(MakeRequest(&ptr_)) {}
+
+ protected:
+  // Sends |payload| |iterations| times, both as array<uint8> and as a
+  // BigBuffer, and logs the throughput of each.
+  void Run(const std::vector<uint8_t>& payload, int iterations) {
+    const uint8_t expected = Checksum(payload.data(), payload.size());
+    const std::string sub_test =
+        base::StringPrintf("%zu_bytes", payload.size());
+    const double total_megabytes =
+        static_cast<double>(payload.size()) * iterations / (1024 * 1024);
+
+    MojoTimeTicks start_time = MojoGetTimeTicksNow();
+    for (int i = 0; i < iterations; ++i) {
+      uint8_t checksum = 0;
+      ASSERT_TRUE(ptr_->ConsumeBytes(payload, &checksum));
+      ASSERT_EQ(expected, checksum);
+    }
+    MojoTimeTicks end_time = MojoGetTimeTicksNow();
+    mojo::test::LogPerfResult(
+        "Bytes", sub_test.c_str(),
+        total_megabytes / ((end_time - start_time) / kMojoTicksPerSecond),
+        "MB/s");
+
+    // The BigBuffer is built from the payload each time, since that copy is
+    // part of the cost of sending it.
+    start_time = MojoGetTimeTicksNow();
+    for (int i = 0; i < iterations; ++i) {
+      uint8_t checksum = 0;
+      ASSERT_TRUE(ptr_->ConsumeBigBuffer(BigBuffer(payload), &checksum));
+      ASSERT_EQ(expected, checksum);
+    }
+    end_time = MojoGetTimeTicksNow();
+    mojo::test::LogPerfResult(
+        "BigBuffer", sub_test.c_str(),
+        total_megabytes / ((end_time - start_time) / kMojoTicksPerSecond),
+        "MB/s");
+  }
+
+ private:
+  base::MessageLoop message_loop_;
+  TestBigBufferPtr ptr_;
+  TestBigBufferImpl impl_;
+
+  DISALLOW_COPY_AND_ASSIGN(BigBufferPerfTest);
+};
+
+TEST_F(BigBufferPerfTest, Throughput) {
+  const size_t kTotalBytes = 256 * 1024 * 1024;
+  for (size_t size = 4 * 1024; size <= 16 * 1024 * 1024; size *= 4) {
+    std::vector<uint8_t> payload(size);
+    for (size_t i = 0; i < size; ++i)
+      payload[i] = static_cast<uint8_t>(i);
+    Run(payload, static_cast<int>(kTotalBytes / size));
+  }
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace common
+}  // namespace mojo
@@ -0,0 +1,92 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/common/big_buffer_struct_traits.h"
+
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "base/logging.h"
+
+namespace mojo {
+
+// static
+ScopedSharedBufferHandle
+StructTraits<common::mojom::BigBufferSharedMemoryRegionDataView,
+             common::internal::BigBufferSharedMemoryRegion>::
+    buffer_handle(common::internal::BigBufferSharedMemoryRegion& region) {
+  return region.TakeBufferHandle();
+}
+
+// static
+uint32_t StructTraits<common::mojom::BigBufferSharedMemoryRegionDataView,
+                      common::internal::BigBufferSharedMemoryRegion>::
+    size(const common::internal::BigBufferSharedMemoryRegion& region) {
+  CHECK_LE(region.size(), std::numeric_limits<uint32_t>::max());
+  return static_cast<uint32_t>(region.size());
+}
+
+// static
+bool StructTraits<common::mojom::BigBufferSharedMemoryRegionDataView,
+                  common::internal::BigBufferSharedMemoryRegion>::
+    Read(common::mojom::BigBufferSharedMemoryRegionDataView data,
+         common::internal::BigBufferSharedMemoryRegion* out) {
+  *out = common::internal::BigBufferSharedMemoryRegion(data.TakeBufferHandle(),
+                                                        data.size());
+  return out->memory() != nullptr;
+}
+
+// static
+common::mojom::BigBufferDataView::Tag
+UnionTraits<common::mojom::BigBufferDataView, common::BigBuffer>::GetTag(
+    const common::BigBuffer& buffer) {
+  switch (buffer.storage_type()) {
+    case common::BigBuffer::StorageType::kBytes:
+      return common::mojom::BigBufferDataView::Tag::BYTES;
+    case common::BigBuffer::StorageType::kSharedMemory:
+      return common::mojom::BigBufferDataView::Tag::SHARED_MEMORY;
+  }
+  NOTREACHED();
+  return common::mojom::BigBufferDataView::Tag::BYTES;
+}
+
+// static
+base::span<const uint8_t>
+UnionTraits<common::mojom::BigBufferDataView, common::BigBuffer>::bytes(
+    const common::BigBuffer& buffer) {
+  return buffer.bytes();
+}
+
+// static
+common::internal::BigBufferSharedMemoryRegion&
+UnionTraits<common::mojom::BigBufferDataView, common::BigBuffer>::shared_memory(
+    common::BigBuffer& buffer) {
+  return buffer.shared_memory();
+}
+
+// static
+bool UnionTraits<common::mojom::BigBufferDataView, common::BigBuffer>::Read(
+    common::mojom::BigBufferDataView data,
+    common::BigBuffer* out) {
+  switch (data.tag()) {
+    case common::mojom::BigBufferDataView::Tag::BYTES: {
+      std::vector<uint8_t> bytes;
+      if (!data.ReadBytes(&bytes))
+        return false;
+      *out = common::BigBuffer::FromInlineBytes(std::move(bytes));
+      return true;
+    }
+    case common::mojom::BigBufferDataView::Tag::SHARED_MEMORY: {
+      common::internal::BigBufferSharedMemoryRegion shared_memory;
+      if (!data.ReadSharedMemory(&shared_memory))
+        return false;
+      *out = common::BigBuffer(std::move(shared_memory));
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace mojo
@@ -0,0 +1,47 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_COMMON_BIG_BUFFER_STRUCT_TRAITS_H_
+#define MOJO_COMMON_BIG_BUFFER_STRUCT_TRAITS_H_
+
+#include <stdint.h>
+
+#include "base/containers/span.h"
+#include "mojo/common/big_buffer.h"
+#include "mojo/common/big_buffer.mojom-shared.h"
+#include "mojo/public/cpp/bindings/array_traits_span.h"
+#include "mojo/public/cpp/bindings/struct_traits.h"
+#include "mojo/public/cpp/bindings/union_traits.h"
+#include "mojo/public/cpp/system/buffer.h"
+
+namespace mojo {
+
+template <>
+struct StructTraits<common::mojom::BigBufferSharedMemoryRegionDataView,
+                    common::internal::BigBufferSharedMemoryRegion> {
+  static ScopedSharedBufferHandle buffer_handle(
+      common::internal::BigBufferSharedMemoryRegion& region);
+  static uint32_t size(
+      const common::internal::BigBufferSharedMemoryRegion& region);
+
+  static bool Read(common::mojom::BigBufferSharedMemoryRegionDataView data,
+                   common::internal::BigBufferSharedMemoryRegion* out);
+};
+
+template <>
+struct UnionTraits<common::mojom::BigBufferDataView, common::BigBuffer> {
+  static common::mojom::BigBufferDataView::Tag GetTag(
+      const common::BigBuffer& buffer);
+
+  static base::span<const uint8_t> bytes(const common::BigBuffer& buffer);
+  static common::internal::BigBufferSharedMemoryRegion& shared_memory(
+      common::BigBuffer& buffer);
+
+  static bool Read(common::mojom::BigBufferDataView data,
+                   common::BigBuffer* out);
+};
+
+}  // namespace mojo
+
+#endif  // MOJO_COMMON_BIG_BUFFER_STRUCT_TRAITS_H_
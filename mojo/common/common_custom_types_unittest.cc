@@ -2,6 +2,7 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include "base/containers/span.h"
 #include "base/files/file_path.h"
 #include "base/files/scoped_temp_dir.h"
 #include "base/memory/ptr_util.h"
@@ -11,6 +12,7 @@
 #include "base/run_loop.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/values.h"
+#include "mojo/common/big_buffer.h"
 #include "mojo/common/common_custom_types_struct_traits.h"
 #include "mojo/common/process_id.mojom.h"
 #include "mojo/common/test_common_custom_types.mojom.h"
@@ -187,6 +189,37 @@ class TestTextDirectionImpl : public TestTextDirection {
   mojo::Binding<TestTextDirection> binding_;
 };
 
+class TestBigBufferImpl : public TestBigBuffer {
+ public:
+  explicit TestBigBufferImpl(TestBigBufferRequest request)
+      : binding_(this, std::move(request)) {}
+
+  // TestBigBuffer implementation:
+  void BounceBigBuffer(BigBuffer in, BounceBigBufferCallback callback) override {
+    std::move(callback).Run(std::move(in));
+  }
+
+  void ConsumeBytes(const std::vector<uint8_t>& bytes,
+                    ConsumeBytesCallback callback) override {
+    std::move(callback).Run(0);
+  }
+
+  void ConsumeBigBuffer(BigBuffer buffer,
+                        ConsumeBigBufferCallback callback) override {
+    std::move(callback).Run(0);
+  }
+
+ private:
+  mojo::Binding<TestBigBuffer> binding_;
+};
+
+std::vector<uint8_t> CreateTestBytes(size_t size) {
+  std::vector<uint8_t> bytes(size);
+  for (size_t i = 0; i < size; ++i)
+    bytes[i] = static_cast<uint8_t>(i * 7);
+  return bytes;
+}
+
 class CommonCustomTypesTest : public testing::Test {
  protected:
   CommonCustomTypesTest() {}
@@ -437,6 +470,70 @@ TEST_F(CommonCustomTypesTest, TextDirection) {
   }
 }
 
+TEST_F(CommonCustomTypesTest, SmallBigBuffer) {
+  TestBigBufferPtr ptr;
+  TestBigBufferImpl impl(MakeRequest(&ptr));
+
+  std::vector<uint8_t> bytes = CreateTestBytes(1024);
+  BigBuffer in(bytes);
+  EXPECT_EQ(BigBuffer::StorageType::kBytes, in.storage_type());
+
+  BigBuffer out;
+  ASSERT_TRUE(ptr->BounceBigBuffer(std::move(in), &out));
+  EXPECT_EQ(BigBuffer::StorageType::kBytes, out.storage_type());
+  EXPECT_EQ(bytes, std::vector<uint8_t>(out.data(), out.data() + out.size()));
+}
+
+TEST_F(CommonCustomTypesTest, EmptyBigBuffer) {
+  TestBigBufferPtr ptr;
+  TestBigBufferImpl impl(MakeRequest(&ptr));
+
+  BigBuffer out(CreateTestBytes(16));
+  ASSERT_TRUE(ptr->BounceBigBuffer(BigBuffer(), &out));
+  EXPECT_EQ(BigBuffer::StorageType::kBytes, out.storage_type());
+  EXPECT_EQ(0u, out.size());
+}
+
+TEST_F(CommonCustomTypesTest, LargeBigBuffer) {
+  TestBigBufferPtr ptr;
+  TestBigBufferImpl impl(MakeRequest(&ptr));
+
+  std::vector<uint8_t> bytes = CreateTestBytes(BigBuffer::kMaxInlineBytes * 4);
+  BigBuffer in(bytes);
+  EXPECT_EQ(BigBuffer::StorageType::kSharedMemory, in.storage_type());
+  EXPECT_EQ(bytes.size(), in.size());
+
+  // The bytes arrive in shared memory, rather than in the message.
+  BigBuffer out;
+  ASSERT_TRUE(ptr->BounceBigBuffer(std::move(in), &out));
+  EXPECT_EQ(BigBuffer::StorageType::kSharedMemory, out.storage_type());
+  EXPECT_EQ(bytes, std::vector<uint8_t>(out.data(), out.data() + out.size()));
+}
+
+TEST_F(CommonCustomTypesTest, BigBufferAtInlineLimit) {
+  TestBigBufferPtr ptr;
+  TestBigBufferImpl impl(MakeRequest(&ptr));
+
+  std::vector<uint8_t> bytes = CreateTestBytes(BigBuffer::kMaxInlineBytes);
+  BigBuffer out;
+  ASSERT_TRUE(ptr->BounceBigBuffer(BigBuffer(bytes), &out));
+  EXPECT_EQ(BigBuffer::StorageType::kBytes, out.storage_type());
+  EXPECT_EQ(bytes, std::vector<uint8_t>(out.data(), out.data() + out.size()));
+}
+
+TEST_F(CommonCustomTypesTest, LargeInlineBigBuffer) {
+  TestBigBufferPtr ptr;
+  TestBigBufferImpl impl(MakeRequest(&ptr));
+
+  // A large buffer sent inline, e.g. because the sender couldn't allocate
+  // shared memory, is received inline too.
+  std::vector<uint8_t> bytes = CreateTestBytes(BigBuffer::kMaxInlineBytes * 2);
+  BigBuffer out;
+  ASSERT_TRUE(ptr->BounceBigBuffer(BigBuffer::FromInlineBytes(bytes), &out));
+  EXPECT_EQ(BigBuffer::StorageType::kBytes, out.storage_type());
+  EXPECT_EQ(bytes, std::vector<uint8_t>(out.data(), out.data() + out.size()));
+}
+
 }  // namespace test
 }  // namespace common
 }  // namespace mojo
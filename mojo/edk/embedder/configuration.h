@@ -39,6 +39,20 @@ struct Configuration {
 
   // Maximum size of a single shared memory segment, in bytes.
   size_t max_shared_memory_num_bytes = 1024 * 1024 * 1024;
+
+  // Capacity of the shared memory ring which channels to other processes use
+  // for small messages without handles, in bytes, or 0 to only use the
+  // channels' sockets. Must be a power of two, no smaller than 4096. Only
+  // supported on Linux and Android, and only for peers which are built with
+  // support for the ring, since older peers reject its control messages.
+  size_t channel_shared_ring_num_bytes = 0;
+
+  // If non-zero, data pipes with a larger capacity start out using only this
+  // many bytes of their shared buffer as their ring, and the producer doubles
+  // the ring, up to the pipe's capacity, whenever it has more data to write
+  // than fits. Pipes which never carry much data then only touch a small part
+  // of their shared buffer.
+  size_t data_pipe_initial_ring_num_bytes = 0;
 };
 
 }  // namespace edk
@@ -50,6 +50,55 @@ static_assert(offsetof(Channel::Message::LegacyHeader, message_type) ==
               "message_type should be at the same offset in both Header "
               "structs.");
 
+// The parts of a received message.
+struct ParsedMessage {
+  Channel::Message::MessageType message_type;
+  uint16_t num_handles;
+  const void* extra_header;
+  size_t extra_header_size;
+  void* payload;
+  size_t payload_size;
+};
+
+// Finds the parts of the message at |legacy_header|, whose |num_bytes| have
+// already been validated and received. Returns false if the rest of its
+// headers are invalid.
+bool ParseMessage(const Channel::Message::LegacyHeader* legacy_header,
+                  ParsedMessage* message) {
+  char* data =
+      reinterpret_cast<char*>(const_cast<Channel::Message::LegacyHeader*>(
+          legacy_header));
+  message->message_type = legacy_header->message_type;
+  if (legacy_header->message_type ==
+      Channel::Message::MessageType::NORMAL_LEGACY) {
+    message->num_handles = legacy_header->num_handles;
+    message->extra_header = nullptr;
+    message->extra_header_size = 0;
+    message->payload_size =
+        legacy_header->num_bytes - sizeof(Channel::Message::LegacyHeader);
+    message->payload = message->payload_size
+                           ? data + sizeof(Channel::Message::LegacyHeader)
+                           : nullptr;
+    return true;
+  }
+
+  const Channel::Message::Header* header =
+      reinterpret_cast<const Channel::Message::Header*>(legacy_header);
+  if (header->num_header_bytes < sizeof(Channel::Message::Header) ||
+      header->num_header_bytes > header->num_bytes) {
+    LOG(ERROR) << "Invalid message header size: " << header->num_header_bytes;
+    return false;
+  }
+  message->num_handles = header->num_handles;
+  message->extra_header_size =
+      header->num_header_bytes - sizeof(Channel::Message::Header);
+  message->extra_header = message->extra_header_size ? header + 1 : nullptr;
+  message->payload_size = header->num_bytes - header->num_header_bytes;
+  message->payload =
+      message->payload_size ? data + header->num_header_bytes : nullptr;
+  return true;
+}
+
 }  // namespace
 
 const size_t kReadBufferSize = 4096;
@@ -667,43 +716,14 @@ bool Channel::OnReadComplete(size_t bytes_read, size_t *next_read_size_hint) {
       return true;
     }
 
-    const Message::Header* header = nullptr;
-    if (legacy_header->message_type != Message::MessageType::NORMAL_LEGACY) {
-      header = reinterpret_cast<const Message::Header*>(legacy_header);
-    }
-
-    size_t extra_header_size = 0;
-    const void* extra_header = nullptr;
-    size_t payload_size = 0;
-    void* payload = nullptr;
-    if (header) {
-      if (header->num_header_bytes < sizeof(Message::Header) ||
-          header->num_header_bytes > header->num_bytes) {
-        LOG(ERROR) << "Invalid message header size: "
-                   << header->num_header_bytes;
-        return false;
-      }
-      extra_header_size = header->num_header_bytes - sizeof(Message::Header);
-      extra_header = extra_header_size ? header + 1 : nullptr;
-      payload_size = header->num_bytes - header->num_header_bytes;
-      payload = payload_size
-                    ? reinterpret_cast<Message::Header*>(
-                          const_cast<char*>(read_buffer_->occupied_bytes()) +
-                          header->num_header_bytes)
-                    : nullptr;
-    } else {
-      payload_size = legacy_header->num_bytes - sizeof(Message::LegacyHeader);
-      payload = payload_size
-                    ? const_cast<Message::LegacyHeader*>(&legacy_header[1])
-                    : nullptr;
-    }
+    ParsedMessage message;
+    if (!ParseMessage(legacy_header, &message))
+      return false;
 
-    const uint16_t num_handles =
-        header ? header->num_handles : legacy_header->num_handles;
     std::vector<ScopedPlatformHandle> handles;
-    if (num_handles > 0) {
-      if (!GetReadPlatformHandles(num_handles, extra_header, extra_header_size,
-                                  &handles)) {
+    if (message.num_handles > 0) {
+      if (!GetReadPlatformHandles(message.num_handles, message.extra_header,
+                                  message.extra_header_size, &handles)) {
         return false;
       }
 
@@ -713,18 +733,15 @@ bool Channel::OnReadComplete(size_t bytes_read, size_t *next_read_size_hint) {
       }
     }
 
-    // We've got a complete message! Dispatch it and try another.
-    if (legacy_header->message_type != Message::MessageType::NORMAL_LEGACY &&
-        legacy_header->message_type != Message::MessageType::NORMAL) {
-      if (!OnControlMessage(legacy_header->message_type, payload, payload_size,
-                            std::move(handles))) {
-        return false;
-      }
-      did_dispatch_message = true;
-    } else if (delegate_) {
-      delegate_->OnChannelMessage(payload, payload_size, std::move(handles));
-      did_dispatch_message = true;
+    // We've got a complete message! Dispatch whatever the implementation
+    // received before it, then dispatch it and try another.
+    if (!DispatchPrecedingMessages())
+      return false;
+    if (!DispatchReceivedMessage(message.message_type, message.payload,
+                                 message.payload_size, std::move(handles))) {
+      return false;
     }
+    did_dispatch_message = true;
 
     read_buffer_->Discard(legacy_header->num_bytes);
   }
@@ -738,6 +755,45 @@ void Channel::OnError(Error error) {
     delegate_->OnChannelError(error);
 }
 
+bool Channel::DispatchMessageWithoutHandles(const void* data,
+                                            size_t num_bytes) {
+  DCHECK(IsAlignedForChannelMessage(reinterpret_cast<uintptr_t>(data)));
+  if (num_bytes < sizeof(Message::LegacyHeader))
+    return false;
+  const Message::LegacyHeader* legacy_header =
+      static_cast<const Message::LegacyHeader*>(data);
+  if (legacy_header->num_bytes != num_bytes) {
+    LOG(ERROR) << "Invalid message size: " << legacy_header->num_bytes;
+    return false;
+  }
+
+  ParsedMessage message;
+  if (!ParseMessage(legacy_header, &message) || message.num_handles > 0)
+    return false;
+  return DispatchReceivedMessage(message.message_type, message.payload,
+                                 message.payload_size,
+                                 std::vector<ScopedPlatformHandle>());
+}
+
+bool Channel::DispatchPrecedingMessages() {
+  return true;
+}
+
+bool Channel::DispatchReceivedMessage(
+    Message::MessageType message_type,
+    const void* payload,
+    size_t payload_size,
+    std::vector<ScopedPlatformHandle> handles) {
+  if (message_type != Message::MessageType::NORMAL_LEGACY &&
+      message_type != Message::MessageType::NORMAL) {
+    return OnControlMessage(message_type, payload, payload_size,
+                            std::move(handles));
+  }
+  if (delegate_)
+    delegate_->OnChannelMessage(payload, payload_size, std::move(handles));
+  return true;
+}
+
 bool Channel::OnControlMessage(Message::MessageType message_type,
                                const void* payload,
                                size_t payload_size,
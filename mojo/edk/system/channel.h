@@ -50,6 +50,12 @@ class MOJO_SYSTEM_IMPL_EXPORT Channel
 #endif
       // A normal message that uses Header and can contain extra header values.
       NORMAL,
+      // A control message which hands the receiver a shared memory ring, which
+      // the sender writes small messages to from then on.
+      SHARED_RING_SETUP,
+      // A control message which tells the receiver to go back to reading
+      // messages from the shared memory ring.
+      SHARED_RING_RESUME,
     };
 
 #pragma pack(push, 1)
@@ -315,6 +321,16 @@ class MOJO_SYSTEM_IMPL_EXPORT Channel
   // OK to call this synchronously from any public interface methods.
   void OnError(Error error);
 
+  // Dispatches a complete serialized message without any handles, which the
+  // implementation received through something other than the read buffer.
+  // Returns false if the message is invalid.
+  bool DispatchMessageWithoutHandles(const void* data, size_t num_bytes);
+
+  // Called before each message in the read buffer is dispatched, to let the
+  // implementation dispatch the messages it received through other means and
+  // which were sent before that message. Returns false on error.
+  virtual bool DispatchPrecedingMessages();
+
   // Retrieves the set of platform handles read for a given message.
   // |extra_header| and |extra_header_size| correspond to the extra header data.
   // Depending on the Channel implementation, this body may encode platform
@@ -344,6 +360,13 @@ class MOJO_SYSTEM_IMPL_EXPORT Channel
 
   class ReadBuffer;
 
+  // Dispatches a message received by the implementation, with its |handles|.
+  // Returns false if it is a control message which isn't accepted.
+  bool DispatchReceivedMessage(Message::MessageType message_type,
+                               const void* payload,
+                               size_t payload_size,
+                               std::vector<ScopedPlatformHandle> handles);
+
   Delegate* delegate_;
   const std::unique_ptr<ReadBuffer> read_buffer_;
 
@@ -17,6 +17,7 @@
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
 #include "base/message_loop/message_loop.h"
+#include "base/metrics/histogram_macros.h"
 #include "base/synchronization/lock.h"
 #include "base/task_runner.h"
 #include "mojo/edk/embedder/platform_channel_utils_posix.h"
@@ -26,6 +27,18 @@
 #include <sys/uio.h>
 #endif
 
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "base/posix/eintr_wrapper.h"
+#include "base/unguessable_token.h"
+#include "mojo/edk/embedder/platform_shared_buffer.h"
+#include "mojo/edk/system/configuration.h"
+#include "mojo/edk/system/shared_ring_buffer.h"
+#endif
+
 namespace mojo {
 namespace edk {
 
@@ -33,6 +46,19 @@ namespace {
 
 const size_t kMaxBatchReadCapacity = 256 * 1024;
 
+// The maximum number of queued messages which are flushed with a single
+// syscall. Must not be more than IOV_MAX.
+const size_t kMaxMessagesPerWrite = 64;
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+// The payload of a SHARED_RING_SETUP message. Its handles are the ring's shared
+// memory and an eventfd which the writer signals to wake the reader up.
+struct SharedRingSetupData {
+  uint32_t capacity;
+  uint32_t padding;
+};
+#endif
+
 // A view over a Channel::Message object. The write queue uses these since
 // large messages may need to be sent in chunks.
 class MessageView {
@@ -68,6 +94,8 @@ class MessageView {
     offset_ += num_bytes;
   }
 
+  bool has_handles() const { return !handles_.empty(); }
+
   std::vector<ScopedPlatformHandle> TakeHandles() {
     return std::move(handles_);
   }
@@ -121,12 +149,8 @@ class ChannelPosix : public Channel,
       base::AutoLock lock(write_lock_);
       if (reject_writes_)
         return;
-      if (outgoing_messages_.empty()) {
-        if (!WriteNoLock(MessageView(std::move(message), 0)))
-          reject_writes_ = write_error = true;
-      } else {
-        outgoing_messages_.emplace_back(std::move(message), 0);
-      }
+      if (!WriteMessageNoLock(std::move(message)))
+        reject_writes_ = write_error = true;
     }
     if (write_error) {
       // Do not synchronously invoke OnError(). Write() may have been called by
@@ -203,6 +227,9 @@ class ChannelPosix : public Channel,
   ~ChannelPosix() override {
     DCHECK(!read_watcher_);
     DCHECK(!write_watcher_);
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+    DCHECK(!ring_watcher_);
+#endif
   }
 
   void StartOnIOThread() {
@@ -222,6 +249,9 @@ class ChannelPosix : public Channel,
           handle_.get().handle, true /* persistent */,
           base::MessageLoopForIO::WATCH_READ, read_watcher_.get(), this);
       base::AutoLock lock(write_lock_);
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+      SetUpOutgoingRingNoLock();
+#endif
       FlushOutgoingMessagesNoLock();
     }
   }
@@ -252,6 +282,13 @@ class ChannelPosix : public Channel,
 
     read_watcher_.reset();
     write_watcher_.reset();
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+    ring_watcher_.reset();
+    incoming_ring_active_ = false;
+    incoming_ring_.reset();
+    incoming_ring_mapping_.reset();
+    incoming_ring_event_.reset();
+#endif
     if (leak_handle_)
       ignore_result(handle_.release());
     handle_.reset();
@@ -272,6 +309,13 @@ class ChannelPosix : public Channel,
 
   // base::MessageLoopForIO::Watcher:
   void OnFileCanReadWithoutBlocking(int fd) override {
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+    if (incoming_ring_event_.is_valid() &&
+        fd == incoming_ring_event_.get().handle) {
+      OnRingEventSignaled();
+      return;
+    }
+#endif
     CHECK_EQ(fd, handle_.get().handle);
     if (handle_.get().needs_connection) {
 #if !defined(OS_NACL)
@@ -343,6 +387,49 @@ class ChannelPosix : public Channel,
       OnError(Error::kDisconnected);
   }
 
+  // Writes |message| to the shared memory ring if it can go there, or to the
+  // socket otherwise. Returns false on error.
+  bool WriteMessageNoLock(MessagePtr message) {
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+    if (outgoing_ring_) {
+      if (!message->has_handles() &&
+          outgoing_ring_->Write(SharedRingBuffer::RecordType::kMessage,
+                                message->data(), message->data_num_bytes(),
+                                SharedRingBuffer::kRecordHeaderSize)) {
+        if (outgoing_ring_active_) {
+          WakeRingReaderNoLock();
+          return true;
+        }
+        // The reader doesn't look at the ring again until it reads this from
+        // the socket, after everything that was sent through the socket.
+        outgoing_ring_active_ = true;
+        return WriteToSocketNoLock(MessagePtr(new Channel::Message(
+            0, 0, Message::MessageType::SHARED_RING_RESUME)));
+      }
+      if (outgoing_ring_active_) {
+        // Tell the reader to switch to the socket at this point of the ring.
+        // There is always room for this, unless the peer corrupted the ring.
+        if (!outgoing_ring_->Write(
+                SharedRingBuffer::RecordType::kSwitchTransport, nullptr, 0,
+                0)) {
+          return false;
+        }
+        WakeRingReaderNoLock();
+        outgoing_ring_active_ = false;
+      }
+    }
+#endif
+    return WriteToSocketNoLock(std::move(message));
+  }
+
+  // Writes |message| to the socket, after any messages which are queued.
+  bool WriteToSocketNoLock(MessagePtr message) {
+    if (outgoing_messages_.empty())
+      return WriteNoLock(MessageView(std::move(message), 0));
+    outgoing_messages_.emplace_back(std::move(message), 0);
+    return true;
+  }
+
   // Attempts to write a message directly to the channel. If the full message
   // cannot be written, it's queued and a wait is initiated to write the message
   // ASAP on the I/O thread.
@@ -432,10 +519,32 @@ class ChannelPosix : public Channel,
     std::swap(outgoing_messages_, messages);
 
     while (!messages.empty()) {
-      if (!WriteNoLock(std::move(messages.front())))
-        return false;
+      // Consecutive messages without handles are written together. Messages
+      // with handles are written on their own, so that the handles arrive
+      // along with their message's data.
+      size_t num_messages = 0;
+      if (!handle_.get().needs_connection) {
+        while (num_messages < messages.size() &&
+               num_messages < kMaxMessagesPerWrite &&
+               !messages[num_messages].has_handles()) {
+          ++num_messages;
+        }
+      }
+
+      if (num_messages > 1) {
+        if (!WriteCoalescedNoLock(&messages, num_messages))
+          return false;
+      } else {
+        if (!WriteNoLock(std::move(messages.front())))
+          return false;
+        messages.pop_front();
+        // WriteNoLock() requeues the message if the socket was full.
+        if (outgoing_messages_.empty()) {
+          UMA_HISTOGRAM_EXACT_LINEAR("Mojo.Channel.MessagesPerWrite", 1,
+                                     kMaxMessagesPerWrite + 1);
+        }
+      }
 
-      messages.pop_front();
       if (!outgoing_messages_.empty()) {
         // The message was requeued by WriteNoLock(), so we have to wait for
         // pipe to become writable again. Repopulate the message queue and exit.
@@ -454,12 +563,55 @@ class ChannelPosix : public Channel,
     return true;
   }
 
-#if defined(OS_MACOSX)
+  // Writes the first |num_messages| of |messages|, which have no handles, with
+  // a single syscall, and removes them from |messages|. If they can't all be
+  // written, the first one which wasn't is queued and a wait is initiated to
+  // write the rest ASAP on the I/O thread.
+  bool WriteCoalescedNoLock(base::circular_deque<MessageView>* messages,
+                            size_t num_messages) {
+    DCHECK_LE(num_messages, kMaxMessagesPerWrite);
+    iovec iov[kMaxMessagesPerWrite];
+    for (size_t i = 0; i < num_messages; ++i) {
+      const MessageView& message_view = (*messages)[i];
+      DCHECK(!message_view.has_handles());
+      iov[i] = {const_cast<void*>(message_view.data()),
+                message_view.data_num_bytes()};
+    }
+
+    ssize_t result = PlatformChannelWritev(handle_, iov, num_messages);
+    if (result < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+        return false;
+      result = 0;
+    } else {
+      UMA_HISTOGRAM_EXACT_LINEAR("Mojo.Channel.MessagesPerWrite",
+                                 static_cast<int>(num_messages),
+                                 kMaxMessagesPerWrite + 1);
+    }
+
+    size_t bytes_written = static_cast<size_t>(result);
+    for (size_t i = 0; i < num_messages; ++i) {
+      MessageView& message_view = messages->front();
+      if (bytes_written < message_view.data_num_bytes()) {
+        if (bytes_written)
+          message_view.advance_data_offset(bytes_written);
+        outgoing_messages_.emplace_front(std::move(message_view));
+        messages->pop_front();
+        WaitForWriteOnIOThreadNoLock();
+        return true;
+      }
+      bytes_written -= message_view.data_num_bytes();
+      messages->pop_front();
+    }
+    return true;
+  }
+
   bool OnControlMessage(Message::MessageType message_type,
                         const void* payload,
                         size_t payload_size,
                         std::vector<ScopedPlatformHandle> handles) override {
     switch (message_type) {
+#if defined(OS_MACOSX)
       case Message::MessageType::HANDLES_SENT: {
         if (payload_size == 0)
           break;
@@ -480,6 +632,18 @@ class ChannelPosix : public Channel,
           break;
         return true;
       }
+#endif  // defined(OS_MACOSX)
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+      case Message::MessageType::SHARED_RING_SETUP:
+        return SetUpIncomingRing(payload, payload_size, std::move(handles));
+
+      case Message::MessageType::SHARED_RING_RESUME:
+        if (!incoming_ring_ || incoming_ring_active_)
+          break;
+        incoming_ring_active_ = true;
+        return ReadFromRing(RingReadMode::kBatch);
+#endif
 
       default:
         break;
@@ -488,6 +652,7 @@ class ChannelPosix : public Channel,
     return false;
   }
 
+#if defined(OS_MACOSX)
   // Closes handles referenced by |fds|. Returns false if |num_fds| is 0, or if
   // |fds| does not match a sequence of handles in |handles_to_close_|.
   bool CloseHandles(const int* fds, size_t num_fds) {
@@ -524,6 +689,197 @@ class ChannelPosix : public Channel,
   }
 #endif  // defined(OS_MACOSX)
 
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  enum class RingReadMode {
+    // Reads until the ring is empty, in batches.
+    kBatch,
+    // Reads up to the next switch to the socket, which must be in the ring.
+    kUntilSwitch,
+  };
+
+  bool DispatchPrecedingMessages() override {
+    // Everything left in the ring was sent before the next socket message.
+    if (!incoming_ring_active_)
+      return true;
+    return ReadFromRing(RingReadMode::kUntilSwitch);
+  }
+
+  // Creates a ring for writing messages to, if it's enabled, and queues the
+  // message which hands it to the peer.
+  void SetUpOutgoingRingNoLock() {
+    const size_t capacity = GetConfiguration().channel_shared_ring_num_bytes;
+    if (!capacity || outgoing_ring_)
+      return;
+    if (!SharedRingBuffer::IsValidCapacity(capacity)) {
+      DLOG(ERROR) << "Invalid shared ring capacity: " << capacity;
+      return;
+    }
+
+    ScopedPlatformHandle event(
+        PlatformHandle(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)));
+    if (!event.is_valid())
+      return;
+    ScopedPlatformHandle peer_event(
+        PlatformHandle(HANDLE_EINTR(dup(event.get().handle))));
+    if (!peer_event.is_valid())
+      return;
+
+    // Sandboxed processes may fail to create shared memory, in which case
+    // they keep using the socket.
+    const size_t num_bytes = SharedRingBuffer::GetMemorySize(capacity);
+    scoped_refptr<PlatformSharedBuffer> buffer(
+        PlatformSharedBuffer::Create(num_bytes));
+    if (!buffer)
+      return;
+    std::unique_ptr<PlatformSharedBufferMapping> mapping =
+        buffer->Map(0, num_bytes);
+    if (!mapping)
+      return;
+    ScopedPlatformHandle peer_buffer = buffer->DuplicatePlatformHandle();
+    if (!peer_buffer.is_valid())
+      return;
+
+    MessagePtr message(new Channel::Message(
+        sizeof(SharedRingSetupData), 2,
+        Message::MessageType::SHARED_RING_SETUP));
+    SharedRingSetupData* data =
+        static_cast<SharedRingSetupData*>(message->mutable_payload());
+    data->capacity = static_cast<uint32_t>(capacity);
+    data->padding = 0;
+    std::vector<ScopedPlatformHandle> handles;
+    handles.push_back(std::move(peer_buffer));
+    handles.push_back(std::move(peer_event));
+    message->SetHandles(std::move(handles));
+    outgoing_messages_.emplace_back(std::move(message), 0);
+
+    outgoing_ring_mapping_ = std::move(mapping);
+    outgoing_ring_.reset(
+        new SharedRingBuffer(outgoing_ring_mapping_->GetBase(), capacity));
+    outgoing_ring_event_ = std::move(event);
+    outgoing_ring_active_ = true;
+  }
+
+  void WakeRingReaderNoLock() {
+    if (!outgoing_ring_->ConsumeReaderWaiting())
+      return;
+    // This only fails if the counter is about to overflow, in which case the
+    // reader has a wakeup pending anyway.
+    uint64_t value = 1;
+    ignore_result(HANDLE_EINTR(
+        write(outgoing_ring_event_.get().handle, &value, sizeof(value))));
+  }
+
+  // Maps the ring which the peer sent in a SHARED_RING_SETUP message, and
+  // starts reading from it.
+  bool SetUpIncomingRing(const void* payload,
+                         size_t payload_size,
+                         std::vector<ScopedPlatformHandle> handles) {
+    if (incoming_ring_ || payload_size != sizeof(SharedRingSetupData) ||
+        handles.size() != 2) {
+      return false;
+    }
+    const size_t capacity =
+        static_cast<const SharedRingSetupData*>(payload)->capacity;
+    if (!SharedRingBuffer::IsValidCapacity(capacity))
+      return false;
+    const size_t num_bytes = SharedRingBuffer::GetMemorySize(capacity);
+
+#if !defined(OS_ANDROID)
+    // Don't let the peer make us touch memory past the end of the file, which
+    // would crash. Ashmem regions can't be mapped past their end to begin
+    // with.
+    struct stat buffer_stat;
+    if (fstat(handles[0].get().handle, &buffer_stat) != 0 ||
+        buffer_stat.st_size < static_cast<off_t>(num_bytes)) {
+      return false;
+    }
+#endif
+
+    scoped_refptr<PlatformSharedBuffer> buffer(
+        PlatformSharedBuffer::CreateFromPlatformHandle(
+            num_bytes, false /* read_only */, base::UnguessableToken::Create(),
+            std::move(handles[0])));
+    if (!buffer)
+      return false;
+    incoming_ring_mapping_ = buffer->Map(0, num_bytes);
+    if (!incoming_ring_mapping_)
+      return false;
+    incoming_ring_.reset(
+        new SharedRingBuffer(incoming_ring_mapping_->GetBase(), capacity));
+    incoming_ring_event_ = std::move(handles[1]);
+
+    ring_watcher_.reset(
+        new base::MessageLoopForIO::FileDescriptorWatcher(FROM_HERE));
+    base::MessageLoopForIO::current()->WatchFileDescriptor(
+        incoming_ring_event_.get().handle, true /* persistent */,
+        base::MessageLoopForIO::WATCH_READ, ring_watcher_.get(), this);
+
+    incoming_ring_active_ = true;
+    return ReadFromRing(RingReadMode::kBatch);
+  }
+
+  void OnRingEventSignaled() {
+    uint64_t value;
+    ignore_result(HANDLE_EINTR(
+        read(incoming_ring_event_.get().handle, &value, sizeof(value))));
+    // While the reader is on the socket, it doesn't need wakeups: it comes
+    // back to the ring when the writer tells it to.
+    OnRingReadable();
+  }
+
+  void OnRingReadable() {
+    if (!incoming_ring_active_)
+      return;
+    if (!ReadFromRing(RingReadMode::kBatch)) {
+      // Stop receiving read notifications.
+      read_watcher_.reset();
+      ring_watcher_.reset();
+      incoming_ring_active_ = false;
+      OnError(Error::kReceivedMalformedData);
+    }
+  }
+
+  // Dispatches the messages in the ring, until it switches to the socket or
+  // as |mode| says. Returns false if the ring contents are invalid.
+  bool ReadFromRing(RingReadMode mode) {
+    size_t total_bytes_read = 0;
+    while (incoming_ring_active_) {
+      if (mode == RingReadMode::kBatch &&
+          total_bytes_read >= kMaxBatchReadCapacity) {
+        // Let other tasks run, and come back for the rest.
+        io_task_runner_->PostTask(
+            FROM_HERE, base::Bind(&ChannelPosix::OnRingReadable, this));
+        return true;
+      }
+
+      SharedRingBuffer::RecordType type;
+      const void* data;
+      size_t size;
+      switch (incoming_ring_->Read(&type, &data, &size)) {
+        case SharedRingBuffer::ReadResult::kRecord:
+          break;
+        case SharedRingBuffer::ReadResult::kEmpty:
+          if (mode == RingReadMode::kUntilSwitch)
+            return false;
+          if (incoming_ring_->PrepareToWait())
+            return true;
+          continue;
+        case SharedRingBuffer::ReadResult::kInvalid:
+          return false;
+      }
+
+      if (type == SharedRingBuffer::RecordType::kSwitchTransport) {
+        incoming_ring_active_ = false;
+        return true;
+      }
+      if (!DispatchMessageWithoutHandles(data, size))
+        return false;
+      total_bytes_read += size;
+    }
+    return true;
+  }
+#endif  // defined(OS_LINUX) || defined(OS_ANDROID)
+
   // Keeps the Channel alive at least until explicit shutdown on the IO thread.
   scoped_refptr<Channel> self_;
 
@@ -544,6 +900,26 @@ class ChannelPosix : public Channel,
 
   bool leak_handle_ = false;
 
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  // The ring which small messages are written to, and the event which wakes
+  // its reader up. Protected by |write_lock_|. While |outgoing_ring_active_|
+  // is false the peer reads from the socket, and won't look at the ring until
+  // it's sent a SHARED_RING_RESUME message.
+  std::unique_ptr<PlatformSharedBufferMapping> outgoing_ring_mapping_;
+  std::unique_ptr<SharedRingBuffer> outgoing_ring_;
+  ScopedPlatformHandle outgoing_ring_event_;
+  bool outgoing_ring_active_ = false;
+
+  // The ring which the peer writes to, which must only be accessed on the IO
+  // thread. While |incoming_ring_active_| is false, messages are read from the
+  // socket.
+  std::unique_ptr<PlatformSharedBufferMapping> incoming_ring_mapping_;
+  std::unique_ptr<SharedRingBuffer> incoming_ring_;
+  ScopedPlatformHandle incoming_ring_event_;
+  std::unique_ptr<base::MessageLoopForIO::FileDescriptorWatcher> ring_watcher_;
+  bool incoming_ring_active_ = false;
+#endif
+
 #if defined(OS_MACOSX)
   base::Lock handles_to_close_lock_;
   std::vector<ScopedPlatformHandle> handles_to_close_;
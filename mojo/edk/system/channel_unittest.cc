@@ -3,10 +3,30 @@
 // found in the LICENSE file.
 
 #include "mojo/edk/system/channel.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <utility>
+#include <vector>
+
+#include "base/macros.h"
 #include "base/memory/ptr_util.h"
+#include "base/run_loop.h"
+#include "base/test/histogram_tester.h"
+#include "base/test/scoped_task_environment.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "build/build_config.h"
+#include "mojo/edk/embedder/connection_params.h"
+#include "mojo/edk/embedder/platform_channel_pair.h"
+#include "mojo/edk/system/configuration.h"
 #include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
+#if defined(OS_POSIX)
+#include <sys/socket.h>
+#endif
+
 namespace mojo {
 namespace edk {
 namespace {
@@ -23,6 +43,15 @@ class TestChannel : public Channel {
     return OnReadComplete(bytes_read, next_read_size_hint);
   }
 
+  bool DispatchMessageWithoutHandlesTest(const void* data, size_t num_bytes) {
+    return DispatchMessageWithoutHandles(data, num_bytes);
+  }
+
+  // Makes |message| dispatch before the next message in the read buffer.
+  void SetPrecedingMessage(MessagePtr message) {
+    preceding_message_ = std::move(message);
+  }
+
   MOCK_METHOD4(GetReadPlatformHandles,
                bool(size_t num_handles,
                     const void* extra_header,
@@ -36,6 +65,17 @@ class TestChannel : public Channel {
 
  protected:
   ~TestChannel() override {}
+
+  bool DispatchPrecedingMessages() override {
+    if (!preceding_message_)
+      return true;
+    MessagePtr message = std::move(preceding_message_);
+    return DispatchMessageWithoutHandles(message->data(),
+                                         message->data_num_bytes());
+  }
+
+ private:
+  MessagePtr preceding_message_;
 };
 
 // Not using GMock as I don't think it supports movable types.
@@ -45,6 +85,8 @@ class MockChannelDelegate : public Channel::Delegate {
 
   size_t GetReceivedPayloadSize() const { return payload_size_; }
 
+  size_t GetNumReceivedMessages() const { return num_messages_; }
+
   const void* GetReceivedPayload() const { return payload_.get(); }
 
  protected:
@@ -54,6 +96,7 @@ class MockChannelDelegate : public Channel::Delegate {
     payload_.reset(new char[payload_size]);
     memcpy(payload_.get(), payload, payload_size);
     payload_size_ = payload_size;
+    ++num_messages_;
   }
 
   // Notify that an error has occured and the Channel will cease operation.
@@ -61,6 +104,7 @@ class MockChannelDelegate : public Channel::Delegate {
 
  private:
   size_t payload_size_ = 0;
+  size_t num_messages_ = 0;
   std::unique_ptr<char[]> payload_;
 };
 
@@ -172,6 +216,245 @@ TEST(ChannelTest, OnReadNonLegacyMessage) {
                   channel_delegate.GetReceivedPayloadSize());
 }
 
+TEST(ChannelTest, DispatchMessageWithoutHandles) {
+  Channel::MessagePtr message =
+      CreateDefaultMessage(false /* legacy_message */);
+
+  MockChannelDelegate channel_delegate;
+  scoped_refptr<TestChannel> channel = new TestChannel(&channel_delegate);
+  EXPECT_TRUE(channel->DispatchMessageWithoutHandlesTest(
+      message->data(), message->data_num_bytes()));
+  EXPECT_EQ(1u, channel_delegate.GetNumReceivedMessages());
+  TestMemoryEqual(message->payload(), message->payload_size(),
+                  channel_delegate.GetReceivedPayload(),
+                  channel_delegate.GetReceivedPayloadSize());
+
+  // The message must be complete.
+  EXPECT_FALSE(channel->DispatchMessageWithoutHandlesTest(
+      message->data(), message->data_num_bytes() - 1));
+  EXPECT_EQ(1u, channel_delegate.GetNumReceivedMessages());
+}
+
+TEST(ChannelTest, OnReadDispatchesPrecedingMessages) {
+  size_t buffer_size = 100 * 1024;
+  Channel::MessagePtr message =
+      CreateDefaultMessage(false /* legacy_message */);
+
+  MockChannelDelegate channel_delegate;
+  scoped_refptr<TestChannel> channel = new TestChannel(&channel_delegate);
+  channel->SetPrecedingMessage(std::make_unique<Channel::Message>(
+      0, 0, Channel::Message::MessageType::NORMAL));
+  char* read_buffer = channel->GetReadBufferTest(&buffer_size);
+  ASSERT_LT(message->data_num_bytes(), buffer_size);
+  memcpy(read_buffer, message->data(), message->data_num_bytes());
+
+  size_t next_read_size_hint = 0;
+  EXPECT_TRUE(channel->OnReadCompleteTest(message->data_num_bytes(),
+                                          &next_read_size_hint));
+
+  // The empty preceding message was dispatched first.
+  EXPECT_EQ(2u, channel_delegate.GetNumReceivedMessages());
+  TestMemoryEqual(message->payload(), message->payload_size(),
+                  channel_delegate.GetReceivedPayload(),
+                  channel_delegate.GetReceivedPayloadSize());
+}
+
+#if defined(OS_POSIX)
+// Records the index in each message it receives, and how many handles came
+// with it.
+class IndexRecordingDelegate : public Channel::Delegate {
+ public:
+  IndexRecordingDelegate() {}
+
+  const std::vector<uint32_t>& indices() const { return indices_; }
+  const std::vector<size_t>& num_handles() const { return num_handles_; }
+  bool had_error() const { return had_error_; }
+
+  // Runs until |num_messages| messages have been received in total.
+  void WaitForMessages(size_t num_messages) {
+    if (indices_.size() >= num_messages)
+      return;
+    num_messages_to_wait_for_ = num_messages;
+    base::RunLoop run_loop;
+    quit_closure_ = run_loop.QuitClosure();
+    run_loop.Run();
+  }
+
+  // Channel::Delegate:
+  void OnChannelMessage(const void* payload,
+                        size_t payload_size,
+                        std::vector<ScopedPlatformHandle> handles) override {
+    uint32_t index;
+    ASSERT_GE(payload_size, sizeof(index));
+    memcpy(&index, payload, sizeof(index));
+    indices_.push_back(index);
+    num_handles_.push_back(handles.size());
+    if (quit_closure_ && indices_.size() >= num_messages_to_wait_for_)
+      std::move(quit_closure_).Run();
+  }
+
+  void OnChannelError(Channel::Error error) override {
+    had_error_ = true;
+    if (quit_closure_)
+      std::move(quit_closure_).Run();
+  }
+
+ private:
+  std::vector<uint32_t> indices_;
+  std::vector<size_t> num_handles_;
+  bool had_error_ = false;
+  size_t num_messages_to_wait_for_ = 0;
+  base::OnceClosure quit_closure_;
+
+  DISALLOW_COPY_AND_ASSIGN(IndexRecordingDelegate);
+};
+
+// Makes a message of |payload_size| bytes which starts with |index|, and which
+// carries a handle if |with_handle| is true.
+Channel::MessagePtr CreateIndexMessage(uint32_t index,
+                                       size_t payload_size,
+                                       bool with_handle) {
+  Channel::MessagePtr message =
+      std::make_unique<Channel::Message>(payload_size, with_handle ? 1 : 0);
+  memset(message->mutable_payload(), 0, payload_size);
+  memcpy(message->mutable_payload(), &index, sizeof(index));
+  if (with_handle) {
+    PlatformChannelPair pair;
+    std::vector<ScopedPlatformHandle> handles;
+    handles.push_back(pair.PassServerHandle());
+    message->SetHandles(std::move(handles));
+  }
+  return message;
+}
+
+TEST(ChannelTest, PartialCoalescedWritesKeepOrder) {
+  base::test::ScopedTaskEnvironment task_environment(
+      base::test::ScopedTaskEnvironment::MainThreadType::IO);
+  base::HistogramTester histogram_tester;
+
+  // Small socket buffers, which a few messages fill, so that the writes of the
+  // queued messages end in the middle of one.
+  PlatformChannelPair pair;
+  ScopedPlatformHandle server_handle = pair.PassServerHandle();
+  ScopedPlatformHandle client_handle = pair.PassClientHandle();
+  const int kSocketBufferSize = 4096;
+  ASSERT_EQ(0, setsockopt(server_handle.get().handle, SOL_SOCKET, SO_SNDBUF,
+                          &kSocketBufferSize, sizeof(kSocketBufferSize)));
+  ASSERT_EQ(0, setsockopt(client_handle.get().handle, SOL_SOCKET, SO_RCVBUF,
+                          &kSocketBufferSize, sizeof(kSocketBufferSize)));
+
+  IndexRecordingDelegate sender_delegate;
+  IndexRecordingDelegate receiver_delegate;
+  scoped_refptr<Channel> sender = Channel::Create(
+      &sender_delegate,
+      ConnectionParams(TransportProtocol::kLegacy, std::move(server_handle)),
+      base::ThreadTaskRunnerHandle::Get());
+  scoped_refptr<Channel> receiver = Channel::Create(
+      &receiver_delegate,
+      ConnectionParams(TransportProtocol::kLegacy, std::move(client_handle)),
+      base::ThreadTaskRunnerHandle::Get());
+  sender->Start();
+
+  // The receiver doesn't read until all of the messages are written, so most
+  // of them are queued, and then flushed with partial coalesced writes as the
+  // receiver drains the socket. Their size doesn't divide the buffer's.
+  const uint32_t kNumMessages = 200;
+  const size_t kPayloadSize = 1000;
+  for (uint32_t i = 0; i < kNumMessages; ++i)
+    sender->Write(CreateIndexMessage(i, kPayloadSize, false));
+  receiver->Start();
+  receiver_delegate.WaitForMessages(kNumMessages);
+
+  EXPECT_FALSE(receiver_delegate.had_error());
+  EXPECT_FALSE(sender_delegate.had_error());
+  ASSERT_EQ(kNumMessages, receiver_delegate.indices().size());
+  for (uint32_t i = 0; i < kNumMessages; ++i)
+    EXPECT_EQ(i, receiver_delegate.indices()[i]);
+
+  // Some of the writes covered several messages.
+  bool had_coalesced_write = false;
+  for (const base::Bucket& bucket :
+       histogram_tester.GetAllSamples("Mojo.Channel.MessagesPerWrite")) {
+    if (bucket.min > 1)
+      had_coalesced_write = true;
+  }
+  EXPECT_TRUE(had_coalesced_write);
+
+  sender->ShutDown();
+  receiver->ShutDown();
+  base::RunLoop().RunUntilIdle();
+}
+#endif  // defined(OS_POSIX)
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+// Sets the size of the shared memory ring of new channels, for the lifetime
+// of this object.
+class ScopedSharedRingNumBytes {
+ public:
+  explicit ScopedSharedRingNumBytes(size_t num_bytes)
+      : old_num_bytes_(GetConfiguration().channel_shared_ring_num_bytes) {
+    internal::g_configuration.channel_shared_ring_num_bytes = num_bytes;
+  }
+
+  ~ScopedSharedRingNumBytes() {
+    internal::g_configuration.channel_shared_ring_num_bytes = old_num_bytes_;
+  }
+
+ private:
+  const size_t old_num_bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedSharedRingNumBytes);
+};
+
+TEST(ChannelTest, SharedRingKeepsOrder) {
+  // The smallest ring, which a few hundred bytes of messages overflow.
+  ScopedSharedRingNumBytes ring_num_bytes(4096);
+  base::test::ScopedTaskEnvironment task_environment(
+      base::test::ScopedTaskEnvironment::MainThreadType::IO);
+
+  PlatformChannelPair pair;
+  IndexRecordingDelegate sender_delegate;
+  IndexRecordingDelegate receiver_delegate;
+  scoped_refptr<Channel> sender = Channel::Create(
+      &sender_delegate,
+      ConnectionParams(TransportProtocol::kLegacy, pair.PassServerHandle()),
+      base::ThreadTaskRunnerHandle::Get());
+  scoped_refptr<Channel> receiver = Channel::Create(
+      &receiver_delegate,
+      ConnectionParams(TransportProtocol::kLegacy, pair.PassClientHandle()),
+      base::ThreadTaskRunnerHandle::Get());
+  sender->Start();
+  receiver->Start();
+
+  // Every seventh message carries a handle, so it goes through the socket and
+  // switches the receiver away from the ring, and the next one switches it
+  // back. The receiver doesn't read until all of them are written, so the ring
+  // overflows and the rest go through the socket too.
+  const uint32_t kNumMessages = 100;
+  const size_t kPayloadSize = 256;
+  for (uint32_t i = 0; i < kNumMessages; ++i)
+    sender->Write(CreateIndexMessage(i, kPayloadSize, i % 7 == 3));
+  receiver_delegate.WaitForMessages(kNumMessages);
+
+  // Once the ring has been read, messages go through it again.
+  for (uint32_t i = kNumMessages; i < 2 * kNumMessages; ++i)
+    sender->Write(CreateIndexMessage(i, kPayloadSize, i % 7 == 3));
+  receiver_delegate.WaitForMessages(2 * kNumMessages);
+
+  EXPECT_FALSE(receiver_delegate.had_error());
+  EXPECT_FALSE(sender_delegate.had_error());
+  ASSERT_EQ(2 * kNumMessages, receiver_delegate.indices().size());
+  for (uint32_t i = 0; i < 2 * kNumMessages; ++i) {
+    EXPECT_EQ(i, receiver_delegate.indices()[i]);
+    EXPECT_EQ(i % 7 == 3 ? 1u : 0u, receiver_delegate.num_handles()[i]);
+  }
+
+  sender->ShutDown();
+  receiver->ShutDown();
+  base::RunLoop().RunUntilIdle();
+}
+#endif  // defined(OS_LINUX) || defined(OS_ANDROID)
+
 }  // namespace
 }  // namespace edk
 }  // namespace mojo
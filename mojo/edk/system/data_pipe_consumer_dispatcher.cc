@@ -41,7 +41,8 @@ struct SerializedState {
   uint8_t flags;
   uint64_t buffer_guid_high;
   uint64_t buffer_guid_low;
-  char padding[7];
+  uint32_t ring_num_bytes;
+  char padding[3];
 };
 
 static_assert(sizeof(SerializedState) % 8 == 0,
@@ -49,6 +50,10 @@ static_assert(sizeof(SerializedState) % 8 == 0,
 
 #pragma pack(pop)
 
+// Reads are reported to the producer once they add up to this fraction of the
+// ring, or once the producer may have less than this fraction left to write to.
+const uint32_t kReadNotificationRingFraction = 4;
+
 }  // namespace
 
 // A PortObserver which forwards to a DataPipeConsumerDispatcher. This owns a
@@ -82,6 +87,7 @@ scoped_refptr<DataPipeConsumerDispatcher> DataPipeConsumerDispatcher::Create(
       new DataPipeConsumerDispatcher(node_controller, control_port,
                                      shared_ring_buffer, options, pipe_id);
   base::AutoLock lock(consumer->lock_);
+  consumer->ring_num_bytes_ = GetInitialDataPipeRingNumBytes(options);
   if (!consumer->InitializeNoLock())
     return nullptr;
   return consumer;
@@ -143,6 +149,8 @@ MojoResult DataPipeConsumerDispatcher::ReadData(void* elements,
   if (min_num_bytes_to_read > bytes_available_) {
     if (had_new_data)
       watchers_.NotifyState(GetHandleSignalsStateNoLock());
+    // The producer may need the room for the rest of the data to arrive.
+    FlushReadNotificationNoLock();
     return peer_closed_ ? MOJO_RESULT_FAILED_PRECONDITION
                         : MOJO_RESULT_OUT_OF_RANGE;
   }
@@ -162,9 +170,9 @@ MojoResult DataPipeConsumerDispatcher::ReadData(void* elements,
     uint8_t* destination = static_cast<uint8_t*>(elements);
     CHECK(destination);
 
-    DCHECK_LE(read_offset_, options_.capacity_num_bytes);
+    DCHECK_LE(read_offset_, ring_num_bytes_);
     uint32_t tail_bytes_to_copy =
-        std::min(options_.capacity_num_bytes - read_offset_, bytes_to_read);
+        std::min(ring_num_bytes_ - read_offset_, bytes_to_read);
     uint32_t head_bytes_to_copy = bytes_to_read - tail_bytes_to_copy;
     if (tail_bytes_to_copy > 0)
       memcpy(destination, data + read_offset_, tail_bytes_to_copy);
@@ -175,11 +183,11 @@ MojoResult DataPipeConsumerDispatcher::ReadData(void* elements,
 
   bool peek = !!(flags & MOJO_READ_DATA_FLAG_PEEK);
   if (discard || !peek) {
-    read_offset_ = (read_offset_ + bytes_to_read) % options_.capacity_num_bytes;
+    read_offset_ = (read_offset_ + bytes_to_read) % ring_num_bytes_;
     bytes_available_ -= bytes_to_read;
-
-    base::AutoUnlock unlock(lock_);
-    NotifyRead(bytes_to_read);
+    num_bytes_read_unnotified_ += bytes_to_read;
+    if (ShouldNotifyReadNoLock())
+      FlushReadNotificationNoLock();
   }
 
   // We may have just read the last available data and thus changed the signals
@@ -216,9 +224,9 @@ MojoResult DataPipeConsumerDispatcher::BeginReadData(const void** buffer,
                         : MOJO_RESULT_SHOULD_WAIT;
   }
 
-  DCHECK_LT(read_offset_, options_.capacity_num_bytes);
+  DCHECK_LT(read_offset_, ring_num_bytes_);
   uint32_t bytes_to_read =
-      std::min(bytes_available_, options_.capacity_num_bytes - read_offset_);
+      std::min(bytes_available_, ring_num_bytes_ - read_offset_);
 
   CHECK(ring_buffer_mapping_);
   uint8_t* data = static_cast<uint8_t*>(ring_buffer_mapping_->GetBase());
@@ -251,14 +259,13 @@ MojoResult DataPipeConsumerDispatcher::EndReadData(uint32_t num_bytes_read) {
     rv = MOJO_RESULT_INVALID_ARGUMENT;
   } else {
     rv = MOJO_RESULT_OK;
-    read_offset_ =
-        (read_offset_ + num_bytes_read) % options_.capacity_num_bytes;
+    read_offset_ = (read_offset_ + num_bytes_read) % ring_num_bytes_;
 
     DCHECK_GE(bytes_available_, num_bytes_read);
     bytes_available_ -= num_bytes_read;
-
-    base::AutoUnlock unlock(lock_);
-    NotifyRead(num_bytes_read);
+    num_bytes_read_unnotified_ += num_bytes_read;
+    if (ShouldNotifyReadNoLock())
+      FlushReadNotificationNoLock();
   }
 
   in_two_phase_read_ = false;
@@ -316,6 +323,7 @@ bool DataPipeConsumerDispatcher::EndSerialize(
   state->read_offset = read_offset_;
   state->bytes_available = bytes_available_;
   state->flags = peer_closed_ ? kFlagPeerClosed : 0;
+  state->ring_num_bytes = ring_num_bytes_;
 
   base::UnguessableToken guid = shared_ring_buffer_->GetGUID();
   state->buffer_guid_high = guid.GetHighForSerialization();
@@ -335,6 +343,10 @@ bool DataPipeConsumerDispatcher::BeginTransit() {
   if (in_transit_)
     return false;
   in_transit_ = !in_two_phase_read_;
+  // Unreported reads aren't serialized, so report them before the consumer
+  // moves.
+  if (in_transit_)
+    FlushReadNotificationNoLock();
   return in_transit_;
 }
 
@@ -370,7 +382,11 @@ DataPipeConsumerDispatcher::Deserialize(const void* data,
 
   const SerializedState* state = static_cast<const SerializedState*>(data);
   if (!state->options.capacity_num_bytes || !state->options.element_num_bytes ||
-      state->options.capacity_num_bytes < state->options.element_num_bytes) {
+      state->options.capacity_num_bytes < state->options.element_num_bytes ||
+      !state->ring_num_bytes ||
+      state->ring_num_bytes > state->options.capacity_num_bytes ||
+      state->bytes_available > state->ring_num_bytes ||
+      state->read_offset >= state->ring_num_bytes) {
     return nullptr;
   }
 
@@ -398,6 +414,7 @@ DataPipeConsumerDispatcher::Deserialize(const void* data,
 
   {
     base::AutoLock lock(dispatcher->lock_);
+    dispatcher->ring_num_bytes_ = state->ring_num_bytes;
     dispatcher->read_offset_ = state->read_offset;
     dispatcher->bytes_available_ = state->bytes_available;
     dispatcher->new_data_available_ = state->bytes_available > 0;
@@ -421,7 +438,8 @@ DataPipeConsumerDispatcher::DataPipeConsumerDispatcher(
       control_port_(control_port),
       pipe_id_(pipe_id),
       watchers_(this),
-      shared_ring_buffer_(shared_ring_buffer) {}
+      shared_ring_buffer_(shared_ring_buffer),
+      ring_num_bytes_(options_.capacity_num_bytes) {}
 
 DataPipeConsumerDispatcher::~DataPipeConsumerDispatcher() {
   DCHECK(is_closed_ && !shared_ring_buffer_ && !ring_buffer_mapping_ &&
@@ -499,13 +517,44 @@ HandleSignalsState DataPipeConsumerDispatcher::GetHandleSignalsStateNoLock()
   return rv;
 }
 
+bool DataPipeConsumerDispatcher::ShouldNotifyReadNoLock() const {
+  lock_.AssertAcquired();
+  if (!num_bytes_read_unnotified_)
+    return false;
+
+  // Once the ring is drained, the producer must see all of it free: it may be
+  // waiting to write more than it has room for, and the consumer won't read
+  // again until it does.
+  if (!bytes_available_)
+    return true;
+
+  // The producer has at most this much room, less whatever it has written
+  // since.
+  const uint32_t threshold = ring_num_bytes_ / kReadNotificationRingFraction;
+  uint32_t producer_available_capacity =
+      ring_num_bytes_ - bytes_available_ - num_bytes_read_unnotified_;
+  return num_bytes_read_unnotified_ >= threshold ||
+         producer_available_capacity < threshold;
+}
+
+void DataPipeConsumerDispatcher::FlushReadNotificationNoLock() {
+  lock_.AssertAcquired();
+  if (!num_bytes_read_unnotified_)
+    return;
+
+  uint32_t num_bytes = num_bytes_read_unnotified_;
+  num_bytes_read_unnotified_ = 0;
+  base::AutoUnlock unlock(lock_);
+  NotifyRead(num_bytes);
+}
+
 void DataPipeConsumerDispatcher::NotifyRead(uint32_t num_bytes) {
   DVLOG(1) << "Data pipe consumer " << pipe_id_
            << " notifying peer: " << num_bytes
            << " bytes read. [control_port=" << control_port_.name() << "]";
 
   SendDataPipeControlMessage(node_controller_, control_port_,
-                             DataPipeCommand::DATA_WAS_READ, num_bytes);
+                             DataPipeCommand::DATA_WAS_READ, num_bytes, 0);
 }
 
 void DataPipeConsumerDispatcher::OnPortStatusChanged() {
@@ -561,8 +610,22 @@ void DataPipeConsumerDispatcher::UpdateSignalsStateNoLock() {
           break;
         }
 
+        if (m->ring_num_bytes > ring_num_bytes_) {
+          // The producer grew its ring. It only does that while the data we
+          // have yet to read doesn't wrap around the end of the old ring.
+          if (m->ring_num_bytes > options_.capacity_num_bytes ||
+              m->ring_num_bytes % options_.element_num_bytes != 0 ||
+              (bytes_available_ &&
+               read_offset_ + bytes_available_ >= ring_num_bytes_)) {
+            DLOG(ERROR) << "Producer grew its ring unexpectedly.";
+            peer_closed_ = true;
+            break;
+          }
+          ring_num_bytes_ = m->ring_num_bytes;
+        }
+
         if (static_cast<size_t>(bytes_available_) + m->num_bytes >
-            options_.capacity_num_bytes) {
+            ring_num_bytes_) {
           DLOG(ERROR) << "Producer claims to have written too many bytes.";
           peer_closed_ = true;
           break;
@@ -585,6 +648,11 @@ void DataPipeConsumerDispatcher::UpdateSignalsStateNoLock() {
       peer_remote_ != was_peer_remote) {
     watchers_.NotifyState(GetHandleSignalsStateNoLock());
   }
+
+  // New data leaves the producer with less room, which may be too little to
+  // keep holding back reads.
+  if (has_new_data && !in_transit_ && ShouldNotifyReadNoLock())
+    FlushReadNotificationNoLock();
 }
 
 }  // namespace edk
@@ -86,6 +86,12 @@ class MOJO_SYSTEM_IMPL_EXPORT DataPipeConsumerDispatcher final
   bool InitializeNoLock();
   MojoResult CloseNoLock();
   HandleSignalsState GetHandleSignalsStateNoLock() const;
+  // Returns whether the producer should be told about the bytes in
+  // |num_bytes_read_unnotified_| now, rather than with a later read.
+  bool ShouldNotifyReadNoLock() const;
+  // Tells the producer about |num_bytes_read_unnotified_|, if there are any.
+  // Releases |lock_| while doing so.
+  void FlushReadNotificationNoLock();
   void NotifyRead(uint32_t num_bytes);
   void OnPortStatusChanged();
   void UpdateSignalsStateNoLock();
@@ -112,9 +118,19 @@ class MOJO_SYSTEM_IMPL_EXPORT DataPipeConsumerDispatcher final
   bool peer_remote_ = false;
   bool transferred_ = false;
 
+  // How much of |shared_ring_buffer_| is used as the ring, as last told by the
+  // producer.
+  uint32_t ring_num_bytes_;
+
   uint32_t read_offset_ = 0;
   uint32_t bytes_available_ = 0;
 
+  // Bytes which have been read, but which the producer hasn't been told about
+  // yet. Reads are only reported once they add up to a good part of the ring,
+  // or when the producer may otherwise run out of room, so that a consumer
+  // which reads in small pieces doesn't send a control message for each one.
+  uint32_t num_bytes_read_unnotified_ = 0;
+
   // Indicates whether any new data is available since the last read attempt.
   bool new_data_available_ = false;
 
@@ -4,7 +4,10 @@
 
 #include "mojo/edk/system/data_pipe_control_message.h"
 
+#include <algorithm>
+
 #include "mojo/edk/embedder/scoped_platform_handle.h"
+#include "mojo/edk/system/configuration.h"
 #include "mojo/edk/system/node_controller.h"
 #include "mojo/edk/system/ports/event.h"
 #include "mojo/edk/system/user_message_impl.h"
@@ -15,7 +18,8 @@ namespace edk {
 void SendDataPipeControlMessage(NodeController* node_controller,
                                 const ports::PortRef& port,
                                 DataPipeCommand command,
-                                uint32_t num_bytes) {
+                                uint32_t num_bytes,
+                                uint32_t ring_num_bytes) {
   std::unique_ptr<ports::UserMessageEvent> event;
   MojoResult result = UserMessageImpl::CreateEventForNewSerializedMessage(
       sizeof(DataPipeControlMessage), nullptr, 0, &event);
@@ -26,6 +30,8 @@ void SendDataPipeControlMessage(NodeController* node_controller,
       event->GetMessage<UserMessageImpl>()->user_payload());
   data->command = command;
   data->num_bytes = num_bytes;
+  data->ring_num_bytes = ring_num_bytes;
+  data->padding = 0;
 
   int rv = node_controller->SendUserMessage(port, std::move(event));
   if (rv != ports::OK && rv != ports::ERROR_PORT_PEER_CLOSED) {
@@ -34,5 +40,19 @@ void SendDataPipeControlMessage(NodeController* node_controller,
   }
 }
 
+uint32_t GetInitialDataPipeRingNumBytes(
+    const MojoCreateDataPipeOptions& options) {
+  size_t initial_num_bytes =
+      GetConfiguration().data_pipe_initial_ring_num_bytes;
+  if (!initial_num_bytes || initial_num_bytes >= options.capacity_num_bytes)
+    return options.capacity_num_bytes;
+
+  // The ring must hold at least one element, and only whole elements.
+  initial_num_bytes = std::max<size_t>(initial_num_bytes,
+                                       options.element_num_bytes);
+  return static_cast<uint32_t>(initial_num_bytes -
+                               initial_num_bytes % options.element_num_bytes);
+}
+
 }  // namespace edk
 }  // namespace mojo
@@ -11,6 +11,7 @@
 
 #include "mojo/edk/embedder/scoped_platform_handle.h"
 #include "mojo/edk/system/ports/port_ref.h"
+#include "mojo/public/c/system/data_pipe.h"
 #include "mojo/public/c/system/macros.h"
 
 namespace mojo {
@@ -30,12 +31,26 @@ enum DataPipeCommand : uint32_t {
 struct MOJO_ALIGNAS(8) DataPipeControlMessage {
   DataPipeCommand command;
   uint32_t num_bytes;
+
+  // For DATA_WAS_WRITTEN, how much of the shared buffer the producer uses as
+  // its ring. This only changes for pipes which start out with a smaller ring
+  // than their capacity. Zero for other commands.
+  uint32_t ring_num_bytes;
+  uint32_t padding;
 };
 
 void SendDataPipeControlMessage(NodeController* node_controller,
                                 const ports::PortRef& port,
                                 DataPipeCommand command,
-                                uint32_t num_bytes);
+                                uint32_t num_bytes,
+                                uint32_t ring_num_bytes);
+
+// Returns how much of its shared buffer a new data pipe created with |options|
+// uses as its ring. This is less than the pipe's capacity if the Configuration
+// asks for pipes to start small, in which case the producer grows the ring when
+// writes don't fit.
+uint32_t GetInitialDataPipeRingNumBytes(
+    const MojoCreateDataPipeOptions& options);
 
 }  // namespace edk
 }  // namespace mojo
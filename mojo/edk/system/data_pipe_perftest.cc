@@ -0,0 +1,134 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "base/test/perf_time_logger.h"
+#include "mojo/edk/test/mojo_test_base.h"
+#include "mojo/public/c/system/data_pipe.h"
+#include "mojo/public/c/system/functions.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace edk {
+namespace {
+
+// Modelled on a network response body: the producer writes the body in chunks
+// as they come off the network, and the consumer takes it in small pieces as
+// its parser gets to them.
+const size_t kBodyNumBytes = 64 * 1024 * 1024;
+const uint32_t kWriteChunkNumBytes = 32 * 1024;
+const uint32_t kReadChunkNumBytes = 4 * 1024;
+
+class DataPipePerfTest : public test::MojoTestBase {
+ public:
+  DataPipePerfTest() {}
+
+ protected:
+  // Sends the consumer of a pipe with the given capacity to the child, writes
+  // the body to it and waits for the child to report that it read all of it.
+  void MeasureDownload(MojoHandle mp, uint32_t capacity_num_bytes) {
+    const MojoCreateDataPipeOptions options = {
+        sizeof(MojoCreateDataPipeOptions),
+        MOJO_CREATE_DATA_PIPE_OPTIONS_FLAG_NONE, 1, capacity_num_bytes};
+    MojoHandle producer, consumer;
+    CHECK_EQ(MOJO_RESULT_OK,
+             MojoCreateDataPipe(&options, &producer, &consumer));
+
+    std::string test_name = base::StringPrintf(
+        "DataPipe_Download_%zuMB_%ukB_pipe", kBodyNumBytes / (1024 * 1024),
+        capacity_num_bytes / 1024);
+    base::PerfTimeLogger logger(test_name.c_str());
+
+    WriteMessageWithHandles(mp, "download", &consumer, 1);
+
+    std::vector<char> chunk(kWriteChunkNumBytes, 'x');
+    size_t num_bytes_written = 0;
+    while (num_bytes_written < kBodyNumBytes) {
+      uint32_t num_bytes = static_cast<uint32_t>(std::min<size_t>(
+          chunk.size(), kBodyNumBytes - num_bytes_written));
+      MojoResult rv = MojoWriteData(producer, chunk.data(), &num_bytes,
+                                    MOJO_WRITE_DATA_FLAG_NONE);
+      if (rv == MOJO_RESULT_SHOULD_WAIT) {
+        CHECK_EQ(MOJO_RESULT_OK,
+                 WaitForSignals(producer, MOJO_HANDLE_SIGNAL_WRITABLE));
+        continue;
+      }
+      CHECK_EQ(MOJO_RESULT_OK, rv);
+      num_bytes_written += num_bytes;
+    }
+    CloseHandle(producer);
+
+    EXPECT_EQ(base::NumberToString(kBodyNumBytes), ReadMessage(mp));
+    logger.Done();
+  }
+
+  // Reads bodies from the consumers sent over |mp| with two-phase reads, and
+  // replies with how many bytes each one had, until it is told to quit.
+  static void RunDownloadClient(MojoHandle mp) {
+    for (;;) {
+      MojoHandle consumer;
+      if (ReadMessageWithOptionalHandle(mp, &consumer) != "download")
+        return;
+
+      size_t num_bytes_read = 0;
+      for (;;) {
+        const void* buffer;
+        uint32_t num_bytes;
+        MojoResult rv = MojoBeginReadData(consumer, &buffer, &num_bytes,
+                                          MOJO_READ_DATA_FLAG_NONE);
+        if (rv == MOJO_RESULT_SHOULD_WAIT) {
+          rv = WaitForSignals(consumer, MOJO_HANDLE_SIGNAL_READABLE);
+          if (rv == MOJO_RESULT_FAILED_PRECONDITION)
+            break;
+          CHECK_EQ(MOJO_RESULT_OK, rv);
+          continue;
+        }
+        if (rv == MOJO_RESULT_FAILED_PRECONDITION)
+          break;
+        CHECK_EQ(MOJO_RESULT_OK, rv);
+
+        num_bytes = std::min(num_bytes, kReadChunkNumBytes);
+        CHECK_EQ(MOJO_RESULT_OK, MojoEndReadData(consumer, num_bytes));
+        num_bytes_read += num_bytes;
+      }
+      CloseHandle(consumer);
+
+      WriteMessage(mp, base::NumberToString(num_bytes_read));
+    }
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(DataPipePerfTest);
+};
+
+DEFINE_TEST_CLIENT_WITH_PIPE(DownloadClient, DataPipePerfTest, h) {
+  RunDownloadClient(h);
+  return 0;
+}
+
+// Streams a large body through data pipes of different capacities to another
+// process. Run with --data-pipe-initial-ring-size to have the pipes start out
+// small and grow.
+TEST_F(DataPipePerfTest, MultiprocessDownload) {
+  RunTestClient("DownloadClient", [&](MojoHandle h) {
+    const uint32_t kCapacities[] = {64 * 1024, 512 * 1024, 2 * 1024 * 1024};
+    for (uint32_t capacity_num_bytes : kCapacities)
+      MeasureDownload(h, capacity_num_bytes);
+    WriteMessage(h, "quit");
+  });
+}
+
+}  // namespace
+}  // namespace edk
+}  // namespace mojo
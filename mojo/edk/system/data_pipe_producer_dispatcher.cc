@@ -7,6 +7,7 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <algorithm>
 #include <utility>
 
 #include "base/bind.h"
@@ -40,7 +41,8 @@ struct SerializedState {
   uint8_t flags;
   uint64_t buffer_guid_high;
   uint64_t buffer_guid_low;
-  char padding[7];
+  uint32_t ring_num_bytes;
+  char padding[3];
 };
 
 static_assert(sizeof(SerializedState) % 8 == 0,
@@ -81,6 +83,8 @@ scoped_refptr<DataPipeProducerDispatcher> DataPipeProducerDispatcher::Create(
       new DataPipeProducerDispatcher(node_controller, control_port,
                                      shared_ring_buffer, options, pipe_id);
   base::AutoLock lock(producer->lock_);
+  producer->ring_num_bytes_ = GetInitialDataPipeRingNumBytes(options);
+  producer->available_capacity_ = producer->ring_num_bytes_;
   if (!producer->InitializeNoLock())
     return nullptr;
   return producer;
@@ -114,14 +118,17 @@ MojoResult DataPipeProducerDispatcher::WriteData(const void* elements,
   if (*num_bytes == 0)
     return MOJO_RESULT_OK;  // Nothing to do.
 
-  if ((flags & MOJO_WRITE_DATA_FLAG_ALL_OR_NONE) &&
-      (*num_bytes > available_capacity_)) {
+  const bool all_or_none = flags & MOJO_WRITE_DATA_FLAG_ALL_OR_NONE;
+  if (*num_bytes > available_capacity_)
+    GrowRingNoLock(all_or_none ? *num_bytes : 0);
+
+  if (all_or_none && (*num_bytes > available_capacity_)) {
     // Don't return "should wait" since you can't wait for a specified amount of
     // data.
     return MOJO_RESULT_OUT_OF_RANGE;
   }
 
-  DCHECK_LE(available_capacity_, options_.capacity_num_bytes);
+  DCHECK_LE(available_capacity_, ring_num_bytes_);
   uint32_t num_bytes_to_write = std::min(*num_bytes, available_capacity_);
   if (num_bytes_to_write == 0)
     return MOJO_RESULT_SHOULD_WAIT;
@@ -135,9 +142,9 @@ MojoResult DataPipeProducerDispatcher::WriteData(const void* elements,
   const uint8_t* source = static_cast<const uint8_t*>(elements);
   CHECK(source);
 
-  DCHECK_LE(write_offset_, options_.capacity_num_bytes);
+  DCHECK_LE(write_offset_, ring_num_bytes_);
   uint32_t tail_bytes_to_write =
-      std::min(options_.capacity_num_bytes - write_offset_, num_bytes_to_write);
+      std::min(ring_num_bytes_ - write_offset_, num_bytes_to_write);
   uint32_t head_bytes_to_write = num_bytes_to_write - tail_bytes_to_write;
 
   DCHECK_GT(tail_bytes_to_write, 0u);
@@ -147,13 +154,13 @@ MojoResult DataPipeProducerDispatcher::WriteData(const void* elements,
 
   DCHECK_LE(num_bytes_to_write, available_capacity_);
   available_capacity_ -= num_bytes_to_write;
-  write_offset_ =
-      (write_offset_ + num_bytes_to_write) % options_.capacity_num_bytes;
+  write_offset_ = (write_offset_ + num_bytes_to_write) % ring_num_bytes_;
 
   watchers_.NotifyState(GetHandleSignalsStateNoLock());
 
+  const uint32_t ring_num_bytes = ring_num_bytes_;
   base::AutoUnlock unlock(lock_);
-  NotifyWrite(num_bytes_to_write);
+  NotifyWrite(num_bytes_to_write, ring_num_bytes);
 
   return MOJO_RESULT_OK;
 }
@@ -175,14 +182,20 @@ MojoResult DataPipeProducerDispatcher::BeginWriteData(
   if (peer_closed_)
     return MOJO_RESULT_FAILED_PRECONDITION;
 
+  if (ring_was_full_) {
+    ring_was_full_ = false;
+    GrowRingNoLock(0);
+  }
+
   if (available_capacity_ == 0) {
+    ring_was_full_ = true;
     return peer_closed_ ? MOJO_RESULT_FAILED_PRECONDITION
                         : MOJO_RESULT_SHOULD_WAIT;
   }
 
   in_two_phase_write_ = true;
-  *buffer_num_bytes = std::min(options_.capacity_num_bytes - write_offset_,
-                               available_capacity_);
+  *buffer_num_bytes =
+      std::min(ring_num_bytes_ - write_offset_, available_capacity_);
   DCHECK_GT(*buffer_num_bytes, 0u);
 
   CHECK(ring_buffer_mapping_);
@@ -209,16 +222,16 @@ MojoResult DataPipeProducerDispatcher::EndWriteData(
   MojoResult rv = MOJO_RESULT_OK;
   if (num_bytes_written > available_capacity_ ||
       num_bytes_written % options_.element_num_bytes != 0 ||
-      write_offset_ + num_bytes_written > options_.capacity_num_bytes) {
+      write_offset_ + num_bytes_written > ring_num_bytes_) {
     rv = MOJO_RESULT_INVALID_ARGUMENT;
   } else {
-    DCHECK_LE(num_bytes_written + write_offset_, options_.capacity_num_bytes);
+    DCHECK_LE(num_bytes_written + write_offset_, ring_num_bytes_);
     available_capacity_ -= num_bytes_written;
-    write_offset_ =
-        (write_offset_ + num_bytes_written) % options_.capacity_num_bytes;
+    write_offset_ = (write_offset_ + num_bytes_written) % ring_num_bytes_;
 
+    const uint32_t ring_num_bytes = ring_num_bytes_;
     base::AutoUnlock unlock(lock_);
-    NotifyWrite(num_bytes_written);
+    NotifyWrite(num_bytes_written, ring_num_bytes);
   }
 
   in_two_phase_write_ = false;
@@ -277,6 +290,7 @@ bool DataPipeProducerDispatcher::EndSerialize(
   state->write_offset = write_offset_;
   state->available_capacity = available_capacity_;
   state->flags = peer_closed_ ? kFlagPeerClosed : 0;
+  state->ring_num_bytes = ring_num_bytes_;
 
   base::UnguessableToken guid = shared_ring_buffer_->GetGUID();
   state->buffer_guid_high = guid.GetHighForSerialization();
@@ -333,7 +347,11 @@ DataPipeProducerDispatcher::Deserialize(const void* data,
 
   const SerializedState* state = static_cast<const SerializedState*>(data);
   if (!state->options.capacity_num_bytes || !state->options.element_num_bytes ||
-      state->options.capacity_num_bytes < state->options.element_num_bytes) {
+      state->options.capacity_num_bytes < state->options.element_num_bytes ||
+      !state->ring_num_bytes ||
+      state->ring_num_bytes > state->options.capacity_num_bytes ||
+      state->available_capacity > state->ring_num_bytes ||
+      state->write_offset >= state->ring_num_bytes) {
     return nullptr;
   }
 
@@ -361,6 +379,7 @@ DataPipeProducerDispatcher::Deserialize(const void* data,
 
   {
     base::AutoLock lock(dispatcher->lock_);
+    dispatcher->ring_num_bytes_ = state->ring_num_bytes;
     dispatcher->write_offset_ = state->write_offset;
     dispatcher->available_capacity_ = state->available_capacity;
     dispatcher->peer_closed_ = state->flags & kFlagPeerClosed;
@@ -384,6 +403,7 @@ DataPipeProducerDispatcher::DataPipeProducerDispatcher(
       pipe_id_(pipe_id),
       watchers_(this),
       shared_ring_buffer_(shared_ring_buffer),
+      ring_num_bytes_(options_.capacity_num_bytes),
       available_capacity_(options_.capacity_num_bytes) {}
 
 DataPipeProducerDispatcher::~DataPipeProducerDispatcher() {
@@ -447,13 +467,43 @@ HandleSignalsState DataPipeProducerDispatcher::GetHandleSignalsStateNoLock()
   return rv;
 }
 
-void DataPipeProducerDispatcher::NotifyWrite(uint32_t num_bytes) {
+void DataPipeProducerDispatcher::GrowRingNoLock(
+    uint32_t min_available_capacity) {
+  lock_.AssertAcquired();
+  if (ring_num_bytes_ == options_.capacity_num_bytes)
+    return;
+
+  // The consumer learns about the new size with the next write, so the ring
+  // can only grow while everything that it may still read lies between the
+  // start of the ring and |write_offset_|, where both sizes agree on offsets.
+  uint32_t num_bytes_in_use = ring_num_bytes_ - available_capacity_;
+  if (num_bytes_in_use > write_offset_)
+    return;
+
+  uint64_t ring_num_bytes = ring_num_bytes_;
+  do {
+    ring_num_bytes *= 2;
+  } while (ring_num_bytes - num_bytes_in_use < min_available_capacity);
+  ring_num_bytes = std::min<uint64_t>(ring_num_bytes,
+                                      options_.capacity_num_bytes);
+  ring_num_bytes -= ring_num_bytes % options_.element_num_bytes;
+
+  DVLOG(1) << "Data pipe producer " << pipe_id_ << " growing its ring from "
+           << ring_num_bytes_ << " to " << ring_num_bytes << " bytes.";
+
+  available_capacity_ += static_cast<uint32_t>(ring_num_bytes) - ring_num_bytes_;
+  ring_num_bytes_ = static_cast<uint32_t>(ring_num_bytes);
+}
+
+void DataPipeProducerDispatcher::NotifyWrite(uint32_t num_bytes,
+                                             uint32_t ring_num_bytes) {
   DVLOG(1) << "Data pipe producer " << pipe_id_
            << " notifying peer: " << num_bytes
            << " bytes written. [control_port=" << control_port_.name() << "]";
 
   SendDataPipeControlMessage(node_controller_, control_port_,
-                             DataPipeCommand::DATA_WAS_WRITTEN, num_bytes);
+                             DataPipeCommand::DATA_WAS_WRITTEN, num_bytes,
+                             ring_num_bytes);
 }
 
 void DataPipeProducerDispatcher::OnPortStatusChanged() {
@@ -510,7 +560,7 @@ void DataPipeProducerDispatcher::UpdateSignalsStateNoLock() {
         }
 
         if (static_cast<size_t>(available_capacity_) + m->num_bytes >
-            options_.capacity_num_bytes) {
+            ring_num_bytes_) {
           DLOG(ERROR) << "Consumer claims to have read too many bytes.";
           break;
         }
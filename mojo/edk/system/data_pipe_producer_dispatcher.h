@@ -87,7 +87,12 @@ class MOJO_SYSTEM_IMPL_EXPORT DataPipeProducerDispatcher final
   bool InitializeNoLock();
   MojoResult CloseNoLock();
   HandleSignalsState GetHandleSignalsStateNoLock() const;
-  void NotifyWrite(uint32_t num_bytes);
+  // Grows the ring to at least twice its size, and enough to make
+  // |min_available_capacity| bytes available, up to the pipe's capacity. Does
+  // nothing if the data in the ring wraps around its end, since that data
+  // would then have to move.
+  void GrowRingNoLock(uint32_t min_available_capacity);
+  void NotifyWrite(uint32_t num_bytes, uint32_t ring_num_bytes);
   void OnPortStatusChanged();
   void UpdateSignalsStateNoLock();
 
@@ -113,6 +118,13 @@ class MOJO_SYSTEM_IMPL_EXPORT DataPipeProducerDispatcher final
   bool transferred_ = false;
   bool in_two_phase_write_ = false;
 
+  // How much of |shared_ring_buffer_| is used as the ring. This is less than
+  // the pipe's capacity if the pipe started out small, until the ring grows.
+  uint32_t ring_num_bytes_;
+  // Set when a two-phase write finds the ring full, so that the next one grows
+  // the ring.
+  bool ring_was_full_ = false;
+
   uint32_t write_offset_ = 0;
   uint32_t available_capacity_;
 
@@ -5,7 +5,9 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/location.h"
@@ -15,6 +17,7 @@
 #include "base/run_loop.h"
 #include "mojo/edk/embedder/embedder.h"
 #include "mojo/edk/embedder/platform_channel_pair.h"
+#include "mojo/edk/system/configuration.h"
 #include "mojo/edk/system/test_utils.h"
 #include "mojo/edk/test/mojo_test_base.h"
 #include "mojo/public/c/system/data_pipe.h"
@@ -1107,6 +1110,171 @@ TEST_F(DataPipeTest, WrapAround) {
   ASSERT_EQ(0, memcmp(read_buffer, &test_data[10], 100u));
 }
 
+// Tests that small reads are reported to the producer together, but that the
+// producer gets the room back as soon as it could run out of it.
+TEST_F(DataPipeTest, ReadNotificationsAreBatched) {
+  unsigned char test_data[200];
+  for (size_t i = 0; i < arraysize(test_data); i++)
+    test_data[i] = static_cast<unsigned char>(i);
+
+  const MojoCreateDataPipeOptions options = {
+      kSizeOfOptions,                           // |struct_size|.
+      MOJO_CREATE_DATA_PIPE_OPTIONS_FLAG_NONE,  // |flags|.
+      1u,                                       // |element_num_bytes|.
+      100u                                      // |capacity_num_bytes|.
+  };
+  ASSERT_EQ(MOJO_RESULT_OK, Create(&options));
+  MojoHandleSignalsState hss;
+
+  uint32_t num_bytes = 50u;
+  ASSERT_EQ(MOJO_RESULT_OK, WriteData(&test_data[0], &num_bytes, true));
+  ASSERT_EQ(MOJO_RESULT_OK,
+            WaitForSignals(consumer_, MOJO_HANDLE_SIGNAL_READABLE, &hss));
+
+  // Reading 10 bytes leaves the producer with plenty of room, so it isn't told
+  // about them yet. (This checks an implementation detail; this behavior is not
+  // guaranteed.)
+  unsigned char read_buffer[200] = {0};
+  num_bytes = 10u;
+  ASSERT_EQ(MOJO_RESULT_OK, ReadData(read_buffer, &num_bytes, true));
+  num_bytes = 100u;
+  ASSERT_EQ(MOJO_RESULT_OK, WriteData(&test_data[50], &num_bytes));
+  ASSERT_EQ(50u, num_bytes);
+
+  // Now that the pipe is full, the producer learns about the read.
+  for (size_t i = 0; i < kMaxPoll; i++) {
+    num_bytes = 100u;
+    MojoResult rv = WriteData(&test_data[100], &num_bytes);
+    if (rv == MOJO_RESULT_OK)
+      break;
+    ASSERT_EQ(MOJO_RESULT_SHOULD_WAIT, rv);
+    test::Sleep(test::EpsilonDeadline());
+  }
+  ASSERT_EQ(10u, num_bytes);
+
+  // Draining the pipe gives the producer all of it back.
+  for (size_t i = 0; i < kMaxPoll; i++) {
+    num_bytes = 0u;
+    ASSERT_EQ(MOJO_RESULT_OK, QueryData(&num_bytes));
+    if (num_bytes >= 100u)
+      break;
+    test::Sleep(test::EpsilonDeadline());
+  }
+  num_bytes = 100u;
+  ASSERT_EQ(MOJO_RESULT_OK, ReadData(&read_buffer[10], &num_bytes, true));
+  ASSERT_EQ(0, memcmp(read_buffer, test_data, 110u));
+  for (size_t i = 0; i < kMaxPoll; i++) {
+    num_bytes = 90u;
+    MojoResult rv = WriteData(&test_data[110], &num_bytes, true);
+    if (rv == MOJO_RESULT_OK)
+      break;
+    ASSERT_EQ(MOJO_RESULT_OUT_OF_RANGE, rv);
+    test::Sleep(test::EpsilonDeadline());
+  }
+  ASSERT_EQ(90u, num_bytes);
+}
+
+// Sets how much of their capacity new data pipes start out using, for the
+// lifetime of this object.
+class ScopedInitialRingNumBytes {
+ public:
+  explicit ScopedInitialRingNumBytes(size_t num_bytes)
+      : old_num_bytes_(GetConfiguration().data_pipe_initial_ring_num_bytes) {
+    internal::g_configuration.data_pipe_initial_ring_num_bytes = num_bytes;
+  }
+
+  ~ScopedInitialRingNumBytes() {
+    internal::g_configuration.data_pipe_initial_ring_num_bytes =
+        old_num_bytes_;
+  }
+
+ private:
+  const size_t old_num_bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedInitialRingNumBytes);
+};
+
+// Tests that a pipe which starts out with a small ring grows it, up to the
+// pipe's capacity, as the producer writes more than fits.
+TEST_F(DataPipeTest, RingGrows) {
+  ScopedInitialRingNumBytes initial_ring_num_bytes(64);
+
+  std::vector<unsigned char> test_data(4096);
+  for (size_t i = 0; i < test_data.size(); i++)
+    test_data[i] = static_cast<unsigned char>(i * 7);
+
+  const MojoCreateDataPipeOptions options = {
+      kSizeOfOptions,                           // |struct_size|.
+      MOJO_CREATE_DATA_PIPE_OPTIONS_FLAG_NONE,  // |flags|.
+      1u,                                       // |element_num_bytes|.
+      1024u                                     // |capacity_num_bytes|.
+  };
+  ASSERT_EQ(MOJO_RESULT_OK, Create(&options));
+
+  // The ring doubles on each write which doesn't fit, while the data doesn't
+  // wrap around its end. (This checks an implementation detail; this behavior
+  // is not guaranteed.)
+  std::vector<unsigned char> read_data;
+  const uint32_t kExpectedWriteSizes[] = {128u, 256u, 512u, 1024u, 1024u};
+  size_t num_bytes_written = 0;
+  for (uint32_t expected_write_size : kExpectedWriteSizes) {
+    uint32_t num_bytes = 1024u;
+    ASSERT_EQ(MOJO_RESULT_OK,
+              WriteData(&test_data[num_bytes_written], &num_bytes));
+    ASSERT_EQ(expected_write_size, num_bytes);
+    num_bytes_written += num_bytes;
+
+    // Drain the pipe, so that the producer gets all of the ring back.
+    while (read_data.size() < num_bytes_written) {
+      unsigned char buffer[1024];
+      num_bytes = sizeof(buffer);
+      MojoResult rv = ReadData(buffer, &num_bytes);
+      if (rv == MOJO_RESULT_SHOULD_WAIT) {
+        test::Sleep(test::EpsilonDeadline());
+        continue;
+      }
+      ASSERT_EQ(MOJO_RESULT_OK, rv);
+      read_data.insert(read_data.end(), buffer, buffer + num_bytes);
+    }
+    MojoHandleSignalsState hss;
+    ASSERT_EQ(MOJO_RESULT_OK,
+              WaitForSignals(producer_, MOJO_HANDLE_SIGNAL_WRITABLE, &hss));
+  }
+
+  ASSERT_EQ(num_bytes_written, read_data.size());
+  EXPECT_TRUE(std::equal(read_data.begin(), read_data.end(),
+                         test_data.begin()));
+}
+
+// Tests that an all-or-none write grows the ring as far as it needs to.
+TEST_F(DataPipeTest, RingGrowsForAllOrNoneWrite) {
+  ScopedInitialRingNumBytes initial_ring_num_bytes(64);
+
+  unsigned char test_data[1000];
+  for (size_t i = 0; i < arraysize(test_data); i++)
+    test_data[i] = static_cast<unsigned char>(i);
+
+  const MojoCreateDataPipeOptions options = {
+      kSizeOfOptions,                           // |struct_size|.
+      MOJO_CREATE_DATA_PIPE_OPTIONS_FLAG_NONE,  // |flags|.
+      1u,                                       // |element_num_bytes|.
+      1000u                                     // |capacity_num_bytes|.
+  };
+  ASSERT_EQ(MOJO_RESULT_OK, Create(&options));
+  MojoHandleSignalsState hss;
+
+  uint32_t num_bytes = 1000u;
+  ASSERT_EQ(MOJO_RESULT_OK, WriteData(test_data, &num_bytes, true));
+  ASSERT_EQ(1000u, num_bytes);
+
+  ASSERT_EQ(MOJO_RESULT_OK,
+            WaitForSignals(consumer_, MOJO_HANDLE_SIGNAL_READABLE, &hss));
+  unsigned char read_buffer[1000] = {0};
+  num_bytes = 1000u;
+  ASSERT_EQ(MOJO_RESULT_OK, ReadData(read_buffer, &num_bytes, true));
+  ASSERT_EQ(0, memcmp(read_buffer, test_data, 1000u));
+}
+
 // Tests the behavior of writing (simple and two-phase), closing the producer,
 // then reading (simple and two-phase).
 TEST_F(DataPipeTest, WriteCloseProducerRead) {
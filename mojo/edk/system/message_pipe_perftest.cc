@@ -13,6 +13,7 @@
 #include "base/logging.h"
 #include "base/macros.h"
 #include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
 #include "base/test/perf_time_logger.h"
 #include "base/threading/thread.h"
 #include "mojo/edk/embedder/embedder.h"
@@ -90,6 +91,78 @@ class MessagePipePerfTest : public test::MojoTestBase {
     SendQuitMessage(mp);
   }
 
+  // Runs ping-pongs on |num_pipes| pipes at once, each with its own pair of
+  // threads, to measure how much threads which talk over unrelated pipes slow
+  // each other down.
+  void RunConcurrentPingPong(size_t num_pipes,
+                             int message_count,
+                             size_t message_size) {
+    std::vector<MojoHandle> server_handles(num_pipes);
+    std::vector<MojoHandle> client_handles(num_pipes);
+    std::vector<std::unique_ptr<base::Thread>> threads;
+    std::vector<std::unique_ptr<base::WaitableEvent>> done_events;
+    for (size_t i = 0; i < num_pipes; ++i) {
+      CreateMessagePipe(&server_handles[i], &client_handles[i]);
+
+      threads.push_back(std::make_unique<base::Thread>("PingPongClient"));
+      threads.back()->Start();
+      threads.back()->task_runner()->PostTask(
+          FROM_HERE, base::Bind(base::IgnoreResult(&RunPingPongClient),
+                                client_handles[i]));
+
+      threads.push_back(std::make_unique<base::Thread>("PingPongServer"));
+      threads.back()->Start();
+      done_events.push_back(std::make_unique<base::WaitableEvent>(
+          base::WaitableEvent::ResetPolicy::MANUAL,
+          base::WaitableEvent::InitialState::NOT_SIGNALED));
+    }
+
+    std::string test_name = base::StringPrintf(
+        "IPC_Perf_Concurrent_%upipes_%dx_%u", static_cast<unsigned>(num_pipes),
+        message_count, static_cast<unsigned>(message_size));
+    base::PerfTimeLogger logger(test_name.c_str());
+
+    for (size_t i = 0; i < num_pipes; ++i) {
+      threads[2 * i + 1]->task_runner()->PostTask(
+          FROM_HERE, base::Bind(&RunPingPongs, server_handles[i], message_count,
+                                message_size, done_events[i].get()));
+    }
+    for (const auto& done_event : done_events)
+      done_event->Wait();
+
+    logger.Done();
+
+    for (MojoHandle server_handle : server_handles)
+      SendQuitMessage(server_handle);
+    threads.clear();
+    for (size_t i = 0; i < num_pipes; ++i) {
+      CloseHandle(server_handles[i]);
+      CloseHandle(client_handles[i]);
+    }
+  }
+
+  static void RunPingPongs(MojoHandle mp,
+                           int message_count,
+                           size_t message_size,
+                           base::WaitableEvent* done_event) {
+    std::string payload(message_size, '*');
+    std::vector<uint8_t> read_buffer;
+    for (int i = 0; i < message_count; ++i) {
+      CHECK_EQ(WriteMessageRaw(MessagePipeHandle(mp), payload.data(),
+                               payload.size(), nullptr, 0,
+                               MOJO_WRITE_MESSAGE_FLAG_NONE),
+               MOJO_RESULT_OK);
+      HandleSignalsState hss;
+      CHECK_EQ(WaitForSignals(mp, MOJO_HANDLE_SIGNAL_READABLE, &hss),
+               MOJO_RESULT_OK);
+      CHECK_EQ(ReadMessageRaw(MessagePipeHandle(mp), &read_buffer, nullptr,
+                              MOJO_READ_MESSAGE_FLAG_NONE),
+               MOJO_RESULT_OK);
+      CHECK_EQ(read_buffer.size(), payload.size());
+    }
+    done_event->Signal();
+  }
+
   static int RunPingPongClient(MojoHandle mp) {
     std::vector<uint8_t> buffer;
     int rv = 0;
@@ -142,6 +215,13 @@ TEST_F(MessagePipePerfTest, PingPong) {
   RunPingPongServer(server_handle);
 }
 
+// Runs ping-pongs over several pipes at once, from different threads.
+TEST_F(MessagePipePerfTest, ConcurrentPingPong) {
+  const size_t kNumPipes[] = {1, 2, 4, 8, 16};
+  for (size_t num_pipes : kNumPipes)
+    RunConcurrentPingPong(num_pipes, 20000, 144);
+}
+
 // For each message received, sends a reply message with the same contents
 // repeated twice, until the other end is closed or it receives "quitquitquit"
 // (which it doesn't reply to). It'll return the number of messages received,
@@ -98,27 +98,41 @@ void GenerateRandomPortName(PortName* name) {
 
 }  // namespace
 
+Node::PortShard::PortShard() = default;
+
+Node::PortShard::~PortShard() = default;
+
 Node::Node(const NodeName& name, NodeDelegate* delegate)
     : name_(name), delegate_(this, delegate) {}
 
 Node::~Node() {
-  if (!ports_.empty())
-    DLOG(WARNING) << "Unclean shutdown for node " << name_;
+  for (const PortShard& shard : port_shards_) {
+    if (!shard.ports.empty()) {
+      DLOG(WARNING) << "Unclean shutdown for node " << name_;
+      break;
+    }
+  }
 }
 
 bool Node::CanShutdownCleanly(ShutdownPolicy policy) {
   PortLocker::AssertNoPortsLockedOnCurrentThread();
-  base::AutoLock ports_lock(ports_lock_);
 
   if (policy == ShutdownPolicy::DONT_ALLOW_LOCAL_PORTS) {
+    bool can_shutdown = true;
+    for (PortShard& shard : port_shards_) {
+      base::AutoLock ports_lock(shard.lock);
 #if DCHECK_IS_ON()
-    for (auto& entry : ports_) {
-      DVLOG(2) << "Port " << entry.first << " referencing node "
-               << entry.second->peer_node_name << " is blocking shutdown of "
-               << "node " << name_ << " (state=" << entry.second->state << ")";
-    }
+      for (auto& entry : shard.ports) {
+        DVLOG(2) << "Port " << entry.first << " referencing node "
+                 << entry.second->peer_node_name << " is blocking shutdown of "
+                 << "node " << name_ << " (state=" << entry.second->state
+                 << ")";
+      }
 #endif
-    return ports_.empty();
+      if (!shard.ports.empty())
+        can_shutdown = false;
+    }
+    return can_shutdown;
   }
 
   DCHECK_EQ(policy, ShutdownPolicy::ALLOW_LOCAL_PORTS);
@@ -127,20 +141,23 @@ bool Node::CanShutdownCleanly(ShutdownPolicy policy) {
   // relatively few ports should be open during shutdown and shutdown doesn't
   // need to be blazingly fast.
   bool can_shutdown = true;
-  for (auto& entry : ports_) {
-    PortRef port_ref(entry.first, entry.second);
-    SinglePortLocker locker(&port_ref);
-    auto* port = locker.port();
-    if (port->peer_node_name != name_ && port->state != Port::kReceiving) {
-      can_shutdown = false;
+  for (PortShard& shard : port_shards_) {
+    base::AutoLock ports_lock(shard.lock);
+    for (auto& entry : shard.ports) {
+      PortRef port_ref(entry.first, entry.second);
+      SinglePortLocker locker(&port_ref);
+      auto* port = locker.port();
+      if (port->peer_node_name != name_ && port->state != Port::kReceiving) {
+        can_shutdown = false;
 #if DCHECK_IS_ON()
-      DVLOG(2) << "Port " << entry.first << " referencing node "
-               << port->peer_node_name << " is blocking shutdown of "
-               << "node " << name_ << " (state=" << port->state << ")";
+        DVLOG(2) << "Port " << entry.first << " referencing node "
+                 << port->peer_node_name << " is blocking shutdown of "
+                 << "node " << name_ << " (state=" << port->state << ")";
 #else
-      // Exit early when not debugging.
-      break;
+        // Exit early when not debugging.
+        return false;
 #endif
+      }
     }
   }
 
@@ -149,9 +166,10 @@ bool Node::CanShutdownCleanly(ShutdownPolicy policy) {
 
 int Node::GetPort(const PortName& port_name, PortRef* port_ref) {
   PortLocker::AssertNoPortsLockedOnCurrentThread();
-  base::AutoLock lock(ports_lock_);
-  auto iter = ports_.find(port_name);
-  if (iter == ports_.end())
+  PortShard& shard = GetPortShard(port_name);
+  base::AutoLock lock(shard.lock);
+  auto iter = shard.ports.find(port_name);
+  if (iter == shard.ports.end())
     return ERROR_PORT_UNKNOWN;
 
 #if defined(OS_ANDROID) && defined(ARCH_CPU_ARM64)
@@ -780,8 +798,9 @@ int Node::OnMergePort(std::unique_ptr<MergePortEvent> event) {
 
 int Node::AddPortWithName(const PortName& port_name, scoped_refptr<Port> port) {
   PortLocker::AssertNoPortsLockedOnCurrentThread();
-  base::AutoLock lock(ports_lock_);
-  if (!ports_.emplace(port_name, std::move(port)).second)
+  PortShard& shard = GetPortShard(port_name);
+  base::AutoLock lock(shard.lock);
+  if (!shard.ports.emplace(port_name, std::move(port)).second)
     return OOPS(ERROR_PORT_EXISTS);  // Suggests a bad UUID generator.
   DVLOG(2) << "Created port " << port_name << "@" << name_;
   return OK;
@@ -791,12 +810,13 @@ void Node::ErasePort(const PortName& port_name) {
   PortLocker::AssertNoPortsLockedOnCurrentThread();
   scoped_refptr<Port> port;
   {
-    base::AutoLock lock(ports_lock_);
-    auto it = ports_.find(port_name);
-    if (it == ports_.end())
+    PortShard& shard = GetPortShard(port_name);
+    base::AutoLock lock(shard.lock);
+    auto it = shard.ports.find(port_name);
+    if (it == shard.ports.end())
       return;
     port = std::move(it->second);
-    ports_.erase(it);
+    shard.ports.erase(it);
   }
   // NOTE: We are careful not to release the port's messages while holding any
   // locks, since they may run arbitrary user code upon destruction.
@@ -1276,6 +1296,10 @@ void Node::TryRemoveProxy(const PortRef& port_ref) {
     delegate_->ForwardEvent(removal_target_node, std::move(removal_event));
 }
 
+Node::PortShard& Node::GetPortShard(const PortName& port_name) {
+  return port_shards_[std::hash<PortName>()(port_name) % kNumPortShards];
+}
+
 void Node::DestroyAllPortsWithPeer(const NodeName& node_name,
                                    const PortName& port_name) {
   // Wipes out all ports whose peer node matches |node_name| and whose peer port
@@ -1286,11 +1310,11 @@ void Node::DestroyAllPortsWithPeer(const NodeName& node_name,
   std::vector<PortName> dead_proxies_to_broadcast;
   std::vector<std::unique_ptr<UserMessageEvent>> undelivered_messages;
 
-  {
-    PortLocker::AssertNoPortsLockedOnCurrentThread();
-    base::AutoLock ports_lock(ports_lock_);
+  PortLocker::AssertNoPortsLockedOnCurrentThread();
+  for (PortShard& shard : port_shards_) {
+    base::AutoLock ports_lock(shard.lock);
 
-    for (auto iter = ports_.begin(); iter != ports_.end(); ++iter) {
+    for (auto iter = shard.ports.begin(); iter != shard.ports.end(); ++iter) {
       PortRef port_ref(iter->first, iter->second);
       {
         SinglePortLocker locker(&port_ref);
@@ -1372,7 +1396,8 @@ Node::DelegateHolder::~DelegateHolder() {}
 #if DCHECK_IS_ON()
 void Node::DelegateHolder::EnsureSafeDelegateAccess() const {
   PortLocker::AssertNoPortsLockedOnCurrentThread();
-  base::AutoLock lock(node_->ports_lock_);
+  for (PortShard& shard : node_->port_shards_)
+    base::AutoLock lock(shard.lock);
 }
 #endif
 
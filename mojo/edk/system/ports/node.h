@@ -224,18 +224,31 @@ class Node {
   void DestroyAllPortsWithPeer(const NodeName& node_name,
                                const PortName& port_name);
 
+  // The port table is split into shards by port name, so that threads which
+  // look up unrelated ports rarely contend for the same lock.
+  static const size_t kNumPortShards = 16;
+
+  struct PortShard {
+    PortShard();
+    ~PortShard();
+
+    // Guards |ports|. This must never be acquired while an individual port's
+    // lock or another shard's lock is held on the same thread. Conversely,
+    // individual port locks may be acquired while this one is held.
+    //
+    // Because UserMessage events may execute arbitrary user code during
+    // destruction, it is also important to ensure that such events are never
+    // destroyed while this (or any individual Port) lock is held.
+    base::Lock lock;
+    std::unordered_map<PortName, scoped_refptr<Port>> ports;
+  };
+
+  PortShard& GetPortShard(const PortName& port_name);
+
   const NodeName name_;
   const DelegateHolder delegate_;
 
-  // Guards |ports_|. This must never be acquired while an individual port's
-  // lock is held on the same thread. Conversely, individual port locks may be
-  // acquired while this one is held.
-  //
-  // Because UserMessage events may execute arbitrary user code during
-  // destruction, it is also important to ensure that such events are never
-  // destroyed while this (or any individual Port) lock is held.
-  base::Lock ports_lock_;
-  std::unordered_map<PortName, scoped_refptr<Port>> ports_;
+  PortShard port_shards_[kNumPortShards];
 
   DISALLOW_COPY_AND_ASSIGN(Node);
 };
@@ -0,0 +1,197 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/edk/system/shared_ring_buffer.h"
+
+#include <string.h>
+
+#include <atomic>
+
+#include "base/bits.h"
+#include "base/logging.h"
+#include "mojo/edk/system/channel.h"
+
+namespace mojo {
+namespace edk {
+
+namespace {
+
+// Rings must hold at least this many records of the maximum size.
+const size_t kMinRecordsPerRing = 4;
+
+const size_t kMinCapacity = 4096;
+const size_t kMaxCapacity = 1u << 30;
+
+}  // namespace
+
+// Lives at the start of the shared memory. The two sides' fields are on
+// separate cache lines, so that they don't bounce between cores.
+struct SharedRingBuffer::SharedHeader {
+  // Written by the writer.
+  std::atomic<uint32_t> write_position;
+  char padding0[60];
+
+  // Written by the reader.
+  std::atomic<uint32_t> read_position;
+  // Non-zero while the reader waits for a wakeup. The writer clears it when it
+  // wakes the reader up.
+  std::atomic<uint32_t> reader_waiting;
+  char padding1[56];
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "Shared atomics must have the same layout in both processes");
+
+struct SharedRingBuffer::RecordHeader {
+  // The size of the data following the header, not including the padding to
+  // the next record.
+  uint32_t size;
+  RecordType type;
+};
+
+// static
+const size_t SharedRingBuffer::kRecordHeaderSize = sizeof(RecordHeader);
+
+// static
+bool SharedRingBuffer::IsValidCapacity(size_t capacity) {
+  return capacity >= kMinCapacity && capacity <= kMaxCapacity &&
+         (capacity & (capacity - 1)) == 0;
+}
+
+// static
+size_t SharedRingBuffer::GetMemorySize(size_t capacity) {
+  return sizeof(SharedHeader) + capacity;
+}
+
+SharedRingBuffer::SharedRingBuffer(void* memory, size_t capacity)
+    : shared_header_(static_cast<SharedHeader*>(memory)),
+      records_(static_cast<char*>(memory) + sizeof(SharedHeader)),
+      capacity_(static_cast<uint32_t>(capacity)),
+      max_data_size_(capacity / kMinRecordsPerRing - sizeof(RecordHeader)) {
+  static_assert(IsAlignedForChannelMessage(sizeof(SharedHeader)),
+                "Records must be aligned for the messages in them");
+  static_assert(IsAlignedForChannelMessage(sizeof(RecordHeader)),
+                "Records must be aligned for the messages in them");
+  DCHECK(IsValidCapacity(capacity));
+  DCHECK(IsAlignedForChannelMessage(reinterpret_cast<uintptr_t>(records_)));
+}
+
+SharedRingBuffer::~SharedRingBuffer() = default;
+
+bool SharedRingBuffer::Write(RecordType type,
+                             const void* data,
+                             size_t size,
+                             size_t reserved_bytes) {
+  DCHECK_NE(RecordType::kPadding, type);
+  if (size > max_data_size_)
+    return false;
+
+  // The reader's position is only trusted as far as it is consistent with
+  // ours.
+  uint32_t read_position =
+      shared_header_->read_position.load(std::memory_order_acquire);
+  uint32_t used = position_ - read_position;
+  if (used > capacity_)
+    return false;
+
+  uint32_t record_size = static_cast<uint32_t>(
+      sizeof(RecordHeader) + base::bits::Align(size, kChannelMessageAlignment));
+  uint32_t offset = position_ & (capacity_ - 1);
+  uint32_t contiguous = capacity_ - offset;
+  uint32_t padding_size = record_size > contiguous ? contiguous : 0;
+  if (used + padding_size + record_size + reserved_bytes > capacity_)
+    return false;
+
+  if (padding_size) {
+    RecordHeader padding = {
+        static_cast<uint32_t>(padding_size - sizeof(RecordHeader)),
+        RecordType::kPadding};
+    memcpy(records_ + offset, &padding, sizeof(padding));
+    position_ += padding_size;
+    offset = 0;
+  }
+
+  RecordHeader header = {static_cast<uint32_t>(size), type};
+  memcpy(records_ + offset, &header, sizeof(header));
+  if (size)
+    memcpy(records_ + offset + sizeof(header), data, size);
+  position_ += record_size;
+
+  // Sequentially consistent, so that the reader can't miss this record after
+  // it sets |reader_waiting|, while we see |reader_waiting| as unset.
+  shared_header_->write_position.store(position_, std::memory_order_seq_cst);
+  return true;
+}
+
+bool SharedRingBuffer::ConsumeReaderWaiting() {
+  return shared_header_->reader_waiting.exchange(
+             0, std::memory_order_seq_cst) != 0;
+}
+
+SharedRingBuffer::ReadResult SharedRingBuffer::Read(RecordType* type,
+                                                    const void** data,
+                                                    size_t* size) {
+  for (;;) {
+    uint32_t write_position =
+        shared_header_->write_position.load(std::memory_order_acquire);
+    uint32_t available = write_position - position_;
+    if (!available)
+      return ReadResult::kEmpty;
+    if (available > capacity_ || !IsAlignedForChannelMessage(available))
+      return ReadResult::kInvalid;
+
+    uint32_t offset = position_ & (capacity_ - 1);
+    uint32_t contiguous = capacity_ - offset;
+    RecordHeader header;
+    memcpy(&header, records_ + offset, sizeof(header));
+    if (header.size > contiguous - sizeof(RecordHeader))
+      return ReadResult::kInvalid;
+    uint32_t record_size = static_cast<uint32_t>(
+        sizeof(RecordHeader) +
+        base::bits::Align(header.size, kChannelMessageAlignment));
+
+    if (header.type == RecordType::kPadding) {
+      if (record_size != contiguous || record_size > available)
+        return ReadResult::kInvalid;
+      position_ += record_size;
+      shared_header_->read_position.store(position_,
+                                          std::memory_order_release);
+      continue;
+    }
+
+    if (record_size > available || header.size > max_data_size_)
+      return ReadResult::kInvalid;
+    if (header.type != RecordType::kMessage &&
+        header.type != RecordType::kSwitchTransport) {
+      return ReadResult::kInvalid;
+    }
+
+    if (!read_data_) {
+      read_data_.reset(static_cast<char*>(
+          base::AlignedAlloc(max_data_size_, kChannelMessageAlignment)));
+    }
+    memcpy(read_data_.get(), records_ + offset + sizeof(RecordHeader),
+           header.size);
+    position_ += record_size;
+    shared_header_->read_position.store(position_, std::memory_order_release);
+
+    *type = header.type;
+    *data = read_data_.get();
+    *size = header.size;
+    return ReadResult::kRecord;
+  }
+}
+
+bool SharedRingBuffer::PrepareToWait() {
+  shared_header_->reader_waiting.store(1, std::memory_order_seq_cst);
+  if (shared_header_->write_position.load(std::memory_order_seq_cst) ==
+      position_) {
+    return true;
+  }
+  shared_header_->reader_waiting.store(0, std::memory_order_relaxed);
+  return false;
+}
+
+}  // namespace edk
+}  // namespace mojo
@@ -0,0 +1,116 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_EDK_SYSTEM_SHARED_RING_BUFFER_H_
+#define MOJO_EDK_SYSTEM_SHARED_RING_BUFFER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+
+#include "base/macros.h"
+#include "base/memory/aligned_memory.h"
+#include "mojo/edk/system/system_impl_export.h"
+
+namespace mojo {
+namespace edk {
+
+// A single-producer, single-consumer ring of variable size records, in memory
+// which is shared between two processes. One process only writes records and
+// the other only reads them; each side has its own SharedRingBuffer over its
+// own mapping of the memory.
+//
+// Each side keeps its own position in the ring, and only publishes it to the
+// shared memory, so a misbehaving peer can't make the other side read or write
+// out of bounds. Records are copied out of the ring before they are returned,
+// so the peer can't change them after they have been validated.
+//
+// The reader doesn't poll: once the ring is empty it calls PrepareToWait() and
+// waits for a wakeup, which the writer only sends when ConsumeReaderWaiting()
+// says that the reader is waiting. Neither side blocks on the other.
+class MOJO_SYSTEM_IMPL_EXPORT SharedRingBuffer {
+ public:
+  enum class RecordType : uint32_t {
+    // Fills the end of the ring when the next record doesn't fit there.
+    kPadding = 0,
+    // A serialized Channel::Message.
+    kMessage = 1,
+    // Marks that the writer sends the following messages through another
+    // transport, until it tells the reader to come back to the ring.
+    kSwitchTransport = 2,
+  };
+
+  enum class ReadResult {
+    kEmpty,
+    kRecord,
+    // The shared memory has been corrupted, presumably by the peer.
+    kInvalid,
+  };
+
+  // The size of the empty record header, which a writer can always append if
+  // it passed this as |reserved_bytes| to all of its previous writes.
+  static const size_t kRecordHeaderSize;
+
+  // Returns whether |capacity| is valid for a ring, i.e. a power of two which
+  // is large enough to hold a few records.
+  static bool IsValidCapacity(size_t capacity);
+
+  // Returns the size of the shared memory needed for a ring of |capacity|
+  // bytes.
+  static size_t GetMemorySize(size_t capacity);
+
+  // |memory| must be a zero-initialized mapping of at least
+  // GetMemorySize(|capacity|) bytes, which outlives this object.
+  SharedRingBuffer(void* memory, size_t capacity);
+  ~SharedRingBuffer();
+
+  // The largest record data that fits in the ring.
+  size_t max_data_size() const { return max_data_size_; }
+
+  // Writer side. Appends a record of |type| with |size| bytes of |data|, if it
+  // fits in the ring with |reserved_bytes| to spare. Returns false otherwise.
+  bool Write(RecordType type,
+             const void* data,
+             size_t size,
+             size_t reserved_bytes);
+
+  // Writer side. Returns true if the reader is waiting for a wakeup, in which
+  // case the caller must wake it up.
+  bool ConsumeReaderWaiting();
+
+  // Reader side. Reads the next record, and points |data| to a copy of its
+  // |size| bytes of data, aligned for a Channel::Message, which is valid until
+  // the next call.
+  ReadResult Read(RecordType* type, const void** data, size_t* size);
+
+  // Reader side. Called when the ring is empty before waiting for a wakeup.
+  // Returns false if records were written in the meantime, in which case there
+  // won't be a wakeup for them.
+  bool PrepareToWait();
+
+ private:
+  struct SharedHeader;
+  struct RecordHeader;
+
+  SharedHeader* const shared_header_;
+  char* const records_;
+  const uint32_t capacity_;
+  const size_t max_data_size_;
+
+  // The position of the next record to write or read, depending on the side.
+  // Positions grow without bound, modulo 2^32, and are taken modulo
+  // |capacity_| to index |records_|.
+  uint32_t position_ = 0;
+
+  // The reader's aligned copy of the last record.
+  std::unique_ptr<char, base::AlignedFreeDeleter> read_data_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedRingBuffer);
+};
+
+}  // namespace edk
+}  // namespace mojo
+
+#endif  // MOJO_EDK_SYSTEM_SHARED_RING_BUFFER_H_
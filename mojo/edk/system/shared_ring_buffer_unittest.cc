@@ -0,0 +1,155 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/edk/system/shared_ring_buffer.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace edk {
+namespace {
+
+using RecordType = SharedRingBuffer::RecordType;
+using ReadResult = SharedRingBuffer::ReadResult;
+
+const size_t kCapacity = 4096;
+
+class SharedRingBufferTest : public testing::Test {
+ public:
+  SharedRingBufferTest()
+      : memory_(SharedRingBuffer::GetMemorySize(kCapacity) / sizeof(uint64_t)),
+        writer_(memory_.data(), kCapacity),
+        reader_(memory_.data(), kCapacity) {}
+
+ protected:
+  bool Write(const std::string& data) {
+    return writer_.Write(RecordType::kMessage, data.data(), data.size(),
+                         SharedRingBuffer::kRecordHeaderSize);
+  }
+
+  std::string Read() {
+    RecordType type;
+    const void* data;
+    size_t size;
+    EXPECT_EQ(ReadResult::kRecord, reader_.Read(&type, &data, &size));
+    EXPECT_EQ(RecordType::kMessage, type);
+    return std::string(static_cast<const char*>(data), size);
+  }
+
+  ReadResult ReadResultOnly() {
+    RecordType type;
+    const void* data;
+    size_t size;
+    return reader_.Read(&type, &data, &size);
+  }
+
+  char* records() {
+    return reinterpret_cast<char*>(memory_.data()) +
+           SharedRingBuffer::GetMemorySize(kCapacity) - kCapacity;
+  }
+
+  // Zero-initialized, and aligned for the shared header.
+  std::vector<uint64_t> memory_;
+  SharedRingBuffer writer_;
+  SharedRingBuffer reader_;
+};
+
+TEST_F(SharedRingBufferTest, IsValidCapacity) {
+  EXPECT_TRUE(SharedRingBuffer::IsValidCapacity(4096));
+  EXPECT_TRUE(SharedRingBuffer::IsValidCapacity(1024 * 1024));
+  EXPECT_FALSE(SharedRingBuffer::IsValidCapacity(0));
+  EXPECT_FALSE(SharedRingBuffer::IsValidCapacity(64));
+  EXPECT_FALSE(SharedRingBuffer::IsValidCapacity(4096 + 8));
+}
+
+TEST_F(SharedRingBufferTest, WriteAndRead) {
+  EXPECT_EQ(ReadResult::kEmpty, ReadResultOnly());
+
+  EXPECT_TRUE(Write("hello"));
+  EXPECT_TRUE(Write(""));
+  EXPECT_TRUE(writer_.Write(RecordType::kSwitchTransport, nullptr, 0, 0));
+  EXPECT_EQ("hello", Read());
+  EXPECT_EQ("", Read());
+
+  RecordType type;
+  const void* data;
+  size_t size;
+  EXPECT_EQ(ReadResult::kRecord, reader_.Read(&type, &data, &size));
+  EXPECT_EQ(RecordType::kSwitchTransport, type);
+  EXPECT_EQ(0u, size);
+  EXPECT_EQ(ReadResult::kEmpty, ReadResultOnly());
+}
+
+TEST_F(SharedRingBufferTest, WrapsAround) {
+  // Records of an odd size end up straddling the end of the ring, where they
+  // are replaced by padding.
+  std::string data(300, 'x');
+  for (int i = 0; i < 100; ++i) {
+    data[0] = static_cast<char>(i);
+    ASSERT_TRUE(Write(data));
+    ASSERT_TRUE(Write(data));
+    EXPECT_EQ(data, Read());
+    EXPECT_EQ(data, Read());
+  }
+  EXPECT_EQ(ReadResult::kEmpty, ReadResultOnly());
+}
+
+TEST_F(SharedRingBufferTest, Full) {
+  std::string data(writer_.max_data_size(), 'x');
+  EXPECT_FALSE(Write(data + "x"));
+
+  int written = 0;
+  while (Write(data))
+    ++written;
+  EXPECT_EQ(3, written);
+
+  // There is always room for the reserved bytes.
+  EXPECT_TRUE(writer_.Write(RecordType::kSwitchTransport, nullptr, 0, 0));
+
+  // Reading makes room again, even if the next record has to wrap around.
+  EXPECT_EQ(data, Read());
+  EXPECT_FALSE(Write(data));
+  EXPECT_EQ(data, Read());
+  EXPECT_TRUE(Write(data));
+}
+
+TEST_F(SharedRingBufferTest, Wait) {
+  EXPECT_TRUE(reader_.PrepareToWait());
+  EXPECT_TRUE(Write("a"));
+  EXPECT_TRUE(writer_.ConsumeReaderWaiting());
+  EXPECT_FALSE(writer_.ConsumeReaderWaiting());
+
+  // The reader doesn't wait while there are records to read.
+  EXPECT_FALSE(reader_.PrepareToWait());
+  EXPECT_FALSE(writer_.ConsumeReaderWaiting());
+  EXPECT_EQ("a", Read());
+  EXPECT_TRUE(reader_.PrepareToWait());
+}
+
+TEST_F(SharedRingBufferTest, CorruptRecord) {
+  EXPECT_TRUE(Write("hello"));
+
+  // A record which claims to extend past what was written.
+  uint32_t size = 1000;
+  memcpy(records(), &size, sizeof(size));
+  EXPECT_EQ(ReadResult::kInvalid, ReadResultOnly());
+}
+
+TEST_F(SharedRingBufferTest, CorruptRecordType) {
+  EXPECT_TRUE(Write("hello"));
+
+  uint32_t type = 42;
+  memcpy(records() + sizeof(uint32_t), &type, sizeof(type));
+  EXPECT_EQ(ReadResult::kInvalid, ReadResultOnly());
+}
+
+}  // namespace
+}  // namespace edk
+}  // namespace mojo
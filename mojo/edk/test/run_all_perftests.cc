@@ -3,19 +3,47 @@
 // found in the LICENSE file.
 
 #include "base/command_line.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/test/multiprocess_test.h"
 #include "base/test/perf_test_suite.h"
 #include "base/test/test_io_thread.h"
+#include "mojo/edk/embedder/configuration.h"
 #include "mojo/edk/embedder/embedder.h"
 #include "mojo/edk/embedder/scoped_ipc_support.h"
 #include "mojo/edk/test/multiprocess_test_helper.h"
 #include "mojo/edk/test/test_support_impl.h"
 #include "mojo/public/tests/test_support_private.h"
 
+namespace {
+
+// Makes channels to other processes send small messages through a shared
+// memory ring of the given size, to compare it with the socket. Child processes
+// inherit the switch.
+const char kChannelSharedRingSize[] = "channel-shared-ring-size";
+
+// Makes data pipes start out with a ring of the given size, which grows as
+// needed, to compare it with rings that use the whole capacity from the start.
+const char kDataPipeInitialRingSize[] = "data-pipe-initial-ring-size";
+
+}  // namespace
+
 int main(int argc, char** argv) {
   base::PerfTestSuite test(argc, argv);
 
-  mojo::edk::Init();
+  mojo::edk::Configuration config;
+  const base::CommandLine& command_line =
+      *base::CommandLine::ForCurrentProcess();
+  if (command_line.HasSwitch(kChannelSharedRingSize)) {
+    base::StringToSizeT(
+        command_line.GetSwitchValueASCII(kChannelSharedRingSize),
+        &config.channel_shared_ring_num_bytes);
+  }
+  if (command_line.HasSwitch(kDataPipeInitialRingSize)) {
+    base::StringToSizeT(
+        command_line.GetSwitchValueASCII(kDataPipeInitialRingSize),
+        &config.data_pipe_initial_ring_num_bytes);
+  }
+  mojo::edk::Init(config);
   base::TestIOThread test_io_thread(base::TestIOThread::kAutoStart);
   mojo::edk::ScopedIPCSupport ipc_support(
       test_io_thread.task_runner(),
@@ -72,7 +72,8 @@ class MOJO_CPP_BINDINGS_EXPORT AssociatedBindingBase {
                 std::unique_ptr<MessageReceiver> payload_validator,
                 bool expect_sync_requests,
                 scoped_refptr<base::SingleThreadTaskRunner> runner,
-                uint32_t interface_version);
+                uint32_t interface_version,
+                const char* interface_name);
 
   std::unique_ptr<InterfaceEndpointClient> endpoint_client_;
 };
@@ -118,7 +119,7 @@ class AssociatedBinding : public AssociatedBindingBase {
     BindImpl(request.PassHandle(), &stub_,
              base::WrapUnique(new typename Interface::RequestValidator_()),
              Interface::HasSyncMethods_, std::move(runner),
-             Interface::Version_);
+             Interface::Version_, Interface::Name_);
   }
 
   // Unbinds and returns the associated interface request so it can be
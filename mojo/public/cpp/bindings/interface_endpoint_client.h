@@ -41,13 +41,15 @@ class MOJO_CPP_BINDINGS_EXPORT InterfaceEndpointClient
     : public MessageReceiverWithResponder {
  public:
   // |receiver| is okay to be null. If it is not null, it must outlive this
-  // object.
+  // object. |interface_name| must outlive this object too; it is typically the
+  // generated Interface::Name_.
   InterfaceEndpointClient(ScopedInterfaceEndpointHandle handle,
                           MessageReceiverWithResponderStatus* receiver,
                           std::unique_ptr<MessageReceiver> payload_validator,
                           bool expect_sync_requests,
                           scoped_refptr<base::SequencedTaskRunner> runner,
-                          uint32_t interface_version);
+                          uint32_t interface_version,
+                          const char* interface_name);
   ~InterfaceEndpointClient() override;
 
   // Sets the error handler to receive notifications when an error is
@@ -159,8 +161,14 @@ class MOJO_CPP_BINDINGS_EXPORT InterfaceEndpointClient
 
   bool HandleValidatedMessage(Message* message);
 
+  // Records |message| with the MessageTrafficProfiler if it is sampled.
+  void RecordSentMessage(const Message& message);
+
   const bool expect_sync_requests_ = false;
 
+  // The name the MessageTrafficProfiler records messages under.
+  const char* const interface_name_;
+
   ScopedInterfaceEndpointHandle handle_;
   std::unique_ptr<AssociatedGroup> associated_group_;
   InterfaceEndpointController* controller_ = nullptr;
@@ -51,7 +51,8 @@ void AssociatedBindingBase::BindImpl(
     std::unique_ptr<MessageReceiver> payload_validator,
     bool expect_sync_requests,
     scoped_refptr<base::SingleThreadTaskRunner> runner,
-    uint32_t interface_version) {
+    uint32_t interface_version,
+    const char* interface_name) {
   if (!handle.is_valid()) {
     endpoint_client_.reset();
     return;
@@ -61,7 +62,7 @@ void AssociatedBindingBase::BindImpl(
       std::move(handle), receiver, std::move(payload_validator),
       expect_sync_requests,
       internal::GetTaskRunnerToUseFromUserProvidedTaskRunner(std::move(runner)),
-      interface_version));
+      interface_version, interface_name));
 }
 
 }  // namespace mojo
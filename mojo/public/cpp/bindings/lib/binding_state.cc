@@ -104,7 +104,7 @@ void BindingStateBase::BindInternal(
   endpoint_client_.reset(new InterfaceEndpointClient(
       router_->CreateLocalEndpointHandle(kMasterInterfaceId), stub,
       std::move(request_validator), has_sync_methods,
-      std::move(sequenced_runner), interface_version));
+      std::move(sequenced_runner), interface_version, interface_name));
 }
 
 }  // namesapce internal
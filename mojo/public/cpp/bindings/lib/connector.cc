@@ -18,6 +18,7 @@
 #include "base/threading/thread_local.h"
 #include "base/trace_event/trace_event.h"
 #include "mojo/public/cpp/bindings/lib/may_auto_lock.h"
+#include "mojo/public/cpp/bindings/message_traffic_profiler.h"
 #include "mojo/public/cpp/bindings/sync_handle_watcher.h"
 #include "mojo/public/cpp/system/wait.h"
 
@@ -421,6 +422,13 @@ bool Connector::ReadSingleMessage(MojoResult* read_result) {
   *read_result = rv;
 
   if (rv == MOJO_RESULT_OK) {
+    // The endpoint which dispatches the message records it.
+    MessageTrafficProfiler* profiler = MessageTrafficProfiler::Get();
+    if (profiler &&
+        profiler->ShouldSample(MessageTrafficProfiler::SamplePath::kReceived)) {
+      message.set_receive_time(base::TimeTicks::Now());
+    }
+
     base::Optional<ActiveDispatchTracker> dispatch_tracker;
     if (!is_dispatching_ && nesting_observer_) {
       is_dispatching_ = true;
@@ -18,6 +18,7 @@
 #include "mojo/public/cpp/bindings/interface_endpoint_controller.h"
 #include "mojo/public/cpp/bindings/lib/task_runner_helper.h"
 #include "mojo/public/cpp/bindings/lib/validation_util.h"
+#include "mojo/public/cpp/bindings/message_traffic_profiler.h"
 #include "mojo/public/cpp/bindings/sync_call_restrictions.h"
 
 namespace mojo {
@@ -140,8 +141,10 @@ InterfaceEndpointClient::InterfaceEndpointClient(
     std::unique_ptr<MessageReceiver> payload_validator,
     bool expect_sync_requests,
     scoped_refptr<base::SequencedTaskRunner> runner,
-    uint32_t interface_version)
+    uint32_t interface_version,
+    const char* interface_name)
     : expect_sync_requests_(expect_sync_requests),
+      interface_name_(interface_name),
       handle_(std::move(handle)),
       incoming_receiver_(receiver),
       thunk_(this),
@@ -238,6 +241,7 @@ bool InterfaceEndpointClient::Accept(Message* message) {
 
   InitControllerIfNecessary();
 
+  RecordSentMessage(*message);
   return controller_->SendMessage(message);
 }
 
@@ -265,6 +269,7 @@ bool InterfaceEndpointClient::AcceptWithResponder(
   message->set_request_id(request_id);
 
   bool is_sync = message->has_flag(Message::kFlagIsSync);
+  RecordSentMessage(*message);
   if (!controller_->SendMessage(message))
     return false;
 
@@ -305,6 +310,14 @@ bool InterfaceEndpointClient::HandleIncomingMessage(Message* message) {
   return filters_.Accept(message);
 }
 
+void InterfaceEndpointClient::RecordSentMessage(const Message& message) {
+  MessageTrafficProfiler* profiler = MessageTrafficProfiler::Get();
+  if (profiler &&
+      profiler->ShouldSample(MessageTrafficProfiler::SamplePath::kSent)) {
+    profiler->RecordSentMessage(interface_name_, message);
+  }
+}
+
 void InterfaceEndpointClient::NotifyError(
     const base::Optional<DisconnectReason>& reason) {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
@@ -382,6 +395,12 @@ bool InterfaceEndpointClient::HandleValidatedMessage(Message* message) {
     return false;
   }
 
+  if (!message->receive_time().is_null()) {
+    MessageTrafficProfiler* profiler = MessageTrafficProfiler::Get();
+    if (profiler)
+      profiler->RecordDispatchedMessage(interface_name_, *message);
+  }
+
   if (message->has_flag(Message::kFlagExpectsResponse)) {
     std::unique_ptr<MessageReceiverWithStatus> responder =
         std::make_unique<ResponderThunk>(weak_ptr_factory_.GetWeakPtr(),
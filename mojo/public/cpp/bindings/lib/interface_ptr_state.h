@@ -80,7 +80,8 @@ class MOJO_CPP_BINDINGS_EXPORT InterfacePtrStateBase {
   bool InitializeEndpointClient(
       bool passes_associated_kinds,
       bool has_sync_methods,
-      std::unique_ptr<MessageReceiver> payload_validator);
+      std::unique_ptr<MessageReceiver> payload_validator,
+      const char* interface_name);
 
  private:
   void OnQueryVersion(const base::Callback<void(uint32_t)>& callback,
@@ -204,7 +205,8 @@ class InterfacePtrState : public InterfacePtrStateBase {
 
     if (InitializeEndpointClient(
             Interface::PassesAssociatedKinds_, Interface::HasSyncMethods_,
-            std::make_unique<typename Interface::ResponseValidator_>())) {
+            std::make_unique<typename Interface::ResponseValidator_>(),
+            Interface::Name_)) {
       router()->SetMasterInterfaceName(Interface::Name_);
       proxy_ = std::make_unique<Proxy>(endpoint_client());
     }
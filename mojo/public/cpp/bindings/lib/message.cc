@@ -180,9 +180,11 @@ Message::Message(Message&& other)
       associated_endpoint_handles_(
           std::move(other.associated_endpoint_handles_)),
       transferable_(other.transferable_),
-      serialized_(other.serialized_) {
+      serialized_(other.serialized_),
+      receive_time_(other.receive_time_) {
   other.transferable_ = false;
   other.serialized_ = false;
+  other.receive_time_ = base::TimeTicks();
 }
 
 Message::Message(std::unique_ptr<internal::UnserializedMessageContext> context)
@@ -262,6 +264,8 @@ Message& Message::operator=(Message&& other) {
   other.transferable_ = false;
   serialized_ = other.serialized_;
   other.serialized_ = false;
+  receive_time_ = other.receive_time_;
+  other.receive_time_ = base::TimeTicks();
   return *this;
 }
 
@@ -272,6 +276,7 @@ void Message::Reset() {
   associated_endpoint_handles_.clear();
   transferable_ = false;
   serialized_ = false;
+  receive_time_ = base::TimeTicks();
 }
 
 const uint8_t* Message::payload() const {
@@ -15,32 +15,33 @@ namespace {
 
 // TODO(yzshen): Define a mojom struct for message header and use the generated
 // validation and data view code.
-bool IsValidMessageHeader(const internal::MessageHeader* header,
-                          internal::ValidationContext* validation_context) {
+bool IsValidMessageHeaderVersion(
+    const internal::MessageHeader* header,
+    internal::ValidationContext* validation_context) {
   // NOTE: Our goal is to preserve support for future extension of the message
   // header. If we encounter fields we do not understand, we must ignore them.
 
   // Extra validation of the struct header:
-  do {
-    if (header->version == 0) {
-      if (header->num_bytes == sizeof(internal::MessageHeader))
-        break;
-    } else if (header->version == 1) {
-      if (header->num_bytes == sizeof(internal::MessageHeaderV1))
-        break;
-    } else if (header->version == 2) {
-      if (header->num_bytes == sizeof(internal::MessageHeaderV2))
-        break;
-    } else if (header->version > 2) {
-      if (header->num_bytes >= sizeof(internal::MessageHeaderV2))
-        break;
-    }
-    internal::ReportValidationError(
-        validation_context,
-        internal::VALIDATION_ERROR_UNEXPECTED_STRUCT_HEADER);
-    return false;
-  } while (false);
+  if (header->version == 0) {
+    if (header->num_bytes == sizeof(internal::MessageHeader))
+      return true;
+  } else if (header->version == 1) {
+    if (header->num_bytes == sizeof(internal::MessageHeaderV1))
+      return true;
+  } else if (header->version == 2) {
+    if (header->num_bytes == sizeof(internal::MessageHeaderV2))
+      return true;
+  } else if (header->version > 2) {
+    if (header->num_bytes >= sizeof(internal::MessageHeaderV2))
+      return true;
+  }
+  internal::ReportValidationError(
+      validation_context, internal::VALIDATION_ERROR_UNEXPECTED_STRUCT_HEADER);
+  return false;
+}
 
+bool IsValidMessageHeader(const internal::MessageHeader* header,
+                          internal::ValidationContext* validation_context) {
   // Validate flags (allow unknown bits):
 
   // These flags require a RequestID.
@@ -125,14 +126,21 @@ bool MessageHeaderValidator::Accept(Message* message) {
   internal::ValidationContext validation_context(
       message->data(), message->data_num_bytes(), 0, 0, message, description_);
 
-  if (!internal::ValidateStructHeaderAndClaimMemory(message->data(),
-                                                    &validation_context))
-    return false;
-
-  if (!IsValidMessageHeader(message->header(), &validation_context))
-    return false;
+  // Most messages carry a header of version 0 or 1, which have a fixed layout
+  // without pointers, so the struct header checks collapse into one claim.
+  const void* data = message->data();
+  if (!internal::ClaimStructOfVersion(data, sizeof(internal::MessageHeader), 0,
+                                      &validation_context) &&
+      !internal::ClaimStructOfVersion(data, sizeof(internal::MessageHeaderV1),
+                                      1, &validation_context)) {
+    if (!internal::ValidateStructHeaderAndClaimMemory(data,
+                                                      &validation_context) ||
+        !IsValidMessageHeaderVersion(message->header(), &validation_context)) {
+      return false;
+    }
+  }
 
-  return true;
+  return IsValidMessageHeader(message->header(), &validation_context);
 }
 
 }  // namespace mojo
@@ -0,0 +1,261 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/public/cpp/bindings/message_traffic_profiler.h"
+
+#include <inttypes.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/metrics/histogram.h"
+#include "base/strings/stringprintf.h"
+#include "base/trace_event/memory_allocator_dump.h"
+#include "base/trace_event/memory_dump_manager.h"
+#include "base/trace_event/process_memory_dump.h"
+#include "mojo/public/cpp/bindings/message.h"
+
+namespace mojo {
+
+namespace {
+
+const int kMaxBytes = 64 * 1024 * 1024;
+const int kMaxLatencyUs = 10 * 1000 * 1000;
+const uint32_t kNumBuckets = 50;
+
+// Interface names are only known at runtime, so the histograms are local, and
+// not uploaded.
+base::HistogramBase* GetHistogram(const char* prefix,
+                                  const char* interface_name,
+                                  int max) {
+  return base::Histogram::FactoryGet(std::string(prefix) + interface_name, 1,
+                                     max, kNumBuckets,
+                                     base::HistogramBase::kNoFlags);
+}
+
+// Memory dump names may only contain some characters.
+std::string GetDumpName(const std::string& interface_name) {
+  std::string name = "mojo/message_traffic/";
+  for (char c : interface_name) {
+    bool allowed = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                   (c >= '0' && c <= '9') || c == '.' || c == '_';
+    name += allowed ? c : '_';
+  }
+  return name;
+}
+
+}  // namespace
+
+// static
+const char MessageTrafficProfiler::kLegacyIpcInterfaceName[] = "LegacyIPC";
+
+// static
+std::atomic<MessageTrafficProfiler*> MessageTrafficProfiler::g_profiler_{
+    nullptr};
+
+MessageTrafficProfiler::InterfaceStats::InterfaceStats() = default;
+
+MessageTrafficProfiler::InterfaceStats::InterfaceStats(
+    InterfaceStats&& other) = default;
+
+MessageTrafficProfiler::InterfaceStats::~InterfaceStats() = default;
+
+// static
+void MessageTrafficProfiler::Enable(uint32_t sampling_interval) {
+  DCHECK_GT(sampling_interval, 0u);
+  MessageTrafficProfiler* profiler =
+      new MessageTrafficProfiler(sampling_interval);
+  MessageTrafficProfiler* expected = nullptr;
+  bool enabled = g_profiler_.compare_exchange_strong(
+      expected, profiler, std::memory_order_acq_rel);
+  DCHECK(enabled) << "MessageTrafficProfiler is already enabled";
+  if (!enabled) {
+    delete profiler;
+    return;
+  }
+  base::trace_event::MemoryDumpManager::GetInstance()->RegisterDumpProvider(
+      profiler, "MojoMessageTraffic", nullptr);
+}
+
+// static
+void MessageTrafficProfiler::ResetForTesting() {
+  MessageTrafficProfiler* profiler =
+      g_profiler_.exchange(nullptr, std::memory_order_acq_rel);
+  if (!profiler)
+    return;
+  base::trace_event::MemoryDumpManager::GetInstance()->UnregisterDumpProvider(
+      profiler);
+  delete profiler;
+}
+
+MessageTrafficProfiler::MessageTrafficProfiler(uint32_t sampling_interval)
+    : sampling_interval_(sampling_interval) {}
+
+MessageTrafficProfiler::~MessageTrafficProfiler() = default;
+
+void MessageTrafficProfiler::RecordSentMessage(const char* interface_name,
+                                               const Message& message) {
+  Record(interface_name, message.name(), true, message.data_num_bytes(), 0,
+         base::nullopt);
+}
+
+void MessageTrafficProfiler::RecordDispatchedMessage(const char* interface_name,
+                                                     const Message& message) {
+  DCHECK(!message.receive_time().is_null());
+  Record(interface_name, message.name(), false, message.data_num_bytes(),
+         message.handles()->size() +
+             message.associated_endpoint_handles()->size(),
+         base::TimeTicks::Now() - message.receive_time());
+}
+
+void MessageTrafficProfiler::RecordLegacyIpcMessage(bool sent,
+                                                    uint32_t message_type,
+                                                    size_t num_bytes,
+                                                    size_t num_handles) {
+  Record(kLegacyIpcInterfaceName, message_type, sent, num_bytes, num_handles,
+         base::nullopt);
+}
+
+MessageTrafficProfiler::Snapshot MessageTrafficProfiler::GetSnapshot() {
+  Snapshot snapshot;
+  base::AutoLock lock(lock_);
+  for (const auto& interface : interfaces_) {
+    for (const auto& message : interface.second.messages) {
+      snapshot.emplace(std::make_pair(interface.first, message.first),
+                       message.second);
+    }
+  }
+  return snapshot;
+}
+
+std::string MessageTrafficProfiler::Dump() {
+  Snapshot snapshot = GetSnapshot();
+  std::vector<Snapshot::const_iterator> entries;
+  entries.reserve(snapshot.size());
+  for (auto it = snapshot.cbegin(); it != snapshot.cend(); ++it)
+    entries.push_back(it);
+  std::stable_sort(entries.begin(), entries.end(),
+                   [](Snapshot::const_iterator a, Snapshot::const_iterator b) {
+                     return a->second.sent_bytes + a->second.received_bytes >
+                            b->second.sent_bytes + b->second.received_bytes;
+                   });
+
+  std::string dump = base::StringPrintf(
+      "Mojo message traffic, 1 in %u messages sampled\n"
+      "interface message: sent (count, bytes), "
+      "received (count, bytes, handles), dispatch latency (avg, max us)\n",
+      sampling_interval_);
+  for (Snapshot::const_iterator entry : entries) {
+    const MessageStats& stats = entry->second;
+    base::StringAppendF(
+        &dump, "%s %" PRIu32 ": %" PRIu64 ", %" PRIu64 "; %" PRIu64
+               ", %" PRIu64 ", %" PRIu64,
+        entry->first.first.c_str(), entry->first.second, stats.sent_count,
+        stats.sent_bytes, stats.received_count, stats.received_bytes,
+        stats.received_handles);
+    if (!stats.max_dispatch_latency.is_zero()) {
+      base::StringAppendF(
+          &dump, "; %" PRId64 ", %" PRId64,
+          (stats.total_dispatch_latency / stats.received_count)
+              .InMicroseconds(),
+          stats.max_dispatch_latency.InMicroseconds());
+    }
+    dump += '\n';
+  }
+  return dump;
+}
+
+bool MessageTrafficProfiler::OnMemoryDump(
+    const base::trace_event::MemoryDumpArgs& args,
+    base::trace_event::ProcessMemoryDump* pmd) {
+  using base::trace_event::MemoryAllocatorDump;
+  if (args.level_of_detail !=
+      base::trace_event::MemoryDumpLevelOfDetail::DETAILED) {
+    return true;
+  }
+
+  base::AutoLock lock(lock_);
+  for (const auto& interface : interfaces_) {
+    MessageStats totals;
+    for (const auto& message : interface.second.messages) {
+      totals.sent_count += message.second.sent_count;
+      totals.sent_bytes += message.second.sent_bytes;
+      totals.received_count += message.second.received_count;
+      totals.received_bytes += message.second.received_bytes;
+    }
+    // The traffic isn't memory, so it is not reported as the dump's size.
+    MemoryAllocatorDump* dump =
+        pmd->CreateAllocatorDump(GetDumpName(interface.first));
+    dump->AddScalar("sent_count", MemoryAllocatorDump::kUnitsObjects,
+                    totals.sent_count);
+    dump->AddScalar("sent_bytes", MemoryAllocatorDump::kUnitsBytes,
+                    totals.sent_bytes);
+    dump->AddScalar("received_count", MemoryAllocatorDump::kUnitsObjects,
+                    totals.received_count);
+    dump->AddScalar("received_bytes", MemoryAllocatorDump::kUnitsBytes,
+                    totals.received_bytes);
+  }
+  return true;
+}
+
+MessageTrafficProfiler::InterfaceStats*
+MessageTrafficProfiler::GetInterfaceStats(const char* interface_name) {
+  lock_.AssertAcquired();
+  auto it = interfaces_.find(interface_name);
+  if (it != interfaces_.end())
+    return &it->second;
+
+  InterfaceStats stats;
+  stats.sent_bytes_histogram =
+      GetHistogram("Mojo.Traffic.SentBytes.", interface_name, kMaxBytes);
+  stats.received_bytes_histogram =
+      GetHistogram("Mojo.Traffic.ReceivedBytes.", interface_name, kMaxBytes);
+  stats.dispatch_latency_histogram = GetHistogram(
+      "Mojo.Traffic.DispatchLatencyUs.", interface_name, kMaxLatencyUs);
+  return &interfaces_.emplace(interface_name, std::move(stats))
+              .first->second;
+}
+
+void MessageTrafficProfiler::Record(
+    const char* interface_name,
+    uint32_t message_name,
+    bool sent,
+    size_t num_bytes,
+    size_t num_handles,
+    base::Optional<base::TimeDelta> dispatch_latency) {
+  base::HistogramBase* bytes_histogram;
+  base::HistogramBase* latency_histogram = nullptr;
+  {
+    base::AutoLock lock(lock_);
+    InterfaceStats* interface = GetInterfaceStats(interface_name);
+    MessageStats& stats = interface->messages[message_name];
+    if (sent) {
+      ++stats.sent_count;
+      stats.sent_bytes += num_bytes;
+      bytes_histogram = interface->sent_bytes_histogram;
+    } else {
+      ++stats.received_count;
+      stats.received_bytes += num_bytes;
+      stats.received_handles += num_handles;
+      bytes_histogram = interface->received_bytes_histogram;
+      if (dispatch_latency) {
+        stats.total_dispatch_latency += *dispatch_latency;
+        stats.max_dispatch_latency =
+            std::max(stats.max_dispatch_latency, *dispatch_latency);
+        latency_histogram = interface->dispatch_latency_histogram;
+      }
+    }
+  }
+
+  // Histograms are thread-safe, and live as long as the process.
+  bytes_histogram->Add(
+      static_cast<int>(std::min<size_t>(num_bytes, kMaxBytes)));
+  if (latency_histogram) {
+    latency_histogram->Add(static_cast<int>(std::min<int64_t>(
+        dispatch_latency->InMicroseconds(), kMaxLatencyUs)));
+  }
+}
+
+}  // namespace mojo
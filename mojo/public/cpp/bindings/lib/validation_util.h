@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 
+#include "base/logging.h"
 #include "mojo/public/cpp/bindings/bindings_export.h"
 #include "mojo/public/cpp/bindings/lib/bindings_internal.h"
 #include "mojo/public/cpp/bindings/lib/serialization_util.h"
@@ -57,6 +58,28 @@ MOJO_CPP_BINDINGS_EXPORT bool ValidateStructHeaderAndClaimMemory(
     const void* data,
     ValidationContext* validation_context);
 
+// Fast path for structs whose expected version has a fixed layout: if |data|
+// holds a struct header of exactly |version| and |num_bytes|, claims the
+// struct's memory and returns true. This folds the checks of
+// ValidateStructHeaderAndClaimMemory() and the version size check into a
+// single pass for the common case where both ends use the same version.
+// Returns false without reporting an error otherwise, and leaves
+// |validation_context| untouched, so that the caller can fall back to the
+// general checks.
+inline bool ClaimStructOfVersion(const void* data,
+                                 uint32_t num_bytes,
+                                 uint32_t version,
+                                 ValidationContext* validation_context) {
+  DCHECK_GE(num_bytes, sizeof(StructHeader));
+  // Neither check reads |data|, so both are evaluated without branching.
+  if (!IsAligned(data) | !validation_context->IsValidRange(data, num_bytes))
+    return false;
+  const StructHeader* header = static_cast<const StructHeader*>(data);
+  if ((header->num_bytes ^ num_bytes) | (header->version ^ version))
+    return false;
+  return validation_context->ClaimMemory(data, num_bytes);
+}
+
 // Validates that |data| contains a valid union header, in terms of alignment
 // and size. It checks that the memory range [data, data + kUnionDataSize) is
 // not marked as occupied by other objects in |validation_context|. On success,
@@ -16,6 +16,7 @@
 #include "base/callback.h"
 #include "base/compiler_specific.h"
 #include "base/logging.h"
+#include "base/time/time.h"
 #include "mojo/public/cpp/bindings/bindings_export.h"
 #include "mojo/public/cpp/bindings/lib/buffer.h"
 #include "mojo/public/cpp/bindings/lib/message_internal.h"
@@ -144,6 +145,13 @@ class MOJO_CPP_BINDINGS_EXPORT Message {
     header_v1()->request_id = request_id;
   }
 
+  // The time at which this message was read from its message pipe, if it was
+  // sampled by the MessageTrafficProfiler. Null otherwise.
+  base::TimeTicks receive_time() const { return receive_time_; }
+  void set_receive_time(base::TimeTicks receive_time) {
+    receive_time_ = receive_time;
+  }
+
   // Access the payload.
   const uint8_t* payload() const;
   uint8_t* mutable_payload() { return const_cast<uint8_t*>(payload()); }
@@ -229,6 +237,8 @@ class MOJO_CPP_BINDINGS_EXPORT Message {
   // Indicates whether this Message object is serialized.
   bool serialized_ = false;
 
+  base::TimeTicks receive_time_;
+
   DISALLOW_COPY_AND_ASSIGN(Message);
 };
 
@@ -0,0 +1,180 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_PUBLIC_CPP_BINDINGS_MESSAGE_TRAFFIC_PROFILER_H_
+#define MOJO_PUBLIC_CPP_BINDINGS_MESSAGE_TRAFFIC_PROFILER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "base/macros.h"
+#include "base/optional.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+#include "base/trace_event/memory_dump_provider.h"
+#include "mojo/public/cpp/bindings/bindings_export.h"
+
+namespace base {
+class HistogramBase;
+}
+
+namespace mojo {
+
+class Message;
+
+// Process-wide statistics of the messages sent and dispatched by mojo bindings,
+// and of the legacy IPC messages sent and received by IPC::ChannelMojo, kept
+// per interface and message name. It is off unless the embedder calls Enable(),
+// and then records one in every |sampling_interval| messages of each path, so
+// that it is cheap enough to leave on. Content enables it in every process with
+// the MojoMessageTrafficProfiler feature.
+//
+// Each sampled message is recorded into local histograms, which are not
+// uploaded, named after its interface:
+//   Mojo.Traffic.SentBytes.<interface>
+//   Mojo.Traffic.ReceivedBytes.<interface>
+//   Mojo.Traffic.DispatchLatencyUs.<interface>
+// The dispatch latency is the time from when the message is read from its
+// message pipe to when its endpoint starts dispatching it, i.e. the time it
+// spends queued in this process. There is no send time on the wire to measure
+// the time spent in transit.
+//
+// The per-interface counters are reported to memory-infra under
+// mojo/message_traffic/<interface> in detailed dumps, e.g. when tracing with
+// the memory-infra category. The per-message counters are available locally
+// through GetSnapshot() and Dump(), e.g. to log the busiest messages.
+//
+// Messages to a peer in the same process may never be serialized, in which case
+// only their header is counted. Legacy IPC messages are recorded under
+// |kLegacyIpcInterfaceName|, with their message type as name, on top of the
+// IPC.mojom.Channel messages which carry them.
+//
+// This class is thread-safe.
+class MOJO_CPP_BINDINGS_EXPORT MessageTrafficProfiler
+    : public base::trace_event::MemoryDumpProvider {
+ public:
+  static const char kLegacyIpcInterfaceName[];
+
+  // The counters of the sampled messages of one name.
+  struct MessageStats {
+    uint64_t sent_count = 0;
+    uint64_t sent_bytes = 0;
+    uint64_t received_count = 0;
+    uint64_t received_bytes = 0;
+    uint64_t received_handles = 0;
+    // Over the received messages. Legacy IPC messages have none.
+    base::TimeDelta total_dispatch_latency;
+    base::TimeDelta max_dispatch_latency;
+  };
+
+  // Keyed by interface name and message name.
+  using Snapshot = std::map<std::pair<std::string, uint32_t>, MessageStats>;
+
+  // The paths which messages are sampled on, each with its own counter, so
+  // that one path's traffic doesn't skew which messages of another are
+  // sampled.
+  enum class SamplePath {
+    kSent,
+    kReceived,
+    kLegacyIpc,
+  };
+
+  // Enables the profiler for the rest of the process' lifetime, sampling one in
+  // every |sampling_interval| messages. Must be called at most once.
+  static void Enable(uint32_t sampling_interval);
+
+  // Returns the profiler, or null if it isn't enabled. This is a single memory
+  // load, for use on every message.
+  static MessageTrafficProfiler* Get() {
+    return g_profiler_.load(std::memory_order_acquire);
+  }
+
+  // Disables and destroys the profiler. Nothing may be using it.
+  static void ResetForTesting();
+
+  // Returns whether the next message on |path| should be recorded. Incoming
+  // messages are sampled when they are read, and only recorded if they carry a
+  // receive time (see Message::receive_time()).
+  bool ShouldSample(SamplePath path) {
+    return sample_counters_[static_cast<size_t>(path)].fetch_add(
+               1, std::memory_order_relaxed) %
+               sampling_interval_ ==
+           0;
+  }
+
+  // Records a sampled outgoing message.
+  void RecordSentMessage(const char* interface_name, const Message& message);
+
+  // Records the dispatch of an incoming message with a receive time.
+  void RecordDispatchedMessage(const char* interface_name,
+                               const Message& message);
+
+  // Records a sampled legacy IPC message of type |message_type|.
+  void RecordLegacyIpcMessage(bool sent,
+                              uint32_t message_type,
+                              size_t num_bytes,
+                              size_t num_handles);
+
+  uint32_t sampling_interval() const { return sampling_interval_; }
+
+  Snapshot GetSnapshot();
+
+  // Returns a human-readable table of the recorded messages, busiest first.
+  std::string Dump();
+
+  // base::trace_event::MemoryDumpProvider implementation.
+  bool OnMemoryDump(const base::trace_event::MemoryDumpArgs& args,
+                    base::trace_event::ProcessMemoryDump* pmd) override;
+
+ private:
+  struct InterfaceStats {
+    InterfaceStats();
+    InterfaceStats(InterfaceStats&& other);
+    ~InterfaceStats();
+
+    base::HistogramBase* sent_bytes_histogram = nullptr;
+    base::HistogramBase* received_bytes_histogram = nullptr;
+    base::HistogramBase* dispatch_latency_histogram = nullptr;
+    std::map<uint32_t, MessageStats> messages;
+  };
+
+  explicit MessageTrafficProfiler(uint32_t sampling_interval);
+  ~MessageTrafficProfiler() override;
+
+  // Returns the stats of |interface_name|, creating them if needed. |lock_|
+  // must be held.
+  InterfaceStats* GetInterfaceStats(const char* interface_name);
+
+  void Record(const char* interface_name,
+              uint32_t message_name,
+              bool sent,
+              size_t num_bytes,
+              size_t num_handles,
+              base::Optional<base::TimeDelta> dispatch_latency);
+
+  static std::atomic<MessageTrafficProfiler*> g_profiler_;
+
+  static constexpr size_t kNumSamplePaths =
+      static_cast<size_t>(SamplePath::kLegacyIpc) + 1;
+
+  const uint32_t sampling_interval_;
+  std::atomic<uint32_t> sample_counters_[kNumSamplePaths] = {};
+
+  base::Lock lock_;
+  // Interface names are compared as strings, and may be looked up without
+  // copying them.
+  std::map<std::string, InterfaceStats, std::less<>> interfaces_;
+
+  DISALLOW_COPY_AND_ASSIGN(MessageTrafficProfiler);
+};
+
+}  // namespace mojo
+
+#endif  // MOJO_PUBLIC_CPP_BINDINGS_MESSAGE_TRAFFIC_PROFILER_H_
@@ -0,0 +1,173 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/public/cpp/bindings/message_traffic_profiler.h"
+
+#include <stdint.h>
+
+#include <string>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/trace_event/memory_allocator_dump.h"
+#include "base/trace_event/process_memory_dump.h"
+#include "mojo/public/cpp/bindings/binding.h"
+#include "mojo/public/cpp/bindings/message.h"
+#include "mojo/public/interfaces/bindings/tests/math_calculator.mojom.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace test {
+namespace {
+
+using MessageStats = MessageTrafficProfiler::MessageStats;
+
+typedef base::Callback<void(double)> CalcCallback;
+
+class CalculatorImpl : public math::Calculator {
+ public:
+  explicit CalculatorImpl(math::CalculatorRequest request)
+      : binding_(this, std::move(request)) {}
+  ~CalculatorImpl() override {}
+
+  void Clear(const CalcCallback& callback) override { callback.Run(0.0); }
+
+  void Add(double value, const CalcCallback& callback) override {
+    callback.Run(value);
+  }
+
+  void Multiply(double value, const CalcCallback& callback) override {
+    callback.Run(0.0);
+  }
+
+ private:
+  Binding<math::Calculator> binding_;
+
+  DISALLOW_COPY_AND_ASSIGN(CalculatorImpl);
+};
+
+class MessageTrafficProfilerTest : public testing::Test {
+ public:
+  MessageTrafficProfilerTest() {}
+  ~MessageTrafficProfilerTest() override {
+    MessageTrafficProfiler::ResetForTesting();
+  }
+
+ private:
+  base::MessageLoop message_loop_;
+
+  DISALLOW_COPY_AND_ASSIGN(MessageTrafficProfilerTest);
+};
+
+TEST_F(MessageTrafficProfilerTest, DisabledByDefault) {
+  EXPECT_FALSE(MessageTrafficProfiler::Get());
+}
+
+TEST_F(MessageTrafficProfilerTest, Sampling) {
+  MessageTrafficProfiler::Enable(3);
+  MessageTrafficProfiler* profiler = MessageTrafficProfiler::Get();
+  ASSERT_TRUE(profiler);
+  using SamplePath = MessageTrafficProfiler::SamplePath;
+  EXPECT_TRUE(profiler->ShouldSample(SamplePath::kSent));
+  EXPECT_FALSE(profiler->ShouldSample(SamplePath::kSent));
+  EXPECT_FALSE(profiler->ShouldSample(SamplePath::kSent));
+  EXPECT_TRUE(profiler->ShouldSample(SamplePath::kSent));
+
+  // Each path samples its own messages, whatever the traffic on the others.
+  EXPECT_TRUE(profiler->ShouldSample(SamplePath::kReceived));
+  EXPECT_TRUE(profiler->ShouldSample(SamplePath::kLegacyIpc));
+  EXPECT_FALSE(profiler->ShouldSample(SamplePath::kReceived));
+  EXPECT_FALSE(profiler->ShouldSample(SamplePath::kSent));
+  EXPECT_FALSE(profiler->ShouldSample(SamplePath::kReceived));
+  EXPECT_TRUE(profiler->ShouldSample(SamplePath::kReceived));
+}
+
+TEST_F(MessageTrafficProfilerTest, RecordMessages) {
+  MessageTrafficProfiler::Enable(1);
+  MessageTrafficProfiler* profiler = MessageTrafficProfiler::Get();
+
+  Message message(7, 0, 16, 0, nullptr);
+  profiler->RecordSentMessage("Foo", message);
+  profiler->RecordSentMessage("Foo", message);
+  message.set_receive_time(base::TimeTicks::Now() -
+                           base::TimeDelta::FromMilliseconds(5));
+  profiler->RecordDispatchedMessage("Foo", message);
+  profiler->RecordLegacyIpcMessage(false, 42, 100, 2);
+
+  MessageTrafficProfiler::Snapshot snapshot = profiler->GetSnapshot();
+  ASSERT_EQ(2u, snapshot.size());
+
+  const MessageStats& foo = snapshot[std::make_pair(std::string("Foo"), 7u)];
+  EXPECT_EQ(2u, foo.sent_count);
+  EXPECT_EQ(2 * message.data_num_bytes(), foo.sent_bytes);
+  EXPECT_EQ(1u, foo.received_count);
+  EXPECT_EQ(message.data_num_bytes(), foo.received_bytes);
+  EXPECT_EQ(0u, foo.received_handles);
+  EXPECT_GE(foo.max_dispatch_latency, base::TimeDelta::FromMilliseconds(5));
+  EXPECT_EQ(foo.max_dispatch_latency, foo.total_dispatch_latency);
+
+  const MessageStats& ipc = snapshot[std::make_pair(
+      std::string(MessageTrafficProfiler::kLegacyIpcInterfaceName), 42u)];
+  EXPECT_EQ(0u, ipc.sent_count);
+  EXPECT_EQ(1u, ipc.received_count);
+  EXPECT_EQ(100u, ipc.received_bytes);
+  EXPECT_EQ(2u, ipc.received_handles);
+  EXPECT_TRUE(ipc.max_dispatch_latency.is_zero());
+
+  std::string dump = profiler->Dump();
+  EXPECT_NE(std::string::npos, dump.find("Foo 7: 2,"));
+  EXPECT_NE(std::string::npos, dump.find("LegacyIPC 42: 0, 0; 1, 100, 2\n"));
+}
+
+TEST_F(MessageTrafficProfilerTest, OnMemoryDump) {
+  MessageTrafficProfiler::Enable(1);
+  MessageTrafficProfiler* profiler = MessageTrafficProfiler::Get();
+  Message message(7, 0, 16, 0, nullptr);
+  profiler->RecordSentMessage("foo.mojom.Foo", message);
+  profiler->RecordLegacyIpcMessage(false, 42, 100, 2);
+
+  base::trace_event::MemoryDumpArgs args = {
+      base::trace_event::MemoryDumpLevelOfDetail::DETAILED};
+  base::trace_event::ProcessMemoryDump pmd(nullptr, args);
+  ASSERT_TRUE(profiler->OnMemoryDump(args, &pmd));
+  EXPECT_EQ(2u, pmd.allocator_dumps().size());
+  EXPECT_TRUE(pmd.GetAllocatorDump("mojo/message_traffic/foo.mojom.Foo"));
+  EXPECT_TRUE(pmd.GetAllocatorDump("mojo/message_traffic/LegacyIPC"));
+
+  // Background dumps only take whitelisted names.
+  args.level_of_detail = base::trace_event::MemoryDumpLevelOfDetail::BACKGROUND;
+  base::trace_event::ProcessMemoryDump background_pmd(nullptr, args);
+  ASSERT_TRUE(profiler->OnMemoryDump(args, &background_pmd));
+  EXPECT_TRUE(background_pmd.allocator_dumps().empty());
+}
+
+TEST_F(MessageTrafficProfilerTest, RecordsInterfaceTraffic) {
+  MessageTrafficProfiler::Enable(1);
+
+  math::CalculatorPtr calculator;
+  CalculatorImpl impl(MakeRequest(&calculator));
+  base::RunLoop run_loop;
+  calculator->Add(1.0, base::Bind([](const base::Closure& quit,
+                                     double total) { quit.Run(); },
+                                  run_loop.QuitClosure()));
+  run_loop.Run();
+
+  // Both ends are in this process, so the request and the response are each
+  // sent and dispatched once.
+  uint64_t sent_count = 0;
+  uint64_t received_count = 0;
+  for (const auto& entry : MessageTrafficProfiler::Get()->GetSnapshot()) {
+    EXPECT_EQ(math::Calculator::Name_, entry.first.first);
+    sent_count += entry.second.sent_count;
+    received_count += entry.second.received_count;
+  }
+  EXPECT_EQ(2u, sent_count);
+  EXPECT_EQ(2u, received_count);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace mojo
@@ -9,6 +9,7 @@
 
 #include "mojo/public/cpp/bindings/lib/serialization_util.h"
 #include "mojo/public/cpp/bindings/lib/validation_context.h"
+#include "mojo/public/cpp/bindings/lib/validation_util.h"
 #include "mojo/public/cpp/system/core.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -292,6 +293,41 @@ TEST(ValidationContextTest, ClaimMemory) {
   }
 }
 
+TEST(ValidationContextTest, ClaimStructOfVersion) {
+  uint64_t data[4] = {};
+  auto* header = reinterpret_cast<internal::StructHeader*>(data);
+  header->num_bytes = 24;
+  header->version = 1;
+
+  {
+    internal::ValidationContext context(data, sizeof(data), 0, 0);
+
+    // Other versions and sizes are left to the general checks, and don't
+    // claim anything.
+    EXPECT_FALSE(internal::ClaimStructOfVersion(data, 24, 0, &context));
+    EXPECT_FALSE(internal::ClaimStructOfVersion(data, 16, 1, &context));
+    EXPECT_TRUE(context.IsValidRange(data, sizeof(data)));
+
+    EXPECT_TRUE(internal::ClaimStructOfVersion(data, 24, 1, &context));
+    EXPECT_FALSE(context.IsValidRange(data, 24));
+    EXPECT_TRUE(context.IsValidRange(data + 3, 8));
+  }
+
+  {
+    // The struct doesn't fit in the valid range.
+    internal::ValidationContext context(data, 16, 0, 0);
+    EXPECT_FALSE(internal::ClaimStructOfVersion(data, 24, 1, &context));
+  }
+
+  {
+    // The struct is misaligned.
+    const char* misaligned = reinterpret_cast<const char*>(data) + 4;
+    internal::ValidationContext context(misaligned, 28, 0, 0);
+    EXPECT_FALSE(internal::ClaimStructOfVersion(misaligned, 24, 1, &context));
+    EXPECT_TRUE(context.IsValidRange(misaligned, 28));
+  }
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace mojo
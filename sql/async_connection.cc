@@ -0,0 +1,161 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sql/async_connection.h"
+
+#include "base/logging.h"
+#include "base/task_runner_util.h"
+#include "base/task_scheduler/post_task.h"
+
+namespace sql {
+
+namespace {
+
+scoped_refptr<base::SequencedTaskRunner> CreateTaskRunner(
+    base::TaskShutdownBehavior shutdown_behavior) {
+  return base::CreateSequencedTaskRunnerWithTraits(
+      {base::MayBlock(), base::TaskPriority::USER_VISIBLE, shutdown_behavior});
+}
+
+bool OpenConnection(Connection* db,
+                    const base::FilePath& path,
+                    const AsyncConnection::ConfigureCallback& configure,
+                    bool read_only) {
+  if (!configure.is_null())
+    configure.Run(db);
+  // The readers share the database file with the writer, so an exclusive lock
+  // would lock them all out, and every read would fall back to the writer.
+  if (db->exclusive_locking()) {
+    DLOG(ERROR) << "AsyncConnection does not support exclusive locking";
+    return false;
+  }
+  db->set_wal_mode();
+  if (read_only)
+    db->set_read_only();
+  return db->Open(path);
+}
+
+// Runs |task| on a connection's sequence, then |done| on |done_task_runner|.
+void RunTask(base::OnceCallback<void(Connection*)> task,
+             Connection* db,
+             scoped_refptr<base::SequencedTaskRunner> done_task_runner,
+             base::OnceClosure done) {
+  std::move(task).Run(db);
+  done_task_runner->PostTask(FROM_HERE, std::move(done));
+}
+
+}  // namespace
+
+struct AsyncConnection::Reader {
+  explicit Reader(scoped_refptr<base::SequencedTaskRunner> task_runner)
+      : task_runner(task_runner),
+        connection(new Connection, base::OnTaskRunnerDeleter(task_runner)) {}
+
+  scoped_refptr<base::SequencedTaskRunner> task_runner;
+  std::unique_ptr<Connection, base::OnTaskRunnerDeleter> connection;
+
+  // Reads are only sent to the reader once its connection is open.
+  bool is_open = false;
+  int pending_reads = 0;
+};
+
+AsyncConnection::AsyncConnection(size_t num_readers,
+                                 const ConfigureCallback& configure)
+    : configure_(configure),
+      // Writes aren't dropped on shutdown, whereas reads only have callers to
+      // reply to while the browser runs.
+      writer_task_runner_(
+          CreateTaskRunner(base::TaskShutdownBehavior::BLOCK_SHUTDOWN)),
+      writer_(new Connection, base::OnTaskRunnerDeleter(writer_task_runner_)),
+      weak_factory_(this) {
+  for (size_t i = 0; i < num_readers; ++i) {
+    readers_.push_back(std::make_unique<Reader>(
+        CreateTaskRunner(base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN)));
+  }
+}
+
+AsyncConnection::~AsyncConnection() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+}
+
+void AsyncConnection::Open(const base::FilePath& path,
+                           base::OnceCallback<void(bool)> callback) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  DCHECK(path_.empty());
+  path_ = path;
+  base::PostTaskAndReplyWithResult(
+      writer_task_runner_.get(), FROM_HERE,
+      base::BindOnce(&OpenConnection, base::Unretained(writer_.get()), path,
+                     configure_, false /* read_only */),
+      base::BindOnce(&AsyncConnection::DidOpenWriter,
+                     weak_factory_.GetWeakPtr(), std::move(callback)));
+}
+
+void AsyncConnection::RunReply(base::OnceClosure reply) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  std::move(reply).Run();
+}
+
+void AsyncConnection::PostRead(Task task) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  Reader* reader = nullptr;
+  for (const auto& candidate : readers_) {
+    if (candidate->is_open &&
+        (!reader || candidate->pending_reads < reader->pending_reads)) {
+      reader = candidate.get();
+    }
+  }
+  if (!reader) {
+    PostWrite(std::move(task));
+    return;
+  }
+
+  ++reader->pending_reads;
+  reader->task_runner->PostTask(
+      FROM_HERE,
+      base::BindOnce(&RunTask, std::move(task),
+                     base::Unretained(reader->connection.get()),
+                     base::SequencedTaskRunnerHandle::Get(),
+                     base::BindOnce(&AsyncConnection::DidRead,
+                                    weak_factory_.GetWeakPtr(), reader)));
+}
+
+void AsyncConnection::PostWrite(Task task) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  writer_task_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(std::move(task), base::Unretained(writer_.get())));
+}
+
+void AsyncConnection::DidOpenWriter(base::OnceCallback<void(bool)> callback,
+                                    bool success) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  // The readers rely on the writer having switched the database to WAL mode.
+  if (success) {
+    for (const auto& reader : readers_) {
+      base::PostTaskAndReplyWithResult(
+          reader->task_runner.get(), FROM_HERE,
+          base::BindOnce(&OpenConnection,
+                         base::Unretained(reader->connection.get()), path_,
+                         configure_, true /* read_only */),
+          base::BindOnce(&AsyncConnection::DidOpenReader,
+                         weak_factory_.GetWeakPtr(), reader.get()));
+    }
+  }
+  std::move(callback).Run(success);
+}
+
+void AsyncConnection::DidOpenReader(Reader* reader, bool success) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  // Reads keep going to the writer if the reader can't be opened.
+  reader->is_open = success;
+}
+
+void AsyncConnection::DidRead(Reader* reader) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  DCHECK_GT(reader->pending_reads, 0);
+  --reader->pending_reads;
+}
+
+}  // namespace sql
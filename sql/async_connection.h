@@ -0,0 +1,188 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SQL_ASYNC_CONNECTION_H_
+#define SQL_ASYNC_CONNECTION_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/callback.h"
+#include "base/files/file_path.h"
+#include "base/location.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
+#include "base/sequence_checker.h"
+#include "base/sequenced_task_runner.h"
+#include "base/threading/sequenced_task_runner_handle.h"
+#include "sql/connection.h"
+#include "sql/sql_export.h"
+#include "sql/statement.h"
+
+namespace sql {
+
+// Runs queries on background sequences, so that callers don't block on disk
+// I/O, and so that long reads and writes don't wait for each other.
+//
+// Writes run in order on the only read-write connection.  Reads run on a pool
+// of read-only connections with a sequence each, and fall back to the writer
+// until those are open.  The database uses write-ahead logging, so a read sees
+// the database as of when its statement started, without locking out writes.
+// Reads which must see the writes issued before them should use Write().
+//
+// The tasks passed to Read() and Write() run on a connection's sequence, and
+// must not keep the Connection or its statements.  Their replies run on the
+// calling sequence, unless the AsyncConnection is destroyed first.
+//
+// This class must be used on a single sequence.
+class SQL_EXPORT AsyncConnection {
+ public:
+  // Configures a connection before it is opened, e.g. its page size and
+  // histogram tag.  Runs on the connection's sequence.  It must not enable
+  // exclusive locking, which would lock the readers out; Open() fails if it
+  // does.
+  using ConfigureCallback = base::RepeatingCallback<void(Connection*)>;
+
+  // Serves reads with |num_readers| read-only connections.  With none, reads
+  // run on the writer.
+  AsyncConnection(size_t num_readers, const ConfigureCallback& configure);
+
+  // Closes the connections on their sequences, after their pending tasks.
+  ~AsyncConnection();
+
+  // Opens the database at |path|, and replies with whether it could be opened
+  // for writing.  Reads and writes issued meanwhile run once it is open.
+  void Open(const base::FilePath& path,
+            base::OnceCallback<void(bool)> callback);
+
+  // Runs |task| on a reader, and replies with its result.
+  template <typename ResultType>
+  void Read(base::OnceCallback<ResultType(Connection*)> task,
+            base::OnceCallback<void(ResultType)> reply) {
+    PostRead(BindTaskAndReply(std::move(task), std::move(reply)));
+  }
+
+  // Runs |task| on the writer, after the writes issued before, and replies
+  // with its result.
+  template <typename ResultType>
+  void Write(base::OnceCallback<ResultType(Connection*)> task,
+             base::OnceCallback<void(ResultType)> reply) {
+    PostWrite(BindTaskAndReply(std::move(task), std::move(reply)));
+  }
+
+  // Runs the statement |sql| on a reader, identified by |id| as for
+  // Connection::GetCachedStatement().  |bind| binds its parameters, and
+  // |read_row| converts each row.  Rather than each row, batches of up to
+  // |batch_size| rows are sent to |on_rows|, so that the results of long reads
+  // can be used as they come without a thread hop per row.  The last batch has
+  // |done| set, and may be empty.
+  template <typename RowType>
+  void ReadRows(
+      const StatementID& id,
+      const char* sql,
+      base::OnceCallback<void(Statement*)> bind,
+      base::RepeatingCallback<RowType(const Statement&)> read_row,
+      size_t batch_size,
+      base::RepeatingCallback<void(std::vector<RowType>, bool done)> on_rows) {
+    DCHECK_GT(batch_size, 0u);
+    PostRead(base::BindOnce(
+        &AsyncConnection::StepRows<RowType>, weak_factory_.GetWeakPtr(),
+        base::SequencedTaskRunnerHandle::Get(), id, sql, std::move(bind),
+        std::move(read_row), batch_size, std::move(on_rows)));
+  }
+
+ private:
+  struct Reader;
+
+  using Task = base::OnceCallback<void(Connection*)>;
+
+  template <typename ResultType>
+  Task BindTaskAndReply(base::OnceCallback<ResultType(Connection*)> task,
+                        base::OnceCallback<void(ResultType)> reply) {
+    return base::BindOnce(&AsyncConnection::RunTaskAndReply<ResultType>,
+                          weak_factory_.GetWeakPtr(),
+                          base::SequencedTaskRunnerHandle::Get(),
+                          std::move(task), std::move(reply));
+  }
+
+  // Runs on a connection's sequence.
+  template <typename ResultType>
+  static void RunTaskAndReply(
+      base::WeakPtr<AsyncConnection> connection,
+      scoped_refptr<base::SequencedTaskRunner> reply_task_runner,
+      base::OnceCallback<ResultType(Connection*)> task,
+      base::OnceCallback<void(ResultType)> reply,
+      Connection* db) {
+    ResultType result = std::move(task).Run(db);
+    reply_task_runner->PostTask(
+        FROM_HERE,
+        base::BindOnce(&AsyncConnection::RunReply, connection,
+                       base::BindOnce(std::move(reply), std::move(result))));
+  }
+
+  // Runs on a reader's sequence.
+  template <typename RowType>
+  static void StepRows(
+      base::WeakPtr<AsyncConnection> connection,
+      scoped_refptr<base::SequencedTaskRunner> reply_task_runner,
+      const StatementID& id,
+      const char* sql,
+      base::OnceCallback<void(Statement*)> bind,
+      base::RepeatingCallback<RowType(const Statement&)> read_row,
+      size_t batch_size,
+      base::RepeatingCallback<void(std::vector<RowType>, bool)> on_rows,
+      Connection* db) {
+    Statement statement(db->GetCachedStatement(id, sql));
+    std::move(bind).Run(&statement);
+    std::vector<RowType> rows;
+    while (statement.Step()) {
+      rows.push_back(read_row.Run(statement));
+      if (rows.size() < batch_size)
+        continue;
+      reply_task_runner->PostTask(
+          FROM_HERE, base::BindOnce(&AsyncConnection::RunReply, connection,
+                                    base::BindOnce(on_rows, std::move(rows),
+                                                   false /* done */)));
+      rows = std::vector<RowType>();
+    }
+    reply_task_runner->PostTask(
+        FROM_HERE,
+        base::BindOnce(
+            &AsyncConnection::RunReply, connection,
+            base::BindOnce(on_rows, std::move(rows), true /* done */)));
+  }
+
+  void RunReply(base::OnceClosure reply);
+
+  // Runs |task| on the reader with the fewest pending reads, or on the writer
+  // if no reader is open.
+  void PostRead(Task task);
+  void PostWrite(Task task);
+
+  void DidOpenWriter(base::OnceCallback<void(bool)> callback, bool success);
+  void DidOpenReader(Reader* reader, bool success);
+  void DidRead(Reader* reader);
+
+  const ConfigureCallback configure_;
+  base::FilePath path_;
+
+  scoped_refptr<base::SequencedTaskRunner> writer_task_runner_;
+  std::unique_ptr<Connection, base::OnTaskRunnerDeleter> writer_;
+  std::vector<std::unique_ptr<Reader>> readers_;
+
+  SEQUENCE_CHECKER(sequence_checker_);
+
+  base::WeakPtrFactory<AsyncConnection> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncConnection);
+};
+
+}  // namespace sql
+
+#endif  // SQL_ASYNC_CONNECTION_H_
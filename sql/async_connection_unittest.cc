@@ -0,0 +1,221 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sql/async_connection.h"
+
+#include <memory>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/macros.h"
+#include "base/run_loop.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/test/scoped_task_environment.h"
+#include "base/threading/thread_restrictions.h"
+#include "sql/connection.h"
+#include "sql/statement.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/sqlite/sqlite3.h"
+
+namespace sql {
+
+namespace {
+
+bool CreateTable(Connection* db) {
+  return db->Execute("CREATE TABLE foo (id INTEGER PRIMARY KEY, value TEXT)");
+}
+
+bool InsertRows(int count, Connection* db) {
+  for (int i = 0; i < count; ++i) {
+    if (!db->Execute("INSERT INTO foo (value) VALUES ('bar')"))
+      return false;
+  }
+  return true;
+}
+
+int CountRows(Connection* db) {
+  Statement s(db->GetUniqueStatement("SELECT COUNT(*) FROM foo"));
+  return s.Step() ? s.ColumnInt(0) : -1;
+}
+
+bool IsReadOnly(Connection* db) {
+  const int rc =
+      db->ExecuteAndReturnErrorCode("INSERT INTO foo (value) VALUES ('')");
+  return (rc & 0xff) == SQLITE_READONLY;
+}
+
+template <typename T>
+void SaveResult(T* out, base::OnceClosure done, T result) {
+  *out = result;
+  std::move(done).Run();
+}
+
+class SQLAsyncConnectionTest : public testing::Test {
+ public:
+  SQLAsyncConnectionTest() {}
+
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    connection_ = std::make_unique<AsyncConnection>(
+        2, AsyncConnection::ConfigureCallback());
+    bool success = false;
+    base::RunLoop run_loop;
+    connection_->Open(temp_dir_.GetPath().AppendASCII("SQLAsyncTest.db"),
+                      base::BindOnce(&SaveResult<bool>, &success,
+                                     run_loop.QuitClosure()));
+    run_loop.Run();
+    ASSERT_TRUE(success);
+    ASSERT_TRUE(Write(base::BindOnce(&CreateTable)));
+    // Lets the readers open.
+    scoped_task_environment_.RunUntilIdle();
+  }
+
+  template <typename T>
+  T Read(base::OnceCallback<T(Connection*)> task) {
+    T result;
+    base::RunLoop run_loop;
+    connection_->Read(std::move(task), base::BindOnce(&SaveResult<T>, &result,
+                                                      run_loop.QuitClosure()));
+    run_loop.Run();
+    return result;
+  }
+
+  template <typename T>
+  T Write(base::OnceCallback<T(Connection*)> task) {
+    T result;
+    base::RunLoop run_loop;
+    connection_->Write(std::move(task), base::BindOnce(&SaveResult<T>, &result,
+                                                       run_loop.QuitClosure()));
+    run_loop.Run();
+    return result;
+  }
+
+ protected:
+  base::test::ScopedTaskEnvironment scoped_task_environment_;
+  base::ScopedTempDir temp_dir_;
+  std::unique_ptr<AsyncConnection> connection_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(SQLAsyncConnectionTest);
+};
+
+TEST_F(SQLAsyncConnectionTest, ReadsSeeCompletedWrites) {
+  EXPECT_EQ(0, Read(base::BindOnce(&CountRows)));
+  EXPECT_TRUE(Write(base::BindOnce(&InsertRows, 3)));
+  EXPECT_EQ(3, Read(base::BindOnce(&CountRows)));
+
+  // Reads run on read-only connections, writes don't.
+  EXPECT_TRUE(Read(base::BindOnce(&IsReadOnly)));
+  EXPECT_FALSE(Write(base::BindOnce(&IsReadOnly)));
+}
+
+TEST_F(SQLAsyncConnectionTest, ReadRows) {
+  ASSERT_TRUE(Write(base::BindOnce(&InsertRows, 10)));
+
+  std::vector<size_t> batch_sizes;
+  std::vector<int> ids;
+  base::RunLoop run_loop;
+  connection_->ReadRows<int>(
+      SQL_FROM_HERE, "SELECT id FROM foo WHERE id > ? ORDER BY id",
+      base::BindOnce([](Statement* s) { s->BindInt(0, 1); }),
+      base::BindRepeating([](const Statement& s) { return s.ColumnInt(0); }),
+      4,
+      base::BindRepeating(
+          [](std::vector<size_t>* batch_sizes, std::vector<int>* ids,
+             base::RepeatingClosure quit, std::vector<int> rows, bool done) {
+            batch_sizes->push_back(rows.size());
+            ids->insert(ids->end(), rows.begin(), rows.end());
+            if (done)
+              quit.Run();
+          },
+          &batch_sizes, &ids, run_loop.QuitClosure()));
+  run_loop.Run();
+
+  EXPECT_EQ(std::vector<size_t>({4, 4, 1}), batch_sizes);
+  EXPECT_EQ(std::vector<int>({2, 3, 4, 5, 6, 7, 8, 9, 10}), ids);
+}
+
+// A read in progress doesn't keep a write from committing, and doesn't see it.
+TEST_F(SQLAsyncConnectionTest, ReadDuringWrite) {
+  ASSERT_TRUE(Write(base::BindOnce(&InsertRows, 2)));
+
+  base::WaitableEvent reading(base::WaitableEvent::ResetPolicy::MANUAL,
+                              base::WaitableEvent::InitialState::NOT_SIGNALED);
+  base::WaitableEvent written(base::WaitableEvent::ResetPolicy::MANUAL,
+                              base::WaitableEvent::InitialState::NOT_SIGNALED);
+
+  int rows_read = 0;
+  bool write_success = false;
+  base::RunLoop read_loop;
+  base::RunLoop write_loop;
+  connection_->Read(
+      base::BindOnce(
+          [](base::WaitableEvent* reading, base::WaitableEvent* written,
+             Connection* db) {
+            Statement s(db->GetUniqueStatement("SELECT id FROM foo"));
+            int rows = 0;
+            if (s.Step())
+              ++rows;
+            reading->Signal();
+            base::ScopedAllowBaseSyncPrimitivesForTesting allow_wait;
+            written->Wait();
+            while (s.Step())
+              ++rows;
+            return rows;
+          },
+          &reading, &written),
+      base::BindOnce(&SaveResult<int>, &rows_read, read_loop.QuitClosure()));
+  connection_->Write(
+      base::BindOnce(
+          [](base::WaitableEvent* reading, base::WaitableEvent* written,
+             Connection* db) {
+            {
+              base::ScopedAllowBaseSyncPrimitivesForTesting allow_wait;
+              reading->Wait();
+            }
+            bool success = InsertRows(1, db);
+            written->Signal();
+            return success;
+          },
+          &reading, &written),
+      base::BindOnce(&SaveResult<bool>, &write_success,
+                     write_loop.QuitClosure()));
+  read_loop.Run();
+  write_loop.Run();
+
+  EXPECT_TRUE(write_success);
+  EXPECT_EQ(2, rows_read);
+  EXPECT_EQ(3, Read(base::BindOnce(&CountRows)));
+}
+
+TEST_F(SQLAsyncConnectionTest, NoReaders) {
+  connection_ = std::make_unique<AsyncConnection>(
+      0, AsyncConnection::ConfigureCallback());
+  connection_->Open(temp_dir_.GetPath().AppendASCII("SQLAsyncTest.db"),
+                    base::BindOnce([](bool success) { EXPECT_TRUE(success); }));
+
+  // Reads run on the writer, after the writes issued before them.
+  connection_->Write(base::BindOnce(&InsertRows, 1),
+                     base::BindOnce([](bool success) {}));
+  EXPECT_EQ(1, Read(base::BindOnce(&CountRows)));
+  EXPECT_FALSE(Read(base::BindOnce(&IsReadOnly)));
+}
+
+TEST_F(SQLAsyncConnectionTest, ExclusiveLockingFails) {
+  connection_ = std::make_unique<AsyncConnection>(
+      1, base::BindRepeating(
+             [](Connection* db) { db->set_exclusive_locking(); }));
+  bool success = true;
+  base::RunLoop run_loop;
+  connection_->Open(
+      temp_dir_.GetPath().AppendASCII("SQLAsyncTest.db"),
+      base::BindOnce(&SaveResult<bool>, &success, run_loop.QuitClosure()));
+  run_loop.Run();
+  EXPECT_FALSE(success);
+}
+
+}  // namespace
+
+}  // namespace sql
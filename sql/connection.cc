@@ -9,11 +9,13 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <algorithm>
 #include <utility>
 
 #include "base/bind.h"
 #include "base/debug/alias.h"
 #include "base/debug/dump_without_crashing.h"
+#include "base/files/file.h"
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
 #include "base/format_macros.h"
@@ -29,6 +31,7 @@
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/synchronization/lock.h"
+#include "base/task_runner.h"
 #include "base/threading/sequenced_task_runner_handle.h"
 #include "base/trace_event/memory_dump_manager.h"
 #include "build/build_config.h"
@@ -50,6 +53,15 @@ namespace {
 // TODO(shess): Better story on this.  http://crbug.com/56559
 const int kBusyTimeoutSeconds = 1;
 
+// The number of statements kept by GetCachedStatement() by default.  This is
+// above the largest working set of any database (History uses about a hundred
+// statements), so it only bounds databases which generate statements.
+const size_t kDefaultStatementCacheSize = 256;
+
+// Databases are memory-mapped with room to grow by half before the mapping has
+// to be resized, and at least this much.
+const int64_t kMinMmapSize = 1024 * 1024;
+
 class ScopedBusyTimeout {
  public:
   explicit ScopedBusyTimeout(sqlite3* db)
@@ -221,6 +233,22 @@ base::HistogramBase* GetMediumTimeHistogram(const std::string& name) {
       base::HistogramBase::kUmaTargetedHistogramFlag);
 }
 
+// Reads the first |size| bytes of the file at |path| to prime the filesystem
+// cache.
+void PreloadFile(const base::FilePath& path, int64_t size) {
+  base::File file(path, base::File::FLAG_OPEN | base::File::FLAG_READ);
+  if (!file.IsValid())
+    return;
+
+  const int kChunkSize = 64 * 1024;
+  std::unique_ptr<char[]> buf(new char[kChunkSize]);
+  for (int64_t pos = 0; pos < size; pos += kChunkSize) {
+    // Stops at the end of the file, or on error.
+    if (file.Read(pos, buf.get(), kChunkSize) <= 0)
+      return;
+  }
+}
+
 std::string AsUTF8ForSQL(const base::FilePath& path) {
 #if defined(OS_WIN)
   return base::WideToUTF8(path.value());
@@ -317,6 +345,12 @@ Connection::Connection()
       cache_size_(0),
       exclusive_locking_(false),
       restrict_to_user_(false),
+      read_only_(false),
+      wal_mode_(false),
+      incremental_vacuum_(false),
+      statement_cache_(CachedStatementMap::NO_AUTO_EVICT),
+      statement_cache_size_(kDefaultStatementCacheSize),
+      unrecorded_statement_cache_hits_(0),
       transaction_nesting_(0),
       needs_rollback_(false),
       in_memory_(false),
@@ -324,6 +358,8 @@ Connection::Connection()
       mmap_alt_status_(false),
       mmap_disabled_(false),
       mmap_enabled_(false),
+      mmap_limit_(0),
+      mmap_size_(0),
       total_changes_at_last_release_(0),
       stats_histogram_(NULL),
       commit_time_histogram_(NULL),
@@ -337,16 +373,37 @@ Connection::~Connection() {
   Close();
 }
 
-void Connection::RecordEvent(Events event, size_t count) {
-  for (size_t i = 0; i < count; ++i) {
-    UMA_HISTOGRAM_ENUMERATION("Sqlite.Stats", event, EVENT_MAX_VALUE);
+void Connection::set_statement_cache_size(size_t statement_cache_size) {
+  statement_cache_size_ = statement_cache_size;
+  if (statement_cache_size_ &&
+      statement_cache_.size() > statement_cache_size_) {
+    RecordEvent(EVENT_STATEMENT_CACHE_EVICTION,
+                statement_cache_.size() - statement_cache_size_);
+    statement_cache_.ShrinkToSize(statement_cache_size_);
   }
+}
 
-  if (stats_histogram_) {
-    for (size_t i = 0; i < count; ++i) {
-      stats_histogram_->Add(event);
-    }
-  }
+void Connection::RecordEvent(Events event, size_t count) {
+  if (!count)
+    return;
+
+  // Use the more primitive STATIC_HISTOGRAM_POINTER_BLOCK macro because the
+  // simple UMA_HISTOGRAM_ENUMERATION macros don't expose 'AddCount'.
+  // Aggregated statement cache hits can be large counts.
+  const int sample_count = static_cast<int>(std::min<size_t>(count, INT_MAX));
+  STATIC_HISTOGRAM_POINTER_BLOCK(
+      "Sqlite.Stats", AddCount(event, sample_count),
+      base::LinearHistogram::FactoryGet(
+          "Sqlite.Stats", 1, EVENT_MAX_VALUE, EVENT_MAX_VALUE + 1,
+          base::HistogramBase::kUmaTargetedHistogramFlag));
+
+  if (stats_histogram_)
+    stats_histogram_->AddCount(event, sample_count);
+}
+
+void Connection::RecordStatementCacheHits() {
+  RecordEvent(EVENT_STATEMENT_CACHE_HIT, unrecorded_statement_cache_hits_);
+  unrecorded_statement_cache_hits_ = 0;
 }
 
 void Connection::RecordCommitTime(const base::TimeDelta& delta) {
@@ -429,7 +486,8 @@ void Connection::CloseInternal(bool forced) {
   // sqlite3_close() needs all prepared statements to be finalized.
 
   // Release cached statements.
-  statement_cache_.clear();
+  statement_cache_.Clear();
+  RecordStatementCacheHits();
 
   // With cached statements released, in-use statements will remain.
   // Closing the database while statements are in use is an API
@@ -519,6 +577,71 @@ void Connection::Preload() {
   }
 }
 
+void Connection::PreloadInBackground(
+    scoped_refptr<base::TaskRunner> task_runner) {
+  if (!db_) {
+    DCHECK(poisoned_) << "Cannot preload null db";
+    return;
+  }
+
+  // In-memory and temporary databases have no path.
+  const base::FilePath path = DbPath();
+  if (path.empty())
+    return;
+
+  // Same amount as Preload().  The file is read through its end at most.
+  const int page_size = page_size_ ? page_size_ : 1024;
+  const int64_t preload_size =
+      static_cast<int64_t>(page_size) * (cache_size_ ? cache_size_ : 2000);
+  task_runner->PostTask(FROM_HERE,
+                        base::Bind(&PreloadFile, path, preload_size));
+}
+
+bool Connection::EstimateFragmentation(int64_t* free_pages,
+                                       double* free_fraction) {
+  if (!db_) {
+    DCHECK(poisoned_) << "Cannot estimate fragmentation of null db";
+    return false;
+  }
+
+  int64_t page_count;
+  {
+    Statement s(GetUniqueStatement("PRAGMA page_count"));
+    if (!s.Step())
+      return false;
+    page_count = s.ColumnInt64(0);
+  }
+  {
+    Statement s(GetUniqueStatement("PRAGMA freelist_count"));
+    if (!s.Step())
+      return false;
+    *free_pages = s.ColumnInt64(0);
+  }
+  *free_fraction =
+      page_count ? static_cast<double>(*free_pages) / page_count : 0.0;
+  return true;
+}
+
+bool Connection::IncrementalVacuum(int max_pages) {
+  DCHECK_GT(max_pages, 0);
+  if (!db_) {
+    DCHECK(poisoned_) << "Cannot vacuum null db";
+    return false;
+  }
+
+  // Values from http://www.sqlite.org/pragma.html#pragma_auto_vacuum
+  const int kIncrementalAutoVacuum = 2;
+  {
+    Statement s(GetUniqueStatement("PRAGMA auto_vacuum"));
+    if (!s.Step() || s.ColumnInt(0) != kIncrementalAutoVacuum)
+      return false;
+  }
+
+  const std::string sql =
+      base::StringPrintf("PRAGMA incremental_vacuum(%d)", max_pages);
+  return Execute(sql.c_str());
+}
+
 // SQLite keeps unused pages associated with a connection in a cache.  It asks
 // the cache for pages by an id, and if the page is present and the database is
 // unchanged, it considers the content of the page valid and doesn't read it
@@ -591,6 +714,9 @@ void Connection::ReleaseCacheMemoryIfNeeded(bool implicit_change_performed) {
 
   total_changes_at_last_release_ = total_changes;
   sqlite3_db_release_memory(db_);
+
+  // The changes may have grown the database past the mapped region.
+  GrowMmapSizeIfNeeded();
 }
 
 base::FilePath Connection::DbPath() const {
@@ -929,6 +1055,11 @@ size_t Connection::GetAppropriateMmapSize() {
     RecordOneEvent(EVENT_MMAP_FAILED);
     return 0;
   } else if (mmap_ofs != MetaTable::kMmapSuccess) {
+    // Progress can't be recorded on a read-only connection, leave the reading
+    // to a writer.
+    if (read_only_)
+      return 0;
+
     // Continue reading from previous offset.
     DCHECK_GE(mmap_ofs, 0);
 
@@ -1019,6 +1150,35 @@ size_t Connection::GetAppropriateMmapSize() {
   return mmap_ofs;
 }
 
+size_t Connection::GetMmapSizeForDatabase(int64_t db_size) const {
+  // Mapping much more than the database only costs address space, which 32-bit
+  // processes are short of, while remapping on every change would be slow.
+  const int64_t mmap_size = std::max(kMinMmapSize, db_size + db_size / 2);
+  return static_cast<size_t>(
+      std::min(mmap_size, static_cast<int64_t>(mmap_limit_)));
+}
+
+void Connection::SetMmapSize(size_t mmap_size) {
+  const std::string sql =
+      base::StringPrintf("PRAGMA mmap_size = %" PRIuS, mmap_size);
+  if (sqlite3_exec(db_, sql.c_str(), NULL, NULL, NULL) == SQLITE_OK)
+    mmap_size_ = mmap_size;
+}
+
+void Connection::GrowMmapSizeIfNeeded() {
+  sqlite3_file* file = NULL;
+  sqlite3_int64 db_size = 0;
+  if (GetSqlite3FileAndSize(db_, &file, &db_size) != SQLITE_OK)
+    return;
+  if (db_size <= static_cast<sqlite3_int64>(mmap_size_))
+    return;
+
+  // Nothing to do if the mapping already covers as much as is safe.
+  const size_t mmap_size = GetMmapSizeForDatabase(db_size);
+  if (mmap_size > mmap_size_)
+    SetMmapSize(mmap_size);
+}
+
 void Connection::TrimMemory(bool aggressively) {
   if (!db_)
     return;
@@ -1046,6 +1206,20 @@ void Connection::TrimMemory(bool aggressively) {
       base::StringPrintf("PRAGMA cache_size=%d", original_cache_size);
   if (!Execute(sql_restore.c_str()))
     DLOG(WARNING) << "Could not restore cache size: " << GetErrorMessage();
+
+  // Pages read through memory-mapped I/O are also charged to the process.  Map
+  // half as much, or nothing, until ReleaseCacheMemoryIfNeeded() grows the
+  // mapping back after the next change.
+  if (mmap_enabled_) {
+    size_t mmap_size = 0;
+    sqlite3_file* file = NULL;
+    sqlite3_int64 db_size = 0;
+    if (!aggressively &&
+        GetSqlite3FileAndSize(db_, &file, &db_size) == SQLITE_OK) {
+      mmap_size = std::min(static_cast<size_t>(db_size), mmap_size_) / 2;
+    }
+    SetMmapSize(mmap_size);
+  }
 }
 
 // Create an in-memory database with the existing database's page
@@ -1092,6 +1266,12 @@ bool Connection::Raze() {
     return false;
 #endif
 
+  // Unlike the rest of the existing database, this is known to be wanted.
+  if (incremental_vacuum_ &&
+      !null_db.Execute("PRAGMA auto_vacuum = INCREMENTAL")) {
+    return false;
+  }
+
   // The page size doesn't take effect until a database has pages, and
   // at this point the null database has none.  Changing the schema
   // version will create the first page.  This will not affect the
@@ -1455,13 +1635,13 @@ bool Connection::ExecuteWithTimeout(const char* sql, base::TimeDelta timeout) {
 }
 
 bool Connection::HasCachedStatement(const StatementID& id) const {
-  return statement_cache_.find(id) != statement_cache_.end();
+  return statement_cache_.Peek(id) != statement_cache_.end();
 }
 
 scoped_refptr<Connection::StatementRef> Connection::GetCachedStatement(
     const StatementID& id,
     const char* sql) {
-  CachedStatementMap::iterator i = statement_cache_.find(id);
+  CachedStatementMap::iterator i = statement_cache_.Get(id);
   if (i != statement_cache_.end()) {
     // Statement is in the cache. It should still be active (we're the only
     // one invalidating cached statements, and we'll remove it from the cache
@@ -1469,12 +1649,23 @@ scoped_refptr<Connection::StatementRef> Connection::GetCachedStatement(
     // case it still has some stuff bound.
     DCHECK(i->second->is_valid());
     sqlite3_reset(i->second->stmt());
+    ++unrecorded_statement_cache_hits_;
     return i->second;
   }
 
+  RecordStatementCacheHits();
+  RecordOneEvent(EVENT_STATEMENT_CACHE_MISS);
   scoped_refptr<StatementRef> statement = GetUniqueStatement(sql);
-  if (statement->is_valid())
-    statement_cache_[id] = statement;  // Only cache valid statements.
+  if (statement->is_valid()) {
+    // Only cache valid statements.  Callers still using an evicted statement
+    // keep their reference to it.
+    statement_cache_.Put(id, statement);
+    if (statement_cache_size_ &&
+        statement_cache_.size() > statement_cache_size_) {
+      RecordOneEvent(EVENT_STATEMENT_CACHE_EVICTION);
+      statement_cache_.ShrinkToSize(statement_cache_size_);
+    }
+  }
   return statement;
 }
 
@@ -1688,9 +1879,10 @@ bool Connection::OpenInternal(const std::string& file_name,
   // Custom memory-mapping VFS which reads pages using regular I/O on first hit.
   sqlite3_vfs* vfs = VFSWrapper();
   const char* vfs_name = (vfs ? vfs->zName : nullptr);
-  int err = sqlite3_open_v2(file_name.c_str(), &db_,
-                            SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
-                            vfs_name);
+  const int open_flags = read_only_
+                             ? SQLITE_OPEN_READONLY
+                             : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+  int err = sqlite3_open_v2(file_name.c_str(), &db_, open_flags, vfs_name);
   if (err != SQLITE_OK) {
     // Extended error codes cannot be enabled until a handle is
     // available, fetch manually.
@@ -1799,7 +1991,13 @@ bool Connection::OpenInternal(const std::string& file_name,
   // TRUNCATE should be faster than DELETE because it won't need directory
   // changes for each transaction.  PERSIST may break the spirit of using
   // secure_delete.
-  ignore_result(Execute("PRAGMA journal_mode = TRUNCATE"));
+  // WAL - append changes to a -wal file, checkpointed into the database from
+  // time to time.  Readers see the database as of their start.
+  // Read-only connections can't change the journal mode.
+  if (!read_only_) {
+    ignore_result(Execute(wal_mode_ ? "PRAGMA journal_mode = WAL"
+                                    : "PRAGMA journal_mode = TRUNCATE"));
+  }
 
   const base::TimeDelta kBusyTimeout =
     base::TimeDelta::FromSeconds(kBusyTimeoutSeconds);
@@ -1821,6 +2019,13 @@ bool Connection::OpenInternal(const std::string& file_name,
     ignore_result(ExecuteWithTimeout(sql.c_str(), kBusyTimeout));
   }
 
+  // Like |page_size_|, only applied by the creation of the first table or by
+  // VACUUM.
+  if (incremental_vacuum_ && !read_only_) {
+    ignore_result(
+        ExecuteWithTimeout("PRAGMA auto_vacuum = INCREMENTAL", kBusyTimeout));
+  }
+
   if (!ExecuteWithTimeout("PRAGMA secure_delete=ON", kBusyTimeout)) {
     bool was_poisoned = poisoned_;
     Close();
@@ -1848,15 +2053,16 @@ bool Connection::OpenInternal(const std::string& file_name,
 
   // Enable memory-mapped access.  The explicit-disable case is because SQLite
   // can be built to default-enable mmap.  GetAppropriateMmapSize() calculates a
-  // safe range to memory-map based on past regular I/O.  This value will be
-  // capped by SQLITE_MAX_MMAP_SIZE, which could be different between 32-bit and
-  // 64-bit platforms.
-  size_t mmap_size = mmap_disabled_ ? 0 : GetAppropriateMmapSize();
-  std::string mmap_sql =
-      base::StringPrintf("PRAGMA mmap_size = %" PRIuS, mmap_size);
-  ignore_result(Execute(mmap_sql.c_str()));
+  // safe range to memory-map based on past regular I/O.  Within it, only the
+  // database and room to grow are mapped, see GetMmapSizeForDatabase().  This
+  // value will be capped by SQLITE_MAX_MMAP_SIZE, which could be different
+  // between 32-bit and 64-bit platforms.
+  mmap_limit_ = mmap_disabled_ ? 0 : GetAppropriateMmapSize();
+  if (rc != SQLITE_OK)
+    db_size = 0;
+  SetMmapSize(GetMmapSizeForDatabase(db_size));
 
-  // Determine if memory-mapping has actually been enabled.  The Execute() above
+  // Determine if memory-mapping has actually been enabled.  The PRAGMA above
   // can succeed without changing the amount mapped.
   mmap_enabled_ = false;
   {
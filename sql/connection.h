@@ -14,7 +14,7 @@
 
 #include "base/callback.h"
 #include "base/compiler_specific.h"
-#include "base/containers/flat_map.h"
+#include "base/containers/mru_cache.h"
 #include "base/gtest_prod_util.h"
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
@@ -28,6 +28,7 @@ struct sqlite3_stmt;
 namespace base {
 class FilePath;
 class HistogramBase;
+class TaskRunner;
 namespace trace_event {
 class ProcessMemoryDump;
 }
@@ -146,6 +147,7 @@ class SQL_EXPORT Connection {
   //
   // This must be called before Open() to have an effect.
   void set_exclusive_locking() { exclusive_locking_ = true; }
+  bool exclusive_locking() const { return exclusive_locking_; }
 
   // Call to cause Open() to restrict access permissions of the
   // database file to only the owner.
@@ -153,6 +155,25 @@ class SQL_EXPORT Connection {
   // other platforms.
   void set_restrict_to_user() { restrict_to_user_ = true; }
 
+  // Call to open the database read-only.  Open() fails if the database doesn't
+  // exist, and statements which change it fail.  The journal mode is left as
+  // the database has it, and the database is only memory-mapped if a writer
+  // already read it through, see GetAppropriateMmapSize().
+  void set_read_only() { read_only_ = true; }
+
+  // Call to use write-ahead logging instead of a rollback journal, so that
+  // readers on other connections neither block writes nor are blocked by them.
+  // The journal mode is persistent, so all connections to the database should
+  // use it.  http://www.sqlite.org/wal.html
+  void set_wal_mode() { wal_mode_ = true; }
+
+  // Call to keep the pages freed by deletions on the freelist until
+  // IncrementalVacuum() releases them, rather than until a full VACUUM.  This
+  // takes effect when a new database is created; an existing database switches
+  // over at its next VACUUM.
+  // http://www.sqlite.org/pragma.html#pragma_auto_vacuum
+  void set_incremental_vacuum() { incremental_vacuum_ = true; }
+
   // Call to use alternative status-tracking for mmap.  Usually this is tracked
   // in the meta table, but some databases have no meta table.
   // TODO(shess): Maybe just have all databases use the alt option?
@@ -161,6 +182,11 @@ class SQL_EXPORT Connection {
   // Call to opt out of memory-mapped file I/O.
   void set_mmap_disabled() { mmap_disabled_ = true; }
 
+  // Sets the number of statements kept by GetCachedStatement(). When the cache
+  // is full, the least recently used statement is dropped from it. The default
+  // is larger than the working set of any database. Zero means no limit.
+  void set_statement_cache_size(size_t statement_cache_size);
+
   // Set an error-handling callback.  On errors, the error number (and
   // statement, if available) will be passed to the callback.
   //
@@ -230,6 +256,13 @@ class SQL_EXPORT Connection {
     EVENT_MMAP_STATUS_FAILURE_READ,  // Failure reading MmapStatus view.
     EVENT_MMAP_STATUS_FAILURE_UPDATE,// Failure updating MmapStatus view.
 
+    // Track GetCachedStatement() calls which found the statement in the cache,
+    // which had to prepare it, and the statements dropped from the cache to
+    // make room.
+    EVENT_STATEMENT_CACHE_HIT,
+    EVENT_STATEMENT_CACHE_MISS,
+    EVENT_STATEMENT_CACHE_EVICTION,
+
     // Leave this at the end.
     // TODO(shess): |EVENT_MAX| causes compile fail on Windows.
     EVENT_MAX_VALUE
@@ -297,12 +330,32 @@ class SQL_EXPORT Connection {
   // everything else.
   void Preload();
 
+  // Like Preload(), but reads the file on |task_runner| instead of blocking
+  // the caller, for databases which will be read soon but not immediately.
+  // The file is read directly rather than through SQLite, so the connection
+  // can be used meanwhile.
+  void PreloadInBackground(scoped_refptr<base::TaskRunner> task_runner);
+
   // Try to trim the cache memory used by the database.  If |aggressively| is
   // true, this function will try to free all of the cache memory it can. If
   // |aggressively| is false, this function will try to cut cache memory
-  // usage by half.
+  // usage by half.  Memory-mapped I/O is also cut by half, or disabled if
+  // |aggressively| is true, until the database is next changed.
   void TrimMemory(bool aggressively);
 
+  // Estimates how fragmented the database is.  |free_pages| receives the number
+  // of pages on the freelist, and |free_fraction| their share of the file.
+  // Free pages take up disk space, and the live pages scattered between them
+  // make scans seek.  Returns false on error.
+  bool EstimateFragmentation(int64_t* free_pages, double* free_fraction);
+
+  // Releases up to |max_pages| free pages, moving live pages from the end of
+  // the file into them and truncating it.  Unlike a VACUUM this doesn't rewrite
+  // the whole database, so it can be run in short slices while idle, and within
+  // a transaction.  Returns false on error, or if the database isn't in
+  // incremental vacuum mode, see set_incremental_vacuum().
+  bool IncrementalVacuum(int max_pages);
+
   // Raze the database to the ground.  This approximates creating a
   // fresh database from scratch, within the constraints of SQLite's
   // locking protocol (locks and open handles can make doing this with
@@ -673,6 +726,9 @@ class SQL_EXPORT Connection {
       const char* pragma_sql,
       std::vector<std::string>* messages) WARN_UNUSED_RESULT;
 
+  // Record the statement cache hits counted since the last call.
+  void RecordStatementCacheHits();
+
   // Record time spent executing explicit COMMIT statements.
   void RecordCommitTime(const base::TimeDelta& delta);
 
@@ -749,6 +805,17 @@ class SQL_EXPORT Connection {
   bool GetMmapAltStatus(int64_t* status);
   bool SetMmapAltStatus(int64_t status);
 
+  // Returns how much of the database to memory-map given its current size,
+  // leaving room to grow, but never more than |mmap_limit_|.
+  size_t GetMmapSizeForDatabase(int64_t db_size) const;
+
+  // Runs "PRAGMA mmap_size" and updates |mmap_size_|.  Unlike Execute(), this
+  // doesn't record events or release cache memory.
+  void SetMmapSize(size_t mmap_size);
+
+  // Grows the memory-mapped region if the database outgrew it.
+  void GrowMmapSizeIfNeeded();
+
   // The actual sqlite database. Will be NULL before Init has been called or if
   // Init resulted in an error.
   sqlite3* db_;
@@ -759,13 +826,22 @@ class SQL_EXPORT Connection {
   int cache_size_;
   bool exclusive_locking_;
   bool restrict_to_user_;
-
-  // All cached statements. Keeping a reference to these statements means that
-  // they'll remain active. Using flat_map here because number of cached
-  // statements is expected to be small, see //base/containers/README.md.
-  typedef base::flat_map<StatementID, scoped_refptr<StatementRef>>
+  bool read_only_;
+  bool wal_mode_;
+  bool incremental_vacuum_;
+
+  // All cached statements, most recently used first. Keeping a reference to
+  // these statements means that they'll remain active. The cache is trimmed to
+  // |statement_cache_size_| by GetCachedStatement().
+  typedef base::MRUCache<StatementID, scoped_refptr<StatementRef>>
       CachedStatementMap;
   CachedStatementMap statement_cache_;
+  size_t statement_cache_size_;
+
+  // GetCachedStatement() hits since they were last recorded. Hits are recorded
+  // in aggregate with the next miss or on close, so that the hot path doesn't
+  // touch histograms.
+  size_t unrecorded_statement_cache_hits_;
 
   // A list of all StatementRefs we've given out. Each ref must register with
   // us when it's created or destroyed. This allows us to potentially close
@@ -801,6 +877,13 @@ class SQL_EXPORT Connection {
   // Used by ReleaseCacheMemoryIfNeeded().
   bool mmap_enabled_;
 
+  // The most of the database which is safe to memory-map, as computed by
+  // GetAppropriateMmapSize() when opening it.
+  size_t mmap_limit_;
+
+  // The size last passed to "PRAGMA mmap_size".
+  size_t mmap_size_;
+
   // Used by ReleaseCacheMemoryIfNeeded() to track if new changes have happened
   // since memory was last released.
   int total_changes_at_last_release_;
@@ -0,0 +1,153 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "sql/connection.h"
+#include "sql/statement.h"
+#include "sql/test/sql_test_base.h"
+#include "sql/transaction.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace sql {
+
+namespace {
+
+const int kRows = 20000;
+const int kValueSize = 512;
+const int kIterations = 50000;
+
+class SQLConnectionPerfTest : public SQLTestBase {
+ public:
+  SQLConnectionPerfTest() {}
+
+ protected:
+  // Fills [foo] with |kRows| rows of |kValueSize| bytes.
+  void FillTable() {
+    ASSERT_TRUE(
+        db().Execute("CREATE TABLE foo (id INTEGER PRIMARY KEY, value BLOB)"));
+    sql::Transaction transaction(&db());
+    ASSERT_TRUE(transaction.Begin());
+    for (int i = 0; i < kRows; ++i) {
+      sql::Statement s(db().GetCachedStatement(
+          SQL_FROM_HERE,
+          "INSERT INTO foo (id, value) VALUES (?, randomblob(?))"));
+      s.BindInt(0, i);
+      s.BindInt(1, kValueSize);
+      ASSERT_TRUE(s.Run());
+    }
+    ASSERT_TRUE(transaction.Commit());
+  }
+
+  // Reads rows of [foo] in a fixed pseudo-random order.
+  void ReadRandomRows(const std::string& story) {
+    uint32_t seed = 1;
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int i = 0; i < kIterations; ++i) {
+      seed = seed * 1103515245 + 12345;
+      sql::Statement s(db().GetCachedStatement(
+          SQL_FROM_HERE, "SELECT value FROM foo WHERE id = ?"));
+      s.BindInt(0, (seed >> 8) % kRows);
+      ASSERT_TRUE(s.Step());
+    }
+    PrintTime("random_reads", story, base::TimeTicks::Now() - start,
+              kIterations);
+  }
+
+  // Runs |kIterations| queries cycling through |working_set| statements.
+  void RunCachedStatements(const std::string& story, int working_set) {
+    std::vector<std::string> sqls;
+    for (int i = 0; i < working_set; ++i) {
+      // Distinct text, so that each statement is prepared separately.
+      sqls.push_back(base::StringPrintf(
+          "SELECT value FROM foo WHERE id = ? AND %d = %d", i, i));
+    }
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int i = 0; i < kIterations; ++i) {
+      const int statement = i % working_set;
+      sql::Statement s(db().GetCachedStatement(
+          sql::StatementID(__FILE__, statement), sqls[statement].c_str()));
+      s.BindInt(0, i % kRows);
+      ASSERT_TRUE(s.Step());
+    }
+    PrintTime("cached_statements", story, base::TimeTicks::Now() - start,
+              kIterations);
+  }
+
+  void PrintTime(const std::string& measurement,
+                 const std::string& story,
+                 base::TimeDelta elapsed,
+                 int iterations) {
+    perf_test::PrintResult(
+        measurement, "", story,
+        static_cast<double>(elapsed.InMicroseconds()) / iterations, "us/op",
+        true);
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(SQLConnectionPerfTest);
+};
+
+TEST_F(SQLConnectionPerfTest, CachedStatements) {
+  FillTable();
+  // Fits in the default cache.
+  RunCachedStatements("working_set_256", 256);
+
+  db().set_statement_cache_size(0);
+  RunCachedStatements("working_set_256_unbounded", 256);
+
+  db().set_statement_cache_size(64);
+  // Fits in the cache.
+  RunCachedStatements("working_set_16", 16);
+  // Thrashes the cache.
+  RunCachedStatements("working_set_256_cache_64", 256);
+}
+
+TEST_F(SQLConnectionPerfTest, RandomReads) {
+  FillTable();
+  ASSERT_TRUE(Reopen());
+  ReadRandomRows("mmap");
+
+  db().set_mmap_disabled();
+  ASSERT_TRUE(Reopen());
+  ReadRandomRows("no_mmap");
+}
+
+TEST_F(SQLConnectionPerfTest, Preload) {
+  FillTable();
+  base::Thread thread("SQLPreload");
+  ASSERT_TRUE(thread.Start());
+
+  // How long the caller is blocked, and how long the first scan then takes.
+  ASSERT_TRUE(Reopen());
+  base::TimeTicks start = base::TimeTicks::Now();
+  db().Preload();
+  PrintTime("preload", "blocking", base::TimeTicks::Now() - start, 1);
+
+  ASSERT_TRUE(Reopen());
+  start = base::TimeTicks::Now();
+  db().PreloadInBackground(thread.task_runner());
+  PrintTime("preload", "background", base::TimeTicks::Now() - start, 1);
+  thread.FlushForTesting();
+
+  start = base::TimeTicks::Now();
+  sql::Statement s(
+      db().GetUniqueStatement("SELECT SUM(LENGTH(value)) FROM foo"));
+  ASSERT_TRUE(s.Step());
+  PrintTime("preload", "first_scan", base::TimeTicks::Now() - start, 1);
+}
+
+}  // namespace
+
+}  // namespace sql
@@ -13,6 +13,7 @@
 #include "base/macros.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/test/histogram_tester.h"
+#include "base/test/test_simple_task_runner.h"
 #include "base/trace_event/process_memory_dump.h"
 #include "build/build_config.h"
 #include "sql/connection.h"
@@ -309,6 +310,65 @@ TEST_F(SQLConnectionTest, CachedStatement) {
   EXPECT_FALSE(db().HasCachedStatement(SQL_FROM_HERE));
 }
 
+TEST_F(SQLConnectionTest, CachedStatementEviction) {
+  sql::StatementID id1("foo", 1);
+  sql::StatementID id2("foo", 2);
+  sql::StatementID id3("foo", 3);
+
+  ASSERT_TRUE(db().Execute("CREATE TABLE foo (a, b)"));
+  db().set_statement_cache_size(2);
+
+  ASSERT_TRUE(db().GetCachedStatement(id1, "SELECT a FROM foo")->is_valid());
+  ASSERT_TRUE(db().GetCachedStatement(id2, "SELECT b FROM foo")->is_valid());
+  EXPECT_TRUE(db().HasCachedStatement(id1));
+  EXPECT_TRUE(db().HasCachedStatement(id2));
+
+  // Using |id1| again leaves |id2| as the least recently used statement.
+  ASSERT_TRUE(db().GetCachedStatement(id1, "SELECT a FROM foo")->is_valid());
+  ASSERT_TRUE(db().GetCachedStatement(id3, "SELECT * FROM foo")->is_valid());
+  EXPECT_TRUE(db().HasCachedStatement(id1));
+  EXPECT_FALSE(db().HasCachedStatement(id2));
+  EXPECT_TRUE(db().HasCachedStatement(id3));
+
+  // A statement in use can be evicted, and stays valid.
+  sql::Statement s(db().GetCachedStatement(id1, "SELECT a FROM foo"));
+  ASSERT_TRUE(s.is_valid());
+  db().set_statement_cache_size(1);
+  ASSERT_TRUE(db().GetCachedStatement(id2, "SELECT b FROM foo")->is_valid());
+  EXPECT_FALSE(db().HasCachedStatement(id1));
+  EXPECT_TRUE(db().HasCachedStatement(id2));
+  EXPECT_FALSE(db().HasCachedStatement(id3));
+  EXPECT_FALSE(s.Step());
+  EXPECT_TRUE(s.Succeeded());
+}
+
+// Cache hits are counted locally and recorded with the next miss or on close.
+TEST_F(SQLConnectionTest, CachedStatementHitsRecordedInAggregate) {
+  ASSERT_TRUE(db().Execute("CREATE TABLE foo (a, b)"));
+  base::HistogramTester tester;
+  const char kGlobalHistogramName[] = "Sqlite.Stats";
+
+  sql::StatementID id1("foo", 1);
+  sql::StatementID id2("foo", 2);
+  for (int i = 0; i < 3; ++i)
+    ASSERT_TRUE(db().GetCachedStatement(id1, "SELECT a FROM foo")->is_valid());
+  tester.ExpectBucketCount(kGlobalHistogramName,
+                           sql::Connection::EVENT_STATEMENT_CACHE_MISS, 1);
+  tester.ExpectBucketCount(kGlobalHistogramName,
+                           sql::Connection::EVENT_STATEMENT_CACHE_HIT, 0);
+
+  ASSERT_TRUE(db().GetCachedStatement(id2, "SELECT b FROM foo")->is_valid());
+  tester.ExpectBucketCount(kGlobalHistogramName,
+                           sql::Connection::EVENT_STATEMENT_CACHE_MISS, 2);
+  tester.ExpectBucketCount(kGlobalHistogramName,
+                           sql::Connection::EVENT_STATEMENT_CACHE_HIT, 2);
+
+  ASSERT_TRUE(db().GetCachedStatement(id2, "SELECT b FROM foo")->is_valid());
+  db().Close();
+  tester.ExpectBucketCount(kGlobalHistogramName,
+                           sql::Connection::EVENT_STATEMENT_CACHE_HIT, 3);
+}
+
 TEST_F(SQLConnectionTest, IsSQLValidTest) {
   ASSERT_TRUE(db().Execute("CREATE TABLE foo (a, b)"));
   ASSERT_TRUE(db().IsSQLValid("SELECT a FROM foo"));
@@ -1558,6 +1618,44 @@ TEST_F(SQLConnectionTest, MmapInitiallyEnabled) {
   EXPECT_EQ("0", ExecuteWithResult(&db(), "PRAGMA mmap_size"));
 }
 
+// Test that the memory-mapped region follows the size of the database.
+TEST_F(SQLConnectionTest, MmapSizeFollowsDatabaseSize) {
+  {
+    sql::Statement s(db().GetUniqueStatement("PRAGMA mmap_size"));
+
+    // SQLite doesn't have mmap support, or it is disabled.
+    if (!s.Step() || s.ColumnInt64(0) <= 0)
+      return;
+
+    // A small database is mapped with room to grow.
+    EXPECT_EQ(1024 * 1024, s.ColumnInt64(0));
+  }
+
+  ASSERT_TRUE(db().Execute("CREATE TABLE foo (value BLOB)"));
+  ASSERT_TRUE(db().BeginTransaction());
+  for (int i = 0; i < 2048; ++i) {
+    sql::Statement s(db().GetCachedStatement(
+        SQL_FROM_HERE, "INSERT INTO foo (value) VALUES (randomblob(1024))"));
+    ASSERT_TRUE(s.Run());
+  }
+  ASSERT_TRUE(db().CommitTransaction());
+
+  int64_t db_size = 0;
+  ASSERT_TRUE(base::GetFileSize(db_path(), &db_size));
+  int64_t mmap_size = 0;
+  ASSERT_TRUE(base::StringToInt64(
+      ExecuteWithResult(&db(), "PRAGMA mmap_size"), &mmap_size));
+  EXPECT_GT(mmap_size, db_size);
+
+  // Trimming memory drops the mapping until the database is changed.
+  db().TrimMemory(true);
+  EXPECT_EQ("0", ExecuteWithResult(&db(), "PRAGMA mmap_size"));
+  ASSERT_TRUE(db().Execute("INSERT INTO foo (value) VALUES (randomblob(1))"));
+  ASSERT_TRUE(base::StringToInt64(
+      ExecuteWithResult(&db(), "PRAGMA mmap_size"), &mmap_size));
+  EXPECT_GT(mmap_size, db_size);
+}
+
 // Test whether a fresh database gets mmap enabled when using alternate status
 // storage.
 TEST_F(SQLConnectionTest, MmapInitiallyEnabledAltStatus) {
@@ -1690,6 +1788,104 @@ TEST_F(SQLConnectionTest, GetAppropriateMmapSizeAltStatus) {
             ExecuteWithResult(&db(), "SELECT * FROM MmapStatus"));
 }
 
+TEST_F(SQLConnectionTest, IncrementalVacuum) {
+  // Existing databases switch over at their next VACUUM.
+  ASSERT_TRUE(db().Execute("CREATE TABLE foo (id INTEGER PRIMARY KEY, v)"));
+  db().Close();
+  db().set_incremental_vacuum();
+  ASSERT_TRUE(db().Open(db_path()));
+  EXPECT_FALSE(db().IncrementalVacuum(10));
+  ASSERT_TRUE(db().Execute("VACUUM"));
+  EXPECT_EQ("2", ExecuteWithResult(&db(), "PRAGMA auto_vacuum"));
+
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_TRUE(
+        db().Execute("INSERT INTO foo (v) VALUES (randomblob(1024))"));
+  }
+  int64_t free_pages = -1;
+  double free_fraction = -1;
+  ASSERT_TRUE(db().EstimateFragmentation(&free_pages, &free_fraction));
+  EXPECT_EQ(0, free_pages);
+  EXPECT_EQ(0.0, free_fraction);
+
+  // Deleted pages stay in the file until they are vacuumed.
+  int64_t db_size;
+  ASSERT_TRUE(base::GetFileSize(db_path(), &db_size));
+  ASSERT_TRUE(db().Execute("DELETE FROM foo WHERE id > 10"));
+  ASSERT_TRUE(db().EstimateFragmentation(&free_pages, &free_fraction));
+  EXPECT_GT(free_pages, 10);
+  EXPECT_GT(free_fraction, 0.5);
+  int64_t new_size;
+  ASSERT_TRUE(base::GetFileSize(db_path(), &new_size));
+  EXPECT_EQ(db_size, new_size);
+
+  // Each slice releases at most the requested number of pages, even within a
+  // transaction.
+  const int64_t initial_free_pages = free_pages;
+  ASSERT_TRUE(db().BeginTransaction());
+  ASSERT_TRUE(db().IncrementalVacuum(10));
+  ASSERT_TRUE(db().CommitTransaction());
+  ASSERT_TRUE(db().EstimateFragmentation(&free_pages, &free_fraction));
+  EXPECT_EQ(initial_free_pages - 10, free_pages);
+
+  while (free_pages > 0) {
+    ASSERT_TRUE(db().IncrementalVacuum(10));
+    ASSERT_TRUE(db().EstimateFragmentation(&free_pages, &free_fraction));
+  }
+  ASSERT_TRUE(base::GetFileSize(db_path(), &new_size));
+  EXPECT_LT(new_size, db_size);
+  EXPECT_EQ("11", ExecuteWithResult(&db(), "SELECT COUNT(*) FROM foo"));
+
+  // Raze() keeps the mode.
+  ASSERT_TRUE(db().Raze());
+  ASSERT_TRUE(db().Execute("CREATE TABLE bar (x)"));
+  EXPECT_EQ("2", ExecuteWithResult(&db(), "PRAGMA auto_vacuum"));
+}
+
+TEST_F(SQLConnectionTest, WALModeAndReadOnly) {
+  db().Close();
+  db().set_wal_mode();
+  ASSERT_TRUE(db().Open(db_path()));
+  EXPECT_EQ("wal", ExecuteWithResult(&db(), "PRAGMA journal_mode"));
+  ASSERT_TRUE(db().Execute("CREATE TABLE foo (a, b)"));
+
+  sql::Connection reader;
+  reader.set_read_only();
+  ASSERT_TRUE(reader.Open(db_path()));
+  EXPECT_EQ("wal", ExecuteWithResult(&reader, "PRAGMA journal_mode"));
+  EXPECT_EQ(SQLITE_READONLY, reader.ExecuteAndReturnErrorCode(
+                                 "INSERT INTO foo (a, b) VALUES (1, 2)"));
+
+  // The reader sees the changes committed by the writer.
+  ASSERT_TRUE(db().Execute("INSERT INTO foo (a, b) VALUES (3, 4)"));
+  EXPECT_EQ("3", ExecuteWithResult(&reader, "SELECT a FROM foo"));
+
+  // A missing database isn't created.
+  sql::Connection missing;
+  missing.set_read_only();
+  missing.set_error_callback(base::Bind(&IgnoreErrorCallback));
+  EXPECT_FALSE(missing.Open(db_path().InsertBeforeExtensionASCII("-missing")));
+}
+
+TEST_F(SQLConnectionTest, PreloadInBackground) {
+  ASSERT_TRUE(db().Execute("CREATE TABLE foo (a, b)"));
+  scoped_refptr<base::TestSimpleTaskRunner> task_runner(
+      new base::TestSimpleTaskRunner);
+  db().PreloadInBackground(task_runner);
+  EXPECT_TRUE(task_runner->HasPendingTask());
+
+  // The connection can be used while the file is read.
+  ASSERT_TRUE(db().Execute("INSERT INTO foo (a, b) VALUES (12, 13)"));
+  task_runner->RunPendingTasks();
+  EXPECT_EQ("12", ExecuteWithResult(&db(), "SELECT a FROM foo"));
+
+  // In-memory databases have no file to read.
+  sql::Connection memory_db;
+  ASSERT_TRUE(memory_db.OpenInMemory());
+  memory_db.PreloadInBackground(task_runner);
+  EXPECT_FALSE(task_runner->HasPendingTask());
+}
+
 // To prevent invalid SQL from accidentally shipping to production, prepared
 // statements which fail to compile with SQLITE_ERROR call DLOG(DCHECK).  This
 // case cannot be suppressed with an error callback.
@@ -4,6 +4,7 @@
 
 #include "third_party/leveldatabase/env_chromium.h"
 
+#include <atomic>
 #include <utility>
 
 #if defined(OS_POSIX)
@@ -33,6 +34,7 @@
 #include "build/build_config.h"
 #include "third_party/leveldatabase/chromium_logger.h"
 #include "third_party/leveldatabase/leveldb_chrome.h"
+#include "third_party/leveldatabase/src/include/leveldb/cache.h"
 #include "third_party/leveldatabase/src/include/leveldb/options.h"
 #include "third_party/re2/src/re2/re2.h"
 
@@ -97,6 +99,7 @@ class Semaphore {
 namespace {
 
 const FilePath::CharType table_extension[] = FILE_PATH_LITERAL(".ldb");
+const FilePath::CharType log_extension[] = FILE_PATH_LITERAL(".log");
 
 static const FilePath::CharType kLevelDBTestDirectoryPrefix[] =
     FILE_PATH_LITERAL("leveldb-test-");
@@ -332,31 +335,40 @@ class ChromiumRandomAccessFile : public leveldb::RandomAccessFile {
 
 class ChromiumWritableFile : public leveldb::WritableFile {
  public:
+  // If |sync_on_close_failures| is set, log files with unsynced appends sync
+  // when they are closed, and count failures to do so in it.
   ChromiumWritableFile(const std::string& fname,
                        base::File f,
-                       const UMALogger* uma_logger);
-  virtual ~ChromiumWritableFile() {}
+                       const UMALogger* uma_logger,
+                       std::atomic<int>* sync_on_close_failures);
+  ~ChromiumWritableFile() override;
   leveldb::Status Append(const leveldb::Slice& data) override;
   leveldb::Status Close() override;
   leveldb::Status Flush() override;
   leveldb::Status Sync() override;
 
  private:
-  enum Type { kManifest, kTable, kOther };
+  enum Type { kManifest, kTable, kLog, kOther };
   leveldb::Status SyncParent();
+  leveldb::Status SyncBeforeClose();
 
   std::string filename_;
   base::File file_;
   const UMALogger* uma_logger_;
   Type file_type_;
   std::string parent_dir_;
+  // Null unless this is a log file which syncs on close.
+  std::atomic<int>* sync_on_close_failures_ = nullptr;
+  bool has_unsynced_appends_ = false;
 
   DISALLOW_COPY_AND_ASSIGN(ChromiumWritableFile);
 };
 
-ChromiumWritableFile::ChromiumWritableFile(const std::string& fname,
-                                           base::File f,
-                                           const UMALogger* uma_logger)
+ChromiumWritableFile::ChromiumWritableFile(
+    const std::string& fname,
+    base::File f,
+    const UMALogger* uma_logger,
+    std::atomic<int>* sync_on_close_failures)
     : filename_(fname),
       file_(std::move(f)),
       uma_logger_(uma_logger),
@@ -367,9 +379,25 @@ ChromiumWritableFile::ChromiumWritableFile(const std::string& fname,
     file_type_ = kManifest;
   else if (path.MatchesExtension(table_extension))
     file_type_ = kTable;
+  else if (path.MatchesExtension(log_extension))
+    file_type_ = kLog;
+  if (file_type_ == kLog)
+    sync_on_close_failures_ = sync_on_close_failures;
   parent_dir_ = FilePath::FromUTF8Unsafe(fname).DirName().AsUTF8Unsafe();
 }
 
+ChromiumWritableFile::~ChromiumWritableFile() {
+  // leveldb deletes a log it switches away from without closing it first.
+  if (file_.IsValid() && !SyncBeforeClose().ok())
+    sync_on_close_failures_->fetch_add(1);
+}
+
+Status ChromiumWritableFile::SyncBeforeClose() {
+  if (!sync_on_close_failures_ || !has_unsynced_appends_)
+    return Status::OK();
+  return Sync();
+}
+
 Status ChromiumWritableFile::SyncParent() {
   TRACE_EVENT0("leveldb", "SyncParent");
 #if defined(OS_POSIX)
@@ -402,12 +430,16 @@ Status ChromiumWritableFile::Append(const Slice& data) {
   }
   if (bytes_written > 0)
     uma_logger_->RecordBytesWritten(bytes_written);
+  has_unsynced_appends_ = true;
   return Status::OK();
 }
 
 Status ChromiumWritableFile::Close() {
+  Status s = SyncBeforeClose();
+  if (!s.ok())
+    sync_on_close_failures_->fetch_add(1);
   file_.Close();
-  return Status::OK();
+  return s;
 }
 
 Status ChromiumWritableFile::Flush() {
@@ -425,6 +457,7 @@ Status ChromiumWritableFile::Sync() {
     return MakeIOError(filename_, base::File::ErrorToString(error),
                        kWritableFileSync, error);
   }
+  has_unsynced_appends_ = false;
 
   // leveldb's implicit contract for Sync() is that if this instance is for a
   // manifest file then the directory is also sync'ed. See leveldb's
@@ -1069,7 +1102,9 @@ Status ChromiumEnv::NewWritableFile(const std::string& fname,
     return MakeIOError(fname, "Unable to create writable file",
                        kNewWritableFile, f.error_details());
   } else {
-    *result = new ChromiumWritableFile(fname, std::move(f), this);
+    *result = new ChromiumWritableFile(
+        fname, std::move(f), this,
+        sync_logs_on_close_ ? &log_sync_on_close_failures_ : nullptr);
     return Status::OK();
   }
 }
@@ -1084,7 +1119,9 @@ Status ChromiumEnv::NewAppendableFile(const std::string& fname,
     return MakeIOError(fname, "Unable to create appendable file",
                        kNewAppendableFile, f.error_details());
   }
-  *result = new ChromiumWritableFile(fname, std::move(f), this);
+  *result = new ChromiumWritableFile(
+      fname, std::move(f), this,
+      sync_logs_on_close_ ? &log_sync_on_close_failures_ : nullptr);
   return Status::OK();
 }
 
@@ -1255,6 +1292,55 @@ LevelDBStatusValue GetLevelDBStatusUMAValue(const leveldb::Status& s) {
   return LEVELDB_STATUS_INVALID_ARGUMENT;
 }
 
+namespace {
+
+// The block cache of a single database. Forwards all calls to a shared block
+// cache, counting the lookups of the database.
+class DBBlockCache : public leveldb::Cache {
+ public:
+  explicit DBBlockCache(leveldb::Cache* shared_cache)
+      : shared_cache_(shared_cache) {}
+  ~DBBlockCache() override {}
+
+  leveldb::Cache* shared_cache() const { return shared_cache_; }
+  uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+  uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+  Handle* Insert(const Slice& key,
+                 void* value,
+                 size_t charge,
+                 void (*deleter)(const Slice& key, void* value)) override {
+    return shared_cache_->Insert(key, value, charge, deleter);
+  }
+
+  Handle* Lookup(const Slice& key) override {
+    Handle* handle = shared_cache_->Lookup(key);
+    (handle ? hits_ : misses_).fetch_add(1, std::memory_order_relaxed);
+    return handle;
+  }
+
+  void Release(Handle* handle) override { shared_cache_->Release(handle); }
+
+  void* Value(Handle* handle) override { return shared_cache_->Value(handle); }
+
+  void Erase(const Slice& key) override { shared_cache_->Erase(key); }
+
+  uint64_t NewId() override { return shared_cache_->NewId(); }
+
+  void Prune() override { shared_cache_->Prune(); }
+
+  size_t TotalCharge() const override { return shared_cache_->TotalCharge(); }
+
+ private:
+  leveldb::Cache* const shared_cache_;
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+
+  DISALLOW_COPY_AND_ASSIGN(DBBlockCache);
+};
+
+}  // namespace
+
 // Forwards all calls to the underlying leveldb::DB instance.
 // Adds / removes itself in the DBTracker it's created with.
 class DBTracker::TrackedDBImpl : public base::LinkNode<TrackedDBImpl>,
@@ -1263,8 +1349,12 @@ class DBTracker::TrackedDBImpl : public base::LinkNode<TrackedDBImpl>,
   TrackedDBImpl(DBTracker* tracker,
                 const std::string name,
                 leveldb::DB* db,
-                const leveldb::Cache* block_cache)
-      : tracker_(tracker), name_(name), db_(db) {
+                std::unique_ptr<DBBlockCache> db_block_cache)
+      : tracker_(tracker),
+        name_(name),
+        db_block_cache_(std::move(db_block_cache)),
+        db_(db) {
+    const leveldb::Cache* block_cache = db_block_cache_->shared_cache();
     if (leveldb_chrome::GetSharedWebBlockCache() ==
         leveldb_chrome::GetSharedBrowserBlockCache()) {
       shared_read_cache_use_ = SharedReadCacheUse_Unified;
@@ -1290,6 +1380,12 @@ class DBTracker::TrackedDBImpl : public base::LinkNode<TrackedDBImpl>,
     return shared_read_cache_use_;
   }
 
+  uint64_t block_cache_hits() const override { return db_block_cache_->hits(); }
+
+  uint64_t block_cache_misses() const override {
+    return db_block_cache_->misses();
+  }
+
   leveldb::Status Put(const leveldb::WriteOptions& options,
                       const leveldb::Slice& key,
                       const leveldb::Slice& value) override {
@@ -1341,6 +1437,8 @@ class DBTracker::TrackedDBImpl : public base::LinkNode<TrackedDBImpl>,
  private:
   DBTracker* tracker_;
   std::string name_;
+  // Used by |db_|, so must outlive it.
+  std::unique_ptr<DBBlockCache> db_block_cache_;
   std::unique_ptr<leveldb::DB> db_;
   SharedReadCacheUse shared_read_cache_use_;
 
@@ -1437,6 +1535,11 @@ void DBTracker::MemoryDumpProvider::DumpVisitor(ProcessMemoryDump* pmd,
       cache_usage / database_use_count_[db->block_cache_type()];
   db_cache_dump->AddScalar(MemoryAllocatorDump::kNameSize,
                            MemoryAllocatorDump::kUnitsBytes, cache_usage_pss);
+  // The hit rate of the database in the shared cache.
+  db_cache_dump->AddScalar("hits", MemoryAllocatorDump::kUnitsObjects,
+                           db->block_cache_hits());
+  db_cache_dump->AddScalar("misses", MemoryAllocatorDump::kUnitsObjects,
+                           db->block_cache_misses());
 
   auto* db_dump = pmd->CreateAllocatorDump(db_dump_name);
   uint64_t total_usage = 0;
@@ -1514,14 +1617,21 @@ bool DBTracker::IsTrackedDB(const leveldb::DB* db) const {
 leveldb::Status DBTracker::OpenDatabase(const leveldb::Options& options,
                                         const std::string& name,
                                         TrackedDB** dbptr) {
+  DCHECK(options.block_cache);
+  // Count the lookups of the database in the shared cache.
+  auto db_block_cache = std::make_unique<DBBlockCache>(options.block_cache);
+  leveldb::Options db_options = options;
+  db_options.block_cache = db_block_cache.get();
+
   leveldb::DB* db = nullptr;
-  auto status = leveldb::DB::Open(options, name, &db);
+  auto status = leveldb::DB::Open(db_options, name, &db);
   // Enforce expectations: either we succeed, and get a valid object in |db|,
   // or we fail, and |db| is still NULL.
   CHECK((status.ok() && db) || (!status.ok() && !db));
   if (status.ok()) {
     // TrackedDBImpl ctor adds the instance to the tracker.
-    *dbptr = new TrackedDBImpl(GetInstance(), name, db, options.block_cache);
+    *dbptr = new TrackedDBImpl(GetInstance(), name, db,
+                               std::move(db_block_cache));
   }
   return status;
 }
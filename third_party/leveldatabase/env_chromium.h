@@ -5,6 +5,7 @@
 #ifndef THIRD_PARTY_LEVELDATABASE_ENV_CHROMIUM_H_
 #define THIRD_PARTY_LEVELDATABASE_ENV_CHROMIUM_H_
 
+#include <atomic>
 #include <memory>
 #include <set>
 #include <string>
@@ -176,9 +177,23 @@ class LEVELDB_EXPORT ChromiumEnv : public leveldb::Env,
                                     leveldb::Logger** result);
   void SetReadOnlyFileLimitForTesting(int max_open_files);
 
+  // The number of log files which failed to sync when they were closed, see
+  // set_sync_logs_on_close().
+  int log_sync_on_close_failures() const {
+    return log_sync_on_close_failures_.load();
+  }
+
  protected:
   explicit ChromiumEnv(const std::string& name);
 
+  // Makes log files which have unsynced writes sync when they are closed.
+  // leveldb closes a log without syncing it when it switches to a new one, so
+  // writes made without WriteOptions::sync, which a later synced write would
+  // otherwise make durable, stay volatile until their memtable is compacted.
+  // leveldb can't be told about errors on close, so they are only counted.
+  // Must be called before the env is used.
+  void set_sync_logs_on_close() { sync_logs_on_close_ = true; }
+
   static const char* FileErrorString(base::File::Error error);
 
  private:
@@ -241,6 +256,9 @@ class LEVELDB_EXPORT ChromiumEnv : public leveldb::Env,
   BGQueue queue_;
   LockTable locks_;
   std::unique_ptr<Semaphore> file_semaphore_;
+
+  bool sync_logs_on_close_ = false;
+  std::atomic<int> log_sync_on_close_failures_{0};
 };
 
 // Tracks databases open via OpenDatabase() method and exposes them to
@@ -281,6 +299,11 @@ class LEVELDB_EXPORT DBTracker {
 
     // Options used when opening the database.
     virtual SharedReadCacheUse block_cache_type() const = 0;
+
+    // The lookups of this database in the shared block cache which found the
+    // block, and which didn't.
+    virtual uint64_t block_cache_hits() const = 0;
+    virtual uint64_t block_cache_misses() const = 0;
   };
 
   // Opens a database and starts tracking it. As long as the opened database
@@ -480,6 +480,30 @@ TEST_F(ChromiumEnvDBTrackerTest, MemoryDumpCreation) {
   EXPECT_EQ(db_size, mad3->GetSizeInternal());
 }
 
+TEST_F(ChromiumEnvDBTrackerTest, BlockCacheHits) {
+  Options options;
+  options.create_if_missing = true;
+  DBTracker::TrackedDB* db;
+  Status status = DBTracker::GetInstance()->OpenDatabase(
+      options, temp_path().AsUTF8Unsafe(), &db);
+  ASSERT_TRUE(status.ok()) << status.ToString();
+  status = db->Put(WriteOptions(), "key", "value");
+  ASSERT_TRUE(status.ok()) << status.ToString();
+  db->CompactRange(nullptr, nullptr);
+  EXPECT_EQ(0u, db->block_cache_hits());
+
+  // The first read loads the block into the cache, and the second finds it.
+  std::string value;
+  status = db->Get(ReadOptions(), "key", &value);
+  ASSERT_TRUE(status.ok()) << status.ToString();
+  EXPECT_GT(db->block_cache_misses(), 0u);
+  status = db->Get(ReadOptions(), "key", &value);
+  ASSERT_TRUE(status.ok()) << status.ToString();
+  EXPECT_GT(db->block_cache_hits(), 0u);
+
+  delete db;
+}
+
 }  // namespace leveldb_env
 
 int main(int argc, char** argv) { return base::TestSuite(argc, argv).Run(); }
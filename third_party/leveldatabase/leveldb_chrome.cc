@@ -4,15 +4,20 @@
 
 #include "third_party/leveldatabase/leveldb_chrome.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "base/bind.h"
 #include "base/containers/flat_set.h"
+#include "base/feature_list.h"
 #include "base/files/file.h"
 #include "base/memory/memory_pressure_listener.h"
 #include "base/metrics/histogram_macros.h"
 #include "base/sys_info.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
 #include "third_party/leveldatabase/env_chromium.h"
+#include "third_party/leveldatabase/scan_resistant_cache.h"
 #include "third_party/leveldatabase/src/helpers/memenv/memenv.h"
 #include "util/mutexlock.h"
 
@@ -24,6 +29,15 @@ namespace leveldb_chrome {
 
 namespace {
 
+// Makes the shared block caches ScanResistantCaches sized by the device's
+// memory, which shrink under memory pressure.
+const base::Feature kScanResistantBlockCache{"LevelDBScanResistantBlockCache",
+                                             base::FEATURE_DISABLED_BY_DEFAULT};
+
+// How long the shared block caches stay shrunk after memory pressure.
+constexpr base::TimeDelta kMemoryPressureRecoveryTime =
+    base::TimeDelta::FromMinutes(1);
+
 size_t DefaultBlockCacheSize() {
   if (base::SysInfo::IsLowEndDevice())
     return 1 << 20;  // 1MB
@@ -31,6 +45,15 @@ size_t DefaultBlockCacheSize() {
     return 8 << 20;  // 8MB
 }
 
+size_t ScaledBlockCacheSize() {
+  if (base::SysInfo::IsLowEndDevice())
+    return DefaultBlockCacheSize();
+  // 1MB per GB of memory, within 8MB to 32MB.
+  int64_t size = base::SysInfo::AmountOfPhysicalMemory() / 1024;
+  return static_cast<size_t>(
+      std::min<int64_t>(std::max<int64_t>(size, 8 << 20), 32 << 20));
+}
+
 // Singleton owning resources shared by Chrome's leveldb databases.
 class Globals {
  public:
@@ -39,9 +62,19 @@ class Globals {
     return globals;
   }
 
-  Globals() : browser_block_cache_(NewLRUCache(DefaultBlockCacheSize())) {
-    if (!base::SysInfo::IsLowEndDevice())
-      web_block_cache_.reset(NewLRUCache(DefaultBlockCacheSize()));
+  Globals() {
+    if (base::FeatureList::IsEnabled(kScanResistantBlockCache)) {
+      scan_resistant_ = true;
+      block_cache_size_ = ScaledBlockCacheSize();
+      browser_block_cache_.reset(new ScanResistantCache(block_cache_size_));
+      if (!base::SysInfo::IsLowEndDevice())
+        web_block_cache_.reset(new ScanResistantCache(block_cache_size_));
+    } else {
+      block_cache_size_ = DefaultBlockCacheSize();
+      browser_block_cache_.reset(NewLRUCache(block_cache_size_));
+      if (!base::SysInfo::IsLowEndDevice())
+        web_block_cache_.reset(NewLRUCache(block_cache_size_));
+    }
 
     memory_pressure_listener_.reset(new base::MemoryPressureListener(
         base::Bind(&Globals::OnMemoryPressure, base::Unretained(this))));
@@ -60,6 +93,21 @@ class Globals {
     if (memory_pressure_level ==
         MemoryPressureLevel::MEMORY_PRESSURE_LEVEL_NONE)
       return;
+    if (scan_resistant_) {
+      // Shrink the caches until the pressure has been gone for a while.
+      size_t capacity =
+          memory_pressure_level ==
+                  MemoryPressureLevel::MEMORY_PRESSURE_LEVEL_CRITICAL
+              ? block_cache_size_ / 8
+              : block_cache_size_ / 2;
+      SetBlockCacheCapacity(
+          std::min(capacity, static_cast<ScanResistantCache*>(
+                                 browser_block_cache())->capacity()));
+      restore_capacity_timer_.Start(
+          FROM_HERE, kMemoryPressureRecoveryTime,
+          base::Bind(&Globals::SetBlockCacheCapacity, base::Unretained(this),
+                     block_cache_size_));
+    }
     browser_block_cache()->Prune();
     if (browser_block_cache() == web_block_cache())
       return;
@@ -78,6 +126,16 @@ class Globals {
     in_memory_envs_.erase(env);
   }
 
+  void SetBlockCacheCapacity(size_t capacity) {
+    DCHECK(scan_resistant_);
+    static_cast<ScanResistantCache*>(browser_block_cache())
+        ->SetCapacity(capacity);
+    if (browser_block_cache() != web_block_cache()) {
+      static_cast<ScanResistantCache*>(web_block_cache())
+          ->SetCapacity(capacity);
+    }
+  }
+
   bool IsInMemoryEnv(const leveldb::Env* env) const {
     leveldb::MutexLock l(&env_mutex_);
     return in_memory_envs_.find(env) != in_memory_envs_.end();
@@ -107,8 +165,14 @@ class Globals {
 
   std::unique_ptr<Cache> web_block_cache_;      // null on low end devices.
   std::unique_ptr<Cache> browser_block_cache_;  // Never null.
+  // Whether the caches are ScanResistantCaches.
+  bool scan_resistant_ = false;
+  // The capacity of each cache when there is no memory pressure.
+  size_t block_cache_size_;
   // Listens for the system being under memory pressure.
   std::unique_ptr<base::MemoryPressureListener> memory_pressure_listener_;
+  // Restores the capacity of the caches after memory pressure.
+  base::OneShotTimer restore_capacity_timer_;
   mutable leveldb::port::Mutex env_mutex_;
   base::flat_set<leveldb::Env*> in_memory_envs_;
 
@@ -0,0 +1,278 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "third_party/leveldatabase/scan_resistant_cache.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+#include "base/containers/linked_list.h"
+#include "base/containers/mru_cache.h"
+#include "base/hash.h"
+#include "base/logging.h"
+#include "base/strings/string_piece.h"
+#include "base/synchronization/lock.h"
+
+namespace leveldb_chrome {
+
+namespace {
+
+// The fewest keys of evicted blocks which a shard remembers.
+const size_t kMinGhostEntries = 64;
+
+enum class Queue { kNone, kProbation, kMain };
+
+struct Entry : public base::LinkNode<Entry> {
+  std::string key;
+  void* value;
+  size_t charge;
+  void (*deleter)(const leveldb::Slice& key, void* value);
+  // The cache holds a reference while the entry is in a queue.
+  int refs;
+  Queue queue;
+};
+
+Entry* ToEntry(leveldb::Cache::Handle* handle) {
+  return reinterpret_cast<Entry*>(handle);
+}
+
+leveldb::Cache::Handle* ToHandle(Entry* entry) {
+  return reinterpret_cast<leveldb::Cache::Handle*>(entry);
+}
+
+base::StringPiece ToStringPiece(const leveldb::Slice& slice) {
+  return base::StringPiece(slice.data(), slice.size());
+}
+
+}  // namespace
+
+class ScanResistantCache::Shard {
+ public:
+  Shard() : ghosts_(GhostSet::NO_AUTO_EVICT) {}
+
+  ~Shard() {
+    while (!probation_.empty())
+      RemoveFromQueue(probation_.head()->value());
+    while (!main_.empty())
+      RemoveFromQueue(main_.head()->value());
+  }
+
+  void SetCapacity(size_t capacity) {
+    base::AutoLock lock(lock_);
+    capacity_ = capacity;
+    EvictIfNeeded();
+  }
+
+  Entry* Insert(const leveldb::Slice& key,
+                void* value,
+                size_t charge,
+                void (*deleter)(const leveldb::Slice& key, void* value)) {
+    Entry* entry = new Entry;
+    entry->key.assign(key.data(), key.size());
+    entry->value = value;
+    entry->charge = charge;
+    entry->deleter = deleter;
+    entry->refs = 1;  // For the returned handle.
+    entry->queue = Queue::kNone;
+
+    base::AutoLock lock(lock_);
+    auto it = table_.find(ToStringPiece(key));
+    if (it != table_.end())
+      RemoveFromQueue(it->second);
+    // Caching is turned off.
+    if (!capacity_)
+      return entry;
+
+    // A block read again soon after its eviction from the probationary queue
+    // skips it.
+    auto ghost = ghosts_.Peek(entry->key);
+    if (ghost != ghosts_.end()) {
+      ghosts_.Erase(ghost);
+      entry->queue = Queue::kMain;
+      main_.Append(entry);
+      main_usage_ += charge;
+    } else {
+      entry->queue = Queue::kProbation;
+      probation_.Append(entry);
+      probation_usage_ += charge;
+    }
+    entry->refs++;
+    table_[entry->key] = entry;
+    EvictIfNeeded();
+    return entry;
+  }
+
+  Entry* Lookup(const leveldb::Slice& key) {
+    base::AutoLock lock(lock_);
+    auto it = table_.find(ToStringPiece(key));
+    if (it == table_.end())
+      return nullptr;
+    Entry* entry = it->second;
+    // Probationary blocks keep their place, so that a block read repeatedly
+    // by a scan is still evicted in turn.
+    if (entry->queue == Queue::kMain) {
+      entry->RemoveFromList();
+      main_.Append(entry);
+    }
+    entry->refs++;
+    return entry;
+  }
+
+  void Release(Entry* entry) {
+    base::AutoLock lock(lock_);
+    Unref(entry);
+  }
+
+  void Erase(const leveldb::Slice& key) {
+    base::AutoLock lock(lock_);
+    auto it = table_.find(ToStringPiece(key));
+    if (it != table_.end())
+      RemoveFromQueue(it->second);
+  }
+
+  void Prune() {
+    base::AutoLock lock(lock_);
+    for (base::LinkedList<Entry>* queue : {&probation_, &main_}) {
+      base::LinkNode<Entry>* node = queue->head();
+      while (node != queue->end()) {
+        Entry* entry = node->value();
+        node = node->next();
+        if (entry->refs == 1)
+          RemoveFromQueue(entry);
+      }
+    }
+    ghosts_.Clear();
+  }
+
+  size_t TotalCharge() const {
+    base::AutoLock lock(lock_);
+    return probation_usage_ + main_usage_;
+  }
+
+ private:
+  using GhostSet = base::HashingMRUCache<std::string, bool>;
+
+  // Removes |entry| from the cache, and deletes it unless it is in use.
+  void RemoveFromQueue(Entry* entry) {
+    DCHECK_NE(Queue::kNone, entry->queue);
+    entry->RemoveFromList();
+    if (entry->queue == Queue::kProbation)
+      probation_usage_ -= entry->charge;
+    else
+      main_usage_ -= entry->charge;
+    entry->queue = Queue::kNone;
+    table_.erase(entry->key);
+    Unref(entry);
+  }
+
+  void Unref(Entry* entry) {
+    DCHECK_GT(entry->refs, 0);
+    if (--entry->refs)
+      return;
+    DCHECK_EQ(Queue::kNone, entry->queue);
+    (*entry->deleter)(leveldb::Slice(entry->key), entry->value);
+    delete entry;
+  }
+
+  void EvictIfNeeded() {
+    while (probation_usage_ + main_usage_ > capacity_) {
+      // The probationary queue keeps its share of the capacity, so that blocks
+      // have a chance to be read again while there.
+      bool from_probation =
+          !probation_.empty() &&
+          (main_.empty() ||
+           probation_usage_ > capacity_ * kProbationPercent / 100);
+      if (from_probation) {
+        Entry* entry = probation_.head()->value();
+        ghosts_.Put(entry->key, true);
+        RemoveFromQueue(entry);
+      } else {
+        RemoveFromQueue(main_.head()->value());
+      }
+    }
+    ghosts_.ShrinkToSize(std::max(table_.size(), kMinGhostEntries));
+  }
+
+  mutable base::Lock lock_;
+  size_t capacity_ = 0;
+  size_t probation_usage_ = 0;
+  size_t main_usage_ = 0;
+  // Oldest first.
+  base::LinkedList<Entry> probation_;
+  // Least recently used first.
+  base::LinkedList<Entry> main_;
+  // Keyed by the entries' own keys.
+  std::unordered_map<base::StringPiece, Entry*, base::StringPieceHash> table_;
+  // The keys of the blocks most recently evicted from |probation_|.
+  GhostSet ghosts_;
+
+  DISALLOW_COPY_AND_ASSIGN(Shard);
+};
+
+ScanResistantCache::ScanResistantCache(size_t capacity)
+    : shards_(new Shard[kNumShards]), capacity_(0) {
+  SetCapacity(capacity);
+}
+
+ScanResistantCache::~ScanResistantCache() = default;
+
+void ScanResistantCache::SetCapacity(size_t capacity) {
+  capacity_ = capacity;
+  const size_t shard_capacity = (capacity + kNumShards - 1) / kNumShards;
+  for (int i = 0; i < kNumShards; ++i)
+    shards_[i].SetCapacity(shard_capacity);
+}
+
+size_t ScanResistantCache::capacity() const {
+  return capacity_;
+}
+
+leveldb::Cache::Handle* ScanResistantCache::Insert(
+    const leveldb::Slice& key,
+    void* value,
+    size_t charge,
+    void (*deleter)(const leveldb::Slice& key, void* value)) {
+  return ToHandle(GetShard(key)->Insert(key, value, charge, deleter));
+}
+
+leveldb::Cache::Handle* ScanResistantCache::Lookup(const leveldb::Slice& key) {
+  return ToHandle(GetShard(key)->Lookup(key));
+}
+
+void ScanResistantCache::Release(Handle* handle) {
+  Entry* entry = ToEntry(handle);
+  GetShard(leveldb::Slice(entry->key))->Release(entry);
+}
+
+void* ScanResistantCache::Value(Handle* handle) {
+  return ToEntry(handle)->value;
+}
+
+void ScanResistantCache::Erase(const leveldb::Slice& key) {
+  GetShard(key)->Erase(key);
+}
+
+uint64_t ScanResistantCache::NewId() {
+  return ++last_id_;
+}
+
+void ScanResistantCache::Prune() {
+  for (int i = 0; i < kNumShards; ++i)
+    shards_[i].Prune();
+}
+
+size_t ScanResistantCache::TotalCharge() const {
+  size_t total = 0;
+  for (int i = 0; i < kNumShards; ++i)
+    total += shards_[i].TotalCharge();
+  return total;
+}
+
+ScanResistantCache::Shard* ScanResistantCache::GetShard(
+    const leveldb::Slice& key) {
+  return &shards_[base::Hash(key.data(), key.size()) % kNumShards];
+}
+
+}  // namespace leveldb_chrome
@@ -0,0 +1,78 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#ifndef THIRD_PARTY_LEVELDATABASE_SCAN_RESISTANT_CACHE_H_
+#define THIRD_PARTY_LEVELDATABASE_SCAN_RESISTANT_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+
+#include "base/macros.h"
+#include "leveldb/cache.h"
+#include "leveldb/export.h"
+
+namespace leveldb_chrome {
+
+// A leveldb block cache which a scan can't flush, using the 2Q replacement
+// policy. A block read for the first time goes to a small probationary FIFO
+// queue, and only moves to the main LRU queue if it is read again soon after
+// being evicted from it, which is tracked by a queue of the keys of the
+// recently evicted blocks. Reads while it is still probationary don't count,
+// since a full table scan, such as an IndexedDB cursor iterating a large object
+// store, reads each block several times in a row and then never again. Such a
+// scan only cycles through the probationary queue.
+//
+// Unlike leveldb's LRU cache, its capacity can be changed, e.g. under memory
+// pressure.
+//
+// This class is thread-safe. Like leveldb's LRU cache, it is split into shards
+// with their own lock, by the hash of the key.
+class LEVELDB_EXPORT ScanResistantCache : public leveldb::Cache {
+ public:
+  // The share of the capacity which the probationary queue keeps when the main
+  // queue needs space, in percent.
+  static const int kProbationPercent = 25;
+
+  explicit ScanResistantCache(size_t capacity);
+  ~ScanResistantCache() override;
+
+  // Evicts blocks until the cache fits in |capacity|. Blocks in use stay
+  // allocated until they are released.
+  void SetCapacity(size_t capacity);
+  size_t capacity() const;
+
+  // leveldb::Cache implementation.
+  Handle* Insert(const leveldb::Slice& key,
+                 void* value,
+                 size_t charge,
+                 void (*deleter)(const leveldb::Slice& key,
+                                 void* value)) override;
+  Handle* Lookup(const leveldb::Slice& key) override;
+  void Release(Handle* handle) override;
+  void* Value(Handle* handle) override;
+  void Erase(const leveldb::Slice& key) override;
+  uint64_t NewId() override;
+  void Prune() override;
+  size_t TotalCharge() const override;
+
+ private:
+  class Shard;
+
+  static const int kNumShards = 16;
+
+  Shard* GetShard(const leveldb::Slice& key);
+
+  std::unique_ptr<Shard[]> shards_;
+  std::atomic<size_t> capacity_;
+  std::atomic<uint64_t> last_id_{0};
+
+  DISALLOW_COPY_AND_ASSIGN(ScanResistantCache);
+};
+
+}  // namespace leveldb_chrome
+
+#endif  // THIRD_PARTY_LEVELDATABASE_SCAN_RESISTANT_CACHE_H_
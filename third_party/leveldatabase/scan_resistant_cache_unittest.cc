@@ -0,0 +1,178 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "third_party/leveldatabase/scan_resistant_cache.h"
+
+#include <stdint.h>
+
+#include <string>
+
+#include "base/strings/string_number_conversions.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace leveldb_chrome {
+
+namespace {
+
+int g_num_deleted = 0;
+
+void DeleteValue(const leveldb::Slice& key, void* value) {
+  ++g_num_deleted;
+}
+
+void* MakeValue(int value) {
+  return reinterpret_cast<void*>(static_cast<intptr_t>(value));
+}
+
+class ScanResistantCacheTest : public testing::Test {
+ protected:
+  void SetUp() override { g_num_deleted = 0; }
+
+  // Inserts |key| with a charge of |charge|, and releases it.
+  void Insert(ScanResistantCache* cache, int key, size_t charge = 1) {
+    std::string encoded_key = base::IntToString(key);
+    cache->Release(
+        cache->Insert(encoded_key, MakeValue(key), charge, &DeleteValue));
+  }
+
+  // Returns whether |key| is in |cache|. Looking it up counts as reading it.
+  bool Contains(ScanResistantCache* cache, int key) {
+    leveldb::Cache::Handle* handle = cache->Lookup(base::IntToString(key));
+    if (!handle)
+      return false;
+    EXPECT_EQ(MakeValue(key), cache->Value(handle));
+    cache->Release(handle);
+    return true;
+  }
+
+  // Reads |key| like a leveldb table does, inserting it on a miss.
+  void Read(ScanResistantCache* cache, int key) {
+    if (!Contains(cache, key))
+      Insert(cache, key);
+  }
+
+  // Makes keys [0, |num_keys|) hot in |cache|, which holds |capacity| entries,
+  // by reading them again after a scan evicts them.
+  void ReadHotKeys(ScanResistantCache* cache, size_t capacity, int num_keys) {
+    for (int key = 0; key < num_keys; ++key)
+      Read(cache, key);
+    for (int key = 0; key < static_cast<int>(capacity * 3 / 2); ++key)
+      Read(cache, num_keys + key);
+    for (int key = 0; key < num_keys; ++key) {
+      EXPECT_FALSE(Contains(cache, key));
+      Read(cache, key);
+    }
+  }
+};
+
+TEST_F(ScanResistantCacheTest, InsertLookupErase) {
+  ScanResistantCache cache(1024);
+  EXPECT_FALSE(Contains(&cache, 1));
+  Insert(&cache, 1, 10);
+  EXPECT_TRUE(Contains(&cache, 1));
+  EXPECT_EQ(10u, cache.TotalCharge());
+
+  cache.Erase("1");
+  EXPECT_FALSE(Contains(&cache, 1));
+  EXPECT_EQ(0u, cache.TotalCharge());
+  EXPECT_EQ(1, g_num_deleted);
+}
+
+TEST_F(ScanResistantCacheTest, EntriesInUseOutliveEviction) {
+  ScanResistantCache cache(1024);
+  leveldb::Cache::Handle* handle =
+      cache.Insert("1", MakeValue(1), 1, &DeleteValue);
+  cache.SetCapacity(0);
+  EXPECT_FALSE(Contains(&cache, 1));
+  EXPECT_EQ(0, g_num_deleted);
+  EXPECT_EQ(MakeValue(1), cache.Value(handle));
+  cache.Release(handle);
+  EXPECT_EQ(1, g_num_deleted);
+}
+
+TEST_F(ScanResistantCacheTest, ScanKeepsHotEntries) {
+  ScanResistantCache cache(1600);
+  const int kNumHotKeys = 10;
+  ReadHotKeys(&cache, 1600, kNumHotKeys);
+
+  // Read many more blocks than fit, once each.
+  for (int key = 10000; key < 20000; ++key)
+    Read(&cache, key);
+  EXPECT_LE(cache.TotalCharge(), 1600u);
+
+  for (int key = 0; key < kNumHotKeys; ++key)
+    EXPECT_TRUE(Contains(&cache, key));
+}
+
+TEST_F(ScanResistantCacheTest, ScanRereadingBlocksKeepsHotEntries) {
+  ScanResistantCache cache(1600);
+  const int kNumHotKeys = 10;
+  ReadHotKeys(&cache, 1600, kNumHotKeys);
+
+  // A scan reads each block several times in a row, which doesn't make it hot.
+  for (int key = 10000; key < 20000; ++key) {
+    for (int i = 0; i < 3; ++i)
+      Read(&cache, key);
+  }
+  EXPECT_LE(cache.TotalCharge(), 1600u);
+
+  for (int key = 0; key < kNumHotKeys; ++key)
+    EXPECT_TRUE(Contains(&cache, key));
+}
+
+TEST_F(ScanResistantCacheTest, ProbationaryReadsDontPromote) {
+  // Each shard holds 4 entries.
+  ScanResistantCache cache(64);
+  Insert(&cache, 0);
+  EXPECT_TRUE(Contains(&cache, 0));
+  EXPECT_TRUE(Contains(&cache, 0));
+
+  // Still probationary, it is evicted in turn.
+  for (int key = 1; key < 300; ++key)
+    Insert(&cache, key);
+  EXPECT_FALSE(Contains(&cache, 0));
+}
+
+TEST_F(ScanResistantCacheTest, RecentlyEvictedEntriesAreKept) {
+  // Each shard holds 4 entries.
+  ScanResistantCache cache(64);
+  Insert(&cache, 0);
+  for (int key = 1; key < 300; ++key)
+    Insert(&cache, key);
+  EXPECT_FALSE(Contains(&cache, 0));
+
+  // Read again soon after its eviction, the entry is kept like a hot one.
+  Insert(&cache, 0);
+  for (int key = 300; key < 3000; ++key)
+    Insert(&cache, key);
+  EXPECT_TRUE(Contains(&cache, 0));
+}
+
+TEST_F(ScanResistantCacheTest, SetCapacity) {
+  ScanResistantCache cache(16000);
+  for (int key = 0; key < 100; ++key)
+    Insert(&cache, key, 10);
+  EXPECT_EQ(1000u, cache.TotalCharge());
+
+  cache.SetCapacity(160);
+  EXPECT_EQ(160u, cache.capacity());
+  EXPECT_LE(cache.TotalCharge(), 160u);
+  EXPECT_GE(g_num_deleted, 84);
+}
+
+TEST_F(ScanResistantCacheTest, Prune) {
+  ScanResistantCache cache(1024);
+  Insert(&cache, 1);
+  leveldb::Cache::Handle* handle =
+      cache.Insert("2", MakeValue(2), 1, &DeleteValue);
+
+  cache.Prune();
+  EXPECT_FALSE(Contains(&cache, 1));
+  EXPECT_TRUE(Contains(&cache, 2));
+  cache.Release(handle);
+}
+
+}  // namespace
+
+}  // namespace leveldb_chrome